@@ -186,6 +186,27 @@ static inline int vkd3d_u32_compare(uint32_t x, uint32_t y)
     return (x > y) - (x < y);
 }
 
+static inline int vkd3d_u64_compare(uint64_t x, uint64_t y)
+{
+    return (x > y) - (x < y);
+}
+
+#define VKD3D_HASH_FNV1A_64_INIT 0xcbf29ce484222325ull
+
+static inline uint64_t vkd3d_hash_fnv1a_64(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
 static inline int ascii_isupper(int c)
 {
     return 'A' <= c && c <= 'Z';
@@ -249,6 +270,19 @@ static inline LONG InterlockedDecrement(LONG volatile *x)
 # else
 #  error "InterlockedDecrement() not implemented for this platform"
 # endif
+
+# if HAVE_SYNC_VAL_COMPARE_AND_SWAP
+static inline LONG InterlockedCompareExchange(LONG volatile *x, LONG xchg, LONG cmp)
+{
+    return __sync_val_compare_and_swap(x, cmp, xchg);
+}
+static inline void *InterlockedCompareExchangePointer(void * volatile *x, void *xchg, void *cmp)
+{
+    return __sync_val_compare_and_swap(x, cmp, xchg);
+}
+# else
+#  error "InterlockedCompareExchangePointer() not implemented for this platform"
+# endif
 #endif  /* _WIN32 */
 
 static inline void vkd3d_parse_version(const char *version, int *major, int *minor)
@@ -67,6 +67,9 @@ typedef int HRESULT;
 
 # define D3DERR_INVALIDCALL _HRESULT_TYPEDEF_(0x8876086c)
 
+# define D3D12_ERROR_ADAPTER_NOT_FOUND       _HRESULT_TYPEDEF_(0x887e0001)
+# define D3D12_ERROR_DRIVER_VERSION_MISMATCH _HRESULT_TYPEDEF_(0x887e0002)
+
 /* Basic types */
 typedef unsigned char BYTE;
 typedef unsigned int DWORD;
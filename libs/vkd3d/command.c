@@ -27,7 +27,7 @@ static void d3d12_fence_signal_timeline_semaphore(struct d3d12_fence *fence, uin
 static HRESULT d3d12_command_queue_signal(struct d3d12_command_queue *command_queue,
         struct d3d12_fence *fence, uint64_t value);
 static HRESULT d3d12_command_queue_flush_ops(struct d3d12_command_queue *queue, bool *flushed_any);
-static HRESULT d3d12_command_queue_flush_ops_locked(struct d3d12_command_queue *queue, bool *flushed_any);
+static void d3d12_command_queue_stop_submit_thread(struct d3d12_command_queue *queue);
 
 HRESULT vkd3d_queue_create(struct d3d12_device *device,
         uint32_t family_index, const VkQueueFamilyProperties *properties, struct vkd3d_queue **queue)
@@ -231,13 +231,12 @@ static VkResult vkd3d_queue_create_vk_semaphore_locked(struct vkd3d_queue *queue
 }
 
 /* Fence worker thread */
-static HRESULT vkd3d_enqueue_gpu_fence(struct vkd3d_fence_worker *worker,
-        VkFence vk_fence, struct d3d12_fence *fence, uint64_t value,
-        struct vkd3d_queue *queue, uint64_t queue_sequence_number)
+static HRESULT vkd3d_fence_worker_enqueue(struct vkd3d_fence_worker *worker,
+        const struct vkd3d_waiting_fence *fence)
 {
-    struct vkd3d_waiting_fence *waiting_fence;
-
-    TRACE("worker %p, fence %p, value %#"PRIx64".\n", worker, fence, value);
+    const struct vkd3d_vk_device_procs *vk_procs = &worker->device->vk_procs;
+    VkSemaphoreSignalInfoKHR signal_info;
+    VkResult vr;
 
     vkd3d_mutex_lock(&worker->mutex);
 
@@ -249,13 +248,20 @@ static HRESULT vkd3d_enqueue_gpu_fence(struct vkd3d_fence_worker *worker,
         return E_OUTOFMEMORY;
     }
 
-    waiting_fence = &worker->fences[worker->fence_count++];
-    waiting_fence->fence = fence;
-    waiting_fence->value = value;
-    waiting_fence->u.vk_fence = vk_fence;
-    waiting_fence->queue_sequence_number = queue_sequence_number;
+    worker->fences[worker->fence_count++] = *fence;
+    d3d12_fence_incref(fence->fence);
 
-    d3d12_fence_incref(fence);
+    /* Interrupt the wait-any, so that the new fence is included in the next wait. */
+    if (worker->is_waiting && worker->vk_wake_semaphore)
+    {
+        signal_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+        signal_info.pNext = NULL;
+        signal_info.semaphore = worker->vk_wake_semaphore;
+        signal_info.value = ++worker->wake_value;
+        if ((vr = VK_CALL(vkSignalSemaphoreKHR(worker->device->vk_device, &signal_info))) < 0)
+            ERR("Failed to signal wake semaphore, vr %d.\n", vr);
+        worker->is_waiting = false;
+    }
 
     vkd3d_cond_signal(&worker->cond);
     vkd3d_mutex_unlock(&worker->mutex);
@@ -263,68 +269,176 @@ static HRESULT vkd3d_enqueue_gpu_fence(struct vkd3d_fence_worker *worker,
     return S_OK;
 }
 
-static void vkd3d_wait_for_gpu_timeline_semaphore(struct vkd3d_fence_worker *worker,
-        const struct vkd3d_waiting_fence *waiting_fence)
+static HRESULT vkd3d_enqueue_gpu_fence(struct vkd3d_fence_worker *worker,
+        VkFence vk_fence, struct d3d12_fence *fence, uint64_t value,
+        struct vkd3d_queue *queue, uint64_t queue_sequence_number)
+{
+    struct vkd3d_waiting_fence waiting_fence;
+
+    TRACE("worker %p, fence %p, value %#"PRIx64".\n", worker, fence, value);
+
+    waiting_fence.fence = fence;
+    waiting_fence.value = value;
+    waiting_fence.u.vk_fence = vk_fence;
+    waiting_fence.queue = queue;
+    waiting_fence.queue_sequence_number = queue_sequence_number;
+
+    return vkd3d_fence_worker_enqueue(worker, &waiting_fence);
+}
+
+static HRESULT vkd3d_enqueue_timeline_semaphore(struct vkd3d_fence_worker *worker, VkSemaphore vk_semaphore,
+        struct d3d12_fence *fence, uint64_t value, struct vkd3d_queue *queue)
+{
+    struct vkd3d_waiting_fence waiting_fence;
+
+    TRACE("worker %p, fence %p, value %#"PRIx64".\n", worker, fence, value);
+
+    waiting_fence.fence = fence;
+    waiting_fence.value = value;
+    waiting_fence.u.vk_semaphore = vk_semaphore;
+    waiting_fence.queue = queue;
+    waiting_fence.queue_sequence_number = 0;
+
+    return vkd3d_fence_worker_enqueue(worker, &waiting_fence);
+}
+
+static void vkd3d_fence_worker_wait_timeline_semaphores(struct vkd3d_fence_worker *worker, uint64_t wake_value)
 {
     const struct d3d12_device *device = worker->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkSemaphoreWaitInfoKHR wait_info;
+    VkSemaphore *vk_semaphores;
+    size_t i, count;
     VkResult vr;
 
+    count = worker->pending_count + 1;
+    if (!vkd3d_array_reserve(&worker->wait_objects, &worker->wait_objects_size, count, sizeof(*vk_semaphores))
+            || !vkd3d_array_reserve((void **)&worker->wait_values, &worker->wait_values_size,
+            count, sizeof(*worker->wait_values)))
+    {
+        ERR("Failed to allocate wait arrays.\n");
+        return;
+    }
+    vk_semaphores = worker->wait_objects;
+
+    for (i = 0; i < worker->pending_count; ++i)
+    {
+        vk_semaphores[i] = worker->pending[i].u.vk_semaphore;
+        worker->wait_values[i] = worker->pending[i].value;
+    }
+    vk_semaphores[i] = worker->vk_wake_semaphore;
+    worker->wait_values[i] = wake_value + 1;
+
     wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
     wait_info.pNext = NULL;
-    wait_info.flags = 0;
-    wait_info.semaphoreCount = 1;
-    wait_info.pSemaphores = &waiting_fence->u.vk_semaphore;
-    wait_info.pValues = &waiting_fence->value;
+    wait_info.flags = VK_SEMAPHORE_WAIT_ANY_BIT_KHR;
+    wait_info.semaphoreCount = count;
+    wait_info.pSemaphores = vk_semaphores;
+    wait_info.pValues = worker->wait_values;
 
     vr = VK_CALL(vkWaitSemaphoresKHR(device->vk_device, &wait_info, ~(uint64_t)0));
-    if (vr == VK_TIMEOUT)
-        return;
-    if (vr != VK_SUCCESS)
+    if (vr != VK_SUCCESS && vr != VK_TIMEOUT)
+        ERR("Failed to wait for Vulkan timeline semaphores, vr %d.\n", vr);
+}
+
+/* Binary fences cannot be signalled from the host, so a wait-any on them
+ * cannot be interrupted when fences are enqueued. The wait is bounded
+ * instead, so that new fences are included in the next wait without
+ * waiting for one of the pending fences to complete. */
+#define VKD3D_FENCE_WORKER_WAKE_TIMEOUT_NS 1000000ull
+
+/* Returns false if the wait timed out, so that no fence status needs to be checked. */
+static bool vkd3d_fence_worker_wait_fences(struct vkd3d_fence_worker *worker)
+{
+    const struct d3d12_device *device = worker->device;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkFence *vk_fences;
+    VkResult vr;
+    size_t i;
+
+    if (!vkd3d_array_reserve(&worker->wait_objects, &worker->wait_objects_size,
+            worker->pending_count, sizeof(*vk_fences)))
     {
-        ERR("Failed to wait for Vulkan timeline semaphore, vr %d.\n", vr);
-        return;
+        ERR("Failed to allocate wait array.\n");
+        return true;
     }
+    vk_fences = worker->wait_objects;
 
-    TRACE("Signaling fence %p value %#"PRIx64".\n", waiting_fence->fence, waiting_fence->value);
-    d3d12_fence_signal_timeline_semaphore(waiting_fence->fence, waiting_fence->value);
+    for (i = 0; i < worker->pending_count; ++i)
+        vk_fences[i] = worker->pending[i].u.vk_fence;
 
-    d3d12_fence_decref(waiting_fence->fence);
+    vr = VK_CALL(vkWaitForFences(device->vk_device, worker->pending_count, vk_fences, VK_FALSE,
+            VKD3D_FENCE_WORKER_WAKE_TIMEOUT_NS));
+    if (vr != VK_SUCCESS && vr != VK_TIMEOUT)
+        ERR("Failed to wait for Vulkan fences, vr %d.\n", vr);
+
+    return vr != VK_TIMEOUT;
 }
 
-static void vkd3d_wait_for_gpu_fence(struct vkd3d_fence_worker *worker,
+static bool vkd3d_fence_worker_signal_if_complete(struct vkd3d_fence_worker *worker,
         const struct vkd3d_waiting_fence *waiting_fence)
 {
     struct d3d12_device *device = worker->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    uint64_t completed_value;
     HRESULT hr;
-    int vr;
+    VkResult vr;
 
-    vr = VK_CALL(vkWaitForFences(device->vk_device, 1, &waiting_fence->u.vk_fence, VK_FALSE, ~(uint64_t)0));
-    if (vr == VK_TIMEOUT)
-        return;
-    if (vr != VK_SUCCESS)
+    if (device->vk_info.KHR_timeline_semaphore)
     {
-        ERR("Failed to wait for Vulkan fence, vr %d.\n", vr);
-        return;
+        if ((vr = VK_CALL(vkGetSemaphoreCounterValueKHR(device->vk_device,
+                waiting_fence->u.vk_semaphore, &completed_value))) < 0)
+        {
+            ERR("Failed to get Vulkan semaphore value, vr %d.\n", vr);
+            return false;
+        }
+        if (completed_value < waiting_fence->value)
+            return false;
+
+        TRACE("Signaling fence %p value %#"PRIx64".\n", waiting_fence->fence, waiting_fence->value);
+        d3d12_fence_signal_timeline_semaphore(waiting_fence->fence, waiting_fence->value);
     }
+    else
+    {
+        if ((vr = VK_CALL(vkGetFenceStatus(device->vk_device, waiting_fence->u.vk_fence))) == VK_NOT_READY)
+            return false;
+        if (vr != VK_SUCCESS)
+        {
+            ERR("Failed to get Vulkan fence status, vr %d.\n", vr);
+            return false;
+        }
+
+        TRACE("Signaling fence %p value %#"PRIx64".\n", waiting_fence->fence, waiting_fence->value);
+        if (FAILED(hr = d3d12_fence_signal(waiting_fence->fence, waiting_fence->value,
+                waiting_fence->u.vk_fence, false)))
+            ERR("Failed to signal D3D12 fence, hr %#x.\n", hr);
 
-    TRACE("Signaling fence %p value %#"PRIx64".\n", waiting_fence->fence, waiting_fence->value);
-    if (FAILED(hr = d3d12_fence_signal(waiting_fence->fence, waiting_fence->value, waiting_fence->u.vk_fence, false)))
-        ERR("Failed to signal D3D12 fence, hr %#x.\n", hr);
+        vkd3d_queue_update_sequence_number(waiting_fence->queue, waiting_fence->queue_sequence_number, device);
+    }
 
     d3d12_fence_decref(waiting_fence->fence);
 
-    vkd3d_queue_update_sequence_number(worker->queue, waiting_fence->queue_sequence_number, device);
+    return true;
+}
+
+static void vkd3d_fence_worker_signal_completed(struct vkd3d_fence_worker *worker)
+{
+    size_t i, count;
+
+    /* Pending fences stay in enqueue order, so the values of each D3D12 fence
+     * are signalled in the order they were submitted. */
+    for (i = 0, count = 0; i < worker->pending_count; ++i)
+    {
+        if (!vkd3d_fence_worker_signal_if_complete(worker, &worker->pending[i]))
+            worker->pending[count++] = worker->pending[i];
+    }
+    worker->pending_count = count;
 }
 
 static void *vkd3d_fence_worker_main(void *arg)
 {
-    size_t old_fences_size, cur_fences_size = 0, cur_fence_count = 0;
-    struct vkd3d_waiting_fence *old_fences, *cur_fences = NULL;
     struct vkd3d_fence_worker *worker = arg;
-    unsigned int i;
+    uint64_t wake_value;
 
     vkd3d_set_thread_name("vkd3d_fence");
 
@@ -332,7 +446,7 @@ static void *vkd3d_fence_worker_main(void *arg)
     {
         vkd3d_mutex_lock(&worker->mutex);
 
-        if (!worker->fence_count && !worker->should_exit)
+        if (!worker->fence_count && !worker->pending_count && !worker->should_exit)
             vkd3d_cond_wait(&worker->cond, &worker->mutex);
 
         if (worker->should_exit)
@@ -341,55 +455,102 @@ static void *vkd3d_fence_worker_main(void *arg)
             break;
         }
 
-        old_fences_size = cur_fences_size;
-        old_fences = cur_fences;
-
-        cur_fence_count = worker->fence_count;
-        cur_fences_size = worker->fences_size;
-        cur_fences = worker->fences;
+        if (vkd3d_array_reserve((void **)&worker->pending, &worker->pending_size,
+                worker->pending_count + worker->fence_count, sizeof(*worker->pending)))
+        {
+            memcpy(&worker->pending[worker->pending_count], worker->fences,
+                    worker->fence_count * sizeof(*worker->fences));
+            worker->pending_count += worker->fence_count;
+            worker->fence_count = 0;
+        }
+        else
+        {
+            ERR("Failed to add pending GPU fences.\n");
+        }
 
-        worker->fence_count = 0;
-        worker->fences_size = old_fences_size;
-        worker->fences = old_fences;
+        worker->is_waiting = !!worker->pending_count;
+        wake_value = worker->wake_value;
 
         vkd3d_mutex_unlock(&worker->mutex);
 
-        for (i = 0; i < cur_fence_count; ++i)
-            worker->wait_for_gpu_fence(worker, &cur_fences[i]);
+        if (!worker->pending_count)
+            continue;
+
+        if (worker->device->vk_info.KHR_timeline_semaphore)
+            vkd3d_fence_worker_wait_timeline_semaphores(worker, wake_value);
+        else if (!vkd3d_fence_worker_wait_fences(worker))
+            continue;
+
+        vkd3d_fence_worker_signal_completed(worker);
     }
 
-    vkd3d_free(cur_fences);
     return NULL;
 }
 
-static HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
-        struct vkd3d_queue *queue, struct d3d12_device *device)
+HRESULT vkd3d_fence_worker_init(struct vkd3d_fence_worker *worker, struct d3d12_device *device)
 {
-    HRESULT hr;
+    VkResult vr;
 
     TRACE("worker %p.\n", worker);
 
-    worker->should_exit = false;
-    worker->queue = queue;
+    memset(worker, 0, sizeof(*worker));
     worker->device = device;
 
-    worker->fence_count = 0;
-    worker->fences = NULL;
-    worker->fences_size = 0;
-
-    worker->wait_for_gpu_fence = device->vk_info.KHR_timeline_semaphore
-            ? vkd3d_wait_for_gpu_timeline_semaphore : vkd3d_wait_for_gpu_fence;
+    if (device->vk_info.KHR_timeline_semaphore
+            && (vr = vkd3d_create_timeline_semaphore(device, 0, &worker->vk_wake_semaphore)) < 0)
+    {
+        ERR("Failed to create wake semaphore, vr %d.\n", vr);
+        return hresult_from_vk_result(vr);
+    }
 
     vkd3d_mutex_init(&worker->mutex);
-
     vkd3d_cond_init(&worker->cond);
+    vkd3d_mutex_init(&worker->thread_mutex);
+
+    return S_OK;
+}
 
-    if (FAILED(hr = vkd3d_create_thread(device->vkd3d_instance,
-            vkd3d_fence_worker_main, worker, &worker->thread)))
+void vkd3d_fence_worker_cleanup(struct vkd3d_fence_worker *worker, struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    TRACE("worker %p.\n", worker);
+
+    assert(!worker->queue_count);
+
+    if (worker->fence_count || worker->pending_count)
+        WARN("Destroying fence worker with %zu pending fences.\n", worker->fence_count + worker->pending_count);
+
+    VK_CALL(vkDestroySemaphore(device->vk_device, worker->vk_wake_semaphore, NULL));
+
+    vkd3d_mutex_destroy(&worker->thread_mutex);
+    vkd3d_cond_destroy(&worker->cond);
+    vkd3d_mutex_destroy(&worker->mutex);
+
+    vkd3d_free(worker->fences);
+    vkd3d_free(worker->pending);
+    vkd3d_free(worker->wait_objects);
+    vkd3d_free(worker->wait_values);
+}
+
+static HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
+        struct d3d12_device *device)
+{
+    HRESULT hr = S_OK;
+
+    TRACE("worker %p.\n", worker);
+
+    vkd3d_mutex_lock(&worker->thread_mutex);
+
+    if (!worker->queue_count)
     {
-        vkd3d_mutex_destroy(&worker->mutex);
-        vkd3d_cond_destroy(&worker->cond);
+        worker->should_exit = false;
+        hr = vkd3d_create_thread(device->vkd3d_instance, vkd3d_fence_worker_main, worker, &worker->thread);
     }
+    if (SUCCEEDED(hr))
+        ++worker->queue_count;
+
+    vkd3d_mutex_unlock(&worker->thread_mutex);
 
     return hr;
 }
@@ -397,26 +558,41 @@ static HRESULT vkd3d_fence_worker_start(struct vkd3d_fence_worker *worker,
 static HRESULT vkd3d_fence_worker_stop(struct vkd3d_fence_worker *worker,
         struct d3d12_device *device)
 {
-    HRESULT hr;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkSemaphoreSignalInfoKHR signal_info;
+    HRESULT hr = S_OK;
 
     TRACE("worker %p.\n", worker);
 
+    vkd3d_mutex_lock(&worker->thread_mutex);
+
+    if (--worker->queue_count)
+    {
+        vkd3d_mutex_unlock(&worker->thread_mutex);
+        return S_OK;
+    }
+
     vkd3d_mutex_lock(&worker->mutex);
 
     worker->should_exit = true;
+    if (worker->is_waiting && worker->vk_wake_semaphore)
+    {
+        signal_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR;
+        signal_info.pNext = NULL;
+        signal_info.semaphore = worker->vk_wake_semaphore;
+        signal_info.value = ++worker->wake_value;
+        VK_CALL(vkSignalSemaphoreKHR(device->vk_device, &signal_info));
+        worker->is_waiting = false;
+    }
     vkd3d_cond_signal(&worker->cond);
 
     vkd3d_mutex_unlock(&worker->mutex);
 
-    if (FAILED(hr = vkd3d_join_thread(device->vkd3d_instance, &worker->thread)))
-        return hr;
-
-    vkd3d_mutex_destroy(&worker->mutex);
-    vkd3d_cond_destroy(&worker->cond);
+    hr = vkd3d_join_thread(device->vkd3d_instance, &worker->thread);
 
-    vkd3d_free(worker->fences);
+    vkd3d_mutex_unlock(&worker->thread_mutex);
 
-    return S_OK;
+    return hr;
 }
 
 static const struct d3d12_root_parameter *root_signature_get_parameter(
@@ -637,42 +813,102 @@ static HRESULT d3d12_fence_update_pending_value(struct d3d12_fence *fence)
     return S_OK;
 }
 
-static HRESULT d3d12_command_queue_record_as_blocked(struct d3d12_command_queue *command_queue)
+static struct vkd3d_blocked_queue *d3d12_device_find_blocked_queue_locked(struct d3d12_device *device,
+        const struct d3d12_command_queue *command_queue)
+{
+    size_t i;
+
+    for (i = 0; i < device->blocked_queue_count; ++i)
+    {
+        if (device->blocked_queues[i].queue == command_queue)
+            return &device->blocked_queues[i];
+    }
+
+    return NULL;
+}
+
+static HRESULT d3d12_command_queue_record_as_blocked(struct d3d12_command_queue *command_queue,
+        struct d3d12_fence *fence, uint64_t value)
 {
     struct d3d12_device *device = command_queue->device;
+    struct vkd3d_blocked_queue *blocked_queue;
     HRESULT hr = S_OK;
 
     vkd3d_mutex_lock(&device->blocked_queues_mutex);
 
-    if (device->blocked_queue_count < ARRAY_SIZE(device->blocked_queues))
+    /* A queue blocks on at most one wait op at a time, so an existing entry
+     * is the same wait being flushed again. */
+    if ((blocked_queue = d3d12_device_find_blocked_queue_locked(device, command_queue)))
+    {
+        if (blocked_queue->fence != fence)
+        {
+            d3d12_fence_incref(fence);
+            d3d12_fence_decref(blocked_queue->fence);
+            blocked_queue->fence = fence;
+        }
+        blocked_queue->value = value;
+    }
+    else if (vkd3d_array_reserve((void **)&device->blocked_queues, &device->blocked_queues_size,
+            device->blocked_queue_count + 1, sizeof(*device->blocked_queues)))
     {
-        device->blocked_queues[device->blocked_queue_count++] = command_queue;
+        blocked_queue = &device->blocked_queues[device->blocked_queue_count++];
+        blocked_queue->queue = command_queue;
+        blocked_queue->fence = fence;
+        blocked_queue->value = value;
+        d3d12_fence_incref(fence);
     }
     else
     {
         WARN("Failed to add blocked command queue %p to device %p.\n", command_queue, device);
-        hr = E_FAIL;
+        hr = E_OUTOFMEMORY;
     }
 
     vkd3d_mutex_unlock(&device->blocked_queues_mutex);
     return hr;
 }
 
+static void d3d12_device_remove_blocked_queue(struct d3d12_device *device,
+        struct d3d12_command_queue *command_queue)
+{
+    size_t i;
+
+    vkd3d_mutex_lock(&device->blocked_queues_mutex);
+
+    for (i = 0; i < device->blocked_queue_count;)
+    {
+        if (device->blocked_queues[i].queue == command_queue)
+        {
+            d3d12_fence_decref(device->blocked_queues[i].fence);
+            device->blocked_queues[i] = device->blocked_queues[--device->blocked_queue_count];
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    vkd3d_mutex_unlock(&device->blocked_queues_mutex);
+}
+
 static HRESULT d3d12_device_flush_blocked_queues_once(struct d3d12_device *device, bool *flushed_any)
 {
-    struct d3d12_command_queue *blocked_queues[VKD3D_MAX_DEVICE_BLOCKED_QUEUES];
-    unsigned int i, blocked_queue_count;
+    struct vkd3d_blocked_queue *blocked_queues, *blocked_queue;
+    size_t i, blocked_queue_count, blocked_queues_size;
+    size_t still_blocked_count = 0;
     HRESULT hr = S_OK;
+    bool is_blocked;
 
     *flushed_any = false;
 
     vkd3d_mutex_lock(&device->blocked_queues_mutex);
 
     /* Flush any ops unblocked by a new pending value. These cannot be
-     * flushed while holding blocked_queue_mutex, so move the queue
-     * pointers to a local array. */
+     * flushed while holding blocked_queue_mutex, so take the list. */
+    blocked_queues = device->blocked_queues;
+    blocked_queues_size = device->blocked_queues_size;
     blocked_queue_count = device->blocked_queue_count;
-    memcpy(blocked_queues, device->blocked_queues, blocked_queue_count * sizeof(blocked_queues[0]));
+    device->blocked_queues = NULL;
+    device->blocked_queues_size = 0;
     device->blocked_queue_count = 0;
 
     vkd3d_mutex_unlock(&device->blocked_queues_mutex);
@@ -681,12 +917,64 @@ static HRESULT d3d12_device_flush_blocked_queues_once(struct d3d12_device *devic
     {
         HRESULT new_hr;
 
-        new_hr = d3d12_command_queue_flush_ops(blocked_queues[i], flushed_any);
+        blocked_queue = &blocked_queues[i];
+
+        /* Only queues whose wait can now be submitted are flushed. */
+        vkd3d_mutex_lock(&blocked_queue->fence->mutex);
+        is_blocked = blocked_queue->value > blocked_queue->fence->max_pending_value;
+        vkd3d_mutex_unlock(&blocked_queue->fence->mutex);
+
+        if (is_blocked)
+        {
+            blocked_queues[still_blocked_count++] = *blocked_queue;
+            continue;
+        }
+
+        d3d12_fence_decref(blocked_queue->fence);
+
+        new_hr = d3d12_command_queue_flush_ops(blocked_queue->queue, flushed_any);
 
         if (SUCCEEDED(hr))
             hr = new_hr;
     }
 
+    if (still_blocked_count)
+    {
+        vkd3d_mutex_lock(&device->blocked_queues_mutex);
+
+        if (!device->blocked_queue_count)
+        {
+            vkd3d_free(device->blocked_queues);
+            device->blocked_queues = blocked_queues;
+            device->blocked_queues_size = blocked_queues_size;
+            device->blocked_queue_count = still_blocked_count;
+            blocked_queues = NULL;
+        }
+        else if (vkd3d_array_reserve((void **)&device->blocked_queues, &device->blocked_queues_size,
+                device->blocked_queue_count + still_blocked_count, sizeof(*device->blocked_queues)))
+        {
+            /* Queues may have been recorded again while the list was taken. */
+            for (i = 0; i < still_blocked_count; ++i)
+            {
+                if (d3d12_device_find_blocked_queue_locked(device, blocked_queues[i].queue))
+                    d3d12_fence_decref(blocked_queues[i].fence);
+                else
+                    device->blocked_queues[device->blocked_queue_count++] = blocked_queues[i];
+            }
+        }
+        else
+        {
+            ERR("Failed to re-add blocked command queues.\n");
+            for (i = 0; i < still_blocked_count; ++i)
+                d3d12_fence_decref(blocked_queues[i].fence);
+            hr = E_OUTOFMEMORY;
+        }
+
+        vkd3d_mutex_unlock(&device->blocked_queues_mutex);
+    }
+
+    vkd3d_free(blocked_queues);
+
     return hr;
 }
 
@@ -739,80 +1027,201 @@ static HRESULT d3d12_fence_add_vk_semaphore(struct d3d12_fence *fence, VkSemapho
     return d3d12_device_flush_blocked_queues(fence->device);
 }
 
+/* A wait set up by SetEventOnMultipleFenceCompletion(). Each fence holds a
+ * reference through its waiting event entry. */
+struct vkd3d_fence_multi_wait
+{
+    LONG refcount;
+    LONG pending_count;
+    HANDLE event;
+    bool signaled;
+    struct vkd3d_mutex mutex;
+    struct vkd3d_cond cond;
+    struct d3d12_device *device;
+};
+
+static void vkd3d_fence_multi_wait_decref(struct vkd3d_fence_multi_wait *wait)
+{
+    if (InterlockedDecrement(&wait->refcount))
+        return;
+
+    vkd3d_cond_destroy(&wait->cond);
+    vkd3d_mutex_destroy(&wait->mutex);
+    vkd3d_free(wait);
+}
+
+static void vkd3d_fence_multi_wait_complete_one(struct vkd3d_fence_multi_wait *wait)
+{
+    /* For D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY the pending count starts at 1,
+     * so only the first completed fence signals the wait. */
+    if (!InterlockedDecrement(&wait->pending_count))
+    {
+        if (wait->event)
+        {
+            wait->device->signal_event(wait->event);
+        }
+        else
+        {
+            vkd3d_mutex_lock(&wait->mutex);
+            wait->signaled = true;
+            vkd3d_cond_broadcast(&wait->cond);
+            vkd3d_mutex_unlock(&wait->mutex);
+        }
+    }
+
+    vkd3d_fence_multi_wait_decref(wait);
+}
+
 static void d3d12_fence_signal_external_events_locked(struct d3d12_fence *fence)
 {
     struct d3d12_device *device = fence->device;
     bool signal_null_event_cond = false;
-    unsigned int i, j;
+    struct vkd3d_waiting_event *current;
 
-    for (i = 0, j = 0; i < fence->event_count; ++i)
+    /* Waiters are sorted by value, so only the completed ones are visited. */
+    while (fence->event_count && (current = &fence->events[fence->event_start])->value <= fence->value)
     {
-        struct vkd3d_waiting_event *current = &fence->events[i];
-
-        if (current->value <= fence->value)
+        if (current->multi_wait)
         {
-            if (current->event)
-            {
-                device->signal_event(current->event);
-            }
-            else
-            {
-                *current->latch = true;
-                signal_null_event_cond = true;
-            }
+            vkd3d_fence_multi_wait_complete_one(current->multi_wait);
+        }
+        else if (current->event)
+        {
+            device->signal_event(current->event);
         }
         else
         {
-            if (i != j)
-                fence->events[j] = *current;
-            ++j;
+            *current->latch = true;
+            signal_null_event_cond = true;
         }
+
+        ++fence->event_start;
+        --fence->event_count;
     }
 
-    fence->event_count = j;
+    if (!fence->event_count)
+        fence->event_start = 0;
 
     if (signal_null_event_cond)
         vkd3d_cond_broadcast(&fence->null_event_cond);
 }
 
-static HRESULT d3d12_fence_signal(struct d3d12_fence *fence, uint64_t value, VkFence vk_fence, bool on_cpu)
+static HRESULT d3d12_fence_add_waiting_event_locked(struct d3d12_fence *fence,
+        uint64_t value, HANDLE event, bool *latch, struct vkd3d_fence_multi_wait *multi_wait)
 {
-    struct d3d12_device *device = fence->device;
-    struct vkd3d_signaled_semaphore *current;
-    unsigned int i;
-
-    vkd3d_mutex_lock(&fence->mutex);
+    struct vkd3d_waiting_event *events;
+    size_t lo, hi, mid, i;
 
-    fence->value = value;
-
-    d3d12_fence_signal_external_events_locked(fence);
+    events = &fence->events[fence->event_start];
 
-    if (vk_fence)
+    /* Find the insertion point after any waiters for the same value. Values
+     * are usually increasing, so check the end first. */
+    lo = 0;
+    hi = fence->event_count;
+    if (hi && events[hi - 1].value > value)
     {
-        const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-
-        for (i = 0; i < fence->semaphore_count; ++i)
+        while (lo < hi)
         {
-            current = &fence->semaphores[i];
-            if (current->u.binary.vk_fence == vk_fence)
-                current->u.binary.vk_fence = VK_NULL_HANDLE;
+            mid = lo + (hi - lo) / 2;
+            if (events[mid].value <= value)
+                lo = mid + 1;
+            else
+                hi = mid;
         }
+    }
 
-        for (i = 0; i < ARRAY_SIZE(fence->old_vk_fences); ++i)
+    for (i = hi; !multi_wait && i && events[i - 1].value == value; --i)
+    {
+        if (!events[i - 1].multi_wait && events[i - 1].event == event)
         {
-            if (fence->old_vk_fences[i] == VK_NULL_HANDLE)
-            {
-                fence->old_vk_fences[i] = vk_fence;
-                VK_CALL(vkResetFences(device->vk_device, 1, &vk_fence));
-                vk_fence = VK_NULL_HANDLE;
-                break;
-            }
+            WARN("Event completion for (%p, %#"PRIx64") is already in the list.\n",
+                    event, value);
+            return S_FALSE;
         }
-        if (vk_fence)
-            VK_CALL(vkDestroyFence(device->vk_device, vk_fence, NULL));
     }
 
-    d3d12_fence_update_pending_value_locked(fence);
+    if (fence->event_start && fence->event_start + fence->event_count == fence->events_size)
+    {
+        memmove(fence->events, events, fence->event_count * sizeof(*fence->events));
+        fence->event_start = 0;
+    }
+
+    if (!vkd3d_array_reserve((void **)&fence->events, &fence->events_size,
+            fence->event_start + fence->event_count + 1, sizeof(*fence->events)))
+    {
+        WARN("Failed to add event.\n");
+        return E_OUTOFMEMORY;
+    }
+
+    events = &fence->events[fence->event_start];
+    memmove(&events[hi + 1], &events[hi], (fence->event_count - hi) * sizeof(*events));
+    events[hi].value = value;
+    events[hi].event = event;
+    events[hi].latch = latch;
+    events[hi].multi_wait = multi_wait;
+    ++fence->event_count;
+
+    return S_OK;
+}
+
+static void d3d12_fence_remove_multi_wait_locked(struct d3d12_fence *fence,
+        struct vkd3d_fence_multi_wait *multi_wait)
+{
+    struct vkd3d_waiting_event *events = &fence->events[fence->event_start];
+    size_t i, j;
+
+    for (i = 0, j = 0; i < fence->event_count; ++i)
+    {
+        if (events[i].multi_wait == multi_wait)
+        {
+            vkd3d_fence_multi_wait_decref(multi_wait);
+            continue;
+        }
+        if (i != j)
+            events[j] = events[i];
+        ++j;
+    }
+    fence->event_count = j;
+}
+
+static HRESULT d3d12_fence_signal(struct d3d12_fence *fence, uint64_t value, VkFence vk_fence, bool on_cpu)
+{
+    struct d3d12_device *device = fence->device;
+    struct vkd3d_signaled_semaphore *current;
+    unsigned int i;
+
+    vkd3d_mutex_lock(&fence->mutex);
+
+    fence->value = value;
+
+    d3d12_fence_signal_external_events_locked(fence);
+
+    if (vk_fence)
+    {
+        const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+        for (i = 0; i < fence->semaphore_count; ++i)
+        {
+            current = &fence->semaphores[i];
+            if (current->u.binary.vk_fence == vk_fence)
+                current->u.binary.vk_fence = VK_NULL_HANDLE;
+        }
+
+        for (i = 0; i < ARRAY_SIZE(fence->old_vk_fences); ++i)
+        {
+            if (fence->old_vk_fences[i] == VK_NULL_HANDLE)
+            {
+                fence->old_vk_fences[i] = vk_fence;
+                VK_CALL(vkResetFences(device->vk_device, 1, &vk_fence));
+                vk_fence = VK_NULL_HANDLE;
+                break;
+            }
+        }
+        if (vk_fence)
+            VK_CALL(vkDestroyFence(device->vk_device, vk_fence, NULL));
+    }
+
+    d3d12_fence_update_pending_value_locked(fence);
 
     vkd3d_mutex_unlock(&fence->mutex);
 
@@ -866,11 +1275,12 @@ static void d3d12_fence_signal_timeline_semaphore(struct d3d12_fence *fence, uin
 
     vkd3d_mutex_lock(&fence->mutex);
 
-    /* With multiple fence workers, it is possible that signal calls are out of
-     * order. The physical value itself is monotonic, but we need to make sure
-     * that all signals happen in correct order if there are fence rewinds.
-     * We don't expect the loop to run more than once, but there might be
-     * extreme edge cases where we signal 2 or more. */
+    /* A single wait may complete several values, and a value may be observed
+     * as complete before the worker dispatches it. The physical value itself
+     * is monotonic, but we need to make sure that all signals happen in
+     * correct order if there are fence rewinds. We don't expect the loop to
+     * run more than once, but there might be extreme edge cases where we
+     * signal 2 or more. */
     while (fence->timeline_value < timeline_value)
     {
         ++fence->timeline_value;
@@ -956,11 +1366,17 @@ static void d3d12_fence_decref(struct d3d12_fence *fence)
     if (!internal_refcount)
     {
         struct d3d12_device *device = fence->device;
+        size_t i;
 
         vkd3d_private_store_destroy(&fence->private_store);
 
         d3d12_fence_destroy_vk_objects(fence);
 
+        for (i = 0; i < fence->event_count; ++i)
+        {
+            if (fence->events[fence->event_start + i].multi_wait)
+                vkd3d_fence_multi_wait_decref(fence->events[fence->event_start + i].multi_wait);
+        }
         vkd3d_free(fence->events);
         vkd3d_free(fence->semaphores);
         vkd3d_mutex_destroy(&fence->mutex);
@@ -1038,8 +1454,8 @@ static HRESULT STDMETHODCALLTYPE d3d12_fence_SetEventOnCompletion(ID3D12Fence *i
         UINT64 value, HANDLE event)
 {
     struct d3d12_fence *fence = impl_from_ID3D12Fence(iface);
-    unsigned int i;
     bool latch = false;
+    HRESULT hr;
 
     TRACE("iface %p, value %#"PRIx64", event %p.\n", iface, value, event);
 
@@ -1053,31 +1469,12 @@ static HRESULT STDMETHODCALLTYPE d3d12_fence_SetEventOnCompletion(ID3D12Fence *i
         return S_OK;
     }
 
-    for (i = 0; i < fence->event_count; ++i)
-    {
-        struct vkd3d_waiting_event *current = &fence->events[i];
-        if (current->value == value && current->event == event)
-        {
-            WARN("Event completion for (%p, %#"PRIx64") is already in the list.\n",
-                    event, value);
-            vkd3d_mutex_unlock(&fence->mutex);
-            return S_OK;
-        }
-    }
-
-    if (!vkd3d_array_reserve((void **)&fence->events, &fence->events_size,
-            fence->event_count + 1, sizeof(*fence->events)))
+    if ((hr = d3d12_fence_add_waiting_event_locked(fence, value, event, &latch, NULL)) != S_OK)
     {
-        WARN("Failed to add event.\n");
         vkd3d_mutex_unlock(&fence->mutex);
-        return E_OUTOFMEMORY;
+        return SUCCEEDED(hr) ? S_OK : hr;
     }
 
-    fence->events[fence->event_count].value = value;
-    fence->events[fence->event_count].event = event;
-    fence->events[fence->event_count].latch = &latch;
-    ++fence->event_count;
-
     /* If event is NULL, we need to block until the fence value completes.
      * Implement this in a uniform way where we pretend we have a dummy event.
      * A NULL fence->events[].event means that we should set latch to true
@@ -1166,6 +1563,7 @@ static HRESULT d3d12_fence_init(struct d3d12_fence *fence, struct d3d12_device *
 
     fence->events = NULL;
     fence->events_size = 0;
+    fence->event_start = 0;
     fence->event_count = 0;
 
     fence->timeline_semaphore = VK_NULL_HANDLE;
@@ -1220,6 +1618,91 @@ HRESULT d3d12_fence_create(struct d3d12_device *device,
     return S_OK;
 }
 
+HRESULT vkd3d_set_event_on_multiple_fence_completion(struct d3d12_device *device, ID3D12Fence * const *fences,
+        const uint64_t *values, unsigned int fence_count, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, HANDLE event)
+{
+    struct vkd3d_fence_multi_wait *wait;
+    struct d3d12_fence *fence;
+    HRESULT hr = S_OK;
+    unsigned int i;
+
+    if (flags & ~D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY)
+    {
+        WARN("Invalid flags %#x.\n", flags);
+        return E_INVALIDARG;
+    }
+
+    if (!fence_count)
+    {
+        if (event)
+            device->signal_event(event);
+        return S_OK;
+    }
+
+    if (!(wait = vkd3d_malloc(sizeof(*wait))))
+        return E_OUTOFMEMORY;
+
+    wait->refcount = 1;
+    wait->pending_count = (flags & D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY) ? 1 : fence_count;
+    wait->event = event;
+    wait->signaled = false;
+    vkd3d_mutex_init(&wait->mutex);
+    vkd3d_cond_init(&wait->cond);
+    wait->device = device;
+
+    for (i = 0; i < fence_count && wait->pending_count > 0; ++i)
+    {
+        fence = unsafe_impl_from_ID3D12Fence(fences[i]);
+
+        InterlockedIncrement(&wait->refcount);
+
+        vkd3d_mutex_lock(&fence->mutex);
+
+        if (values[i] <= fence->value)
+        {
+            vkd3d_mutex_unlock(&fence->mutex);
+            vkd3d_fence_multi_wait_complete_one(wait);
+            continue;
+        }
+
+        if (FAILED(hr = d3d12_fence_add_waiting_event_locked(fence, values[i], NULL, NULL, wait)))
+        {
+            vkd3d_mutex_unlock(&fence->mutex);
+            vkd3d_fence_multi_wait_decref(wait);
+            break;
+        }
+
+        vkd3d_mutex_unlock(&fence->mutex);
+    }
+
+    /* Don't leave the event registered on the fences which were already
+     * handled if the wait as a whole failed. */
+    if (FAILED(hr))
+    {
+        while (i--)
+        {
+            fence = unsafe_impl_from_ID3D12Fence(fences[i]);
+            vkd3d_mutex_lock(&fence->mutex);
+            d3d12_fence_remove_multi_wait_locked(fence, wait);
+            vkd3d_mutex_unlock(&fence->mutex);
+        }
+    }
+
+    /* As with SetEventOnCompletion(), a NULL event means we block until the
+     * wait is satisfied. */
+    if (SUCCEEDED(hr) && !event)
+    {
+        vkd3d_mutex_lock(&wait->mutex);
+        while (!wait->signaled)
+            vkd3d_cond_wait(&wait->cond, &wait->mutex);
+        vkd3d_mutex_unlock(&wait->mutex);
+    }
+
+    vkd3d_fence_multi_wait_decref(wait);
+
+    return hr;
+}
+
 VkResult vkd3d_create_timeline_semaphore(const struct d3d12_device *device, uint64_t initial_value,
         VkSemaphore *timeline_semaphore)
 {
@@ -1343,31 +1826,8 @@ static void d3d12_command_allocator_free_command_buffer(struct d3d12_command_all
     allocator->command_buffers[allocator->command_buffer_count++] = list->vk_command_buffer;
 }
 
-static bool d3d12_command_allocator_add_render_pass(struct d3d12_command_allocator *allocator, VkRenderPass pass)
-{
-    if (!vkd3d_array_reserve((void **)&allocator->passes, &allocator->passes_size,
-            allocator->pass_count + 1, sizeof(*allocator->passes)))
-        return false;
-
-    allocator->passes[allocator->pass_count++] = pass;
-
-    return true;
-}
-
-static bool d3d12_command_allocator_add_framebuffer(struct d3d12_command_allocator *allocator,
-        VkFramebuffer framebuffer)
-{
-    if (!vkd3d_array_reserve((void **)&allocator->framebuffers, &allocator->framebuffers_size,
-            allocator->framebuffer_count + 1, sizeof(*allocator->framebuffers)))
-        return false;
-
-    allocator->framebuffers[allocator->framebuffer_count++] = framebuffer;
-
-    return true;
-}
-
 static bool d3d12_command_allocator_add_descriptor_pool(struct d3d12_command_allocator *allocator,
-        VkDescriptorPool pool)
+        struct vkd3d_descriptor_pool *pool)
 {
     if (!vkd3d_array_reserve((void **)&allocator->descriptor_pools, &allocator->descriptor_pools_size,
             allocator->descriptor_pool_count + 1, sizeof(*allocator->descriptor_pools)))
@@ -1403,57 +1863,181 @@ static bool d3d12_command_allocator_add_buffer_view(struct d3d12_command_allocat
     return true;
 }
 
-static bool d3d12_command_allocator_add_transfer_buffer(struct d3d12_command_allocator *allocator,
-        const struct vkd3d_buffer *buffer)
+#define VKD3D_DESCRIPTOR_POOL_DEFAULT_SETS 512u
+#define VKD3D_DESCRIPTOR_POOL_MIN_SETS 64u
+#define VKD3D_DESCRIPTOR_POOL_MAX_SETS 4096u
+#define VKD3D_DESCRIPTOR_POOL_USAGE_THRESHOLD 8
+
+void vkd3d_descriptor_pool_cache_init(struct vkd3d_descriptor_pool_cache *cache)
 {
-    if (!vkd3d_array_reserve((void **)&allocator->transfer_buffers, &allocator->transfer_buffers_size,
-            allocator->transfer_buffer_count + 1, sizeof(*allocator->transfer_buffers)))
-        return false;
+    memset(cache, 0, sizeof(*cache));
+    cache->max_sets = VKD3D_DESCRIPTOR_POOL_DEFAULT_SETS;
+}
 
-    allocator->transfer_buffers[allocator->transfer_buffer_count++] = *buffer;
+static void vkd3d_descriptor_pool_destroy(struct vkd3d_descriptor_pool *pool, struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
-    return true;
+    VK_CALL(vkDestroyDescriptorPool(device->vk_device, pool->vk_pool, NULL));
+    vkd3d_free(pool);
 }
 
-static VkDescriptorPool d3d12_command_allocator_allocate_descriptor_pool(
-        struct d3d12_command_allocator *allocator)
+void vkd3d_descriptor_pool_cache_cleanup(struct vkd3d_descriptor_pool_cache *cache, struct d3d12_device *device)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(cache->pools); ++i)
+    {
+        if (cache->pools[i])
+            vkd3d_descriptor_pool_destroy(cache->pools[i], device);
+        cache->pools[i] = NULL;
+    }
+}
+
+static struct vkd3d_descriptor_pool *vkd3d_descriptor_pool_create(struct d3d12_device *device,
+        unsigned int max_sets)
 {
-    struct d3d12_device *device = allocator->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkDescriptorPoolSize pool_sizes[ARRAY_SIZE(device->vk_pool_sizes)];
     struct VkDescriptorPoolCreateInfo pool_desc;
-    VkDevice vk_device = device->vk_device;
-    VkDescriptorPool vk_pool;
+    struct vkd3d_descriptor_pool *pool;
+    unsigned int i, set_count;
+    uint64_t count;
     VkResult vr;
 
-    if (allocator->free_descriptor_pool_count > 0)
+    if (!(pool = vkd3d_malloc(sizeof(*pool))))
+        return NULL;
+
+    /* Descriptor counts scale with the set count, so that growing a pool
+     * doesn't just run out of descriptors sooner. */
+    set_count = max_sets ? max_sets : VKD3D_DESCRIPTOR_POOL_DEFAULT_SETS;
+    for (i = 0; i < ARRAY_SIZE(pool_sizes); ++i)
     {
-        vk_pool = allocator->free_descriptor_pools[allocator->free_descriptor_pool_count - 1];
-        allocator->free_descriptor_pools[allocator->free_descriptor_pool_count - 1] = VK_NULL_HANDLE;
-        --allocator->free_descriptor_pool_count;
+        count = (uint64_t)device->vk_pool_sizes[i].descriptorCount * set_count / VKD3D_DESCRIPTOR_POOL_DEFAULT_SETS;
+        pool_sizes[i].type = device->vk_pool_sizes[i].type;
+        pool_sizes[i].descriptorCount = min(max(count, 1), UINT32_MAX);
     }
+
+    pool_desc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_desc.pNext = NULL;
+    pool_desc.flags = 0;
+    pool_desc.maxSets = set_count;
+    pool_desc.poolSizeCount = ARRAY_SIZE(pool_sizes);
+    pool_desc.pPoolSizes = pool_sizes;
+    if ((vr = VK_CALL(vkCreateDescriptorPool(device->vk_device, &pool_desc, NULL, &pool->vk_pool))) < 0)
+    {
+        ERR("Failed to create descriptor pool, vr %d.\n", vr);
+        vkd3d_free(pool);
+        return NULL;
+    }
+    pool->max_sets = max_sets;
+
+    return pool;
+}
+
+static struct vkd3d_descriptor_pool *vkd3d_descriptor_pool_cache_get(struct vkd3d_descriptor_pool_cache *cache,
+        struct d3d12_device *device)
+{
+    struct vkd3d_descriptor_pool *pool;
+    unsigned int i, max_sets;
+
+    max_sets = cache->max_sets;
+    for (i = 0; i < ARRAY_SIZE(cache->pools); ++i)
+    {
+        if (!(pool = cache->pools[i]))
+            continue;
+        if (InterlockedCompareExchangePointer((void * volatile *)&cache->pools[i], NULL, pool) != pool)
+            continue;
+        if (pool->max_sets == max_sets)
+            return pool;
+        /* Sized for a previous target. */
+        vkd3d_descriptor_pool_destroy(pool, device);
+    }
+
+    return vkd3d_descriptor_pool_create(device, max_sets);
+}
+
+/* The pool must no longer be in use by the GPU. */
+static void vkd3d_descriptor_pool_cache_put(struct vkd3d_descriptor_pool_cache *cache,
+        struct d3d12_device *device, struct vkd3d_descriptor_pool *pool)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    unsigned int i;
+
+    if (pool->max_sets == (unsigned int)cache->max_sets)
+    {
+        VK_CALL(vkResetDescriptorPool(device->vk_device, pool->vk_pool, 0));
+
+        for (i = 0; i < ARRAY_SIZE(cache->pools); ++i)
+        {
+            if (!cache->pools[i] && !InterlockedCompareExchangePointer((void * volatile *)&cache->pools[i],
+                    pool, NULL))
+                return;
+        }
+    }
+
+    vkd3d_descriptor_pool_destroy(pool, device);
+}
+
+/* Grow pools when allocators routinely need several of them between resets,
+ * and shrink them when most of a pool goes unused. Sets of all layouts are
+ * allocated from the allocator's current pool, so usage is tracked for all
+ * layouts together. A set with a large variable count which doesn't fit a
+ * shrunk pool gets a pool of the default size instead. */
+static void vkd3d_descriptor_pool_cache_update_usage(struct vkd3d_descriptor_pool_cache *cache,
+        unsigned int set_count, size_t pool_count)
+{
+    LONG max_sets = cache->max_sets;
+    LONG score;
+
+    if (pool_count > 1)
+        score = InterlockedIncrement(&cache->usage_score);
+    else if (pool_count && set_count < (unsigned int)max_sets / 4)
+        score = InterlockedDecrement(&cache->usage_score);
     else
+        return;
+
+    if (score == VKD3D_DESCRIPTOR_POOL_USAGE_THRESHOLD)
     {
-        pool_desc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        pool_desc.pNext = NULL;
-        pool_desc.flags = 0;
-        pool_desc.maxSets = 512;
-        pool_desc.poolSizeCount = ARRAY_SIZE(device->vk_pool_sizes);
-        pool_desc.pPoolSizes = device->vk_pool_sizes;
-        if ((vr = VK_CALL(vkCreateDescriptorPool(vk_device, &pool_desc, NULL, &vk_pool))) < 0)
+        InterlockedAdd(&cache->usage_score, -VKD3D_DESCRIPTOR_POOL_USAGE_THRESHOLD);
+        if (max_sets < VKD3D_DESCRIPTOR_POOL_MAX_SETS)
         {
-            ERR("Failed to create descriptor pool, vr %d.\n", vr);
-            return VK_NULL_HANDLE;
+            TRACE("Growing descriptor pools to %d sets.\n", max_sets * 2);
+            cache->max_sets = max_sets * 2;
+        }
+    }
+    else if (score == -VKD3D_DESCRIPTOR_POOL_USAGE_THRESHOLD)
+    {
+        InterlockedAdd(&cache->usage_score, VKD3D_DESCRIPTOR_POOL_USAGE_THRESHOLD);
+        if (max_sets > VKD3D_DESCRIPTOR_POOL_MIN_SETS)
+        {
+            TRACE("Shrinking descriptor pools to %d sets.\n", max_sets / 2);
+            cache->max_sets = max_sets / 2;
         }
     }
+}
 
-    if (!(d3d12_command_allocator_add_descriptor_pool(allocator, vk_pool)))
+static VkDescriptorPool d3d12_command_allocator_allocate_descriptor_pool(
+        struct d3d12_command_allocator *allocator, bool oversized)
+{
+    struct d3d12_device *device = allocator->device;
+    struct vkd3d_descriptor_pool *pool;
+
+    if (oversized)
+        pool = vkd3d_descriptor_pool_create(device, 0);
+    else
+        pool = vkd3d_descriptor_pool_cache_get(&device->descriptor_pool_cache, device);
+    if (!pool)
+        return VK_NULL_HANDLE;
+
+    if (!(d3d12_command_allocator_add_descriptor_pool(allocator, pool)))
     {
         ERR("Failed to add descriptor pool.\n");
-        VK_CALL(vkDestroyDescriptorPool(vk_device, vk_pool, NULL));
+        vkd3d_descriptor_pool_cache_put(&device->descriptor_pool_cache, device, pool);
         return VK_NULL_HANDLE;
     }
 
-    return vk_pool;
+    return pool->vk_pool;
 }
 
 static VkDescriptorSet d3d12_command_allocator_allocate_descriptor_set(
@@ -1464,12 +2048,13 @@ static VkDescriptorSet d3d12_command_allocator_allocate_descriptor_set(
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkDescriptorSetVariableDescriptorCountAllocateInfoEXT set_size;
     struct VkDescriptorSetAllocateInfo set_desc;
+    struct vkd3d_descriptor_pool *pool;
     VkDevice vk_device = device->vk_device;
     VkDescriptorSet vk_descriptor_set;
     VkResult vr;
 
     if (!allocator->vk_descriptor_pool)
-        allocator->vk_descriptor_pool = d3d12_command_allocator_allocate_descriptor_pool(allocator);
+        allocator->vk_descriptor_pool = d3d12_command_allocator_allocate_descriptor_pool(allocator, false);
     if (!allocator->vk_descriptor_pool)
         return VK_NULL_HANDLE;
 
@@ -1487,11 +2072,14 @@ static VkDescriptorSet d3d12_command_allocator_allocate_descriptor_set(
         set_size.pDescriptorCounts = &variable_binding_size;
     }
     if ((vr = VK_CALL(vkAllocateDescriptorSets(vk_device, &set_desc, &vk_descriptor_set))) >= 0)
+    {
+        ++allocator->descriptor_set_count;
         return vk_descriptor_set;
+    }
 
     allocator->vk_descriptor_pool = VK_NULL_HANDLE;
     if (vr == VK_ERROR_FRAGMENTED_POOL || vr == VK_ERROR_OUT_OF_POOL_MEMORY_KHR)
-        allocator->vk_descriptor_pool = d3d12_command_allocator_allocate_descriptor_pool(allocator);
+        allocator->vk_descriptor_pool = d3d12_command_allocator_allocate_descriptor_pool(allocator, false);
     if (!allocator->vk_descriptor_pool)
     {
         ERR("Failed to allocate descriptor set, vr %d.\n", vr);
@@ -1501,10 +2089,24 @@ static VkDescriptorSet d3d12_command_allocator_allocate_descriptor_set(
     set_desc.descriptorPool = allocator->vk_descriptor_pool;
     if ((vr = VK_CALL(vkAllocateDescriptorSets(vk_device, &set_desc, &vk_descriptor_set))) < 0)
     {
-        FIXME("Failed to allocate descriptor set from a new pool, vr %d.\n", vr);
-        return VK_NULL_HANDLE;
+        pool = allocator->descriptor_pools[allocator->descriptor_pool_count - 1];
+        /* A pool sized down for small sets may be unable to hold a large
+         * variable count set; retry with a pool of the default size. */
+        if (vr == VK_ERROR_OUT_OF_POOL_MEMORY_KHR && pool->max_sets
+                && pool->max_sets < VKD3D_DESCRIPTOR_POOL_DEFAULT_SETS
+                && (allocator->vk_descriptor_pool = d3d12_command_allocator_allocate_descriptor_pool(allocator, true)))
+        {
+            set_desc.descriptorPool = allocator->vk_descriptor_pool;
+            vr = VK_CALL(vkAllocateDescriptorSets(vk_device, &set_desc, &vk_descriptor_set));
+        }
+        if (vr < 0)
+        {
+            FIXME("Failed to allocate descriptor set from a new pool, vr %d.\n", vr);
+            return VK_NULL_HANDLE;
+        }
     }
 
+    ++allocator->descriptor_set_count;
     return vk_descriptor_set;
 }
 
@@ -1520,7 +2122,7 @@ static void vkd3d_buffer_destroy(struct vkd3d_buffer *buffer, struct d3d12_devic
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
-    VK_CALL(vkFreeMemory(device->vk_device, buffer->vk_memory, NULL));
+    vkd3d_free_device_memory(device, buffer->vk_memory);
     VK_CALL(vkDestroyBuffer(device->vk_device, buffer->vk_buffer, NULL));
 }
 
@@ -1529,40 +2131,29 @@ static void d3d12_command_allocator_free_resources(struct d3d12_command_allocato
 {
     struct d3d12_device *device = allocator->device;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    unsigned int i, j;
+    unsigned int i;
 
+    /* Descriptor pools go back to the device, where any allocator can reuse them. */
     allocator->vk_descriptor_pool = VK_NULL_HANDLE;
-
-    if (keep_reusable_resources)
+    vkd3d_descriptor_pool_cache_update_usage(&device->descriptor_pool_cache,
+            allocator->descriptor_set_count, allocator->descriptor_pool_count);
+    allocator->descriptor_set_count = 0;
+    for (i = 0; i < allocator->descriptor_pool_count; ++i)
     {
-        if (vkd3d_array_reserve((void **)&allocator->free_descriptor_pools,
-                &allocator->free_descriptor_pools_size,
-                allocator->free_descriptor_pool_count + allocator->descriptor_pool_count,
-                sizeof(*allocator->free_descriptor_pools)))
-        {
-            for (i = 0, j = allocator->free_descriptor_pool_count; i < allocator->descriptor_pool_count; ++i, ++j)
-            {
-                VK_CALL(vkResetDescriptorPool(device->vk_device, allocator->descriptor_pools[i], 0));
-                allocator->free_descriptor_pools[j] = allocator->descriptor_pools[i];
-            }
-            allocator->free_descriptor_pool_count += allocator->descriptor_pool_count;
-            allocator->descriptor_pool_count = 0;
-        }
+        vkd3d_descriptor_pool_cache_put(&device->descriptor_pool_cache, device, allocator->descriptor_pools[i]);
     }
-    else
+    allocator->descriptor_pool_count = 0;
+
+    if (!keep_reusable_resources)
     {
-        for (i = 0; i < allocator->free_descriptor_pool_count; ++i)
+        for (i = 0; i < allocator->transfer_buffer_count; ++i)
         {
-            VK_CALL(vkDestroyDescriptorPool(device->vk_device, allocator->free_descriptor_pools[i], NULL));
+            vkd3d_buffer_destroy(&allocator->transfer_buffers[i], device);
         }
-        allocator->free_descriptor_pool_count = 0;
-    }
-
-    for (i = 0; i < allocator->transfer_buffer_count; ++i)
-    {
-        vkd3d_buffer_destroy(&allocator->transfer_buffers[i], device);
+        allocator->transfer_buffer_count = 0;
     }
-    allocator->transfer_buffer_count = 0;
+    allocator->transfer_buffer_idx = 0;
+    allocator->transfer_buffer_offset = 0;
 
     for (i = 0; i < allocator->buffer_view_count; ++i)
     {
@@ -1575,24 +2166,6 @@ static void d3d12_command_allocator_free_resources(struct d3d12_command_allocato
         vkd3d_view_decref(allocator->views[i], device);
     }
     allocator->view_count = 0;
-
-    for (i = 0; i < allocator->descriptor_pool_count; ++i)
-    {
-        VK_CALL(vkDestroyDescriptorPool(device->vk_device, allocator->descriptor_pools[i], NULL));
-    }
-    allocator->descriptor_pool_count = 0;
-
-    for (i = 0; i < allocator->framebuffer_count; ++i)
-    {
-        VK_CALL(vkDestroyFramebuffer(device->vk_device, allocator->framebuffers[i], NULL));
-    }
-    allocator->framebuffer_count = 0;
-
-    for (i = 0; i < allocator->pass_count; ++i)
-    {
-        VK_CALL(vkDestroyRenderPass(device->vk_device, allocator->passes[i], NULL));
-    }
-    allocator->pass_count = 0;
 }
 
 /* ID3D12CommandAllocator */
@@ -1655,9 +2228,8 @@ static ULONG STDMETHODCALLTYPE d3d12_command_allocator_Release(ID3D12CommandAllo
         vkd3d_free(allocator->buffer_views);
         vkd3d_free(allocator->views);
         vkd3d_free(allocator->descriptor_pools);
-        vkd3d_free(allocator->free_descriptor_pools);
-        vkd3d_free(allocator->framebuffers);
-        vkd3d_free(allocator->passes);
+
+        vkd3d_command_stream_cleanup(&allocator->command_stream);
 
         /* All command buffers are implicitly freed when a pool is destroyed. */
         vkd3d_free(allocator->command_buffers);
@@ -1842,18 +2414,7 @@ static HRESULT d3d12_command_allocator_init(struct d3d12_command_allocator *allo
     }
 
     allocator->vk_descriptor_pool = VK_NULL_HANDLE;
-
-    allocator->free_descriptor_pools = NULL;
-    allocator->free_descriptor_pools_size = 0;
-    allocator->free_descriptor_pool_count = 0;
-
-    allocator->passes = NULL;
-    allocator->passes_size = 0;
-    allocator->pass_count = 0;
-
-    allocator->framebuffers = NULL;
-    allocator->framebuffers_size = 0;
-    allocator->framebuffer_count = 0;
+    allocator->descriptor_set_count = 0;
 
     allocator->descriptor_pools = NULL;
     allocator->descriptor_pools_size = 0;
@@ -1870,11 +2431,15 @@ static HRESULT d3d12_command_allocator_init(struct d3d12_command_allocator *allo
     allocator->transfer_buffers = NULL;
     allocator->transfer_buffers_size = 0;
     allocator->transfer_buffer_count = 0;
+    allocator->transfer_buffer_idx = 0;
+    allocator->transfer_buffer_offset = 0;
 
     allocator->command_buffers = NULL;
     allocator->command_buffers_size = 0;
     allocator->command_buffer_count = 0;
 
+    memset(&allocator->command_stream, 0, sizeof(allocator->command_stream));
+
     allocator->current_command_list = NULL;
 
     d3d12_device_add_ref(allocator->device = device);
@@ -1926,3877 +2491,6688 @@ static void d3d12_command_list_invalidate_current_pipeline(struct d3d12_command_
     list->current_pipeline = VK_NULL_HANDLE;
 }
 
-static void d3d12_command_list_end_current_render_pass(struct d3d12_command_list *list)
+static void vkd3d_barrier_batch_clear(struct vkd3d_barrier_batch *batch)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    batch->src_stage_mask = 0;
+    batch->dst_stage_mask = 0;
 
-    if (list->xfb_enabled)
-    {
-        VK_CALL(vkCmdEndTransformFeedbackEXT(list->vk_command_buffer, 0, ARRAY_SIZE(list->so_counter_buffers),
-                list->so_counter_buffers, list->so_counter_buffer_offsets));
-    }
+    batch->memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    batch->memory_barrier.pNext = NULL;
+    batch->memory_barrier.srcAccessMask = 0;
+    batch->memory_barrier.dstAccessMask = 0;
+    batch->has_memory_barrier = false;
 
-    if (list->current_render_pass)
-        VK_CALL(vkCmdEndRenderPass(list->vk_command_buffer));
+    batch->buffer_barrier_count = 0;
+    batch->image_barrier_count = 0;
+}
 
-    list->current_render_pass = VK_NULL_HANDLE;
+static void vkd3d_barrier_batch_cleanup(struct vkd3d_barrier_batch *batch)
+{
+    vkd3d_free(batch->buffer_barriers);
+    vkd3d_free(batch->image_barriers);
+}
 
-    if (list->xfb_enabled)
-    {
-        VkMemoryBarrier vk_barrier;
+static bool vk_image_subresource_ranges_overlap(const VkImageSubresourceRange *a,
+        const VkImageSubresourceRange *b)
+{
+    uint32_t a_level_end, b_level_end, a_layer_end, b_layer_end;
 
-        /* We need a barrier between pause and resume. */
-        vk_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-        vk_barrier.pNext = NULL;
-        vk_barrier.srcAccessMask = VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
-        vk_barrier.dstAccessMask = VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT;
-        VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer,
-                VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0,
-                1, &vk_barrier, 0, NULL, 0, NULL));
+    a_level_end = a->levelCount == VK_REMAINING_MIP_LEVELS ? ~0u : a->baseMipLevel + a->levelCount;
+    b_level_end = b->levelCount == VK_REMAINING_MIP_LEVELS ? ~0u : b->baseMipLevel + b->levelCount;
+    a_layer_end = a->layerCount == VK_REMAINING_ARRAY_LAYERS ? ~0u : a->baseArrayLayer + a->layerCount;
+    b_layer_end = b->layerCount == VK_REMAINING_ARRAY_LAYERS ? ~0u : b->baseArrayLayer + b->layerCount;
 
-        list->xfb_enabled = false;
-    }
+    return a->baseMipLevel < b_level_end && b->baseMipLevel < a_level_end
+            && a->baseArrayLayer < b_layer_end && b->baseArrayLayer < a_layer_end;
 }
 
-static void d3d12_command_list_invalidate_current_render_pass(struct d3d12_command_list *list)
+/* Deferred recording. Commands are appended to the allocator's command stream
+ * as variable sized records, and translated to Vulkan commands by
+ * d3d12_command_list_flush_stream(). Commands which aren't recorded into the
+ * stream flush it first, which keeps the Vulkan command order intact. */
+enum vkd3d_stream_command_type
 {
-    d3d12_command_list_end_current_render_pass(list);
-}
+    VKD3D_STREAM_COMMAND_NOP,
+    VKD3D_STREAM_COMMAND_BEGIN_RENDER_PASS,
+    VKD3D_STREAM_COMMAND_END_RENDER_PASS,
+    VKD3D_STREAM_COMMAND_PIPELINE_BARRIER,
+    VKD3D_STREAM_COMMAND_BIND_PIPELINE,
+    VKD3D_STREAM_COMMAND_BIND_DESCRIPTOR_SETS,
+    VKD3D_STREAM_COMMAND_PUSH_CONSTANTS,
+    VKD3D_STREAM_COMMAND_BIND_VERTEX_BUFFERS,
+    VKD3D_STREAM_COMMAND_BIND_INDEX_BUFFER,
+    VKD3D_STREAM_COMMAND_SET_VIEWPORT,
+    VKD3D_STREAM_COMMAND_SET_SCISSOR,
+    VKD3D_STREAM_COMMAND_DRAW,
+    VKD3D_STREAM_COMMAND_DRAW_INDEXED,
+};
 
-static void d3d12_command_list_invalidate_bindings(struct d3d12_command_list *list,
-        struct d3d12_pipeline_state *state)
+struct vkd3d_stream_command
 {
-    if (state && state->uav_counters.binding_count)
-    {
-        enum vkd3d_pipeline_bind_point bind_point = (enum vkd3d_pipeline_bind_point)state->vk_bind_point;
-        struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    enum vkd3d_stream_command_type type;
+    uint32_t size;
+};
 
-        vkd3d_array_reserve((void **)&bindings->vk_uav_counter_views, &bindings->vk_uav_counter_views_size,
-                state->uav_counters.binding_count, sizeof(*bindings->vk_uav_counter_views));
-        bindings->uav_counters_dirty = true;
-    }
-}
+struct vkd3d_stream_begin_render_pass
+{
+    struct vkd3d_stream_command command;
+    VkRenderPass vk_render_pass;
+    VkFramebuffer vk_framebuffer;
+    VkRect2D render_area;
+    uint32_t clear_value_count;
+    VkClearValue clear_values[];
+};
 
-static void d3d12_command_list_invalidate_root_parameters(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point)
+struct vkd3d_stream_pipeline_barrier
 {
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    struct vkd3d_stream_command command;
+    VkPipelineStageFlags src_stage_mask;
+    VkPipelineStageFlags dst_stage_mask;
+    uint32_t memory_barrier_count;
+    uint32_t buffer_barrier_count;
+    uint32_t image_barrier_count;
+    /* Memory, buffer and image barriers, in that order. */
+    uint64_t data[];
+};
 
-    if (!bindings->root_signature)
-        return;
+struct vkd3d_stream_bind_pipeline
+{
+    struct vkd3d_stream_command command;
+    VkPipelineBindPoint bind_point;
+    VkPipeline vk_pipeline;
+};
 
-    bindings->descriptor_set_count = 0;
-    bindings->descriptor_table_dirty_mask = bindings->descriptor_table_active_mask & bindings->root_signature->descriptor_table_mask;
-    bindings->push_descriptor_dirty_mask = bindings->push_descriptor_active_mask & bindings->root_signature->push_descriptor_mask;
-    bindings->cbv_srv_uav_heap_id = 0;
-    bindings->sampler_heap_id = 0;
-}
+struct vkd3d_stream_bind_descriptor_sets
+{
+    struct vkd3d_stream_command command;
+    VkPipelineBindPoint bind_point;
+    VkPipelineLayout vk_pipeline_layout;
+    uint32_t first_set;
+    uint32_t set_count;
+    uint32_t dynamic_offset_count;
+    /* Descriptor sets, followed by dynamic offsets. */
+    uint64_t data[];
+};
 
-static bool vk_barrier_parameters_from_d3d12_resource_state(unsigned int state, unsigned int stencil_state,
-        const struct d3d12_resource *resource, VkQueueFlags vk_queue_flags, const struct vkd3d_vulkan_info *vk_info,
-        VkAccessFlags *access_mask, VkPipelineStageFlags *stage_flags, VkImageLayout *image_layout)
+struct vkd3d_stream_push_constants
 {
-    bool is_swapchain_image = resource && (resource->flags & VKD3D_RESOURCE_PRESENT_STATE_TRANSITION);
-    VkPipelineStageFlags queue_shader_stages = 0;
+    struct vkd3d_stream_command command;
+    VkPipelineLayout vk_pipeline_layout;
+    VkShaderStageFlags stage_flags;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t values[];
+};
 
-    if (vk_queue_flags & VK_QUEUE_GRAPHICS_BIT)
-    {
-        queue_shader_stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
-                | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT
-                | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT
-                | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT
-                | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    if (vk_queue_flags & VK_QUEUE_COMPUTE_BIT)
-        queue_shader_stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+struct vkd3d_stream_bind_vertex_buffers
+{
+    struct vkd3d_stream_command command;
+    uint32_t first_binding;
+    uint32_t binding_count;
+    /* Buffers, followed by offsets. */
+    uint64_t data[];
+};
 
-    switch (state)
-    {
-        case D3D12_RESOURCE_STATE_COMMON: /* D3D12_RESOURCE_STATE_PRESENT */
-            /* The COMMON state is used for ownership transfer between
-             * DIRECT/COMPUTE and COPY queues. Additionally, a texture has to
-             * be in the COMMON state to be accessed by CPU. Moreover,
-             * resources can be implicitly promoted to other states out of the
-             * COMMON state, and the resource state can decay to the COMMON
-             * state when GPU finishes execution of a command list. */
-            if (is_swapchain_image)
-            {
-                if (resource->present_state == D3D12_RESOURCE_STATE_PRESENT)
-                {
-                    *access_mask = VK_ACCESS_MEMORY_READ_BIT;
-                    *stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-                    if (image_layout)
-                        *image_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-                    return true;
-                }
-                else if (resource->present_state != D3D12_RESOURCE_STATE_COMMON)
-                {
-                    vk_barrier_parameters_from_d3d12_resource_state(resource->present_state, 0,
-                            resource, vk_queue_flags, vk_info, access_mask, stage_flags, image_layout);
-                    return true;
-                }
-            }
+struct vkd3d_stream_bind_index_buffer
+{
+    struct vkd3d_stream_command command;
+    VkBuffer vk_buffer;
+    VkDeviceSize offset;
+    VkIndexType index_type;
+};
 
-            *access_mask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT;
-            *stage_flags = VK_PIPELINE_STAGE_HOST_BIT;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
-            return true;
+struct vkd3d_stream_set_viewport
+{
+    struct vkd3d_stream_command command;
+    uint32_t first_viewport;
+    uint32_t viewport_count;
+    VkViewport viewports[];
+};
 
-        /* Handle write states. */
-        case D3D12_RESOURCE_STATE_RENDER_TARGET:
-            *access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
-                    | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            *stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-            return true;
+struct vkd3d_stream_set_scissor
+{
+    struct vkd3d_stream_command command;
+    uint32_t first_scissor;
+    uint32_t scissor_count;
+    VkRect2D scissors[];
+};
 
-        case D3D12_RESOURCE_STATE_UNORDERED_ACCESS:
-            *access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-            *stage_flags = queue_shader_stages;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
-            return true;
+struct vkd3d_stream_draw
+{
+    struct vkd3d_stream_command command;
+    uint32_t vertex_count;
+    uint32_t instance_count;
+    uint32_t first_vertex;
+    uint32_t first_instance;
+};
 
-        case D3D12_RESOURCE_STATE_DEPTH_WRITE:
-            *access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
-                    | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            *stage_flags = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
-                    | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-            if (image_layout)
-            {
-                if (!stencil_state || (stencil_state & D3D12_RESOURCE_STATE_DEPTH_WRITE))
-                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-                else
-                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
-            }
-            return true;
+struct vkd3d_stream_draw_indexed
+{
+    struct vkd3d_stream_command command;
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t first_instance;
+};
 
-        case D3D12_RESOURCE_STATE_COPY_DEST:
-        case D3D12_RESOURCE_STATE_RESOLVE_DEST:
-            *access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            *stage_flags = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            return true;
+/* Forgets the Vulkan state known to the translation, e.g. after commands were
+ * recorded into the command buffer directly. */
+static void vkd3d_command_stream_invalidate_state(struct vkd3d_command_stream *stream)
+{
+    memset(stream->vk_pipelines, 0, sizeof(stream->vk_pipelines));
+    stream->viewport_count = 0;
+    stream->scissor_count = 0;
+    stream->vk_render_pass = VK_NULL_HANDLE;
+    stream->vk_framebuffer = VK_NULL_HANDLE;
+}
 
-        case D3D12_RESOURCE_STATE_STREAM_OUT:
-            *access_mask = VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT
-                    | VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT
-                    | VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
-            *stage_flags = VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT
-                    | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
-            return true;
+static void vkd3d_command_stream_reset_state(struct vkd3d_command_stream *stream)
+{
+    vkd3d_command_stream_invalidate_state(stream);
+    vkd3d_barrier_batch_clear(&stream->barriers);
 
-        /* Set the Vulkan image layout for read-only states. */
-        case D3D12_RESOURCE_STATE_DEPTH_READ:
-        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
-        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
-        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-                | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
-            *access_mask = 0;
-            *stage_flags = 0;
-            if (image_layout)
-            {
-                if (stencil_state & D3D12_RESOURCE_STATE_DEPTH_WRITE)
-                {
-                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL;
-                    *access_mask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-                }
-                else
-                {
-                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-                }
-            }
-            break;
+    stream->command_count = 0;
+    stream->dropped_command_count = 0;
+    stream->collect_timings = WARN_ON();
+    stream->record_time_ns = 0;
+    stream->translation_time_ns = 0;
+}
 
-        case D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
-        case D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
-        case D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
-            *access_mask = 0;
-            *stage_flags = 0;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            break;
+static void vkd3d_command_stream_cleanup(struct vkd3d_command_stream *stream)
+{
+    vkd3d_barrier_batch_cleanup(&stream->barriers);
+    vkd3d_free(stream->data);
+}
 
-        case D3D12_RESOURCE_STATE_COPY_SOURCE:
-        case D3D12_RESOURCE_STATE_RESOLVE_SOURCE:
-            *access_mask = 0;
-            *stage_flags = 0;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            break;
+static void vkd3d_command_stream_flush_barriers(struct vkd3d_command_stream *stream,
+        const struct vkd3d_vk_device_procs *vk_procs, VkCommandBuffer vk_command_buffer)
+{
+    struct vkd3d_barrier_batch *batch = &stream->barriers;
 
-        default:
-            *access_mask = 0;
-            *stage_flags = 0;
-            if (image_layout)
-                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
-            break;
-    }
+    /* Execution dependencies without memory barriers are valid too. */
+    if (!batch->src_stage_mask)
+        return;
 
-    /* Handle read-only states. */
-    assert(!is_write_resource_state(state));
+    VK_CALL(vkCmdPipelineBarrier(vk_command_buffer, batch->src_stage_mask, batch->dst_stage_mask, 0,
+            batch->has_memory_barrier ? 1 : 0, &batch->memory_barrier,
+            batch->buffer_barrier_count, batch->buffer_barriers,
+            batch->image_barrier_count, batch->image_barriers));
 
-    if (state & D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)
-    {
-        *access_mask |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
-                | VK_ACCESS_UNIFORM_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
-                | queue_shader_stages;
-        state &= ~D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
-    }
+    vkd3d_barrier_batch_clear(batch);
+}
 
-    if (state & D3D12_RESOURCE_STATE_INDEX_BUFFER)
-    {
-        *access_mask |= VK_ACCESS_INDEX_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
-        state &= ~D3D12_RESOURCE_STATE_INDEX_BUFFER;
-    }
+/* Adjacent pipeline barriers are merged only if they are independent. Merging
+ * widens the stage masks of every barrier in the batch, which is always
+ * valid, but global memory barriers may form a memory dependency chain with a
+ * preceding barrier, and barriers within a single vkCmdPipelineBarrier() are
+ * unordered. */
+static bool vkd3d_barrier_batch_merge(struct vkd3d_barrier_batch *batch,
+        const struct vkd3d_stream_pipeline_barrier *barrier)
+{
+    const VkBufferMemoryBarrier *buffer_barriers;
+    const VkImageMemoryBarrier *image_barriers;
+    const VkMemoryBarrier *memory_barriers;
+    bool batch_has_resource_barriers;
+    size_t i, j;
 
-    if (state & D3D12_RESOURCE_STATE_DEPTH_READ)
-    {
-        *access_mask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
-                | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-        state &= ~D3D12_RESOURCE_STATE_DEPTH_READ;
-    }
+    memory_barriers = (const VkMemoryBarrier *)barrier->data;
+    buffer_barriers = (const VkBufferMemoryBarrier *)&memory_barriers[barrier->memory_barrier_count];
+    image_barriers = (const VkImageMemoryBarrier *)&buffer_barriers[barrier->buffer_barrier_count];
 
-    if (state & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
-    {
-        *access_mask |= VK_ACCESS_SHADER_READ_BIT;
-        *stage_flags |= (queue_shader_stages & ~VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-        state &= ~D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-    }
-    if (state & D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
+    batch_has_resource_barriers = batch->buffer_barrier_count || batch->image_barrier_count;
+    if (batch->src_stage_mask)
     {
-        *access_mask |= VK_ACCESS_SHADER_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        state &= ~D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        if (barrier->memory_barrier_count && (batch_has_resource_barriers
+                || barrier->buffer_barrier_count || barrier->image_barrier_count))
+            return false;
+        if (batch->has_memory_barrier && (barrier->buffer_barrier_count || barrier->image_barrier_count))
+            return false;
+        if (!barrier->memory_barrier_count && !barrier->buffer_barrier_count && !barrier->image_barrier_count)
+            return false;
     }
 
-    if (state & D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT) /* D3D12_RESOURCE_STATE_PREDICATION */
+    for (i = 0; i < barrier->buffer_barrier_count; ++i)
     {
-        *access_mask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-        if (vk_info->EXT_conditional_rendering)
+        for (j = 0; j < batch->buffer_barrier_count; ++j)
         {
-            *access_mask |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
-            *stage_flags |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
+            if (batch->buffer_barriers[j].buffer == buffer_barriers[i].buffer)
+                return false;
         }
-        state &= ~D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
     }
 
-    if (state & (D3D12_RESOURCE_STATE_COPY_SOURCE | D3D12_RESOURCE_STATE_RESOLVE_SOURCE))
+    for (i = 0; i < barrier->image_barrier_count; ++i)
     {
-        *access_mask |= VK_ACCESS_TRANSFER_READ_BIT;
-        *stage_flags |= VK_PIPELINE_STAGE_TRANSFER_BIT;
-        state &= ~(D3D12_RESOURCE_STATE_COPY_SOURCE | D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+        for (j = 0; j < batch->image_barrier_count; ++j)
+        {
+            if (batch->image_barriers[j].image == image_barriers[i].image
+                    && vk_image_subresource_ranges_overlap(&batch->image_barriers[j].subresourceRange,
+                    &image_barriers[i].subresourceRange))
+                return false;
+        }
     }
 
-    if (state)
-    {
-        WARN("Invalid resource state %#x.\n", state);
+    if (!vkd3d_array_reserve((void **)&batch->buffer_barriers, &batch->buffer_barriers_size,
+            batch->buffer_barrier_count + barrier->buffer_barrier_count, sizeof(*batch->buffer_barriers))
+            || !vkd3d_array_reserve((void **)&batch->image_barriers, &batch->image_barriers_size,
+            batch->image_barrier_count + barrier->image_barrier_count, sizeof(*batch->image_barriers)))
         return false;
+
+    for (i = 0; i < barrier->memory_barrier_count; ++i)
+    {
+        batch->memory_barrier.srcAccessMask |= memory_barriers[i].srcAccessMask;
+        batch->memory_barrier.dstAccessMask |= memory_barriers[i].dstAccessMask;
+        batch->has_memory_barrier = true;
     }
+    memcpy(&batch->buffer_barriers[batch->buffer_barrier_count], buffer_barriers,
+            barrier->buffer_barrier_count * sizeof(*buffer_barriers));
+    batch->buffer_barrier_count += barrier->buffer_barrier_count;
+    memcpy(&batch->image_barriers[batch->image_barrier_count], image_barriers,
+            barrier->image_barrier_count * sizeof(*image_barriers));
+    batch->image_barrier_count += barrier->image_barrier_count;
+
+    batch->src_stage_mask |= barrier->src_stage_mask;
+    batch->dst_stage_mask |= barrier->dst_stage_mask;
+
     return true;
 }
 
-static void d3d12_command_list_transition_resource_to_initial_state(struct d3d12_command_list *list,
-        struct d3d12_resource *resource)
+/* Returns the begin command of a render pass which resumes the current render
+ * pass, i.e. begins the same render pass on the same framebuffer without
+ * clearing attachments, with only state commands in between. */
+static struct vkd3d_stream_begin_render_pass *vkd3d_command_stream_find_render_pass_resume(
+        struct vkd3d_command_stream *stream, size_t offset)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
-    VkPipelineStageFlags src_stage_mask, dst_stage_mask;
-    VkImageMemoryBarrier barrier;
-
-    assert(d3d12_resource_is_texture(resource));
-
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.pNext = NULL;
+    struct vkd3d_stream_begin_render_pass *begin;
+    const struct vkd3d_stream_command *command;
 
-    /* vkQueueSubmit() defines a memory dependency with prior host writes. */
-    src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    barrier.srcAccessMask = 0;
-    barrier.oldLayout = d3d12_resource_is_cpu_accessible(resource) ?
-            VK_IMAGE_LAYOUT_PREINITIALIZED : VK_IMAGE_LAYOUT_UNDEFINED;
+    if (!stream->vk_render_pass)
+        return NULL;
 
-    if (!vk_barrier_parameters_from_d3d12_resource_state(resource->initial_state, 0,
-            resource, list->vk_queue_flags, vk_info, &barrier.dstAccessMask, &dst_stage_mask, &barrier.newLayout))
+    for (; offset < stream->size; offset += command->size)
     {
-        FIXME("Unhandled state %#x.\n", resource->initial_state);
-        return;
-    }
+        command = (const struct vkd3d_stream_command *)&stream->data[offset];
 
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = resource->u.vk_image;
-    barrier.subresourceRange.aspectMask = resource->format->vk_aspect_mask;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        switch (command->type)
+        {
+            case VKD3D_STREAM_COMMAND_NOP:
+            case VKD3D_STREAM_COMMAND_BIND_PIPELINE:
+            case VKD3D_STREAM_COMMAND_BIND_DESCRIPTOR_SETS:
+            case VKD3D_STREAM_COMMAND_PUSH_CONSTANTS:
+            case VKD3D_STREAM_COMMAND_BIND_VERTEX_BUFFERS:
+            case VKD3D_STREAM_COMMAND_BIND_INDEX_BUFFER:
+            case VKD3D_STREAM_COMMAND_SET_VIEWPORT:
+            case VKD3D_STREAM_COMMAND_SET_SCISSOR:
+                break;
 
-    TRACE("Initial state %#x transition for resource %p (old layout %#x, new layout %#x).\n",
-            resource->initial_state, resource, barrier.oldLayout, barrier.newLayout);
+            case VKD3D_STREAM_COMMAND_BEGIN_RENDER_PASS:
+                begin = (struct vkd3d_stream_begin_render_pass *)command;
+                if (begin->vk_render_pass == stream->vk_render_pass
+                        && begin->vk_framebuffer == stream->vk_framebuffer
+                        && !memcmp(&begin->render_area, &stream->render_area, sizeof(begin->render_area))
+                        && !begin->clear_value_count)
+                    return begin;
+                return NULL;
 
-    VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer, src_stage_mask, dst_stage_mask, 0,
-            0, NULL, 0, NULL, 1, &barrier));
+            default:
+                return NULL;
+        }
+    }
+
+    return NULL;
 }
 
-static void d3d12_command_list_track_resource_usage(struct d3d12_command_list *list,
-        struct d3d12_resource *resource)
+static void d3d12_command_list_flush_stream(struct d3d12_command_list *list)
 {
-    if (resource->flags & VKD3D_RESOURCE_INITIAL_STATE_TRANSITION)
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct vkd3d_stream_bind_descriptor_sets *descriptor_sets;
+    const struct vkd3d_stream_bind_vertex_buffers *vertex_buffers;
+    const struct vkd3d_stream_bind_index_buffer *index_buffer;
+    const struct vkd3d_stream_push_constants *push_constants;
+    const struct vkd3d_stream_pipeline_barrier *barrier;
+    const struct vkd3d_stream_bind_pipeline *pipeline;
+    const struct vkd3d_stream_draw_indexed *draw_indexed;
+    const struct vkd3d_stream_set_viewport *viewport;
+    const struct vkd3d_stream_set_scissor *scissor;
+    struct vkd3d_stream_begin_render_pass *begin;
+    VkCommandBuffer vk_command_buffer = list->vk_command_buffer;
+    const VkBufferMemoryBarrier *buffer_barriers;
+    const VkImageMemoryBarrier *image_barriers;
+    const struct vkd3d_stream_draw *draw;
+    struct vkd3d_stream_command *command;
+    VkRenderPassBeginInfo begin_desc;
+    struct vkd3d_command_stream *stream;
+    const VkMemoryBarrier *memory_barriers;
+    uint64_t start_time = 0;
+    unsigned int index;
+    size_t offset;
+
+    if (!list->allocator || !list->allocator->command_stream.size)
+        return;
+    stream = &list->allocator->command_stream;
+
+    if (stream->collect_timings)
+        start_time = vkd3d_get_monotonic_time_ns();
+
+    for (offset = 0; offset < stream->size; offset += command->size)
     {
-        d3d12_command_list_end_current_render_pass(list);
+        command = (struct vkd3d_stream_command *)&stream->data[offset];
 
-        d3d12_command_list_transition_resource_to_initial_state(list, resource);
-        resource->flags &= ~VKD3D_RESOURCE_INITIAL_STATE_TRANSITION;
+        if (command->type == VKD3D_STREAM_COMMAND_PIPELINE_BARRIER)
+        {
+            barrier = (const struct vkd3d_stream_pipeline_barrier *)command;
+            if (stream->barriers.src_stage_mask && vkd3d_barrier_batch_merge(&stream->barriers, barrier))
+            {
+                ++stream->dropped_command_count;
+                continue;
+            }
+
+            vkd3d_command_stream_flush_barriers(stream, vk_procs, vk_command_buffer);
+            if (!vkd3d_barrier_batch_merge(&stream->barriers, barrier))
+            {
+                memory_barriers = (const VkMemoryBarrier *)barrier->data;
+                buffer_barriers = (const VkBufferMemoryBarrier *)&memory_barriers[barrier->memory_barrier_count];
+                image_barriers = (const VkImageMemoryBarrier *)&buffer_barriers[barrier->buffer_barrier_count];
+                VK_CALL(vkCmdPipelineBarrier(vk_command_buffer, barrier->src_stage_mask, barrier->dst_stage_mask, 0,
+                        barrier->memory_barrier_count, memory_barriers, barrier->buffer_barrier_count, buffer_barriers,
+                        barrier->image_barrier_count, image_barriers));
+            }
+            continue;
+        }
+
+        if (command->type != VKD3D_STREAM_COMMAND_NOP)
+            vkd3d_command_stream_flush_barriers(stream, vk_procs, vk_command_buffer);
+
+        switch (command->type)
+        {
+            case VKD3D_STREAM_COMMAND_NOP:
+                break;
+
+            case VKD3D_STREAM_COMMAND_BEGIN_RENDER_PASS:
+                begin = (struct vkd3d_stream_begin_render_pass *)command;
+                begin_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                begin_desc.pNext = NULL;
+                begin_desc.renderPass = begin->vk_render_pass;
+                begin_desc.framebuffer = begin->vk_framebuffer;
+                begin_desc.renderArea = begin->render_area;
+                begin_desc.clearValueCount = begin->clear_value_count;
+                begin_desc.pClearValues = begin->clear_values;
+                VK_CALL(vkCmdBeginRenderPass(vk_command_buffer, &begin_desc, VK_SUBPASS_CONTENTS_INLINE));
+                stream->vk_render_pass = begin->vk_render_pass;
+                stream->vk_framebuffer = begin->vk_framebuffer;
+                stream->render_area = begin->render_area;
+                break;
+
+            case VKD3D_STREAM_COMMAND_END_RENDER_PASS:
+                if ((begin = vkd3d_command_stream_find_render_pass_resume(stream, offset + command->size)))
+                {
+                    begin->command.type = VKD3D_STREAM_COMMAND_NOP;
+                    stream->dropped_command_count += 2;
+                    break;
+                }
+                VK_CALL(vkCmdEndRenderPass(vk_command_buffer));
+                stream->vk_render_pass = VK_NULL_HANDLE;
+                stream->vk_framebuffer = VK_NULL_HANDLE;
+                break;
+
+            case VKD3D_STREAM_COMMAND_BIND_PIPELINE:
+                pipeline = (const struct vkd3d_stream_bind_pipeline *)command;
+                index = pipeline->bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0;
+                if (stream->vk_pipelines[index] == pipeline->vk_pipeline)
+                {
+                    ++stream->dropped_command_count;
+                    break;
+                }
+                VK_CALL(vkCmdBindPipeline(vk_command_buffer, pipeline->bind_point, pipeline->vk_pipeline));
+                stream->vk_pipelines[index] = pipeline->vk_pipeline;
+                break;
+
+            case VKD3D_STREAM_COMMAND_BIND_DESCRIPTOR_SETS:
+                descriptor_sets = (const struct vkd3d_stream_bind_descriptor_sets *)command;
+                VK_CALL(vkCmdBindDescriptorSets(vk_command_buffer, descriptor_sets->bind_point,
+                        descriptor_sets->vk_pipeline_layout, descriptor_sets->first_set, descriptor_sets->set_count,
+                        (const VkDescriptorSet *)descriptor_sets->data, descriptor_sets->dynamic_offset_count,
+                        (const uint32_t *)&descriptor_sets->data[descriptor_sets->set_count]));
+                break;
+
+            case VKD3D_STREAM_COMMAND_PUSH_CONSTANTS:
+                push_constants = (const struct vkd3d_stream_push_constants *)command;
+                VK_CALL(vkCmdPushConstants(vk_command_buffer, push_constants->vk_pipeline_layout,
+                        push_constants->stage_flags, push_constants->offset, push_constants->size,
+                        push_constants->values));
+                break;
+
+            case VKD3D_STREAM_COMMAND_BIND_VERTEX_BUFFERS:
+                vertex_buffers = (const struct vkd3d_stream_bind_vertex_buffers *)command;
+                VK_CALL(vkCmdBindVertexBuffers(vk_command_buffer, vertex_buffers->first_binding,
+                        vertex_buffers->binding_count, (const VkBuffer *)vertex_buffers->data,
+                        (const VkDeviceSize *)&vertex_buffers->data[vertex_buffers->binding_count]));
+                break;
+
+            case VKD3D_STREAM_COMMAND_BIND_INDEX_BUFFER:
+                index_buffer = (const struct vkd3d_stream_bind_index_buffer *)command;
+                VK_CALL(vkCmdBindIndexBuffer(vk_command_buffer, index_buffer->vk_buffer,
+                        index_buffer->offset, index_buffer->index_type));
+                break;
+
+            case VKD3D_STREAM_COMMAND_SET_VIEWPORT:
+                viewport = (const struct vkd3d_stream_set_viewport *)command;
+                if (!viewport->first_viewport && viewport->viewport_count == stream->viewport_count
+                        && !memcmp(viewport->viewports, stream->viewports,
+                        viewport->viewport_count * sizeof(*viewport->viewports)))
+                {
+                    ++stream->dropped_command_count;
+                    break;
+                }
+                VK_CALL(vkCmdSetViewport(vk_command_buffer, viewport->first_viewport,
+                        viewport->viewport_count, viewport->viewports));
+                if (!viewport->first_viewport && viewport->viewport_count <= ARRAY_SIZE(stream->viewports))
+                {
+                    memcpy(stream->viewports, viewport->viewports,
+                            viewport->viewport_count * sizeof(*viewport->viewports));
+                    stream->viewport_count = viewport->viewport_count;
+                }
+                else
+                {
+                    stream->viewport_count = 0;
+                }
+                break;
+
+            case VKD3D_STREAM_COMMAND_SET_SCISSOR:
+                scissor = (const struct vkd3d_stream_set_scissor *)command;
+                if (!scissor->first_scissor && scissor->scissor_count == stream->scissor_count
+                        && !memcmp(scissor->scissors, stream->scissors,
+                        scissor->scissor_count * sizeof(*scissor->scissors)))
+                {
+                    ++stream->dropped_command_count;
+                    break;
+                }
+                VK_CALL(vkCmdSetScissor(vk_command_buffer, scissor->first_scissor,
+                        scissor->scissor_count, scissor->scissors));
+                if (!scissor->first_scissor && scissor->scissor_count <= ARRAY_SIZE(stream->scissors))
+                {
+                    memcpy(stream->scissors, scissor->scissors, scissor->scissor_count * sizeof(*scissor->scissors));
+                    stream->scissor_count = scissor->scissor_count;
+                }
+                else
+                {
+                    stream->scissor_count = 0;
+                }
+                break;
+
+            case VKD3D_STREAM_COMMAND_DRAW:
+                draw = (const struct vkd3d_stream_draw *)command;
+                VK_CALL(vkCmdDraw(vk_command_buffer, draw->vertex_count, draw->instance_count,
+                        draw->first_vertex, draw->first_instance));
+                break;
+
+            case VKD3D_STREAM_COMMAND_DRAW_INDEXED:
+                draw_indexed = (const struct vkd3d_stream_draw_indexed *)command;
+                VK_CALL(vkCmdDrawIndexed(vk_command_buffer, draw_indexed->index_count, draw_indexed->instance_count,
+                        draw_indexed->first_index, draw_indexed->vertex_offset, draw_indexed->first_instance));
+                break;
+
+            default:
+                ERR("Invalid stream command type %#x.\n", command->type);
+                break;
+        }
     }
+
+    vkd3d_command_stream_flush_barriers(stream, vk_procs, vk_command_buffer);
+    stream->size = 0;
+
+    if (stream->collect_timings)
+        stream->translation_time_ns += vkd3d_get_monotonic_time_ns() - start_time;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_QueryInterface(ID3D12GraphicsCommandList2 *iface,
-        REFIID iid, void **object)
+struct vkd3d_record_timer
 {
-    TRACE("iface %p, iid %s, object %p.\n", iface, debugstr_guid(iid), object);
+    uint64_t start_time;
+    uint64_t translation_time_ns;
+};
 
-    if (IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList2)
-            || IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList1)
-            || IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList)
-            || IsEqualGUID(iid, &IID_ID3D12CommandList)
-            || IsEqualGUID(iid, &IID_ID3D12DeviceChild)
-            || IsEqualGUID(iid, &IID_ID3D12Object)
-            || IsEqualGUID(iid, &IID_IUnknown))
-    {
-        ID3D12GraphicsCommandList2_AddRef(iface);
-        *object = iface;
-        return S_OK;
-    }
+/* Times recording into the command stream. Translation triggered in between
+ * is counted separately. */
+static void d3d12_command_list_begin_record_timing(const struct d3d12_command_list *list,
+        struct vkd3d_record_timer *timer)
+{
+    const struct vkd3d_command_stream *stream;
 
-    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
+    timer->start_time = 0;
+    if (!list->is_deferred || !list->allocator || !list->allocator->command_stream.collect_timings)
+        return;
+    stream = &list->allocator->command_stream;
 
-    *object = NULL;
-    return E_NOINTERFACE;
+    timer->start_time = vkd3d_get_monotonic_time_ns();
+    timer->translation_time_ns = stream->translation_time_ns;
 }
 
-static ULONG STDMETHODCALLTYPE d3d12_command_list_AddRef(ID3D12GraphicsCommandList2 *iface)
+static void d3d12_command_list_end_record_timing(struct d3d12_command_list *list,
+        const struct vkd3d_record_timer *timer)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    ULONG refcount = InterlockedIncrement(&list->refcount);
+    struct vkd3d_command_stream *stream;
 
-    TRACE("%p increasing refcount to %u.\n", list, refcount);
+    if (!timer->start_time || !list->allocator)
+        return;
+    stream = &list->allocator->command_stream;
 
-    return refcount;
+    stream->record_time_ns += vkd3d_get_monotonic_time_ns() - timer->start_time
+            - (stream->translation_time_ns - timer->translation_time_ns);
 }
 
-static void vkd3d_pipeline_bindings_cleanup(struct vkd3d_pipeline_bindings *bindings)
+/* Returns the Vulkan command buffer for recording commands directly, after
+ * translating deferred commands. */
+static VkCommandBuffer d3d12_command_list_get_vk_command_buffer(struct d3d12_command_list *list)
 {
-    vkd3d_free(bindings->vk_uav_counter_views);
+    d3d12_command_list_flush_stream(list);
+    return list->vk_command_buffer;
 }
 
-static ULONG STDMETHODCALLTYPE d3d12_command_list_Release(ID3D12GraphicsCommandList2 *iface)
+/* Returns NULL if the command should be recorded directly. */
+static void *d3d12_command_list_alloc_stream_command(struct d3d12_command_list *list,
+        enum vkd3d_stream_command_type type, size_t size)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    ULONG refcount = InterlockedDecrement(&list->refcount);
+    struct vkd3d_command_stream *stream;
+    struct vkd3d_stream_command *command;
 
-    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+    if (!list->is_deferred || !list->allocator)
+        return NULL;
+    stream = &list->allocator->command_stream;
 
-    if (!refcount)
+    size = align(size, sizeof(uint64_t));
+    if (!vkd3d_array_reserve((void **)&stream->data, &stream->data_size, stream->size + size, 1))
     {
-        struct d3d12_device *device = list->device;
-
-        vkd3d_private_store_destroy(&list->private_store);
+        ERR("Failed to allocate stream command.\n");
+        d3d12_command_list_flush_stream(list);
+        vkd3d_command_stream_invalidate_state(stream);
+        return NULL;
+    }
 
-        /* When command pool is destroyed, all command buffers are implicitly freed. */
-        if (list->allocator)
-            d3d12_command_allocator_free_command_buffer(list->allocator, list);
+    command = (struct vkd3d_stream_command *)&stream->data[stream->size];
+    command->type = type;
+    command->size = size;
+    stream->size += size;
+    ++stream->command_count;
 
-        vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE]);
-        vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS]);
+    return command;
+}
 
-        vkd3d_free(list);
+static void d3d12_command_list_cmd_begin_render_pass(struct d3d12_command_list *list,
+        const VkRenderPassBeginInfo *begin_desc)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_begin_render_pass *command;
 
-        d3d12_device_release(device);
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_BEGIN_RENDER_PASS,
+            offsetof(struct vkd3d_stream_begin_render_pass, clear_values[begin_desc->clearValueCount]))))
+    {
+        command->vk_render_pass = begin_desc->renderPass;
+        command->vk_framebuffer = begin_desc->framebuffer;
+        command->render_area = begin_desc->renderArea;
+        command->clear_value_count = begin_desc->clearValueCount;
+        memcpy(command->clear_values, begin_desc->pClearValues,
+                begin_desc->clearValueCount * sizeof(*begin_desc->pClearValues));
+        return;
     }
 
-    return refcount;
+    VK_CALL(vkCmdBeginRenderPass(list->vk_command_buffer, begin_desc, VK_SUBPASS_CONTENTS_INLINE));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_GetPrivateData(ID3D12GraphicsCommandList2 *iface,
-        REFGUID guid, UINT *data_size, void *data)
+static void d3d12_command_list_cmd_end_render_pass(struct d3d12_command_list *list)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
 
-    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+    if (d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_END_RENDER_PASS,
+            sizeof(struct vkd3d_stream_command)))
+        return;
 
-    return vkd3d_get_private_data(&list->private_store, guid, data_size, data);
+    VK_CALL(vkCmdEndRenderPass(list->vk_command_buffer));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetPrivateData(ID3D12GraphicsCommandList2 *iface,
-        REFGUID guid, UINT data_size, const void *data)
+static void d3d12_command_list_cmd_pipeline_barrier(struct d3d12_command_list *list,
+        VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
+        uint32_t memory_barrier_count, const VkMemoryBarrier *memory_barriers,
+        uint32_t buffer_barrier_count, const VkBufferMemoryBarrier *buffer_barriers,
+        uint32_t image_barrier_count, const VkImageMemoryBarrier *image_barriers)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-
-    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_pipeline_barrier *command;
+    size_t size;
+    uint8_t *ptr;
+
+    size = offsetof(struct vkd3d_stream_pipeline_barrier, data)
+            + memory_barrier_count * sizeof(*memory_barriers)
+            + buffer_barrier_count * sizeof(*buffer_barriers)
+            + image_barrier_count * sizeof(*image_barriers);
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_PIPELINE_BARRIER, size)))
+    {
+        command->src_stage_mask = src_stage_mask;
+        command->dst_stage_mask = dst_stage_mask;
+        command->memory_barrier_count = memory_barrier_count;
+        command->buffer_barrier_count = buffer_barrier_count;
+        command->image_barrier_count = image_barrier_count;
+
+        ptr = (uint8_t *)command->data;
+        memcpy(ptr, memory_barriers, memory_barrier_count * sizeof(*memory_barriers));
+        ptr += memory_barrier_count * sizeof(*memory_barriers);
+        memcpy(ptr, buffer_barriers, buffer_barrier_count * sizeof(*buffer_barriers));
+        ptr += buffer_barrier_count * sizeof(*buffer_barriers);
+        memcpy(ptr, image_barriers, image_barrier_count * sizeof(*image_barriers));
+        return;
+    }
 
-    return vkd3d_set_private_data(&list->private_store, guid, data_size, data);
+    VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer, src_stage_mask, dst_stage_mask, 0,
+            memory_barrier_count, memory_barriers, buffer_barrier_count, buffer_barriers,
+            image_barrier_count, image_barriers));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetPrivateDataInterface(ID3D12GraphicsCommandList2 *iface,
-        REFGUID guid, const IUnknown *data)
+static void d3d12_command_list_cmd_bind_pipeline(struct d3d12_command_list *list,
+        VkPipelineBindPoint bind_point, VkPipeline vk_pipeline)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_bind_pipeline *command;
 
-    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_BIND_PIPELINE,
+            sizeof(*command))))
+    {
+        command->bind_point = bind_point;
+        command->vk_pipeline = vk_pipeline;
+        return;
+    }
 
-    return vkd3d_set_private_data_interface(&list->private_store, guid, data);
+    VK_CALL(vkCmdBindPipeline(list->vk_command_buffer, bind_point, vk_pipeline));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetName(ID3D12GraphicsCommandList2 *iface, const WCHAR *name)
+static void d3d12_command_list_cmd_bind_descriptor_sets(struct d3d12_command_list *list,
+        VkPipelineBindPoint bind_point, VkPipelineLayout vk_pipeline_layout, uint32_t first_set,
+        uint32_t set_count, const VkDescriptorSet *sets, uint32_t dynamic_offset_count, const uint32_t *dynamic_offsets)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-
-    TRACE("iface %p, name %s.\n", iface, debugstr_w(name, list->device->wchar_size));
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_bind_descriptor_sets *command;
+
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_BIND_DESCRIPTOR_SETS,
+            offsetof(struct vkd3d_stream_bind_descriptor_sets, data[set_count])
+            + dynamic_offset_count * sizeof(*dynamic_offsets))))
+    {
+        command->bind_point = bind_point;
+        command->vk_pipeline_layout = vk_pipeline_layout;
+        command->first_set = first_set;
+        command->set_count = set_count;
+        command->dynamic_offset_count = dynamic_offset_count;
+        memcpy(command->data, sets, set_count * sizeof(*sets));
+        memcpy(&command->data[set_count], dynamic_offsets, dynamic_offset_count * sizeof(*dynamic_offsets));
+        return;
+    }
 
-    return name ? S_OK : E_INVALIDARG;
+    VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, bind_point, vk_pipeline_layout,
+            first_set, set_count, sets, dynamic_offset_count, dynamic_offsets));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_GetDevice(ID3D12GraphicsCommandList2 *iface, REFIID iid, void **device)
+static void d3d12_command_list_cmd_push_constants(struct d3d12_command_list *list,
+        VkPipelineLayout vk_pipeline_layout, VkShaderStageFlags stage_flags,
+        uint32_t offset, uint32_t size, const void *values)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_push_constants *command;
 
-    TRACE("iface %p, iid %s, device %p.\n", iface, debugstr_guid(iid), device);
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_PUSH_CONSTANTS,
+            offsetof(struct vkd3d_stream_push_constants, values) + size)))
+    {
+        command->vk_pipeline_layout = vk_pipeline_layout;
+        command->stage_flags = stage_flags;
+        command->offset = offset;
+        command->size = size;
+        memcpy(command->values, values, size);
+        return;
+    }
 
-    return d3d12_device_query_interface(list->device, iid, device);
+    VK_CALL(vkCmdPushConstants(list->vk_command_buffer, vk_pipeline_layout, stage_flags, offset, size, values));
 }
 
-static D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE d3d12_command_list_GetType(ID3D12GraphicsCommandList2 *iface)
+static void d3d12_command_list_cmd_bind_vertex_buffers(struct d3d12_command_list *list,
+        uint32_t first_binding, uint32_t binding_count, const VkBuffer *buffers, const VkDeviceSize *offsets)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_bind_vertex_buffers *command;
 
-    TRACE("iface %p.\n", iface);
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_BIND_VERTEX_BUFFERS,
+            offsetof(struct vkd3d_stream_bind_vertex_buffers, data[2 * binding_count]))))
+    {
+        command->first_binding = first_binding;
+        command->binding_count = binding_count;
+        memcpy(command->data, buffers, binding_count * sizeof(*buffers));
+        memcpy(&command->data[binding_count], offsets, binding_count * sizeof(*offsets));
+        return;
+    }
 
-    return list->type;
+    VK_CALL(vkCmdBindVertexBuffers(list->vk_command_buffer, first_binding, binding_count, buffers, offsets));
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_Close(ID3D12GraphicsCommandList2 *iface)
+static void d3d12_command_list_cmd_bind_index_buffer(struct d3d12_command_list *list,
+        VkBuffer vk_buffer, VkDeviceSize offset, VkIndexType index_type)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkResult vr;
-
-    TRACE("iface %p.\n", iface);
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_bind_index_buffer *command;
 
-    if (!list->is_recording)
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_BIND_INDEX_BUFFER,
+            sizeof(*command))))
     {
-        WARN("Command list is not in the recording state.\n");
-        return E_FAIL;
+        command->vk_buffer = vk_buffer;
+        command->offset = offset;
+        command->index_type = index_type;
+        return;
     }
 
-    vk_procs = &list->device->vk_procs;
+    VK_CALL(vkCmdBindIndexBuffer(list->vk_command_buffer, vk_buffer, offset, index_type));
+}
 
-    d3d12_command_list_end_current_render_pass(list);
-    if (list->is_predicated)
-        VK_CALL(vkCmdEndConditionalRenderingEXT(list->vk_command_buffer));
+static void d3d12_command_list_cmd_set_viewport(struct d3d12_command_list *list,
+        uint32_t first_viewport, uint32_t viewport_count, const VkViewport *viewports)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_set_viewport *command;
 
-    if ((vr = VK_CALL(vkEndCommandBuffer(list->vk_command_buffer))) < 0)
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_SET_VIEWPORT,
+            offsetof(struct vkd3d_stream_set_viewport, viewports[viewport_count]))))
     {
-        WARN("Failed to end command buffer, vr %d.\n", vr);
-        return hresult_from_vk_result(vr);
+        command->first_viewport = first_viewport;
+        command->viewport_count = viewport_count;
+        memcpy(command->viewports, viewports, viewport_count * sizeof(*viewports));
+        return;
     }
 
-    if (list->allocator)
+    VK_CALL(vkCmdSetViewport(list->vk_command_buffer, first_viewport, viewport_count, viewports));
+}
+
+static void d3d12_command_list_cmd_set_scissor(struct d3d12_command_list *list,
+        uint32_t first_scissor, uint32_t scissor_count, const VkRect2D *scissors)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_set_scissor *command;
+
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_SET_SCISSOR,
+            offsetof(struct vkd3d_stream_set_scissor, scissors[scissor_count]))))
     {
-        d3d12_command_allocator_free_command_buffer(list->allocator, list);
-        list->allocator = NULL;
+        command->first_scissor = first_scissor;
+        command->scissor_count = scissor_count;
+        memcpy(command->scissors, scissors, scissor_count * sizeof(*scissors));
+        return;
     }
 
-    list->is_recording = false;
+    VK_CALL(vkCmdSetScissor(list->vk_command_buffer, first_scissor, scissor_count, scissors));
+}
 
-    if (!list->is_valid)
+static void d3d12_command_list_cmd_draw(struct d3d12_command_list *list, uint32_t vertex_count,
+        uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_draw *command;
+
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_DRAW, sizeof(*command))))
     {
-        WARN("Error occurred during command list recording.\n");
-        return E_INVALIDARG;
+        command->vertex_count = vertex_count;
+        command->instance_count = instance_count;
+        command->first_vertex = first_vertex;
+        command->first_instance = first_instance;
+        return;
     }
 
-    return S_OK;
+    VK_CALL(vkCmdDraw(list->vk_command_buffer, vertex_count, instance_count, first_vertex, first_instance));
 }
 
-static void d3d12_command_list_reset_state(struct d3d12_command_list *list,
-        ID3D12PipelineState *initial_pipeline_state)
+static void d3d12_command_list_cmd_draw_indexed(struct d3d12_command_list *list, uint32_t index_count,
+        uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-    ID3D12GraphicsCommandList2 *iface = &list->ID3D12GraphicsCommandList2_iface;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct vkd3d_stream_draw_indexed *command;
 
-    memset(list->strides, 0, sizeof(list->strides));
-    list->primitive_topology = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+    if ((command = d3d12_command_list_alloc_stream_command(list, VKD3D_STREAM_COMMAND_DRAW_INDEXED,
+            sizeof(*command))))
+    {
+        command->index_count = index_count;
+        command->instance_count = instance_count;
+        command->first_index = first_index;
+        command->vertex_offset = vertex_offset;
+        command->first_instance = first_instance;
+        return;
+    }
 
-    list->index_buffer_format = DXGI_FORMAT_UNKNOWN;
+    VK_CALL(vkCmdDrawIndexed(list->vk_command_buffer, index_count, instance_count,
+            first_index, vertex_offset, first_instance));
+}
 
-    memset(list->rtvs, 0, sizeof(list->rtvs));
-    list->dsv = VK_NULL_HANDLE;
-    list->dsv_format = VK_FORMAT_UNDEFINED;
-    list->fb_width = 0;
-    list->fb_height = 0;
-    list->fb_layer_count = 0;
+static void d3d12_command_list_flush_barriers(struct d3d12_command_list *list)
+{
+    struct vkd3d_barrier_batch *batch = &list->barriers;
 
-    list->xfb_enabled = false;
+    if (!batch->has_memory_barrier && !batch->buffer_barrier_count && !batch->image_barrier_count)
+        return;
 
-    list->is_predicated = false;
+    TRACE("Flushing %u buffer and %u image barriers.\n",
+            (unsigned int)batch->buffer_barrier_count, (unsigned int)batch->image_barrier_count);
 
-    list->current_framebuffer = VK_NULL_HANDLE;
-    list->current_pipeline = VK_NULL_HANDLE;
-    list->pso_render_pass = VK_NULL_HANDLE;
-    list->current_render_pass = VK_NULL_HANDLE;
+    d3d12_command_list_cmd_pipeline_barrier(list, batch->src_stage_mask, batch->dst_stage_mask,
+            batch->has_memory_barrier ? 1 : 0, &batch->memory_barrier,
+            batch->buffer_barrier_count, batch->buffer_barriers,
+            batch->image_barrier_count, batch->image_barriers);
 
-    vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE]);
-    vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS]);
-    memset(list->pipeline_bindings, 0, sizeof(list->pipeline_bindings));
-    list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS].vk_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE].vk_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
+    vkd3d_barrier_batch_clear(batch);
+}
 
-    list->state = NULL;
+/* Exactly one of "memory_barrier", "buffer_barrier" and "image_barrier" must
+ * be non-NULL. */
+static void d3d12_command_list_add_barrier(struct d3d12_command_list *list,
+        VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
+        const VkMemoryBarrier *memory_barrier, const VkBufferMemoryBarrier *buffer_barrier,
+        const VkImageMemoryBarrier *image_barrier)
+{
+    struct vkd3d_barrier_batch *batch = &list->barriers;
+    size_t i;
 
-    memset(list->so_counter_buffers, 0, sizeof(list->so_counter_buffers));
-    memset(list->so_counter_buffer_offsets, 0, sizeof(list->so_counter_buffer_offsets));
+    if (memory_barrier)
+    {
+        batch->memory_barrier.srcAccessMask |= memory_barrier->srcAccessMask;
+        batch->memory_barrier.dstAccessMask |= memory_barrier->dstAccessMask;
+        batch->has_memory_barrier = true;
+    }
+    else if (buffer_barrier)
+    {
+        if (!vkd3d_array_reserve((void **)&batch->buffer_barriers, &batch->buffer_barriers_size,
+                batch->buffer_barrier_count + 1, sizeof(*batch->buffer_barriers)))
+            goto record;
+        batch->buffer_barriers[batch->buffer_barrier_count++] = *buffer_barrier;
+    }
+    else
+    {
+        /* Layout transitions within a single vkCmdPipelineBarrier() are
+         * unordered, so a subresource may only be transitioned once. */
+        for (i = 0; i < batch->image_barrier_count; ++i)
+        {
+            if (batch->image_barriers[i].image == image_barrier->image
+                    && vk_image_subresource_ranges_overlap(&batch->image_barriers[i].subresourceRange,
+                    &image_barrier->subresourceRange))
+            {
+                d3d12_command_list_flush_barriers(list);
+                break;
+            }
+        }
 
-    ID3D12GraphicsCommandList2_SetPipelineState(iface, initial_pipeline_state);
+        if (!vkd3d_array_reserve((void **)&batch->image_barriers, &batch->image_barriers_size,
+                batch->image_barrier_count + 1, sizeof(*batch->image_barriers)))
+            goto record;
+        batch->image_barriers[batch->image_barrier_count++] = *image_barrier;
+    }
+
+    batch->src_stage_mask |= src_stage_mask;
+    batch->dst_stage_mask |= dst_stage_mask;
+    return;
+
+record:
+    ERR("Failed to batch barrier.\n");
+    d3d12_command_list_flush_barriers(list);
+    d3d12_command_list_cmd_pipeline_barrier(list, src_stage_mask, dst_stage_mask,
+            0, NULL, buffer_barrier ? 1 : 0, buffer_barrier, image_barrier ? 1 : 0, image_barrier);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_command_list_Reset(ID3D12GraphicsCommandList2 *iface,
-        ID3D12CommandAllocator *allocator, ID3D12PipelineState *initial_pipeline_state)
+static void d3d12_command_list_end_current_render_pass(struct d3d12_command_list *list)
 {
-    struct d3d12_command_allocator *allocator_impl = unsafe_impl_from_ID3D12CommandAllocator(allocator);
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    HRESULT hr;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
 
-    TRACE("iface %p, allocator %p, initial_pipeline_state %p.\n",
-            iface, allocator, initial_pipeline_state);
+    d3d12_command_list_flush_barriers(list);
 
-    if (!allocator_impl)
+    if (list->xfb_enabled)
     {
-        WARN("Command allocator is NULL.\n");
-        return E_INVALIDARG;
+        VK_CALL(vkCmdEndTransformFeedbackEXT(d3d12_command_list_get_vk_command_buffer(list),
+                0, ARRAY_SIZE(list->so_counter_buffers),
+                list->so_counter_buffers, list->so_counter_buffer_offsets));
     }
 
-    if (list->is_recording)
+    if (list->current_render_pass)
+        d3d12_command_list_cmd_end_render_pass(list);
+
+    list->current_render_pass = VK_NULL_HANDLE;
+
+    if (list->xfb_enabled)
     {
-        WARN("Command list is in the recording state.\n");
-        return E_FAIL;
+        VkMemoryBarrier vk_barrier;
+
+        /* We need a barrier between pause and resume. */
+        vk_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        vk_barrier.pNext = NULL;
+        vk_barrier.srcAccessMask = VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
+        vk_barrier.dstAccessMask = VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT;
+        d3d12_command_list_cmd_pipeline_barrier(list,
+                VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                1, &vk_barrier, 0, NULL, 0, NULL);
+
+        list->xfb_enabled = false;
     }
+}
 
-    if (SUCCEEDED(hr = d3d12_command_allocator_allocate_command_buffer(allocator_impl, list)))
+static void d3d12_command_list_invalidate_current_render_pass(struct d3d12_command_list *list)
+{
+    d3d12_command_list_end_current_render_pass(list);
+}
+
+static bool d3d12_command_list_find_pending_discard(struct d3d12_command_list *list,
+        const struct d3d12_resource *resource, size_t *idx)
+{
+    size_t i;
+
+    for (i = 0; i < list->pending_discard_count; ++i)
     {
-        list->allocator = allocator_impl;
-        d3d12_command_list_reset_state(list, initial_pipeline_state);
+        if (list->pending_discards[i].resource == resource)
+        {
+            *idx = i;
+            return true;
+        }
     }
 
-    return hr;
+    return false;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ClearState(ID3D12GraphicsCommandList2 *iface,
-        ID3D12PipelineState *pipeline_state)
+static void d3d12_command_list_remove_pending_discard(struct d3d12_command_list *list, size_t idx)
 {
-    FIXME("iface %p, pipline_state %p stub!\n", iface, pipeline_state);
+    list->pending_discards[idx] = list->pending_discards[--list->pending_discard_count];
 }
 
-static bool d3d12_command_list_has_depth_stencil_view(struct d3d12_command_list *list)
+static void d3d12_command_list_drop_pending_discard(struct d3d12_command_list *list,
+        const struct d3d12_resource *resource)
 {
-    struct d3d12_graphics_pipeline_state *graphics;
+    size_t idx;
 
-    assert(d3d12_pipeline_state_is_graphics(list->state));
-    graphics = &list->state->u.graphics;
+    if (d3d12_command_list_find_pending_discard(list, resource, &idx))
+        d3d12_command_list_remove_pending_discard(list, idx);
+}
 
-    return graphics->dsv_format || (d3d12_pipeline_state_has_unknown_dsv_format(list->state) && list->dsv_format);
+static bool vkd3d_pending_discard_covers_range(const struct vkd3d_pending_discard *discard,
+        const VkImageSubresourceRange *range)
+{
+    const D3D12_RESOURCE_DESC *desc = &discard->resource->desc;
+    uint32_t level_count, layer_count;
+
+    level_count = range->levelCount == VK_REMAINING_MIP_LEVELS
+            ? desc->MipLevels - range->baseMipLevel : range->levelCount;
+    layer_count = range->layerCount == VK_REMAINING_ARRAY_LAYERS
+            ? d3d12_resource_desc_get_layer_count(desc) - range->baseArrayLayer : range->layerCount;
+
+    return discard->range.baseMipLevel <= range->baseMipLevel
+            && range->baseMipLevel + level_count <= discard->range.baseMipLevel + discard->range.levelCount
+            && discard->range.baseArrayLayer <= range->baseArrayLayer
+            && range->baseArrayLayer + layer_count <= discard->range.baseArrayLayer + discard->range.layerCount;
 }
 
-static void d3d12_command_list_get_fb_extent(struct d3d12_command_list *list,
-        uint32_t *width, uint32_t *height, uint32_t *layer_count)
+static bool vkd3d_pending_discard_covers_view(const struct vkd3d_pending_discard *discard,
+        const struct vkd3d_view *view)
 {
-    struct d3d12_graphics_pipeline_state *graphics = &list->state->u.graphics;
-    struct d3d12_device *device = list->device;
+    VkImageSubresourceRange range;
 
-    if (graphics->rt_count || d3d12_command_list_has_depth_stencil_view(list))
+    range.aspectMask = discard->range.aspectMask;
+    range.baseMipLevel = view->info.texture.miplevel_idx;
+    range.levelCount = 1;
+    /* Views of 3D textures select depth slices, which aren't sub-resources. */
+    if (discard->resource->desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
     {
-        *width = list->fb_width;
-        *height = list->fb_height;
-        if (layer_count)
-            *layer_count = list->fb_layer_count;
+        range.baseArrayLayer = 0;
+        range.layerCount = 1;
     }
     else
     {
-        *width = device->vk_info.device_limits.maxFramebufferWidth;
-        *height = device->vk_info.device_limits.maxFramebufferHeight;
-        if (layer_count)
-            *layer_count = 1;
+        range.baseArrayLayer = view->info.texture.layer_idx;
+        range.layerCount = view->info.texture.layer_count;
     }
+
+    return vkd3d_pending_discard_covers_range(discard, &range);
 }
 
-static bool d3d12_command_list_update_current_framebuffer(struct d3d12_command_list *list)
+static void d3d12_command_list_emit_clear(struct d3d12_command_list *list,
+        const struct vkd3d_pending_clear *clear, unsigned int rect_count, const D3D12_RECT *rects)
 {
-    struct d3d12_device *device = list->device;
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    VkImageView views[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
-    struct d3d12_graphics_pipeline_state *graphics;
-    struct VkFramebufferCreateInfo fb_desc;
+    struct vkd3d_framebuffer_key framebuffer_key;
+    struct vkd3d_render_pass_key pass_key;
+    struct VkRenderPassBeginInfo begin_desc;
     VkFramebuffer vk_framebuffer;
-    unsigned int view_count;
+    VkRenderPass vk_render_pass;
+    D3D12_RECT full_rect;
     unsigned int i;
-    VkResult vr;
-
-    if (list->current_framebuffer != VK_NULL_HANDLE)
-        return true;
+    HRESULT hr;
 
-    graphics = &list->state->u.graphics;
+    /* The discard is either superseded by the clear, or precedes it. */
+    d3d12_command_list_drop_pending_discard(list, clear->resource);
 
-    for (i = 0, view_count = 0; i < graphics->rt_count; ++i)
+    if (!rect_count)
     {
-        if (graphics->null_attachment_mask & (1u << i))
-        {
-            if (list->rtvs[i])
-                WARN("Expected NULL RTV for attachment %u.\n", i);
-            continue;
-        }
-
-        if (!list->rtvs[i])
-        {
-            FIXME("Invalid RTV for attachment %u.\n", i);
-            return false;
-        }
+        full_rect.top = 0;
+        full_rect.left = 0;
+        full_rect.bottom = clear->height;
+        full_rect.right = clear->width;
 
-        views[view_count++] = list->rtvs[i];
+        rect_count = 1;
+        rects = &full_rect;
     }
 
-    if (d3d12_command_list_has_depth_stencil_view(list))
+    memset(&pass_key, 0, sizeof(pass_key));
+    pass_key.attachment_count = 1;
+    pass_key.sample_count = clear->sample_count;
+    pass_key.vk_formats[0] = clear->view->format->vk_format;
+    if (clear->aspect_mask & VK_IMAGE_ASPECT_COLOR_BIT)
     {
-        if (!(views[view_count++] = list->dsv))
-        {
-            FIXME("Invalid DSV.\n");
-            return false;
-        }
+        pass_key.clear_mask = 1u;
     }
-
-    fb_desc.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    fb_desc.pNext = NULL;
-    fb_desc.flags = 0;
-    fb_desc.renderPass = list->pso_render_pass;
-    fb_desc.attachmentCount = view_count;
-    fb_desc.pAttachments = views;
-    d3d12_command_list_get_fb_extent(list, &fb_desc.width, &fb_desc.height, &fb_desc.layers);
-    if ((vr = VK_CALL(vkCreateFramebuffer(device->vk_device, &fb_desc, NULL, &vk_framebuffer))) < 0)
+    else
     {
-        WARN("Failed to create Vulkan framebuffer, vr %d.\n", vr);
-        return false;
+        /* Aspects which are not cleared are preserved. */
+        pass_key.depth_enable = true;
+        pass_key.stencil_enable = true;
+        pass_key.depth_stencil_write = true;
+        if (clear->aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+            pass_key.clear_mask |= VKD3D_RENDER_PASS_DEPTH_BIT;
+        if (clear->aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT)
+            pass_key.clear_mask |= VKD3D_RENDER_PASS_STENCIL_BIT;
     }
 
-    if (!d3d12_command_allocator_add_framebuffer(list->allocator, vk_framebuffer))
+    if (FAILED(hr = vkd3d_render_pass_cache_find(&list->device->render_pass_cache,
+            list->device, &pass_key, &vk_render_pass)))
     {
-        WARN("Failed to add framebuffer.\n");
-        VK_CALL(vkDestroyFramebuffer(device->vk_device, vk_framebuffer, NULL));
-        return false;
+        WARN("Failed to get clear render pass, hr %#x.\n", hr);
+        return;
     }
 
-    list->current_framebuffer = vk_framebuffer;
+    memset(&framebuffer_key, 0, sizeof(framebuffer_key));
+    framebuffer_key.vk_render_pass = vk_render_pass;
+    framebuffer_key.views[0] = clear->view->u.vk_image_view;
+    framebuffer_key.view_count = 1;
+    framebuffer_key.width = clear->width;
+    framebuffer_key.height = clear->height;
+    framebuffer_key.layer_count = clear->layer_count;
 
-    return true;
-}
+    if (FAILED(hr = vkd3d_framebuffer_cache_find(&list->device->framebuffer_cache,
+            list->device, &framebuffer_key, &vk_framebuffer)))
+    {
+        WARN("Failed to get clear framebuffer, hr %#x.\n", hr);
+        return;
+    }
 
-static bool d3d12_command_list_update_compute_pipeline(struct d3d12_command_list *list)
-{
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    d3d12_command_list_flush_barriers(list);
 
-    if (list->current_pipeline != VK_NULL_HANDLE)
-        return true;
+    begin_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    begin_desc.pNext = NULL;
+    begin_desc.renderPass = vk_render_pass;
+    begin_desc.framebuffer = vk_framebuffer;
+    begin_desc.clearValueCount = 1;
+    begin_desc.pClearValues = &clear->value;
 
-    if (!d3d12_pipeline_state_is_compute(list->state))
+    for (i = 0; i < rect_count; ++i)
     {
-        WARN("Pipeline state %p is not a compute pipeline.\n", list->state);
-        return false;
+        begin_desc.renderArea.offset.x = rects[i].left;
+        begin_desc.renderArea.offset.y = rects[i].top;
+        begin_desc.renderArea.extent.width = rects[i].right - rects[i].left;
+        begin_desc.renderArea.extent.height = rects[i].bottom - rects[i].top;
+        d3d12_command_list_cmd_begin_render_pass(list, &begin_desc);
+        d3d12_command_list_cmd_end_render_pass(list);
     }
-
-    VK_CALL(vkCmdBindPipeline(list->vk_command_buffer, list->state->vk_bind_point, list->state->u.compute.vk_pipeline));
-    list->current_pipeline = list->state->u.compute.vk_pipeline;
-
-    return true;
 }
 
-static bool d3d12_command_list_update_graphics_pipeline(struct d3d12_command_list *list)
+static void d3d12_command_list_remove_pending_clear(struct d3d12_command_list *list, size_t idx)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    VkRenderPass vk_render_pass;
-    VkPipeline vk_pipeline;
+    /* The order of pending clears doesn't matter, there is at most one for
+     * each resource. */
+    list->pending_clears[idx] = list->pending_clears[--list->pending_clear_count];
+}
 
-    if (list->current_pipeline != VK_NULL_HANDLE)
-        return true;
+/* Must be called outside of a render pass. */
+static void d3d12_command_list_flush_pending_clears(struct d3d12_command_list *list)
+{
+    size_t i;
 
-    if (!d3d12_pipeline_state_is_graphics(list->state))
-    {
-        WARN("Pipeline state %p is not a graphics pipeline.\n", list->state);
-        return false;
-    }
+    assert(!list->current_render_pass);
 
-    if (!(vk_pipeline = d3d12_pipeline_state_get_or_create_pipeline(list->state,
-            list->primitive_topology, list->strides, list->dsv_format, &vk_render_pass)))
-        return false;
+    for (i = 0; i < list->pending_clear_count; ++i)
+        d3d12_command_list_emit_clear(list, &list->pending_clears[i], 0, NULL);
+    list->pending_clear_count = 0;
+}
 
-    /* The render pass cache ensures that we use the same Vulkan render pass
-     * object for compatible render passes. */
-    if (list->pso_render_pass != vk_render_pass)
+static void d3d12_command_list_invalidate_bindings(struct d3d12_command_list *list,
+        struct d3d12_pipeline_state *state)
+{
+    if (state && state->uav_counters.binding_count)
     {
-        list->pso_render_pass = vk_render_pass;
-        d3d12_command_list_invalidate_current_framebuffer(list);
-        d3d12_command_list_invalidate_current_render_pass(list);
-    }
-
-    VK_CALL(vkCmdBindPipeline(list->vk_command_buffer, list->state->vk_bind_point, vk_pipeline));
-    list->current_pipeline = vk_pipeline;
+        enum vkd3d_pipeline_bind_point bind_point = (enum vkd3d_pipeline_bind_point)state->vk_bind_point;
+        struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
 
-    return true;
+        vkd3d_array_reserve((void **)&bindings->vk_uav_counter_views, &bindings->vk_uav_counter_views_size,
+                state->uav_counters.binding_count, sizeof(*bindings->vk_uav_counter_views));
+        bindings->uav_counters_dirty = true;
+    }
 }
 
-static void d3d12_command_list_prepare_descriptors(struct d3d12_command_list *list,
+static void d3d12_command_list_invalidate_root_parameters(struct d3d12_command_list *list,
         enum vkd3d_pipeline_bind_point bind_point)
 {
     struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    unsigned int variable_binding_size, unbounded_offset, table_index, heap_size, i;
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    const struct d3d12_descriptor_set_layout *layout;
-    const struct d3d12_desc *base_descriptor;
-    VkDescriptorSet vk_descriptor_set;
 
-    if (bindings->descriptor_set_count && !bindings->in_use)
+    if (!bindings->root_signature)
         return;
 
-    /* We cannot modify bound descriptor sets. We need a new descriptor set if
-     * we are about to update resource bindings.
-     *
-     * The Vulkan spec says:
-     *
-     *   "The descriptor set contents bound by a call to
-     *   vkCmdBindDescriptorSets may be consumed during host execution of the
-     *   command, or during shader execution of the resulting draws, or any
-     *   time in between. Thus, the contents must not be altered (overwritten
-     *   by an update command, or freed) between when the command is recorded
-     *   and when the command completes executing on the queue."
-     */
     bindings->descriptor_set_count = 0;
-    for (i = root_signature->main_set; i < root_signature->vk_set_count; ++i)
-    {
-        layout = &root_signature->descriptor_set_layouts[i];
-        unbounded_offset = layout->unbounded_offset;
-        table_index = layout->table_index;
-        variable_binding_size = 0;
-
-        if (unbounded_offset != UINT_MAX
-                /* Descriptors may not be set, eg. WoW. */
-                && (base_descriptor = bindings->descriptor_tables[table_index]))
-        {
-            heap_size = d3d12_desc_heap_range_size(base_descriptor);
-
-            if (heap_size < unbounded_offset)
-                WARN("Descriptor heap size %u is less than the offset %u of an unbounded range in table %u, "
-                        "vk set %u.\n", heap_size, unbounded_offset, table_index, i);
-            else
-                variable_binding_size = heap_size - unbounded_offset;
-        }
-
-        vk_descriptor_set = d3d12_command_allocator_allocate_descriptor_set(list->allocator,
-                layout->vk_layout, variable_binding_size, unbounded_offset != UINT_MAX);
-        bindings->descriptor_sets[bindings->descriptor_set_count++] = vk_descriptor_set;
-    }
-
-    bindings->in_use = false;
-
-    bindings->descriptor_table_dirty_mask |= bindings->descriptor_table_active_mask & root_signature->descriptor_table_mask;
-    bindings->push_descriptor_dirty_mask |= bindings->push_descriptor_active_mask & root_signature->push_descriptor_mask;
+    bindings->descriptor_table_dirty_mask = bindings->descriptor_table_active_mask & bindings->root_signature->descriptor_table_mask;
+    bindings->push_descriptor_dirty_mask = bindings->push_descriptor_active_mask & bindings->root_signature->push_descriptor_mask;
+    bindings->cbv_srv_uav_heap_id = 0;
+    bindings->sampler_heap_id = 0;
 }
 
-static bool vk_write_descriptor_set_from_d3d12_desc(VkWriteDescriptorSet *vk_descriptor_write,
-        VkDescriptorImageInfo *vk_image_info, const struct d3d12_desc *descriptor,
-        const struct d3d12_root_descriptor_table_range *range, VkDescriptorSet *vk_descriptor_sets,
-        unsigned int index, bool use_array)
+static bool vk_barrier_parameters_from_d3d12_resource_state(unsigned int state, unsigned int stencil_state,
+        const struct d3d12_resource *resource, VkQueueFlags vk_queue_flags, const struct vkd3d_vulkan_info *vk_info,
+        VkAccessFlags *access_mask, VkPipelineStageFlags *stage_flags, VkImageLayout *image_layout)
 {
-    uint32_t descriptor_range_magic = range->descriptor_magic;
-    const struct vkd3d_view *view = descriptor->s.u.view_info.view;
-    uint32_t vk_binding = range->binding;
-    uint32_t set = range->set;
-
-    if (descriptor->s.magic != descriptor_range_magic)
-        return false;
-
-    vk_descriptor_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    vk_descriptor_write->pNext = NULL;
-    vk_descriptor_write->dstSet = vk_descriptor_sets[set];
-    vk_descriptor_write->dstBinding = use_array ? vk_binding : vk_binding + index;
-    vk_descriptor_write->dstArrayElement = use_array ? index : 0;
-    vk_descriptor_write->descriptorCount = 1;
-    vk_descriptor_write->descriptorType = descriptor->s.vk_descriptor_type;
-    vk_descriptor_write->pImageInfo = NULL;
-    vk_descriptor_write->pBufferInfo = NULL;
-    vk_descriptor_write->pTexelBufferView = NULL;
+    bool is_swapchain_image = resource && (resource->flags & VKD3D_RESOURCE_PRESENT_STATE_TRANSITION);
+    VkPipelineStageFlags queue_shader_stages = 0;
 
-    switch (descriptor->s.magic)
+    if (vk_queue_flags & VK_QUEUE_GRAPHICS_BIT)
     {
-        case VKD3D_DESCRIPTOR_MAGIC_CBV:
-            vk_descriptor_write->pBufferInfo = &descriptor->s.u.vk_cbv_info;
-            break;
+        queue_shader_stages |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT
+                | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT
+                | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT
+                | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+    if (vk_queue_flags & VK_QUEUE_COMPUTE_BIT)
+        queue_shader_stages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 
-        case VKD3D_DESCRIPTOR_MAGIC_SRV:
-        case VKD3D_DESCRIPTOR_MAGIC_UAV:
-            /* We use separate bindings for buffer and texture SRVs/UAVs.
-             * See d3d12_root_signature_init(). For unbounded ranges the
-             * descriptors exist in two consecutive sets, otherwise they occur
-             * in pairs in one set. */
-            if (range->descriptor_count == UINT_MAX)
+    switch (state)
+    {
+        case D3D12_RESOURCE_STATE_COMMON: /* D3D12_RESOURCE_STATE_PRESENT */
+            /* The COMMON state is used for ownership transfer between
+             * DIRECT/COMPUTE and COPY queues. Additionally, a texture has to
+             * be in the COMMON state to be accessed by CPU. Moreover,
+             * resources can be implicitly promoted to other states out of the
+             * COMMON state, and the resource state can decay to the COMMON
+             * state when GPU finishes execution of a command list. */
+            if (is_swapchain_image)
             {
-                if (descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
-                        && descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+                if (resource->present_state == D3D12_RESOURCE_STATE_PRESENT)
                 {
-                    vk_descriptor_write->dstSet = vk_descriptor_sets[set + 1];
-                    vk_descriptor_write->dstBinding = 0;
+                    *access_mask = VK_ACCESS_MEMORY_READ_BIT;
+                    *stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                    if (image_layout)
+                        *image_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+                    return true;
+                }
+                else if (resource->present_state != D3D12_RESOURCE_STATE_COMMON)
+                {
+                    vk_barrier_parameters_from_d3d12_resource_state(resource->present_state, 0,
+                            resource, vk_queue_flags, vk_info, access_mask, stage_flags, image_layout);
+                    return true;
                 }
-            }
-            else
-            {
-                if (!use_array)
-                    vk_descriptor_write->dstBinding = vk_binding + 2 * index;
-                if (descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
-                        && descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
-                    ++vk_descriptor_write->dstBinding;
             }
 
-            if (descriptor->s.vk_descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
-                    || descriptor->s.vk_descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+            *access_mask = VK_ACCESS_HOST_READ_BIT | VK_ACCESS_HOST_WRITE_BIT;
+            *stage_flags = VK_PIPELINE_STAGE_HOST_BIT;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
+            return true;
+
+        /* Handle write states. */
+        case D3D12_RESOURCE_STATE_RENDER_TARGET:
+            *access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT
+                    | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            *stage_flags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            return true;
+
+        case D3D12_RESOURCE_STATE_UNORDERED_ACCESS:
+            *access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            *stage_flags = queue_shader_stages;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
+            return true;
+
+        case D3D12_RESOURCE_STATE_DEPTH_WRITE:
+            *access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+                    | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            *stage_flags = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                    | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            if (image_layout)
             {
-                vk_descriptor_write->pTexelBufferView = &view->u.vk_buffer_view;
+                if (!stencil_state || (stencil_state & D3D12_RESOURCE_STATE_DEPTH_WRITE))
+                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+                else
+                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
             }
-            else
-            {
-                vk_image_info->sampler = VK_NULL_HANDLE;
-                vk_image_info->imageView = view->u.vk_image_view;
-                vk_image_info->imageLayout = descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_SRV
-                        ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+            return true;
+
+        case D3D12_RESOURCE_STATE_COPY_DEST:
+        case D3D12_RESOURCE_STATE_RESOLVE_DEST:
+            *access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            *stage_flags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            return true;
+
+        case D3D12_RESOURCE_STATE_STREAM_OUT:
+            *access_mask = VK_ACCESS_TRANSFORM_FEEDBACK_WRITE_BIT_EXT
+                    | VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_READ_BIT_EXT
+                    | VK_ACCESS_TRANSFORM_FEEDBACK_COUNTER_WRITE_BIT_EXT;
+            *stage_flags = VK_PIPELINE_STAGE_TRANSFORM_FEEDBACK_BIT_EXT
+                    | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            return true;
 
-                vk_descriptor_write->pImageInfo = vk_image_info;
+        /* Set the Vulkan image layout for read-only states. */
+        case D3D12_RESOURCE_STATE_DEPTH_READ:
+        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
+        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
+        case D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+                | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
+            *access_mask = 0;
+            *stage_flags = 0;
+            if (image_layout)
+            {
+                if (stencil_state & D3D12_RESOURCE_STATE_DEPTH_WRITE)
+                {
+                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL;
+                    *access_mask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+                }
+                else
+                {
+                    *image_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+                }
             }
             break;
 
-        case VKD3D_DESCRIPTOR_MAGIC_SAMPLER:
-            vk_image_info->sampler = view->u.vk_sampler;
-            vk_image_info->imageView = VK_NULL_HANDLE;
-            vk_image_info->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        case D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE:
+        case D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
+        case D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
+            *access_mask = 0;
+            *stage_flags = 0;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            break;
 
-            vk_descriptor_write->pImageInfo = vk_image_info;
+        case D3D12_RESOURCE_STATE_COPY_SOURCE:
+        case D3D12_RESOURCE_STATE_RESOLVE_SOURCE:
+            *access_mask = 0;
+            *stage_flags = 0;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
             break;
 
         default:
-            ERR("Invalid descriptor %#x.\n", descriptor->s.magic);
-            return false;
+            *access_mask = 0;
+            *stage_flags = 0;
+            if (image_layout)
+                *image_layout = VK_IMAGE_LAYOUT_GENERAL;
+            break;
     }
 
-    return true;
-}
+    /* Handle read-only states. */
+    assert(!is_write_resource_state(state));
 
-static void d3d12_command_list_update_descriptor_table(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, struct d3d12_desc *base_descriptor)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    struct VkWriteDescriptorSet descriptor_writes[24], *current_descriptor_write;
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    struct VkDescriptorImageInfo image_infos[24], *current_image_info;
-    const struct d3d12_root_descriptor_table *descriptor_table;
-    const struct d3d12_pipeline_state *state = list->state;
-    const struct d3d12_root_descriptor_table_range *range;
-    VkDevice vk_device = list->device->vk_device;
-    unsigned int i, j, k, descriptor_count;
-    struct d3d12_desc *descriptor;
-    unsigned int write_count = 0;
-    bool unbounded = false;
+    if (state & D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)
+    {
+        *access_mask |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+                | VK_ACCESS_UNIFORM_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+                | queue_shader_stages;
+        state &= ~D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+    }
 
-    descriptor_table = root_signature_get_descriptor_table(root_signature, index);
+    if (state & D3D12_RESOURCE_STATE_INDEX_BUFFER)
+    {
+        *access_mask |= VK_ACCESS_INDEX_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        state &= ~D3D12_RESOURCE_STATE_INDEX_BUFFER;
+    }
 
-    current_descriptor_write = descriptor_writes;
-    current_image_info = image_infos;
-    for (i = 0; i < descriptor_table->range_count; ++i)
+    if (state & D3D12_RESOURCE_STATE_DEPTH_READ)
     {
-        range = &descriptor_table->ranges[i];
+        *access_mask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+                | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        state &= ~D3D12_RESOURCE_STATE_DEPTH_READ;
+    }
 
-        /* The first unbounded range of each type is written until the heap end is reached. Do not repeat. */
-        if (unbounded && i && range->type == descriptor_table->ranges[i - 1].type)
-            continue;
-
-        descriptor = base_descriptor + range->offset;
+    if (state & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+    {
+        *access_mask |= VK_ACCESS_SHADER_READ_BIT;
+        *stage_flags |= (queue_shader_stages & ~VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        state &= ~D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    }
+    if (state & D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
+    {
+        *access_mask |= VK_ACCESS_SHADER_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        state &= ~D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    }
 
-        descriptor_count = range->descriptor_count;
-        if ((unbounded = descriptor_count == UINT_MAX))
+    if (state & D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT) /* D3D12_RESOURCE_STATE_PREDICATION */
+    {
+        *access_mask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        if (vk_info->EXT_conditional_rendering)
         {
-            descriptor_count = d3d12_desc_heap_range_size(descriptor);
-
-            if (descriptor_count > range->vk_binding_count)
-            {
-                ERR("Heap descriptor count %u exceeds maximum Vulkan count %u. Reducing to the Vulkan maximum.\n",
-                        descriptor_count, range->vk_binding_count);
-                descriptor_count = range->vk_binding_count;
-            }
+            *access_mask |= VK_ACCESS_CONDITIONAL_RENDERING_READ_BIT_EXT;
+            *stage_flags |= VK_PIPELINE_STAGE_CONDITIONAL_RENDERING_BIT_EXT;
         }
+        state &= ~D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT;
+    }
 
-        for (j = 0; j < descriptor_count; ++j, ++descriptor)
-        {
-            unsigned int register_idx = range->base_register_idx + j;
+    if (state & (D3D12_RESOURCE_STATE_COPY_SOURCE | D3D12_RESOURCE_STATE_RESOLVE_SOURCE))
+    {
+        *access_mask |= VK_ACCESS_TRANSFER_READ_BIT;
+        *stage_flags |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        state &= ~(D3D12_RESOURCE_STATE_COPY_SOURCE | D3D12_RESOURCE_STATE_RESOLVE_SOURCE);
+    }
 
-            /* Track UAV counters. */
-            if (range->descriptor_magic == VKD3D_DESCRIPTOR_MAGIC_UAV)
-            {
-                for (k = 0; k < state->uav_counters.binding_count; ++k)
-                {
-                    if (state->uav_counters.bindings[k].register_space == range->register_space
-                            && state->uav_counters.bindings[k].register_index == register_idx)
-                    {
-                        VkBufferView vk_counter_view = descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_UAV
-                                ? descriptor->s.u.view_info.view->vk_counter_view : VK_NULL_HANDLE;
-                        if (bindings->vk_uav_counter_views[k] != vk_counter_view)
-                            bindings->uav_counters_dirty = true;
-                        bindings->vk_uav_counter_views[k] = vk_counter_view;
-                        break;
-                    }
-                }
-            }
+    if (state)
+    {
+        WARN("Invalid resource state %#x.\n", state);
+        return false;
+    }
+    return true;
+}
 
-            /* Not all descriptors are necessarily populated if the range is unbounded. */
-            if (descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE)
-                continue;
+static void d3d12_command_list_transition_resource_to_initial_state(struct d3d12_command_list *list,
+        struct d3d12_resource *resource)
+{
+    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
+    VkPipelineStageFlags src_stage_mask, dst_stage_mask;
+    VkImageMemoryBarrier barrier;
 
-            if (!vk_write_descriptor_set_from_d3d12_desc(current_descriptor_write, current_image_info,
-                    descriptor, range, bindings->descriptor_sets, j, root_signature->use_descriptor_arrays))
-                continue;
+    assert(d3d12_resource_is_texture(resource));
 
-            ++write_count;
-            ++current_descriptor_write;
-            ++current_image_info;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
 
-            if (write_count == ARRAY_SIZE(descriptor_writes))
-            {
-                VK_CALL(vkUpdateDescriptorSets(vk_device, write_count, descriptor_writes, 0, NULL));
-                write_count = 0;
-                current_descriptor_write = descriptor_writes;
-                current_image_info = image_infos;
-            }
-        }
+    /* vkQueueSubmit() defines a memory dependency with prior host writes. */
+    src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    barrier.srcAccessMask = 0;
+    barrier.oldLayout = d3d12_resource_is_cpu_accessible(resource) ?
+            VK_IMAGE_LAYOUT_PREINITIALIZED : VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (!vk_barrier_parameters_from_d3d12_resource_state(resource->initial_state, 0,
+            resource, list->vk_queue_flags, vk_info, &barrier.dstAccessMask, &dst_stage_mask, &barrier.newLayout))
+    {
+        FIXME("Unhandled state %#x.\n", resource->initial_state);
+        return;
     }
 
-    VK_CALL(vkUpdateDescriptorSets(vk_device, write_count, descriptor_writes, 0, NULL));
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = resource->u.vk_image;
+    barrier.subresourceRange.aspectMask = resource->format->vk_aspect_mask;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+    TRACE("Initial state %#x transition for resource %p (old layout %#x, new layout %#x).\n",
+            resource->initial_state, resource, barrier.oldLayout, barrier.newLayout);
+
+    d3d12_command_list_cmd_pipeline_barrier(list, src_stage_mask, dst_stage_mask,
+            0, NULL, 0, NULL, 1, &barrier);
 }
 
-static bool vk_write_descriptor_set_from_root_descriptor(VkWriteDescriptorSet *vk_descriptor_write,
-        const struct d3d12_root_parameter *root_parameter, VkDescriptorSet vk_descriptor_set,
-        VkBufferView *vk_buffer_view, const VkDescriptorBufferInfo *vk_buffer_info)
+static void d3d12_command_list_track_resource_usage(struct d3d12_command_list *list,
+        struct d3d12_resource *resource)
 {
-    const struct d3d12_root_descriptor *root_descriptor;
-
-    switch (root_parameter->parameter_type)
+    if (resource->flags & VKD3D_RESOURCE_INITIAL_STATE_TRANSITION)
     {
-        case D3D12_ROOT_PARAMETER_TYPE_CBV:
-            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            break;
-        case D3D12_ROOT_PARAMETER_TYPE_SRV:
-            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
-            break;
-        case D3D12_ROOT_PARAMETER_TYPE_UAV:
-            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-            break;
-        default:
-            ERR("Invalid root descriptor %#x.\n", root_parameter->parameter_type);
-            return false;
+        d3d12_command_list_end_current_render_pass(list);
+
+        d3d12_command_list_transition_resource_to_initial_state(list, resource);
+        resource->flags &= ~VKD3D_RESOURCE_INITIAL_STATE_TRANSITION;
     }
+}
 
-    root_descriptor = &root_parameter->u.descriptor;
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_QueryInterface(ID3D12GraphicsCommandList2 *iface,
+        REFIID iid, void **object)
+{
+    TRACE("iface %p, iid %s, object %p.\n", iface, debugstr_guid(iid), object);
 
-    vk_descriptor_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    vk_descriptor_write->pNext = NULL;
-    vk_descriptor_write->dstSet = vk_descriptor_set;
-    vk_descriptor_write->dstBinding = root_descriptor->binding;
-    vk_descriptor_write->dstArrayElement = 0;
-    vk_descriptor_write->descriptorCount = 1;
-    vk_descriptor_write->pImageInfo = NULL;
-    vk_descriptor_write->pBufferInfo = vk_buffer_info;
-    vk_descriptor_write->pTexelBufferView = vk_buffer_view;
+    if (IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList2)
+            || IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList1)
+            || IsEqualGUID(iid, &IID_ID3D12GraphicsCommandList)
+            || IsEqualGUID(iid, &IID_ID3D12CommandList)
+            || IsEqualGUID(iid, &IID_ID3D12DeviceChild)
+            || IsEqualGUID(iid, &IID_ID3D12Object)
+            || IsEqualGUID(iid, &IID_IUnknown))
+    {
+        ID3D12GraphicsCommandList2_AddRef(iface);
+        *object = iface;
+        return S_OK;
+    }
 
-    return true;
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(iid));
+
+    *object = NULL;
+    return E_NOINTERFACE;
 }
 
-static void d3d12_command_list_update_push_descriptors(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point)
+static ULONG STDMETHODCALLTYPE d3d12_command_list_AddRef(ID3D12GraphicsCommandList2 *iface)
 {
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    VkWriteDescriptorSet *descriptor_writes = NULL, *current_descriptor_write;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    VkDescriptorBufferInfo *buffer_infos = NULL, *current_buffer_info;
-    const struct d3d12_root_parameter *root_parameter;
-    struct vkd3d_push_descriptor *push_descriptor;
-    struct d3d12_device *device = list->device;
-    VkDescriptorBufferInfo *vk_buffer_info;
-    unsigned int i, descriptor_count;
-    VkBufferView *vk_buffer_view;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    ULONG refcount = InterlockedIncrement(&list->refcount);
 
-    if (!bindings->push_descriptor_dirty_mask)
-        return;
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
 
-    descriptor_count = vkd3d_popcount(bindings->push_descriptor_dirty_mask);
+    return refcount;
+}
 
-    if (!(descriptor_writes = vkd3d_calloc(descriptor_count, sizeof(*descriptor_writes))))
-        return;
-    if (!(buffer_infos = vkd3d_calloc(descriptor_count, sizeof(*buffer_infos))))
-        goto done;
+static void vkd3d_pipeline_bindings_cleanup(struct vkd3d_pipeline_bindings *bindings)
+{
+    vkd3d_free(bindings->vk_uav_counter_views);
+}
 
-    descriptor_count = 0;
-    current_buffer_info = buffer_infos;
-    current_descriptor_write = descriptor_writes;
-    for (i = 0; i < ARRAY_SIZE(bindings->push_descriptors); ++i)
+static ULONG STDMETHODCALLTYPE d3d12_command_list_Release(ID3D12GraphicsCommandList2 *iface)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
     {
-        if (!(bindings->push_descriptor_dirty_mask & (1u << i)))
-            continue;
+        struct d3d12_device *device = list->device;
 
-        root_parameter = root_signature_get_root_descriptor(root_signature, i);
-        push_descriptor = &bindings->push_descriptors[i];
+        vkd3d_private_store_destroy(&list->private_store);
 
-        if (root_parameter->parameter_type == D3D12_ROOT_PARAMETER_TYPE_CBV)
-        {
-            vk_buffer_view = NULL;
-            vk_buffer_info = current_buffer_info;
-            vk_buffer_info->buffer = push_descriptor->u.cbv.vk_buffer;
-            vk_buffer_info->offset = push_descriptor->u.cbv.offset;
-            vk_buffer_info->range = VK_WHOLE_SIZE;
-        }
-        else
-        {
-            vk_buffer_view = &push_descriptor->u.vk_buffer_view;
-            vk_buffer_info = NULL;
-        }
+        /* When command pool is destroyed, all command buffers are implicitly freed. */
+        if (list->allocator)
+            d3d12_command_allocator_free_command_buffer(list->allocator, list);
 
-        if (!vk_write_descriptor_set_from_root_descriptor(current_descriptor_write,
-                root_parameter, bindings->descriptor_sets[0], vk_buffer_view, vk_buffer_info))
-            continue;
+        vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE]);
+        vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS]);
+        vkd3d_barrier_batch_cleanup(&list->barriers);
+        vkd3d_free(list->pending_clears);
+        vkd3d_free(list->pending_discards);
+        vkd3d_free(list->bundle_data);
 
-        ++descriptor_count;
-        ++current_descriptor_write;
-        ++current_buffer_info;
-    }
+        vkd3d_free(list);
 
-    VK_CALL(vkUpdateDescriptorSets(device->vk_device, descriptor_count, descriptor_writes, 0, NULL));
-    bindings->push_descriptor_dirty_mask = 0;
+        d3d12_device_release(device);
+    }
 
-done:
-    vkd3d_free(descriptor_writes);
-    vkd3d_free(buffer_infos);
+    return refcount;
 }
 
-static void d3d12_command_list_update_uav_counter_descriptors(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point)
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_GetPrivateData(ID3D12GraphicsCommandList2 *iface,
+        REFGUID guid, UINT *data_size, void *data)
 {
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_pipeline_state *state = list->state;
-    VkDevice vk_device = list->device->vk_device;
-    VkWriteDescriptorSet *vk_descriptor_writes;
-    VkDescriptorSet vk_descriptor_set;
-    unsigned int uav_counter_count;
-    unsigned int i;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    if (!state || !bindings->uav_counters_dirty)
-        return;
-
-    uav_counter_count = state->uav_counters.binding_count;
-    if (!(vk_descriptor_writes = vkd3d_calloc(uav_counter_count, sizeof(*vk_descriptor_writes))))
-        return;
-    if (!(vk_descriptor_set = d3d12_command_allocator_allocate_descriptor_set(
-            list->allocator, state->uav_counters.vk_set_layout, 0, false)))
-        goto done;
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
-    for (i = 0; i < uav_counter_count; ++i)
-    {
-        const struct vkd3d_shader_uav_counter_binding *uav_counter = &state->uav_counters.bindings[i];
-        const VkBufferView *vk_uav_counter_views = bindings->vk_uav_counter_views;
+    return vkd3d_get_private_data(&list->private_store, guid, data_size, data);
+}
 
-        assert(vk_uav_counter_views[i]);
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetPrivateData(ID3D12GraphicsCommandList2 *iface,
+        REFGUID guid, UINT data_size, const void *data)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-        vk_descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        vk_descriptor_writes[i].pNext = NULL;
-        vk_descriptor_writes[i].dstSet = vk_descriptor_set;
-        vk_descriptor_writes[i].dstBinding = uav_counter->binding.binding;
-        vk_descriptor_writes[i].dstArrayElement = 0;
-        vk_descriptor_writes[i].descriptorCount = 1;
-        vk_descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-        vk_descriptor_writes[i].pImageInfo = NULL;
-        vk_descriptor_writes[i].pBufferInfo = NULL;
-        vk_descriptor_writes[i].pTexelBufferView = &vk_uav_counter_views[i];
-    }
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
 
-    VK_CALL(vkUpdateDescriptorSets(vk_device, uav_counter_count, vk_descriptor_writes, 0, NULL));
+    return vkd3d_set_private_data(&list->private_store, guid, data_size, data);
+}
 
-    VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, bindings->vk_bind_point,
-            state->uav_counters.vk_pipeline_layout, state->uav_counters.set_index, 1, &vk_descriptor_set, 0, NULL));
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetPrivateDataInterface(ID3D12GraphicsCommandList2 *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    bindings->uav_counters_dirty = false;
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
 
-done:
-    vkd3d_free(vk_descriptor_writes);
+    return vkd3d_set_private_data_interface(&list->private_store, guid, data);
 }
 
-static void d3d12_command_list_update_descriptors(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point)
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_SetName(ID3D12GraphicsCommandList2 *iface, const WCHAR *name)
 {
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_root_signature *rs = bindings->root_signature;
-    struct d3d12_desc *base_descriptor;
-    unsigned int i;
-
-    if (!rs || !rs->vk_set_count)
-        return;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    if (bindings->descriptor_table_dirty_mask || bindings->push_descriptor_dirty_mask)
-        d3d12_command_list_prepare_descriptors(list, bind_point);
+    TRACE("iface %p, name %s.\n", iface, debugstr_w(name, list->device->wchar_size));
 
-    for (i = 0; i < ARRAY_SIZE(bindings->descriptor_tables); ++i)
-    {
-        if (bindings->descriptor_table_dirty_mask & ((uint64_t)1 << i))
-        {
-            if ((base_descriptor = bindings->descriptor_tables[i]))
-                d3d12_command_list_update_descriptor_table(list, bind_point, i, base_descriptor);
-            else
-                WARN("Descriptor table %u is not set.\n", i);
-        }
-    }
-    bindings->descriptor_table_dirty_mask = 0;
+    return name ? S_OK : E_INVALIDARG;
+}
 
-    d3d12_command_list_update_push_descriptors(list, bind_point);
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_GetDevice(ID3D12GraphicsCommandList2 *iface, REFIID iid, void **device)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    if (bindings->descriptor_set_count)
-    {
-        VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, bindings->vk_bind_point,
-                rs->vk_pipeline_layout, rs->main_set, bindings->descriptor_set_count, bindings->descriptor_sets,
-                0, NULL));
-        bindings->in_use = true;
-    }
+    TRACE("iface %p, iid %s, device %p.\n", iface, debugstr_guid(iid), device);
 
-    d3d12_command_list_update_uav_counter_descriptors(list, bind_point);
+    return d3d12_device_query_interface(list->device, iid, device);
 }
 
-static unsigned int d3d12_command_list_bind_descriptor_table(struct d3d12_command_list *list,
-        struct vkd3d_pipeline_bindings *bindings, unsigned int index,
-        struct d3d12_descriptor_heap **cbv_srv_uav_heap, struct d3d12_descriptor_heap **sampler_heap)
+static D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE d3d12_command_list_GetType(ID3D12GraphicsCommandList2 *iface)
 {
-    struct d3d12_descriptor_heap *heap;
-    const struct d3d12_desc *desc;
-    unsigned int offset;
-
-    if (!(desc = bindings->descriptor_tables[index]))
-        return 0;
-
-    /* AMD, Nvidia and Intel drivers on Windows work if SetDescriptorHeaps()
-     * is not called, so we bind heaps from the tables instead. No NULL check is
-     * needed here because it's checked when descriptor tables are set. */
-    heap = d3d12_desc_get_descriptor_heap(desc);
-    offset = desc->index;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    if (heap->desc.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
-    {
-        if (*cbv_srv_uav_heap)
-        {
-            if (heap == *cbv_srv_uav_heap)
-                return offset;
-            /* This occurs occasionally in Rise of the Tomb Raider apparently due to a race
-             * condition (one of several), but adding a mutex for table updates has no effect. */
-            WARN("List %p uses descriptors from more than one CBV/SRV/UAV heap.\n", list);
-        }
-        *cbv_srv_uav_heap = heap;
-    }
-    else
-    {
-        if (*sampler_heap)
-        {
-            if (heap == *sampler_heap)
-                return offset;
-            WARN("List %p uses descriptors from more than one sampler heap.\n", list);
-        }
-        *sampler_heap = heap;
-    }
+    TRACE("iface %p.\n", iface);
 
-    return offset;
+    return list->type;
 }
 
-static void d3d12_command_list_update_descriptor_tables(struct d3d12_command_list *list,
-        struct vkd3d_pipeline_bindings *bindings, struct d3d12_descriptor_heap **cbv_srv_uav_heap,
-        struct d3d12_descriptor_heap **sampler_heap)
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_Close(ID3D12GraphicsCommandList2 *iface)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_root_signature *rs = bindings->root_signature;
-    unsigned int offsets[D3D12_MAX_ROOT_COST];
-    unsigned int i, j;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs;
+    struct vkd3d_command_stream *stream;
+    VkResult vr;
 
-    for (i = 0, j = 0; i < ARRAY_SIZE(bindings->descriptor_tables); ++i)
-    {
-        if (!(rs->descriptor_table_mask & ((uint64_t)1 << i)))
-            continue;
-        offsets[j++] = d3d12_command_list_bind_descriptor_table(list, bindings, i,
-                cbv_srv_uav_heap, sampler_heap);
-    }
-    if (j)
+    TRACE("iface %p.\n", iface);
+
+    if (!list->is_recording)
     {
-        VK_CALL(vkCmdPushConstants(list->vk_command_buffer, rs->vk_pipeline_layout, VK_SHADER_STAGE_ALL,
-                rs->descriptor_table_offset, j * sizeof(uint32_t), offsets));
+        WARN("Command list is not in the recording state.\n");
+        return E_FAIL;
     }
-}
 
-static void d3d12_command_list_bind_descriptor_heap(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, struct d3d12_descriptor_heap *heap)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_root_signature *rs = bindings->root_signature;
-    enum vkd3d_vk_descriptor_set_index set;
+    vk_procs = &list->device->vk_procs;
 
-    if (!heap)
-        return;
+    d3d12_command_list_end_current_render_pass(list);
+    d3d12_command_list_flush_pending_clears(list);
+    /* Discards are only hints, the contents are undefined either way. */
+    list->pending_discard_count = 0;
+    if (list->is_predicated)
+        VK_CALL(vkCmdEndConditionalRenderingEXT(d3d12_command_list_get_vk_command_buffer(list)));
+    d3d12_command_list_flush_stream(list);
 
-    if (heap->desc.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+    if (list->is_deferred && list->allocator)
     {
-        if (heap->serial_id == bindings->cbv_srv_uav_heap_id)
-            return;
-        bindings->cbv_srv_uav_heap_id = heap->serial_id;
+        stream = &list->allocator->command_stream;
+        TRACE("Recorded %u deferred commands, dropped %u.\n", stream->command_count, stream->dropped_command_count);
+        if (stream->collect_timings)
+            WARN("Recording draws and barriers took %"PRIu64" ns, translation took %"PRIu64" ns.\n",
+                    stream->record_time_ns, stream->translation_time_ns);
     }
-    else
+
+    if ((vr = VK_CALL(vkEndCommandBuffer(list->vk_command_buffer))) < 0)
     {
-        if (heap->serial_id == bindings->sampler_heap_id)
-            return;
-        bindings->sampler_heap_id = heap->serial_id;
+        WARN("Failed to end command buffer, vr %d.\n", vr);
+        return hresult_from_vk_result(vr);
     }
 
-    /* These sets can be shared across multiple command lists, and therefore binding must
-     * be synchronised. On an experimental branch in which caching of Vk descriptor writes
-     * greatly increased the chance of multiple threads arriving here at the same time,
-     * GRID 2019 crashed without the mutex lock. */
-    vkd3d_mutex_lock(&heap->vk_sets_mutex);
-
-    for (set = 0; set < ARRAY_SIZE(heap->vk_descriptor_sets); ++set)
+    if (list->allocator)
     {
-        VkDescriptorSet vk_descriptor_set = heap->vk_descriptor_sets[set].vk_set;
+        d3d12_command_allocator_free_command_buffer(list->allocator, list);
+        list->allocator = NULL;
+    }
 
-        if (!vk_descriptor_set)
-            continue;
+    list->is_recording = false;
 
-        VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, bindings->vk_bind_point, rs->vk_pipeline_layout,
-                rs->vk_set_count + set, 1, &vk_descriptor_set, 0, NULL));
+    if (!list->is_valid)
+    {
+        WARN("Error occurred during command list recording.\n");
+        return E_INVALIDARG;
     }
 
-    vkd3d_mutex_unlock(&heap->vk_sets_mutex);
+    return S_OK;
 }
 
-static void d3d12_command_list_update_heap_descriptors(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point)
+static void d3d12_command_list_reset_state(struct d3d12_command_list *list,
+        ID3D12PipelineState *initial_pipeline_state)
 {
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    struct d3d12_descriptor_heap *cbv_srv_uav_heap = NULL, *sampler_heap = NULL;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_root_signature *rs = bindings->root_signature;
+    ID3D12GraphicsCommandList2 *iface = &list->ID3D12GraphicsCommandList2_iface;
 
-    if (!rs)
-        return;
+    memset(list->strides, 0, sizeof(list->strides));
+    list->primitive_topology = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
 
-    if (bindings->descriptor_table_dirty_mask || bindings->push_descriptor_dirty_mask)
-        d3d12_command_list_prepare_descriptors(list, bind_point);
-    if (bindings->descriptor_table_dirty_mask)
-        d3d12_command_list_update_descriptor_tables(list, bindings, &cbv_srv_uav_heap, &sampler_heap);
-    bindings->descriptor_table_dirty_mask = 0;
+    list->index_buffer_format = DXGI_FORMAT_UNKNOWN;
 
-    d3d12_command_list_update_push_descriptors(list, bind_point);
+    memset(list->vertex_buffers, 0, sizeof(list->vertex_buffers));
+    memset(list->vertex_buffer_offsets, 0, sizeof(list->vertex_buffer_offsets));
+    list->vertex_buffer_dirty_mask = 0;
+    list->index_buffer = VK_NULL_HANDLE;
+    list->index_buffer_offset = 0;
+    list->index_type = VK_INDEX_TYPE_UINT16;
+    list->index_buffer_dirty = false;
 
-    if (bindings->descriptor_set_count)
-    {
-        VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, bindings->vk_bind_point, rs->vk_pipeline_layout,
-                rs->main_set, bindings->descriptor_set_count, bindings->descriptor_sets, 0, NULL));
-        bindings->in_use = true;
-    }
+    memset(list->rtvs, 0, sizeof(list->rtvs));
+    list->dsv = VK_NULL_HANDLE;
+    memset(list->rtv_resources, 0, sizeof(list->rtv_resources));
+    list->dsv_resource = NULL;
+    memset(list->rtv_views, 0, sizeof(list->rtv_views));
+    list->dsv_view = NULL;
+    list->dsv_format = VK_FORMAT_UNDEFINED;
+    list->fb_width = 0;
+    list->fb_height = 0;
+    list->fb_layer_count = 0;
 
-    d3d12_command_list_bind_descriptor_heap(list, bind_point, cbv_srv_uav_heap);
-    d3d12_command_list_bind_descriptor_heap(list, bind_point, sampler_heap);
-}
+    list->xfb_enabled = false;
 
-static bool d3d12_command_list_update_compute_state(struct d3d12_command_list *list)
-{
-    d3d12_command_list_end_current_render_pass(list);
+    list->is_predicated = false;
 
-    if (!d3d12_command_list_update_compute_pipeline(list))
-        return false;
+    list->is_deferred = !!(list->device->vkd3d_instance->config_flags & VKD3D_CONFIG_FLAG_DEFERRED_RECORDING);
+    if (list->allocator)
+        vkd3d_command_stream_reset_state(&list->allocator->command_stream);
 
-    list->update_descriptors(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE);
+    list->current_framebuffer = VK_NULL_HANDLE;
+    list->current_pipeline = VK_NULL_HANDLE;
+    list->pso_render_pass = VK_NULL_HANDLE;
+    list->current_render_pass = VK_NULL_HANDLE;
+    vkd3d_barrier_batch_clear(&list->barriers);
+    list->pending_clear_count = 0;
+    list->pending_discard_count = 0;
 
-    return true;
-}
+    vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE]);
+    vkd3d_pipeline_bindings_cleanup(&list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS]);
+    memset(list->pipeline_bindings, 0, sizeof(list->pipeline_bindings));
+    list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS].vk_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COMPUTE].vk_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
+    memset(list->descriptor_buffer_heaps, 0, sizeof(list->descriptor_buffer_heaps));
+    memset(list->descriptor_buffer_heap_ids, 0, sizeof(list->descriptor_buffer_heap_ids));
 
-static bool d3d12_command_list_begin_render_pass(struct d3d12_command_list *list)
-{
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    struct d3d12_graphics_pipeline_state *graphics;
-    struct VkRenderPassBeginInfo begin_desc;
-    VkRenderPass vk_render_pass;
+    list->state = NULL;
 
-    if (!d3d12_command_list_update_graphics_pipeline(list))
-        return false;
-    if (!d3d12_command_list_update_current_framebuffer(list))
-        return false;
-
-    list->update_descriptors(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS);
+    memset(list->so_counter_buffers, 0, sizeof(list->so_counter_buffers));
+    memset(list->so_counter_buffer_offsets, 0, sizeof(list->so_counter_buffer_offsets));
 
-    if (list->current_render_pass != VK_NULL_HANDLE)
-        return true;
+    ID3D12GraphicsCommandList2_SetPipelineState(iface, initial_pipeline_state);
+}
 
-    vk_render_pass = list->pso_render_pass;
-    assert(vk_render_pass);
+static HRESULT STDMETHODCALLTYPE d3d12_command_list_Reset(ID3D12GraphicsCommandList2 *iface,
+        ID3D12CommandAllocator *allocator, ID3D12PipelineState *initial_pipeline_state)
+{
+    struct d3d12_command_allocator *allocator_impl = unsafe_impl_from_ID3D12CommandAllocator(allocator);
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    HRESULT hr;
 
-    begin_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    begin_desc.pNext = NULL;
-    begin_desc.renderPass = vk_render_pass;
-    begin_desc.framebuffer = list->current_framebuffer;
-    begin_desc.renderArea.offset.x = 0;
-    begin_desc.renderArea.offset.y = 0;
-    d3d12_command_list_get_fb_extent(list,
-            &begin_desc.renderArea.extent.width, &begin_desc.renderArea.extent.height, NULL);
-    begin_desc.clearValueCount = 0;
-    begin_desc.pClearValues = NULL;
-    VK_CALL(vkCmdBeginRenderPass(list->vk_command_buffer, &begin_desc, VK_SUBPASS_CONTENTS_INLINE));
+    TRACE("iface %p, allocator %p, initial_pipeline_state %p.\n",
+            iface, allocator, initial_pipeline_state);
 
-    list->current_render_pass = vk_render_pass;
+    if (!allocator_impl)
+    {
+        WARN("Command allocator is NULL.\n");
+        return E_INVALIDARG;
+    }
 
-    graphics = &list->state->u.graphics;
-    if (graphics->xfb_enabled)
+    if (list->is_recording)
     {
-        VK_CALL(vkCmdBeginTransformFeedbackEXT(list->vk_command_buffer, 0, ARRAY_SIZE(list->so_counter_buffers),
-                list->so_counter_buffers, list->so_counter_buffer_offsets));
+        WARN("Command list is in the recording state.\n");
+        return E_FAIL;
+    }
 
-        list->xfb_enabled = true;
+    if (SUCCEEDED(hr = d3d12_command_allocator_allocate_command_buffer(allocator_impl, list)))
+    {
+        list->allocator = allocator_impl;
+        d3d12_command_list_reset_state(list, initial_pipeline_state);
     }
 
-    return true;
+    return hr;
 }
 
-static void d3d12_command_list_check_index_buffer_strip_cut_value(struct d3d12_command_list *list)
+static void STDMETHODCALLTYPE d3d12_command_list_ClearState(ID3D12GraphicsCommandList2 *iface,
+        ID3D12PipelineState *pipeline_state)
+{
+    FIXME("iface %p, pipline_state %p stub!\n", iface, pipeline_state);
+}
+
+static bool d3d12_command_list_has_depth_stencil_view(struct d3d12_command_list *list)
+{
+    struct d3d12_graphics_pipeline_state *graphics;
+
+    assert(d3d12_pipeline_state_is_graphics(list->state));
+    graphics = &list->state->u.graphics;
+
+    return graphics->dsv_format || (d3d12_pipeline_state_has_unknown_dsv_format(list->state) && list->dsv_format);
+}
+
+static void d3d12_command_list_get_fb_extent(struct d3d12_command_list *list,
+        uint32_t *width, uint32_t *height, uint32_t *layer_count)
 {
     struct d3d12_graphics_pipeline_state *graphics = &list->state->u.graphics;
+    struct d3d12_device *device = list->device;
 
-    /* In Vulkan, the strip cut value is derived from the index buffer format. */
-    switch (graphics->index_buffer_strip_cut_value)
+    if (graphics->rt_count || d3d12_command_list_has_depth_stencil_view(list))
     {
-        case D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF:
-            if (list->index_buffer_format != DXGI_FORMAT_R16_UINT)
-            {
-                FIXME_ONCE("Strip cut value 0xffff is not supported with index buffer format %#x.\n",
-                        list->index_buffer_format);
-            }
-            break;
+        *width = list->fb_width;
+        *height = list->fb_height;
+        if (layer_count)
+            *layer_count = list->fb_layer_count;
+    }
+    else
+    {
+        *width = device->vk_info.device_limits.maxFramebufferWidth;
+        *height = device->vk_info.device_limits.maxFramebufferHeight;
+        if (layer_count)
+            *layer_count = 1;
+    }
+}
 
-        case D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF:
-            if (list->index_buffer_format != DXGI_FORMAT_R32_UINT)
-            {
-                FIXME_ONCE("Strip cut value 0xffffffff is not supported with index buffer format %#x.\n",
-                        list->index_buffer_format);
-            }
-            break;
+struct vkd3d_framebuffer_entry
+{
+    struct vkd3d_framebuffer_entry *next;
+    uint32_t hash;
+    struct vkd3d_framebuffer_key key;
+    VkFramebuffer vk_framebuffer;
+};
 
-        default:
-            break;
-    }
+static uint32_t vkd3d_framebuffer_key_hash(const struct vkd3d_framebuffer_key *key)
+{
+    uint64_t hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, key, sizeof(*key));
+
+    return hash ^ (hash >> 32);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_DrawInstanced(ID3D12GraphicsCommandList2 *iface,
-        UINT vertex_count_per_instance, UINT instance_count, UINT start_vertex_location,
-        UINT start_instance_location)
+void vkd3d_framebuffer_cache_init(struct vkd3d_framebuffer_cache *cache)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
+    vkd3d_mutex_init(&cache->mutex);
+    memset(cache->buckets, 0, sizeof(cache->buckets));
+    cache->framebuffer_count = 0;
+}
 
-    TRACE("iface %p, vertex_count_per_instance %u, instance_count %u, "
-            "start_vertex_location %u, start_instance_location %u.\n",
-            iface, vertex_count_per_instance, instance_count,
-            start_vertex_location, start_instance_location);
+void vkd3d_framebuffer_cache_cleanup(struct vkd3d_framebuffer_cache *cache, struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_framebuffer_entry *entry, *next;
+    size_t i;
 
-    vk_procs = &list->device->vk_procs;
+    TRACE("Destroying %zu framebuffers.\n", cache->framebuffer_count);
 
-    if (!d3d12_command_list_begin_render_pass(list))
+    for (i = 0; i < ARRAY_SIZE(cache->buckets); ++i)
     {
-        WARN("Failed to begin render pass, ignoring draw call.\n");
-        return;
+        for (entry = cache->buckets[i]; entry; entry = next)
+        {
+            next = entry->next;
+            VK_CALL(vkDestroyFramebuffer(device->vk_device, entry->vk_framebuffer, NULL));
+            vkd3d_free(entry);
+        }
     }
 
-    VK_CALL(vkCmdDraw(list->vk_command_buffer, vertex_count_per_instance,
-            instance_count, start_vertex_location, start_instance_location));
+    vkd3d_mutex_destroy(&cache->mutex);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_DrawIndexedInstanced(ID3D12GraphicsCommandList2 *iface,
-        UINT index_count_per_instance, UINT instance_count, UINT start_vertex_location,
-        INT base_vertex_location, UINT start_instance_location)
+HRESULT vkd3d_framebuffer_cache_find(struct vkd3d_framebuffer_cache *cache, struct d3d12_device *device,
+        const struct vkd3d_framebuffer_key *key, VkFramebuffer *vk_framebuffer)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_framebuffer_entry **bucket, *entry;
+    struct VkFramebufferCreateInfo fb_desc;
+    uint32_t hash;
+    VkResult vr;
 
-    TRACE("iface %p, index_count_per_instance %u, instance_count %u, start_vertex_location %u, "
-            "base_vertex_location %d, start_instance_location %u.\n",
-            iface, index_count_per_instance, instance_count, start_vertex_location,
-            base_vertex_location, start_instance_location);
+    hash = vkd3d_framebuffer_key_hash(key);
+    bucket = &cache->buckets[hash % ARRAY_SIZE(cache->buckets)];
 
-    if (!d3d12_command_list_begin_render_pass(list))
+    vkd3d_mutex_lock(&cache->mutex);
+
+    for (entry = *bucket; entry; entry = entry->next)
     {
-        WARN("Failed to begin render pass, ignoring draw call.\n");
-        return;
+        if (entry->hash == hash && !memcmp(&entry->key, key, sizeof(*key)))
+        {
+            *vk_framebuffer = entry->vk_framebuffer;
+            vkd3d_mutex_unlock(&cache->mutex);
+            return S_OK;
+        }
     }
 
-    vk_procs = &list->device->vk_procs;
+    if (!(entry = vkd3d_malloc(sizeof(*entry))))
+    {
+        vkd3d_mutex_unlock(&cache->mutex);
+        return E_OUTOFMEMORY;
+    }
+
+    fb_desc.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fb_desc.pNext = NULL;
+    fb_desc.flags = 0;
+    fb_desc.renderPass = key->vk_render_pass;
+    fb_desc.attachmentCount = key->view_count;
+    fb_desc.pAttachments = key->views;
+    fb_desc.width = key->width;
+    fb_desc.height = key->height;
+    fb_desc.layers = key->layer_count;
+    if ((vr = VK_CALL(vkCreateFramebuffer(device->vk_device, &fb_desc, NULL, &entry->vk_framebuffer))) < 0)
+    {
+        WARN("Failed to create Vulkan framebuffer, vr %d.\n", vr);
+        vkd3d_mutex_unlock(&cache->mutex);
+        vkd3d_free(entry);
+        return hresult_from_vk_result(vr);
+    }
+
+    entry->hash = hash;
+    entry->key = *key;
+    entry->next = *bucket;
+    *bucket = entry;
+    ++cache->framebuffer_count;
 
-    d3d12_command_list_check_index_buffer_strip_cut_value(list);
+    *vk_framebuffer = entry->vk_framebuffer;
 
-    VK_CALL(vkCmdDrawIndexed(list->vk_command_buffer, index_count_per_instance,
-            instance_count, start_vertex_location, base_vertex_location, start_instance_location));
+    vkd3d_mutex_unlock(&cache->mutex);
+
+    return S_OK;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_Dispatch(ID3D12GraphicsCommandList2 *iface,
-        UINT x, UINT y, UINT z)
+/* Views are only destroyed once no command allocator references them, so
+ * command buffers using these framebuffers have completed execution. */
+void vkd3d_framebuffer_cache_remove_view(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, VkImageView vk_view)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_framebuffer_entry **entry, *current;
+    unsigned int j;
+    size_t i;
 
-    TRACE("iface %p, x %u, y %u, z %u.\n", iface, x, y, z);
+    vkd3d_mutex_lock(&cache->mutex);
 
-    if (!d3d12_command_list_update_compute_state(list))
+    for (i = 0; i < ARRAY_SIZE(cache->buckets) && cache->framebuffer_count; ++i)
     {
-        WARN("Failed to update compute state, ignoring dispatch.\n");
-        return;
-    }
+        for (entry = &cache->buckets[i]; (current = *entry);)
+        {
+            for (j = 0; j < current->key.view_count; ++j)
+            {
+                if (current->key.views[j] == vk_view)
+                    break;
+            }
 
-    vk_procs = &list->device->vk_procs;
+            if (j == current->key.view_count)
+            {
+                entry = &current->next;
+                continue;
+            }
+
+            *entry = current->next;
+            VK_CALL(vkDestroyFramebuffer(device->vk_device, current->vk_framebuffer, NULL));
+            vkd3d_free(current);
+            --cache->framebuffer_count;
+        }
+    }
 
-    VK_CALL(vkCmdDispatch(list->vk_command_buffer, x, y, z));
+    vkd3d_mutex_unlock(&cache->mutex);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_CopyBufferRegion(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *dst, UINT64 dst_offset, ID3D12Resource *src, UINT64 src_offset, UINT64 byte_count)
+static bool d3d12_command_list_update_current_framebuffer(struct d3d12_command_list *list)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *dst_resource, *src_resource;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkBufferCopy buffer_copy;
+    struct d3d12_graphics_pipeline_state *graphics;
+    struct vkd3d_framebuffer_key key;
+    VkFramebuffer vk_framebuffer;
+    unsigned int i;
+    HRESULT hr;
 
-    TRACE("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
-            "src_offset %#"PRIx64", byte_count %#"PRIx64".\n",
-            iface, dst, dst_offset, src, src_offset, byte_count);
+    if (list->current_framebuffer != VK_NULL_HANDLE)
+        return true;
 
-    vk_procs = &list->device->vk_procs;
+    graphics = &list->state->u.graphics;
 
-    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
-    assert(d3d12_resource_is_buffer(dst_resource));
-    src_resource = unsafe_impl_from_ID3D12Resource(src);
-    assert(d3d12_resource_is_buffer(src_resource));
+    memset(&key, 0, sizeof(key));
+    key.vk_render_pass = list->pso_render_pass;
 
-    d3d12_command_list_track_resource_usage(list, dst_resource);
-    d3d12_command_list_track_resource_usage(list, src_resource);
+    for (i = 0; i < graphics->rt_count; ++i)
+    {
+        if (graphics->null_attachment_mask & (1u << i))
+        {
+            if (list->rtvs[i])
+                WARN("Expected NULL RTV for attachment %u.\n", i);
+            continue;
+        }
 
-    d3d12_command_list_end_current_render_pass(list);
+        if (!list->rtvs[i])
+        {
+            FIXME("Invalid RTV for attachment %u.\n", i);
+            return false;
+        }
 
-    buffer_copy.srcOffset = src_offset;
-    buffer_copy.dstOffset = dst_offset;
-    buffer_copy.size = byte_count;
+        key.views[key.view_count++] = list->rtvs[i];
+    }
 
-    VK_CALL(vkCmdCopyBuffer(list->vk_command_buffer,
-            src_resource->u.vk_buffer, dst_resource->u.vk_buffer, 1, &buffer_copy));
-}
+    if (d3d12_command_list_has_depth_stencil_view(list))
+    {
+        if (!(key.views[key.view_count++] = list->dsv))
+        {
+            FIXME("Invalid DSV.\n");
+            return false;
+        }
+    }
 
-static void vk_image_subresource_layers_from_d3d12(VkImageSubresourceLayers *subresource,
-        const struct vkd3d_format *format, unsigned int sub_resource_idx, unsigned int miplevel_count)
-{
-    subresource->aspectMask = format->vk_aspect_mask;
-    subresource->mipLevel = sub_resource_idx % miplevel_count;
-    subresource->baseArrayLayer = sub_resource_idx / miplevel_count;
-    subresource->layerCount = 1;
+    d3d12_command_list_get_fb_extent(list, &key.width, &key.height, &key.layer_count);
+
+    if (FAILED(hr = vkd3d_framebuffer_cache_find(&list->device->framebuffer_cache,
+            list->device, &key, &vk_framebuffer)))
+    {
+        WARN("Failed to get framebuffer, hr %#x.\n", hr);
+        return false;
+    }
+
+    list->current_framebuffer = vk_framebuffer;
+
+    return true;
 }
 
-static void vk_extent_3d_from_d3d12_miplevel(VkExtent3D *extent,
-        const D3D12_RESOURCE_DESC *resource_desc, unsigned int miplevel_idx)
+static void d3d12_command_list_bind_pipeline(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, VkPipeline vk_pipeline)
 {
-    extent->width = d3d12_resource_desc_get_width(resource_desc, miplevel_idx);
-    extent->height = d3d12_resource_desc_get_height(resource_desc, miplevel_idx);
-    extent->depth = d3d12_resource_desc_get_depth(resource_desc, miplevel_idx);
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+
+    if (bindings->vk_pipeline == vk_pipeline)
+        return;
+
+    d3d12_command_list_cmd_bind_pipeline(list, bindings->vk_bind_point, vk_pipeline);
+    bindings->vk_pipeline = vk_pipeline;
 }
 
-static void vk_buffer_image_copy_from_d3d12(VkBufferImageCopy *copy,
-        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprint, unsigned int sub_resource_idx,
-        const D3D12_RESOURCE_DESC *image_desc, const struct vkd3d_format *format,
-        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+static bool d3d12_command_list_update_compute_pipeline(struct d3d12_command_list *list)
 {
-    copy->bufferOffset = footprint->Offset;
-    if (src_box)
+    if (list->current_pipeline != VK_NULL_HANDLE)
+        return true;
+
+    if (!d3d12_pipeline_state_is_compute(list->state))
     {
-        VkDeviceSize row_count = footprint->Footprint.Height / format->block_height;
-        copy->bufferOffset += vkd3d_format_get_data_offset(format, footprint->Footprint.RowPitch,
-                row_count * footprint->Footprint.RowPitch, src_box->left, src_box->top, src_box->front);
+        WARN("Pipeline state %p is not a compute pipeline.\n", list->state);
+        return false;
     }
-    copy->bufferRowLength = footprint->Footprint.RowPitch /
-            (format->byte_count * format->block_byte_count) * format->block_width;
-    copy->bufferImageHeight = footprint->Footprint.Height;
-    vk_image_subresource_layers_from_d3d12(&copy->imageSubresource,
-            format, sub_resource_idx, image_desc->MipLevels);
-    copy->imageOffset.x = dst_x;
-    copy->imageOffset.y = dst_y;
-    copy->imageOffset.z = dst_z;
 
-    vk_extent_3d_from_d3d12_miplevel(&copy->imageExtent, image_desc,
-            copy->imageSubresource.mipLevel);
-    copy->imageExtent.width -= copy->imageOffset.x;
-    copy->imageExtent.height -= copy->imageOffset.y;
-    copy->imageExtent.depth -= copy->imageOffset.z;
+    d3d12_command_list_bind_pipeline(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE, list->state->u.compute.vk_pipeline);
+    list->current_pipeline = list->state->u.compute.vk_pipeline;
 
-    if (src_box)
+    return true;
+}
+
+static bool d3d12_command_list_update_graphics_pipeline(struct d3d12_command_list *list)
+{
+    VkRenderPass vk_render_pass;
+    VkPipeline vk_pipeline;
+
+    if (list->current_pipeline != VK_NULL_HANDLE)
+        return true;
+
+    if (!d3d12_pipeline_state_is_graphics(list->state))
     {
-        copy->imageExtent.width = min(copy->imageExtent.width, src_box->right - src_box->left);
-        copy->imageExtent.height = min(copy->imageExtent.height, src_box->bottom - src_box->top);
-        copy->imageExtent.depth = min(copy->imageExtent.depth, src_box->back - src_box->front);
+        WARN("Pipeline state %p is not a graphics pipeline.\n", list->state);
+        return false;
     }
-    else
+
+    if (!(vk_pipeline = d3d12_pipeline_state_get_or_create_pipeline(list->state,
+            list->primitive_topology, list->strides, list->dsv_format, &vk_render_pass)))
+        return false;
+
+    /* The render pass cache ensures that we use the same Vulkan render pass
+     * object for compatible render passes. */
+    if (list->pso_render_pass != vk_render_pass)
     {
-        copy->imageExtent.width = min(copy->imageExtent.width, footprint->Footprint.Width);
-        copy->imageExtent.height = min(copy->imageExtent.height, footprint->Footprint.Height);
-        copy->imageExtent.depth = min(copy->imageExtent.depth, footprint->Footprint.Depth);
+        list->pso_render_pass = vk_render_pass;
+        d3d12_command_list_invalidate_current_framebuffer(list);
+        d3d12_command_list_invalidate_current_render_pass(list);
     }
+
+    d3d12_command_list_bind_pipeline(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS, vk_pipeline);
+    list->current_pipeline = vk_pipeline;
+
+    return true;
 }
 
-static void vk_image_buffer_copy_from_d3d12(VkBufferImageCopy *copy,
-        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprint, unsigned int sub_resource_idx,
-        const D3D12_RESOURCE_DESC *image_desc, const struct vkd3d_format *format,
-        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+static void d3d12_command_list_prepare_descriptors(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
 {
-    VkDeviceSize row_count = footprint->Footprint.Height / format->block_height;
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    unsigned int variable_binding_size, unbounded_offset, table_index, heap_size, i;
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    const struct d3d12_descriptor_set_layout *layout;
+    const struct d3d12_desc *base_descriptor;
+    VkDescriptorSet vk_descriptor_set;
 
-    copy->bufferOffset = footprint->Offset + vkd3d_format_get_data_offset(format,
-            footprint->Footprint.RowPitch, row_count * footprint->Footprint.RowPitch, dst_x, dst_y, dst_z);
-    copy->bufferRowLength = footprint->Footprint.RowPitch /
-            (format->byte_count * format->block_byte_count) * format->block_width;
-    copy->bufferImageHeight = footprint->Footprint.Height;
-    vk_image_subresource_layers_from_d3d12(&copy->imageSubresource,
-            format, sub_resource_idx, image_desc->MipLevels);
-    copy->imageOffset.x = src_box ? src_box->left : 0;
-    copy->imageOffset.y = src_box ? src_box->top : 0;
-    copy->imageOffset.z = src_box ? src_box->front : 0;
-    if (src_box)
+#ifdef VK_EXT_descriptor_buffer
+    /* With descriptor buffers the main set holds only static samplers, which
+     * are embedded in its layout. */
+    if (list->device->use_descriptor_buffers)
     {
-        copy->imageExtent.width = src_box->right - src_box->left;
-        copy->imageExtent.height = src_box->bottom - src_box->top;
-        copy->imageExtent.depth = src_box->back - src_box->front;
+        const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+
+        if (root_signature->main_set < root_signature->vk_set_count)
+            VK_CALL(vkCmdBindDescriptorBufferEmbeddedSamplersEXT(d3d12_command_list_get_vk_command_buffer(list),
+                    bindings->vk_bind_point,
+                    root_signature->vk_pipeline_layout, root_signature->main_set));
+        return;
     }
-    else
+#endif
+
+    if (bindings->descriptor_set_count && !bindings->in_use)
+        return;
+
+    /* We cannot modify bound descriptor sets. We need a new descriptor set if
+     * we are about to update resource bindings.
+     *
+     * The Vulkan spec says:
+     *
+     *   "The descriptor set contents bound by a call to
+     *   vkCmdBindDescriptorSets may be consumed during host execution of the
+     *   command, or during shader execution of the resulting draws, or any
+     *   time in between. Thus, the contents must not be altered (overwritten
+     *   by an update command, or freed) between when the command is recorded
+     *   and when the command completes executing on the queue."
+     */
+    bindings->descriptor_set_count = 0;
+    for (i = root_signature->main_set; i < root_signature->vk_set_count; ++i)
     {
-        unsigned int miplevel = copy->imageSubresource.mipLevel;
-        vk_extent_3d_from_d3d12_miplevel(&copy->imageExtent, image_desc, miplevel);
+        layout = &root_signature->descriptor_set_layouts[i];
+        unbounded_offset = layout->unbounded_offset;
+        table_index = layout->table_index;
+        variable_binding_size = 0;
+
+        if (unbounded_offset != UINT_MAX
+                /* Descriptors may not be set, eg. WoW. */
+                && (base_descriptor = bindings->descriptor_tables[table_index]))
+        {
+            heap_size = d3d12_desc_heap_range_size(base_descriptor);
+
+            if (heap_size < unbounded_offset)
+                WARN("Descriptor heap size %u is less than the offset %u of an unbounded range in table %u, "
+                        "vk set %u.\n", heap_size, unbounded_offset, table_index, i);
+            else
+                variable_binding_size = heap_size - unbounded_offset;
+        }
+
+        vk_descriptor_set = d3d12_command_allocator_allocate_descriptor_set(list->allocator,
+                layout->vk_layout, variable_binding_size, unbounded_offset != UINT_MAX);
+        bindings->descriptor_sets[bindings->descriptor_set_count++] = vk_descriptor_set;
     }
+
+    bindings->in_use = false;
+
+    bindings->descriptor_table_dirty_mask |= bindings->descriptor_table_active_mask & root_signature->descriptor_table_mask;
+    bindings->push_descriptor_dirty_mask |= bindings->push_descriptor_active_mask & root_signature->push_descriptor_mask;
 }
 
-static void vk_image_copy_from_d3d12(VkImageCopy *image_copy,
-        unsigned int src_sub_resource_idx, unsigned int dst_sub_resource_idx,
-        const D3D12_RESOURCE_DESC *src_desc, const D3D12_RESOURCE_DESC *dst_desc,
-        const struct vkd3d_format *src_format, const struct vkd3d_format *dst_format,
-        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+static bool vk_write_descriptor_set_from_d3d12_desc(VkWriteDescriptorSet *vk_descriptor_write,
+        const struct d3d12_desc *descriptor, const struct d3d12_root_descriptor_table_range *range,
+        VkDescriptorSet *vk_descriptor_sets, unsigned int index, bool use_array)
 {
-    vk_image_subresource_layers_from_d3d12(&image_copy->srcSubresource,
-            src_format, src_sub_resource_idx, src_desc->MipLevels);
-    image_copy->srcOffset.x = src_box ? src_box->left : 0;
-    image_copy->srcOffset.y = src_box ? src_box->top : 0;
-    image_copy->srcOffset.z = src_box ? src_box->front : 0;
-    vk_image_subresource_layers_from_d3d12(&image_copy->dstSubresource,
-            dst_format, dst_sub_resource_idx, dst_desc->MipLevels);
-    image_copy->dstOffset.x = dst_x;
-    image_copy->dstOffset.y = dst_y;
-    image_copy->dstOffset.z = dst_z;
-    if (src_box)
+    uint32_t descriptor_range_magic = range->descriptor_magic;
+    const struct vkd3d_view *view = descriptor->s.u.view_info.view;
+    uint32_t vk_binding = range->binding;
+    uint32_t set = range->set;
+
+    if (descriptor->s.magic != descriptor_range_magic)
+        return false;
+
+    vk_descriptor_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vk_descriptor_write->pNext = NULL;
+    vk_descriptor_write->dstSet = vk_descriptor_sets[set];
+    vk_descriptor_write->dstBinding = use_array ? vk_binding : vk_binding + index;
+    vk_descriptor_write->dstArrayElement = use_array ? index : 0;
+    vk_descriptor_write->descriptorCount = 1;
+    vk_descriptor_write->descriptorType = descriptor->s.vk_descriptor_type;
+    vk_descriptor_write->pImageInfo = NULL;
+    vk_descriptor_write->pBufferInfo = NULL;
+    vk_descriptor_write->pTexelBufferView = NULL;
+
+    switch (descriptor->s.magic)
     {
-        image_copy->extent.width = src_box->right - src_box->left;
-        image_copy->extent.height = src_box->bottom - src_box->top;
-        image_copy->extent.depth = src_box->back - src_box->front;
+        case VKD3D_DESCRIPTOR_MAGIC_CBV:
+            vk_descriptor_write->pBufferInfo = &descriptor->s.u.vk_cbv_info;
+            break;
+
+        case VKD3D_DESCRIPTOR_MAGIC_SRV:
+        case VKD3D_DESCRIPTOR_MAGIC_UAV:
+            /* We use separate bindings for buffer and texture SRVs/UAVs.
+             * See d3d12_root_signature_init(). For unbounded ranges the
+             * descriptors exist in two consecutive sets, otherwise they occur
+             * in pairs in one set. */
+            if (range->descriptor_count == UINT_MAX)
+            {
+                if (descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                        && descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+                {
+                    vk_descriptor_write->dstSet = vk_descriptor_sets[set + 1];
+                    vk_descriptor_write->dstBinding = 0;
+                }
+            }
+            else
+            {
+                if (!use_array)
+                    vk_descriptor_write->dstBinding = vk_binding + 2 * index;
+                if (descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                        && descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+                    ++vk_descriptor_write->dstBinding;
+            }
+
+            if (descriptor->s.vk_descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+                    || descriptor->s.vk_descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+            {
+                vk_descriptor_write->pTexelBufferView = &view->u.vk_buffer_view;
+            }
+            else
+            {
+                vk_descriptor_write->pImageInfo = &descriptor->s.u.view_info.vk_image_info;
+            }
+            break;
+
+        case VKD3D_DESCRIPTOR_MAGIC_SAMPLER:
+            vk_descriptor_write->pImageInfo = &descriptor->s.u.view_info.vk_image_info;
+            break;
+
+        default:
+            ERR("Invalid descriptor %#x.\n", descriptor->s.magic);
+            return false;
     }
-    else
+
+    return true;
+}
+
+static void d3d12_command_list_track_uav_counter(struct d3d12_command_list *list,
+        struct vkd3d_pipeline_bindings *bindings, const struct d3d12_root_descriptor_table_range *range,
+        unsigned int index, const struct d3d12_desc *descriptor)
+{
+    const struct d3d12_pipeline_state *state = list->state;
+    unsigned int register_idx = range->base_register_idx + index;
+    VkBufferView vk_counter_view;
+    unsigned int k;
+
+    for (k = 0; k < state->uav_counters.binding_count; ++k)
     {
-        unsigned int miplevel = image_copy->srcSubresource.mipLevel;
-        vk_extent_3d_from_d3d12_miplevel(&image_copy->extent, src_desc, miplevel);
+        if (state->uav_counters.bindings[k].register_space == range->register_space
+                && state->uav_counters.bindings[k].register_index == register_idx)
+        {
+            vk_counter_view = descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_UAV
+                    ? descriptor->s.u.view_info.view->vk_counter_view : VK_NULL_HANDLE;
+            if (bindings->vk_uav_counter_views[k] != vk_counter_view)
+                bindings->uav_counters_dirty = true;
+            bindings->vk_uav_counter_views[k] = vk_counter_view;
+            break;
+        }
     }
 }
 
-static HRESULT d3d12_command_list_allocate_transfer_buffer(struct d3d12_command_list *list,
-        VkDeviceSize size, struct vkd3d_buffer *buffer)
+static bool d3d12_desc_matches_template_range(const struct d3d12_desc *descriptor,
+        const struct d3d12_root_descriptor_table_range *range)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    struct d3d12_device *device = list->device;
-    D3D12_HEAP_PROPERTIES heap_properties;
-    D3D12_RESOURCE_DESC buffer_desc;
-    HRESULT hr;
+    if (descriptor->s.magic != range->descriptor_magic)
+        return false;
 
-    memset(&heap_properties, 0, sizeof(heap_properties));
-    heap_properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    /* Templates write SRVs and UAVs to the image binding. */
+    return descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+            && descriptor->s.vk_descriptor_type != VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+}
 
-    buffer_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    buffer_desc.Alignment = 0;
-    buffer_desc.Width = size;
-    buffer_desc.Height = 1;
-    buffer_desc.DepthOrArraySize = 1;
-    buffer_desc.MipLevels = 1;
-    buffer_desc.Format = DXGI_FORMAT_UNKNOWN;
+/* Write the whole table with a single template update, reading descriptor
+ * data straight from the heap. Returns false if the table contains
+ * descriptors the template cannot express; UAV counter tracking is
+ * idempotent, so the caller can simply fall back to individual writes. */
+static bool d3d12_command_list_update_descriptor_table_with_template(struct d3d12_command_list *list,
+        struct vkd3d_pipeline_bindings *bindings, const struct d3d12_root_descriptor_table *descriptor_table,
+        const struct d3d12_desc *base_descriptor)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct d3d12_root_descriptor_table_range *range;
+    const struct d3d12_desc *descriptor;
+    unsigned int i, j;
+
+    for (i = 0; i < descriptor_table->range_count; ++i)
+    {
+        range = &descriptor_table->ranges[i];
+        descriptor = base_descriptor + range->offset;
+
+        for (j = 0; j < range->descriptor_count; ++j, ++descriptor)
+        {
+            if (range->descriptor_magic == VKD3D_DESCRIPTOR_MAGIC_UAV)
+                d3d12_command_list_track_uav_counter(list, bindings, range, j, descriptor);
+            if (!d3d12_desc_matches_template_range(descriptor, range))
+                return false;
+        }
+    }
+
+    VK_CALL(vkUpdateDescriptorSetWithTemplateKHR(list->device->vk_device,
+            bindings->descriptor_sets[descriptor_table->ranges[0].set], descriptor_table->vk_template,
+            base_descriptor));
+
+    return true;
+}
+
+static void d3d12_command_list_update_descriptor_table(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, struct d3d12_desc *base_descriptor)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    struct VkWriteDescriptorSet descriptor_writes[24], *current_descriptor_write;
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct d3d12_root_descriptor_table *descriptor_table;
+    const struct d3d12_root_descriptor_table_range *range;
+    VkDevice vk_device = list->device->vk_device;
+    unsigned int i, j, descriptor_count;
+    struct d3d12_desc *descriptor;
+    unsigned int write_count = 0;
+    bool unbounded = false;
+
+    descriptor_table = root_signature_get_descriptor_table(root_signature, index);
+
+    if (descriptor_table->vk_template && d3d12_command_list_update_descriptor_table_with_template(list,
+            bindings, descriptor_table, base_descriptor))
+        return;
+
+    current_descriptor_write = descriptor_writes;
+    for (i = 0; i < descriptor_table->range_count; ++i)
+    {
+        range = &descriptor_table->ranges[i];
+
+        /* The first unbounded range of each type is written until the heap end is reached. Do not repeat. */
+        if (unbounded && i && range->type == descriptor_table->ranges[i - 1].type)
+            continue;
+
+        descriptor = base_descriptor + range->offset;
+
+        descriptor_count = range->descriptor_count;
+        if ((unbounded = descriptor_count == UINT_MAX))
+        {
+            descriptor_count = d3d12_desc_heap_range_size(descriptor);
+
+            if (descriptor_count > range->vk_binding_count)
+            {
+                ERR("Heap descriptor count %u exceeds maximum Vulkan count %u. Reducing to the Vulkan maximum.\n",
+                        descriptor_count, range->vk_binding_count);
+                descriptor_count = range->vk_binding_count;
+            }
+        }
+
+        for (j = 0; j < descriptor_count; ++j, ++descriptor)
+        {
+            if (range->descriptor_magic == VKD3D_DESCRIPTOR_MAGIC_UAV)
+                d3d12_command_list_track_uav_counter(list, bindings, range, j, descriptor);
+
+            /* Not all descriptors are necessarily populated if the range is unbounded. */
+            if (descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE)
+                continue;
+
+            if (!vk_write_descriptor_set_from_d3d12_desc(current_descriptor_write, descriptor, range,
+                    bindings->descriptor_sets, j, root_signature->use_descriptor_arrays))
+                continue;
+
+            ++write_count;
+            ++current_descriptor_write;
+
+            if (write_count == ARRAY_SIZE(descriptor_writes))
+            {
+                VK_CALL(vkUpdateDescriptorSets(vk_device, write_count, descriptor_writes, 0, NULL));
+                write_count = 0;
+                current_descriptor_write = descriptor_writes;
+            }
+        }
+    }
+
+    VK_CALL(vkUpdateDescriptorSets(vk_device, write_count, descriptor_writes, 0, NULL));
+}
+
+static bool vk_write_descriptor_set_from_root_descriptor(VkWriteDescriptorSet *vk_descriptor_write,
+        const struct d3d12_root_parameter *root_parameter, VkDescriptorSet vk_descriptor_set,
+        VkBufferView *vk_buffer_view, const VkDescriptorBufferInfo *vk_buffer_info)
+{
+    const struct d3d12_root_descriptor *root_descriptor;
+
+    switch (root_parameter->parameter_type)
+    {
+        case D3D12_ROOT_PARAMETER_TYPE_CBV:
+            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_SRV:
+            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_UAV:
+            vk_descriptor_write->descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+            break;
+        default:
+            ERR("Invalid root descriptor %#x.\n", root_parameter->parameter_type);
+            return false;
+    }
+
+    root_descriptor = &root_parameter->u.descriptor;
+
+    vk_descriptor_write->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    vk_descriptor_write->pNext = NULL;
+    vk_descriptor_write->dstSet = vk_descriptor_set;
+    vk_descriptor_write->dstBinding = root_descriptor->binding;
+    vk_descriptor_write->dstArrayElement = 0;
+    vk_descriptor_write->descriptorCount = 1;
+    vk_descriptor_write->pImageInfo = NULL;
+    vk_descriptor_write->pBufferInfo = vk_buffer_info;
+    vk_descriptor_write->pTexelBufferView = vk_buffer_view;
+
+    return true;
+}
+
+static void d3d12_command_list_update_push_descriptors(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    VkWriteDescriptorSet *descriptor_writes = NULL, *current_descriptor_write;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    VkDescriptorBufferInfo *buffer_infos = NULL, *current_buffer_info;
+    const struct d3d12_root_parameter *root_parameter;
+    struct vkd3d_push_descriptor *push_descriptor;
+    struct d3d12_device *device = list->device;
+    VkDescriptorBufferInfo *vk_buffer_info;
+    unsigned int i, descriptor_count;
+    VkBufferView *vk_buffer_view;
+
+    if (!bindings->push_descriptor_dirty_mask)
+        return;
+
+    descriptor_count = vkd3d_popcount(bindings->push_descriptor_dirty_mask);
+
+    if (!(descriptor_writes = vkd3d_calloc(descriptor_count, sizeof(*descriptor_writes))))
+        return;
+    if (!(buffer_infos = vkd3d_calloc(descriptor_count, sizeof(*buffer_infos))))
+        goto done;
+
+    descriptor_count = 0;
+    current_buffer_info = buffer_infos;
+    current_descriptor_write = descriptor_writes;
+    for (i = 0; i < ARRAY_SIZE(bindings->push_descriptors); ++i)
+    {
+        if (!(bindings->push_descriptor_dirty_mask & (1u << i)))
+            continue;
+
+        root_parameter = root_signature_get_root_descriptor(root_signature, i);
+        push_descriptor = &bindings->push_descriptors[i];
+
+        if (root_parameter->parameter_type == D3D12_ROOT_PARAMETER_TYPE_CBV)
+        {
+            vk_buffer_view = NULL;
+            vk_buffer_info = current_buffer_info;
+            vk_buffer_info->buffer = push_descriptor->u.cbv.vk_buffer;
+            vk_buffer_info->offset = push_descriptor->u.cbv.offset;
+            vk_buffer_info->range = VK_WHOLE_SIZE;
+        }
+        else
+        {
+            vk_buffer_view = &push_descriptor->u.vk_buffer_view;
+            vk_buffer_info = NULL;
+        }
+
+        if (!vk_write_descriptor_set_from_root_descriptor(current_descriptor_write,
+                root_parameter, bindings->descriptor_sets[0], vk_buffer_view, vk_buffer_info))
+            continue;
+
+        ++descriptor_count;
+        ++current_descriptor_write;
+        ++current_buffer_info;
+    }
+
+    VK_CALL(vkUpdateDescriptorSets(device->vk_device, descriptor_count, descriptor_writes, 0, NULL));
+    bindings->push_descriptor_dirty_mask = 0;
+
+done:
+    vkd3d_free(descriptor_writes);
+    vkd3d_free(buffer_infos);
+}
+
+static void d3d12_command_list_update_uav_counter_descriptors(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct d3d12_pipeline_state *state = list->state;
+    VkDevice vk_device = list->device->vk_device;
+    VkWriteDescriptorSet *vk_descriptor_writes;
+    VkDescriptorSet vk_descriptor_set;
+    unsigned int uav_counter_count;
+    unsigned int i;
+
+    if (!state || !bindings->uav_counters_dirty)
+        return;
+
+    uav_counter_count = state->uav_counters.binding_count;
+    if (!(vk_descriptor_writes = vkd3d_calloc(uav_counter_count, sizeof(*vk_descriptor_writes))))
+        return;
+    if (!(vk_descriptor_set = d3d12_command_allocator_allocate_descriptor_set(
+            list->allocator, state->uav_counters.vk_set_layout, 0, false)))
+        goto done;
+
+    for (i = 0; i < uav_counter_count; ++i)
+    {
+        const struct vkd3d_shader_uav_counter_binding *uav_counter = &state->uav_counters.bindings[i];
+        const VkBufferView *vk_uav_counter_views = bindings->vk_uav_counter_views;
+
+        assert(vk_uav_counter_views[i]);
+
+        vk_descriptor_writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        vk_descriptor_writes[i].pNext = NULL;
+        vk_descriptor_writes[i].dstSet = vk_descriptor_set;
+        vk_descriptor_writes[i].dstBinding = uav_counter->binding.binding;
+        vk_descriptor_writes[i].dstArrayElement = 0;
+        vk_descriptor_writes[i].descriptorCount = 1;
+        vk_descriptor_writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+        vk_descriptor_writes[i].pImageInfo = NULL;
+        vk_descriptor_writes[i].pBufferInfo = NULL;
+        vk_descriptor_writes[i].pTexelBufferView = &vk_uav_counter_views[i];
+    }
+
+    VK_CALL(vkUpdateDescriptorSets(vk_device, uav_counter_count, vk_descriptor_writes, 0, NULL));
+
+    d3d12_command_list_cmd_bind_descriptor_sets(list, bindings->vk_bind_point,
+            state->uav_counters.vk_pipeline_layout, state->uav_counters.set_index, 1, &vk_descriptor_set, 0, NULL);
+
+    bindings->uav_counters_dirty = false;
+
+done:
+    vkd3d_free(vk_descriptor_writes);
+}
+
+static void d3d12_command_list_update_descriptors(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+    struct d3d12_desc *base_descriptor;
+    unsigned int i;
+
+    if (!rs || !rs->vk_set_count)
+        return;
+
+    if (bindings->descriptor_table_dirty_mask || bindings->push_descriptor_dirty_mask)
+        d3d12_command_list_prepare_descriptors(list, bind_point);
+
+    for (i = 0; i < ARRAY_SIZE(bindings->descriptor_tables); ++i)
+    {
+        if (bindings->descriptor_table_dirty_mask & ((uint64_t)1 << i))
+        {
+            if ((base_descriptor = bindings->descriptor_tables[i]))
+                d3d12_command_list_update_descriptor_table(list, bind_point, i, base_descriptor);
+            else
+                WARN("Descriptor table %u is not set.\n", i);
+        }
+    }
+    bindings->descriptor_table_dirty_mask = 0;
+
+    d3d12_command_list_update_push_descriptors(list, bind_point);
+
+    if (bindings->descriptor_set_count)
+    {
+        d3d12_command_list_cmd_bind_descriptor_sets(list, bindings->vk_bind_point,
+                rs->vk_pipeline_layout, rs->main_set, bindings->descriptor_set_count, bindings->descriptor_sets,
+                0, NULL);
+        bindings->in_use = true;
+    }
+
+    d3d12_command_list_update_uav_counter_descriptors(list, bind_point);
+}
+
+static unsigned int d3d12_command_list_bind_descriptor_table(struct d3d12_command_list *list,
+        struct vkd3d_pipeline_bindings *bindings, unsigned int index,
+        struct d3d12_descriptor_heap **cbv_srv_uav_heap, struct d3d12_descriptor_heap **sampler_heap)
+{
+    struct d3d12_descriptor_heap *heap;
+    const struct d3d12_desc *desc;
+    unsigned int offset;
+
+    if (!(desc = bindings->descriptor_tables[index]))
+        return 0;
+
+    /* AMD, Nvidia and Intel drivers on Windows work if SetDescriptorHeaps()
+     * is not called, so we bind heaps from the tables instead. No NULL check is
+     * needed here because it's checked when descriptor tables are set. */
+    heap = d3d12_desc_get_descriptor_heap(desc);
+    offset = desc->index;
+
+    if (heap->desc.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+    {
+        if (*cbv_srv_uav_heap)
+        {
+            if (heap == *cbv_srv_uav_heap)
+                return offset;
+            /* This occurs occasionally in Rise of the Tomb Raider apparently due to a race
+             * condition (one of several), but adding a mutex for table updates has no effect. */
+            WARN("List %p uses descriptors from more than one CBV/SRV/UAV heap.\n", list);
+        }
+        *cbv_srv_uav_heap = heap;
+    }
+    else
+    {
+        if (*sampler_heap)
+        {
+            if (heap == *sampler_heap)
+                return offset;
+            WARN("List %p uses descriptors from more than one sampler heap.\n", list);
+        }
+        *sampler_heap = heap;
+    }
+
+    return offset;
+}
+
+static void d3d12_command_list_update_descriptor_tables(struct d3d12_command_list *list,
+        struct vkd3d_pipeline_bindings *bindings, struct d3d12_descriptor_heap **cbv_srv_uav_heap,
+        struct d3d12_descriptor_heap **sampler_heap)
+{
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+    unsigned int offsets[D3D12_MAX_ROOT_COST];
+    unsigned int i, j;
+
+    for (i = 0, j = 0; i < ARRAY_SIZE(bindings->descriptor_tables); ++i)
+    {
+        if (!(rs->descriptor_table_mask & ((uint64_t)1 << i)))
+            continue;
+        offsets[j++] = d3d12_command_list_bind_descriptor_table(list, bindings, i,
+                cbv_srv_uav_heap, sampler_heap);
+    }
+    if (j)
+    {
+        d3d12_command_list_cmd_push_constants(list, rs->vk_pipeline_layout, VK_SHADER_STAGE_ALL,
+                rs->descriptor_table_offset, j * sizeof(uint32_t), offsets);
+    }
+}
+
+static void d3d12_command_list_bind_descriptor_heap(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, struct d3d12_descriptor_heap *heap)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+    enum vkd3d_vk_descriptor_set_index set;
+
+    if (!heap)
+        return;
+
+    if (heap->desc.Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+    {
+        if (heap->serial_id == bindings->cbv_srv_uav_heap_id)
+            return;
+        bindings->cbv_srv_uav_heap_id = heap->serial_id;
+    }
+    else
+    {
+        if (heap->serial_id == bindings->sampler_heap_id)
+            return;
+        bindings->sampler_heap_id = heap->serial_id;
+    }
+
+    /* These sets can be shared across multiple command lists, and therefore binding must
+     * be synchronised. On an experimental branch in which caching of Vk descriptor writes
+     * greatly increased the chance of multiple threads arriving here at the same time,
+     * GRID 2019 crashed without the mutex lock. */
+    vkd3d_mutex_lock(&heap->vk_sets_mutex);
+
+    for (set = 0; set < ARRAY_SIZE(heap->vk_descriptor_sets); ++set)
+    {
+        VkDescriptorSet vk_descriptor_set = heap->vk_descriptor_sets[set].vk_set;
+
+        if (!vk_descriptor_set)
+            continue;
+
+        d3d12_command_list_cmd_bind_descriptor_sets(list, bindings->vk_bind_point, rs->vk_pipeline_layout,
+                rs->vk_set_count + set, 1, &vk_descriptor_set, 0, NULL);
+    }
+
+    vkd3d_mutex_unlock(&heap->vk_sets_mutex);
+}
+
+#ifdef VK_EXT_descriptor_buffer
+static void d3d12_command_list_set_descriptor_buffer_offsets(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, const struct d3d12_descriptor_heap *heap)
+{
+    const struct vkd3d_vk_descriptor_heap_layout *layouts = list->device->vk_descriptor_heap_layouts;
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+    enum vkd3d_vk_descriptor_set_index set;
+    uint32_t buffer_index;
+
+    buffer_index = list->descriptor_buffer_indices[heap->desc.Type];
+    for (set = 0; set < VKD3D_SET_INDEX_COUNT; ++set)
+    {
+        if (layouts[set].applicable_heap_type != heap->desc.Type)
+            continue;
+        VK_CALL(vkCmdSetDescriptorBufferOffsetsEXT(d3d12_command_list_get_vk_command_buffer(list),
+                bindings->vk_bind_point,
+                rs->vk_pipeline_layout, rs->vk_set_count + set, 1, &buffer_index,
+                &heap->descriptor_buffer.set_offsets[set]));
+    }
+}
+
+/* Descriptor buffer equivalent of d3d12_command_list_bind_descriptor_heap(). */
+static void d3d12_command_list_bind_descriptor_buffers(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, const struct d3d12_descriptor_heap *cbv_srv_uav_heap,
+        const struct d3d12_descriptor_heap *sampler_heap)
+{
+    VkDescriptorBufferBindingInfoEXT binding_infos[ARRAY_SIZE(list->descriptor_buffer_heaps)];
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct d3d12_descriptor_heap *heaps[ARRAY_SIZE(list->descriptor_buffer_heaps)];
+    const struct d3d12_descriptor_heap *heap;
+    unsigned int i, count;
+    uint64_t *heap_id;
+    bool rebind = false;
+
+    heaps[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = cbv_srv_uav_heap;
+    heaps[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER] = sampler_heap;
+
+    for (i = 0; i < ARRAY_SIZE(heaps); ++i)
+    {
+        if (!(heap = heaps[i]) || heap->serial_id == list->descriptor_buffer_heap_ids[i])
+            continue;
+        if (!heap->descriptor_buffer.vk_buffer)
+        {
+            WARN("Descriptor heap %p is not shader visible.\n", heap);
+            continue;
+        }
+        list->descriptor_buffer_heaps[i] = heap;
+        list->descriptor_buffer_heap_ids[i] = heap->serial_id;
+        rebind = true;
+    }
+
+    if (rebind)
+    {
+        for (i = 0, count = 0; i < ARRAY_SIZE(list->descriptor_buffer_heaps); ++i)
+        {
+            if (!(heap = list->descriptor_buffer_heaps[i]))
+                continue;
+            binding_infos[count].sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+            binding_infos[count].pNext = NULL;
+            binding_infos[count].address = heap->descriptor_buffer.vk_address;
+            binding_infos[count].usage = (i == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)
+                    ? VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+                    : VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT;
+            list->descriptor_buffer_indices[i] = count++;
+        }
+        VK_CALL(vkCmdBindDescriptorBuffersEXT(d3d12_command_list_get_vk_command_buffer(list), count, binding_infos));
+
+        /* Offsets refer to buffer binding indices, which may have changed. */
+        for (i = 0; i < ARRAY_SIZE(list->pipeline_bindings); ++i)
+        {
+            if (i != bind_point)
+                d3d12_command_list_invalidate_root_parameters(list, i);
+        }
+        bindings->cbv_srv_uav_heap_id = 0;
+        bindings->sampler_heap_id = 0;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(list->descriptor_buffer_heaps); ++i)
+    {
+        if (!(heap = list->descriptor_buffer_heaps[i]))
+            continue;
+        heap_id = (i == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) ? &bindings->sampler_heap_id
+                : &bindings->cbv_srv_uav_heap_id;
+        if (heap->serial_id == *heap_id)
+            continue;
+        *heap_id = heap->serial_id;
+        d3d12_command_list_set_descriptor_buffer_offsets(list, bind_point, heap);
+    }
+}
+#endif
+
+static void d3d12_command_list_update_heap_descriptors(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    struct d3d12_descriptor_heap *cbv_srv_uav_heap = NULL, *sampler_heap = NULL;
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+
+    if (!rs)
+        return;
+
+    if (bindings->descriptor_table_dirty_mask || bindings->push_descriptor_dirty_mask)
+        d3d12_command_list_prepare_descriptors(list, bind_point);
+    if (bindings->descriptor_table_dirty_mask)
+        d3d12_command_list_update_descriptor_tables(list, bindings, &cbv_srv_uav_heap, &sampler_heap);
+    bindings->descriptor_table_dirty_mask = 0;
+
+    d3d12_command_list_update_push_descriptors(list, bind_point);
+
+    if (bindings->descriptor_set_count)
+    {
+        d3d12_command_list_cmd_bind_descriptor_sets(list, bindings->vk_bind_point, rs->vk_pipeline_layout,
+                rs->main_set, bindings->descriptor_set_count, bindings->descriptor_sets, 0, NULL);
+        bindings->in_use = true;
+    }
+
+#ifdef VK_EXT_descriptor_buffer
+    if (list->device->use_descriptor_buffers)
+    {
+        d3d12_command_list_bind_descriptor_buffers(list, bind_point, cbv_srv_uav_heap, sampler_heap);
+        return;
+    }
+#endif
+
+    d3d12_command_list_bind_descriptor_heap(list, bind_point, cbv_srv_uav_heap);
+    d3d12_command_list_bind_descriptor_heap(list, bind_point, sampler_heap);
+}
+
+/* Push constants are shared by all pipeline bind points in Vulkan, so pushing
+ * values for one bind point clobbers the root constants of the others. */
+static void d3d12_command_list_invalidate_push_constants(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point except)
+{
+    struct vkd3d_pipeline_bindings *bindings;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(list->pipeline_bindings); ++i)
+    {
+        bindings = &list->pipeline_bindings[i];
+        if (i != except)
+            bindings->push_constant_dirty_mask = bindings->push_constant_valid_mask;
+    }
+}
+
+static void d3d12_command_list_flush_root_constants(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *rs = bindings->root_signature;
+    const VkPushConstantRange *range;
+    unsigned int i, j, first, last;
+    bool pushed = false;
+
+    if (!rs || !bindings->push_constant_dirty_mask)
+        return;
+
+    /* Changed values are coalesced within each push constant range. A single
+     * update may not span ranges with different stages. */
+    for (i = 0; i < rs->push_constant_range_count; ++i)
+    {
+        range = &rs->push_constant_ranges[i];
+        first = ~0u;
+        last = 0;
+        for (j = range->offset / sizeof(uint32_t); j < (range->offset + range->size) / sizeof(uint32_t)
+                && j < ARRAY_SIZE(bindings->push_constants); ++j)
+        {
+            if (!(bindings->push_constant_dirty_mask & ((uint64_t)1 << j)))
+                continue;
+            first = min(first, j);
+            last = j;
+        }
+        if (first > last)
+            continue;
+
+        d3d12_command_list_cmd_push_constants(list, rs->vk_pipeline_layout, range->stageFlags,
+                first * sizeof(uint32_t), (last - first + 1) * sizeof(uint32_t), &bindings->push_constants[first]);
+        pushed = true;
+    }
+    bindings->push_constant_dirty_mask = 0;
+
+    if (pushed)
+        d3d12_command_list_invalidate_push_constants(list, bind_point);
+}
+
+static void d3d12_command_list_flush_vertex_input(struct d3d12_command_list *list)
+{
+    unsigned int i, count;
+
+    /* Adjacent changed bindings are recorded with a single command. */
+    for (i = 0; list->vertex_buffer_dirty_mask && i < ARRAY_SIZE(list->vertex_buffers); ++i)
+    {
+        if (!(list->vertex_buffer_dirty_mask & (1u << i)))
+            continue;
+
+        for (count = 1; i + count < ARRAY_SIZE(list->vertex_buffers)
+                && (list->vertex_buffer_dirty_mask & (1u << (i + count))); ++count)
+            ;
+        d3d12_command_list_cmd_bind_vertex_buffers(list, i, count,
+                &list->vertex_buffers[i], &list->vertex_buffer_offsets[i]);
+        i += count;
+    }
+    list->vertex_buffer_dirty_mask = 0;
+
+    if (list->index_buffer_dirty)
+    {
+        d3d12_command_list_cmd_bind_index_buffer(list, list->index_buffer,
+                list->index_buffer_offset, list->index_type);
+        list->index_buffer_dirty = false;
+    }
+}
+
+static bool d3d12_command_list_update_compute_state(struct d3d12_command_list *list)
+{
+    d3d12_command_list_end_current_render_pass(list);
+
+    if (!d3d12_command_list_update_compute_pipeline(list))
+        return false;
+
+    list->update_descriptors(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE);
+    d3d12_command_list_flush_root_constants(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE);
+
+    return true;
+}
+
+/* The load op only clears the render area, and only the framebuffer layers. */
+static bool vkd3d_pending_clear_covers_fb(const struct vkd3d_pending_clear *clear,
+        uint32_t width, uint32_t height, uint32_t layer_count)
+{
+    return clear->width == width && clear->height == height && clear->layer_count == layer_count;
+}
+
+/* Folds pending clears and discards of the bound attachments into the load
+ * ops of the render pass about to begin. Returns the render pass to use. */
+static VkRenderPass d3d12_command_list_consume_pending_load_ops(struct d3d12_command_list *list,
+        VkClearValue *clear_values, uint32_t *clear_value_count)
+{
+    struct vkd3d_pending_clear consumed[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
+    struct d3d12_graphics_pipeline_state *graphics = &list->state->u.graphics;
+    unsigned int i, attachment_idx, dsv_idx, consumed_count = 0;
+    uint32_t width, height, layer_count, clear_mask = 0, discard_mask = 0;
+    const struct vkd3d_pending_discard *discard;
+    const struct vkd3d_pending_clear *clear;
+    VkRenderPass vk_render_pass;
+    bool has_dsv, is_bound;
+    size_t j;
+    HRESULT hr;
+
+    *clear_value_count = 0;
+
+    if (!list->pending_clear_count && !list->pending_discard_count)
+        return list->pso_render_pass;
+
+    d3d12_command_list_get_fb_extent(list, &width, &height, &layer_count);
+    has_dsv = d3d12_command_list_has_depth_stencil_view(list);
+    for (i = 0, dsv_idx = 0; i < graphics->rt_count; ++i)
+    {
+        if (!(graphics->null_attachment_mask & (1u << i)))
+            ++dsv_idx;
+    }
+
+    /* Iterate backwards, removal moves the last entry into the current slot. */
+    for (j = list->pending_clear_count; j--;)
+    {
+        clear = &list->pending_clears[j];
+        is_bound = false;
+
+        for (i = 0, attachment_idx = 0; i < graphics->rt_count; ++i)
+        {
+            if (graphics->null_attachment_mask & (1u << i))
+                continue;
+
+            if (list->rtv_resources[i] == clear->resource)
+            {
+                is_bound = true;
+                if (list->rtv_views[i] == clear->view
+                        && vkd3d_pending_clear_covers_fb(clear, width, height, layer_count))
+                {
+                    clear_values[attachment_idx] = clear->value;
+                    *clear_value_count = max(*clear_value_count, attachment_idx + 1);
+                    clear_mask |= 1u << i;
+                    consumed[consumed_count++] = *clear;
+                    d3d12_command_list_remove_pending_clear(list, j);
+                    clear = NULL;
+                }
+                break;
+            }
+
+            ++attachment_idx;
+        }
+
+        if (clear && !is_bound && has_dsv && list->dsv_resource == clear->resource)
+        {
+            is_bound = true;
+            if (list->dsv_view == clear->view && vkd3d_pending_clear_covers_fb(clear, width, height, layer_count))
+            {
+                clear_values[dsv_idx] = clear->value;
+                *clear_value_count = dsv_idx + 1;
+                if (clear->aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                    clear_mask |= VKD3D_RENDER_PASS_DEPTH_BIT;
+                if (clear->aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT)
+                    clear_mask |= VKD3D_RENDER_PASS_STENCIL_BIT;
+                consumed[consumed_count++] = *clear;
+                d3d12_command_list_remove_pending_clear(list, j);
+                clear = NULL;
+            }
+        }
+
+        /* A different view of a bound resource, or a render area which
+         * doesn't cover the whole view. */
+        if (clear && is_bound)
+        {
+            d3d12_command_list_emit_clear(list, clear, 0, NULL);
+            d3d12_command_list_remove_pending_clear(list, j);
+        }
+    }
+
+    /* Discards of bound resources are consumed either way. Those which don't
+     * cover the bound view are dropped, since discarding is only a hint. */
+    for (j = list->pending_discard_count; j--;)
+    {
+        discard = &list->pending_discards[j];
+        is_bound = false;
+
+        for (i = 0; i < graphics->rt_count; ++i)
+        {
+            if (graphics->null_attachment_mask & (1u << i) || list->rtv_resources[i] != discard->resource)
+                continue;
+
+            is_bound = true;
+            if (!(clear_mask & (1u << i)) && vkd3d_pending_discard_covers_view(discard, list->rtv_views[i]))
+                discard_mask |= 1u << i;
+        }
+
+        if (has_dsv && list->dsv_resource == discard->resource)
+        {
+            is_bound = true;
+            if (vkd3d_pending_discard_covers_view(discard, list->dsv_view))
+                discard_mask |= (VKD3D_RENDER_PASS_DEPTH_BIT | VKD3D_RENDER_PASS_STENCIL_BIT) & ~clear_mask;
+        }
+
+        if (is_bound)
+            d3d12_command_list_remove_pending_discard(list, j);
+    }
+
+    if (!clear_mask && !discard_mask)
+        return list->pso_render_pass;
+
+    if (FAILED(hr = d3d12_pipeline_state_get_render_pass_variant(list->state,
+            list->dsv_format, clear_mask, discard_mask, &vk_render_pass)))
+    {
+        WARN("Failed to get render pass variant, hr %#x.\n", hr);
+        for (i = 0; i < consumed_count; ++i)
+            d3d12_command_list_emit_clear(list, &consumed[i], 0, NULL);
+        *clear_value_count = 0;
+        return list->pso_render_pass;
+    }
+
+    TRACE("Folded %u clears into render pass, discard mask %#x.\n", consumed_count, discard_mask);
+
+    return vk_render_pass;
+}
+
+static bool d3d12_command_list_begin_render_pass(struct d3d12_command_list *list)
+{
+    VkClearValue clear_values[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct d3d12_graphics_pipeline_state *graphics;
+    struct VkRenderPassBeginInfo begin_desc;
+    VkRenderPass vk_render_pass;
+
+    if (!d3d12_command_list_update_graphics_pipeline(list))
+        return false;
+    if (!d3d12_command_list_update_current_framebuffer(list))
+        return false;
+
+    list->update_descriptors(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS);
+    d3d12_command_list_flush_root_constants(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS);
+    d3d12_command_list_flush_vertex_input(list);
+
+    if (list->current_render_pass != VK_NULL_HANDLE)
+        return true;
+
+    assert(list->pso_render_pass);
+    vk_render_pass = d3d12_command_list_consume_pending_load_ops(list, clear_values, &begin_desc.clearValueCount);
+
+    begin_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    begin_desc.pNext = NULL;
+    begin_desc.renderPass = vk_render_pass;
+    begin_desc.framebuffer = list->current_framebuffer;
+    begin_desc.renderArea.offset.x = 0;
+    begin_desc.renderArea.offset.y = 0;
+    d3d12_command_list_get_fb_extent(list,
+            &begin_desc.renderArea.extent.width, &begin_desc.renderArea.extent.height, NULL);
+    begin_desc.pClearValues = begin_desc.clearValueCount ? clear_values : NULL;
+    d3d12_command_list_flush_barriers(list);
+    d3d12_command_list_cmd_begin_render_pass(list, &begin_desc);
+
+    list->current_render_pass = vk_render_pass;
+
+    graphics = &list->state->u.graphics;
+    if (graphics->xfb_enabled)
+    {
+        VK_CALL(vkCmdBeginTransformFeedbackEXT(d3d12_command_list_get_vk_command_buffer(list),
+                0, ARRAY_SIZE(list->so_counter_buffers),
+                list->so_counter_buffers, list->so_counter_buffer_offsets));
+
+        list->xfb_enabled = true;
+    }
+
+    return true;
+}
+
+static void d3d12_command_list_check_index_buffer_strip_cut_value(struct d3d12_command_list *list)
+{
+    struct d3d12_graphics_pipeline_state *graphics = &list->state->u.graphics;
+
+    /* In Vulkan, the strip cut value is derived from the index buffer format. */
+    switch (graphics->index_buffer_strip_cut_value)
+    {
+        case D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF:
+            if (list->index_buffer_format != DXGI_FORMAT_R16_UINT)
+            {
+                FIXME_ONCE("Strip cut value 0xffff is not supported with index buffer format %#x.\n",
+                        list->index_buffer_format);
+            }
+            break;
+
+        case D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF:
+            if (list->index_buffer_format != DXGI_FORMAT_R32_UINT)
+            {
+                FIXME_ONCE("Strip cut value 0xffffffff is not supported with index buffer format %#x.\n",
+                        list->index_buffer_format);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_DrawInstanced(ID3D12GraphicsCommandList2 *iface,
+        UINT vertex_count_per_instance, UINT instance_count, UINT start_vertex_location,
+        UINT start_instance_location)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct vkd3d_record_timer timer;
+
+    TRACE("iface %p, vertex_count_per_instance %u, instance_count %u, "
+            "start_vertex_location %u, start_instance_location %u.\n",
+            iface, vertex_count_per_instance, instance_count,
+            start_vertex_location, start_instance_location);
+
+    d3d12_command_list_begin_record_timing(list, &timer);
+
+    if (!d3d12_command_list_begin_render_pass(list))
+    {
+        WARN("Failed to begin render pass, ignoring draw call.\n");
+    }
+    else
+    {
+        d3d12_command_list_cmd_draw(list, vertex_count_per_instance,
+                instance_count, start_vertex_location, start_instance_location);
+    }
+
+    d3d12_command_list_end_record_timing(list, &timer);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_DrawIndexedInstanced(ID3D12GraphicsCommandList2 *iface,
+        UINT index_count_per_instance, UINT instance_count, UINT start_vertex_location,
+        INT base_vertex_location, UINT start_instance_location)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct vkd3d_record_timer timer;
+
+    TRACE("iface %p, index_count_per_instance %u, instance_count %u, start_vertex_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, index_count_per_instance, instance_count, start_vertex_location,
+            base_vertex_location, start_instance_location);
+
+    d3d12_command_list_begin_record_timing(list, &timer);
+
+    if (!d3d12_command_list_begin_render_pass(list))
+    {
+        WARN("Failed to begin render pass, ignoring draw call.\n");
+    }
+    else
+    {
+        d3d12_command_list_check_index_buffer_strip_cut_value(list);
+
+        d3d12_command_list_cmd_draw_indexed(list, index_count_per_instance,
+                instance_count, start_vertex_location, base_vertex_location, start_instance_location);
+    }
+
+    d3d12_command_list_end_record_timing(list, &timer);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_Dispatch(ID3D12GraphicsCommandList2 *iface,
+        UINT x, UINT y, UINT z)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs;
+
+    TRACE("iface %p, x %u, y %u, z %u.\n", iface, x, y, z);
+
+    if (!d3d12_command_list_update_compute_state(list))
+    {
+        WARN("Failed to update compute state, ignoring dispatch.\n");
+        return;
+    }
+
+    vk_procs = &list->device->vk_procs;
+
+    VK_CALL(vkCmdDispatch(d3d12_command_list_get_vk_command_buffer(list), x, y, z));
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_CopyBufferRegion(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, UINT64 dst_offset, ID3D12Resource *src, UINT64 src_offset, UINT64 byte_count)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *dst_resource, *src_resource;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    VkBufferCopy buffer_copy;
+
+    TRACE("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
+            "src_offset %#"PRIx64", byte_count %#"PRIx64".\n",
+            iface, dst, dst_offset, src, src_offset, byte_count);
+
+    vk_procs = &list->device->vk_procs;
+
+    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
+    assert(d3d12_resource_is_buffer(dst_resource));
+    src_resource = unsafe_impl_from_ID3D12Resource(src);
+    assert(d3d12_resource_is_buffer(src_resource));
+
+    d3d12_command_list_track_resource_usage(list, dst_resource);
+    d3d12_command_list_track_resource_usage(list, src_resource);
+
+    d3d12_command_list_end_current_render_pass(list);
+
+    buffer_copy.srcOffset = src_offset;
+    buffer_copy.dstOffset = dst_offset;
+    buffer_copy.size = byte_count;
+
+    VK_CALL(vkCmdCopyBuffer(d3d12_command_list_get_vk_command_buffer(list),
+            src_resource->u.vk_buffer, dst_resource->u.vk_buffer, 1, &buffer_copy));
+}
+
+static void vk_image_subresource_layers_from_d3d12(VkImageSubresourceLayers *subresource,
+        const struct vkd3d_format *format, unsigned int sub_resource_idx, unsigned int miplevel_count)
+{
+    subresource->aspectMask = format->vk_aspect_mask;
+    subresource->mipLevel = sub_resource_idx % miplevel_count;
+    subresource->baseArrayLayer = sub_resource_idx / miplevel_count;
+    subresource->layerCount = 1;
+}
+
+static void vk_extent_3d_from_d3d12_miplevel(VkExtent3D *extent,
+        const D3D12_RESOURCE_DESC *resource_desc, unsigned int miplevel_idx)
+{
+    extent->width = d3d12_resource_desc_get_width(resource_desc, miplevel_idx);
+    extent->height = d3d12_resource_desc_get_height(resource_desc, miplevel_idx);
+    extent->depth = d3d12_resource_desc_get_depth(resource_desc, miplevel_idx);
+}
+
+static void vk_buffer_image_copy_from_d3d12(VkBufferImageCopy *copy,
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprint, unsigned int sub_resource_idx,
+        const D3D12_RESOURCE_DESC *image_desc, const struct vkd3d_format *format,
+        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+{
+    copy->bufferOffset = footprint->Offset;
+    if (src_box)
+    {
+        VkDeviceSize row_count = footprint->Footprint.Height / format->block_height;
+        copy->bufferOffset += vkd3d_format_get_data_offset(format, footprint->Footprint.RowPitch,
+                row_count * footprint->Footprint.RowPitch, src_box->left, src_box->top, src_box->front);
+    }
+    copy->bufferRowLength = footprint->Footprint.RowPitch /
+            (format->byte_count * format->block_byte_count) * format->block_width;
+    copy->bufferImageHeight = footprint->Footprint.Height;
+    vk_image_subresource_layers_from_d3d12(&copy->imageSubresource,
+            format, sub_resource_idx, image_desc->MipLevels);
+    copy->imageOffset.x = dst_x;
+    copy->imageOffset.y = dst_y;
+    copy->imageOffset.z = dst_z;
+
+    vk_extent_3d_from_d3d12_miplevel(&copy->imageExtent, image_desc,
+            copy->imageSubresource.mipLevel);
+    copy->imageExtent.width -= copy->imageOffset.x;
+    copy->imageExtent.height -= copy->imageOffset.y;
+    copy->imageExtent.depth -= copy->imageOffset.z;
+
+    if (src_box)
+    {
+        copy->imageExtent.width = min(copy->imageExtent.width, src_box->right - src_box->left);
+        copy->imageExtent.height = min(copy->imageExtent.height, src_box->bottom - src_box->top);
+        copy->imageExtent.depth = min(copy->imageExtent.depth, src_box->back - src_box->front);
+    }
+    else
+    {
+        copy->imageExtent.width = min(copy->imageExtent.width, footprint->Footprint.Width);
+        copy->imageExtent.height = min(copy->imageExtent.height, footprint->Footprint.Height);
+        copy->imageExtent.depth = min(copy->imageExtent.depth, footprint->Footprint.Depth);
+    }
+}
+
+static void vk_image_buffer_copy_from_d3d12(VkBufferImageCopy *copy,
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT *footprint, unsigned int sub_resource_idx,
+        const D3D12_RESOURCE_DESC *image_desc, const struct vkd3d_format *format,
+        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+{
+    VkDeviceSize row_count = footprint->Footprint.Height / format->block_height;
+
+    copy->bufferOffset = footprint->Offset + vkd3d_format_get_data_offset(format,
+            footprint->Footprint.RowPitch, row_count * footprint->Footprint.RowPitch, dst_x, dst_y, dst_z);
+    copy->bufferRowLength = footprint->Footprint.RowPitch /
+            (format->byte_count * format->block_byte_count) * format->block_width;
+    copy->bufferImageHeight = footprint->Footprint.Height;
+    vk_image_subresource_layers_from_d3d12(&copy->imageSubresource,
+            format, sub_resource_idx, image_desc->MipLevels);
+    copy->imageOffset.x = src_box ? src_box->left : 0;
+    copy->imageOffset.y = src_box ? src_box->top : 0;
+    copy->imageOffset.z = src_box ? src_box->front : 0;
+    if (src_box)
+    {
+        copy->imageExtent.width = src_box->right - src_box->left;
+        copy->imageExtent.height = src_box->bottom - src_box->top;
+        copy->imageExtent.depth = src_box->back - src_box->front;
+    }
+    else
+    {
+        unsigned int miplevel = copy->imageSubresource.mipLevel;
+        vk_extent_3d_from_d3d12_miplevel(&copy->imageExtent, image_desc, miplevel);
+    }
+}
+
+static void vk_image_copy_from_d3d12(VkImageCopy *image_copy,
+        unsigned int src_sub_resource_idx, unsigned int dst_sub_resource_idx,
+        const D3D12_RESOURCE_DESC *src_desc, const D3D12_RESOURCE_DESC *dst_desc,
+        const struct vkd3d_format *src_format, const struct vkd3d_format *dst_format,
+        const D3D12_BOX *src_box, unsigned int dst_x, unsigned int dst_y, unsigned int dst_z)
+{
+    vk_image_subresource_layers_from_d3d12(&image_copy->srcSubresource,
+            src_format, src_sub_resource_idx, src_desc->MipLevels);
+    image_copy->srcOffset.x = src_box ? src_box->left : 0;
+    image_copy->srcOffset.y = src_box ? src_box->top : 0;
+    image_copy->srcOffset.z = src_box ? src_box->front : 0;
+    vk_image_subresource_layers_from_d3d12(&image_copy->dstSubresource,
+            dst_format, dst_sub_resource_idx, dst_desc->MipLevels);
+    image_copy->dstOffset.x = dst_x;
+    image_copy->dstOffset.y = dst_y;
+    image_copy->dstOffset.z = dst_z;
+    if (src_box)
+    {
+        image_copy->extent.width = src_box->right - src_box->left;
+        image_copy->extent.height = src_box->bottom - src_box->top;
+        image_copy->extent.depth = src_box->back - src_box->front;
+    }
+    else
+    {
+        unsigned int miplevel = image_copy->srcSubresource.mipLevel;
+        vk_extent_3d_from_d3d12_miplevel(&image_copy->extent, src_desc, miplevel);
+    }
+}
+
+static HRESULT d3d12_command_list_create_transfer_buffer(struct d3d12_command_list *list,
+        VkDeviceSize size, struct vkd3d_buffer *buffer)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    struct d3d12_device *device = list->device;
+    D3D12_HEAP_PROPERTIES heap_properties;
+    D3D12_RESOURCE_DESC buffer_desc;
+    HRESULT hr;
+
+    memset(&heap_properties, 0, sizeof(heap_properties));
+    heap_properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+    buffer_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    buffer_desc.Alignment = 0;
+    buffer_desc.Width = size;
+    buffer_desc.Height = 1;
+    buffer_desc.DepthOrArraySize = 1;
+    buffer_desc.MipLevels = 1;
+    buffer_desc.Format = DXGI_FORMAT_UNKNOWN;
     buffer_desc.SampleDesc.Count = 1;
     buffer_desc.SampleDesc.Quality = 0;
     buffer_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
     buffer_desc.Flags = D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
 
-    if (FAILED(hr = vkd3d_create_buffer(device, &heap_properties, D3D12_HEAP_FLAG_NONE,
-            &buffer_desc, &buffer->vk_buffer)))
-        return hr;
-    if (FAILED(hr = vkd3d_allocate_buffer_memory(device, buffer->vk_buffer,
-            &heap_properties, D3D12_HEAP_FLAG_NONE, &buffer->vk_memory, NULL, NULL)))
+    if (FAILED(hr = vkd3d_create_buffer(device, &heap_properties, D3D12_HEAP_FLAG_NONE,
+            &buffer_desc, &buffer->vk_buffer)))
+        return hr;
+    if (FAILED(hr = vkd3d_allocate_buffer_memory(device, buffer->vk_buffer,
+            &heap_properties, D3D12_HEAP_FLAG_NONE, NULL, &buffer->vk_memory, NULL, NULL)))
+    {
+        VK_CALL(vkDestroyBuffer(device->vk_device, buffer->vk_buffer, NULL));
+        return hr;
+    }
+    buffer->size = size;
+
+    return S_OK;
+}
+
+/* Transfer memory is handed out linearly from the allocator's transfer
+ * buffers, which are recycled as a whole when the allocator is reset. */
+static HRESULT d3d12_command_list_allocate_transfer_buffer(struct d3d12_command_list *list,
+        VkDeviceSize size, VkDeviceSize alignment, VkBuffer *vk_buffer, VkDeviceSize *offset)
+{
+    struct d3d12_command_allocator *allocator = list->allocator;
+    struct vkd3d_buffer *buffer, new_buffer;
+    VkDeviceSize start;
+    HRESULT hr;
+
+    for (; allocator->transfer_buffer_idx < allocator->transfer_buffer_count; ++allocator->transfer_buffer_idx)
+    {
+        buffer = &allocator->transfer_buffers[allocator->transfer_buffer_idx];
+        start = align(allocator->transfer_buffer_offset, alignment);
+        if (start <= buffer->size && size <= buffer->size - start)
+        {
+            allocator->transfer_buffer_offset = start + size;
+            *vk_buffer = buffer->vk_buffer;
+            *offset = start;
+            return S_OK;
+        }
+        allocator->transfer_buffer_offset = 0;
+    }
+
+    if (!vkd3d_array_reserve((void **)&allocator->transfer_buffers, &allocator->transfer_buffers_size,
+            allocator->transfer_buffer_count + 1, sizeof(*allocator->transfer_buffers)))
+    {
+        ERR("Failed to add transfer buffer.\n");
+        return E_OUTOFMEMORY;
+    }
+
+    if (FAILED(hr = d3d12_command_list_create_transfer_buffer(list,
+            max(size, list->device->transfer_buffer_size), &new_buffer)))
+        return hr;
+
+    TRACE("Created transfer buffer of size %#"PRIx64".\n", new_buffer.size);
+
+    allocator->transfer_buffer_idx = allocator->transfer_buffer_count;
+    allocator->transfer_buffers[allocator->transfer_buffer_count++] = new_buffer;
+    allocator->transfer_buffer_offset = size;
+    *vk_buffer = new_buffer.vk_buffer;
+    *offset = 0;
+
+    return S_OK;
+}
+
+/* In Vulkan, each depth/stencil format is only compatible with itself.
+ * This means that we are not allowed to copy texture regions directly between
+ * depth/stencil and color formats.
+ *
+ * FIXME: Implement color <-> depth/stencil blits in shaders.
+ */
+static void d3d12_command_list_copy_incompatible_texture_region(struct d3d12_command_list *list,
+        struct d3d12_resource *dst_resource, unsigned int dst_sub_resource_idx,
+        const struct vkd3d_format *dst_format, struct d3d12_resource *src_resource,
+        unsigned int src_sub_resource_idx, const struct vkd3d_format *src_format)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const D3D12_RESOURCE_DESC *dst_desc = &dst_resource->desc;
+    const D3D12_RESOURCE_DESC *src_desc = &src_resource->desc;
+    unsigned int dst_miplevel_idx, src_miplevel_idx;
+    VkBufferImageCopy buffer_image_copy;
+    VkBufferMemoryBarrier vk_barrier;
+    VkDeviceSize buffer_size, alignment;
+    VkBuffer vk_buffer;
+    HRESULT hr;
+
+    WARN("Copying incompatible texture formats %#x, %#x -> %#x, %#x.\n",
+            src_format->dxgi_format, src_format->vk_format,
+            dst_format->dxgi_format, dst_format->vk_format);
+
+    assert(d3d12_resource_is_texture(dst_resource));
+    assert(d3d12_resource_is_texture(src_resource));
+    assert(!vkd3d_format_is_compressed(dst_format));
+    assert(!vkd3d_format_is_compressed(src_format));
+    assert(dst_format->byte_count == src_format->byte_count);
+
+    buffer_image_copy.bufferRowLength = 0;
+    buffer_image_copy.bufferImageHeight = 0;
+    vk_image_subresource_layers_from_d3d12(&buffer_image_copy.imageSubresource,
+            src_format, src_sub_resource_idx, src_desc->MipLevels);
+    src_miplevel_idx = buffer_image_copy.imageSubresource.mipLevel;
+    buffer_image_copy.imageOffset.x = 0;
+    buffer_image_copy.imageOffset.y = 0;
+    buffer_image_copy.imageOffset.z = 0;
+    vk_extent_3d_from_d3d12_miplevel(&buffer_image_copy.imageExtent, src_desc, src_miplevel_idx);
+
+    buffer_size = src_format->byte_count * buffer_image_copy.imageExtent.width *
+            buffer_image_copy.imageExtent.height * buffer_image_copy.imageExtent.depth;
+    /* The buffer offset must be a multiple of both 4 and the texel size.
+     * Depth/stencil texel sizes are powers of two, so the larger of the two
+     * is enough. */
+    alignment = max(max(4, src_format->byte_count),
+            list->device->vk_info.device_limits.optimalBufferCopyOffsetAlignment);
+    if (FAILED(hr = d3d12_command_list_allocate_transfer_buffer(list, buffer_size,
+            alignment, &vk_buffer, &buffer_image_copy.bufferOffset)))
+    {
+        ERR("Failed to allocate transfer buffer, hr %#x.\n", hr);
+        return;
+    }
+
+    VK_CALL(vkCmdCopyImageToBuffer(d3d12_command_list_get_vk_command_buffer(list),
+            src_resource->u.vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            vk_buffer, 1, &buffer_image_copy));
+
+    vk_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    vk_barrier.pNext = NULL;
+    vk_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vk_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    vk_barrier.buffer = vk_buffer;
+    vk_barrier.offset = buffer_image_copy.bufferOffset;
+    vk_barrier.size = buffer_size;
+    d3d12_command_list_cmd_pipeline_barrier(list,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, NULL, 1, &vk_barrier, 0, NULL);
+
+    vk_image_subresource_layers_from_d3d12(&buffer_image_copy.imageSubresource,
+            dst_format, dst_sub_resource_idx, dst_desc->MipLevels);
+    dst_miplevel_idx = buffer_image_copy.imageSubresource.mipLevel;
+
+    assert(d3d12_resource_desc_get_width(src_desc, src_miplevel_idx) ==
+            d3d12_resource_desc_get_width(dst_desc, dst_miplevel_idx));
+    assert(d3d12_resource_desc_get_height(src_desc, src_miplevel_idx) ==
+            d3d12_resource_desc_get_height(dst_desc, dst_miplevel_idx));
+    assert(d3d12_resource_desc_get_depth(src_desc, src_miplevel_idx) ==
+            d3d12_resource_desc_get_depth(dst_desc, dst_miplevel_idx));
+
+    VK_CALL(vkCmdCopyBufferToImage(d3d12_command_list_get_vk_command_buffer(list),
+            vk_buffer, dst_resource->u.vk_image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &buffer_image_copy));
+}
+
+static bool validate_d3d12_box(const D3D12_BOX *box)
+{
+    return box->right > box->left
+            && box->bottom > box->top
+            && box->back > box->front;
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_CopyTextureRegion(ID3D12GraphicsCommandList2 *iface,
+        const D3D12_TEXTURE_COPY_LOCATION *dst, UINT dst_x, UINT dst_y, UINT dst_z,
+        const D3D12_TEXTURE_COPY_LOCATION *src, const D3D12_BOX *src_box)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *dst_resource, *src_resource;
+    const struct vkd3d_format *src_format, *dst_format;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    VkBufferImageCopy buffer_image_copy;
+    VkImageCopy image_copy;
+
+    TRACE("iface %p, dst %p, dst_x %u, dst_y %u, dst_z %u, src %p, src_box %p.\n",
+            iface, dst, dst_x, dst_y, dst_z, src, src_box);
+
+    if (src_box && !validate_d3d12_box(src_box))
+    {
+        WARN("Empty box %s.\n", debug_d3d12_box(src_box));
+        return;
+    }
+
+    vk_procs = &list->device->vk_procs;
+
+    dst_resource = unsafe_impl_from_ID3D12Resource(dst->pResource);
+    src_resource = unsafe_impl_from_ID3D12Resource(src->pResource);
+
+    d3d12_command_list_track_resource_usage(list, dst_resource);
+    d3d12_command_list_track_resource_usage(list, src_resource);
+
+    d3d12_command_list_end_current_render_pass(list);
+
+    if (src->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX
+            && dst->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
+    {
+        assert(d3d12_resource_is_buffer(dst_resource));
+        assert(d3d12_resource_is_texture(src_resource));
+
+        if (!(dst_format = vkd3d_format_from_d3d12_resource_desc(list->device,
+                &src_resource->desc, dst->u.PlacedFootprint.Footprint.Format)))
+        {
+            WARN("Invalid format %#x.\n", dst->u.PlacedFootprint.Footprint.Format);
+            return;
+        }
+
+        if (dst_format->is_emulated)
+        {
+            FIXME("Format %#x is not supported yet.\n", dst_format->dxgi_format);
+            return;
+        }
+
+        if ((dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                && (dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
+            FIXME("Depth-stencil format %#x not fully supported yet.\n", dst_format->dxgi_format);
+
+        vk_image_buffer_copy_from_d3d12(&buffer_image_copy, &dst->u.PlacedFootprint,
+                src->u.SubresourceIndex, &src_resource->desc, dst_format, src_box, dst_x, dst_y, dst_z);
+        VK_CALL(vkCmdCopyImageToBuffer(d3d12_command_list_get_vk_command_buffer(list),
+                src_resource->u.vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                dst_resource->u.vk_buffer, 1, &buffer_image_copy));
+    }
+    else if (src->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT
+            && dst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
+    {
+        assert(d3d12_resource_is_texture(dst_resource));
+        assert(d3d12_resource_is_buffer(src_resource));
+
+        if (!(src_format = vkd3d_format_from_d3d12_resource_desc(list->device,
+                &dst_resource->desc, src->u.PlacedFootprint.Footprint.Format)))
+        {
+            WARN("Invalid format %#x.\n", src->u.PlacedFootprint.Footprint.Format);
+            return;
+        }
+
+        if (src_format->is_emulated)
+        {
+            FIXME("Format %#x is not supported yet.\n", src_format->dxgi_format);
+            return;
+        }
+
+        if ((src_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                && (src_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
+            FIXME("Depth-stencil format %#x not fully supported yet.\n", src_format->dxgi_format);
+
+        vk_buffer_image_copy_from_d3d12(&buffer_image_copy, &src->u.PlacedFootprint,
+                dst->u.SubresourceIndex, &dst_resource->desc, src_format, src_box, dst_x, dst_y, dst_z);
+        VK_CALL(vkCmdCopyBufferToImage(d3d12_command_list_get_vk_command_buffer(list),
+                src_resource->u.vk_buffer, dst_resource->u.vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &buffer_image_copy));
+    }
+    else if (src->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX
+            && dst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
+    {
+        assert(d3d12_resource_is_texture(dst_resource));
+        assert(d3d12_resource_is_texture(src_resource));
+
+        dst_format = dst_resource->format;
+        src_format = src_resource->format;
+
+        if ((dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                && (dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
+            FIXME("Depth-stencil format %#x not fully supported yet.\n", dst_format->dxgi_format);
+        if ((src_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                && (src_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
+            FIXME("Depth-stencil format %#x not fully supported yet.\n", src_format->dxgi_format);
+
+        if (dst_format->vk_aspect_mask != src_format->vk_aspect_mask)
+        {
+            d3d12_command_list_copy_incompatible_texture_region(list,
+                    dst_resource, dst->u.SubresourceIndex, dst_format,
+                    src_resource, src->u.SubresourceIndex, src_format);
+            return;
+        }
+
+        vk_image_copy_from_d3d12(&image_copy, src->u.SubresourceIndex, dst->u.SubresourceIndex,
+                 &src_resource->desc, &dst_resource->desc, src_format, dst_format,
+                 src_box, dst_x, dst_y, dst_z);
+        VK_CALL(vkCmdCopyImage(d3d12_command_list_get_vk_command_buffer(list), src_resource->u.vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_copy));
+    }
+    else
+    {
+        FIXME("Copy type %#x -> %#x not implemented.\n", src->Type, dst->Type);
+    }
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_CopyResource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, ID3D12Resource *src)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *dst_resource, *src_resource;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    VkBufferCopy vk_buffer_copy;
+    VkImageCopy vk_image_copy;
+    unsigned int layer_count;
+    unsigned int i;
+
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst, src);
+
+    vk_procs = &list->device->vk_procs;
+
+    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
+    src_resource = unsafe_impl_from_ID3D12Resource(src);
+
+    d3d12_command_list_track_resource_usage(list, dst_resource);
+    d3d12_command_list_track_resource_usage(list, src_resource);
+
+    d3d12_command_list_end_current_render_pass(list);
+
+    if (d3d12_resource_is_buffer(dst_resource))
+    {
+        assert(d3d12_resource_is_buffer(src_resource));
+        assert(src_resource->desc.Width == dst_resource->desc.Width);
+
+        vk_buffer_copy.srcOffset = 0;
+        vk_buffer_copy.dstOffset = 0;
+        vk_buffer_copy.size = dst_resource->desc.Width;
+        VK_CALL(vkCmdCopyBuffer(d3d12_command_list_get_vk_command_buffer(list),
+                src_resource->u.vk_buffer, dst_resource->u.vk_buffer, 1, &vk_buffer_copy));
+    }
+    else
+    {
+        layer_count = d3d12_resource_desc_get_layer_count(&dst_resource->desc);
+
+        assert(d3d12_resource_is_texture(dst_resource));
+        assert(d3d12_resource_is_texture(src_resource));
+        assert(dst_resource->desc.MipLevels == src_resource->desc.MipLevels);
+        assert(layer_count == d3d12_resource_desc_get_layer_count(&src_resource->desc));
+
+        for (i = 0; i < dst_resource->desc.MipLevels; ++i)
+        {
+            vk_image_copy_from_d3d12(&vk_image_copy, i, i, &src_resource->desc, &dst_resource->desc,
+                    src_resource->format, dst_resource->format, NULL, 0, 0, 0);
+            vk_image_copy.dstSubresource.layerCount = layer_count;
+            vk_image_copy.srcSubresource.layerCount = layer_count;
+            VK_CALL(vkCmdCopyImage(d3d12_command_list_get_vk_command_buffer(list), src_resource->u.vk_image,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_image_copy));
+        }
+    }
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_CopyTiles(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *tiled_resource, const D3D12_TILED_RESOURCE_COORDINATE *tile_region_start_coordinate,
+        const D3D12_TILE_REGION_SIZE *tile_region_size, ID3D12Resource *buffer, UINT64 buffer_offset,
+        D3D12_TILE_COPY_FLAGS flags)
+{
+    FIXME("iface %p, tiled_resource %p, tile_region_start_coordinate %p, tile_region_size %p, "
+            "buffer %p, buffer_offset %#"PRIx64", flags %#x stub!\n",
+            iface, tiled_resource, tile_region_start_coordinate, tile_region_size,
+            buffer, buffer_offset, flags);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_ResolveSubresource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, UINT dst_sub_resource_idx,
+        ID3D12Resource *src, UINT src_sub_resource_idx, DXGI_FORMAT format)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_format *src_format, *dst_format, *vk_format;
+    struct d3d12_resource *dst_resource, *src_resource;
+    const struct vkd3d_vk_device_procs *vk_procs;
+    const struct d3d12_device *device;
+    VkImageResolve vk_image_resolve;
+
+    TRACE("iface %p, dst_resource %p, dst_sub_resource_idx %u, src_resource %p, src_sub_resource_idx %u, "
+            "format %#x.\n", iface, dst, dst_sub_resource_idx, src, src_sub_resource_idx, format);
+
+    device = list->device;
+    vk_procs = &device->vk_procs;
+
+    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
+    src_resource = unsafe_impl_from_ID3D12Resource(src);
+
+    assert(d3d12_resource_is_texture(dst_resource));
+    assert(d3d12_resource_is_texture(src_resource));
+
+    d3d12_command_list_track_resource_usage(list, dst_resource);
+    d3d12_command_list_track_resource_usage(list, src_resource);
+
+    d3d12_command_list_end_current_render_pass(list);
+
+    dst_format = dst_resource->format;
+    src_format = src_resource->format;
+
+    if (dst_format->type == VKD3D_FORMAT_TYPE_TYPELESS || src_format->type == VKD3D_FORMAT_TYPE_TYPELESS)
+    {
+        if (!(vk_format = vkd3d_format_from_d3d12_resource_desc(device, &dst_resource->desc, format)))
+        {
+            WARN("Invalid format %#x.\n", format);
+            return;
+        }
+        if (dst_format->vk_format != src_format->vk_format || dst_format->vk_format != vk_format->vk_format)
+        {
+            FIXME("Not implemented for typeless resources.\n");
+            return;
+        }
+    }
+
+    /* Resolve of depth/stencil images is not supported in Vulkan. */
+    if ((dst_format->vk_aspect_mask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+            || (src_format->vk_aspect_mask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)))
+    {
+        FIXME("Resolve of depth/stencil images is not implemented yet.\n");
+        return;
+    }
+
+    vk_image_subresource_layers_from_d3d12(&vk_image_resolve.srcSubresource,
+            src_format, src_sub_resource_idx, src_resource->desc.MipLevels);
+    memset(&vk_image_resolve.srcOffset, 0, sizeof(vk_image_resolve.srcOffset));
+    vk_image_subresource_layers_from_d3d12(&vk_image_resolve.dstSubresource,
+            dst_format, dst_sub_resource_idx, dst_resource->desc.MipLevels);
+    memset(&vk_image_resolve.dstOffset, 0, sizeof(vk_image_resolve.dstOffset));
+    vk_extent_3d_from_d3d12_miplevel(&vk_image_resolve.extent,
+            &dst_resource->desc, vk_image_resolve.dstSubresource.mipLevel);
+
+    VK_CALL(vkCmdResolveImage(d3d12_command_list_get_vk_command_buffer(list), src_resource->u.vk_image,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_image_resolve));
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_IASetPrimitiveTopology(ID3D12GraphicsCommandList2 *iface,
+        D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    if (list->primitive_topology == topology)
+        return;
+
+    list->primitive_topology = topology;
+    d3d12_command_list_invalidate_current_pipeline(list);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_RSSetViewports(ID3D12GraphicsCommandList2 *iface,
+        UINT viewport_count, const D3D12_VIEWPORT *viewports)
+{
+    VkViewport vk_viewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    unsigned int i;
+
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (viewport_count > ARRAY_SIZE(vk_viewports))
+    {
+        FIXME("Viewport count %u > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE.\n", viewport_count);
+        viewport_count = ARRAY_SIZE(vk_viewports);
+    }
+
+    for (i = 0; i < viewport_count; ++i)
+    {
+        vk_viewports[i].x = viewports[i].TopLeftX;
+        vk_viewports[i].y = viewports[i].TopLeftY + viewports[i].Height;
+        vk_viewports[i].width = viewports[i].Width;
+        vk_viewports[i].height = -viewports[i].Height;
+        vk_viewports[i].minDepth = viewports[i].MinDepth;
+        vk_viewports[i].maxDepth = viewports[i].MaxDepth;
+
+        if (!vk_viewports[i].width || !vk_viewports[i].height)
+        {
+            FIXME_ONCE("Invalid viewport %u, ignoring RSSetViewports().\n", i);
+            return;
+        }
+    }
+
+    d3d12_command_list_cmd_set_viewport(list, 0, viewport_count, vk_viewports);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_RSSetScissorRects(ID3D12GraphicsCommandList2 *iface,
+        UINT rect_count, const D3D12_RECT *rects)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    VkRect2D vk_rects[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    unsigned int i;
+
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+
+    if (rect_count > ARRAY_SIZE(vk_rects))
+    {
+        FIXME("Rect count %u > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE.\n", rect_count);
+        rect_count = ARRAY_SIZE(vk_rects);
+    }
+
+    for (i = 0; i < rect_count; ++i)
+    {
+        vk_rects[i].offset.x = rects[i].left;
+        vk_rects[i].offset.y = rects[i].top;
+        vk_rects[i].extent.width = rects[i].right - rects[i].left;
+        vk_rects[i].extent.height = rects[i].bottom - rects[i].top;
+    }
+
+    d3d12_command_list_cmd_set_scissor(list, 0, rect_count, vk_rects);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_OMSetBlendFactor(ID3D12GraphicsCommandList2 *iface,
+        const FLOAT blend_factor[4])
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs;
+
+    TRACE("iface %p, blend_factor %p.\n", iface, blend_factor);
+
+    vk_procs = &list->device->vk_procs;
+    VK_CALL(vkCmdSetBlendConstants(d3d12_command_list_get_vk_command_buffer(list), blend_factor));
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_OMSetStencilRef(ID3D12GraphicsCommandList2 *iface,
+        UINT stencil_ref)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct vkd3d_vk_device_procs *vk_procs;
+
+    TRACE("iface %p, stencil_ref %u.\n", iface, stencil_ref);
+
+    vk_procs = &list->device->vk_procs;
+    VK_CALL(vkCmdSetStencilReference(d3d12_command_list_get_vk_command_buffer(list),
+            VK_STENCIL_FRONT_AND_BACK, stencil_ref));
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_SetPipelineState(ID3D12GraphicsCommandList2 *iface,
+        ID3D12PipelineState *pipeline_state)
+{
+    struct d3d12_pipeline_state *state = unsafe_impl_from_ID3D12PipelineState(pipeline_state);
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+
+    TRACE("iface %p, pipeline_state %p.\n", iface, pipeline_state);
+
+    /* Shaders may still be translated in the background. */
+    if (state && FAILED(d3d12_pipeline_state_wait(state)))
+    {
+        ERR("Failed to compile pipeline state %p.\n", state);
+        state = NULL;
+    }
+
+    if (list->state == state)
+        return;
+
+    d3d12_command_list_invalidate_bindings(list, state);
+    d3d12_command_list_invalidate_current_pipeline(list);
+
+    list->state = state;
+}
+
+static bool is_ds_multiplanar_resolvable(unsigned int first_state, unsigned int second_state)
+{
+    /* Only combinations of depth/stencil read/write are supported. */
+    return first_state == second_state
+            || ((first_state & (D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_DEPTH_WRITE))
+            && (second_state & (D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_DEPTH_WRITE)));
+}
+
+static unsigned int d3d12_find_ds_multiplanar_transition(const D3D12_RESOURCE_BARRIER *barriers,
+        unsigned int i, unsigned int barrier_count, unsigned int sub_resource_count)
+{
+    unsigned int sub_resource_idx = barriers[i].u.Transition.Subresource;
+    unsigned int j;
+
+    for (j = i + 1; j < barrier_count; ++j)
+    {
+        if (barriers[j].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION
+                && barriers[j].u.Transition.pResource == barriers[i].u.Transition.pResource
+                && sub_resource_idx % sub_resource_count == barriers[j].u.Transition.Subresource % sub_resource_count)
+        {
+            /* Second barrier must be for a different plane. */
+            if (barriers[j].u.Transition.Subresource == sub_resource_idx)
+                return 0;
+
+            /* Validate the second barrier and check if the combination of two states is supported. */
+            if (!is_valid_resource_state(barriers[j].u.Transition.StateBefore)
+                    || !is_ds_multiplanar_resolvable(barriers[i].u.Transition.StateBefore, barriers[j].u.Transition.StateBefore)
+                    || !is_valid_resource_state(barriers[j].u.Transition.StateAfter)
+                    || !is_ds_multiplanar_resolvable(barriers[i].u.Transition.StateAfter, barriers[j].u.Transition.StateAfter)
+                    || barriers[j].u.Transition.Subresource >= sub_resource_count * 2u)
+                return 0;
+
+            return j;
+        }
+    }
+    return 0;
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_ResourceBarrier(ID3D12GraphicsCommandList2 *iface,
+        UINT barrier_count, const D3D12_RESOURCE_BARRIER *barriers)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    bool have_aliasing_barriers = false, have_split_barriers = false;
+    const struct vkd3d_vulkan_info *vk_info;
+    bool *multiplanar_handled = NULL;
+    struct vkd3d_record_timer timer;
+    size_t discard_idx;
+    unsigned int i;
+
+    TRACE("iface %p, barrier_count %u, barriers %p.\n", iface, barrier_count, barriers);
+
+    vk_info = &list->device->vk_info;
+
+    d3d12_command_list_begin_record_timing(list, &timer);
+
+    /* Barriers are only batched outside of render passes, so this doesn't
+     * flush barriers from a preceding ResourceBarrier() call. */
+    if (list->current_render_pass)
+        d3d12_command_list_end_current_render_pass(list);
+    /* Clears must complete before a transition away from the render target
+     * or depth write state. */
+    d3d12_command_list_flush_pending_clears(list);
+
+    for (i = 0; i < barrier_count; ++i)
     {
-        VK_CALL(vkDestroyBuffer(device->vk_device, buffer->vk_buffer, NULL));
-        return hr;
+        unsigned int sub_resource_idx = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        VkPipelineStageFlags src_stage_mask = 0, dst_stage_mask = 0;
+        VkAccessFlags src_access_mask = 0, dst_access_mask = 0;
+        const D3D12_RESOURCE_BARRIER *current = &barriers[i];
+        VkImageLayout layout_before, layout_after;
+        struct d3d12_resource *resource;
+
+        have_split_barriers = have_split_barriers
+                || (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+                || (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+
+        if (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+            continue;
+
+        switch (current->Type)
+        {
+            case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+            {
+                unsigned int state_before, state_after, stencil_state_before = 0, stencil_state_after = 0;
+                const D3D12_RESOURCE_TRANSITION_BARRIER *transition = &current->u.Transition;
+
+                if (!is_valid_resource_state(transition->StateBefore))
+                {
+                    d3d12_command_list_mark_as_invalid(list,
+                            "Invalid StateBefore %#x (barrier %u).", transition->StateBefore, i);
+                    continue;
+                }
+                if (!is_valid_resource_state(transition->StateAfter))
+                {
+                    d3d12_command_list_mark_as_invalid(list,
+                            "Invalid StateAfter %#x (barrier %u).", transition->StateAfter, i);
+                    continue;
+                }
+
+                if (!(resource = unsafe_impl_from_ID3D12Resource(transition->pResource)))
+                {
+                    d3d12_command_list_mark_as_invalid(list, "A resource pointer is NULL.");
+                    continue;
+                }
+
+                if (multiplanar_handled && multiplanar_handled[i])
+                    continue;
+
+                state_before = transition->StateBefore;
+                state_after = transition->StateAfter;
+
+                sub_resource_idx = transition->Subresource;
+
+                if (sub_resource_idx != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
+                        && (resource->desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+                {
+                    unsigned int sub_resource_count = d3d12_resource_desc_get_sub_resource_count(&resource->desc);
+                    unsigned int j = d3d12_find_ds_multiplanar_transition(barriers, i, barrier_count, sub_resource_count);
+                    if (j && (multiplanar_handled || (multiplanar_handled = vkd3d_calloc(barrier_count, sizeof(*multiplanar_handled)))))
+                    {
+                        multiplanar_handled[j] = true;
+                        if (sub_resource_idx >= sub_resource_count)
+                        {
+                            sub_resource_idx -= sub_resource_count;
+                            /* The stencil barrier is at i, depth at j. */
+                            state_before = barriers[j].u.Transition.StateBefore;
+                            state_after = barriers[j].u.Transition.StateAfter;
+                            stencil_state_before = transition->StateBefore;
+                            stencil_state_after = transition->StateAfter;
+                        }
+                        else
+                        {
+                            /* Depth at i, stencil at j. */
+                            stencil_state_before = barriers[j].u.Transition.StateBefore;
+                            stencil_state_after = barriers[j].u.Transition.StateAfter;
+                        }
+                    }
+                    else if (sub_resource_idx >= sub_resource_count)
+                    {
+                        FIXME_ONCE("Unhandled sub-resource idx %u.\n", sub_resource_idx);
+                        continue;
+                    }
+                }
+
+                if (!vk_barrier_parameters_from_d3d12_resource_state(state_before, stencil_state_before,
+                        resource, list->vk_queue_flags, vk_info, &src_access_mask, &src_stage_mask, &layout_before))
+                {
+                    FIXME("Unhandled state %#x.\n", state_before);
+                    continue;
+                }
+                if (!vk_barrier_parameters_from_d3d12_resource_state(state_after, stencil_state_after,
+                        resource, list->vk_queue_flags, vk_info, &dst_access_mask, &dst_stage_mask, &layout_after))
+                {
+                    FIXME("Unhandled state %#x.\n", state_after);
+                    continue;
+                }
+
+                TRACE("Transition barrier (resource %p, subresource %#x, before %#x, after %#x).\n",
+                        resource, transition->Subresource, transition->StateBefore, transition->StateAfter);
+                break;
+            }
+
+            case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            {
+                const D3D12_RESOURCE_UAV_BARRIER *uav = &current->u.UAV;
+                VkPipelineStageFlags stage_mask;
+                VkImageLayout image_layout;
+                VkAccessFlags access_mask;
+
+                resource = unsafe_impl_from_ID3D12Resource(uav->pResource);
+                vk_barrier_parameters_from_d3d12_resource_state(D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 0,
+                        resource, list->vk_queue_flags, vk_info, &access_mask, &stage_mask, &image_layout);
+                src_access_mask = dst_access_mask = access_mask;
+                src_stage_mask = dst_stage_mask = stage_mask;
+                layout_before = layout_after = image_layout;
+
+                TRACE("UAV barrier (resource %p).\n", resource);
+                break;
+            }
+
+            case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+                have_aliasing_barriers = true;
+                continue;
+            default:
+                WARN("Invalid barrier type %#x.\n", current->Type);
+                continue;
+        }
+
+        if (resource)
+            d3d12_command_list_track_resource_usage(list, resource);
+
+        if (!resource)
+        {
+            VkMemoryBarrier vk_barrier;
+
+            vk_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            vk_barrier.pNext = NULL;
+            vk_barrier.srcAccessMask = src_access_mask;
+            vk_barrier.dstAccessMask = dst_access_mask;
+
+            d3d12_command_list_add_barrier(list, src_stage_mask, dst_stage_mask, &vk_barrier, NULL, NULL);
+        }
+        else if (d3d12_resource_is_buffer(resource))
+        {
+            VkBufferMemoryBarrier vk_barrier;
+
+            vk_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            vk_barrier.pNext = NULL;
+            vk_barrier.srcAccessMask = src_access_mask;
+            vk_barrier.dstAccessMask = dst_access_mask;
+            vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            vk_barrier.buffer = resource->u.vk_buffer;
+            vk_barrier.offset = 0;
+            vk_barrier.size = VK_WHOLE_SIZE;
+
+            d3d12_command_list_add_barrier(list, src_stage_mask, dst_stage_mask, NULL, &vk_barrier, NULL);
+        }
+        else
+        {
+            VkImageMemoryBarrier vk_barrier;
+
+            vk_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            vk_barrier.pNext = NULL;
+            vk_barrier.srcAccessMask = src_access_mask;
+            vk_barrier.dstAccessMask = dst_access_mask;
+            vk_barrier.oldLayout = layout_before;
+            vk_barrier.newLayout = layout_after;
+            vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            vk_barrier.image = resource->u.vk_image;
+
+            vk_barrier.subresourceRange.aspectMask = resource->format->vk_aspect_mask;
+            if (sub_resource_idx == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+            {
+                vk_barrier.subresourceRange.baseMipLevel = 0;
+                vk_barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+                vk_barrier.subresourceRange.baseArrayLayer = 0;
+                vk_barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            }
+            else
+            {
+                /* FIXME: Some formats in D3D12 are planar. Each plane is a separate sub-resource. */
+                if (sub_resource_idx >= d3d12_resource_desc_get_sub_resource_count(&resource->desc))
+                {
+                    FIXME_ONCE("Unhandled sub-resource idx %u.\n", sub_resource_idx);
+                    continue;
+                }
+
+                vk_barrier.subresourceRange.baseMipLevel = sub_resource_idx % resource->desc.MipLevels;
+                vk_barrier.subresourceRange.levelCount = 1;
+                vk_barrier.subresourceRange.baseArrayLayer = sub_resource_idx / resource->desc.MipLevels;
+                vk_barrier.subresourceRange.layerCount = 1;
+            }
+
+            /* The contents of discarded sub-resources don't need to be preserved. */
+            if (current->Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION
+                    && d3d12_command_list_find_pending_discard(list, resource, &discard_idx))
+            {
+                if (vkd3d_pending_discard_covers_range(&list->pending_discards[discard_idx],
+                        &vk_barrier.subresourceRange))
+                    vk_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                d3d12_command_list_remove_pending_discard(list, discard_idx);
+            }
+
+            d3d12_command_list_add_barrier(list, src_stage_mask, dst_stage_mask, NULL, NULL, &vk_barrier);
+        }
     }
 
-    if (!d3d12_command_allocator_add_transfer_buffer(list->allocator, buffer))
-    {
-        ERR("Failed to add transfer buffer.\n");
-        vkd3d_buffer_destroy(buffer, device);
-        return E_OUTOFMEMORY;
-    }
+    vkd3d_free(multiplanar_handled);
+
+    d3d12_command_list_end_record_timing(list, &timer);
+
+    if (have_aliasing_barriers)
+        FIXME_ONCE("Aliasing barriers not implemented yet.\n");
+
+    /* Vulkan doesn't support split barriers. */
+    if (have_split_barriers)
+        WARN("Issuing split barrier(s) on D3D12_RESOURCE_BARRIER_FLAG_END_ONLY.\n");
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_SetDescriptorHeaps(ID3D12GraphicsCommandList2 *iface,
+        UINT heap_count, ID3D12DescriptorHeap *const *heaps)
+{
+    TRACE("iface %p, heap_count %u, heaps %p.\n", iface, heap_count, heaps);
+
+    /* Our current implementation does not need this method.
+     * In Windows it doesn't need to be called at all for correct operation, and
+     * at least on AMD the wrong heaps can be set here and tests still succeed.
+     *
+     * It could be used to validate descriptor tables but we do not have an
+     * equivalent of the D3D12 Debug Layer. */
+}
+
+static void d3d12_command_list_set_root_signature(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, const struct d3d12_root_signature *root_signature)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
 
-    return S_OK;
+    if (bindings->root_signature == root_signature)
+        return;
+
+    bindings->root_signature = root_signature;
+    /* Push constants of the previous pipeline layout are not inherited. */
+    bindings->push_constant_dirty_mask = 0;
+    bindings->push_constant_valid_mask = 0;
+
+    d3d12_command_list_invalidate_root_parameters(list, bind_point);
 }
 
-/* In Vulkan, each depth/stencil format is only compatible with itself.
- * This means that we are not allowed to copy texture regions directly between
- * depth/stencil and color formats.
- *
- * FIXME: Implement color <-> depth/stencil blits in shaders.
- */
-static void d3d12_command_list_copy_incompatible_texture_region(struct d3d12_command_list *list,
-        struct d3d12_resource *dst_resource, unsigned int dst_sub_resource_idx,
-        const struct vkd3d_format *dst_format, struct d3d12_resource *src_resource,
-        unsigned int src_sub_resource_idx, const struct vkd3d_format *src_format)
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootSignature(ID3D12GraphicsCommandList2 *iface,
+        ID3D12RootSignature *root_signature)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const D3D12_RESOURCE_DESC *dst_desc = &dst_resource->desc;
-    const D3D12_RESOURCE_DESC *src_desc = &src_resource->desc;
-    unsigned int dst_miplevel_idx, src_miplevel_idx;
-    struct vkd3d_buffer transfer_buffer;
-    VkBufferImageCopy buffer_image_copy;
-    VkBufferMemoryBarrier vk_barrier;
-    VkDeviceSize buffer_size;
-    HRESULT hr;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    WARN("Copying incompatible texture formats %#x, %#x -> %#x, %#x.\n",
-            src_format->dxgi_format, src_format->vk_format,
-            dst_format->dxgi_format, dst_format->vk_format);
+    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
 
-    assert(d3d12_resource_is_texture(dst_resource));
-    assert(d3d12_resource_is_texture(src_resource));
-    assert(!vkd3d_format_is_compressed(dst_format));
-    assert(!vkd3d_format_is_compressed(src_format));
-    assert(dst_format->byte_count == src_format->byte_count);
+    d3d12_command_list_set_root_signature(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            unsafe_impl_from_ID3D12RootSignature(root_signature));
+}
 
-    buffer_image_copy.bufferOffset = 0;
-    buffer_image_copy.bufferRowLength = 0;
-    buffer_image_copy.bufferImageHeight = 0;
-    vk_image_subresource_layers_from_d3d12(&buffer_image_copy.imageSubresource,
-            src_format, src_sub_resource_idx, src_desc->MipLevels);
-    src_miplevel_idx = buffer_image_copy.imageSubresource.mipLevel;
-    buffer_image_copy.imageOffset.x = 0;
-    buffer_image_copy.imageOffset.y = 0;
-    buffer_image_copy.imageOffset.z = 0;
-    vk_extent_3d_from_d3d12_miplevel(&buffer_image_copy.imageExtent, src_desc, src_miplevel_idx);
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootSignature(ID3D12GraphicsCommandList2 *iface,
+        ID3D12RootSignature *root_signature)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    buffer_size = src_format->byte_count * buffer_image_copy.imageExtent.width *
-            buffer_image_copy.imageExtent.height * buffer_image_copy.imageExtent.depth;
-    if (FAILED(hr = d3d12_command_list_allocate_transfer_buffer(list, buffer_size, &transfer_buffer)))
-    {
-        ERR("Failed to allocate transfer buffer, hr %#x.\n", hr);
-        return;
-    }
+    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
 
-    VK_CALL(vkCmdCopyImageToBuffer(list->vk_command_buffer,
-            src_resource->u.vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-            transfer_buffer.vk_buffer, 1, &buffer_image_copy));
+    d3d12_command_list_set_root_signature(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            unsafe_impl_from_ID3D12RootSignature(root_signature));
+}
 
-    vk_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-    vk_barrier.pNext = NULL;
-    vk_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    vk_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-    vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    vk_barrier.buffer = transfer_buffer.vk_buffer;
-    vk_barrier.offset = 0;
-    vk_barrier.size = VK_WHOLE_SIZE;
-    VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-            0, NULL, 1, &vk_barrier, 0, NULL));
+static void d3d12_command_list_set_descriptor_table(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    struct d3d12_desc *desc;
 
-    vk_image_subresource_layers_from_d3d12(&buffer_image_copy.imageSubresource,
-            dst_format, dst_sub_resource_idx, dst_desc->MipLevels);
-    dst_miplevel_idx = buffer_image_copy.imageSubresource.mipLevel;
+    assert(root_signature_get_descriptor_table(root_signature, index));
 
-    assert(d3d12_resource_desc_get_width(src_desc, src_miplevel_idx) ==
-            d3d12_resource_desc_get_width(dst_desc, dst_miplevel_idx));
-    assert(d3d12_resource_desc_get_height(src_desc, src_miplevel_idx) ==
-            d3d12_resource_desc_get_height(dst_desc, dst_miplevel_idx));
-    assert(d3d12_resource_desc_get_depth(src_desc, src_miplevel_idx) ==
-            d3d12_resource_desc_get_depth(dst_desc, dst_miplevel_idx));
+    assert(index < ARRAY_SIZE(bindings->descriptor_tables));
+    desc = d3d12_desc_from_gpu_handle(base_descriptor);
 
-    VK_CALL(vkCmdCopyBufferToImage(list->vk_command_buffer,
-            transfer_buffer.vk_buffer, dst_resource->u.vk_image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &buffer_image_copy));
+    if (bindings->descriptor_tables[index] == desc)
+        return;
+
+    bindings->descriptor_tables[index] = desc;
+    bindings->descriptor_table_dirty_mask |= (uint64_t)1 << index;
+    bindings->descriptor_table_active_mask |= (uint64_t)1 << index;
 }
 
-static bool validate_d3d12_box(const D3D12_BOX *box)
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
 {
-    return box->right > box->left
-            && box->bottom > box->top
-            && box->back > box->front;
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+
+    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
+            iface, root_parameter_index, base_descriptor.ptr);
+
+    d3d12_command_list_set_descriptor_table(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            root_parameter_index, base_descriptor);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_CopyTextureRegion(ID3D12GraphicsCommandList2 *iface,
-        const D3D12_TEXTURE_COPY_LOCATION *dst, UINT dst_x, UINT dst_y, UINT dst_z,
-        const D3D12_TEXTURE_COPY_LOCATION *src, const D3D12_BOX *src_box)
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *dst_resource, *src_resource;
-    const struct vkd3d_format *src_format, *dst_format;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkBufferImageCopy buffer_image_copy;
-    VkImageCopy image_copy;
 
-    TRACE("iface %p, dst %p, dst_x %u, dst_y %u, dst_z %u, src %p, src_box %p.\n",
-            iface, dst, dst_x, dst_y, dst_z, src, src_box);
+    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
+            iface, root_parameter_index, base_descriptor.ptr);
 
-    if (src_box && !validate_d3d12_box(src_box))
+    d3d12_command_list_set_descriptor_table(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            root_parameter_index, base_descriptor);
+}
+
+static void d3d12_command_list_set_root_constants(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, unsigned int offset,
+        unsigned int count, const void *data)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    const uint32_t *values = data;
+    const struct d3d12_root_constant *c;
+    unsigned int i, idx;
+    uint64_t bit;
+
+    c = root_signature_get_32bit_constants(root_signature, index);
+    idx = c->offset / sizeof(uint32_t) + offset;
+    if (!vkd3d_bound_range(idx, count, ARRAY_SIZE(bindings->push_constants)))
     {
-        WARN("Empty box %s.\n", debug_d3d12_box(src_box));
+        WARN("Invalid root constant offset %u / count %u.\n", idx, count);
         return;
     }
 
-    vk_procs = &list->device->vk_procs;
+    /* Unchanged values are not pushed again. */
+    for (i = 0; i < count; ++i, ++idx)
+    {
+        bit = (uint64_t)1 << idx;
+        if ((bindings->push_constant_valid_mask & bit) && bindings->push_constants[idx] == values[i])
+            continue;
+        bindings->push_constants[idx] = values[i];
+        bindings->push_constant_valid_mask |= bit;
+        bindings->push_constant_dirty_mask |= bit;
+    }
+}
 
-    dst_resource = unsafe_impl_from_ID3D12Resource(dst->pResource);
-    src_resource = unsafe_impl_from_ID3D12Resource(src->pResource);
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT data, UINT dst_offset)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    d3d12_command_list_track_resource_usage(list, dst_resource);
-    d3d12_command_list_track_resource_usage(list, src_resource);
+    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
+            iface, root_parameter_index, data, dst_offset);
 
-    d3d12_command_list_end_current_render_pass(list);
+    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            root_parameter_index, dst_offset, 1, &data);
+}
 
-    if (src->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX
-            && dst->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
-    {
-        assert(d3d12_resource_is_buffer(dst_resource));
-        assert(d3d12_resource_is_texture(src_resource));
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT data, UINT dst_offset)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-        if (!(dst_format = vkd3d_format_from_d3d12_resource_desc(list->device,
-                &src_resource->desc, dst->u.PlacedFootprint.Footprint.Format)))
-        {
-            WARN("Invalid format %#x.\n", dst->u.PlacedFootprint.Footprint.Format);
-            return;
-        }
+    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
+            iface, root_parameter_index, data, dst_offset);
 
-        if (dst_format->is_emulated)
-        {
-            FIXME("Format %#x is not supported yet.\n", dst_format->dxgi_format);
-            return;
-        }
+    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            root_parameter_index, dst_offset, 1, &data);
+}
 
-        if ((dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
-                && (dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
-            FIXME("Depth-stencil format %#x not fully supported yet.\n", dst_format->dxgi_format);
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-        vk_image_buffer_copy_from_d3d12(&buffer_image_copy, &dst->u.PlacedFootprint,
-                src->u.SubresourceIndex, &src_resource->desc, dst_format, src_box, dst_x, dst_y, dst_z);
-        VK_CALL(vkCmdCopyImageToBuffer(list->vk_command_buffer,
-                src_resource->u.vk_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                dst_resource->u.vk_buffer, 1, &buffer_image_copy));
-    }
-    else if (src->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT
-            && dst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
-    {
-        assert(d3d12_resource_is_texture(dst_resource));
-        assert(d3d12_resource_is_buffer(src_resource));
+    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
+            iface, root_parameter_index, constant_count, data, dst_offset);
 
-        if (!(src_format = vkd3d_format_from_d3d12_resource_desc(list->device,
-                &dst_resource->desc, src->u.PlacedFootprint.Footprint.Format)))
-        {
-            WARN("Invalid format %#x.\n", src->u.PlacedFootprint.Footprint.Format);
-            return;
-        }
+    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            root_parameter_index, dst_offset, constant_count, data);
+}
 
-        if (src_format->is_emulated)
-        {
-            FIXME("Format %#x is not supported yet.\n", src_format->dxgi_format);
-            return;
-        }
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-        if ((src_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
-                && (src_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
-            FIXME("Depth-stencil format %#x not fully supported yet.\n", src_format->dxgi_format);
+    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
+            iface, root_parameter_index, constant_count, data, dst_offset);
 
-        vk_buffer_image_copy_from_d3d12(&buffer_image_copy, &src->u.PlacedFootprint,
-                dst->u.SubresourceIndex, &dst_resource->desc, src_format, src_box, dst_x, dst_y, dst_z);
-        VK_CALL(vkCmdCopyBufferToImage(list->vk_command_buffer,
-                src_resource->u.vk_buffer, dst_resource->u.vk_image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &buffer_image_copy));
-    }
-    else if (src->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX
-            && dst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
-    {
-        assert(d3d12_resource_is_texture(dst_resource));
-        assert(d3d12_resource_is_texture(src_resource));
+    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            root_parameter_index, dst_offset, constant_count, data);
+}
 
-        dst_format = dst_resource->format;
-        src_format = src_resource->format;
+static void d3d12_command_list_set_root_cbv(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_VIRTUAL_ADDRESS gpu_address)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
+    const struct d3d12_root_parameter *root_parameter;
+    struct VkWriteDescriptorSet descriptor_write;
+    struct VkDescriptorBufferInfo buffer_info;
+    struct d3d12_resource *resource;
 
-        if ((dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
-                && (dst_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
-            FIXME("Depth-stencil format %#x not fully supported yet.\n", dst_format->dxgi_format);
-        if ((src_format->vk_aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
-                && (src_format->vk_aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT))
-            FIXME("Depth-stencil format %#x not fully supported yet.\n", src_format->dxgi_format);
+    root_parameter = root_signature_get_root_descriptor(root_signature, index);
+    assert(root_parameter->parameter_type == D3D12_ROOT_PARAMETER_TYPE_CBV);
 
-        if (dst_format->vk_aspect_mask != src_format->vk_aspect_mask)
-        {
-            d3d12_command_list_copy_incompatible_texture_region(list,
-                    dst_resource, dst->u.SubresourceIndex, dst_format,
-                    src_resource, src->u.SubresourceIndex, src_format);
-            return;
-        }
+    resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, gpu_address);
+    buffer_info.buffer = resource->u.vk_buffer;
+    buffer_info.offset = gpu_address - resource->gpu_address;
+    buffer_info.range = resource->desc.Width - buffer_info.offset;
+    buffer_info.range = min(buffer_info.range, vk_info->device_limits.maxUniformBufferRange);
 
-        vk_image_copy_from_d3d12(&image_copy, src->u.SubresourceIndex, dst->u.SubresourceIndex,
-                 &src_resource->desc, &dst_resource->desc, src_format, dst_format,
-                 src_box, dst_x, dst_y, dst_z);
-        VK_CALL(vkCmdCopyImage(list->vk_command_buffer, src_resource->u.vk_image,
-                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_copy));
+    if (vk_info->KHR_push_descriptor)
+    {
+        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
+                root_parameter, VK_NULL_HANDLE, NULL, &buffer_info);
+        VK_CALL(vkCmdPushDescriptorSetKHR(d3d12_command_list_get_vk_command_buffer(list), bindings->vk_bind_point,
+                root_signature->vk_pipeline_layout, 0, 1, &descriptor_write));
     }
     else
     {
-        FIXME("Copy type %#x -> %#x not implemented.\n", src->Type, dst->Type);
+        d3d12_command_list_prepare_descriptors(list, bind_point);
+        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
+                root_parameter, bindings->descriptor_sets[0], NULL, &buffer_info);
+        VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &descriptor_write, 0, NULL));
+
+        assert(index < ARRAY_SIZE(bindings->push_descriptors));
+        bindings->push_descriptors[index].u.cbv.vk_buffer = buffer_info.buffer;
+        bindings->push_descriptors[index].u.cbv.offset = buffer_info.offset;
+        bindings->push_descriptor_dirty_mask |= 1u << index;
+        bindings->push_descriptor_active_mask |= 1u << index;
     }
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_CopyResource(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *dst, ID3D12Resource *src)
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootConstantBufferView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *dst_resource, *src_resource;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkBufferCopy vk_buffer_copy;
-    VkImageCopy vk_image_copy;
-    unsigned int layer_count;
-    unsigned int i;
 
-    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst, src);
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    vk_procs = &list->device->vk_procs;
+    d3d12_command_list_set_root_cbv(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index, address);
+}
 
-    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
-    src_resource = unsafe_impl_from_ID3D12Resource(src);
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootConstantBufferView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    d3d12_command_list_track_resource_usage(list, dst_resource);
-    d3d12_command_list_track_resource_usage(list, src_resource);
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    d3d12_command_list_end_current_render_pass(list);
+    d3d12_command_list_set_root_cbv(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index, address);
+}
 
-    if (d3d12_resource_is_buffer(dst_resource))
+static void d3d12_command_list_set_root_descriptor(struct d3d12_command_list *list,
+        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_VIRTUAL_ADDRESS gpu_address)
+{
+    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    const struct d3d12_root_signature *root_signature = bindings->root_signature;
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
+    const struct d3d12_root_parameter *root_parameter;
+    struct VkWriteDescriptorSet descriptor_write;
+    VkDevice vk_device = list->device->vk_device;
+    VkBufferView vk_buffer_view;
+
+    root_parameter = root_signature_get_root_descriptor(root_signature, index);
+    assert(root_parameter->parameter_type != D3D12_ROOT_PARAMETER_TYPE_CBV);
+
+    /* FIXME: Re-use buffer views. */
+    if (!vkd3d_create_raw_buffer_view(list->device, gpu_address, &vk_buffer_view))
     {
-        assert(d3d12_resource_is_buffer(src_resource));
-        assert(src_resource->desc.Width == dst_resource->desc.Width);
+        ERR("Failed to create buffer view.\n");
+        return;
+    }
 
-        vk_buffer_copy.srcOffset = 0;
-        vk_buffer_copy.dstOffset = 0;
-        vk_buffer_copy.size = dst_resource->desc.Width;
-        VK_CALL(vkCmdCopyBuffer(list->vk_command_buffer,
-                src_resource->u.vk_buffer, dst_resource->u.vk_buffer, 1, &vk_buffer_copy));
+    if (!(d3d12_command_allocator_add_buffer_view(list->allocator, vk_buffer_view)))
+    {
+        ERR("Failed to add buffer view.\n");
+        VK_CALL(vkDestroyBufferView(vk_device, vk_buffer_view, NULL));
+        return;
+    }
+
+    if (vk_info->KHR_push_descriptor)
+    {
+        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
+                root_parameter, VK_NULL_HANDLE, &vk_buffer_view, NULL);
+        VK_CALL(vkCmdPushDescriptorSetKHR(d3d12_command_list_get_vk_command_buffer(list), bindings->vk_bind_point,
+                root_signature->vk_pipeline_layout, 0, 1, &descriptor_write));
     }
     else
     {
-        layer_count = d3d12_resource_desc_get_layer_count(&dst_resource->desc);
-
-        assert(d3d12_resource_is_texture(dst_resource));
-        assert(d3d12_resource_is_texture(src_resource));
-        assert(dst_resource->desc.MipLevels == src_resource->desc.MipLevels);
-        assert(layer_count == d3d12_resource_desc_get_layer_count(&src_resource->desc));
+        d3d12_command_list_prepare_descriptors(list, bind_point);
+        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
+                root_parameter, bindings->descriptor_sets[0], &vk_buffer_view,  NULL);
+        VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &descriptor_write, 0, NULL));
 
-        for (i = 0; i < dst_resource->desc.MipLevels; ++i)
-        {
-            vk_image_copy_from_d3d12(&vk_image_copy, i, i, &src_resource->desc, &dst_resource->desc,
-                    src_resource->format, dst_resource->format, NULL, 0, 0, 0);
-            vk_image_copy.dstSubresource.layerCount = layer_count;
-            vk_image_copy.srcSubresource.layerCount = layer_count;
-            VK_CALL(vkCmdCopyImage(list->vk_command_buffer, src_resource->u.vk_image,
-                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_image_copy));
-        }
+        assert(index < ARRAY_SIZE(bindings->push_descriptors));
+        bindings->push_descriptors[index].u.vk_buffer_view = vk_buffer_view;
+        bindings->push_descriptor_dirty_mask |= 1u << index;
+        bindings->push_descriptor_active_mask |= 1u << index;
     }
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_CopyTiles(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *tiled_resource, const D3D12_TILED_RESOURCE_COORDINATE *tile_region_start_coordinate,
-        const D3D12_TILE_REGION_SIZE *tile_region_size, ID3D12Resource *buffer, UINT64 buffer_offset,
-        D3D12_TILE_COPY_FLAGS flags)
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootShaderResourceView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
-    FIXME("iface %p, tiled_resource %p, tile_region_start_coordinate %p, tile_region_size %p, "
-            "buffer %p, buffer_offset %#"PRIx64", flags %#x stub!\n",
-            iface, tiled_resource, tile_region_start_coordinate, tile_region_size,
-            buffer, buffer_offset, flags);
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
+
+    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            root_parameter_index, address);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ResolveSubresource(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *dst, UINT dst_sub_resource_idx,
-        ID3D12Resource *src, UINT src_sub_resource_idx, DXGI_FORMAT format)
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootShaderResourceView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_format *src_format, *dst_format, *vk_format;
-    struct d3d12_resource *dst_resource, *src_resource;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    const struct d3d12_device *device;
-    VkImageResolve vk_image_resolve;
 
-    TRACE("iface %p, dst_resource %p, dst_sub_resource_idx %u, src_resource %p, src_sub_resource_idx %u, "
-            "format %#x.\n", iface, dst, dst_sub_resource_idx, src, src_sub_resource_idx, format);
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    device = list->device;
-    vk_procs = &device->vk_procs;
+    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            root_parameter_index, address);
+}
 
-    dst_resource = unsafe_impl_from_ID3D12Resource(dst);
-    src_resource = unsafe_impl_from_ID3D12Resource(src);
+static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootUnorderedAccessView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    assert(d3d12_resource_is_texture(dst_resource));
-    assert(d3d12_resource_is_texture(src_resource));
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    d3d12_command_list_track_resource_usage(list, dst_resource);
-    d3d12_command_list_track_resource_usage(list, src_resource);
+    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
+            root_parameter_index, address);
+}
 
-    d3d12_command_list_end_current_render_pass(list);
+static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootUnorderedAccessView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    dst_format = dst_resource->format;
-    src_format = src_resource->format;
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    if (dst_format->type == VKD3D_FORMAT_TYPE_TYPELESS || src_format->type == VKD3D_FORMAT_TYPE_TYPELESS)
-    {
-        if (!(vk_format = vkd3d_format_from_d3d12_resource_desc(device, &dst_resource->desc, format)))
-        {
-            WARN("Invalid format %#x.\n", format);
-            return;
-        }
-        if (dst_format->vk_format != src_format->vk_format || dst_format->vk_format != vk_format->vk_format)
-        {
-            FIXME("Not implemented for typeless resources.\n");
-            return;
-        }
-    }
+    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
+            root_parameter_index, address);
+}
 
-    /* Resolve of depth/stencil images is not supported in Vulkan. */
-    if ((dst_format->vk_aspect_mask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
-            || (src_format->vk_aspect_mask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)))
+static void STDMETHODCALLTYPE d3d12_command_list_IASetIndexBuffer(ID3D12GraphicsCommandList2 *iface,
+        const D3D12_INDEX_BUFFER_VIEW *view)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *resource;
+    enum VkIndexType index_type;
+    VkDeviceSize offset;
+
+    TRACE("iface %p, view %p.\n", iface, view);
+
+    if (!view)
     {
-        FIXME("Resolve of depth/stencil images is not implemented yet.\n");
+        WARN("Ignoring NULL index buffer view.\n");
         return;
     }
 
-    vk_image_subresource_layers_from_d3d12(&vk_image_resolve.srcSubresource,
-            src_format, src_sub_resource_idx, src_resource->desc.MipLevels);
-    memset(&vk_image_resolve.srcOffset, 0, sizeof(vk_image_resolve.srcOffset));
-    vk_image_subresource_layers_from_d3d12(&vk_image_resolve.dstSubresource,
-            dst_format, dst_sub_resource_idx, dst_resource->desc.MipLevels);
-    memset(&vk_image_resolve.dstOffset, 0, sizeof(vk_image_resolve.dstOffset));
-    vk_extent_3d_from_d3d12_miplevel(&vk_image_resolve.extent,
-            &dst_resource->desc, vk_image_resolve.dstSubresource.mipLevel);
-
-    VK_CALL(vkCmdResolveImage(list->vk_command_buffer, src_resource->u.vk_image,
-            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst_resource->u.vk_image,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vk_image_resolve));
-}
-
-static void STDMETHODCALLTYPE d3d12_command_list_IASetPrimitiveTopology(ID3D12GraphicsCommandList2 *iface,
-        D3D12_PRIMITIVE_TOPOLOGY topology)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    switch (view->Format)
+    {
+        case DXGI_FORMAT_R16_UINT:
+            index_type = VK_INDEX_TYPE_UINT16;
+            break;
+        case DXGI_FORMAT_R32_UINT:
+            index_type = VK_INDEX_TYPE_UINT32;
+            break;
+        default:
+            WARN("Invalid index format %#x.\n", view->Format);
+            return;
+    }
 
-    TRACE("iface %p, topology %#x.\n", iface, topology);
+    list->index_buffer_format = view->Format;
 
-    if (list->primitive_topology == topology)
+    resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, view->BufferLocation);
+    offset = view->BufferLocation - resource->gpu_address;
+    if (list->index_buffer == resource->u.vk_buffer && list->index_buffer_offset == offset
+            && list->index_type == index_type)
         return;
 
-    list->primitive_topology = topology;
-    d3d12_command_list_invalidate_current_pipeline(list);
+    list->index_buffer = resource->u.vk_buffer;
+    list->index_buffer_offset = offset;
+    list->index_type = index_type;
+    list->index_buffer_dirty = true;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_RSSetViewports(ID3D12GraphicsCommandList2 *iface,
-        UINT viewport_count, const D3D12_VIEWPORT *viewports)
+static void STDMETHODCALLTYPE d3d12_command_list_IASetVertexBuffers(ID3D12GraphicsCommandList2 *iface,
+        UINT start_slot, UINT view_count, const D3D12_VERTEX_BUFFER_VIEW *views)
 {
-    VkViewport vk_viewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
-    unsigned int i;
+    const struct vkd3d_null_resources *null_resources;
+    struct vkd3d_gpu_va_allocator *gpu_va_allocator;
+    unsigned int i, slot, stride;
+    struct d3d12_resource *resource;
+    bool invalidate = false;
+    VkDeviceSize offset;
+    VkBuffer buffer;
 
-    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    if (viewport_count > ARRAY_SIZE(vk_viewports))
+    null_resources = &list->device->null_resources;
+    gpu_va_allocator = &list->device->gpu_va_allocator;
+
+    if (!vkd3d_bound_range(start_slot, view_count, ARRAY_SIZE(list->strides)))
     {
-        FIXME("Viewport count %u > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE.\n", viewport_count);
-        viewport_count = ARRAY_SIZE(vk_viewports);
+        WARN("Invalid start slot %u / view count %u.\n", start_slot, view_count);
+        return;
     }
 
-    for (i = 0; i < viewport_count; ++i)
+    if (!views)
     {
-        vk_viewports[i].x = viewports[i].TopLeftX;
-        vk_viewports[i].y = viewports[i].TopLeftY + viewports[i].Height;
-        vk_viewports[i].width = viewports[i].Width;
-        vk_viewports[i].height = -viewports[i].Height;
-        vk_viewports[i].minDepth = viewports[i].MinDepth;
-        vk_viewports[i].maxDepth = viewports[i].MaxDepth;
+        WARN("NULL \"views\" pointer specified.\n");
+        return;
+    }
 
-        if (!vk_viewports[i].width || !vk_viewports[i].height)
+    for (i = 0; i < view_count; ++i)
+    {
+        slot = start_slot + i;
+        if (views[i].BufferLocation)
         {
-            FIXME_ONCE("Invalid viewport %u, ignoring RSSetViewports().\n", i);
-            return;
+            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferLocation);
+            buffer = resource->u.vk_buffer;
+            offset = views[i].BufferLocation - resource->gpu_address;
+            stride = views[i].StrideInBytes;
+        }
+        else
+        {
+            buffer = null_resources->vk_buffer;
+            offset = 0;
+            stride = 0;
+        }
+
+        if (list->vertex_buffers[slot] != buffer || list->vertex_buffer_offsets[slot] != offset)
+        {
+            list->vertex_buffers[slot] = buffer;
+            list->vertex_buffer_offsets[slot] = offset;
+            list->vertex_buffer_dirty_mask |= 1u << slot;
         }
+
+        invalidate |= list->strides[slot] != stride;
+        list->strides[slot] = stride;
     }
 
-    vk_procs = &list->device->vk_procs;
-    VK_CALL(vkCmdSetViewport(list->vk_command_buffer, 0, viewport_count, vk_viewports));
+    if (invalidate)
+        d3d12_command_list_invalidate_current_pipeline(list);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_RSSetScissorRects(ID3D12GraphicsCommandList2 *iface,
-        UINT rect_count, const D3D12_RECT *rects)
+static void STDMETHODCALLTYPE d3d12_command_list_SOSetTargets(ID3D12GraphicsCommandList2 *iface,
+        UINT start_slot, UINT view_count, const D3D12_STREAM_OUTPUT_BUFFER_VIEW *views)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    VkRect2D vk_rects[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    VkDeviceSize offsets[ARRAY_SIZE(list->so_counter_buffers)];
+    VkDeviceSize sizes[ARRAY_SIZE(list->so_counter_buffers)];
+    VkBuffer buffers[ARRAY_SIZE(list->so_counter_buffers)];
+    struct vkd3d_gpu_va_allocator *gpu_va_allocator;
     const struct vkd3d_vk_device_procs *vk_procs;
-    unsigned int i;
+    struct d3d12_resource *resource;
+    unsigned int i, first, count;
 
-    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    if (rect_count > ARRAY_SIZE(vk_rects))
+    d3d12_command_list_end_current_render_pass(list);
+
+    if (!list->device->vk_info.EXT_transform_feedback)
     {
-        FIXME("Rect count %u > D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE.\n", rect_count);
-        rect_count = ARRAY_SIZE(vk_rects);
+        FIXME("Transform feedback is not supported by Vulkan implementation.\n");
+        return;
     }
 
-    for (i = 0; i < rect_count; ++i)
+    if (!vkd3d_bound_range(start_slot, view_count, ARRAY_SIZE(buffers)))
     {
-        vk_rects[i].offset.x = rects[i].left;
-        vk_rects[i].offset.y = rects[i].top;
-        vk_rects[i].extent.width = rects[i].right - rects[i].left;
-        vk_rects[i].extent.height = rects[i].bottom - rects[i].top;
+        WARN("Invalid start slot %u / view count %u.\n", start_slot, view_count);
+        return;
     }
 
     vk_procs = &list->device->vk_procs;
-    VK_CALL(vkCmdSetScissor(list->vk_command_buffer, 0, rect_count, vk_rects));
-}
-
-static void STDMETHODCALLTYPE d3d12_command_list_OMSetBlendFactor(ID3D12GraphicsCommandList2 *iface,
-        const FLOAT blend_factor[4])
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
+    gpu_va_allocator = &list->device->gpu_va_allocator;
 
-    TRACE("iface %p, blend_factor %p.\n", iface, blend_factor);
+    count = 0;
+    first = start_slot;
+    for (i = 0; i < view_count; ++i)
+    {
+        if (views[i].BufferLocation && views[i].SizeInBytes)
+        {
+            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferLocation);
+            buffers[count] = resource->u.vk_buffer;
+            offsets[count] = views[i].BufferLocation - resource->gpu_address;
+            sizes[count] = views[i].SizeInBytes;
 
-    vk_procs = &list->device->vk_procs;
-    VK_CALL(vkCmdSetBlendConstants(list->vk_command_buffer, blend_factor));
-}
+            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferFilledSizeLocation);
+            list->so_counter_buffers[start_slot + i] = resource->u.vk_buffer;
+            list->so_counter_buffer_offsets[start_slot + i] = views[i].BufferFilledSizeLocation - resource->gpu_address;
+            ++count;
+        }
+        else
+        {
+            if (count)
+                VK_CALL(vkCmdBindTransformFeedbackBuffersEXT(d3d12_command_list_get_vk_command_buffer(list),
+                        first, count, buffers, offsets, sizes));
+            count = 0;
+            first = start_slot + i + 1;
 
-static void STDMETHODCALLTYPE d3d12_command_list_OMSetStencilRef(ID3D12GraphicsCommandList2 *iface,
-        UINT stencil_ref)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_vk_device_procs *vk_procs;
+            list->so_counter_buffers[start_slot + i] = VK_NULL_HANDLE;
+            list->so_counter_buffer_offsets[start_slot + i] = 0;
 
-    TRACE("iface %p, stencil_ref %u.\n", iface, stencil_ref);
+            WARN("Trying to unbind transform feedback buffer %u. Ignoring.\n", start_slot + i);
+        }
+    }
 
-    vk_procs = &list->device->vk_procs;
-    VK_CALL(vkCmdSetStencilReference(list->vk_command_buffer, VK_STENCIL_FRONT_AND_BACK, stencil_ref));
+    if (count)
+        VK_CALL(vkCmdBindTransformFeedbackBuffersEXT(d3d12_command_list_get_vk_command_buffer(list),
+                first, count, buffers, offsets, sizes));
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetPipelineState(ID3D12GraphicsCommandList2 *iface,
-        ID3D12PipelineState *pipeline_state)
+static void STDMETHODCALLTYPE d3d12_command_list_OMSetRenderTargets(ID3D12GraphicsCommandList2 *iface,
+        UINT render_target_descriptor_count, const D3D12_CPU_DESCRIPTOR_HANDLE *render_target_descriptors,
+        BOOL single_descriptor_handle, const D3D12_CPU_DESCRIPTOR_HANDLE *depth_stencil_descriptor)
 {
-    struct d3d12_pipeline_state *state = unsafe_impl_from_ID3D12PipelineState(pipeline_state);
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct d3d12_rtv_desc *rtv_desc;
+    const struct d3d12_dsv_desc *dsv_desc;
+    VkFormat prev_dsv_format;
+    struct vkd3d_view *view;
+    unsigned int i;
 
-    TRACE("iface %p, pipeline_state %p.\n", iface, pipeline_state);
+    TRACE("iface %p, render_target_descriptor_count %u, render_target_descriptors %p, "
+            "single_descriptor_handle %#x, depth_stencil_descriptor %p.\n",
+            iface, render_target_descriptor_count, render_target_descriptors,
+            single_descriptor_handle, depth_stencil_descriptor);
 
-    if (list->state == state)
-        return;
+    if (render_target_descriptor_count > ARRAY_SIZE(list->rtvs))
+    {
+        WARN("Descriptor count %u > %zu, ignoring extra descriptors.\n",
+                render_target_descriptor_count, ARRAY_SIZE(list->rtvs));
+        render_target_descriptor_count = ARRAY_SIZE(list->rtvs);
+    }
 
-    d3d12_command_list_invalidate_bindings(list, state);
-    d3d12_command_list_invalidate_current_pipeline(list);
+    list->fb_width = 0;
+    list->fb_height = 0;
+    list->fb_layer_count = 0;
+    for (i = 0; i < render_target_descriptor_count; ++i)
+    {
+        if (single_descriptor_handle)
+        {
+            if ((rtv_desc = d3d12_rtv_desc_from_cpu_handle(*render_target_descriptors)))
+                rtv_desc += i;
+        }
+        else
+        {
+            rtv_desc = d3d12_rtv_desc_from_cpu_handle(render_target_descriptors[i]);
+        }
 
-    list->state = state;
-}
+        if (!rtv_desc || !rtv_desc->resource)
+        {
+            WARN("RTV descriptor %u is not initialized.\n", i);
+            list->rtvs[i] = VK_NULL_HANDLE;
+            list->rtv_resources[i] = NULL;
+            list->rtv_views[i] = NULL;
+            continue;
+        }
 
-static bool is_ds_multiplanar_resolvable(unsigned int first_state, unsigned int second_state)
-{
-    /* Only combinations of depth/stencil read/write are supported. */
-    return first_state == second_state
-            || ((first_state & (D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_DEPTH_WRITE))
-            && (second_state & (D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_DEPTH_WRITE)));
-}
+        d3d12_command_list_track_resource_usage(list, rtv_desc->resource);
 
-static unsigned int d3d12_find_ds_multiplanar_transition(const D3D12_RESOURCE_BARRIER *barriers,
-        unsigned int i, unsigned int barrier_count, unsigned int sub_resource_count)
-{
-    unsigned int sub_resource_idx = barriers[i].u.Transition.Subresource;
-    unsigned int j;
+        /* In D3D12 CPU descriptors are consumed when a command is recorded. */
+        view = rtv_desc->view;
+        if (!d3d12_command_allocator_add_view(list->allocator, view))
+        {
+            WARN("Failed to add view.\n");
+        }
 
-    for (j = i + 1; j < barrier_count; ++j)
+        list->rtvs[i] = view->u.vk_image_view;
+        list->rtv_resources[i] = rtv_desc->resource;
+        list->rtv_views[i] = view;
+        list->fb_width = max(list->fb_width, rtv_desc->width);
+        list->fb_height = max(list->fb_height, rtv_desc->height);
+        list->fb_layer_count = max(list->fb_layer_count, rtv_desc->layer_count);
+    }
+
+    prev_dsv_format = list->dsv_format;
+    list->dsv = VK_NULL_HANDLE;
+    list->dsv_resource = NULL;
+    list->dsv_view = NULL;
+    list->dsv_format = VK_FORMAT_UNDEFINED;
+    if (depth_stencil_descriptor)
     {
-        if (barriers[j].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION
-                && barriers[j].u.Transition.pResource == barriers[i].u.Transition.pResource
-                && sub_resource_idx % sub_resource_count == barriers[j].u.Transition.Subresource % sub_resource_count)
+        if ((dsv_desc = d3d12_dsv_desc_from_cpu_handle(*depth_stencil_descriptor))
+                && dsv_desc->resource)
         {
-            /* Second barrier must be for a different plane. */
-            if (barriers[j].u.Transition.Subresource == sub_resource_idx)
-                return 0;
+            d3d12_command_list_track_resource_usage(list, dsv_desc->resource);
 
-            /* Validate the second barrier and check if the combination of two states is supported. */
-            if (!is_valid_resource_state(barriers[j].u.Transition.StateBefore)
-                    || !is_ds_multiplanar_resolvable(barriers[i].u.Transition.StateBefore, barriers[j].u.Transition.StateBefore)
-                    || !is_valid_resource_state(barriers[j].u.Transition.StateAfter)
-                    || !is_ds_multiplanar_resolvable(barriers[i].u.Transition.StateAfter, barriers[j].u.Transition.StateAfter)
-                    || barriers[j].u.Transition.Subresource >= sub_resource_count * 2u)
-                return 0;
+            /* In D3D12 CPU descriptors are consumed when a command is recorded. */
+            view = dsv_desc->view;
+            if (!d3d12_command_allocator_add_view(list->allocator, view))
+            {
+                WARN("Failed to add view.\n");
+                list->dsv = VK_NULL_HANDLE;
+            }
 
-            return j;
+            list->dsv = view->u.vk_image_view;
+            list->dsv_resource = dsv_desc->resource;
+            list->dsv_view = view;
+            list->fb_width = max(list->fb_width, dsv_desc->width);
+            list->fb_height = max(list->fb_height, dsv_desc->height);
+            list->fb_layer_count = max(list->fb_layer_count, dsv_desc->layer_count);
+            list->dsv_format = dsv_desc->format->vk_format;
+        }
+        else
+        {
+            WARN("DSV descriptor is not initialized.\n");
         }
     }
-    return 0;
+
+    if (prev_dsv_format != list->dsv_format && d3d12_pipeline_state_has_unknown_dsv_format(list->state))
+        d3d12_command_list_invalidate_current_pipeline(list);
+
+    d3d12_command_list_invalidate_current_framebuffer(list);
+    d3d12_command_list_invalidate_current_render_pass(list);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ResourceBarrier(ID3D12GraphicsCommandList2 *iface,
-        UINT barrier_count, const D3D12_RESOURCE_BARRIER *barriers)
+static bool d3d12_command_list_rects_cover_clear(const struct vkd3d_pending_clear *clear,
+        unsigned int rect_count, const D3D12_RECT *rects)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    bool have_aliasing_barriers = false, have_split_barriers = false;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    const struct vkd3d_vulkan_info *vk_info;
-    bool *multiplanar_handled = NULL;
-    unsigned int i;
+    if (!rect_count)
+        return true;
 
-    TRACE("iface %p, barrier_count %u, barriers %p.\n", iface, barrier_count, barriers);
+    return rect_count == 1 && rects[0].left <= 0 && rects[0].top <= 0
+            && rects[0].right >= (LONG)clear->width && rects[0].bottom >= (LONG)clear->height;
+}
 
-    vk_procs = &list->device->vk_procs;
-    vk_info = &list->device->vk_info;
+static void d3d12_command_list_clear(struct d3d12_command_list *list,
+        const struct vkd3d_pending_clear *clear, unsigned int rect_count, const D3D12_RECT *rects)
+{
+    struct vkd3d_pending_clear *pending;
+    bool is_full_clear;
+    size_t i;
 
     d3d12_command_list_end_current_render_pass(list);
 
-    for (i = 0; i < barrier_count; ++i)
+    /* In D3D12 CPU descriptors are consumed when a command is recorded. */
+    if (!d3d12_command_allocator_add_view(list->allocator, clear->view))
     {
-        unsigned int sub_resource_idx = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-        VkPipelineStageFlags src_stage_mask = 0, dst_stage_mask = 0;
-        VkAccessFlags src_access_mask = 0, dst_access_mask = 0;
-        const D3D12_RESOURCE_BARRIER *current = &barriers[i];
-        VkImageLayout layout_before, layout_after;
-        struct d3d12_resource *resource;
+        WARN("Failed to add view.\n");
+        d3d12_command_list_emit_clear(list, clear, rect_count, rects);
+        return;
+    }
 
-        have_split_barriers = have_split_barriers
-                || (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
-                || (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
+    is_full_clear = d3d12_command_list_rects_cover_clear(clear, rect_count, rects);
 
-        if (current->Flags & D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+    for (i = 0; i < list->pending_clear_count; ++i)
+    {
+        pending = &list->pending_clears[i];
+        if (pending->resource != clear->resource)
             continue;
 
-        switch (current->Type)
+        if (is_full_clear && pending->view == clear->view)
         {
-            case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
-            {
-                unsigned int state_before, state_after, stencil_state_before = 0, stencil_state_after = 0;
-                const D3D12_RESOURCE_TRANSITION_BARRIER *transition = &current->u.Transition;
+            if (clear->aspect_mask & VK_IMAGE_ASPECT_COLOR_BIT)
+                pending->value = clear->value;
+            if (clear->aspect_mask & VK_IMAGE_ASPECT_DEPTH_BIT)
+                pending->value.depthStencil.depth = clear->value.depthStencil.depth;
+            if (clear->aspect_mask & VK_IMAGE_ASPECT_STENCIL_BIT)
+                pending->value.depthStencil.stencil = clear->value.depthStencil.stencil;
+            pending->aspect_mask |= clear->aspect_mask;
+            return;
+        }
 
-                if (!is_valid_resource_state(transition->StateBefore))
-                {
-                    d3d12_command_list_mark_as_invalid(list,
-                            "Invalid StateBefore %#x (barrier %u).", transition->StateBefore, i);
-                    continue;
-                }
-                if (!is_valid_resource_state(transition->StateAfter))
-                {
-                    d3d12_command_list_mark_as_invalid(list,
-                            "Invalid StateAfter %#x (barrier %u).", transition->StateAfter, i);
-                    continue;
-                }
+        /* Views of the same resource may overlap. */
+        d3d12_command_list_emit_clear(list, pending, 0, NULL);
+        d3d12_command_list_remove_pending_clear(list, i);
+        break;
+    }
 
-                if (!(resource = unsafe_impl_from_ID3D12Resource(transition->pResource)))
-                {
-                    d3d12_command_list_mark_as_invalid(list, "A resource pointer is NULL.");
-                    continue;
-                }
+    if (!is_full_clear || !vkd3d_array_reserve((void **)&list->pending_clears, &list->pending_clears_size,
+            list->pending_clear_count + 1, sizeof(*list->pending_clears)))
+    {
+        d3d12_command_list_emit_clear(list, clear, rect_count, rects);
+        return;
+    }
 
-                if (multiplanar_handled && multiplanar_handled[i])
-                    continue;
+    list->pending_clears[list->pending_clear_count++] = *clear;
+}
 
-                state_before = transition->StateBefore;
-                state_after = transition->StateAfter;
+static void STDMETHODCALLTYPE d3d12_command_list_ClearDepthStencilView(ID3D12GraphicsCommandList2 *iface,
+        D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags, float depth, UINT8 stencil,
+        UINT rect_count, const D3D12_RECT *rects)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct d3d12_dsv_desc *dsv_desc = d3d12_dsv_desc_from_cpu_handle(dsv);
+    struct vkd3d_pending_clear clear;
 
-                sub_resource_idx = transition->Subresource;
+    TRACE("iface %p, dsv %#lx, flags %#x, depth %.8e, stencil 0x%02x, rect_count %u, rects %p.\n",
+            iface, dsv.ptr, flags, depth, stencil, rect_count, rects);
 
-                if (sub_resource_idx != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES
-                        && (resource->desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
-                {
-                    unsigned int sub_resource_count = d3d12_resource_desc_get_sub_resource_count(&resource->desc);
-                    unsigned int j = d3d12_find_ds_multiplanar_transition(barriers, i, barrier_count, sub_resource_count);
-                    if (j && (multiplanar_handled || (multiplanar_handled = vkd3d_calloc(barrier_count, sizeof(*multiplanar_handled)))))
-                    {
-                        multiplanar_handled[j] = true;
-                        if (sub_resource_idx >= sub_resource_count)
-                        {
-                            sub_resource_idx -= sub_resource_count;
-                            /* The stencil barrier is at i, depth at j. */
-                            state_before = barriers[j].u.Transition.StateBefore;
-                            state_after = barriers[j].u.Transition.StateAfter;
-                            stencil_state_before = transition->StateBefore;
-                            stencil_state_after = transition->StateAfter;
-                        }
-                        else
-                        {
-                            /* Depth at i, stencil at j. */
-                            stencil_state_before = barriers[j].u.Transition.StateBefore;
-                            stencil_state_after = barriers[j].u.Transition.StateAfter;
-                        }
-                    }
-                    else if (sub_resource_idx >= sub_resource_count)
-                    {
-                        FIXME_ONCE("Unhandled sub-resource idx %u.\n", sub_resource_idx);
-                        continue;
-                    }
-                }
+    d3d12_command_list_track_resource_usage(list, dsv_desc->resource);
 
-                if (!vk_barrier_parameters_from_d3d12_resource_state(state_before, stencil_state_before,
-                        resource, list->vk_queue_flags, vk_info, &src_access_mask, &src_stage_mask, &layout_before))
-                {
-                    FIXME("Unhandled state %#x.\n", state_before);
-                    continue;
-                }
-                if (!vk_barrier_parameters_from_d3d12_resource_state(state_after, stencil_state_after,
-                        resource, list->vk_queue_flags, vk_info, &dst_access_mask, &dst_stage_mask, &layout_after))
-                {
-                    FIXME("Unhandled state %#x.\n", state_after);
-                    continue;
-                }
+    clear.aspect_mask = 0;
+    if (flags & D3D12_CLEAR_FLAG_DEPTH)
+        clear.aspect_mask |= VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (flags & D3D12_CLEAR_FLAG_STENCIL)
+        clear.aspect_mask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    if (!clear.aspect_mask)
+        return;
 
-                TRACE("Transition barrier (resource %p, subresource %#x, before %#x, after %#x).\n",
-                        resource, transition->Subresource, transition->StateBefore, transition->StateAfter);
-                break;
-            }
+    clear.resource = dsv_desc->resource;
+    clear.view = dsv_desc->view;
+    clear.sample_count = dsv_desc->sample_count;
+    clear.width = dsv_desc->width;
+    clear.height = dsv_desc->height;
+    clear.layer_count = dsv_desc->layer_count;
+    clear.value.depthStencil.depth = depth;
+    clear.value.depthStencil.stencil = stencil;
 
-            case D3D12_RESOURCE_BARRIER_TYPE_UAV:
-            {
-                const D3D12_RESOURCE_UAV_BARRIER *uav = &current->u.UAV;
-                VkPipelineStageFlags stage_mask;
-                VkImageLayout image_layout;
-                VkAccessFlags access_mask;
+    d3d12_command_list_clear(list, &clear, rect_count, rects);
+}
 
-                resource = unsafe_impl_from_ID3D12Resource(uav->pResource);
-                vk_barrier_parameters_from_d3d12_resource_state(D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 0,
-                        resource, list->vk_queue_flags, vk_info, &access_mask, &stage_mask, &image_layout);
-                src_access_mask = dst_access_mask = access_mask;
-                src_stage_mask = dst_stage_mask = stage_mask;
-                layout_before = layout_after = image_layout;
+static void STDMETHODCALLTYPE d3d12_command_list_ClearRenderTargetView(ID3D12GraphicsCommandList2 *iface,
+        D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4], UINT rect_count, const D3D12_RECT *rects)
+{
+    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    const struct d3d12_rtv_desc *rtv_desc = d3d12_rtv_desc_from_cpu_handle(rtv);
+    struct vkd3d_pending_clear clear;
 
-                TRACE("UAV barrier (resource %p).\n", resource);
-                break;
-            }
+    TRACE("iface %p, rtv %#lx, color %p, rect_count %u, rects %p.\n",
+            iface, rtv.ptr, color, rect_count, rects);
 
-            case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
-                have_aliasing_barriers = true;
-                continue;
-            default:
-                WARN("Invalid barrier type %#x.\n", current->Type);
-                continue;
-        }
+    d3d12_command_list_track_resource_usage(list, rtv_desc->resource);
 
-        if (resource)
-            d3d12_command_list_track_resource_usage(list, resource);
+    clear.resource = rtv_desc->resource;
+    clear.view = rtv_desc->view;
+    clear.sample_count = rtv_desc->sample_count;
+    clear.width = rtv_desc->width;
+    clear.height = rtv_desc->height;
+    clear.layer_count = rtv_desc->layer_count;
+    clear.aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT;
 
-        if (!resource)
-        {
-            VkMemoryBarrier vk_barrier;
+    if (rtv_desc->format->type == VKD3D_FORMAT_TYPE_UINT)
+    {
+        clear.value.color.uint32[0] = max(0, color[0]);
+        clear.value.color.uint32[1] = max(0, color[1]);
+        clear.value.color.uint32[2] = max(0, color[2]);
+        clear.value.color.uint32[3] = max(0, color[3]);
+    }
+    else if (rtv_desc->format->type == VKD3D_FORMAT_TYPE_SINT)
+    {
+        clear.value.color.int32[0] = color[0];
+        clear.value.color.int32[1] = color[1];
+        clear.value.color.int32[2] = color[2];
+        clear.value.color.int32[3] = color[3];
+    }
+    else
+    {
+        clear.value.color.float32[0] = color[0];
+        clear.value.color.float32[1] = color[1];
+        clear.value.color.float32[2] = color[2];
+        clear.value.color.float32[3] = color[3];
+    }
 
-            vk_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-            vk_barrier.pNext = NULL;
-            vk_barrier.srcAccessMask = src_access_mask;
-            vk_barrier.dstAccessMask = dst_access_mask;
+    d3d12_command_list_clear(list, &clear, rect_count, rects);
+}
 
-            VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer, src_stage_mask, dst_stage_mask, 0,
-                    1, &vk_barrier, 0, NULL, 0, NULL));
-        }
-        else if (d3d12_resource_is_buffer(resource))
-        {
-            VkBufferMemoryBarrier vk_barrier;
+struct vkd3d_uav_clear_pipeline
+{
+    VkDescriptorSetLayout vk_set_layout;
+    VkPipelineLayout vk_pipeline_layout;
+    VkPipeline vk_pipeline;
+    VkExtent3D group_size;
+};
 
-            vk_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-            vk_barrier.pNext = NULL;
-            vk_barrier.srcAccessMask = src_access_mask;
-            vk_barrier.dstAccessMask = dst_access_mask;
-            vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            vk_barrier.buffer = resource->u.vk_buffer;
-            vk_barrier.offset = 0;
-            vk_barrier.size = VK_WHOLE_SIZE;
+static void vkd3d_uav_clear_state_get_buffer_pipeline(const struct vkd3d_uav_clear_state *state,
+        enum vkd3d_format_type format_type, struct vkd3d_uav_clear_pipeline *info)
+{
+    const struct vkd3d_uav_clear_pipelines *pipelines;
 
-            VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer, src_stage_mask, dst_stage_mask, 0,
-                    0, NULL, 1, &vk_barrier, 0, NULL));
-        }
-        else
-        {
-            VkImageMemoryBarrier vk_barrier;
+    pipelines = format_type == VKD3D_FORMAT_TYPE_UINT ? &state->pipelines_uint : &state->pipelines_float;
+    info->vk_set_layout = state->vk_set_layout_buffer;
+    info->vk_pipeline_layout = state->vk_pipeline_layout_buffer;
+    info->vk_pipeline = pipelines->buffer;
+    info->group_size = (VkExtent3D){128, 1, 1};
+}
 
-            vk_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-            vk_barrier.pNext = NULL;
-            vk_barrier.srcAccessMask = src_access_mask;
-            vk_barrier.dstAccessMask = dst_access_mask;
-            vk_barrier.oldLayout = layout_before;
-            vk_barrier.newLayout = layout_after;
-            vk_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            vk_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-            vk_barrier.image = resource->u.vk_image;
+static void vkd3d_uav_clear_state_get_image_pipeline(const struct vkd3d_uav_clear_state *state,
+        VkImageViewType image_view_type, enum vkd3d_format_type format_type, struct vkd3d_uav_clear_pipeline *info)
+{
+    const struct vkd3d_uav_clear_pipelines *pipelines;
 
-            vk_barrier.subresourceRange.aspectMask = resource->format->vk_aspect_mask;
-            if (sub_resource_idx == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
-            {
-                vk_barrier.subresourceRange.baseMipLevel = 0;
-                vk_barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
-                vk_barrier.subresourceRange.baseArrayLayer = 0;
-                vk_barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
-            }
-            else
-            {
-                /* FIXME: Some formats in D3D12 are planar. Each plane is a separate sub-resource. */
-                if (sub_resource_idx >= d3d12_resource_desc_get_sub_resource_count(&resource->desc))
-                {
-                    FIXME_ONCE("Unhandled sub-resource idx %u.\n", sub_resource_idx);
-                    continue;
-                }
+    pipelines = format_type == VKD3D_FORMAT_TYPE_UINT ? &state->pipelines_uint : &state->pipelines_float;
+    info->vk_set_layout = state->vk_set_layout_image;
+    info->vk_pipeline_layout = state->vk_pipeline_layout_image;
 
-                vk_barrier.subresourceRange.baseMipLevel = sub_resource_idx % resource->desc.MipLevels;
-                vk_barrier.subresourceRange.levelCount = 1;
-                vk_barrier.subresourceRange.baseArrayLayer = sub_resource_idx / resource->desc.MipLevels;
-                vk_barrier.subresourceRange.layerCount = 1;
-            }
+    switch (image_view_type)
+    {
+        case VK_IMAGE_VIEW_TYPE_1D:
+            info->vk_pipeline = pipelines->image_1d;
+            info->group_size = (VkExtent3D){64, 1, 1};
+            break;
+
+        case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
+            info->vk_pipeline = pipelines->image_1d_array;
+            info->group_size = (VkExtent3D){64, 1, 1};
+            break;
+
+        case VK_IMAGE_VIEW_TYPE_2D:
+            info->vk_pipeline = pipelines->image_2d;
+            info->group_size = (VkExtent3D){8, 8, 1};
+            break;
+
+        case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
+            info->vk_pipeline = pipelines->image_2d_array;
+            info->group_size = (VkExtent3D){8, 8, 1};
+            break;
 
-            VK_CALL(vkCmdPipelineBarrier(list->vk_command_buffer, src_stage_mask, dst_stage_mask, 0,
-                    0, NULL, 0, NULL, 1, &vk_barrier));
-        }
+        case VK_IMAGE_VIEW_TYPE_3D:
+            info->vk_pipeline = pipelines->image_3d;
+            info->group_size = (VkExtent3D){8, 8, 1};
+            break;
+
+        default:
+            ERR("Unhandled view type %#x.\n", image_view_type);
+            info->vk_pipeline = VK_NULL_HANDLE;
+            info->group_size = (VkExtent3D){0, 0, 0};
+            break;
     }
+}
 
-    vkd3d_free(multiplanar_handled);
+static void d3d12_command_list_clear_uav(struct d3d12_command_list *list,
+        struct d3d12_resource *resource, struct vkd3d_view *view, const VkClearColorValue *clear_colour,
+        unsigned int rect_count, const D3D12_RECT *rects)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
+    unsigned int i, miplevel_idx, layer_count;
+    struct vkd3d_uav_clear_pipeline pipeline;
+    struct vkd3d_uav_clear_args clear_args;
+    VkDescriptorImageInfo image_info;
+    D3D12_RECT full_rect, curr_rect;
+    VkWriteDescriptorSet write_set;
 
-    if (have_aliasing_barriers)
-        FIXME_ONCE("Aliasing barriers not implemented yet.\n");
+    d3d12_command_list_track_resource_usage(list, resource);
+    d3d12_command_list_end_current_render_pass(list);
 
-    /* Vulkan doesn't support split barriers. */
-    if (have_split_barriers)
-        WARN("Issuing split barrier(s) on D3D12_RESOURCE_BARRIER_FLAG_END_ONLY.\n");
-}
+    d3d12_command_list_invalidate_current_pipeline(list);
+    d3d12_command_list_invalidate_bindings(list, list->state);
+    d3d12_command_list_invalidate_root_parameters(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE);
+    d3d12_command_list_invalidate_push_constants(list, VKD3D_PIPELINE_BIND_POINT_COUNT);
 
-static void STDMETHODCALLTYPE d3d12_command_list_ExecuteBundle(ID3D12GraphicsCommandList2 *iface,
-        ID3D12GraphicsCommandList *command_list)
-{
-    FIXME("iface %p, command_list %p stub!\n", iface, command_list);
-}
+    if (!d3d12_command_allocator_add_view(list->allocator, view))
+        WARN("Failed to add view.\n");
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetDescriptorHeaps(ID3D12GraphicsCommandList2 *iface,
-        UINT heap_count, ID3D12DescriptorHeap *const *heaps)
-{
-    TRACE("iface %p, heap_count %u, heaps %p.\n", iface, heap_count, heaps);
+    clear_args.colour = *clear_colour;
 
-    /* Our current implementation does not need this method.
-     * In Windows it doesn't need to be called at all for correct operation, and
-     * at least on AMD the wrong heaps can be set here and tests still succeed.
-     *
-     * It could be used to validate descriptor tables but we do not have an
-     * equivalent of the D3D12 Debug Layer. */
-}
+    write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write_set.pNext = NULL;
+    write_set.dstBinding = 0;
+    write_set.dstArrayElement = 0;
+    write_set.descriptorCount = 1;
 
-static void d3d12_command_list_set_root_signature(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, const struct d3d12_root_signature *root_signature)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
+    if (d3d12_resource_is_buffer(resource))
+    {
+        write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+        write_set.pImageInfo = NULL;
+        write_set.pBufferInfo = NULL;
+        write_set.pTexelBufferView = &view->u.vk_buffer_view;
 
-    if (bindings->root_signature == root_signature)
-        return;
+        miplevel_idx = 0;
+        layer_count = 1;
+        vkd3d_uav_clear_state_get_buffer_pipeline(&list->device->uav_clear_state,
+                view->format->type, &pipeline);
+    }
+    else
+    {
+        image_info.sampler = VK_NULL_HANDLE;
+        image_info.imageView = view->u.vk_image_view;
+        image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-    bindings->root_signature = root_signature;
+        write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write_set.pImageInfo = &image_info;
+        write_set.pBufferInfo = NULL;
+        write_set.pTexelBufferView = NULL;
 
-    d3d12_command_list_invalidate_root_parameters(list, bind_point);
-}
+        miplevel_idx = view->info.texture.miplevel_idx;
+        layer_count = view->info.texture.vk_view_type == VK_IMAGE_VIEW_TYPE_3D
+                ? d3d12_resource_desc_get_depth(&resource->desc, miplevel_idx)
+                : view->info.texture.layer_count;
+        vkd3d_uav_clear_state_get_image_pipeline(&list->device->uav_clear_state,
+                view->info.texture.vk_view_type, view->format->type, &pipeline);
+    }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootSignature(ID3D12GraphicsCommandList2 *iface,
-        ID3D12RootSignature *root_signature)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    if (!(write_set.dstSet = d3d12_command_allocator_allocate_descriptor_set(
+            list->allocator, pipeline.vk_set_layout, 0, false)))
+    {
+        ERR("Failed to allocate descriptor set.\n");
+        return;
+    }
 
-    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
+    VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &write_set, 0, NULL));
 
-    d3d12_command_list_set_root_signature(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            unsafe_impl_from_ID3D12RootSignature(root_signature));
-}
+    full_rect.left = 0;
+    full_rect.right = d3d12_resource_desc_get_width(&resource->desc, miplevel_idx);
+    full_rect.top = 0;
+    full_rect.bottom = d3d12_resource_desc_get_height(&resource->desc, miplevel_idx);
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootSignature(ID3D12GraphicsCommandList2 *iface,
-        ID3D12RootSignature *root_signature)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    if (!rect_count)
+    {
+        rects = &full_rect;
+        rect_count = 1;
+    }
 
-    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
+    d3d12_command_list_bind_pipeline(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE, pipeline.vk_pipeline);
 
-    d3d12_command_list_set_root_signature(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            unsafe_impl_from_ID3D12RootSignature(root_signature));
-}
+    d3d12_command_list_cmd_bind_descriptor_sets(list, VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipeline.vk_pipeline_layout, 0, 1, &write_set.dstSet, 0, NULL);
 
-static void d3d12_command_list_set_descriptor_table(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    struct d3d12_desc *desc;
+    for (i = 0; i < rect_count; ++i)
+    {
+        /* Clamp to the actual resource region and skip empty rectangles. */
+        curr_rect.left = max(rects[i].left, full_rect.left);
+        curr_rect.top = max(rects[i].top, full_rect.top);
+        curr_rect.right = min(rects[i].right, full_rect.right);
+        curr_rect.bottom = min(rects[i].bottom, full_rect.bottom);
 
-    assert(root_signature_get_descriptor_table(root_signature, index));
+        if (curr_rect.left >= curr_rect.right || curr_rect.top >= curr_rect.bottom)
+            continue;
 
-    assert(index < ARRAY_SIZE(bindings->descriptor_tables));
-    desc = d3d12_desc_from_gpu_handle(base_descriptor);
+        clear_args.offset.x = curr_rect.left;
+        clear_args.offset.y = curr_rect.top;
+        clear_args.extent.width = curr_rect.right - curr_rect.left;
+        clear_args.extent.height = curr_rect.bottom - curr_rect.top;
 
-    if (bindings->descriptor_tables[index] == desc)
-        return;
+        d3d12_command_list_cmd_push_constants(list, pipeline.vk_pipeline_layout,
+                VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(clear_args), &clear_args);
 
-    bindings->descriptor_tables[index] = desc;
-    bindings->descriptor_table_dirty_mask |= (uint64_t)1 << index;
-    bindings->descriptor_table_active_mask |= (uint64_t)1 << index;
+        VK_CALL(vkCmdDispatch(d3d12_command_list_get_vk_command_buffer(list),
+                vkd3d_compute_workgroup_count(clear_args.extent.width, pipeline.group_size.width),
+                vkd3d_compute_workgroup_count(clear_args.extent.height, pipeline.group_size.height),
+                vkd3d_compute_workgroup_count(layer_count, pipeline.group_size.depth)));
+    }
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
+static const struct vkd3d_format *vkd3d_fixup_clear_uav_uint_colour(struct d3d12_device *device,
+        DXGI_FORMAT dxgi_format, VkClearColorValue *colour)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-
-    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
-            iface, root_parameter_index, base_descriptor.ptr);
+    switch (dxgi_format)
+    {
+        case DXGI_FORMAT_R11G11B10_FLOAT:
+            colour->uint32[0] = (colour->uint32[0] & 0x7ff)
+                    | ((colour->uint32[1] & 0x7ff) << 11)
+                    | ((colour->uint32[2] & 0x3ff) << 22);
+            return vkd3d_get_format(device, DXGI_FORMAT_R32_UINT, false);
 
-    d3d12_command_list_set_descriptor_table(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            root_parameter_index, base_descriptor);
+        default:
+            return NULL;
+    }
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
+static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewUint(ID3D12GraphicsCommandList2 *iface,
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
+        const UINT values[4], UINT rect_count, const D3D12_RECT *rects)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_device *device = list->device;
+    struct vkd3d_view *view, *uint_view = NULL;
+    struct vkd3d_texture_view_desc view_desc;
+    const struct vkd3d_format *uint_format;
+    struct d3d12_resource *resource_impl;
+    VkClearColorValue colour;
 
-    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
-            iface, root_parameter_index, base_descriptor.ptr);
+    TRACE("iface %p, gpu_handle %#"PRIx64", cpu_handle %lx, resource %p, values %p, rect_count %u, rects %p.\n",
+            iface, gpu_handle.ptr, cpu_handle.ptr, resource, values, rect_count, rects);
 
-    d3d12_command_list_set_descriptor_table(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            root_parameter_index, base_descriptor);
-}
+    resource_impl = unsafe_impl_from_ID3D12Resource(resource);
+    view = d3d12_desc_from_cpu_handle(cpu_handle)->s.u.view_info.view;
+    memcpy(colour.uint32, values, sizeof(colour.uint32));
 
-static void d3d12_command_list_set_root_constants(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, unsigned int offset,
-        unsigned int count, const void *data)
-{
-    const struct d3d12_root_signature *root_signature = list->pipeline_bindings[bind_point].root_signature;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct d3d12_root_constant *c;
+    if (view->format->type != VKD3D_FORMAT_TYPE_UINT)
+    {
+        if (!(uint_format = vkd3d_find_uint_format(device, view->format->dxgi_format))
+                && !(uint_format = vkd3d_fixup_clear_uav_uint_colour(device, view->format->dxgi_format, &colour)))
+        {
+            ERR("Unhandled format %#x.\n", view->format->dxgi_format);
+            return;
+        }
 
-    c = root_signature_get_32bit_constants(root_signature, index);
-    VK_CALL(vkCmdPushConstants(list->vk_command_buffer, root_signature->vk_pipeline_layout,
-            c->stage_flags, c->offset + offset * sizeof(uint32_t), count * sizeof(uint32_t), data));
+        if (d3d12_resource_is_buffer(resource_impl))
+        {
+            if (!vkd3d_create_buffer_view(device, resource_impl->u.vk_buffer, uint_format,
+                    view->info.buffer.offset, view->info.buffer.size, &uint_view))
+            {
+                ERR("Failed to create buffer view.\n");
+                return;
+            }
+        }
+        else
+        {
+            memset(&view_desc, 0, sizeof(view_desc));
+            view_desc.view_type = view->info.texture.vk_view_type;
+            view_desc.format = uint_format;
+            view_desc.miplevel_idx = view->info.texture.miplevel_idx;
+            view_desc.miplevel_count = 1;
+            view_desc.layer_idx = view->info.texture.layer_idx;
+            view_desc.layer_count = view->info.texture.layer_count;
+
+            if (!vkd3d_create_texture_view(device, resource_impl->u.vk_image, &view_desc, &uint_view))
+            {
+                ERR("Failed to create image view.\n");
+                return;
+            }
+        }
+        view = uint_view;
+    }
+
+    d3d12_command_list_clear_uav(list, resource_impl, view, &colour, rect_count, rects);
+
+    if (uint_view)
+        vkd3d_view_decref(uint_view, device);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, UINT data, UINT dst_offset)
+static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewFloat(ID3D12GraphicsCommandList2 *iface,
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
+        const float values[4], UINT rect_count, const D3D12_RECT *rects)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *resource_impl;
+    VkClearColorValue colour;
+    struct vkd3d_view *view;
+
+    TRACE("iface %p, gpu_handle %#"PRIx64", cpu_handle %lx, resource %p, values %p, rect_count %u, rects %p.\n",
+            iface, gpu_handle.ptr, cpu_handle.ptr, resource, values, rect_count, rects);
 
-    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
-            iface, root_parameter_index, data, dst_offset);
+    resource_impl = unsafe_impl_from_ID3D12Resource(resource);
+    view = d3d12_desc_from_cpu_handle(cpu_handle)->s.u.view_info.view;
+    memcpy(colour.float32, values, sizeof(colour.float32));
 
-    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            root_parameter_index, dst_offset, 1, &data);
+    d3d12_command_list_clear_uav(list, resource_impl, view, &colour, rect_count, rects);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, UINT data, UINT dst_offset)
+static bool vk_image_subresource_range_from_discard_region(const struct d3d12_resource *resource,
+        const D3D12_DISCARD_REGION *region, VkImageSubresourceRange *range)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    unsigned int sub_resource_count, first, count, level_count;
 
-    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
-            iface, root_parameter_index, data, dst_offset);
+    sub_resource_count = d3d12_resource_desc_get_sub_resource_count(&resource->desc);
+    level_count = resource->desc.MipLevels;
 
-    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            root_parameter_index, dst_offset, 1, &data);
-}
+    if (region)
+    {
+        first = region->FirstSubresource;
+        count = region->NumSubresources;
+    }
+    else
+    {
+        first = 0;
+        count = sub_resource_count * resource->format->plane_count;
+    }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    /* Depth and stencil planes are only discarded together. */
+    if (resource->format->plane_count > 1)
+    {
+        if (first || count != sub_resource_count * resource->format->plane_count)
+            return false;
+        count = sub_resource_count;
+    }
 
-    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
-            iface, root_parameter_index, constant_count, data, dst_offset);
+    if (!count || first + count > sub_resource_count)
+        return false;
 
-    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            root_parameter_index, dst_offset, constant_count, data);
+    range->aspectMask = resource->format->vk_aspect_mask;
+    if (!(first % level_count) && !(count % level_count))
+    {
+        range->baseMipLevel = 0;
+        range->levelCount = level_count;
+        range->baseArrayLayer = first / level_count;
+        range->layerCount = count / level_count;
+    }
+    else if (first % level_count + count <= level_count)
+    {
+        range->baseMipLevel = first % level_count;
+        range->levelCount = count;
+        range->baseArrayLayer = first / level_count;
+        range->layerCount = 1;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
-        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
+static void STDMETHODCALLTYPE d3d12_command_list_DiscardResource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *resource, const D3D12_DISCARD_REGION *region)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *resource_impl = unsafe_impl_from_ID3D12Resource(resource);
+    struct vkd3d_pending_discard *pending, discard;
+    size_t i;
 
-    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
-            iface, root_parameter_index, constant_count, data, dst_offset);
+    TRACE("iface %p, resource %p, region %p.\n", iface, resource, region);
 
-    d3d12_command_list_set_root_constants(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            root_parameter_index, dst_offset, constant_count, data);
-}
+    /* Discarding is a hint, the contents of the discarded regions are
+     * undefined afterwards. It's only tracked for render targets and depth
+     * stencils, which are written exclusively through render passes. */
+    if (!resource_impl || !d3d12_resource_is_texture(resource_impl)
+            || !(resource_impl->desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET
+            | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+            || (resource_impl->desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS))
+    {
+        TRACE("Ignoring discard of resource %p.\n", resource_impl);
+        return;
+    }
 
-static void d3d12_command_list_set_root_cbv(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_VIRTUAL_ADDRESS gpu_address)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
-    const struct d3d12_root_parameter *root_parameter;
-    struct VkWriteDescriptorSet descriptor_write;
-    struct VkDescriptorBufferInfo buffer_info;
-    struct d3d12_resource *resource;
+    if (region && region->NumRects)
+    {
+        TRACE("Ignoring discard of %u rects.\n", region->NumRects);
+        return;
+    }
 
-    root_parameter = root_signature_get_root_descriptor(root_signature, index);
-    assert(root_parameter->parameter_type == D3D12_ROOT_PARAMETER_TYPE_CBV);
+    if (!vk_image_subresource_range_from_discard_region(resource_impl, region, &discard.range))
+    {
+        TRACE("Ignoring discard of sub-resources %u-%u.\n",
+                region->FirstSubresource, region->FirstSubresource + region->NumSubresources);
+        return;
+    }
+    discard.resource = resource_impl;
 
-    resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, gpu_address);
-    buffer_info.buffer = resource->u.vk_buffer;
-    buffer_info.offset = gpu_address - resource->gpu_address;
-    buffer_info.range = resource->desc.Width - buffer_info.offset;
-    buffer_info.range = min(buffer_info.range, vk_info->device_limits.maxUniformBufferRange);
+    d3d12_command_list_track_resource_usage(list, resource_impl);
+    /* The next render pass must not load the discarded contents. */
+    d3d12_command_list_end_current_render_pass(list);
 
-    if (vk_info->KHR_push_descriptor)
+    /* Clears of discarded views don't need to be recorded. */
+    for (i = list->pending_clear_count; i--;)
     {
-        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
-                root_parameter, VK_NULL_HANDLE, NULL, &buffer_info);
-        VK_CALL(vkCmdPushDescriptorSetKHR(list->vk_command_buffer, bindings->vk_bind_point,
-                root_signature->vk_pipeline_layout, 0, 1, &descriptor_write));
+        if (list->pending_clears[i].resource == resource_impl
+                && vkd3d_pending_discard_covers_view(&discard, list->pending_clears[i].view))
+            d3d12_command_list_remove_pending_clear(list, i);
     }
-    else
+
+    if (d3d12_command_list_find_pending_discard(list, resource_impl, &i))
     {
-        d3d12_command_list_prepare_descriptors(list, bind_point);
-        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
-                root_parameter, bindings->descriptor_sets[0], NULL, &buffer_info);
-        VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &descriptor_write, 0, NULL));
+        /* Keep a single discard per resource. Merging partial discards
+         * isn't worth it. */
+        pending = &list->pending_discards[i];
+        if (vkd3d_pending_discard_covers_range(&discard, &pending->range))
+            *pending = discard;
+        return;
+    }
 
-        assert(index < ARRAY_SIZE(bindings->push_descriptors));
-        bindings->push_descriptors[index].u.cbv.vk_buffer = buffer_info.buffer;
-        bindings->push_descriptors[index].u.cbv.offset = buffer_info.offset;
-        bindings->push_descriptor_dirty_mask |= 1u << index;
-        bindings->push_descriptor_active_mask |= 1u << index;
+    if (!vkd3d_array_reserve((void **)&list->pending_discards, &list->pending_discards_size,
+            list->pending_discard_count + 1, sizeof(*list->pending_discards)))
+    {
+        WARN("Failed to allocate pending discard.\n");
+        return;
     }
+
+    list->pending_discards[list->pending_discard_count++] = discard;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootConstantBufferView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+static void STDMETHODCALLTYPE d3d12_command_list_BeginQuery(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
+    const struct vkd3d_vk_device_procs *vk_procs;
+    VkQueryControlFlags flags = 0;
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+    TRACE("iface %p, heap %p, type %#x, index %u.\n", iface, heap, type, index);
 
-    d3d12_command_list_set_root_cbv(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE, root_parameter_index, address);
+    vk_procs = &list->device->vk_procs;
+
+    d3d12_command_list_end_current_render_pass(list);
+
+    VK_CALL(vkCmdResetQueryPool(d3d12_command_list_get_vk_command_buffer(list), query_heap->vk_query_pool, index, 1));
+
+    if (type == D3D12_QUERY_TYPE_OCCLUSION)
+        flags = VK_QUERY_CONTROL_PRECISE_BIT;
+
+    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
+    {
+        unsigned int stream_index = type - D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0;
+        VK_CALL(vkCmdBeginQueryIndexedEXT(d3d12_command_list_get_vk_command_buffer(list),
+                query_heap->vk_query_pool, index, flags, stream_index));
+        return;
+    }
+
+    VK_CALL(vkCmdBeginQuery(d3d12_command_list_get_vk_command_buffer(list), query_heap->vk_query_pool, index, flags));
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootConstantBufferView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+static void STDMETHODCALLTYPE d3d12_command_list_EndQuery(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
+    const struct vkd3d_vk_device_procs *vk_procs;
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+    TRACE("iface %p, heap %p, type %#x, index %u.\n", iface, heap, type, index);
 
-    d3d12_command_list_set_root_cbv(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS, root_parameter_index, address);
-}
+    vk_procs = &list->device->vk_procs;
 
-static void d3d12_command_list_set_root_descriptor(struct d3d12_command_list *list,
-        enum vkd3d_pipeline_bind_point bind_point, unsigned int index, D3D12_GPU_VIRTUAL_ADDRESS gpu_address)
-{
-    struct vkd3d_pipeline_bindings *bindings = &list->pipeline_bindings[bind_point];
-    const struct d3d12_root_signature *root_signature = bindings->root_signature;
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
-    const struct d3d12_root_parameter *root_parameter;
-    struct VkWriteDescriptorSet descriptor_write;
-    VkDevice vk_device = list->device->vk_device;
-    VkBufferView vk_buffer_view;
+    d3d12_command_list_end_current_render_pass(list);
 
-    root_parameter = root_signature_get_root_descriptor(root_signature, index);
-    assert(root_parameter->parameter_type != D3D12_ROOT_PARAMETER_TYPE_CBV);
+    d3d12_query_heap_mark_result_as_available(query_heap, index);
 
-    /* FIXME: Re-use buffer views. */
-    if (!vkd3d_create_raw_buffer_view(list->device, gpu_address, &vk_buffer_view))
+    if (type == D3D12_QUERY_TYPE_TIMESTAMP)
     {
-        ERR("Failed to create buffer view.\n");
+        VK_CALL(vkCmdResetQueryPool(d3d12_command_list_get_vk_command_buffer(list),
+                query_heap->vk_query_pool, index, 1));
+        VK_CALL(vkCmdWriteTimestamp(d3d12_command_list_get_vk_command_buffer(list),
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_heap->vk_query_pool, index));
         return;
     }
 
-    if (!(d3d12_command_allocator_add_buffer_view(list->allocator, vk_buffer_view)))
+    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
     {
-        ERR("Failed to add buffer view.\n");
-        VK_CALL(vkDestroyBufferView(vk_device, vk_buffer_view, NULL));
+        unsigned int stream_index = type - D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0;
+        VK_CALL(vkCmdEndQueryIndexedEXT(d3d12_command_list_get_vk_command_buffer(list),
+                query_heap->vk_query_pool, index, stream_index));
         return;
     }
 
-    if (vk_info->KHR_push_descriptor)
-    {
-        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
-                root_parameter, VK_NULL_HANDLE, &vk_buffer_view, NULL);
-        VK_CALL(vkCmdPushDescriptorSetKHR(list->vk_command_buffer, bindings->vk_bind_point,
-                root_signature->vk_pipeline_layout, 0, 1, &descriptor_write));
-    }
-    else
-    {
-        d3d12_command_list_prepare_descriptors(list, bind_point);
-        vk_write_descriptor_set_from_root_descriptor(&descriptor_write,
-                root_parameter, bindings->descriptor_sets[0], &vk_buffer_view,  NULL);
-        VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &descriptor_write, 0, NULL));
-
-        assert(index < ARRAY_SIZE(bindings->push_descriptors));
-        bindings->push_descriptors[index].u.vk_buffer_view = vk_buffer_view;
-        bindings->push_descriptor_dirty_mask |= 1u << index;
-        bindings->push_descriptor_active_mask |= 1u << index;
-    }
+    VK_CALL(vkCmdEndQuery(d3d12_command_list_get_vk_command_buffer(list), query_heap->vk_query_pool, index));
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootShaderResourceView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+static size_t get_query_stride(D3D12_QUERY_TYPE type)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    if (type == D3D12_QUERY_TYPE_PIPELINE_STATISTICS)
+        return sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
+        return sizeof(D3D12_QUERY_DATA_SO_STATISTICS);
 
-    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            root_parameter_index, address);
+    return sizeof(uint64_t);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootShaderResourceView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+static void STDMETHODCALLTYPE d3d12_command_list_ResolveQueryData(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT start_index, UINT query_count,
+        ID3D12Resource *dst_buffer, UINT64 aligned_dst_buffer_offset)
 {
+    const struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *buffer = unsafe_impl_from_ID3D12Resource(dst_buffer);
+    const struct vkd3d_vk_device_procs *vk_procs;
+    unsigned int i, first, count;
+    VkDeviceSize offset, stride;
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+    TRACE("iface %p, heap %p, type %#x, start_index %u, query_count %u, "
+            "dst_buffer %p, aligned_dst_buffer_offset %#"PRIx64".\n",
+            iface, heap, type, start_index, query_count,
+            dst_buffer, aligned_dst_buffer_offset);
 
-    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            root_parameter_index, address);
-}
+    vk_procs = &list->device->vk_procs;
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetComputeRootUnorderedAccessView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    /* Vulkan is less strict than D3D12 here. Vulkan implementations are free
+     * to return any non-zero result for binary occlusion with at least one
+     * sample passing, while D3D12 guarantees that the result is 1 then.
+     *
+     * For example, the Nvidia binary blob drivers on Linux seem to always
+     * count precisely, even when it was signalled that non-precise is enough.
+     */
+    if (type == D3D12_QUERY_TYPE_BINARY_OCCLUSION)
+        FIXME_ONCE("D3D12 guarantees binary occlusion queries result in only 0 and 1.\n");
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+    if (!d3d12_resource_is_buffer(buffer))
+    {
+        WARN("Destination resource is not a buffer.\n");
+        return;
+    }
 
-    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE,
-            root_parameter_index, address);
-}
+    d3d12_command_list_end_current_render_pass(list);
+
+    stride = get_query_stride(type);
+
+    count = 0;
+    first = start_index;
+    offset = aligned_dst_buffer_offset;
+    for (i = 0; i < query_count; ++i)
+    {
+        if (d3d12_query_heap_is_result_available(query_heap, start_index + i))
+        {
+            ++count;
+        }
+        else
+        {
+            if (count)
+            {
+                VK_CALL(vkCmdCopyQueryPoolResults(d3d12_command_list_get_vk_command_buffer(list),
+                        query_heap->vk_query_pool, first, count, buffer->u.vk_buffer,
+                        offset, stride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+            }
+            count = 0;
+            first = start_index + i;
+            offset = aligned_dst_buffer_offset + i * stride;
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetGraphicsRootUnorderedAccessView(
-        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
-{
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+            /* We cannot copy query results if a query was not issued:
+             *
+             *   "If the query does not become available in a finite amount of
+             *   time (e.g. due to not issuing a query since the last reset),
+             *   a VK_ERROR_DEVICE_LOST error may occur."
+             */
+            VK_CALL(vkCmdFillBuffer(d3d12_command_list_get_vk_command_buffer(list),
+                    buffer->u.vk_buffer, offset, stride, 0x00000000));
 
-    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
-            iface, root_parameter_index, address);
+            ++first;
+            offset += stride;
+        }
+    }
 
-    d3d12_command_list_set_root_descriptor(list, VKD3D_PIPELINE_BIND_POINT_GRAPHICS,
-            root_parameter_index, address);
+    if (count)
+    {
+        VK_CALL(vkCmdCopyQueryPoolResults(d3d12_command_list_get_vk_command_buffer(list),
+                query_heap->vk_query_pool, first, count, buffer->u.vk_buffer,
+                offset, stride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+    }
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_IASetIndexBuffer(ID3D12GraphicsCommandList2 *iface,
-        const D3D12_INDEX_BUFFER_VIEW *view)
+static void STDMETHODCALLTYPE d3d12_command_list_SetPredication(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *buffer, UINT64 aligned_buffer_offset, D3D12_PREDICATION_OP operation)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_resource *resource = unsafe_impl_from_ID3D12Resource(buffer);
+    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
     const struct vkd3d_vk_device_procs *vk_procs;
-    struct d3d12_resource *resource;
-    enum VkIndexType index_type;
 
-    TRACE("iface %p, view %p.\n", iface, view);
+    TRACE("iface %p, buffer %p, aligned_buffer_offset %#"PRIx64", operation %#x.\n",
+            iface, buffer, aligned_buffer_offset, operation);
 
-    if (!view)
+    if (!vk_info->EXT_conditional_rendering)
     {
-        WARN("Ignoring NULL index buffer view.\n");
+        FIXME("Vulkan conditional rendering extension not present. Conditional rendering not supported.\n");
         return;
     }
 
     vk_procs = &list->device->vk_procs;
 
-    switch (view->Format)
+    /* FIXME: Add support for conditional rendering in render passes. */
+    d3d12_command_list_end_current_render_pass(list);
+
+    if (resource)
     {
-        case DXGI_FORMAT_R16_UINT:
-            index_type = VK_INDEX_TYPE_UINT16;
-            break;
-        case DXGI_FORMAT_R32_UINT:
-            index_type = VK_INDEX_TYPE_UINT32;
-            break;
-        default:
-            WARN("Invalid index format %#x.\n", view->Format);
+        VkConditionalRenderingBeginInfoEXT cond_info;
+
+        if (aligned_buffer_offset & (sizeof(uint64_t) - 1))
+        {
+            WARN("Unaligned predicate argument buffer offset %#"PRIx64".\n", aligned_buffer_offset);
+            return;
+        }
+
+        if (!d3d12_resource_is_buffer(resource))
+        {
+            WARN("Predicate arguments must be stored in a buffer resource.\n");
             return;
+        }
+
+        FIXME_ONCE("Predication doesn't support clear and copy commands, "
+                "and predication values are treated as 32-bit values.\n");
+
+        cond_info.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
+        cond_info.pNext = NULL;
+        cond_info.buffer = resource->u.vk_buffer;
+        cond_info.offset = aligned_buffer_offset;
+        switch (operation)
+        {
+            case D3D12_PREDICATION_OP_EQUAL_ZERO:
+                cond_info.flags = 0;
+                break;
+
+            case D3D12_PREDICATION_OP_NOT_EQUAL_ZERO:
+                cond_info.flags = VK_CONDITIONAL_RENDERING_INVERTED_BIT_EXT;
+                break;
+
+            default:
+                FIXME("Unhandled predication operation %#x.\n", operation);
+                return;
+        }
+
+        if (list->is_predicated)
+            VK_CALL(vkCmdEndConditionalRenderingEXT(d3d12_command_list_get_vk_command_buffer(list)));
+        VK_CALL(vkCmdBeginConditionalRenderingEXT(d3d12_command_list_get_vk_command_buffer(list), &cond_info));
+        list->is_predicated = true;
+    }
+    else if (list->is_predicated)
+    {
+        VK_CALL(vkCmdEndConditionalRenderingEXT(d3d12_command_list_get_vk_command_buffer(list)));
+        list->is_predicated = false;
     }
+}
 
-    list->index_buffer_format = view->Format;
+static void STDMETHODCALLTYPE d3d12_command_list_SetMarker(ID3D12GraphicsCommandList2 *iface,
+        UINT metadata, const void *data, UINT size)
+{
+    FIXME("iface %p, metadata %#x, data %p, size %u stub!\n", iface, metadata, data, size);
+}
 
-    resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, view->BufferLocation);
-    VK_CALL(vkCmdBindIndexBuffer(list->vk_command_buffer, resource->u.vk_buffer,
-            view->BufferLocation - resource->gpu_address, index_type));
+static void STDMETHODCALLTYPE d3d12_command_list_BeginEvent(ID3D12GraphicsCommandList2 *iface,
+        UINT metadata, const void *data, UINT size)
+{
+    FIXME("iface %p, metadata %#x, data %p, size %u stub!\n", iface, metadata, data, size);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_IASetVertexBuffers(ID3D12GraphicsCommandList2 *iface,
-        UINT start_slot, UINT view_count, const D3D12_VERTEX_BUFFER_VIEW *views)
+static void STDMETHODCALLTYPE d3d12_command_list_EndEvent(ID3D12GraphicsCommandList2 *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+}
+
+STATIC_ASSERT(sizeof(VkDispatchIndirectCommand) == sizeof(D3D12_DISPATCH_ARGUMENTS));
+STATIC_ASSERT(sizeof(VkDrawIndexedIndirectCommand) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+STATIC_ASSERT(sizeof(VkDrawIndirectCommand) == sizeof(D3D12_DRAW_ARGUMENTS));
+
+static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(ID3D12GraphicsCommandList2 *iface,
+        ID3D12CommandSignature *command_signature, UINT max_command_count, ID3D12Resource *arg_buffer,
+        UINT64 arg_buffer_offset, ID3D12Resource *count_buffer, UINT64 count_buffer_offset)
 {
+    struct d3d12_command_signature *sig_impl = unsafe_impl_from_ID3D12CommandSignature(command_signature);
+    struct d3d12_resource *count_impl = unsafe_impl_from_ID3D12Resource(count_buffer);
+    struct d3d12_resource *arg_impl = unsafe_impl_from_ID3D12Resource(arg_buffer);
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct vkd3d_null_resources *null_resources;
-    struct vkd3d_gpu_va_allocator *gpu_va_allocator;
-    VkDeviceSize offsets[ARRAY_SIZE(list->strides)];
+    const D3D12_COMMAND_SIGNATURE_DESC *signature_desc;
     const struct vkd3d_vk_device_procs *vk_procs;
-    VkBuffer buffers[ARRAY_SIZE(list->strides)];
-    struct d3d12_resource *resource;
-    bool invalidate = false;
-    unsigned int i, stride;
+    unsigned int i;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    TRACE("iface %p, command_signature %p, max_command_count %u, arg_buffer %p, "
+            "arg_buffer_offset %#"PRIx64", count_buffer %p, count_buffer_offset %#"PRIx64".\n",
+            iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
+            count_buffer, count_buffer_offset);
 
     vk_procs = &list->device->vk_procs;
-    null_resources = &list->device->null_resources;
-    gpu_va_allocator = &list->device->gpu_va_allocator;
 
-    if (!vkd3d_bound_range(start_slot, view_count, ARRAY_SIZE(list->strides)))
+    if (count_buffer && !list->device->vk_info.KHR_draw_indirect_count)
     {
-        WARN("Invalid start slot %u / view count %u.\n", start_slot, view_count);
+        FIXME("Count buffers not supported by Vulkan implementation.\n");
         return;
     }
 
-    if (!views)
+    signature_desc = &sig_impl->desc;
+    for (i = 0; i < signature_desc->NumArgumentDescs; ++i)
     {
-        WARN("NULL \"views\" pointer specified.\n");
-        return;
-    }
+        const D3D12_INDIRECT_ARGUMENT_DESC *arg_desc = &signature_desc->pArgumentDescs[i];
 
-    for (i = 0; i < view_count; ++i)
-    {
-        if (views[i].BufferLocation)
-        {
-            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferLocation);
-            buffers[i] = resource->u.vk_buffer;
-            offsets[i] = views[i].BufferLocation - resource->gpu_address;
-            stride = views[i].StrideInBytes;
-        }
-        else
+        switch (arg_desc->Type)
         {
-            buffers[i] = null_resources->vk_buffer;
-            offsets[i] = 0;
-            stride = 0;
-        }
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
+                if (!d3d12_command_list_begin_render_pass(list))
+                {
+                    WARN("Failed to begin render pass, ignoring draw.\n");
+                    break;
+                }
+
+                if (count_buffer)
+                {
+                    VK_CALL(vkCmdDrawIndirectCountKHR(d3d12_command_list_get_vk_command_buffer(list),
+                            arg_impl->u.vk_buffer,
+                            arg_buffer_offset, count_impl->u.vk_buffer, count_buffer_offset,
+                            max_command_count, signature_desc->ByteStride));
+                }
+                else
+                {
+                    VK_CALL(vkCmdDrawIndirect(d3d12_command_list_get_vk_command_buffer(list), arg_impl->u.vk_buffer,
+                            arg_buffer_offset, max_command_count, signature_desc->ByteStride));
+                }
+                break;
+
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
+                if (!d3d12_command_list_begin_render_pass(list))
+                {
+                    WARN("Failed to begin render pass, ignoring draw.\n");
+                    break;
+                }
+
+                d3d12_command_list_check_index_buffer_strip_cut_value(list);
+
+                if (count_buffer)
+                {
+                    VK_CALL(vkCmdDrawIndexedIndirectCountKHR(d3d12_command_list_get_vk_command_buffer(list),
+                            arg_impl->u.vk_buffer,
+                            arg_buffer_offset, count_impl->u.vk_buffer, count_buffer_offset,
+                            max_command_count, signature_desc->ByteStride));
+                }
+                else
+                {
+                    VK_CALL(vkCmdDrawIndexedIndirect(d3d12_command_list_get_vk_command_buffer(list),
+                            arg_impl->u.vk_buffer,
+                            arg_buffer_offset, max_command_count, signature_desc->ByteStride));
+                }
+                break;
+
+            case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
+                if (max_command_count != 1)
+                    FIXME("Ignoring command count %u.\n", max_command_count);
+
+                if (count_buffer)
+                {
+                    FIXME("Count buffers not supported for indirect dispatch.\n");
+                    break;
+                }
+
+                if (!d3d12_command_list_update_compute_state(list))
+                {
+                    WARN("Failed to update compute state, ignoring dispatch.\n");
+                    return;
+                }
+
+                VK_CALL(vkCmdDispatchIndirect(d3d12_command_list_get_vk_command_buffer(list),
+                        arg_impl->u.vk_buffer, arg_buffer_offset));
+                break;
 
-        invalidate |= list->strides[start_slot + i] != stride;
-        list->strides[start_slot + i] = stride;
+            default:
+                FIXME("Ignoring unhandled argument type %#x.\n", arg_desc->Type);
+                break;
+        }
     }
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_AtomicCopyBufferUINT(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst_buffer, UINT64 dst_offset,
+        ID3D12Resource *src_buffer, UINT64 src_offset,
+        UINT dependent_resource_count, ID3D12Resource * const *dependent_resources,
+        const D3D12_SUBRESOURCE_RANGE_UINT64 *dependent_sub_resource_ranges)
+{
+    FIXME("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
+            "src_offset %#"PRIx64", dependent_resource_count %u, "
+            "dependent_resources %p, dependent_sub_resource_ranges %p stub!\n",
+            iface, dst_buffer, dst_offset, src_buffer, src_offset,
+            dependent_resource_count, dependent_resources, dependent_sub_resource_ranges);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_AtomicCopyBufferUINT64(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst_buffer, UINT64 dst_offset,
+        ID3D12Resource *src_buffer, UINT64 src_offset,
+        UINT dependent_resource_count, ID3D12Resource * const *dependent_resources,
+        const D3D12_SUBRESOURCE_RANGE_UINT64 *dependent_sub_resource_ranges)
+{
+    FIXME("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
+            "src_offset %#"PRIx64", dependent_resource_count %u, "
+            "dependent_resources %p, dependent_sub_resource_ranges %p stub!\n",
+            iface, dst_buffer, dst_offset, src_buffer, src_offset,
+            dependent_resource_count, dependent_resources, dependent_sub_resource_ranges);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_OMSetDepthBounds(ID3D12GraphicsCommandList2 *iface,
+        FLOAT min, FLOAT max)
+{
+    FIXME("iface %p, min %.8e, max %.8e stub!\n", iface, min, max);
+}
+
+static void STDMETHODCALLTYPE d3d12_command_list_SetSamplePositions(ID3D12GraphicsCommandList2 *iface,
+        UINT sample_count, UINT pixel_count, D3D12_SAMPLE_POSITION *sample_positions)
+{
+    FIXME("iface %p, sample_count %u, pixel_count %u, sample_positions %p stub!\n",
+            iface, sample_count, pixel_count, sample_positions);
+}
 
-    if (view_count)
-        VK_CALL(vkCmdBindVertexBuffers(list->vk_command_buffer, start_slot, view_count, buffers, offsets));
+static void STDMETHODCALLTYPE d3d12_command_list_ResolveSubresourceRegion(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst_resource, UINT dst_sub_resource_idx, UINT dst_x, UINT dst_y,
+        ID3D12Resource *src_resource, UINT src_sub_resource_idx,
+        D3D12_RECT *src_rect, DXGI_FORMAT format, D3D12_RESOLVE_MODE mode)
+{
+    FIXME("iface %p, dst_resource %p, dst_sub_resource_idx %u, "
+            "dst_x %u, dst_y %u, src_resource %p, src_sub_resource_idx %u, "
+            "src_rect %p, format %#x, mode %#x stub!\n",
+            iface, dst_resource, dst_sub_resource_idx, dst_x, dst_y,
+            src_resource, src_sub_resource_idx, src_rect, format, mode);
+}
 
-    if (invalidate)
-        d3d12_command_list_invalidate_current_pipeline(list);
+static void STDMETHODCALLTYPE d3d12_command_list_SetViewInstanceMask(ID3D12GraphicsCommandList2 *iface, UINT mask)
+{
+    FIXME("iface %p, mask %#x stub!\n", iface, mask);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SOSetTargets(ID3D12GraphicsCommandList2 *iface,
-        UINT start_slot, UINT view_count, const D3D12_STREAM_OUTPUT_BUFFER_VIEW *views)
+static void STDMETHODCALLTYPE d3d12_command_list_WriteBufferImmediate(ID3D12GraphicsCommandList2 *iface,
+        UINT count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER *parameters,
+        const D3D12_WRITEBUFFERIMMEDIATE_MODE *modes)
 {
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    VkDeviceSize offsets[ARRAY_SIZE(list->so_counter_buffers)];
-    VkDeviceSize sizes[ARRAY_SIZE(list->so_counter_buffers)];
-    VkBuffer buffers[ARRAY_SIZE(list->so_counter_buffers)];
-    struct vkd3d_gpu_va_allocator *gpu_va_allocator;
-    const struct vkd3d_vk_device_procs *vk_procs;
     struct d3d12_resource *resource;
-    unsigned int i, first, count;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
-
-    d3d12_command_list_end_current_render_pass(list);
+    unsigned int i;
 
-    if (!list->device->vk_info.EXT_transform_feedback)
-    {
-        FIXME("Transform feedback is not supported by Vulkan implementation.\n");
-        return;
-    }
+    FIXME("iface %p, count %u, parameters %p, modes %p stub!\n", iface, count, parameters, modes);
 
-    if (!vkd3d_bound_range(start_slot, view_count, ARRAY_SIZE(buffers)))
+    for (i = 0; i < count; ++i)
     {
-        WARN("Invalid start slot %u / view count %u.\n", start_slot, view_count);
-        return;
+        resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, parameters[i].Dest);
+        d3d12_command_list_track_resource_usage(list, resource);
     }
+}
 
-    vk_procs = &list->device->vk_procs;
-    gpu_va_allocator = &list->device->gpu_va_allocator;
+/* ID3D12GraphicsCommandList bundles
+ *
+ * Bundles inherit most of their state from the command list executing them,
+ * and state set by a bundle persists in that command list afterwards. Vulkan
+ * secondary command buffers inherit neither dynamic state nor bound pipelines
+ * and descriptor sets, so bundles are recorded as a list of API calls which
+ * ExecuteBundle() replays on the calling command list. */
+struct d3d12_bundle_command
+{
+    void (*execute)(struct d3d12_command_list *list, const struct d3d12_bundle_command *command);
+    size_t size;
+};
 
-    count = 0;
-    first = start_slot;
-    for (i = 0; i < view_count; ++i)
-    {
-        if (views[i].BufferLocation && views[i].SizeInBytes)
-        {
-            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferLocation);
-            buffers[count] = resource->u.vk_buffer;
-            offsets[count] = views[i].BufferLocation - resource->gpu_address;
-            sizes[count] = views[i].SizeInBytes;
+struct d3d12_bundle_draw
+{
+    struct d3d12_bundle_command command;
+    UINT vertex_count_per_instance;
+    UINT instance_count;
+    UINT start_vertex_location;
+    UINT start_instance_location;
+};
 
-            resource = vkd3d_gpu_va_allocator_dereference(gpu_va_allocator, views[i].BufferFilledSizeLocation);
-            list->so_counter_buffers[start_slot + i] = resource->u.vk_buffer;
-            list->so_counter_buffer_offsets[start_slot + i] = views[i].BufferFilledSizeLocation - resource->gpu_address;
-            ++count;
-        }
-        else
-        {
-            if (count)
-                VK_CALL(vkCmdBindTransformFeedbackBuffersEXT(list->vk_command_buffer, first, count, buffers, offsets, sizes));
-            count = 0;
-            first = start_slot + i + 1;
+struct d3d12_bundle_draw_indexed
+{
+    struct d3d12_bundle_command command;
+    UINT index_count_per_instance;
+    UINT instance_count;
+    UINT start_index_location;
+    INT base_vertex_location;
+    UINT start_instance_location;
+};
 
-            list->so_counter_buffers[start_slot + i] = VK_NULL_HANDLE;
-            list->so_counter_buffer_offsets[start_slot + i] = 0;
+struct d3d12_bundle_dispatch
+{
+    struct d3d12_bundle_command command;
+    UINT x, y, z;
+};
 
-            WARN("Trying to unbind transform feedback buffer %u. Ignoring.\n", start_slot + i);
-        }
-    }
+struct d3d12_bundle_set_primitive_topology
+{
+    struct d3d12_bundle_command command;
+    D3D12_PRIMITIVE_TOPOLOGY topology;
+};
 
-    if (count)
-        VK_CALL(vkCmdBindTransformFeedbackBuffersEXT(list->vk_command_buffer, first, count, buffers, offsets, sizes));
-}
+struct d3d12_bundle_set_blend_factor
+{
+    struct d3d12_bundle_command command;
+    FLOAT blend_factor[4];
+};
 
-static void STDMETHODCALLTYPE d3d12_command_list_OMSetRenderTargets(ID3D12GraphicsCommandList2 *iface,
-        UINT render_target_descriptor_count, const D3D12_CPU_DESCRIPTOR_HANDLE *render_target_descriptors,
-        BOOL single_descriptor_handle, const D3D12_CPU_DESCRIPTOR_HANDLE *depth_stencil_descriptor)
+struct d3d12_bundle_set_stencil_ref
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct d3d12_rtv_desc *rtv_desc;
-    const struct d3d12_dsv_desc *dsv_desc;
-    VkFormat prev_dsv_format;
-    struct vkd3d_view *view;
-    unsigned int i;
+    struct d3d12_bundle_command command;
+    UINT stencil_ref;
+};
 
-    TRACE("iface %p, render_target_descriptor_count %u, render_target_descriptors %p, "
-            "single_descriptor_handle %#x, depth_stencil_descriptor %p.\n",
-            iface, render_target_descriptor_count, render_target_descriptors,
-            single_descriptor_handle, depth_stencil_descriptor);
+struct d3d12_bundle_set_pipeline_state
+{
+    struct d3d12_bundle_command command;
+    ID3D12PipelineState *pipeline_state;
+};
 
-    if (render_target_descriptor_count > ARRAY_SIZE(list->rtvs))
-    {
-        WARN("Descriptor count %u > %zu, ignoring extra descriptors.\n",
-                render_target_descriptor_count, ARRAY_SIZE(list->rtvs));
-        render_target_descriptor_count = ARRAY_SIZE(list->rtvs);
-    }
+struct d3d12_bundle_set_root_signature
+{
+    struct d3d12_bundle_command command;
+    void (STDMETHODCALLTYPE *set_root_signature)(ID3D12GraphicsCommandList2 *iface,
+            ID3D12RootSignature *root_signature);
+    ID3D12RootSignature *root_signature;
+};
 
-    list->fb_width = 0;
-    list->fb_height = 0;
-    list->fb_layer_count = 0;
-    for (i = 0; i < render_target_descriptor_count; ++i)
-    {
-        if (single_descriptor_handle)
-        {
-            if ((rtv_desc = d3d12_rtv_desc_from_cpu_handle(*render_target_descriptors)))
-                rtv_desc += i;
-        }
-        else
-        {
-            rtv_desc = d3d12_rtv_desc_from_cpu_handle(render_target_descriptors[i]);
-        }
+struct d3d12_bundle_set_root_descriptor_table
+{
+    struct d3d12_bundle_command command;
+    void (STDMETHODCALLTYPE *set_root_descriptor_table)(ID3D12GraphicsCommandList2 *iface,
+            UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor);
+    UINT root_parameter_index;
+    D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor;
+};
 
-        if (!rtv_desc || !rtv_desc->resource)
-        {
-            WARN("RTV descriptor %u is not initialized.\n", i);
-            list->rtvs[i] = VK_NULL_HANDLE;
-            continue;
-        }
+struct d3d12_bundle_set_root_constants
+{
+    struct d3d12_bundle_command command;
+    void (STDMETHODCALLTYPE *set_root_constants)(ID3D12GraphicsCommandList2 *iface,
+            UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset);
+    UINT root_parameter_index;
+    UINT constant_count;
+    UINT dst_offset;
+    uint32_t data[];
+};
 
-        d3d12_command_list_track_resource_usage(list, rtv_desc->resource);
+struct d3d12_bundle_set_root_view
+{
+    struct d3d12_bundle_command command;
+    void (STDMETHODCALLTYPE *set_root_view)(ID3D12GraphicsCommandList2 *iface,
+            UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address);
+    UINT root_parameter_index;
+    D3D12_GPU_VIRTUAL_ADDRESS address;
+};
 
-        /* In D3D12 CPU descriptors are consumed when a command is recorded. */
-        view = rtv_desc->view;
-        if (!d3d12_command_allocator_add_view(list->allocator, view))
-        {
-            WARN("Failed to add view.\n");
-        }
+struct d3d12_bundle_set_index_buffer
+{
+    struct d3d12_bundle_command command;
+    bool has_view;
+    D3D12_INDEX_BUFFER_VIEW view;
+};
 
-        list->rtvs[i] = view->u.vk_image_view;
-        list->fb_width = max(list->fb_width, rtv_desc->width);
-        list->fb_height = max(list->fb_height, rtv_desc->height);
-        list->fb_layer_count = max(list->fb_layer_count, rtv_desc->layer_count);
-    }
+struct d3d12_bundle_set_vertex_buffers
+{
+    struct d3d12_bundle_command command;
+    UINT start_slot;
+    UINT view_count;
+    bool has_views;
+    D3D12_VERTEX_BUFFER_VIEW views[];
+};
 
-    prev_dsv_format = list->dsv_format;
-    list->dsv = VK_NULL_HANDLE;
-    list->dsv_format = VK_FORMAT_UNDEFINED;
-    if (depth_stencil_descriptor)
-    {
-        if ((dsv_desc = d3d12_dsv_desc_from_cpu_handle(*depth_stencil_descriptor))
-                && dsv_desc->resource)
-        {
-            d3d12_command_list_track_resource_usage(list, dsv_desc->resource);
+struct d3d12_bundle_execute_indirect
+{
+    struct d3d12_bundle_command command;
+    ID3D12CommandSignature *command_signature;
+    UINT max_command_count;
+    ID3D12Resource *arg_buffer;
+    UINT64 arg_buffer_offset;
+    ID3D12Resource *count_buffer;
+    UINT64 count_buffer_offset;
+};
 
-            /* In D3D12 CPU descriptors are consumed when a command is recorded. */
-            view = dsv_desc->view;
-            if (!d3d12_command_allocator_add_view(list->allocator, view))
-            {
-                WARN("Failed to add view.\n");
-                list->dsv = VK_NULL_HANDLE;
-            }
+static void *d3d12_bundle_add_command(struct d3d12_command_list *bundle,
+        void (*execute)(struct d3d12_command_list *list, const struct d3d12_bundle_command *command), size_t size)
+{
+    struct d3d12_bundle_command *command;
 
-            list->dsv = view->u.vk_image_view;
-            list->fb_width = max(list->fb_width, dsv_desc->width);
-            list->fb_height = max(list->fb_height, dsv_desc->height);
-            list->fb_layer_count = max(list->fb_layer_count, dsv_desc->layer_count);
-            list->dsv_format = dsv_desc->format->vk_format;
-        }
-        else
-        {
-            WARN("DSV descriptor is not initialized.\n");
-        }
+    size = align(size, sizeof(uint64_t));
+    if (!vkd3d_array_reserve((void **)&bundle->bundle_data, &bundle->bundle_data_size,
+            bundle->bundle_size + size, 1))
+    {
+        ERR("Failed to allocate bundle command.\n");
+        bundle->is_valid = false;
+        return NULL;
     }
 
-    if (prev_dsv_format != list->dsv_format && d3d12_pipeline_state_has_unknown_dsv_format(list->state))
-        d3d12_command_list_invalidate_current_pipeline(list);
+    command = (struct d3d12_bundle_command *)&bundle->bundle_data[bundle->bundle_size];
+    command->execute = execute;
+    command->size = size;
+    bundle->bundle_size += size;
 
-    d3d12_command_list_invalidate_current_framebuffer(list);
-    d3d12_command_list_invalidate_current_render_pass(list);
+    return command;
 }
 
-static void d3d12_command_list_clear(struct d3d12_command_list *list,
-        const struct VkAttachmentDescription *attachment_desc,
-        const struct VkAttachmentReference *color_reference, const struct VkAttachmentReference *ds_reference,
-        struct vkd3d_view *view, size_t width, size_t height, unsigned int layer_count,
-        const union VkClearValue *clear_value, unsigned int rect_count, const D3D12_RECT *rects)
+static void d3d12_bundle_invalid_command(ID3D12GraphicsCommandList2 *iface, const char *name)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    struct VkSubpassDescription sub_pass_desc;
-    struct VkRenderPassCreateInfo pass_desc;
-    struct VkRenderPassBeginInfo begin_desc;
-    struct VkFramebufferCreateInfo fb_desc;
-    VkFramebuffer vk_framebuffer;
-    VkRenderPass vk_render_pass;
-    D3D12_RECT full_rect;
-    unsigned int i;
-    VkResult vr;
-
-    d3d12_command_list_end_current_render_pass(list);
-
-    if (!rect_count)
-    {
-        full_rect.top = 0;
-        full_rect.left = 0;
-        full_rect.bottom = height;
-        full_rect.right = width;
-
-        rect_count = 1;
-        rects = &full_rect;
-    }
-
-    sub_pass_desc.flags = 0;
-    sub_pass_desc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    sub_pass_desc.inputAttachmentCount = 0;
-    sub_pass_desc.pInputAttachments = NULL;
-    sub_pass_desc.colorAttachmentCount = !!color_reference;
-    sub_pass_desc.pColorAttachments = color_reference;
-    sub_pass_desc.pResolveAttachments = NULL;
-    sub_pass_desc.pDepthStencilAttachment = ds_reference;
-    sub_pass_desc.preserveAttachmentCount = 0;
-    sub_pass_desc.pPreserveAttachments = NULL;
-
-    pass_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    pass_desc.pNext = NULL;
-    pass_desc.flags = 0;
-    pass_desc.attachmentCount = 1;
-    pass_desc.pAttachments = attachment_desc;
-    pass_desc.subpassCount = 1;
-    pass_desc.pSubpasses = &sub_pass_desc;
-    pass_desc.dependencyCount = 0;
-    pass_desc.pDependencies = NULL;
-    if ((vr = VK_CALL(vkCreateRenderPass(list->device->vk_device, &pass_desc, NULL, &vk_render_pass))) < 0)
-    {
-        WARN("Failed to create Vulkan render pass, vr %d.\n", vr);
-        return;
-    }
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    if (!d3d12_command_allocator_add_render_pass(list->allocator, vk_render_pass))
-    {
-        WARN("Failed to add render pass.\n");
-        VK_CALL(vkDestroyRenderPass(list->device->vk_device, vk_render_pass, NULL));
-        return;
-    }
+    WARN("iface %p, %s() is not allowed in bundles.\n", iface, name);
 
-    if (!d3d12_command_allocator_add_view(list->allocator, view))
-    {
-        WARN("Failed to add view.\n");
-    }
+    bundle->is_valid = false;
+}
 
-    fb_desc.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    fb_desc.pNext = NULL;
-    fb_desc.flags = 0;
-    fb_desc.renderPass = vk_render_pass;
-    fb_desc.attachmentCount = 1;
-    fb_desc.pAttachments = &view->u.vk_image_view;
-    fb_desc.width = width;
-    fb_desc.height = height;
-    fb_desc.layers = layer_count;
-    if ((vr = VK_CALL(vkCreateFramebuffer(list->device->vk_device, &fb_desc, NULL, &vk_framebuffer))) < 0)
-    {
-        WARN("Failed to create Vulkan framebuffer, vr %d.\n", vr);
-        return;
-    }
+static void d3d12_bundle_execute_set_pipeline_state(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_pipeline_state *args = (const void *)command;
 
-    if (!d3d12_command_allocator_add_framebuffer(list->allocator, vk_framebuffer))
-    {
-        WARN("Failed to add framebuffer.\n");
-        VK_CALL(vkDestroyFramebuffer(list->device->vk_device, vk_framebuffer, NULL));
-        return;
-    }
+    d3d12_command_list_SetPipelineState(&list->ID3D12GraphicsCommandList2_iface, args->pipeline_state);
+}
 
-    begin_desc.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    begin_desc.pNext = NULL;
-    begin_desc.renderPass = vk_render_pass;
-    begin_desc.framebuffer = vk_framebuffer;
-    begin_desc.clearValueCount = 1;
-    begin_desc.pClearValues = clear_value;
+static void d3d12_bundle_record_set_pipeline_state(struct d3d12_command_list *bundle,
+        ID3D12PipelineState *pipeline_state)
+{
+    struct d3d12_bundle_set_pipeline_state *args;
 
-    for (i = 0; i < rect_count; ++i)
-    {
-        begin_desc.renderArea.offset.x = rects[i].left;
-        begin_desc.renderArea.offset.y = rects[i].top;
-        begin_desc.renderArea.extent.width = rects[i].right - rects[i].left;
-        begin_desc.renderArea.extent.height = rects[i].bottom - rects[i].top;
-        VK_CALL(vkCmdBeginRenderPass(list->vk_command_buffer, &begin_desc, VK_SUBPASS_CONTENTS_INLINE));
-        VK_CALL(vkCmdEndRenderPass(list->vk_command_buffer));
-    }
+    if ((args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_pipeline_state, sizeof(*args))))
+        args->pipeline_state = pipeline_state;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ClearDepthStencilView(ID3D12GraphicsCommandList2 *iface,
-        D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags, float depth, UINT8 stencil,
-        UINT rect_count, const D3D12_RECT *rects)
+static void d3d12_bundle_reset_state(struct d3d12_command_list *bundle,
+        ID3D12PipelineState *initial_pipeline_state)
 {
-    const union VkClearValue clear_value = {.depthStencil = {depth, stencil}};
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct d3d12_dsv_desc *dsv_desc = d3d12_dsv_desc_from_cpu_handle(dsv);
-    struct VkAttachmentDescription attachment_desc;
-    struct VkAttachmentReference ds_reference;
+    bundle->bundle_size = 0;
+    bundle->is_recording = true;
+    bundle->is_valid = true;
 
-    TRACE("iface %p, dsv %#lx, flags %#x, depth %.8e, stencil 0x%02x, rect_count %u, rects %p.\n",
-            iface, dsv.ptr, flags, depth, stencil, rect_count, rects);
+    if (initial_pipeline_state)
+        d3d12_bundle_record_set_pipeline_state(bundle, initial_pipeline_state);
+}
 
-    d3d12_command_list_track_resource_usage(list, dsv_desc->resource);
+static HRESULT STDMETHODCALLTYPE d3d12_bundle_Close(ID3D12GraphicsCommandList2 *iface)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    attachment_desc.flags = 0;
-    attachment_desc.format = dsv_desc->format->vk_format;
-    attachment_desc.samples = dsv_desc->sample_count;
-    if (flags & D3D12_CLEAR_FLAG_DEPTH)
+    TRACE("iface %p.\n", iface);
+
+    if (!bundle->is_recording)
     {
-        attachment_desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        WARN("Bundle is not in the recording state.\n");
+        return E_FAIL;
     }
-    else
+
+    bundle->is_recording = false;
+
+    if (!bundle->is_valid)
     {
-        attachment_desc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        WARN("Error occurred during bundle recording.\n");
+        return E_INVALIDARG;
     }
-    if (flags & D3D12_CLEAR_FLAG_STENCIL)
+
+    return S_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_bundle_Reset(ID3D12GraphicsCommandList2 *iface,
+        ID3D12CommandAllocator *allocator, ID3D12PipelineState *initial_pipeline_state)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+
+    TRACE("iface %p, allocator %p, initial_pipeline_state %p.\n",
+            iface, allocator, initial_pipeline_state);
+
+    if (!allocator)
     {
-        attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+        WARN("Command allocator is NULL.\n");
+        return E_INVALIDARG;
     }
-    else
+
+    if (bundle->is_recording)
     {
-        attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        WARN("Bundle is in the recording state.\n");
+        return E_FAIL;
     }
-    attachment_desc.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-    attachment_desc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
-    ds_reference.attachment = 0;
-    ds_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    d3d12_bundle_reset_state(bundle, initial_pipeline_state);
 
-    d3d12_command_list_clear(list, &attachment_desc, NULL, &ds_reference,
-            dsv_desc->view, dsv_desc->width, dsv_desc->height, dsv_desc->layer_count,
-            &clear_value, rect_count, rects);
+    return S_OK;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ClearRenderTargetView(ID3D12GraphicsCommandList2 *iface,
-        D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4], UINT rect_count, const D3D12_RECT *rects)
+static void d3d12_bundle_execute_draw(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const struct d3d12_rtv_desc *rtv_desc = d3d12_rtv_desc_from_cpu_handle(rtv);
-    struct VkAttachmentDescription attachment_desc;
-    struct VkAttachmentReference color_reference;
-    VkClearValue clear_value;
+    const struct d3d12_bundle_draw *args = (const void *)command;
 
-    TRACE("iface %p, rtv %#lx, color %p, rect_count %u, rects %p.\n",
-            iface, rtv.ptr, color, rect_count, rects);
+    d3d12_command_list_DrawInstanced(&list->ID3D12GraphicsCommandList2_iface, args->vertex_count_per_instance,
+            args->instance_count, args->start_vertex_location, args->start_instance_location);
+}
 
-    d3d12_command_list_track_resource_usage(list, rtv_desc->resource);
+static void STDMETHODCALLTYPE d3d12_bundle_DrawInstanced(ID3D12GraphicsCommandList2 *iface,
+        UINT vertex_count_per_instance, UINT instance_count, UINT start_vertex_location,
+        UINT start_instance_location)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_draw *args;
 
-    attachment_desc.flags = 0;
-    attachment_desc.format = rtv_desc->format->vk_format;
-    attachment_desc.samples = rtv_desc->sample_count;
-    attachment_desc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    attachment_desc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachment_desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachment_desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachment_desc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    attachment_desc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    TRACE("iface %p, vertex_count_per_instance %u, instance_count %u, "
+            "start_vertex_location %u, start_instance_location %u.\n",
+            iface, vertex_count_per_instance, instance_count,
+            start_vertex_location, start_instance_location);
 
-    color_reference.attachment = 0;
-    color_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_draw, sizeof(*args))))
+        return;
 
-    if (rtv_desc->format->type == VKD3D_FORMAT_TYPE_UINT)
-    {
-        clear_value.color.uint32[0] = max(0, color[0]);
-        clear_value.color.uint32[1] = max(0, color[1]);
-        clear_value.color.uint32[2] = max(0, color[2]);
-        clear_value.color.uint32[3] = max(0, color[3]);
-    }
-    else if (rtv_desc->format->type == VKD3D_FORMAT_TYPE_SINT)
-    {
-        clear_value.color.int32[0] = color[0];
-        clear_value.color.int32[1] = color[1];
-        clear_value.color.int32[2] = color[2];
-        clear_value.color.int32[3] = color[3];
-    }
-    else
-    {
-        clear_value.color.float32[0] = color[0];
-        clear_value.color.float32[1] = color[1];
-        clear_value.color.float32[2] = color[2];
-        clear_value.color.float32[3] = color[3];
-    }
+    args->vertex_count_per_instance = vertex_count_per_instance;
+    args->instance_count = instance_count;
+    args->start_vertex_location = start_vertex_location;
+    args->start_instance_location = start_instance_location;
+}
 
-    d3d12_command_list_clear(list, &attachment_desc, &color_reference, NULL,
-            rtv_desc->view, rtv_desc->width, rtv_desc->height, rtv_desc->layer_count,
-            &clear_value, rect_count, rects);
+static void d3d12_bundle_execute_draw_indexed(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_draw_indexed *args = (const void *)command;
+
+    d3d12_command_list_DrawIndexedInstanced(&list->ID3D12GraphicsCommandList2_iface,
+            args->index_count_per_instance, args->instance_count, args->start_index_location,
+            args->base_vertex_location, args->start_instance_location);
 }
 
-struct vkd3d_uav_clear_pipeline
+static void STDMETHODCALLTYPE d3d12_bundle_DrawIndexedInstanced(ID3D12GraphicsCommandList2 *iface,
+        UINT index_count_per_instance, UINT instance_count, UINT start_vertex_location,
+        INT base_vertex_location, UINT start_instance_location)
 {
-    VkDescriptorSetLayout vk_set_layout;
-    VkPipelineLayout vk_pipeline_layout;
-    VkPipeline vk_pipeline;
-    VkExtent3D group_size;
-};
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_draw_indexed *args;
 
-static void vkd3d_uav_clear_state_get_buffer_pipeline(const struct vkd3d_uav_clear_state *state,
-        enum vkd3d_format_type format_type, struct vkd3d_uav_clear_pipeline *info)
+    TRACE("iface %p, index_count_per_instance %u, instance_count %u, start_vertex_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, index_count_per_instance, instance_count, start_vertex_location,
+            base_vertex_location, start_instance_location);
+
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_draw_indexed, sizeof(*args))))
+        return;
+
+    args->index_count_per_instance = index_count_per_instance;
+    args->instance_count = instance_count;
+    args->start_index_location = start_vertex_location;
+    args->base_vertex_location = base_vertex_location;
+    args->start_instance_location = start_instance_location;
+}
+
+static void d3d12_bundle_execute_dispatch(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
 {
-    const struct vkd3d_uav_clear_pipelines *pipelines;
+    const struct d3d12_bundle_dispatch *args = (const void *)command;
 
-    pipelines = format_type == VKD3D_FORMAT_TYPE_UINT ? &state->pipelines_uint : &state->pipelines_float;
-    info->vk_set_layout = state->vk_set_layout_buffer;
-    info->vk_pipeline_layout = state->vk_pipeline_layout_buffer;
-    info->vk_pipeline = pipelines->buffer;
-    info->group_size = (VkExtent3D){128, 1, 1};
+    d3d12_command_list_Dispatch(&list->ID3D12GraphicsCommandList2_iface, args->x, args->y, args->z);
 }
 
-static void vkd3d_uav_clear_state_get_image_pipeline(const struct vkd3d_uav_clear_state *state,
-        VkImageViewType image_view_type, enum vkd3d_format_type format_type, struct vkd3d_uav_clear_pipeline *info)
+static void STDMETHODCALLTYPE d3d12_bundle_Dispatch(ID3D12GraphicsCommandList2 *iface,
+        UINT x, UINT y, UINT z)
 {
-    const struct vkd3d_uav_clear_pipelines *pipelines;
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_dispatch *args;
 
-    pipelines = format_type == VKD3D_FORMAT_TYPE_UINT ? &state->pipelines_uint : &state->pipelines_float;
-    info->vk_set_layout = state->vk_set_layout_image;
-    info->vk_pipeline_layout = state->vk_pipeline_layout_image;
+    TRACE("iface %p, x %u, y %u, z %u.\n", iface, x, y, z);
 
-    switch (image_view_type)
-    {
-        case VK_IMAGE_VIEW_TYPE_1D:
-            info->vk_pipeline = pipelines->image_1d;
-            info->group_size = (VkExtent3D){64, 1, 1};
-            break;
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_dispatch, sizeof(*args))))
+        return;
 
-        case VK_IMAGE_VIEW_TYPE_1D_ARRAY:
-            info->vk_pipeline = pipelines->image_1d_array;
-            info->group_size = (VkExtent3D){64, 1, 1};
-            break;
+    args->x = x;
+    args->y = y;
+    args->z = z;
+}
 
-        case VK_IMAGE_VIEW_TYPE_2D:
-            info->vk_pipeline = pipelines->image_2d;
-            info->group_size = (VkExtent3D){8, 8, 1};
-            break;
+static void d3d12_bundle_execute_set_primitive_topology(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_primitive_topology *args = (const void *)command;
 
-        case VK_IMAGE_VIEW_TYPE_2D_ARRAY:
-            info->vk_pipeline = pipelines->image_2d_array;
-            info->group_size = (VkExtent3D){8, 8, 1};
-            break;
+    d3d12_command_list_IASetPrimitiveTopology(&list->ID3D12GraphicsCommandList2_iface, args->topology);
+}
 
-        case VK_IMAGE_VIEW_TYPE_3D:
-            info->vk_pipeline = pipelines->image_3d;
-            info->group_size = (VkExtent3D){8, 8, 1};
-            break;
+static void STDMETHODCALLTYPE d3d12_bundle_IASetPrimitiveTopology(ID3D12GraphicsCommandList2 *iface,
+        D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_set_primitive_topology *args;
 
-        default:
-            ERR("Unhandled view type %#x.\n", image_view_type);
-            info->vk_pipeline = VK_NULL_HANDLE;
-            info->group_size = (VkExtent3D){0, 0, 0};
-            break;
-    }
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    if ((args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_primitive_topology, sizeof(*args))))
+        args->topology = topology;
 }
 
-static void d3d12_command_list_clear_uav(struct d3d12_command_list *list,
-        struct d3d12_resource *resource, struct vkd3d_view *view, const VkClearColorValue *clear_colour,
-        unsigned int rect_count, const D3D12_RECT *rects)
+static void d3d12_bundle_execute_set_blend_factor(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &list->device->vk_procs;
-    unsigned int i, miplevel_idx, layer_count;
-    struct vkd3d_uav_clear_pipeline pipeline;
-    struct vkd3d_uav_clear_args clear_args;
-    VkDescriptorImageInfo image_info;
-    D3D12_RECT full_rect, curr_rect;
-    VkWriteDescriptorSet write_set;
+    const struct d3d12_bundle_set_blend_factor *args = (const void *)command;
 
-    d3d12_command_list_track_resource_usage(list, resource);
-    d3d12_command_list_end_current_render_pass(list);
+    d3d12_command_list_OMSetBlendFactor(&list->ID3D12GraphicsCommandList2_iface, args->blend_factor);
+}
 
-    d3d12_command_list_invalidate_current_pipeline(list);
-    d3d12_command_list_invalidate_bindings(list, list->state);
-    d3d12_command_list_invalidate_root_parameters(list, VKD3D_PIPELINE_BIND_POINT_COMPUTE);
+static void STDMETHODCALLTYPE d3d12_bundle_OMSetBlendFactor(ID3D12GraphicsCommandList2 *iface,
+        const FLOAT blend_factor[4])
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_set_blend_factor *args;
 
-    if (!d3d12_command_allocator_add_view(list->allocator, view))
-        WARN("Failed to add view.\n");
+    TRACE("iface %p, blend_factor %p.\n", iface, blend_factor);
 
-    clear_args.colour = *clear_colour;
+    if ((args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_blend_factor, sizeof(*args))))
+        memcpy(args->blend_factor, blend_factor, sizeof(args->blend_factor));
+}
 
-    write_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write_set.pNext = NULL;
-    write_set.dstBinding = 0;
-    write_set.dstArrayElement = 0;
-    write_set.descriptorCount = 1;
+static void d3d12_bundle_execute_set_stencil_ref(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_stencil_ref *args = (const void *)command;
 
-    if (d3d12_resource_is_buffer(resource))
-    {
-        write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-        write_set.pImageInfo = NULL;
-        write_set.pBufferInfo = NULL;
-        write_set.pTexelBufferView = &view->u.vk_buffer_view;
+    d3d12_command_list_OMSetStencilRef(&list->ID3D12GraphicsCommandList2_iface, args->stencil_ref);
+}
 
-        miplevel_idx = 0;
-        layer_count = 1;
-        vkd3d_uav_clear_state_get_buffer_pipeline(&list->device->uav_clear_state,
-                view->format->type, &pipeline);
-    }
-    else
-    {
-        image_info.sampler = VK_NULL_HANDLE;
-        image_info.imageView = view->u.vk_image_view;
-        image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+static void STDMETHODCALLTYPE d3d12_bundle_OMSetStencilRef(ID3D12GraphicsCommandList2 *iface,
+        UINT stencil_ref)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_set_stencil_ref *args;
 
-        write_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        write_set.pImageInfo = &image_info;
-        write_set.pBufferInfo = NULL;
-        write_set.pTexelBufferView = NULL;
+    TRACE("iface %p, stencil_ref %u.\n", iface, stencil_ref);
 
-        miplevel_idx = view->info.texture.miplevel_idx;
-        layer_count = view->info.texture.vk_view_type == VK_IMAGE_VIEW_TYPE_3D
-                ? d3d12_resource_desc_get_depth(&resource->desc, miplevel_idx)
-                : view->info.texture.layer_count;
-        vkd3d_uav_clear_state_get_image_pipeline(&list->device->uav_clear_state,
-                view->info.texture.vk_view_type, view->format->type, &pipeline);
-    }
+    if ((args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_stencil_ref, sizeof(*args))))
+        args->stencil_ref = stencil_ref;
+}
 
-    if (!(write_set.dstSet = d3d12_command_allocator_allocate_descriptor_set(
-            list->allocator, pipeline.vk_set_layout, 0, false)))
-    {
-        ERR("Failed to allocate descriptor set.\n");
-        return;
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_SetPipelineState(ID3D12GraphicsCommandList2 *iface,
+        ID3D12PipelineState *pipeline_state)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
 
-    VK_CALL(vkUpdateDescriptorSets(list->device->vk_device, 1, &write_set, 0, NULL));
+    TRACE("iface %p, pipeline_state %p.\n", iface, pipeline_state);
 
-    full_rect.left = 0;
-    full_rect.right = d3d12_resource_desc_get_width(&resource->desc, miplevel_idx);
-    full_rect.top = 0;
-    full_rect.bottom = d3d12_resource_desc_get_height(&resource->desc, miplevel_idx);
+    d3d12_bundle_record_set_pipeline_state(bundle, pipeline_state);
+}
 
-    if (!rect_count)
-    {
-        rects = &full_rect;
-        rect_count = 1;
-    }
+static void d3d12_bundle_execute_set_root_signature(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_root_signature *args = (const void *)command;
 
-    VK_CALL(vkCmdBindPipeline(list->vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.vk_pipeline));
+    args->set_root_signature(&list->ID3D12GraphicsCommandList2_iface, args->root_signature);
+}
 
-    VK_CALL(vkCmdBindDescriptorSets(list->vk_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-            pipeline.vk_pipeline_layout, 0, 1, &write_set.dstSet, 0, NULL));
+static void d3d12_bundle_record_set_root_signature(struct d3d12_command_list *bundle,
+        void (STDMETHODCALLTYPE *set_root_signature)(ID3D12GraphicsCommandList2 *iface,
+        ID3D12RootSignature *root_signature), ID3D12RootSignature *root_signature)
+{
+    struct d3d12_bundle_set_root_signature *args;
 
-    for (i = 0; i < rect_count; ++i)
-    {
-        /* Clamp to the actual resource region and skip empty rectangles. */
-        curr_rect.left = max(rects[i].left, full_rect.left);
-        curr_rect.top = max(rects[i].top, full_rect.top);
-        curr_rect.right = min(rects[i].right, full_rect.right);
-        curr_rect.bottom = min(rects[i].bottom, full_rect.bottom);
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_root_signature, sizeof(*args))))
+        return;
 
-        if (curr_rect.left >= curr_rect.right || curr_rect.top >= curr_rect.bottom)
-            continue;
+    args->set_root_signature = set_root_signature;
+    args->root_signature = root_signature;
+}
 
-        clear_args.offset.x = curr_rect.left;
-        clear_args.offset.y = curr_rect.top;
-        clear_args.extent.width = curr_rect.right - curr_rect.left;
-        clear_args.extent.height = curr_rect.bottom - curr_rect.top;
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootSignature(ID3D12GraphicsCommandList2 *iface,
+        ID3D12RootSignature *root_signature)
+{
+    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
 
-        VK_CALL(vkCmdPushConstants(list->vk_command_buffer, pipeline.vk_pipeline_layout,
-                VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(clear_args), &clear_args));
+    d3d12_bundle_record_set_root_signature(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRootSignature, root_signature);
+}
 
-        VK_CALL(vkCmdDispatch(list->vk_command_buffer,
-                vkd3d_compute_workgroup_count(clear_args.extent.width, pipeline.group_size.width),
-                vkd3d_compute_workgroup_count(clear_args.extent.height, pipeline.group_size.height),
-                vkd3d_compute_workgroup_count(layer_count, pipeline.group_size.depth)));
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootSignature(ID3D12GraphicsCommandList2 *iface,
+        ID3D12RootSignature *root_signature)
+{
+    TRACE("iface %p, root_signature %p.\n", iface, root_signature);
+
+    d3d12_bundle_record_set_root_signature(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRootSignature, root_signature);
 }
 
-static const struct vkd3d_format *vkd3d_fixup_clear_uav_uint_colour(struct d3d12_device *device,
-        DXGI_FORMAT dxgi_format, VkClearColorValue *colour)
+static void d3d12_bundle_execute_set_root_descriptor_table(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
 {
-    switch (dxgi_format)
-    {
-        case DXGI_FORMAT_R11G11B10_FLOAT:
-            colour->uint32[0] = (colour->uint32[0] & 0x7ff)
-                    | ((colour->uint32[1] & 0x7ff) << 11)
-                    | ((colour->uint32[2] & 0x3ff) << 22);
-            return vkd3d_get_format(device, DXGI_FORMAT_R32_UINT, false);
+    const struct d3d12_bundle_set_root_descriptor_table *args = (const void *)command;
 
-        default:
-            return NULL;
-    }
+    args->set_root_descriptor_table(&list->ID3D12GraphicsCommandList2_iface,
+            args->root_parameter_index, args->base_descriptor);
+}
+
+static void d3d12_bundle_record_set_root_descriptor_table(struct d3d12_command_list *bundle,
+        void (STDMETHODCALLTYPE *set_root_descriptor_table)(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor),
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
+{
+    struct d3d12_bundle_set_root_descriptor_table *args;
+
+    if (!(args = d3d12_bundle_add_command(bundle,
+            d3d12_bundle_execute_set_root_descriptor_table, sizeof(*args))))
+        return;
+
+    args->set_root_descriptor_table = set_root_descriptor_table;
+    args->root_parameter_index = root_parameter_index;
+    args->base_descriptor = base_descriptor;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewUint(ID3D12GraphicsCommandList2 *iface,
-        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
-        const UINT values[4], UINT rect_count, const D3D12_RECT *rects)
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_device *device = list->device;
-    struct vkd3d_view *view, *uint_view = NULL;
-    struct vkd3d_texture_view_desc view_desc;
-    const struct vkd3d_format *uint_format;
-    struct d3d12_resource *resource_impl;
-    VkClearColorValue colour;
+    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
+            iface, root_parameter_index, base_descriptor.ptr);
 
-    TRACE("iface %p, gpu_handle %#"PRIx64", cpu_handle %lx, resource %p, values %p, rect_count %u, rects %p.\n",
-            iface, gpu_handle.ptr, cpu_handle.ptr, resource, values, rect_count, rects);
+    d3d12_bundle_record_set_root_descriptor_table(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRootDescriptorTable, root_parameter_index, base_descriptor);
+}
 
-    resource_impl = unsafe_impl_from_ID3D12Resource(resource);
-    view = d3d12_desc_from_cpu_handle(cpu_handle)->s.u.view_info.view;
-    memcpy(colour.uint32, values, sizeof(colour.uint32));
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootDescriptorTable(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_DESCRIPTOR_HANDLE base_descriptor)
+{
+    TRACE("iface %p, root_parameter_index %u, base_descriptor %#"PRIx64".\n",
+            iface, root_parameter_index, base_descriptor.ptr);
 
-    if (view->format->type != VKD3D_FORMAT_TYPE_UINT)
-    {
-        if (!(uint_format = vkd3d_find_uint_format(device, view->format->dxgi_format))
-                && !(uint_format = vkd3d_fixup_clear_uav_uint_colour(device, view->format->dxgi_format, &colour)))
-        {
-            ERR("Unhandled format %#x.\n", view->format->dxgi_format);
-            return;
-        }
+    d3d12_bundle_record_set_root_descriptor_table(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRootDescriptorTable, root_parameter_index, base_descriptor);
+}
 
-        if (d3d12_resource_is_buffer(resource_impl))
-        {
-            if (!vkd3d_create_buffer_view(device, resource_impl->u.vk_buffer, uint_format,
-                    view->info.buffer.offset, view->info.buffer.size, &uint_view))
-            {
-                ERR("Failed to create buffer view.\n");
-                return;
-            }
-        }
-        else
-        {
-            memset(&view_desc, 0, sizeof(view_desc));
-            view_desc.view_type = view->info.texture.vk_view_type;
-            view_desc.format = uint_format;
-            view_desc.miplevel_idx = view->info.texture.miplevel_idx;
-            view_desc.miplevel_count = 1;
-            view_desc.layer_idx = view->info.texture.layer_idx;
-            view_desc.layer_count = view->info.texture.layer_count;
+static void d3d12_bundle_execute_set_root_constants(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_root_constants *args = (const void *)command;
 
-            if (!vkd3d_create_texture_view(device, resource_impl->u.vk_image, &view_desc, &uint_view))
-            {
-                ERR("Failed to create image view.\n");
-                return;
-            }
-        }
-        view = uint_view;
-    }
+    args->set_root_constants(&list->ID3D12GraphicsCommandList2_iface,
+            args->root_parameter_index, args->constant_count, args->data, args->dst_offset);
+}
 
-    d3d12_command_list_clear_uav(list, resource_impl, view, &colour, rect_count, rects);
+static void d3d12_bundle_record_set_root_constants(struct d3d12_command_list *bundle,
+        void (STDMETHODCALLTYPE *set_root_constants)(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset),
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
+{
+    struct d3d12_bundle_set_root_constants *args;
 
-    if (uint_view)
-        vkd3d_view_decref(uint_view, device);
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_root_constants,
+            offsetof(struct d3d12_bundle_set_root_constants, data[constant_count]))))
+        return;
+
+    args->set_root_constants = set_root_constants;
+    args->root_parameter_index = root_parameter_index;
+    args->constant_count = constant_count;
+    args->dst_offset = dst_offset;
+    memcpy(args->data, data, constant_count * sizeof(*args->data));
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ClearUnorderedAccessViewFloat(ID3D12GraphicsCommandList2 *iface,
-        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
-        const float values[4], UINT rect_count, const D3D12_RECT *rects)
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT data, UINT dst_offset)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *resource_impl;
-    VkClearColorValue colour;
-    struct vkd3d_view *view;
+    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
+            iface, root_parameter_index, data, dst_offset);
 
-    TRACE("iface %p, gpu_handle %#"PRIx64", cpu_handle %lx, resource %p, values %p, rect_count %u, rects %p.\n",
-            iface, gpu_handle.ptr, cpu_handle.ptr, resource, values, rect_count, rects);
+    d3d12_bundle_record_set_root_constants(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRoot32BitConstants, root_parameter_index, 1, &data, dst_offset);
+}
 
-    resource_impl = unsafe_impl_from_ID3D12Resource(resource);
-    view = d3d12_desc_from_cpu_handle(cpu_handle)->s.u.view_info.view;
-    memcpy(colour.float32, values, sizeof(colour.float32));
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstant(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT data, UINT dst_offset)
+{
+    TRACE("iface %p, root_parameter_index %u, data 0x%08x, dst_offset %u.\n",
+            iface, root_parameter_index, data, dst_offset);
 
-    d3d12_command_list_clear_uav(list, resource_impl, view, &colour, rect_count, rects);
+    d3d12_bundle_record_set_root_constants(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRoot32BitConstants, root_parameter_index, 1, &data, dst_offset);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_DiscardResource(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *resource, const D3D12_DISCARD_REGION *region)
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
 {
-    FIXME_ONCE("iface %p, resource %p, region %p stub!\n", iface, resource, region);
+    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
+            iface, root_parameter_index, constant_count, data, dst_offset);
+
+    d3d12_bundle_record_set_root_constants(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRoot32BitConstants, root_parameter_index,
+            constant_count, data, dst_offset);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_BeginQuery(ID3D12GraphicsCommandList2 *iface,
-        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRoot32BitConstants(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, UINT constant_count, const void *data, UINT dst_offset)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
-    const struct vkd3d_vk_device_procs *vk_procs;
-    VkQueryControlFlags flags = 0;
-
-    TRACE("iface %p, heap %p, type %#x, index %u.\n", iface, heap, type, index);
+    TRACE("iface %p, root_parameter_index %u, constant_count %u, data %p, dst_offset %u.\n",
+            iface, root_parameter_index, constant_count, data, dst_offset);
 
-    vk_procs = &list->device->vk_procs;
+    d3d12_bundle_record_set_root_constants(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRoot32BitConstants, root_parameter_index,
+            constant_count, data, dst_offset);
+}
 
-    d3d12_command_list_end_current_render_pass(list);
+static void d3d12_bundle_execute_set_root_view(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_root_view *args = (const void *)command;
 
-    VK_CALL(vkCmdResetQueryPool(list->vk_command_buffer, query_heap->vk_query_pool, index, 1));
+    args->set_root_view(&list->ID3D12GraphicsCommandList2_iface, args->root_parameter_index, args->address);
+}
 
-    if (type == D3D12_QUERY_TYPE_OCCLUSION)
-        flags = VK_QUERY_CONTROL_PRECISE_BIT;
+static void d3d12_bundle_record_set_root_view(struct d3d12_command_list *bundle,
+        void (STDMETHODCALLTYPE *set_root_view)(ID3D12GraphicsCommandList2 *iface,
+        UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address),
+        UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    struct d3d12_bundle_set_root_view *args;
 
-    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
-    {
-        unsigned int stream_index = type - D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0;
-        VK_CALL(vkCmdBeginQueryIndexedEXT(list->vk_command_buffer,
-                query_heap->vk_query_pool, index, flags, stream_index));
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_root_view, sizeof(*args))))
         return;
-    }
 
-    VK_CALL(vkCmdBeginQuery(list->vk_command_buffer, query_heap->vk_query_pool, index, flags));
+    args->set_root_view = set_root_view;
+    args->root_parameter_index = root_parameter_index;
+    args->address = address;
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_EndQuery(ID3D12GraphicsCommandList2 *iface,
-        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootConstantBufferView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
-    const struct vkd3d_vk_device_procs *vk_procs;
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    TRACE("iface %p, heap %p, type %#x, index %u.\n", iface, heap, type, index);
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRootConstantBufferView, root_parameter_index, address);
+}
 
-    vk_procs = &list->device->vk_procs;
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootConstantBufferView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    d3d12_command_list_end_current_render_pass(list);
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRootConstantBufferView, root_parameter_index, address);
+}
 
-    d3d12_query_heap_mark_result_as_available(query_heap, index);
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootShaderResourceView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    if (type == D3D12_QUERY_TYPE_TIMESTAMP)
-    {
-        VK_CALL(vkCmdResetQueryPool(list->vk_command_buffer, query_heap->vk_query_pool, index, 1));
-        VK_CALL(vkCmdWriteTimestamp(list->vk_command_buffer,
-                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_heap->vk_query_pool, index));
-        return;
-    }
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRootShaderResourceView, root_parameter_index, address);
+}
 
-    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
-    {
-        unsigned int stream_index = type - D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0;
-        VK_CALL(vkCmdEndQueryIndexedEXT(list->vk_command_buffer,
-                query_heap->vk_query_pool, index, stream_index));
-        return;
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootShaderResourceView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    VK_CALL(vkCmdEndQuery(list->vk_command_buffer, query_heap->vk_query_pool, index));
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRootShaderResourceView, root_parameter_index, address);
 }
 
-static size_t get_query_stride(D3D12_QUERY_TYPE type)
+static void STDMETHODCALLTYPE d3d12_bundle_SetComputeRootUnorderedAccessView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
-    if (type == D3D12_QUERY_TYPE_PIPELINE_STATISTICS)
-        return sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS);
-
-    if (D3D12_QUERY_TYPE_SO_STATISTICS_STREAM0 <= type && type <= D3D12_QUERY_TYPE_SO_STATISTICS_STREAM3)
-        return sizeof(D3D12_QUERY_DATA_SO_STATISTICS);
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    return sizeof(uint64_t);
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetComputeRootUnorderedAccessView, root_parameter_index, address);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ResolveQueryData(ID3D12GraphicsCommandList2 *iface,
-        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT start_index, UINT query_count,
-        ID3D12Resource *dst_buffer, UINT64 aligned_dst_buffer_offset)
+static void STDMETHODCALLTYPE d3d12_bundle_SetGraphicsRootUnorderedAccessView(
+        ID3D12GraphicsCommandList2 *iface, UINT root_parameter_index, D3D12_GPU_VIRTUAL_ADDRESS address)
 {
-    const struct d3d12_query_heap *query_heap = unsafe_impl_from_ID3D12QueryHeap(heap);
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *buffer = unsafe_impl_from_ID3D12Resource(dst_buffer);
-    const struct vkd3d_vk_device_procs *vk_procs;
-    unsigned int i, first, count;
-    VkDeviceSize offset, stride;
-
-    TRACE("iface %p, heap %p, type %#x, start_index %u, query_count %u, "
-            "dst_buffer %p, aligned_dst_buffer_offset %#"PRIx64".\n",
-            iface, heap, type, start_index, query_count,
-            dst_buffer, aligned_dst_buffer_offset);
+    TRACE("iface %p, root_parameter_index %u, address %#"PRIx64".\n",
+            iface, root_parameter_index, address);
 
-    vk_procs = &list->device->vk_procs;
+    d3d12_bundle_record_set_root_view(impl_from_ID3D12GraphicsCommandList2(iface),
+            d3d12_command_list_SetGraphicsRootUnorderedAccessView, root_parameter_index, address);
+}
 
-    /* Vulkan is less strict than D3D12 here. Vulkan implementations are free
-     * to return any non-zero result for binary occlusion with at least one
-     * sample passing, while D3D12 guarantees that the result is 1 then.
-     *
-     * For example, the Nvidia binary blob drivers on Linux seem to always
-     * count precisely, even when it was signalled that non-precise is enough.
-     */
-    if (type == D3D12_QUERY_TYPE_BINARY_OCCLUSION)
-        FIXME_ONCE("D3D12 guarantees binary occlusion queries result in only 0 and 1.\n");
+static void d3d12_bundle_execute_set_index_buffer(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_index_buffer *args = (const void *)command;
 
-    if (!d3d12_resource_is_buffer(buffer))
-    {
-        WARN("Destination resource is not a buffer.\n");
-        return;
-    }
+    d3d12_command_list_IASetIndexBuffer(&list->ID3D12GraphicsCommandList2_iface,
+            args->has_view ? &args->view : NULL);
+}
 
-    d3d12_command_list_end_current_render_pass(list);
+static void STDMETHODCALLTYPE d3d12_bundle_IASetIndexBuffer(ID3D12GraphicsCommandList2 *iface,
+        const D3D12_INDEX_BUFFER_VIEW *view)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_set_index_buffer *args;
 
-    stride = get_query_stride(type);
+    TRACE("iface %p, view %p.\n", iface, view);
 
-    count = 0;
-    first = start_index;
-    offset = aligned_dst_buffer_offset;
-    for (i = 0; i < query_count; ++i)
-    {
-        if (d3d12_query_heap_is_result_available(query_heap, start_index + i))
-        {
-            ++count;
-        }
-        else
-        {
-            if (count)
-            {
-                VK_CALL(vkCmdCopyQueryPoolResults(list->vk_command_buffer,
-                        query_heap->vk_query_pool, first, count, buffer->u.vk_buffer,
-                        offset, stride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
-            }
-            count = 0;
-            first = start_index + i;
-            offset = aligned_dst_buffer_offset + i * stride;
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_index_buffer, sizeof(*args))))
+        return;
 
-            /* We cannot copy query results if a query was not issued:
-             *
-             *   "If the query does not become available in a finite amount of
-             *   time (e.g. due to not issuing a query since the last reset),
-             *   a VK_ERROR_DEVICE_LOST error may occur."
-             */
-            VK_CALL(vkCmdFillBuffer(list->vk_command_buffer,
-                    buffer->u.vk_buffer, offset, stride, 0x00000000));
+    if ((args->has_view = !!view))
+        args->view = *view;
+}
 
-            ++first;
-            offset += stride;
-        }
-    }
+static void d3d12_bundle_execute_set_vertex_buffers(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_set_vertex_buffers *args = (const void *)command;
 
-    if (count)
-    {
-        VK_CALL(vkCmdCopyQueryPoolResults(list->vk_command_buffer,
-                query_heap->vk_query_pool, first, count, buffer->u.vk_buffer,
-                offset, stride, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
-    }
+    d3d12_command_list_IASetVertexBuffers(&list->ID3D12GraphicsCommandList2_iface,
+            args->start_slot, args->view_count, args->has_views ? args->views : NULL);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetPredication(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *buffer, UINT64 aligned_buffer_offset, D3D12_PREDICATION_OP operation)
+static void STDMETHODCALLTYPE d3d12_bundle_IASetVertexBuffers(ID3D12GraphicsCommandList2 *iface,
+        UINT start_slot, UINT view_count, const D3D12_VERTEX_BUFFER_VIEW *views)
 {
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *resource = unsafe_impl_from_ID3D12Resource(buffer);
-    const struct vkd3d_vulkan_info *vk_info = &list->device->vk_info;
-    const struct vkd3d_vk_device_procs *vk_procs;
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_set_vertex_buffers *args;
+    size_t size;
 
-    TRACE("iface %p, buffer %p, aligned_buffer_offset %#"PRIx64", operation %#x.\n",
-            iface, buffer, aligned_buffer_offset, operation);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    if (!vk_info->EXT_conditional_rendering)
+    if (!vkd3d_bound_range(start_slot, view_count, D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT))
     {
-        FIXME("Vulkan conditional rendering extension not present. Conditional rendering not supported.\n");
+        WARN("Invalid start slot %u / view count %u.\n", start_slot, view_count);
+        bundle->is_valid = false;
         return;
     }
 
-    vk_procs = &list->device->vk_procs;
-
-    /* FIXME: Add support for conditional rendering in render passes. */
-    d3d12_command_list_end_current_render_pass(list);
+    size = offsetof(struct d3d12_bundle_set_vertex_buffers, views[views ? view_count : 0]);
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_set_vertex_buffers, size)))
+        return;
 
-    if (resource)
-    {
-        VkConditionalRenderingBeginInfoEXT cond_info;
+    args->start_slot = start_slot;
+    args->view_count = view_count;
+    if ((args->has_views = !!views))
+        memcpy(args->views, views, view_count * sizeof(*views));
+}
 
-        if (aligned_buffer_offset & (sizeof(uint64_t) - 1))
-        {
-            WARN("Unaligned predicate argument buffer offset %#"PRIx64".\n", aligned_buffer_offset);
-            return;
-        }
+static void d3d12_bundle_execute_execute_indirect(struct d3d12_command_list *list,
+        const struct d3d12_bundle_command *command)
+{
+    const struct d3d12_bundle_execute_indirect *args = (const void *)command;
 
-        if (!d3d12_resource_is_buffer(resource))
-        {
-            WARN("Predicate arguments must be stored in a buffer resource.\n");
-            return;
-        }
+    d3d12_command_list_ExecuteIndirect(&list->ID3D12GraphicsCommandList2_iface, args->command_signature,
+            args->max_command_count, args->arg_buffer, args->arg_buffer_offset,
+            args->count_buffer, args->count_buffer_offset);
+}
 
-        FIXME_ONCE("Predication doesn't support clear and copy commands, "
-                "and predication values are treated as 32-bit values.\n");
+static void STDMETHODCALLTYPE d3d12_bundle_ExecuteIndirect(ID3D12GraphicsCommandList2 *iface,
+        ID3D12CommandSignature *command_signature, UINT max_command_count, ID3D12Resource *arg_buffer,
+        UINT64 arg_buffer_offset, ID3D12Resource *count_buffer, UINT64 count_buffer_offset)
+{
+    struct d3d12_command_list *bundle = impl_from_ID3D12GraphicsCommandList2(iface);
+    struct d3d12_bundle_execute_indirect *args;
 
-        cond_info.sType = VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT;
-        cond_info.pNext = NULL;
-        cond_info.buffer = resource->u.vk_buffer;
-        cond_info.offset = aligned_buffer_offset;
-        switch (operation)
-        {
-            case D3D12_PREDICATION_OP_EQUAL_ZERO:
-                cond_info.flags = 0;
-                break;
+    TRACE("iface %p, command_signature %p, max_command_count %u, arg_buffer %p, "
+            "arg_buffer_offset %#"PRIx64", count_buffer %p, count_buffer_offset %#"PRIx64".\n",
+            iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
+            count_buffer, count_buffer_offset);
 
-            case D3D12_PREDICATION_OP_NOT_EQUAL_ZERO:
-                cond_info.flags = VK_CONDITIONAL_RENDERING_INVERTED_BIT_EXT;
-                break;
+    if (!(args = d3d12_bundle_add_command(bundle, d3d12_bundle_execute_execute_indirect, sizeof(*args))))
+        return;
 
-            default:
-                FIXME("Unhandled predication operation %#x.\n", operation);
-                return;
-        }
+    args->command_signature = command_signature;
+    args->max_command_count = max_command_count;
+    args->arg_buffer = arg_buffer;
+    args->arg_buffer_offset = arg_buffer_offset;
+    args->count_buffer = count_buffer;
+    args->count_buffer_offset = count_buffer_offset;
+}
 
-        if (list->is_predicated)
-            VK_CALL(vkCmdEndConditionalRenderingEXT(list->vk_command_buffer));
-        VK_CALL(vkCmdBeginConditionalRenderingEXT(list->vk_command_buffer, &cond_info));
-        list->is_predicated = true;
-    }
-    else if (list->is_predicated)
-    {
-        VK_CALL(vkCmdEndConditionalRenderingEXT(list->vk_command_buffer));
-        list->is_predicated = false;
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_CopyBufferRegion(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, UINT64 dst_offset, ID3D12Resource *src, UINT64 src_offset, UINT64 byte_count)
+{
+    d3d12_bundle_invalid_command(iface, "CopyBufferRegion");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetMarker(ID3D12GraphicsCommandList2 *iface,
-        UINT metadata, const void *data, UINT size)
+static void STDMETHODCALLTYPE d3d12_bundle_CopyTextureRegion(ID3D12GraphicsCommandList2 *iface,
+        const D3D12_TEXTURE_COPY_LOCATION *dst, UINT dst_x, UINT dst_y, UINT dst_z,
+        const D3D12_TEXTURE_COPY_LOCATION *src, const D3D12_BOX *src_box)
 {
-    FIXME("iface %p, metadata %#x, data %p, size %u stub!\n", iface, metadata, data, size);
+    d3d12_bundle_invalid_command(iface, "CopyTextureRegion");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_BeginEvent(ID3D12GraphicsCommandList2 *iface,
-        UINT metadata, const void *data, UINT size)
+static void STDMETHODCALLTYPE d3d12_bundle_CopyResource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, ID3D12Resource *src)
 {
-    FIXME("iface %p, metadata %#x, data %p, size %u stub!\n", iface, metadata, data, size);
+    d3d12_bundle_invalid_command(iface, "CopyResource");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_EndEvent(ID3D12GraphicsCommandList2 *iface)
+static void STDMETHODCALLTYPE d3d12_bundle_CopyTiles(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *tiled_resource, const D3D12_TILED_RESOURCE_COORDINATE *tile_region_start_coordinate,
+        const D3D12_TILE_REGION_SIZE *tile_region_size, ID3D12Resource *buffer, UINT64 buffer_offset,
+        D3D12_TILE_COPY_FLAGS flags)
 {
-    FIXME("iface %p stub!\n", iface);
+    d3d12_bundle_invalid_command(iface, "CopyTiles");
 }
 
-STATIC_ASSERT(sizeof(VkDispatchIndirectCommand) == sizeof(D3D12_DISPATCH_ARGUMENTS));
-STATIC_ASSERT(sizeof(VkDrawIndexedIndirectCommand) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
-STATIC_ASSERT(sizeof(VkDrawIndirectCommand) == sizeof(D3D12_DRAW_ARGUMENTS));
+static void STDMETHODCALLTYPE d3d12_bundle_ResolveSubresource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst, UINT dst_sub_resource_idx,
+        ID3D12Resource *src, UINT src_sub_resource_idx, DXGI_FORMAT format)
+{
+    d3d12_bundle_invalid_command(iface, "ResolveSubresource");
+}
 
-static void STDMETHODCALLTYPE d3d12_command_list_ExecuteIndirect(ID3D12GraphicsCommandList2 *iface,
-        ID3D12CommandSignature *command_signature, UINT max_command_count, ID3D12Resource *arg_buffer,
-        UINT64 arg_buffer_offset, ID3D12Resource *count_buffer, UINT64 count_buffer_offset)
+static void STDMETHODCALLTYPE d3d12_bundle_RSSetViewports(ID3D12GraphicsCommandList2 *iface,
+        UINT viewport_count, const D3D12_VIEWPORT *viewports)
 {
-    struct d3d12_command_signature *sig_impl = unsafe_impl_from_ID3D12CommandSignature(command_signature);
-    struct d3d12_resource *count_impl = unsafe_impl_from_ID3D12Resource(count_buffer);
-    struct d3d12_resource *arg_impl = unsafe_impl_from_ID3D12Resource(arg_buffer);
-    struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    const D3D12_COMMAND_SIGNATURE_DESC *signature_desc;
-    const struct vkd3d_vk_device_procs *vk_procs;
-    unsigned int i;
+    d3d12_bundle_invalid_command(iface, "RSSetViewports");
+}
 
-    TRACE("iface %p, command_signature %p, max_command_count %u, arg_buffer %p, "
-            "arg_buffer_offset %#"PRIx64", count_buffer %p, count_buffer_offset %#"PRIx64".\n",
-            iface, command_signature, max_command_count, arg_buffer, arg_buffer_offset,
-            count_buffer, count_buffer_offset);
+static void STDMETHODCALLTYPE d3d12_bundle_RSSetScissorRects(ID3D12GraphicsCommandList2 *iface,
+        UINT rect_count, const D3D12_RECT *rects)
+{
+    d3d12_bundle_invalid_command(iface, "RSSetScissorRects");
+}
 
-    vk_procs = &list->device->vk_procs;
+static void STDMETHODCALLTYPE d3d12_bundle_ResourceBarrier(ID3D12GraphicsCommandList2 *iface,
+        UINT barrier_count, const D3D12_RESOURCE_BARRIER *barriers)
+{
+    d3d12_bundle_invalid_command(iface, "ResourceBarrier");
+}
 
-    if (count_buffer && !list->device->vk_info.KHR_draw_indirect_count)
-    {
-        FIXME("Count buffers not supported by Vulkan implementation.\n");
-        return;
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_ExecuteBundle(ID3D12GraphicsCommandList2 *iface,
+        ID3D12GraphicsCommandList *command_list)
+{
+    d3d12_bundle_invalid_command(iface, "ExecuteBundle");
+}
 
-    signature_desc = &sig_impl->desc;
-    for (i = 0; i < signature_desc->NumArgumentDescs; ++i)
-    {
-        const D3D12_INDIRECT_ARGUMENT_DESC *arg_desc = &signature_desc->pArgumentDescs[i];
+static void STDMETHODCALLTYPE d3d12_bundle_SOSetTargets(ID3D12GraphicsCommandList2 *iface,
+        UINT start_slot, UINT view_count, const D3D12_STREAM_OUTPUT_BUFFER_VIEW *views)
+{
+    d3d12_bundle_invalid_command(iface, "SOSetTargets");
+}
 
-        switch (arg_desc->Type)
-        {
-            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
-                if (!d3d12_command_list_begin_render_pass(list))
-                {
-                    WARN("Failed to begin render pass, ignoring draw.\n");
-                    break;
-                }
+static void STDMETHODCALLTYPE d3d12_bundle_OMSetRenderTargets(ID3D12GraphicsCommandList2 *iface,
+        UINT render_target_descriptor_count, const D3D12_CPU_DESCRIPTOR_HANDLE *render_target_descriptors,
+        BOOL single_descriptor_handle, const D3D12_CPU_DESCRIPTOR_HANDLE *depth_stencil_descriptor)
+{
+    d3d12_bundle_invalid_command(iface, "OMSetRenderTargets");
+}
 
-                if (count_buffer)
-                {
-                    VK_CALL(vkCmdDrawIndirectCountKHR(list->vk_command_buffer, arg_impl->u.vk_buffer,
-                            arg_buffer_offset, count_impl->u.vk_buffer, count_buffer_offset,
-                            max_command_count, signature_desc->ByteStride));
-                }
-                else
-                {
-                    VK_CALL(vkCmdDrawIndirect(list->vk_command_buffer, arg_impl->u.vk_buffer,
-                            arg_buffer_offset, max_command_count, signature_desc->ByteStride));
-                }
-                break;
+static void STDMETHODCALLTYPE d3d12_bundle_ClearDepthStencilView(ID3D12GraphicsCommandList2 *iface,
+        D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags, float depth, UINT8 stencil,
+        UINT rect_count, const D3D12_RECT *rects)
+{
+    d3d12_bundle_invalid_command(iface, "ClearDepthStencilView");
+}
 
-            case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
-                if (!d3d12_command_list_begin_render_pass(list))
-                {
-                    WARN("Failed to begin render pass, ignoring draw.\n");
-                    break;
-                }
+static void STDMETHODCALLTYPE d3d12_bundle_ClearRenderTargetView(ID3D12GraphicsCommandList2 *iface,
+        D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4], UINT rect_count, const D3D12_RECT *rects)
+{
+    d3d12_bundle_invalid_command(iface, "ClearRenderTargetView");
+}
 
-                d3d12_command_list_check_index_buffer_strip_cut_value(list);
+static void STDMETHODCALLTYPE d3d12_bundle_ClearUnorderedAccessViewUint(ID3D12GraphicsCommandList2 *iface,
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
+        const UINT values[4], UINT rect_count, const D3D12_RECT *rects)
+{
+    d3d12_bundle_invalid_command(iface, "ClearUnorderedAccessViewUint");
+}
 
-                if (count_buffer)
-                {
-                    VK_CALL(vkCmdDrawIndexedIndirectCountKHR(list->vk_command_buffer, arg_impl->u.vk_buffer,
-                            arg_buffer_offset, count_impl->u.vk_buffer, count_buffer_offset,
-                            max_command_count, signature_desc->ByteStride));
-                }
-                else
-                {
-                    VK_CALL(vkCmdDrawIndexedIndirect(list->vk_command_buffer, arg_impl->u.vk_buffer,
-                            arg_buffer_offset, max_command_count, signature_desc->ByteStride));
-                }
-                break;
+static void STDMETHODCALLTYPE d3d12_bundle_ClearUnorderedAccessViewFloat(ID3D12GraphicsCommandList2 *iface,
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle, D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle, ID3D12Resource *resource,
+        const float values[4], UINT rect_count, const D3D12_RECT *rects)
+{
+    d3d12_bundle_invalid_command(iface, "ClearUnorderedAccessViewFloat");
+}
 
-            case D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH:
-                if (max_command_count != 1)
-                    FIXME("Ignoring command count %u.\n", max_command_count);
+static void STDMETHODCALLTYPE d3d12_bundle_DiscardResource(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *resource, const D3D12_DISCARD_REGION *region)
+{
+    d3d12_bundle_invalid_command(iface, "DiscardResource");
+}
 
-                if (count_buffer)
-                {
-                    FIXME("Count buffers not supported for indirect dispatch.\n");
-                    break;
-                }
+static void STDMETHODCALLTYPE d3d12_bundle_BeginQuery(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
+{
+    d3d12_bundle_invalid_command(iface, "BeginQuery");
+}
 
-                if (!d3d12_command_list_update_compute_state(list))
-                {
-                    WARN("Failed to update compute state, ignoring dispatch.\n");
-                    return;
-                }
+static void STDMETHODCALLTYPE d3d12_bundle_EndQuery(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT index)
+{
+    d3d12_bundle_invalid_command(iface, "EndQuery");
+}
 
-                VK_CALL(vkCmdDispatchIndirect(list->vk_command_buffer,
-                        arg_impl->u.vk_buffer, arg_buffer_offset));
-                break;
+static void STDMETHODCALLTYPE d3d12_bundle_ResolveQueryData(ID3D12GraphicsCommandList2 *iface,
+        ID3D12QueryHeap *heap, D3D12_QUERY_TYPE type, UINT start_index, UINT query_count,
+        ID3D12Resource *dst_buffer, UINT64 aligned_dst_buffer_offset)
+{
+    d3d12_bundle_invalid_command(iface, "ResolveQueryData");
+}
 
-            default:
-                FIXME("Ignoring unhandled argument type %#x.\n", arg_desc->Type);
-                break;
-        }
-    }
+static void STDMETHODCALLTYPE d3d12_bundle_SetPredication(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *buffer, UINT64 aligned_buffer_offset, D3D12_PREDICATION_OP operation)
+{
+    d3d12_bundle_invalid_command(iface, "SetPredication");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_AtomicCopyBufferUINT(ID3D12GraphicsCommandList2 *iface,
+static void STDMETHODCALLTYPE d3d12_bundle_AtomicCopyBufferUINT(ID3D12GraphicsCommandList2 *iface,
         ID3D12Resource *dst_buffer, UINT64 dst_offset,
         ID3D12Resource *src_buffer, UINT64 src_offset,
         UINT dependent_resource_count, ID3D12Resource * const *dependent_resources,
         const D3D12_SUBRESOURCE_RANGE_UINT64 *dependent_sub_resource_ranges)
 {
-    FIXME("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
-            "src_offset %#"PRIx64", dependent_resource_count %u, "
-            "dependent_resources %p, dependent_sub_resource_ranges %p stub!\n",
-            iface, dst_buffer, dst_offset, src_buffer, src_offset,
-            dependent_resource_count, dependent_resources, dependent_sub_resource_ranges);
+    d3d12_bundle_invalid_command(iface, "AtomicCopyBufferUINT");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_AtomicCopyBufferUINT64(ID3D12GraphicsCommandList2 *iface,
+static void STDMETHODCALLTYPE d3d12_bundle_AtomicCopyBufferUINT64(ID3D12GraphicsCommandList2 *iface,
         ID3D12Resource *dst_buffer, UINT64 dst_offset,
         ID3D12Resource *src_buffer, UINT64 src_offset,
         UINT dependent_resource_count, ID3D12Resource * const *dependent_resources,
         const D3D12_SUBRESOURCE_RANGE_UINT64 *dependent_sub_resource_ranges)
 {
-    FIXME("iface %p, dst_resource %p, dst_offset %#"PRIx64", src_resource %p, "
-            "src_offset %#"PRIx64", dependent_resource_count %u, "
-            "dependent_resources %p, dependent_sub_resource_ranges %p stub!\n",
-            iface, dst_buffer, dst_offset, src_buffer, src_offset,
-            dependent_resource_count, dependent_resources, dependent_sub_resource_ranges);
+    d3d12_bundle_invalid_command(iface, "AtomicCopyBufferUINT64");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_OMSetDepthBounds(ID3D12GraphicsCommandList2 *iface,
-        FLOAT min, FLOAT max)
+static void STDMETHODCALLTYPE d3d12_bundle_ResolveSubresourceRegion(ID3D12GraphicsCommandList2 *iface,
+        ID3D12Resource *dst_resource, UINT dst_sub_resource_idx, UINT dst_x, UINT dst_y,
+        ID3D12Resource *src_resource, UINT src_sub_resource_idx,
+        D3D12_RECT *src_rect, DXGI_FORMAT format, D3D12_RESOLVE_MODE mode)
 {
-    FIXME("iface %p, min %.8e, max %.8e stub!\n", iface, min, max);
+    d3d12_bundle_invalid_command(iface, "ResolveSubresourceRegion");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetSamplePositions(ID3D12GraphicsCommandList2 *iface,
-        UINT sample_count, UINT pixel_count, D3D12_SAMPLE_POSITION *sample_positions)
+static void STDMETHODCALLTYPE d3d12_bundle_WriteBufferImmediate(ID3D12GraphicsCommandList2 *iface,
+        UINT count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER *parameters,
+        const D3D12_WRITEBUFFERIMMEDIATE_MODE *modes)
 {
-    FIXME("iface %p, sample_count %u, pixel_count %u, sample_positions %p stub!\n",
-            iface, sample_count, pixel_count, sample_positions);
+    d3d12_bundle_invalid_command(iface, "WriteBufferImmediate");
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_ResolveSubresourceRegion(ID3D12GraphicsCommandList2 *iface,
-        ID3D12Resource *dst_resource, UINT dst_sub_resource_idx, UINT dst_x, UINT dst_y,
-        ID3D12Resource *src_resource, UINT src_sub_resource_idx,
-        D3D12_RECT *src_rect, DXGI_FORMAT format, D3D12_RESOLVE_MODE mode)
+static const struct ID3D12GraphicsCommandList2Vtbl d3d12_bundle_vtbl =
 {
-    FIXME("iface %p, dst_resource %p, dst_sub_resource_idx %u, "
-            "dst_x %u, dst_y %u, src_resource %p, src_sub_resource_idx %u, "
-            "src_rect %p, format %#x, mode %#x stub!\n",
-            iface, dst_resource, dst_sub_resource_idx, dst_x, dst_y,
-            src_resource, src_sub_resource_idx, src_rect, format, mode);
-}
+    /* IUnknown methods */
+    d3d12_command_list_QueryInterface,
+    d3d12_command_list_AddRef,
+    d3d12_command_list_Release,
+    /* ID3D12Object methods */
+    d3d12_command_list_GetPrivateData,
+    d3d12_command_list_SetPrivateData,
+    d3d12_command_list_SetPrivateDataInterface,
+    d3d12_command_list_SetName,
+    /* ID3D12DeviceChild methods */
+    d3d12_command_list_GetDevice,
+    /* ID3D12CommandList methods */
+    d3d12_command_list_GetType,
+    /* ID3D12GraphicsCommandList methods */
+    d3d12_bundle_Close,
+    d3d12_bundle_Reset,
+    d3d12_command_list_ClearState,
+    d3d12_bundle_DrawInstanced,
+    d3d12_bundle_DrawIndexedInstanced,
+    d3d12_bundle_Dispatch,
+    d3d12_bundle_CopyBufferRegion,
+    d3d12_bundle_CopyTextureRegion,
+    d3d12_bundle_CopyResource,
+    d3d12_bundle_CopyTiles,
+    d3d12_bundle_ResolveSubresource,
+    d3d12_bundle_IASetPrimitiveTopology,
+    d3d12_bundle_RSSetViewports,
+    d3d12_bundle_RSSetScissorRects,
+    d3d12_bundle_OMSetBlendFactor,
+    d3d12_bundle_OMSetStencilRef,
+    d3d12_bundle_SetPipelineState,
+    d3d12_bundle_ResourceBarrier,
+    d3d12_bundle_ExecuteBundle,
+    d3d12_command_list_SetDescriptorHeaps,
+    d3d12_bundle_SetComputeRootSignature,
+    d3d12_bundle_SetGraphicsRootSignature,
+    d3d12_bundle_SetComputeRootDescriptorTable,
+    d3d12_bundle_SetGraphicsRootDescriptorTable,
+    d3d12_bundle_SetComputeRoot32BitConstant,
+    d3d12_bundle_SetGraphicsRoot32BitConstant,
+    d3d12_bundle_SetComputeRoot32BitConstants,
+    d3d12_bundle_SetGraphicsRoot32BitConstants,
+    d3d12_bundle_SetComputeRootConstantBufferView,
+    d3d12_bundle_SetGraphicsRootConstantBufferView,
+    d3d12_bundle_SetComputeRootShaderResourceView,
+    d3d12_bundle_SetGraphicsRootShaderResourceView,
+    d3d12_bundle_SetComputeRootUnorderedAccessView,
+    d3d12_bundle_SetGraphicsRootUnorderedAccessView,
+    d3d12_bundle_IASetIndexBuffer,
+    d3d12_bundle_IASetVertexBuffers,
+    d3d12_bundle_SOSetTargets,
+    d3d12_bundle_OMSetRenderTargets,
+    d3d12_bundle_ClearDepthStencilView,
+    d3d12_bundle_ClearRenderTargetView,
+    d3d12_bundle_ClearUnorderedAccessViewUint,
+    d3d12_bundle_ClearUnorderedAccessViewFloat,
+    d3d12_bundle_DiscardResource,
+    d3d12_bundle_BeginQuery,
+    d3d12_bundle_EndQuery,
+    d3d12_bundle_ResolveQueryData,
+    d3d12_bundle_SetPredication,
+    d3d12_command_list_SetMarker,
+    d3d12_command_list_BeginEvent,
+    d3d12_command_list_EndEvent,
+    d3d12_bundle_ExecuteIndirect,
+    /* ID3D12GraphicsCommandList1 methods */
+    d3d12_bundle_AtomicCopyBufferUINT,
+    d3d12_bundle_AtomicCopyBufferUINT64,
+    d3d12_command_list_OMSetDepthBounds,
+    d3d12_command_list_SetSamplePositions,
+    d3d12_bundle_ResolveSubresourceRegion,
+    d3d12_command_list_SetViewInstanceMask,
+    /* ID3D12GraphicsCommandList2 methods */
+    d3d12_bundle_WriteBufferImmediate,
+};
 
-static void STDMETHODCALLTYPE d3d12_command_list_SetViewInstanceMask(ID3D12GraphicsCommandList2 *iface, UINT mask)
+static struct d3d12_command_list *unsafe_impl_from_bundle(ID3D12GraphicsCommandList *iface)
 {
-    FIXME("iface %p, mask %#x stub!\n", iface, mask);
+    if (!iface)
+        return NULL;
+    assert(iface->lpVtbl == (struct ID3D12GraphicsCommandListVtbl *)&d3d12_bundle_vtbl);
+    return CONTAINING_RECORD(iface, struct d3d12_command_list, ID3D12GraphicsCommandList2_iface);
 }
 
-static void STDMETHODCALLTYPE d3d12_command_list_WriteBufferImmediate(ID3D12GraphicsCommandList2 *iface,
-        UINT count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER *parameters,
-        const D3D12_WRITEBUFFERIMMEDIATE_MODE *modes)
+static void STDMETHODCALLTYPE d3d12_command_list_ExecuteBundle(ID3D12GraphicsCommandList2 *iface,
+        ID3D12GraphicsCommandList *command_list)
 {
+    struct d3d12_command_list *bundle = unsafe_impl_from_bundle(command_list);
     struct d3d12_command_list *list = impl_from_ID3D12GraphicsCommandList2(iface);
-    struct d3d12_resource *resource;
-    unsigned int i;
+    const struct d3d12_bundle_command *command;
+    size_t offset;
 
-    FIXME("iface %p, count %u, parameters %p, modes %p stub!\n", iface, count, parameters, modes);
+    TRACE("iface %p, command_list %p.\n", iface, command_list);
 
-    for (i = 0; i < count; ++i)
+    if (list->type != D3D12_COMMAND_LIST_TYPE_DIRECT)
     {
-        resource = vkd3d_gpu_va_allocator_dereference(&list->device->gpu_va_allocator, parameters[i].Dest);
-        d3d12_command_list_track_resource_usage(list, resource);
+        WARN("Bundles can only be executed by direct command lists.\n");
+        list->is_valid = false;
+        return;
+    }
+
+    if (!bundle || bundle->is_recording || !bundle->is_valid)
+    {
+        WARN("Invalid bundle %p.\n", bundle);
+        list->is_valid = false;
+        return;
+    }
+
+    for (offset = 0; offset < bundle->bundle_size; offset += command->size)
+    {
+        command = (const struct d3d12_bundle_command *)&bundle->bundle_data[offset];
+        command->execute(list, command);
     }
 }
 
@@ -5882,7 +9258,8 @@ static struct d3d12_command_list *unsafe_impl_from_ID3D12CommandList(ID3D12Comma
 {
     if (!iface)
         return NULL;
-    assert(iface->lpVtbl == (struct ID3D12CommandListVtbl *)&d3d12_command_list_vtbl);
+    assert(iface->lpVtbl == (struct ID3D12CommandListVtbl *)&d3d12_command_list_vtbl
+            || iface->lpVtbl == (struct ID3D12CommandListVtbl *)&d3d12_bundle_vtbl);
     return CONTAINING_RECORD(iface, struct d3d12_command_list, ID3D12GraphicsCommandList2_iface);
 }
 
@@ -5904,9 +9281,32 @@ static HRESULT d3d12_command_list_init(struct d3d12_command_list *list, struct d
 
     list->allocator = allocator;
 
+    memset(&list->barriers, 0, sizeof(list->barriers));
+    list->pending_clears = NULL;
+    list->pending_clears_size = 0;
+    list->pending_clear_count = 0;
+    list->pending_discards = NULL;
+    list->pending_discards_size = 0;
+    list->pending_discard_count = 0;
+
     list->update_descriptors = device->use_vk_heaps ? d3d12_command_list_update_heap_descriptors
             : d3d12_command_list_update_descriptors;
 
+    list->bundle_data = NULL;
+    list->bundle_data_size = 0;
+    list->bundle_size = 0;
+
+    if (type == D3D12_COMMAND_LIST_TYPE_BUNDLE)
+    {
+        /* Bundles don't own a Vulkan command buffer. */
+        list->ID3D12GraphicsCommandList2_iface.lpVtbl = &d3d12_bundle_vtbl;
+        list->allocator = NULL;
+        list->vk_command_buffer = VK_NULL_HANDLE;
+        memset(list->pipeline_bindings, 0, sizeof(list->pipeline_bindings));
+        d3d12_bundle_reset_state(list, initial_pipeline_state);
+        return S_OK;
+    }
+
     if (SUCCEEDED(hr = d3d12_command_allocator_allocate_command_buffer(allocator, list)))
     {
         list->pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_GRAPHICS].vk_uav_counter_views = NULL;
@@ -5999,9 +9399,45 @@ static ULONG STDMETHODCALLTYPE d3d12_command_queue_AddRef(ID3D12CommandQueue *if
     return refcount;
 }
 
-static void d3d12_command_queue_op_array_destroy(struct d3d12_command_queue_op_array *array)
+static void d3d12_command_queue_free_op(struct vkd3d_cs_op_data *op)
+{
+    switch (op->opcode)
+    {
+        case VKD3D_CS_OP_WAIT:
+            d3d12_fence_decref(op->u.wait.fence);
+            break;
+
+        case VKD3D_CS_OP_SIGNAL:
+            d3d12_fence_decref(op->u.signal.fence);
+            break;
+
+        case VKD3D_CS_OP_EXECUTE:
+            break;
+
+        default:
+            vkd3d_unreachable();
+    }
+
+    vkd3d_free(op);
+}
+
+static void d3d12_command_queue_destroy_ops(struct d3d12_command_queue *queue)
 {
-    vkd3d_free(array->ops);
+    struct vkd3d_cs_op_data *op, *next;
+
+    if (queue->op_head || queue->pending_head)
+        WARN("Destroying command queue %p with unflushed ops.\n", queue);
+
+    for (op = queue->pending_head; op; op = next)
+    {
+        next = op->next;
+        d3d12_command_queue_free_op(op);
+    }
+    for (op = queue->op_head; op; op = next)
+    {
+        next = op->next;
+        d3d12_command_queue_free_op(op);
+    }
 }
 
 static ULONG STDMETHODCALLTYPE d3d12_command_queue_Release(ID3D12CommandQueue *iface)
@@ -6015,11 +9451,24 @@ static ULONG STDMETHODCALLTYPE d3d12_command_queue_Release(ID3D12CommandQueue *i
     {
         struct d3d12_device *device = command_queue->device;
 
-        vkd3d_fence_worker_stop(&command_queue->fence_worker, device);
+        if (command_queue->use_submit_thread)
+            d3d12_command_queue_stop_submit_thread(command_queue);
+
+        d3d12_device_remove_blocked_queue(device, command_queue);
+        d3d12_command_queue_destroy_ops(command_queue);
+
+        /* Flushes of blocked queues use the submit mutex, so it's destroyed
+         * after the queue is removed from the blocked list. */
+        if (command_queue->use_submit_thread)
+        {
+            vkd3d_cond_destroy(&command_queue->submit_idle_cond);
+            vkd3d_cond_destroy(&command_queue->submit_cond);
+            vkd3d_mutex_destroy(&command_queue->submit_mutex);
+        }
+
+        vkd3d_fence_worker_stop(&device->fence_worker, device);
 
-        vkd3d_mutex_destroy(&command_queue->op_mutex);
-        d3d12_command_queue_op_array_destroy(&command_queue->op_queue);
-        d3d12_command_queue_op_array_destroy(&command_queue->aux_op_queue);
+        vkd3d_free(command_queue->submit_infos);
 
         vkd3d_private_store_destroy(&command_queue->private_store);
 
@@ -6090,14 +9539,6 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_queue_GetDevice(ID3D12CommandQueu
     return d3d12_device_query_interface(command_queue->device, iid, device);
 }
 
-static struct vkd3d_cs_op_data *d3d12_command_queue_op_array_require_space(struct d3d12_command_queue_op_array *array)
-{
-    if (!vkd3d_array_reserve((void **)&array->ops, &array->size, array->count + 1, sizeof(*array->ops)))
-        return NULL;
-
-    return &array->ops[array->count++];
-}
-
 static void STDMETHODCALLTYPE d3d12_command_queue_UpdateTileMappings(ID3D12CommandQueue *iface,
         ID3D12Resource *resource, UINT region_count,
         const D3D12_TILED_RESOURCE_COORDINATE *region_start_coordinates, const D3D12_TILE_REGION_SIZE *region_sizes,
@@ -6125,45 +9566,128 @@ static void STDMETHODCALLTYPE d3d12_command_queue_CopyTileMappings(ID3D12Command
             src_region_start_coordinate, region_size, flags);
 }
 
+/* Submits consecutive execute ops with a single vkQueueSubmit() call, and
+ * frees them. */
 static void d3d12_command_queue_execute(struct d3d12_command_queue *command_queue,
-        VkCommandBuffer *buffers, unsigned int count)
+        struct vkd3d_cs_op_data *ops, unsigned int op_count)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &command_queue->device->vk_procs;
     struct vkd3d_queue *vkd3d_queue = command_queue->vkd3d_queue;
-    VkSubmitInfo submit_desc;
+    struct vkd3d_cs_op_data *op, *next;
+    VkSubmitInfo *submit_infos;
     VkQueue vk_queue;
+    unsigned int i;
     VkResult vr;
 
-    memset(&submit_desc, 0, sizeof(submit_desc));
+    if (!vkd3d_array_reserve((void **)&command_queue->submit_infos, &command_queue->submit_infos_size,
+            op_count, sizeof(*command_queue->submit_infos)))
+    {
+        ERR("Failed to allocate submit infos.\n");
+        goto done;
+    }
+    submit_infos = command_queue->submit_infos;
+
+    for (i = 0, op = ops; i < op_count; ++i, op = op->next)
+    {
+        assert(op->opcode == VKD3D_CS_OP_EXECUTE);
+        memset(&submit_infos[i], 0, sizeof(submit_infos[i]));
+        submit_infos[i].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_infos[i].commandBufferCount = op->u.execute.buffer_count;
+        submit_infos[i].pCommandBuffers = op->u.execute.buffers;
+    }
 
     if (!(vk_queue = vkd3d_queue_acquire(vkd3d_queue)))
     {
         ERR("Failed to acquire queue %p.\n", vkd3d_queue);
-        return;
+        goto done;
     }
 
-    submit_desc.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_desc.commandBufferCount = count;
-    submit_desc.pCommandBuffers = buffers;
-
-    if ((vr = VK_CALL(vkQueueSubmit(vk_queue, 1, &submit_desc, VK_NULL_HANDLE))) < 0)
+    if ((vr = VK_CALL(vkQueueSubmit(vk_queue, op_count, submit_infos, VK_NULL_HANDLE))) < 0)
         ERR("Failed to submit queue(s), vr %d.\n", vr);
 
     vkd3d_queue_release(vkd3d_queue);
 
-    vkd3d_free(buffers);
+done:
+    for (i = 0, op = ops; i < op_count; ++i, op = next)
+    {
+        next = op->next;
+        vkd3d_free(op);
+    }
 }
 
-static void d3d12_command_queue_submit_locked(struct d3d12_command_queue *queue)
+static void d3d12_command_queue_submit_op(struct d3d12_command_queue *queue, struct vkd3d_cs_op_data *op)
 {
+    struct vkd3d_cs_op_data *head;
     bool flushed_any = false;
     HRESULT hr;
 
-    if (queue->op_queue.count == 1 && !queue->is_flushing)
+    do
+    {
+        head = queue->op_head;
+        op->next = head;
+    }
+    while (InterlockedCompareExchangePointer((void * volatile *)&queue->op_head, op, head) != head);
+
+    if (queue->use_submit_thread)
+    {
+        if (!InterlockedCompareExchange(&queue->submit_pending, 1, 0))
+        {
+            vkd3d_mutex_lock(&queue->submit_mutex);
+            vkd3d_cond_signal(&queue->submit_cond);
+            vkd3d_mutex_unlock(&queue->submit_mutex);
+        }
+        return;
+    }
+
+    if (FAILED(hr = d3d12_command_queue_flush_ops(queue, &flushed_any)))
+        ERR("Cannot flush queue, hr %#x.\n", hr);
+}
+
+static void *d3d12_command_queue_submit_main(void *arg)
+{
+    struct d3d12_command_queue *queue = arg;
+    bool flushed_any, should_exit;
+    HRESULT hr;
+
+    vkd3d_set_thread_name("vkd3d_queue");
+
+    for (;;)
     {
-        if (FAILED(hr = d3d12_command_queue_flush_ops_locked(queue, &flushed_any)))
-            ERR("Cannot flush queue, hr %#x.\n", hr);
+        vkd3d_mutex_lock(&queue->submit_mutex);
+        while (!queue->submit_pending && !queue->submit_thread_exit)
+            vkd3d_cond_wait(&queue->submit_cond, &queue->submit_mutex);
+        should_exit = queue->submit_thread_exit;
+        vkd3d_mutex_unlock(&queue->submit_mutex);
+
+        /* Flush any remaining ops before exiting. Ops which accumulated
+         * while this thread was asleep are flushed together, which allows
+         * batching consecutive executes. */
+        if (InterlockedCompareExchange(&queue->submit_pending, 0, 1))
+        {
+            flushed_any = false;
+            if (FAILED(hr = d3d12_command_queue_flush_ops(queue, &flushed_any)))
+                ERR("Cannot flush queue, hr %#x.\n", hr);
+        }
+        else if (should_exit)
+        {
+            break;
+        }
     }
+
+    return NULL;
+}
+
+static void d3d12_command_queue_stop_submit_thread(struct d3d12_command_queue *queue)
+{
+    HRESULT hr;
+
+    vkd3d_mutex_lock(&queue->submit_mutex);
+    queue->submit_thread_exit = true;
+    vkd3d_cond_signal(&queue->submit_cond);
+    vkd3d_mutex_unlock(&queue->submit_mutex);
+
+    if (FAILED(hr = vkd3d_join_thread(queue->device->vkd3d_instance, &queue->submit_thread)))
+        ERR("Failed to join submit thread, hr %#x.\n", hr);
 }
 
 static void STDMETHODCALLTYPE d3d12_command_queue_ExecuteCommandLists(ID3D12CommandQueue *iface,
@@ -6181,42 +9705,42 @@ static void STDMETHODCALLTYPE d3d12_command_queue_ExecuteCommandLists(ID3D12Comm
     if (!command_list_count)
         return;
 
-    if (!(buffers = vkd3d_calloc(command_list_count, sizeof(*buffers))))
+    /* The command buffer array is stored after the op. */
+    if (!(op = vkd3d_malloc(sizeof(*op) + command_list_count * sizeof(*buffers))))
     {
-        ERR("Failed to allocate command buffer array.\n");
+        ERR("Failed to allocate op.\n");
         return;
     }
+    buffers = (VkCommandBuffer *)(op + 1);
 
     for (i = 0; i < command_list_count; ++i)
     {
         cmd_list = unsafe_impl_from_ID3D12CommandList(command_lists[i]);
 
+        if (cmd_list->type == D3D12_COMMAND_LIST_TYPE_BUNDLE)
+        {
+            d3d12_device_mark_as_removed(command_queue->device, DXGI_ERROR_INVALID_CALL,
+                    "Bundle %p cannot be executed on a command queue.", command_lists[i]);
+            vkd3d_free(op);
+            return;
+        }
+
         if (cmd_list->is_recording)
         {
             d3d12_device_mark_as_removed(command_queue->device, DXGI_ERROR_INVALID_CALL,
                     "Command list %p is in recording state.", command_lists[i]);
-            vkd3d_free(buffers);
+            vkd3d_free(op);
             return;
         }
 
         buffers[i] = cmd_list->vk_command_buffer;
     }
 
-    vkd3d_mutex_lock(&command_queue->op_mutex);
-
-    if (!(op = d3d12_command_queue_op_array_require_space(&command_queue->op_queue)))
-    {
-        ERR("Failed to add op.\n");
-        return;
-    }
     op->opcode = VKD3D_CS_OP_EXECUTE;
     op->u.execute.buffers = buffers;
     op->u.execute.buffer_count = command_list_count;
 
-    d3d12_command_queue_submit_locked(command_queue);
-
-    vkd3d_mutex_unlock(&command_queue->op_mutex);
-    return;
+    d3d12_command_queue_submit_op(command_queue, op);
 }
 
 static void STDMETHODCALLTYPE d3d12_command_queue_SetMarker(ID3D12CommandQueue *iface,
@@ -6238,64 +9762,26 @@ static void STDMETHODCALLTYPE d3d12_command_queue_EndEvent(ID3D12CommandQueue *i
     FIXME("iface %p stub!\n", iface);
 }
 
-static HRESULT vkd3d_enqueue_timeline_semaphore(struct vkd3d_fence_worker *worker, VkSemaphore vk_semaphore,
-        struct d3d12_fence *fence, uint64_t value, struct vkd3d_queue *queue)
-{
-    struct vkd3d_waiting_fence *waiting_fence;
-
-    TRACE("worker %p, fence %p, value %#"PRIx64".\n", worker, fence, value);
-
-    vkd3d_mutex_lock(&worker->mutex);
-
-    if (!vkd3d_array_reserve((void **)&worker->fences, &worker->fences_size,
-            worker->fence_count + 1, sizeof(*worker->fences)))
-    {
-        ERR("Failed to add GPU timeline semaphore.\n");
-        vkd3d_mutex_unlock(&worker->mutex);
-        return E_OUTOFMEMORY;
-    }
-
-    waiting_fence = &worker->fences[worker->fence_count++];
-    waiting_fence->fence = fence;
-    waiting_fence->value = value;
-    waiting_fence->u.vk_semaphore = vk_semaphore;
-
-    d3d12_fence_incref(fence);
-
-    vkd3d_cond_signal(&worker->cond);
-    vkd3d_mutex_unlock(&worker->mutex);
-
-    return S_OK;
-}
-
 static HRESULT STDMETHODCALLTYPE d3d12_command_queue_Signal(ID3D12CommandQueue *iface,
         ID3D12Fence *fence_iface, UINT64 value)
 {
     struct d3d12_command_queue *command_queue = impl_from_ID3D12CommandQueue(iface);
     struct d3d12_fence *fence = unsafe_impl_from_ID3D12Fence(fence_iface);
     struct vkd3d_cs_op_data *op;
-    HRESULT hr = S_OK;
 
     TRACE("iface %p, fence %p, value %#"PRIx64".\n", iface, fence_iface, value);
 
-    vkd3d_mutex_lock(&command_queue->op_mutex);
-
-    if (!(op = d3d12_command_queue_op_array_require_space(&command_queue->op_queue)))
-    {
-        hr = E_OUTOFMEMORY;
-        goto done;
-    }
+    if (!(op = vkd3d_malloc(sizeof(*op))))
+        return E_OUTOFMEMORY;
     op->opcode = VKD3D_CS_OP_SIGNAL;
     op->u.signal.fence = fence;
     op->u.signal.value = value;
 
     d3d12_fence_incref(fence);
 
-    d3d12_command_queue_submit_locked(command_queue);
+    d3d12_command_queue_submit_op(command_queue, op);
 
-done:
-    vkd3d_mutex_unlock(&command_queue->op_mutex);
-    return hr;
+    return S_OK;
 }
 
 static HRESULT d3d12_command_queue_signal(struct d3d12_command_queue *command_queue,
@@ -6402,7 +9888,7 @@ static HRESULT d3d12_command_queue_signal(struct d3d12_command_queue *command_qu
         vk_semaphore = fence->timeline_semaphore;
         assert(vk_semaphore);
 
-        return vkd3d_enqueue_timeline_semaphore(&command_queue->fence_worker,
+        return vkd3d_enqueue_timeline_semaphore(&device->fence_worker,
                 vk_semaphore, fence, timeline_value, vkd3d_queue);
     }
 
@@ -6412,7 +9898,7 @@ static HRESULT d3d12_command_queue_signal(struct d3d12_command_queue *command_qu
     vr = VK_CALL(vkGetFenceStatus(device->vk_device, vk_fence));
     if (vr == VK_NOT_READY)
     {
-        if (SUCCEEDED(hr = vkd3d_enqueue_gpu_fence(&command_queue->fence_worker,
+        if (SUCCEEDED(hr = vkd3d_enqueue_gpu_fence(&device->fence_worker,
                 vk_fence, fence, value, vkd3d_queue, sequence_number)))
         {
             vk_fence = VK_NULL_HANDLE;
@@ -6612,28 +10098,20 @@ static HRESULT STDMETHODCALLTYPE d3d12_command_queue_Wait(ID3D12CommandQueue *if
     struct d3d12_command_queue *command_queue = impl_from_ID3D12CommandQueue(iface);
     struct d3d12_fence *fence = unsafe_impl_from_ID3D12Fence(fence_iface);
     struct vkd3d_cs_op_data *op;
-    HRESULT hr = S_OK;
 
     TRACE("iface %p, fence %p, value %#"PRIx64".\n", iface, fence_iface, value);
 
-    vkd3d_mutex_lock(&command_queue->op_mutex);
-
-    if (!(op = d3d12_command_queue_op_array_require_space(&command_queue->op_queue)))
-    {
-        hr = E_OUTOFMEMORY;
-        goto done;
-    }
+    if (!(op = vkd3d_malloc(sizeof(*op))))
+        return E_OUTOFMEMORY;
     op->opcode = VKD3D_CS_OP_WAIT;
     op->u.wait.fence = fence;
     op->u.wait.value = value;
 
     d3d12_fence_incref(fence);
 
-    d3d12_command_queue_submit_locked(command_queue);
+    d3d12_command_queue_submit_op(command_queue, op);
 
-done:
-    vkd3d_mutex_unlock(&command_queue->op_mutex);
-    return hr;
+    return S_OK;
 }
 
 static HRESULT STDMETHODCALLTYPE d3d12_command_queue_GetTimestampFrequency(ID3D12CommandQueue *iface,
@@ -6757,139 +10235,135 @@ static const struct ID3D12CommandQueueVtbl d3d12_command_queue_vtbl =
     d3d12_command_queue_GetDesc,
 };
 
-static void d3d12_command_queue_swap_queues(struct d3d12_command_queue *queue)
+/* Moves ops from the lock-free list to the end of the pending list. */
+static void d3d12_command_queue_take_ops(struct d3d12_command_queue *queue)
 {
-    struct d3d12_command_queue_op_array array;
-
-    array = queue->op_queue;
-    queue->op_queue = queue->aux_op_queue;
-    queue->aux_op_queue = array;
-}
+    struct vkd3d_cs_op_data *head, *op, *next, *list = NULL;
 
-static bool d3d12_command_queue_op_array_append(struct d3d12_command_queue_op_array *array,
-        size_t count, const struct vkd3d_cs_op_data *new_ops)
-{
-    if (!vkd3d_array_reserve((void **)&array->ops, &array->size, array->count + count, sizeof(*array->ops)))
+    do
     {
-        ERR("Cannot reserve memory for %zu new ops.\n", count);
-        return false;
+        head = queue->op_head;
     }
+    while (InterlockedCompareExchangePointer((void * volatile *)&queue->op_head, NULL, head) != head);
 
-    memcpy(&array->ops[array->count], new_ops, count * sizeof(*array->ops));
-    array->count += count;
-
-    return true;
-}
-
-static void d3d12_command_queue_delete_aux_ops(struct d3d12_command_queue *queue,
-        unsigned int done_count)
-{
-    queue->aux_op_queue.count -= done_count;
-    memmove(queue->aux_op_queue.ops, &queue->aux_op_queue.ops[done_count],
-            queue->aux_op_queue.count * sizeof(*queue->aux_op_queue.ops));
-}
-
-static HRESULT d3d12_command_queue_fixup_after_flush_locked(struct d3d12_command_queue *queue)
-{
-    d3d12_command_queue_swap_queues(queue);
-
-    d3d12_command_queue_op_array_append(&queue->op_queue, queue->aux_op_queue.count, queue->aux_op_queue.ops);
-
-    queue->aux_op_queue.count = 0;
-    queue->is_flushing = false;
-
-    return d3d12_command_queue_record_as_blocked(queue);
-}
-
-static HRESULT d3d12_command_queue_flush_ops(struct d3d12_command_queue *queue, bool *flushed_any)
-{
-    HRESULT hr;
-
-    vkd3d_mutex_lock(&queue->op_mutex);
+    if (!head)
+        return;
 
-    /* This function may be re-entered when invoking
-     * d3d12_command_queue_signal().  The first call is responsible
-     * for re-adding the queue to the flush list. */
-    if (queue->is_flushing)
+    /* The list is newest first; reverse it into submission order. */
+    for (op = head; op; op = next)
     {
-        vkd3d_mutex_unlock(&queue->op_mutex);
-        return S_OK;
+        next = op->next;
+        op->next = list;
+        list = op;
     }
 
-    hr = d3d12_command_queue_flush_ops_locked(queue, flushed_any);
-
-    vkd3d_mutex_unlock(&queue->op_mutex);
-
-    return hr;
+    if (queue->pending_tail)
+        queue->pending_tail->next = list;
+    else
+        queue->pending_head = list;
+    queue->pending_tail = head;
 }
 
-/* flushed_any is initialised by the caller. */
-static HRESULT d3d12_command_queue_flush_ops_locked(struct d3d12_command_queue *queue, bool *flushed_any)
+/* Only called by the thread which set is_flushing. */
+static HRESULT d3d12_command_queue_flush_pending_ops(struct d3d12_command_queue *queue, bool *flushed_any)
 {
-    struct vkd3d_cs_op_data *op;
+    struct vkd3d_cs_op_data *op, *last, *next;
     struct d3d12_fence *fence;
-    unsigned int i;
-
-    queue->is_flushing = true;
-
-    assert(queue->aux_op_queue.count == 0);
+    unsigned int count;
+    HRESULT hr;
 
-    while (queue->op_queue.count != 0)
+    for (d3d12_command_queue_take_ops(queue); (op = queue->pending_head); d3d12_command_queue_take_ops(queue))
     {
-        d3d12_command_queue_swap_queues(queue);
+        switch (op->opcode)
+        {
+            case VKD3D_CS_OP_WAIT:
+                fence = op->u.wait.fence;
+                vkd3d_mutex_lock(&fence->mutex);
+                if (op->u.wait.value > fence->max_pending_value)
+                {
+                    vkd3d_mutex_unlock(&fence->mutex);
 
-        vkd3d_mutex_unlock(&queue->op_mutex);
+                    /* Record the dependency, then check again in case a
+                     * signal was queued in the meantime. */
+                    if (FAILED(hr = d3d12_command_queue_record_as_blocked(queue, fence, op->u.wait.value)))
+                        return hr;
 
-        for (i = 0; i < queue->aux_op_queue.count; ++i)
-        {
-            op = &queue->aux_op_queue.ops[i];
-            switch (op->opcode)
-            {
-                case VKD3D_CS_OP_WAIT:
-                    fence = op->u.wait.fence;
                     vkd3d_mutex_lock(&fence->mutex);
                     if (op->u.wait.value > fence->max_pending_value)
                     {
                         vkd3d_mutex_unlock(&fence->mutex);
-                        d3d12_command_queue_delete_aux_ops(queue, i);
-                        vkd3d_mutex_lock(&queue->op_mutex);
-                        return d3d12_command_queue_fixup_after_flush_locked(queue);
+                        return S_OK;
                     }
-                    d3d12_command_queue_wait_locked(queue, fence, op->u.wait.value);
-                    d3d12_fence_decref(fence);
-                    break;
+                    vkd3d_mutex_unlock(&fence->mutex);
 
-                case VKD3D_CS_OP_SIGNAL:
-                    d3d12_command_queue_signal(queue, op->u.signal.fence, op->u.signal.value);
-                    d3d12_fence_decref(op->u.signal.fence);
-                    break;
+                    d3d12_device_remove_blocked_queue(queue->device, queue);
 
-                case VKD3D_CS_OP_EXECUTE:
-                    d3d12_command_queue_execute(queue, op->u.execute.buffers, op->u.execute.buffer_count);
-                    break;
+                    vkd3d_mutex_lock(&fence->mutex);
+                }
+                d3d12_command_queue_wait_locked(queue, fence, op->u.wait.value);
+                next = op->next;
+                d3d12_command_queue_free_op(op);
+                break;
 
-                default:
-                    vkd3d_unreachable();
-            }
+            case VKD3D_CS_OP_SIGNAL:
+                d3d12_command_queue_signal(queue, op->u.signal.fence, op->u.signal.value);
+                next = op->next;
+                d3d12_command_queue_free_op(op);
+                break;
+
+            case VKD3D_CS_OP_EXECUTE:
+                for (last = op, count = 1; last->next && last->next->opcode == VKD3D_CS_OP_EXECUTE; ++count)
+                    last = last->next;
+                next = last->next;
+                d3d12_command_queue_execute(queue, op, count);
+                break;
 
-            *flushed_any |= true;
+            default:
+                vkd3d_unreachable();
         }
 
-        queue->aux_op_queue.count = 0;
+        if (!(queue->pending_head = next))
+            queue->pending_tail = NULL;
 
-        vkd3d_mutex_lock(&queue->op_mutex);
+        *flushed_any |= true;
     }
 
-    queue->is_flushing = false;
-
     return S_OK;
 }
 
-static void d3d12_command_queue_op_array_init(struct d3d12_command_queue_op_array *array)
+/* flushed_any is initialised by the caller. */
+static HRESULT d3d12_command_queue_flush_ops(struct d3d12_command_queue *queue, bool *flushed_any)
 {
-    array->ops = NULL;
-    array->count = 0;
-    array->size = 0;
+    HRESULT hr = S_OK;
+
+    /* Only one thread flushes a queue at a time. If another thread is
+     * flushing, including an outer call on this thread when invoking
+     * d3d12_command_queue_signal(), it sees flush_requested after it
+     * releases is_flushing and flushes again. */
+    InterlockedCompareExchange(&queue->flush_requested, 1, 0);
+
+    while (queue->flush_requested)
+    {
+        if (InterlockedCompareExchange(&queue->is_flushing, 1, 0))
+            return S_OK;
+
+        if (InterlockedCompareExchange(&queue->flush_requested, 0, 1))
+            hr = d3d12_command_queue_flush_pending_ops(queue, flushed_any);
+
+        InterlockedCompareExchange(&queue->is_flushing, 0, 1);
+
+        if (queue->use_submit_thread)
+        {
+            vkd3d_mutex_lock(&queue->submit_mutex);
+            vkd3d_cond_broadcast(&queue->submit_idle_cond);
+            vkd3d_mutex_unlock(&queue->submit_mutex);
+        }
+
+        if (FAILED(hr))
+            return hr;
+    }
+
+    return S_OK;
 }
 
 static HRESULT d3d12_command_queue_init(struct d3d12_command_queue *queue,
@@ -6910,10 +10384,11 @@ static HRESULT d3d12_command_queue_init(struct d3d12_command_queue *queue,
     queue->last_waited_fence = NULL;
     queue->last_waited_fence_value = 0;
 
-    d3d12_command_queue_op_array_init(&queue->op_queue);
-    queue->is_flushing = false;
-
-    d3d12_command_queue_op_array_init(&queue->aux_op_queue);
+    queue->op_head = NULL;
+    queue->is_flushing = 0;
+    queue->flush_requested = 0;
+    queue->pending_head = NULL;
+    queue->pending_tail = NULL;
 
     if (desc->Priority == D3D12_COMMAND_QUEUE_PRIORITY_GLOBAL_REALTIME)
     {
@@ -6929,17 +10404,38 @@ static HRESULT d3d12_command_queue_init(struct d3d12_command_queue *queue,
     if (FAILED(hr = vkd3d_private_store_init(&queue->private_store)))
         return hr;
 
-    vkd3d_mutex_init(&queue->op_mutex);
+    queue->submit_infos = NULL;
+    queue->submit_infos_size = 0;
+
+    if (FAILED(hr = vkd3d_fence_worker_start(&device->fence_worker, device)))
+        goto fail_destroy_private_store;
 
-    if (FAILED(hr = vkd3d_fence_worker_start(&queue->fence_worker, queue->vkd3d_queue, device)))
-        goto fail_destroy_op_mutex;
+    queue->device = device;
+
+    queue->use_submit_thread = !!(device->vkd3d_instance->config_flags & VKD3D_CONFIG_FLAG_SUBMIT_THREAD);
+    queue->submit_pending = 0;
+    queue->submit_thread_exit = false;
+    if (queue->use_submit_thread)
+    {
+        vkd3d_mutex_init(&queue->submit_mutex);
+        vkd3d_cond_init(&queue->submit_cond);
+        vkd3d_cond_init(&queue->submit_idle_cond);
+        if (FAILED(hr = vkd3d_create_thread(device->vkd3d_instance,
+                d3d12_command_queue_submit_main, queue, &queue->submit_thread)))
+        {
+            vkd3d_cond_destroy(&queue->submit_idle_cond);
+            vkd3d_cond_destroy(&queue->submit_cond);
+            vkd3d_mutex_destroy(&queue->submit_mutex);
+            vkd3d_fence_worker_stop(&device->fence_worker, device);
+            goto fail_destroy_private_store;
+        }
+    }
 
-    d3d12_device_add_ref(queue->device = device);
+    d3d12_device_add_ref(device);
 
     return S_OK;
 
-fail_destroy_op_mutex:
-    vkd3d_mutex_destroy(&queue->op_mutex);
+fail_destroy_private_store:
     vkd3d_private_store_destroy(&queue->private_store);
     return hr;
 }
@@ -6973,13 +10469,41 @@ uint32_t vkd3d_get_vk_queue_family_index(ID3D12CommandQueue *queue)
     return d3d12_queue->vkd3d_queue->vk_family_index;
 }
 
+/* Waits until the submit thread has flushed all ops which can be flushed.
+ * Ops behind a wait for a fence value which has not been signalled yet stay
+ * pending, since waiting for them could block forever. */
+static void d3d12_command_queue_wait_submit_thread_idle(struct d3d12_command_queue *queue)
+{
+    vkd3d_mutex_lock(&queue->submit_mutex);
+
+    for (;;)
+    {
+        if (queue->op_head && !InterlockedCompareExchange(&queue->submit_pending, 1, 0))
+            vkd3d_cond_signal(&queue->submit_cond);
+        else if (!queue->submit_pending && !queue->is_flushing)
+            break;
+
+        vkd3d_cond_wait(&queue->submit_idle_cond, &queue->submit_mutex);
+    }
+
+    vkd3d_mutex_unlock(&queue->submit_mutex);
+}
+
 VkQueue vkd3d_acquire_vk_queue(ID3D12CommandQueue *queue)
 {
     struct d3d12_command_queue *d3d12_queue = impl_from_ID3D12CommandQueue(queue);
-    VkQueue vk_queue = vkd3d_queue_acquire(d3d12_queue->vkd3d_queue);
+    VkQueue vk_queue;
+
+    /* Work submitted through the queue must reach Vulkan before work
+     * submitted by the caller, e.g. a present. The submit thread needs the
+     * Vulkan queue, so wait before acquiring it. */
+    if (d3d12_queue->use_submit_thread)
+        d3d12_command_queue_wait_submit_thread_idle(d3d12_queue);
+
+    vk_queue = vkd3d_queue_acquire(d3d12_queue->vkd3d_queue);
 
-    if (d3d12_queue->op_queue.count)
-        WARN("Acquired command queue %p with %zu remaining ops.\n", d3d12_queue, d3d12_queue->op_queue.count);
+    if (d3d12_queue->op_head || d3d12_queue->pending_head)
+        WARN("Acquired command queue %p with remaining ops.\n", d3d12_queue);
     else if (d3d12_queue->is_flushing)
         WARN("Acquired command queue %p which is flushing.\n", d3d12_queue);
 
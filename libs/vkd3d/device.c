@@ -63,6 +63,7 @@ struct vkd3d_optional_extension_info
 static const struct vkd3d_optional_extension_info optional_instance_extensions[] =
 {
     /* KHR extensions */
+    VK_EXTENSION(KHR_DEVICE_GROUP_CREATION, KHR_device_group_creation),
     VK_EXTENSION(KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2, KHR_get_physical_device_properties2),
     /* EXT extensions */
     VK_DEBUG_EXTENSION(EXT_DEBUG_REPORT, EXT_debug_report),
@@ -77,19 +78,28 @@ static const char * const required_device_extensions[] =
 static const struct vkd3d_optional_extension_info optional_device_extensions[] =
 {
     /* KHR extensions */
+    VK_EXTENSION(KHR_BUFFER_DEVICE_ADDRESS, KHR_buffer_device_address),
     VK_EXTENSION(KHR_DEDICATED_ALLOCATION, KHR_dedicated_allocation),
+    VK_EXTENSION(KHR_DESCRIPTOR_UPDATE_TEMPLATE, KHR_descriptor_update_template),
+    VK_EXTENSION(KHR_DEVICE_GROUP, KHR_device_group),
     VK_EXTENSION(KHR_DRAW_INDIRECT_COUNT, KHR_draw_indirect_count),
     VK_EXTENSION(KHR_GET_MEMORY_REQUIREMENTS_2, KHR_get_memory_requirements2),
     VK_EXTENSION(KHR_IMAGE_FORMAT_LIST, KHR_image_format_list),
     VK_EXTENSION(KHR_MAINTENANCE3, KHR_maintenance3),
     VK_EXTENSION(KHR_PUSH_DESCRIPTOR, KHR_push_descriptor),
     VK_EXTENSION(KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE, KHR_sampler_mirror_clamp_to_edge),
+#ifdef VK_EXT_descriptor_buffer
+    VK_EXTENSION(KHR_SYNCHRONIZATION_2, KHR_synchronization2),
+#endif
     VK_EXTENSION(KHR_TIMELINE_SEMAPHORE, KHR_timeline_semaphore),
     /* EXT extensions */
     VK_EXTENSION(EXT_CALIBRATED_TIMESTAMPS, EXT_calibrated_timestamps),
     VK_EXTENSION(EXT_CONDITIONAL_RENDERING, EXT_conditional_rendering),
     VK_EXTENSION(EXT_DEBUG_MARKER, EXT_debug_marker),
     VK_EXTENSION(EXT_DEPTH_CLIP_ENABLE, EXT_depth_clip_enable),
+#ifdef VK_EXT_descriptor_buffer
+    VK_EXTENSION(EXT_DESCRIPTOR_BUFFER, EXT_descriptor_buffer),
+#endif
     VK_EXTENSION(EXT_DESCRIPTOR_INDEXING, EXT_descriptor_indexing),
     VK_EXTENSION(EXT_ROBUSTNESS_2, EXT_robustness2),
     VK_EXTENSION(EXT_SHADER_DEMOTE_TO_HELPER_INVOCATION, EXT_shader_demote_to_helper_invocation),
@@ -99,6 +109,43 @@ static const struct vkd3d_optional_extension_info optional_device_extensions[] =
     VK_EXTENSION(EXT_VERTEX_ATTRIBUTE_DIVISOR, EXT_vertex_attribute_divisor),
 };
 
+#ifdef VK_EXT_descriptor_buffer
+static void vkd3d_vk_descriptor_heap_layout_init_descriptor_buffer(struct d3d12_device *device,
+        struct vkd3d_vk_descriptor_heap_layout *layout)
+{
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT *properties = &device->vk_info.descriptor_buffer_properties;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    VK_CALL(vkGetDescriptorSetLayoutBindingOffsetEXT(device->vk_device, layout->vk_set_layout, 0,
+            &layout->binding_offset));
+
+    switch (layout->type)
+    {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            layout->descriptor_size = properties->uniformBufferDescriptorSize;
+            break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            layout->descriptor_size = properties->uniformTexelBufferDescriptorSize;
+            break;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            layout->descriptor_size = properties->sampledImageDescriptorSize;
+            break;
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            layout->descriptor_size = properties->storageTexelBufferDescriptorSize;
+            break;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            layout->descriptor_size = properties->storageImageDescriptorSize;
+            break;
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+            layout->descriptor_size = properties->samplerDescriptorSize;
+            break;
+        default:
+            ERR("Unhandled descriptor type %#x.\n", layout->type);
+            break;
+    }
+}
+#endif
+
 static HRESULT vkd3d_create_vk_descriptor_heap_layout(struct d3d12_device *device, unsigned int index)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
@@ -124,6 +171,16 @@ static HRESULT vkd3d_create_vk_descriptor_heap_layout(struct d3d12_device *devic
             | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
             | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
 
+#ifdef VK_EXT_descriptor_buffer
+    /* Descriptor buffer contents may be written at any time the GPU is not
+     * reading them, so the update after bind flags do not apply. */
+    if (device->use_descriptor_buffers)
+    {
+        set_desc.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        set_flags = VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT;
+    }
+#endif
+
     flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
     flags_info.pNext = NULL;
     flags_info.bindingCount = 1;
@@ -136,6 +193,11 @@ static HRESULT vkd3d_create_vk_descriptor_heap_layout(struct d3d12_device *devic
         return hresult_from_vk_result(vr);
     }
 
+#ifdef VK_EXT_descriptor_buffer
+    if (device->use_descriptor_buffers)
+        vkd3d_vk_descriptor_heap_layout_init_descriptor_buffer(device, &device->vk_descriptor_heap_layouts[index]);
+#endif
+
     return S_OK;
 }
 
@@ -494,6 +556,9 @@ static void vkd3d_init_debug_report(struct vkd3d_instance *instance)
 
 static const struct vkd3d_debug_option vkd3d_config_options[] =
 {
+    {"deferred_recording", VKD3D_CONFIG_FLAG_DEFERRED_RECORDING}, /* record command lists into an intermediate stream */
+    {"descriptor_buffer", VKD3D_CONFIG_FLAG_DESCRIPTOR_BUFFER}, /* back descriptor heaps with descriptor buffers */
+    {"submit_thread", VKD3D_CONFIG_FLAG_SUBMIT_THREAD}, /* submit command queue work from a worker thread */
     {"virtual_heaps", VKD3D_CONFIG_FLAG_VIRTUAL_HEAPS}, /* always use virtual descriptor heaps */
     {"vk_debug", VKD3D_CONFIG_FLAG_VULKAN_DEBUG}, /* enable Vulkan debug extensions */
 };
@@ -742,6 +807,9 @@ VkInstance vkd3d_instance_get_vk_instance(struct vkd3d_instance *instance)
 struct vkd3d_physical_device_info
 {
     /* properties */
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptor_buffer_properties;
+#endif
     VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptor_indexing_properties;
     VkPhysicalDeviceMaintenance3Properties maintenance3_properties;
     VkPhysicalDeviceTexelBufferAlignmentPropertiesEXT texel_buffer_alignment_properties;
@@ -751,8 +819,12 @@ struct vkd3d_physical_device_info
     VkPhysicalDeviceProperties2KHR properties2;
 
     /* features */
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR buffer_device_address_features;
     VkPhysicalDeviceConditionalRenderingFeaturesEXT conditional_rendering_features;
     VkPhysicalDeviceDepthClipEnableFeaturesEXT depth_clip_features;
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptor_buffer_features;
+#endif
     VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features;
     VkPhysicalDeviceRobustness2FeaturesEXT robustness2_features;
     VkPhysicalDeviceShaderDemoteToHelperInvocationFeaturesEXT demote_features;
@@ -768,6 +840,11 @@ static void vkd3d_physical_device_info_init(struct vkd3d_physical_device_info *i
 {
     const struct vkd3d_vk_instance_procs *vk_procs = &device->vkd3d_instance->vk_procs;
     VkPhysicalDeviceConditionalRenderingFeaturesEXT *conditional_rendering_features;
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR *buffer_device_address_features;
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT *descriptor_buffer_properties;
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT *descriptor_buffer_features;
+#endif
     VkPhysicalDeviceDescriptorIndexingPropertiesEXT *descriptor_indexing_properties;
     VkPhysicalDeviceVertexAttributeDivisorPropertiesEXT *vertex_divisor_properties;
     VkPhysicalDeviceTexelBufferAlignmentPropertiesEXT *buffer_alignment_properties;
@@ -785,8 +862,13 @@ static void vkd3d_physical_device_info_init(struct vkd3d_physical_device_info *i
     struct vkd3d_vulkan_info *vulkan_info = &device->vk_info;
 
     memset(info, 0, sizeof(*info));
+    buffer_device_address_features = &info->buffer_device_address_features;
     conditional_rendering_features = &info->conditional_rendering_features;
     depth_clip_features = &info->depth_clip_features;
+#ifdef VK_EXT_descriptor_buffer
+    descriptor_buffer_features = &info->descriptor_buffer_features;
+    descriptor_buffer_properties = &info->descriptor_buffer_properties;
+#endif
     descriptor_indexing_features = &info->descriptor_indexing_features;
     robustness2_features = &info->robustness2_features;
     descriptor_indexing_properties = &info->descriptor_indexing_properties;
@@ -802,10 +884,16 @@ static void vkd3d_physical_device_info_init(struct vkd3d_physical_device_info *i
 
     info->features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
 
+    buffer_device_address_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR;
+    vk_prepend_struct(&info->features2, buffer_device_address_features);
     conditional_rendering_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT;
     vk_prepend_struct(&info->features2, conditional_rendering_features);
     depth_clip_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DEPTH_CLIP_ENABLE_FEATURES_EXT;
     vk_prepend_struct(&info->features2, depth_clip_features);
+#ifdef VK_EXT_descriptor_buffer
+    descriptor_buffer_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+    vk_prepend_struct(&info->features2, descriptor_buffer_features);
+#endif
     descriptor_indexing_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
     vk_prepend_struct(&info->features2, descriptor_indexing_features);
     robustness2_features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT;
@@ -830,6 +918,10 @@ static void vkd3d_physical_device_info_init(struct vkd3d_physical_device_info *i
 
     maintenance3_properties->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_3_PROPERTIES;
     vk_prepend_struct(&info->properties2, maintenance3_properties);
+#ifdef VK_EXT_descriptor_buffer
+    descriptor_buffer_properties->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+    vk_prepend_struct(&info->properties2, descriptor_buffer_properties);
+#endif
     descriptor_indexing_properties->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
     vk_prepend_struct(&info->properties2, descriptor_indexing_properties);
     buffer_alignment_properties->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TEXEL_BUFFER_ALIGNMENT_PROPERTIES_EXT;
@@ -1437,7 +1529,11 @@ static HRESULT vkd3d_init_device_caps(struct d3d12_device *device,
 {
     const struct vkd3d_vk_instance_procs *vk_procs = &device->vkd3d_instance->vk_procs;
     const struct vkd3d_optional_device_extensions_info *optional_extensions;
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR *buffer_device_address;
     VkPhysicalDeviceDescriptorIndexingFeaturesEXT *descriptor_indexing;
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT *descriptor_buffer;
+#endif
     VkPhysicalDevice physical_device = device->vk_physical_device;
     struct vkd3d_vulkan_info *vulkan_info = &device->vk_info;
     VkExtensionProperties *vk_extensions;
@@ -1673,6 +1769,58 @@ static HRESULT vkd3d_init_device_caps(struct d3d12_device *device,
             && descriptor_indexing->descriptorBindingUniformTexelBufferUpdateAfterBind
             && descriptor_indexing->descriptorBindingStorageTexelBufferUpdateAfterBind;
 
+    /* Descriptor buffers are an optional backend for Vulkan heaps. Root
+     * descriptors must be pushed, because a set in a descriptor buffer
+     * pipeline layout holds either push descriptors or only immutable
+     * samplers. Older Vulkan headers don't define VK_EXT_descriptor_buffer,
+     * in which case the descriptor set path is always used. */
+    buffer_device_address = &physical_device_info->buffer_device_address_features;
+#ifdef VK_EXT_descriptor_buffer
+    descriptor_buffer = &physical_device_info->descriptor_buffer_features;
+    device->use_descriptor_buffers = device->use_vk_heaps
+            && (device->vkd3d_instance->config_flags & VKD3D_CONFIG_FLAG_DESCRIPTOR_BUFFER)
+            && vulkan_info->EXT_descriptor_buffer && vulkan_info->KHR_buffer_device_address
+            && vulkan_info->KHR_device_group && vulkan_info->KHR_device_group_creation
+            && vulkan_info->KHR_synchronization2 && vulkan_info->KHR_push_descriptor
+            && descriptor_buffer->descriptorBuffer && descriptor_buffer->descriptorBufferPushDescriptors
+            && buffer_device_address->bufferDeviceAddress;
+
+    if (device->use_descriptor_buffers)
+    {
+        VkPhysicalDeviceDescriptorBufferPropertiesEXT *properties = &vulkan_info->descriptor_buffer_properties;
+
+        *properties = physical_device_info->descriptor_buffer_properties;
+        properties->pNext = NULL;
+        if (features->robustBufferAccess)
+        {
+            properties->uniformBufferDescriptorSize = properties->robustUniformBufferDescriptorSize;
+            properties->uniformTexelBufferDescriptorSize = properties->robustUniformTexelBufferDescriptorSize;
+            properties->storageTexelBufferDescriptorSize = properties->robustStorageTexelBufferDescriptorSize;
+        }
+    }
+    else
+    {
+        descriptor_buffer->descriptorBuffer = VK_FALSE;
+        descriptor_buffer->descriptorBufferPushDescriptors = VK_FALSE;
+    }
+    descriptor_buffer->descriptorBufferCaptureReplay = VK_FALSE;
+    descriptor_buffer->descriptorBufferImageLayoutIgnored = VK_FALSE;
+#else
+    device->use_descriptor_buffers = false;
+#endif
+    if (!device->use_descriptor_buffers)
+    {
+        if (device->vkd3d_instance->config_flags & VKD3D_CONFIG_FLAG_DESCRIPTOR_BUFFER)
+            WARN("Descriptor buffers are not supported.\n");
+        vulkan_info->EXT_descriptor_buffer = false;
+        vulkan_info->KHR_buffer_device_address = false;
+        vulkan_info->KHR_device_group = false;
+        vulkan_info->KHR_synchronization2 = false;
+        buffer_device_address->bufferDeviceAddress = VK_FALSE;
+    }
+    buffer_device_address->bufferDeviceAddressCaptureReplay = VK_FALSE;
+    buffer_device_address->bufferDeviceAddressMultiDevice = VK_FALSE;
+
     if (device->use_vk_heaps)
         vkd3d_device_vk_heaps_descriptor_limits_init(&vulkan_info->descriptor_limits,
                 &physical_device_info->descriptor_indexing_properties);
@@ -2047,25 +2195,186 @@ static HRESULT vkd3d_create_vk_device(struct d3d12_device *device,
     return hr;
 }
 
+#define VKD3D_PIPELINE_CACHE_MAGIC VKD3D_MAKE_TAG('V', 'P', 'C', 'H')
+#define VKD3D_PIPELINE_CACHE_VERSION 1
+#define VKD3D_PIPELINE_CACHE_DEFAULT_MAX_SIZE_MB 256u
+
+struct vkd3d_pipeline_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t build_hash;
+    uint8_t device_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+};
+
+/* Pipeline cache data is only valid for the exact same libvkd3d and
+ * libvkd3d-shader builds, since either may change the generated SPIR-V. */
+uint64_t vkd3d_get_build_hash(void)
+{
+    static const char build[] = PACKAGE_STRING VKD3D_VCS_ID;
+    const char *shader_version;
+    uint64_t hash;
+
+    shader_version = vkd3d_shader_get_version(NULL, NULL);
+    hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, build, sizeof(build));
+    return vkd3d_hash_fnv1a_64(hash, shader_version, strlen(shader_version));
+}
+
+static bool d3d12_device_init_pipeline_cache_path(struct d3d12_device *device,
+        const VkPhysicalDeviceProperties *properties)
+{
+    char uuid[2 * VK_UUID_SIZE + 1];
+    const char *directory;
+    char path[1024];
+    unsigned int i;
+    int len;
+
+    if (!(directory = getenv("VKD3D_PIPELINE_CACHE_PATH")) || !*directory)
+        return false;
+
+    for (i = 0; i < VK_UUID_SIZE; ++i)
+        sprintf(&uuid[2 * i], "%02x", properties->pipelineCacheUUID[i]);
+
+    len = snprintf(path, ARRAY_SIZE(path), "%s/vkd3d-pipeline-cache-%04x-%04x-%s.bin",
+            directory, properties->vendorID, properties->deviceID, uuid);
+    if (len < 0 || len >= ARRAY_SIZE(path))
+    {
+        WARN("Pipeline cache path is too long.\n");
+        return false;
+    }
+
+    if (!(device->pipeline_cache_path = vkd3d_strdup(path)))
+        return false;
+    device->pipeline_cache_max_size = (size_t)vkd3d_env_var_as_uint("VKD3D_PIPELINE_CACHE_MAX_SIZE",
+            VKD3D_PIPELINE_CACHE_DEFAULT_MAX_SIZE_MB) * 1024 * 1024;
+
+    TRACE("Using persistent pipeline cache %s, max size %zu.\n",
+            debugstr_a(device->pipeline_cache_path), device->pipeline_cache_max_size);
+
+    return true;
+}
+
+static void *d3d12_device_load_pipeline_cache_data(struct d3d12_device *device, size_t *data_size)
+{
+    const struct vkd3d_pipeline_cache_header *header;
+    size_t size;
+    void *blob;
+
+    *data_size = 0;
+
+    if (!(blob = vkd3d_load_file(device->pipeline_cache_path, &size)))
+        return NULL;
+
+    header = blob;
+    if (size < sizeof(*header) || header->magic != VKD3D_PIPELINE_CACHE_MAGIC
+            || header->version != VKD3D_PIPELINE_CACHE_VERSION
+            || header->build_hash != vkd3d_get_build_hash()
+            || memcmp(header->device_uuid, device->pipeline_cache_uuid, VK_UUID_SIZE)
+            || header->data_size != size - sizeof(*header)
+            || header->data_size > device->pipeline_cache_max_size)
+    {
+        WARN("Ignoring stale or invalid pipeline cache %s.\n", debugstr_a(device->pipeline_cache_path));
+        vkd3d_free(blob);
+        return NULL;
+    }
+
+    *data_size = header->data_size;
+    return blob;
+}
+
+static void d3d12_device_store_pipeline_cache(struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_pipeline_cache_header *header;
+    size_t data_size;
+    VkResult vr;
+    void *blob;
+
+    if (!device->pipeline_cache_path || !device->vk_pipeline_cache)
+        return;
+
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device->vk_device, device->vk_pipeline_cache,
+            &data_size, NULL))) < 0)
+    {
+        WARN("Failed to get pipeline cache data size, vr %d.\n", vr);
+        return;
+    }
+    if (data_size > device->pipeline_cache_max_size)
+    {
+        WARN("Pipeline cache size %zu exceeds the limit of %zu bytes, not storing it.\n",
+                data_size, device->pipeline_cache_max_size);
+        /* The old file is stale as well; don't load it again on the next run. */
+        vkd3d_remove_file(device->pipeline_cache_path);
+        return;
+    }
+
+    if (!(blob = vkd3d_malloc(sizeof(*header) + data_size)))
+        return;
+
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device->vk_device, device->vk_pipeline_cache,
+            &data_size, (uint8_t *)blob + sizeof(*header)))) < 0)
+    {
+        WARN("Failed to get pipeline cache data, vr %d.\n", vr);
+        vkd3d_free(blob);
+        return;
+    }
+
+    header = blob;
+    header->magic = VKD3D_PIPELINE_CACHE_MAGIC;
+    header->version = VKD3D_PIPELINE_CACHE_VERSION;
+    header->build_hash = vkd3d_get_build_hash();
+    memcpy(header->device_uuid, device->pipeline_cache_uuid, VK_UUID_SIZE);
+    header->data_size = data_size;
+
+    if (vkd3d_store_file_atomic(device->pipeline_cache_path, blob, sizeof(*header) + data_size))
+        TRACE("Stored %zu bytes of pipeline cache data.\n", data_size);
+
+    vkd3d_free(blob);
+}
+
 static HRESULT d3d12_device_init_pipeline_cache(struct d3d12_device *device)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkPhysicalDeviceProperties device_properties;
     VkPipelineCacheCreateInfo cache_info;
+    size_t initial_data_size = 0;
+    void *blob = NULL;
     VkResult vr;
 
     vkd3d_mutex_init(&device->mutex);
 
+    device->pipeline_cache_path = NULL;
+    device->pipeline_cache_max_size = 0;
+
+    VK_CALL(vkGetPhysicalDeviceProperties(device->vk_physical_device, &device_properties));
+    memcpy(device->pipeline_cache_uuid, device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+    if (d3d12_device_init_pipeline_cache_path(device, &device_properties))
+        blob = d3d12_device_load_pipeline_cache_data(device, &initial_data_size);
+
     cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     cache_info.pNext = NULL;
     cache_info.flags = 0;
-    cache_info.initialDataSize = 0;
-    cache_info.pInitialData = NULL;
+    cache_info.initialDataSize = initial_data_size;
+    cache_info.pInitialData = blob ? (uint8_t *)blob + sizeof(struct vkd3d_pipeline_cache_header) : NULL;
     if ((vr = VK_CALL(vkCreatePipelineCache(device->vk_device, &cache_info, NULL,
-            &device->vk_pipeline_cache))) < 0)
+            &device->vk_pipeline_cache))) < 0 && blob)
+    {
+        WARN("Failed to create Vulkan pipeline cache from stored data, vr %d.\n", vr);
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device->vk_device, &cache_info, NULL, &device->vk_pipeline_cache));
+    }
+    vkd3d_free(blob);
+    if (vr < 0)
     {
         ERR("Failed to create Vulkan pipeline cache, vr %d.\n", vr);
         device->vk_pipeline_cache = VK_NULL_HANDLE;
     }
+    else if (initial_data_size)
+    {
+        TRACE("Loaded %zu bytes of pipeline cache data.\n", initial_data_size);
+    }
 
     return S_OK;
 }
@@ -2076,6 +2385,7 @@ static void d3d12_device_destroy_pipeline_cache(struct d3d12_device *device)
 
     if (device->vk_pipeline_cache)
         VK_CALL(vkDestroyPipelineCache(device->vk_device, device->vk_pipeline_cache, NULL));
+    vkd3d_free(device->pipeline_cache_path);
 
     vkd3d_mutex_destroy(&device->mutex);
 }
@@ -2414,22 +2724,23 @@ static void vkd3d_init_descriptor_pool_sizes(VkDescriptorPoolSize *pool_sizes,
             VKD3D_MAX_VIRTUAL_HEAP_DESCRIPTORS_PER_TYPE);
 };
 
-/* ID3D12Device */
-static inline struct d3d12_device *impl_from_ID3D12Device(ID3D12Device *iface)
+/* ID3D12Device1 */
+static inline struct d3d12_device *impl_from_ID3D12Device1(ID3D12Device1 *iface)
 {
-    return CONTAINING_RECORD(iface, struct d3d12_device, ID3D12Device_iface);
+    return CONTAINING_RECORD(iface, struct d3d12_device, ID3D12Device1_iface);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_QueryInterface(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_QueryInterface(ID3D12Device1 *iface,
         REFIID riid, void **object)
 {
     TRACE("iface %p, riid %s, object %p.\n", iface, debugstr_guid(riid), object);
 
-    if (IsEqualGUID(riid, &IID_ID3D12Device)
+    if (IsEqualGUID(riid, &IID_ID3D12Device1)
+            || IsEqualGUID(riid, &IID_ID3D12Device)
             || IsEqualGUID(riid, &IID_ID3D12Object)
             || IsEqualGUID(riid, &IID_IUnknown))
     {
-        ID3D12Device_AddRef(iface);
+        ID3D12Device1_AddRef(iface);
         *object = iface;
         return S_OK;
     }
@@ -2440,9 +2751,9 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_QueryInterface(ID3D12Device *iface
     return E_NOINTERFACE;
 }
 
-static ULONG STDMETHODCALLTYPE d3d12_device_AddRef(ID3D12Device *iface)
+static ULONG STDMETHODCALLTYPE d3d12_device_AddRef(ID3D12Device1 *iface)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     ULONG refcount = InterlockedIncrement(&device->refcount);
 
     TRACE("%p increasing refcount to %u.\n", device, refcount);
@@ -2450,11 +2761,10 @@ static ULONG STDMETHODCALLTYPE d3d12_device_AddRef(ID3D12Device *iface)
     return refcount;
 }
 
-static ULONG STDMETHODCALLTYPE d3d12_device_Release(ID3D12Device *iface)
+static ULONG STDMETHODCALLTYPE d3d12_device_Release(ID3D12Device1 *iface)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     ULONG refcount = InterlockedDecrement(&device->refcount);
-    size_t i;
 
     TRACE("%p decreasing refcount to %u.\n", device, refcount);
 
@@ -2463,6 +2773,7 @@ static ULONG STDMETHODCALLTYPE d3d12_device_Release(ID3D12Device *iface)
         const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
         vkd3d_mutex_destroy(&device->blocked_queues_mutex);
+        vkd3d_free(device->blocked_queues);
 
         vkd3d_private_store_destroy(&device->private_store);
 
@@ -2471,11 +2782,17 @@ static ULONG STDMETHODCALLTYPE d3d12_device_Release(ID3D12Device *iface)
         vkd3d_uav_clear_state_cleanup(&device->uav_clear_state, device);
         vkd3d_destroy_null_resources(&device->null_resources, device);
         vkd3d_gpu_va_allocator_cleanup(&device->gpu_va_allocator);
+        vkd3d_pipeline_compiler_cleanup(&device->pipeline_compiler, device);
+        vkd3d_descriptor_pool_cache_cleanup(&device->descriptor_pool_cache, device);
+        vkd3d_view_reclaimer_cleanup(&device->view_reclaimer, device);
+        vkd3d_fence_worker_cleanup(&device->fence_worker, device);
+        vkd3d_framebuffer_cache_cleanup(&device->framebuffer_cache, device);
         vkd3d_render_pass_cache_cleanup(&device->render_pass_cache, device);
+        vkd3d_shader_cache_cleanup(&device->shader_cache);
+        d3d12_device_store_pipeline_cache(device);
         d3d12_device_destroy_pipeline_cache(device);
         d3d12_device_destroy_vkd3d_queues(device);
-        for (i = 0; i < ARRAY_SIZE(device->desc_mutex); ++i)
-            vkd3d_mutex_destroy(&device->desc_mutex[i]);
+        vkd3d_memory_allocator_cleanup(&device->memory_allocator, device);
         VK_CALL(vkDestroyDevice(device->vk_device, NULL));
         if (device->parent)
             IUnknown_Release(device->parent);
@@ -2487,10 +2804,10 @@ static ULONG STDMETHODCALLTYPE d3d12_device_Release(ID3D12Device *iface)
     return refcount;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_GetPrivateData(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_GetPrivateData(ID3D12Device1 *iface,
         REFGUID guid, UINT *data_size, void *data)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, guid %s, data_size %p, data %p.\n",
             iface, debugstr_guid(guid), data_size, data);
@@ -2498,10 +2815,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_GetPrivateData(ID3D12Device *iface
     return vkd3d_get_private_data(&device->private_store, guid, data_size, data);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_SetPrivateData(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetPrivateData(ID3D12Device1 *iface,
         REFGUID guid, UINT data_size, const void *data)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, guid %s, data_size %u, data %p.\n",
             iface, debugstr_guid(guid), data_size, data);
@@ -2509,19 +2826,19 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_SetPrivateData(ID3D12Device *iface
     return vkd3d_set_private_data(&device->private_store, guid, data_size, data);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_SetPrivateDataInterface(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetPrivateDataInterface(ID3D12Device1 *iface,
         REFGUID guid, const IUnknown *data)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
 
     return vkd3d_set_private_data_interface(&device->private_store, guid, data);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_SetName(ID3D12Device *iface, const WCHAR *name)
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetName(ID3D12Device1 *iface, const WCHAR *name)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, name %s.\n", iface, debugstr_w(name, device->wchar_size));
 
@@ -2529,17 +2846,17 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_SetName(ID3D12Device *iface, const
             VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_EXT, name);
 }
 
-static UINT STDMETHODCALLTYPE d3d12_device_GetNodeCount(ID3D12Device *iface)
+static UINT STDMETHODCALLTYPE d3d12_device_GetNodeCount(ID3D12Device1 *iface)
 {
     TRACE("iface %p.\n", iface);
 
     return 1;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandQueue(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandQueue(ID3D12Device1 *iface,
         const D3D12_COMMAND_QUEUE_DESC *desc, REFIID riid, void **command_queue)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_command_queue *object;
     HRESULT hr;
 
@@ -2553,10 +2870,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandQueue(ID3D12Device *i
             riid, command_queue);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandAllocator(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandAllocator(ID3D12Device1 *iface,
         D3D12_COMMAND_LIST_TYPE type, REFIID riid, void **command_allocator)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_command_allocator *object;
     HRESULT hr;
 
@@ -2570,10 +2887,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandAllocator(ID3D12Devic
             riid, command_allocator);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateGraphicsPipelineState(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateGraphicsPipelineState(ID3D12Device1 *iface,
         const D3D12_GRAPHICS_PIPELINE_STATE_DESC *desc, REFIID riid, void **pipeline_state)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_pipeline_state *object;
     HRESULT hr;
 
@@ -2587,10 +2904,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateGraphicsPipelineState(ID3D12
             &IID_ID3D12PipelineState, riid, pipeline_state);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateComputePipelineState(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateComputePipelineState(ID3D12Device1 *iface,
         const D3D12_COMPUTE_PIPELINE_STATE_DESC *desc, REFIID riid, void **pipeline_state)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_pipeline_state *object;
     HRESULT hr;
 
@@ -2604,11 +2921,11 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateComputePipelineState(ID3D12D
             &IID_ID3D12PipelineState, riid, pipeline_state);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandList(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandList(ID3D12Device1 *iface,
         UINT node_mask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator *command_allocator,
         ID3D12PipelineState *initial_pipeline_state, REFIID riid, void **command_list)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_command_list *object;
     HRESULT hr;
 
@@ -2731,10 +3048,10 @@ bool d3d12_device_is_uma(struct d3d12_device *device, bool *coherent)
     return true;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CheckFeatureSupport(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CheckFeatureSupport(ID3D12Device1 *iface,
         D3D12_FEATURE feature, void *feature_data, UINT feature_data_size)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, feature %#x, feature_data %p, feature_data_size %u.\n",
             iface, feature, feature_data, feature_data_size);
@@ -3079,11 +3396,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CheckFeatureSupport(ID3D12Device *
                 return E_INVALIDARG;
             }
 
-            /* FIXME: The d3d12 documentation states that
-             * D3D12_SHADER_CACHE_SUPPORT_SINGLE_PSO is always supported, but
-             * the CachedPSO field of D3D12_GRAPHICS_PIPELINE_STATE_DESC is
-             * ignored and GetCachedBlob() is a stub. */
-            data->SupportFlags = D3D12_SHADER_CACHE_SUPPORT_NONE;
+            data->SupportFlags = D3D12_SHADER_CACHE_SUPPORT_SINGLE_PSO | D3D12_SHADER_CACHE_SUPPORT_LIBRARY;
 
             TRACE("Shader cache support %#x.\n", data->SupportFlags);
             return S_OK;
@@ -3233,10 +3546,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CheckFeatureSupport(ID3D12Device *
     }
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateDescriptorHeap(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateDescriptorHeap(ID3D12Device1 *iface,
         const D3D12_DESCRIPTOR_HEAP_DESC *desc, REFIID riid, void **descriptor_heap)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_descriptor_heap *object;
     HRESULT hr;
 
@@ -3250,7 +3563,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateDescriptorHeap(ID3D12Device
             &IID_ID3D12DescriptorHeap, riid, descriptor_heap);
 }
 
-static UINT STDMETHODCALLTYPE d3d12_device_GetDescriptorHandleIncrementSize(ID3D12Device *iface,
+static UINT STDMETHODCALLTYPE d3d12_device_GetDescriptorHandleIncrementSize(ID3D12Device1 *iface,
         D3D12_DESCRIPTOR_HEAP_TYPE descriptor_heap_type)
 {
     TRACE("iface %p, descriptor_heap_type %#x.\n", iface, descriptor_heap_type);
@@ -3273,11 +3586,11 @@ static UINT STDMETHODCALLTYPE d3d12_device_GetDescriptorHandleIncrementSize(ID3D
     }
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateRootSignature(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateRootSignature(ID3D12Device1 *iface,
         UINT node_mask, const void *bytecode, SIZE_T bytecode_length,
         REFIID riid, void **root_signature)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_root_signature *object;
     HRESULT hr;
 
@@ -3293,10 +3606,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateRootSignature(ID3D12Device *
             &IID_ID3D12RootSignature, riid, root_signature);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateConstantBufferView(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateConstantBufferView(ID3D12Device1 *iface,
         const D3D12_CONSTANT_BUFFER_VIEW_DESC *desc, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_desc tmp = {0};
 
     TRACE("iface %p, desc %p, descriptor %#lx.\n", iface, desc, descriptor.ptr);
@@ -3305,11 +3618,11 @@ static void STDMETHODCALLTYPE d3d12_device_CreateConstantBufferView(ID3D12Device
     d3d12_desc_write_atomic(d3d12_desc_from_cpu_handle(descriptor), &tmp, device);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateShaderResourceView(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateShaderResourceView(ID3D12Device1 *iface,
         ID3D12Resource *resource, const D3D12_SHADER_RESOURCE_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_desc tmp = {0};
 
     TRACE("iface %p, resource %p, desc %p, descriptor %#lx.\n",
@@ -3319,11 +3632,11 @@ static void STDMETHODCALLTYPE d3d12_device_CreateShaderResourceView(ID3D12Device
     d3d12_desc_write_atomic(d3d12_desc_from_cpu_handle(descriptor), &tmp, device);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateUnorderedAccessView(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateUnorderedAccessView(ID3D12Device1 *iface,
         ID3D12Resource *resource, ID3D12Resource *counter_resource,
         const D3D12_UNORDERED_ACCESS_VIEW_DESC *desc, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_desc tmp = {0};
 
     TRACE("iface %p, resource %p, counter_resource %p, desc %p, descriptor %#lx.\n",
@@ -3334,7 +3647,7 @@ static void STDMETHODCALLTYPE d3d12_device_CreateUnorderedAccessView(ID3D12Devic
     d3d12_desc_write_atomic(d3d12_desc_from_cpu_handle(descriptor), &tmp, device);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateRenderTargetView(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateRenderTargetView(ID3D12Device1 *iface,
         ID3D12Resource *resource, const D3D12_RENDER_TARGET_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
@@ -3342,10 +3655,10 @@ static void STDMETHODCALLTYPE d3d12_device_CreateRenderTargetView(ID3D12Device *
             iface, resource, desc, descriptor.ptr);
 
     d3d12_rtv_desc_create_rtv(d3d12_rtv_desc_from_cpu_handle(descriptor),
-            impl_from_ID3D12Device(iface), unsafe_impl_from_ID3D12Resource(resource), desc);
+            impl_from_ID3D12Device1(iface), unsafe_impl_from_ID3D12Resource(resource), desc);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateDepthStencilView(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateDepthStencilView(ID3D12Device1 *iface,
         ID3D12Resource *resource, const D3D12_DEPTH_STENCIL_VIEW_DESC *desc,
         D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
@@ -3353,13 +3666,13 @@ static void STDMETHODCALLTYPE d3d12_device_CreateDepthStencilView(ID3D12Device *
             iface, resource, desc, descriptor.ptr);
 
     d3d12_dsv_desc_create_dsv(d3d12_dsv_desc_from_cpu_handle(descriptor),
-            impl_from_ID3D12Device(iface), unsafe_impl_from_ID3D12Resource(resource), desc);
+            impl_from_ID3D12Device1(iface), unsafe_impl_from_ID3D12Resource(resource), desc);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CreateSampler(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CreateSampler(ID3D12Device1 *iface,
         const D3D12_SAMPLER_DESC *desc, D3D12_CPU_DESCRIPTOR_HANDLE descriptor)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_desc tmp = {0};
 
     TRACE("iface %p, desc %p, descriptor %#lx.\n", iface, desc, descriptor.ptr);
@@ -3388,29 +3701,20 @@ static void d3d12_desc_buffered_copy_atomic(struct d3d12_desc *dst, const struct
 {
     struct d3d12_desc_copy_location *location;
     enum vkd3d_vk_descriptor_set_index set;
-    struct vkd3d_mutex *mutex;
+    struct d3d12_desc tmp;
 
-    mutex = d3d12_device_get_descriptor_mutex(device, src);
-    vkd3d_mutex_lock(mutex);
+    d3d12_desc_read_atomic(&tmp, src, device);
 
-    if (src->s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE)
+    if (tmp.s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE)
     {
-        /* Source must be unlocked first, and therefore can't be used as a null source. */
-        static const struct d3d12_desc null = {0};
-        vkd3d_mutex_unlock(mutex);
-        d3d12_desc_write_atomic(dst, &null, device);
+        d3d12_desc_write_atomic(dst, &tmp, device);
         return;
     }
 
-    set = vkd3d_vk_descriptor_set_index_from_vk_descriptor_type(src->s.vk_descriptor_type);
+    set = vkd3d_vk_descriptor_set_index_from_vk_descriptor_type(tmp.s.vk_descriptor_type);
     location = &locations[set][infos[set].count++];
 
-    location->src.s = src->s;
-
-    if (location->src.s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW)
-        vkd3d_view_incref(location->src.s.u.view_info.view);
-
-    vkd3d_mutex_unlock(mutex);
+    location->src.s = tmp.s;
 
     infos[set].uav_counter |= (location->src.s.magic == VKD3D_DESCRIPTOR_MAGIC_UAV)
             && !!location->src.s.u.view_info.view->vk_counter_view;
@@ -3424,6 +3728,8 @@ static void d3d12_desc_buffered_copy_atomic(struct d3d12_desc *dst, const struct
     }
 }
 
+#define VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT 8
+
 /* Some games, e.g. Control, copy a large number of descriptors per frame, so the
  * speed of this function is critical. */
 static void d3d12_device_vk_heaps_copy_descriptors(struct d3d12_device *device,
@@ -3439,7 +3745,7 @@ static void d3d12_device_vk_heaps_copy_descriptors(struct d3d12_device *device,
     struct d3d12_desc_copy_info infos[VKD3D_SET_INDEX_COUNT];
     struct d3d12_descriptor_heap *descriptor_heap = NULL;
     const struct d3d12_desc *src, *heap_base, *heap_end;
-    unsigned int dst_range_size, src_range_size;
+    unsigned int dst_range_size, src_range_size, count;
     struct d3d12_desc *dst;
 
     descriptor_heap = d3d12_desc_get_descriptor_heap(d3d12_desc_from_cpu_handle(dst_descriptor_range_offsets[0]));
@@ -3465,6 +3771,16 @@ static void d3d12_device_vk_heaps_copy_descriptors(struct d3d12_device *device,
             heap_end = heap_base + descriptor_heap->desc.NumDescriptors;
         }
 
+        /* Both ranges are contiguous, so long runs can be copied in bulk. */
+        count = min(dst_range_size - dst_idx, src_range_size - src_idx);
+        if (count >= VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT)
+        {
+            flush_desc_writes(locations, infos, descriptor_heap, device);
+            d3d12_desc_copy_contiguous(&dst[dst_idx], &src[src_idx], count, device);
+            dst_idx += count;
+            src_idx += count;
+        }
+
         for (; dst_idx < dst_range_size && src_idx < src_range_size; src_idx++, dst_idx++)
         {
             /* We don't need to lock either descriptor for the identity check. The descriptor
@@ -3492,18 +3808,16 @@ static void d3d12_device_vk_heaps_copy_descriptors(struct d3d12_device *device,
     flush_desc_writes(locations, infos, descriptor_heap, device);
 }
 
-#define VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT 8
-
-static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(ID3D12Device1 *iface,
         UINT dst_descriptor_range_count, const D3D12_CPU_DESCRIPTOR_HANDLE *dst_descriptor_range_offsets,
         const UINT *dst_descriptor_range_sizes,
         UINT src_descriptor_range_count, const D3D12_CPU_DESCRIPTOR_HANDLE *src_descriptor_range_offsets,
         const UINT *src_descriptor_range_sizes,
         D3D12_DESCRIPTOR_HEAP_TYPE descriptor_heap_type)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     unsigned int dst_range_idx, dst_idx, src_range_idx, src_idx;
-    unsigned int dst_range_size, src_range_size;
+    unsigned int dst_range_size, src_range_size, count;
     const struct d3d12_desc *src;
     struct d3d12_desc *dst;
 
@@ -3525,8 +3839,9 @@ static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(ID3D12Device *iface,
     if (!dst_descriptor_range_count)
         return;
 
-    if (device->use_vk_heaps && (dst_descriptor_range_count > 1 || (dst_descriptor_range_sizes
-            && dst_descriptor_range_sizes[0] >= VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT)))
+    /* Descriptor buffer data is copied directly, so Vulkan set updates need not be batched. */
+    if (device->use_vk_heaps && !device->use_descriptor_buffers && (dst_descriptor_range_count > 1
+            || (dst_descriptor_range_sizes && dst_descriptor_range_sizes[0] >= VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT)))
     {
         d3d12_device_vk_heaps_copy_descriptors(device, dst_descriptor_range_count, dst_descriptor_range_offsets,
                 dst_descriptor_range_sizes, src_descriptor_range_count, src_descriptor_range_offsets,
@@ -3544,6 +3859,14 @@ static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(ID3D12Device *iface,
         dst = d3d12_desc_from_cpu_handle(dst_descriptor_range_offsets[dst_range_idx]);
         src = d3d12_desc_from_cpu_handle(src_descriptor_range_offsets[src_range_idx]);
 
+        count = min(dst_range_size - dst_idx, src_range_size - src_idx);
+        if (count >= VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT)
+        {
+            d3d12_desc_copy_contiguous(&dst[dst_idx], &src[src_idx], count, device);
+            dst_idx += count;
+            src_idx += count;
+        }
+
         while (dst_idx < dst_range_size && src_idx < src_range_size)
             d3d12_desc_copy(&dst[dst_idx++], &src[src_idx++], device);
 
@@ -3560,7 +3883,7 @@ static void STDMETHODCALLTYPE d3d12_device_CopyDescriptors(ID3D12Device *iface,
     }
 }
 
-static void STDMETHODCALLTYPE d3d12_device_CopyDescriptorsSimple(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_CopyDescriptorsSimple(ID3D12Device1 *iface,
         UINT descriptor_count, const D3D12_CPU_DESCRIPTOR_HANDLE dst_descriptor_range_offset,
         const D3D12_CPU_DESCRIPTOR_HANDLE src_descriptor_range_offset,
         D3D12_DESCRIPTOR_HEAP_TYPE descriptor_heap_type)
@@ -3572,8 +3895,8 @@ static void STDMETHODCALLTYPE d3d12_device_CopyDescriptorsSimple(ID3D12Device *i
 
     if (descriptor_count >= VKD3D_DESCRIPTOR_OPTIMISED_COPY_MIN_COUNT)
     {
-        struct d3d12_device *device = impl_from_ID3D12Device(iface);
-        if (device->use_vk_heaps)
+        struct d3d12_device *device = impl_from_ID3D12Device1(iface);
+        if (device->use_vk_heaps && !device->use_descriptor_buffers)
         {
             d3d12_device_vk_heaps_copy_descriptors(device, 1, &dst_descriptor_range_offset,
                     &descriptor_count, 1, &src_descriptor_range_offset, &descriptor_count);
@@ -3586,10 +3909,10 @@ static void STDMETHODCALLTYPE d3d12_device_CopyDescriptorsSimple(ID3D12Device *i
 }
 
 static D3D12_RESOURCE_ALLOCATION_INFO * STDMETHODCALLTYPE d3d12_device_GetResourceAllocationInfo(
-        ID3D12Device *iface, D3D12_RESOURCE_ALLOCATION_INFO *info, UINT visible_mask,
+        ID3D12Device1 *iface, D3D12_RESOURCE_ALLOCATION_INFO *info, UINT visible_mask,
         UINT count, const D3D12_RESOURCE_DESC *resource_descs)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     const D3D12_RESOURCE_DESC *desc;
     uint64_t requested_alignment;
 
@@ -3662,10 +3985,10 @@ invalid:
     return info;
 }
 
-static D3D12_HEAP_PROPERTIES * STDMETHODCALLTYPE d3d12_device_GetCustomHeapProperties(ID3D12Device *iface,
+static D3D12_HEAP_PROPERTIES * STDMETHODCALLTYPE d3d12_device_GetCustomHeapProperties(ID3D12Device1 *iface,
         D3D12_HEAP_PROPERTIES *heap_properties, UINT node_mask, D3D12_HEAP_TYPE heap_type)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     bool coherent;
 
     TRACE("iface %p, heap_properties %p, node_mask 0x%08x, heap_type %#x.\n",
@@ -3705,12 +4028,12 @@ static D3D12_HEAP_PROPERTIES * STDMETHODCALLTYPE d3d12_device_GetCustomHeapPrope
     return heap_properties;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommittedResource(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommittedResource(ID3D12Device1 *iface,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
         const D3D12_RESOURCE_DESC *desc, D3D12_RESOURCE_STATES initial_state,
         const D3D12_CLEAR_VALUE *optimized_clear_value, REFIID iid, void **resource)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_resource *object;
     HRESULT hr;
 
@@ -3729,10 +4052,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommittedResource(ID3D12Devi
     return return_interface(&object->ID3D12Resource_iface, &IID_ID3D12Resource, iid, resource);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateHeap(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateHeap(ID3D12Device1 *iface,
         const D3D12_HEAP_DESC *desc, REFIID iid, void **heap)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_heap *object;
     HRESULT hr;
 
@@ -3748,12 +4071,12 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateHeap(ID3D12Device *iface,
     return return_interface(&object->ID3D12Heap_iface, &IID_ID3D12Heap, iid, heap);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreatePlacedResource(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreatePlacedResource(ID3D12Device1 *iface,
         ID3D12Heap *heap, UINT64 heap_offset,
         const D3D12_RESOURCE_DESC *desc, D3D12_RESOURCE_STATES initial_state,
         const D3D12_CLEAR_VALUE *optimized_clear_value, REFIID iid, void **resource)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_heap *heap_object;
     struct d3d12_resource *object;
     HRESULT hr;
@@ -3772,11 +4095,11 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreatePlacedResource(ID3D12Device
     return return_interface(&object->ID3D12Resource_iface, &IID_ID3D12Resource, iid, resource);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateReservedResource(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateReservedResource(ID3D12Device1 *iface,
         const D3D12_RESOURCE_DESC *desc, D3D12_RESOURCE_STATES initial_state,
         const D3D12_CLEAR_VALUE *optimized_clear_value, REFIID iid, void **resource)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_resource *object;
     HRESULT hr;
 
@@ -3790,11 +4113,11 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateReservedResource(ID3D12Devic
     return return_interface(&object->ID3D12Resource_iface, &IID_ID3D12Resource, iid, resource);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateSharedHandle(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateSharedHandle(ID3D12Device1 *iface,
         ID3D12DeviceChild *object, const SECURITY_ATTRIBUTES *attributes, DWORD access,
         const WCHAR *name, HANDLE *handle)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     FIXME("iface %p, object %p, attributes %p, access %#x, name %s, handle %p stub!\n",
             iface, object, attributes, access, debugstr_w(name, device->wchar_size), handle);
@@ -3802,7 +4125,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateSharedHandle(ID3D12Device *i
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandle(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandle(ID3D12Device1 *iface,
         HANDLE handle, REFIID riid, void **object)
 {
     FIXME("iface %p, handle %p, riid %s, object %p stub!\n",
@@ -3811,10 +4134,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandle(ID3D12Device *ifa
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandleByName(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandleByName(ID3D12Device1 *iface,
         const WCHAR *name, DWORD access, HANDLE *handle)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     FIXME("iface %p, name %s, access %#x, handle %p stub!\n",
             iface, debugstr_w(name, device->wchar_size), access, handle);
@@ -3822,7 +4145,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_OpenSharedHandleByName(ID3D12Devic
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_MakeResident(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_MakeResident(ID3D12Device1 *iface,
         UINT object_count, ID3D12Pageable * const *objects)
 {
     FIXME_ONCE("iface %p, object_count %u, objects %p stub!\n",
@@ -3831,7 +4154,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_MakeResident(ID3D12Device *iface,
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_Evict(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_Evict(ID3D12Device1 *iface,
         UINT object_count, ID3D12Pageable * const *objects)
 {
     FIXME_ONCE("iface %p, object_count %u, objects %p stub!\n",
@@ -3840,10 +4163,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_Evict(ID3D12Device *iface,
     return S_OK;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateFence(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateFence(ID3D12Device1 *iface,
         UINT64 initial_value, D3D12_FENCE_FLAGS flags, REFIID riid, void **fence)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_fence *object;
     HRESULT hr;
 
@@ -3856,21 +4179,21 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateFence(ID3D12Device *iface,
     return return_interface(&object->ID3D12Fence_iface, &IID_ID3D12Fence, riid, fence);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_GetDeviceRemovedReason(ID3D12Device *iface)
+static HRESULT STDMETHODCALLTYPE d3d12_device_GetDeviceRemovedReason(ID3D12Device1 *iface)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p.\n", iface);
 
     return device->removed_reason;
 }
 
-static void STDMETHODCALLTYPE d3d12_device_GetCopyableFootprints(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_GetCopyableFootprints(ID3D12Device1 *iface,
         const D3D12_RESOURCE_DESC *desc, UINT first_sub_resource, UINT sub_resource_count,
         UINT64 base_offset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts,
         UINT *row_counts, UINT64 *row_sizes, UINT64 *total_bytes)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     unsigned int i, sub_resource_idx, miplevel_idx, row_count, row_size, row_pitch;
     unsigned int width, height, depth, plane_count, sub_resources_per_plane;
@@ -3950,10 +4273,10 @@ static void STDMETHODCALLTYPE d3d12_device_GetCopyableFootprints(ID3D12Device *i
         *total_bytes = total;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateQueryHeap(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateQueryHeap(ID3D12Device1 *iface,
         const D3D12_QUERY_HEAP_DESC *desc, REFIID iid, void **heap)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_query_heap *object;
     HRESULT hr;
 
@@ -3966,18 +4289,18 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateQueryHeap(ID3D12Device *ifac
     return return_interface(&object->ID3D12QueryHeap_iface, &IID_ID3D12QueryHeap, iid, heap);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_SetStablePowerState(ID3D12Device *iface, BOOL enable)
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetStablePowerState(ID3D12Device1 *iface, BOOL enable)
 {
     FIXME("iface %p, enable %#x stub!\n", iface, enable);
 
     return E_NOTIMPL;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandSignature(ID3D12Device *iface,
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandSignature(ID3D12Device1 *iface,
         const D3D12_COMMAND_SIGNATURE_DESC *desc, ID3D12RootSignature *root_signature,
         REFIID iid, void **command_signature)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
     struct d3d12_command_signature *object;
     HRESULT hr;
 
@@ -3991,7 +4314,7 @@ static HRESULT STDMETHODCALLTYPE d3d12_device_CreateCommandSignature(ID3D12Devic
             &IID_ID3D12CommandSignature, iid, command_signature);
 }
 
-static void STDMETHODCALLTYPE d3d12_device_GetResourceTiling(ID3D12Device *iface,
+static void STDMETHODCALLTYPE d3d12_device_GetResourceTiling(ID3D12Device1 *iface,
         ID3D12Resource *resource, UINT *total_tile_count,
         D3D12_PACKED_MIP_INFO *packed_mip_info, D3D12_TILE_SHAPE *standard_tile_shape,
         UINT *sub_resource_tiling_count, UINT first_sub_resource_tiling,
@@ -4005,9 +4328,9 @@ static void STDMETHODCALLTYPE d3d12_device_GetResourceTiling(ID3D12Device *iface
             sub_resource_tilings);
 }
 
-static LUID * STDMETHODCALLTYPE d3d12_device_GetAdapterLuid(ID3D12Device *iface, LUID *luid)
+static LUID * STDMETHODCALLTYPE d3d12_device_GetAdapterLuid(ID3D12Device1 *iface, LUID *luid)
 {
-    struct d3d12_device *device = impl_from_ID3D12Device(iface);
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
 
     TRACE("iface %p, luid %p.\n", iface, luid);
 
@@ -4016,7 +4339,50 @@ static LUID * STDMETHODCALLTYPE d3d12_device_GetAdapterLuid(ID3D12Device *iface,
     return luid;
 }
 
-static const struct ID3D12DeviceVtbl d3d12_device_vtbl =
+static HRESULT STDMETHODCALLTYPE d3d12_device_CreatePipelineLibrary(ID3D12Device1 *iface,
+        const void *blob, SIZE_T blob_size, REFIID iid, void **lib)
+{
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
+    struct d3d12_pipeline_library *object;
+    HRESULT hr;
+
+    TRACE("iface %p, blob %p, blob_size %lu, iid %s, lib %p.\n",
+            iface, blob, blob_size, debugstr_guid(iid), lib);
+
+    if (FAILED(hr = d3d12_pipeline_library_create(device, blob, blob_size, &object)))
+        return hr;
+
+    return return_interface(&object->ID3D12PipelineLibrary_iface,
+            &IID_ID3D12PipelineLibrary, iid, lib);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetEventOnMultipleFenceCompletion(ID3D12Device1 *iface,
+        ID3D12Fence * const *fences, const UINT64 *values, UINT fence_count,
+        D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, HANDLE event)
+{
+    struct d3d12_device *device = impl_from_ID3D12Device1(iface);
+
+    TRACE("iface %p, fences %p, values %p, fence_count %u, flags %#x, event %p.\n",
+            iface, fences, values, fence_count, flags, event);
+
+    return vkd3d_set_event_on_multiple_fence_completion(device, fences, values, fence_count, flags, event);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_device_SetResidencyPriority(ID3D12Device1 *iface,
+        UINT object_count, ID3D12Pageable * const *objects, const D3D12_RESIDENCY_PRIORITY *priorities)
+{
+    TRACE("iface %p, object_count %u, objects %p, priorities %p.\n",
+            iface, object_count, objects, priorities);
+
+    if (object_count && (!objects || !priorities))
+        return E_INVALIDARG;
+
+    /* Vulkan manages residency itself, and we don't evict objects in
+     * MakeResident() or Evict() either, so there is nothing to prioritise. */
+    return S_OK;
+}
+
+static const struct ID3D12Device1Vtbl d3d12_device_vtbl =
 {
     /* IUnknown methods */
     d3d12_device_QueryInterface,
@@ -4065,24 +4431,29 @@ static const struct ID3D12DeviceVtbl d3d12_device_vtbl =
     d3d12_device_CreateCommandSignature,
     d3d12_device_GetResourceTiling,
     d3d12_device_GetAdapterLuid,
+    /* ID3D12Device1 methods */
+    d3d12_device_CreatePipelineLibrary,
+    d3d12_device_SetEventOnMultipleFenceCompletion,
+    d3d12_device_SetResidencyPriority,
 };
 
-struct d3d12_device *unsafe_impl_from_ID3D12Device(ID3D12Device *iface)
+struct d3d12_device *unsafe_impl_from_ID3D12Device1(ID3D12Device1 *iface)
 {
     if (!iface)
         return NULL;
     assert(iface->lpVtbl == &d3d12_device_vtbl);
-    return impl_from_ID3D12Device(iface);
+    return impl_from_ID3D12Device1(iface);
 }
 
+#define VKD3D_TRANSFER_BUFFER_DEFAULT_SIZE_MB 4u
+
 static HRESULT d3d12_device_init(struct d3d12_device *device,
         struct vkd3d_instance *instance, const struct vkd3d_device_create_info *create_info)
 {
     const struct vkd3d_vk_device_procs *vk_procs;
     HRESULT hr;
-    size_t i;
 
-    device->ID3D12Device_iface.lpVtbl = &d3d12_device_vtbl;
+    device->ID3D12Device1_iface.lpVtbl = &d3d12_device_vtbl;
     device->refcount = 1;
 
     vkd3d_instance_incref(device->vkd3d_instance = instance);
@@ -4107,8 +4478,10 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
     if (FAILED(hr = vkd3d_init_format_info(device)))
         goto out_free_private_store;
 
+    vkd3d_memory_allocator_init(&device->memory_allocator, device);
+
     if (FAILED(hr = vkd3d_init_null_resources(&device->null_resources, device)))
-        goto out_cleanup_format_info;
+        goto out_cleanup_memory_allocator;
 
     if (FAILED(hr = vkd3d_uav_clear_state_init(&device->uav_clear_state, device)))
         goto out_destroy_null_resources;
@@ -4116,16 +4489,28 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
     if (FAILED(hr = vkd3d_vk_descriptor_heap_layouts_init(device)))
         goto out_cleanup_uav_clear_state;
 
+    if (FAILED(hr = vkd3d_fence_worker_init(&device->fence_worker, device)))
+        goto out_cleanup_descriptor_heap_layouts;
+
+    device->transfer_buffer_size = (VkDeviceSize)vkd3d_env_var_as_uint("VKD3D_TRANSFER_BUFFER_SIZE",
+            VKD3D_TRANSFER_BUFFER_DEFAULT_SIZE_MB) * 1024 * 1024;
+    if (!device->transfer_buffer_size)
+        device->transfer_buffer_size = VKD3D_TRANSFER_BUFFER_DEFAULT_SIZE_MB * 1024 * 1024;
+
     vkd3d_render_pass_cache_init(&device->render_pass_cache);
+    vkd3d_framebuffer_cache_init(&device->framebuffer_cache);
+    vkd3d_descriptor_pool_cache_init(&device->descriptor_pool_cache);
+    vkd3d_view_reclaimer_init(&device->view_reclaimer);
+    vkd3d_shader_cache_init(&device->shader_cache);
+    vkd3d_pipeline_compiler_init(&device->pipeline_compiler, device);
     vkd3d_gpu_va_allocator_init(&device->gpu_va_allocator);
     vkd3d_time_domains_init(device);
 
+    device->blocked_queues = NULL;
+    device->blocked_queues_size = 0;
     device->blocked_queue_count = 0;
     vkd3d_mutex_init(&device->blocked_queues_mutex);
 
-    for (i = 0; i < ARRAY_SIZE(device->desc_mutex); ++i)
-        vkd3d_mutex_init(&device->desc_mutex[i]);
-
     vkd3d_init_descriptor_pool_sizes(device->vk_pool_sizes, &device->vk_info.descriptor_limits);
 
     if ((device->parent = create_info->parent))
@@ -4133,11 +4518,14 @@ static HRESULT d3d12_device_init(struct d3d12_device *device,
 
     return S_OK;
 
+out_cleanup_descriptor_heap_layouts:
+    vkd3d_vk_descriptor_heap_layouts_cleanup(device);
 out_cleanup_uav_clear_state:
     vkd3d_uav_clear_state_cleanup(&device->uav_clear_state, device);
 out_destroy_null_resources:
     vkd3d_destroy_null_resources(&device->null_resources, device);
-out_cleanup_format_info:
+out_cleanup_memory_allocator:
+    vkd3d_memory_allocator_cleanup(&device->memory_allocator, device);
     vkd3d_cleanup_format_info(device);
 out_free_private_store:
     vkd3d_private_store_destroy(&device->private_store);
@@ -4279,28 +4667,28 @@ HRESULT vkd3d_join_thread(struct vkd3d_instance *instance, union vkd3d_thread_ha
 
 IUnknown *vkd3d_get_device_parent(ID3D12Device *device)
 {
-    struct d3d12_device *d3d12_device = impl_from_ID3D12Device(device);
+    struct d3d12_device *d3d12_device = impl_from_ID3D12Device1((ID3D12Device1 *)device);
 
     return d3d12_device->parent;
 }
 
 VkDevice vkd3d_get_vk_device(ID3D12Device *device)
 {
-    struct d3d12_device *d3d12_device = impl_from_ID3D12Device(device);
+    struct d3d12_device *d3d12_device = impl_from_ID3D12Device1((ID3D12Device1 *)device);
 
     return d3d12_device->vk_device;
 }
 
 VkPhysicalDevice vkd3d_get_vk_physical_device(ID3D12Device *device)
 {
-    struct d3d12_device *d3d12_device = impl_from_ID3D12Device(device);
+    struct d3d12_device *d3d12_device = impl_from_ID3D12Device1((ID3D12Device1 *)device);
 
     return d3d12_device->vk_physical_device;
 }
 
 struct vkd3d_instance *vkd3d_instance_from_device(ID3D12Device *device)
 {
-    struct d3d12_device *d3d12_device = impl_from_ID3D12Device(device);
+    struct d3d12_device *d3d12_device = impl_from_ID3D12Device1((ID3D12Device1 *)device);
 
     return d3d12_device->vkd3d_instance;
 }
@@ -111,25 +111,68 @@ static HRESULT vkd3d_select_memory_type(struct d3d12_device *device, uint32_t me
     return E_FAIL;
 }
 
+static HRESULT vkd3d_allocate_vk_memory(struct d3d12_device *device, uint32_t memory_type, VkDeviceSize size,
+        const VkMemoryDedicatedAllocateInfo *dedicated_allocate_info, VkDeviceMemory *vk_memory)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkMemoryAllocateFlagsInfoKHR flags_info;
+    VkMemoryAllocateInfo allocate_info;
+    VkResult vr;
+
+    TRACE("Allocating %#"PRIx64" bytes of memory type %u.\n", size, memory_type);
+
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.pNext = dedicated_allocate_info;
+    allocate_info.allocationSize = size;
+    allocate_info.memoryTypeIndex = memory_type;
+
+    /* Buffer device addresses are needed to write buffer descriptors. */
+    if (device->use_descriptor_buffers)
+    {
+        flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
+        flags_info.pNext = dedicated_allocate_info;
+        flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+        flags_info.deviceMask = 0;
+        allocate_info.pNext = &flags_info;
+    }
+
+    if ((vr = VK_CALL(vkAllocateMemory(device->vk_device, &allocate_info, NULL, vk_memory))) < 0)
+    {
+        WARN("Failed to allocate device memory, vr %d.\n", vr);
+        *vk_memory = VK_NULL_HANDLE;
+        return hresult_from_vk_result(vr);
+    }
+
+    TRACE("%d live device memory objects.\n", InterlockedIncrement(&device->memory_allocator.device_memory_count));
+
+    return S_OK;
+}
+
+void vkd3d_free_device_memory(struct d3d12_device *device, VkDeviceMemory vk_memory)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    if (!vk_memory)
+        return;
+
+    VK_CALL(vkFreeMemory(device->vk_device, vk_memory, NULL));
+    InterlockedDecrement(&device->memory_allocator.device_memory_count);
+}
+
 static HRESULT vkd3d_allocate_device_memory(struct d3d12_device *device,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
         const VkMemoryRequirements *memory_requirements,
         const VkMemoryDedicatedAllocateInfo *dedicated_allocate_info,
         VkDeviceMemory *vk_memory, uint32_t *vk_memory_type)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    VkMemoryAllocateInfo allocate_info;
-    VkResult vr;
+    unsigned int memory_type;
     HRESULT hr;
 
     TRACE("Memory requirements: size %#"PRIx64", alignment %#"PRIx64".\n",
             memory_requirements->size, memory_requirements->alignment);
 
-    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocate_info.pNext = dedicated_allocate_info;
-    allocate_info.allocationSize = memory_requirements->size;
     if (FAILED(hr = vkd3d_select_memory_type(device, memory_requirements->memoryTypeBits,
-            heap_properties, heap_flags, &allocate_info.memoryTypeIndex)))
+            heap_properties, heap_flags, &memory_type)))
     {
         if (hr != E_INVALIDARG)
             FIXME("Failed to find suitable memory type (allowed types %#x).\n", memory_requirements->memoryTypeBits);
@@ -137,24 +180,442 @@ static HRESULT vkd3d_allocate_device_memory(struct d3d12_device *device,
         return hr;
     }
 
-    TRACE("Allocating memory type %u.\n", allocate_info.memoryTypeIndex);
+    if (FAILED(hr = vkd3d_allocate_vk_memory(device, memory_type,
+            memory_requirements->size, dedicated_allocate_info, vk_memory)))
+        return hr;
+
+    if (vk_memory_type)
+        *vk_memory_type = memory_type;
 
-    if ((vr = VK_CALL(vkAllocateMemory(device->vk_device, &allocate_info, NULL, vk_memory))) < 0)
+    return S_OK;
+}
+
+/* Committed resources are sub-allocated from large chunks of device memory,
+ * instead of each of them allocating its own VkDeviceMemory object. Free
+ * space within a chunk is tracked as a sorted list of ranges, which are
+ * allocated first-fit and coalesced on free. */
+#define VKD3D_MEMORY_CHUNK_SIZE (64u * 1024 * 1024)
+#define VKD3D_MEMORY_CHUNK_MIN_SIZE (4u * 1024 * 1024)
+
+static void vkd3d_memory_allocator_trace_stats(const struct vkd3d_memory_allocator *allocator)
+{
+    VkDeviceSize largest_free_range = 0, free_size;
+    const struct vkd3d_memory_chunk *chunk;
+    size_t i, j, k;
+
+    if (!TRACE_ON())
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(allocator->chunks); ++i)
     {
-        WARN("Failed to allocate device memory, vr %d.\n", vr);
+        for (j = 0; j < ARRAY_SIZE(allocator->chunks[i]); ++j)
+        {
+            LIST_FOR_EACH_ENTRY(chunk, &allocator->chunks[i][j], struct vkd3d_memory_chunk, entry)
+            {
+                for (k = 0; k < chunk->free_range_count; ++k)
+                    largest_free_range = max(largest_free_range, chunk->free_ranges[k].size);
+            }
+        }
+    }
+
+    free_size = allocator->chunk_memory_size - allocator->allocated_size;
+    TRACE("%d live device memory objects, %zu chunks of %#"PRIx64" bytes, "
+            "%zu sub-allocations of %#"PRIx64" bytes, %#"PRIx64" bytes free, "
+            "largest free range %#"PRIx64" bytes, fragmentation %u%%.\n",
+            allocator->device_memory_count, allocator->chunk_count, allocator->chunk_memory_size,
+            allocator->allocation_count, allocator->allocated_size, free_size, largest_free_range,
+            free_size ? (unsigned int)(100 - largest_free_range * 100 / free_size) : 0);
+}
+
+static HRESULT vkd3d_memory_chunk_create(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device,
+        uint32_t memory_type, bool linear, struct vkd3d_memory_chunk **chunk)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkMemoryPropertyFlags flags;
+    struct vkd3d_memory_chunk *object;
+    VkResult vr;
+    HRESULT hr;
+
+    if (!(object = vkd3d_malloc(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->size = allocator->chunk_size[memory_type];
+    object->memory_type = memory_type;
+    object->linear = linear;
+    object->map_ptr = NULL;
+    object->free_ranges = NULL;
+    object->free_ranges_size = 0;
+    object->free_range_count = 0;
+    object->free_size = object->size;
+    object->allocation_count = 0;
+    object->clean_offset = 0;
+
+    if (!vkd3d_array_reserve((void **)&object->free_ranges, &object->free_ranges_size,
+            2, sizeof(*object->free_ranges)))
+    {
+        vkd3d_free(object);
+        return E_OUTOFMEMORY;
+    }
+    object->free_ranges[0].offset = 0;
+    object->free_ranges[0].size = object->size;
+    object->free_range_count = 1;
+
+    if (FAILED(hr = vkd3d_allocate_vk_memory(device, memory_type, object->size, NULL, &object->vk_memory)))
+    {
+        vkd3d_free(object->free_ranges);
+        vkd3d_free(object);
+        return hr;
+    }
+
+    /* Host visible chunks stay mapped for their whole lifetime; heaps
+     * sub-allocated from them map by offsetting into the chunk mapping. */
+    flags = device->memory_properties.memoryTypes[memory_type].propertyFlags;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && (vr = VK_CALL(vkMapMemory(device->vk_device,
+            object->vk_memory, 0, VK_WHOLE_SIZE, 0, &object->map_ptr))) < 0)
+    {
+        WARN("Failed to map device memory, vr %d.\n", vr);
+        object->map_ptr = NULL;
+    }
+
+    list_add_head(&allocator->chunks[memory_type][linear], &object->entry);
+    ++allocator->chunk_count;
+    allocator->chunk_memory_size += object->size;
+
+    TRACE("Created memory chunk %p, memory type %u, size %#"PRIx64".\n", object, memory_type, object->size);
+    vkd3d_memory_allocator_trace_stats(allocator);
+
+    *chunk = object;
+
+    return S_OK;
+}
+
+static void vkd3d_memory_chunk_destroy(struct vkd3d_memory_chunk *chunk,
+        struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
+{
+    TRACE("Destroying memory chunk %p.\n", chunk);
+
+    list_remove(&chunk->entry);
+    --allocator->chunk_count;
+    allocator->chunk_memory_size -= chunk->size;
+
+    vkd3d_free_device_memory(device, chunk->vk_memory);
+    vkd3d_free(chunk->free_ranges);
+    vkd3d_free(chunk);
+}
+
+/* Only ranges starting at or above min_offset are considered. */
+static bool vkd3d_memory_chunk_allocate(struct vkd3d_memory_chunk *chunk, VkDeviceSize size,
+        VkDeviceSize alignment, VkDeviceSize min_offset, VkDeviceSize *offset, bool *is_dirty)
+{
+    struct vkd3d_memory_range *range;
+    VkDeviceSize start, end;
+    size_t i;
+
+    if (chunk->free_size < size)
+        return false;
+
+    /* Free ranges are separated by allocations, so there are never more than
+     * allocation_count + 1 of them. Reserving room for one more range up
+     * front means freeing never has to grow the array. */
+    if (!vkd3d_array_reserve((void **)&chunk->free_ranges, &chunk->free_ranges_size,
+            chunk->allocation_count + 2, sizeof(*chunk->free_ranges)))
+        return false;
+
+    for (i = 0; i < chunk->free_range_count; ++i)
+    {
+        range = &chunk->free_ranges[i];
+        start = (max(range->offset, min_offset) + alignment - 1) & ~(alignment - 1);
+        end = range->offset + range->size;
+        if (start > end || end - start < size)
+            continue;
+
+        if (start > range->offset && start + size < end)
+        {
+            memmove(&chunk->free_ranges[i + 2], &chunk->free_ranges[i + 1],
+                    (chunk->free_range_count - i - 1) * sizeof(*chunk->free_ranges));
+            chunk->free_ranges[i + 1].offset = start + size;
+            chunk->free_ranges[i + 1].size = end - (start + size);
+            range->size = start - range->offset;
+            ++chunk->free_range_count;
+        }
+        else if (start > range->offset)
+        {
+            range->size = start - range->offset;
+        }
+        else if (start + size < end)
+        {
+            range->offset = start + size;
+            range->size = end - range->offset;
+        }
+        else
+        {
+            memmove(range, range + 1, (chunk->free_range_count - i - 1) * sizeof(*chunk->free_ranges));
+            --chunk->free_range_count;
+        }
+
+        chunk->free_size -= size;
+        ++chunk->allocation_count;
+        *is_dirty = start < chunk->clean_offset;
+        chunk->clean_offset = max(chunk->clean_offset, start + size);
+        *offset = start;
+        return true;
+    }
+
+    return false;
+}
+
+static void vkd3d_memory_chunk_free(struct vkd3d_memory_chunk *chunk, VkDeviceSize offset, VkDeviceSize size)
+{
+    struct vkd3d_memory_range *ranges = chunk->free_ranges;
+    size_t lo = 0, hi = chunk->free_range_count, i;
+    bool merge_prev, merge_next;
+
+    while (lo < hi)
+    {
+        i = lo + (hi - lo) / 2;
+        if (ranges[i].offset < offset)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    i = lo;
+
+    merge_prev = i && ranges[i - 1].offset + ranges[i - 1].size == offset;
+    merge_next = i < chunk->free_range_count && offset + size == ranges[i].offset;
+
+    if (merge_prev && merge_next)
+    {
+        ranges[i - 1].size += size + ranges[i].size;
+        memmove(&ranges[i], &ranges[i + 1], (chunk->free_range_count - i - 1) * sizeof(*ranges));
+        --chunk->free_range_count;
+    }
+    else if (merge_prev)
+    {
+        ranges[i - 1].size += size;
+    }
+    else if (merge_next)
+    {
+        ranges[i].offset = offset;
+        ranges[i].size += size;
+    }
+    else
+    {
+        assert(chunk->free_range_count < chunk->free_ranges_size);
+        memmove(&ranges[i + 1], &ranges[i], (chunk->free_range_count - i) * sizeof(*ranges));
+        ranges[i].offset = offset;
+        ranges[i].size = size;
+        ++chunk->free_range_count;
+    }
+
+    chunk->free_size += size;
+    --chunk->allocation_count;
+}
+
+void vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
+{
+    const VkPhysicalDeviceMemoryProperties *memory_info = &device->memory_properties;
+    VkDeviceSize heap_size;
+    size_t i, j;
+
+    vkd3d_mutex_init(&allocator->mutex);
+
+    for (i = 0; i < ARRAY_SIZE(allocator->chunks); ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(allocator->chunks[i]); ++j)
+            list_init(&allocator->chunks[i][j]);
+    }
+
+    /* Keep chunks small relative to the heap they are allocated from, in
+     * order not to exhaust small heaps like the host visible VRAM window. */
+    for (i = 0; i < memory_info->memoryTypeCount; ++i)
+    {
+        heap_size = memory_info->memoryHeaps[memory_info->memoryTypes[i].heapIndex].size;
+        allocator->chunk_size[i] = min(VKD3D_MEMORY_CHUNK_SIZE, heap_size / 8);
+        if (allocator->chunk_size[i] < VKD3D_MEMORY_CHUNK_MIN_SIZE)
+            allocator->chunk_size[i] = 0;
+    }
+    for (; i < ARRAY_SIZE(allocator->chunk_size); ++i)
+        allocator->chunk_size[i] = 0;
+
+    allocator->device_memory_count = 0;
+    allocator->chunk_count = 0;
+    allocator->chunk_memory_size = 0;
+    allocator->allocated_size = 0;
+    allocator->allocation_count = 0;
+}
+
+void vkd3d_memory_allocator_cleanup(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device)
+{
+    struct vkd3d_memory_chunk *chunk, *next;
+    size_t i, j;
+
+    vkd3d_memory_allocator_trace_stats(allocator);
+
+    for (i = 0; i < ARRAY_SIZE(allocator->chunks); ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(allocator->chunks[i]); ++j)
+        {
+            LIST_FOR_EACH_ENTRY_SAFE(chunk, next, &allocator->chunks[i][j], struct vkd3d_memory_chunk, entry)
+            {
+                if (chunk->allocation_count)
+                    ERR("Memory chunk %p still has %u allocations.\n", chunk, chunk->allocation_count);
+                vkd3d_memory_chunk_destroy(chunk, allocator, device);
+            }
+        }
+    }
+
+    if (allocator->device_memory_count)
+        ERR("%d device memory objects leaked.\n", allocator->device_memory_count);
+
+    vkd3d_mutex_destroy(&allocator->mutex);
+}
+
+/* Returns S_FALSE if the allocation should use dedicated memory instead.
+ *
+ * D3D12 guarantees committed buffers read back as zero unless they are
+ * created with D3D12_HEAP_FLAG_CREATE_NOT_ZEROED. Fresh chunk memory is
+ * zeroed, but recycled ranges are not. Recycled ranges of mapped chunks are
+ * cleared on the CPU; other chunks only hand them out when no zeroing is
+ * needed. Images start in an undefined layout, so their contents are never
+ * preserved anyway. */
+static HRESULT vkd3d_memory_allocator_allocate(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, uint32_t memory_type, bool linear, D3D12_HEAP_FLAGS heap_flags,
+        const VkMemoryRequirements *memory_requirements, struct vkd3d_memory_allocation *allocation)
+{
+    VkDeviceSize size = memory_requirements->size, alignment = max(memory_requirements->alignment, 1);
+    bool zero_fill = linear && !(heap_flags & D3D12_HEAP_FLAG_CREATE_NOT_ZEROED);
+    struct vkd3d_memory_chunk *chunk;
+    VkDeviceSize offset;
+    bool is_dirty;
+    HRESULT hr;
+
+    if (size > allocator->chunk_size[memory_type] / 4 || alignment & (alignment - 1))
+        return S_FALSE;
+
+    vkd3d_mutex_lock(&allocator->mutex);
+
+    LIST_FOR_EACH_ENTRY(chunk, &allocator->chunks[memory_type][linear], struct vkd3d_memory_chunk, entry)
+    {
+        if (vkd3d_memory_chunk_allocate(chunk, size, alignment,
+                zero_fill && !chunk->map_ptr ? chunk->clean_offset : 0, &offset, &is_dirty))
+            goto done;
+    }
+
+    if (FAILED(hr = vkd3d_memory_chunk_create(allocator, device, memory_type, linear, &chunk)))
+    {
+        vkd3d_mutex_unlock(&allocator->mutex);
+        return hr;
+    }
+    if (!vkd3d_memory_chunk_allocate(chunk, size, alignment, 0, &offset, &is_dirty))
+    {
+        vkd3d_memory_chunk_destroy(chunk, allocator, device);
+        vkd3d_mutex_unlock(&allocator->mutex);
+        return E_OUTOFMEMORY;
+    }
+
+done:
+    allocator->allocated_size += size;
+    ++allocator->allocation_count;
+
+    vkd3d_mutex_unlock(&allocator->mutex);
+
+    if (zero_fill && is_dirty)
+        memset((uint8_t *)chunk->map_ptr + offset, 0, size);
+
+    allocation->chunk = chunk;
+    allocation->offset = offset;
+    allocation->size = size;
+
+    return S_OK;
+}
+
+static void vkd3d_memory_allocator_free(struct vkd3d_memory_allocator *allocator,
+        struct d3d12_device *device, struct vkd3d_memory_allocation *allocation)
+{
+    struct vkd3d_memory_chunk *chunk = allocation->chunk;
+    struct list *chunks;
+
+    vkd3d_mutex_lock(&allocator->mutex);
+
+    vkd3d_memory_chunk_free(chunk, allocation->offset, allocation->size);
+    allocator->allocated_size -= allocation->size;
+    --allocator->allocation_count;
+
+    /* Keep one chunk around per pool, to avoid thrashing when a single
+     * resource is repeatedly created and destroyed. */
+    chunks = &allocator->chunks[chunk->memory_type][chunk->linear];
+    if (!chunk->allocation_count && (list_prev(chunks, &chunk->entry) || list_next(chunks, &chunk->entry)))
+    {
+        vkd3d_memory_chunk_destroy(chunk, allocator, device);
+        vkd3d_memory_allocator_trace_stats(allocator);
+    }
+
+    vkd3d_mutex_unlock(&allocator->mutex);
+
+    allocation->chunk = NULL;
+}
+
+static HRESULT vkd3d_allocate_resource_device_memory(struct d3d12_device *device,
+        const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
+        const VkMemoryRequirements *memory_requirements,
+        const VkMemoryDedicatedAllocateInfo *dedicated_allocate_info, bool linear,
+        struct vkd3d_memory_allocation *allocation, VkDeviceMemory *vk_memory,
+        uint32_t *vk_memory_type, VkDeviceSize *offset)
+{
+    unsigned int memory_type;
+    HRESULT hr;
+
+    *offset = 0;
+
+    if (!allocation)
+        return vkd3d_allocate_device_memory(device, heap_properties, heap_flags,
+                memory_requirements, dedicated_allocate_info, vk_memory, vk_memory_type);
+
+    allocation->chunk = NULL;
+
+    if (dedicated_allocate_info || heap_flags & (D3D12_HEAP_FLAG_SHARED | D3D12_HEAP_FLAG_ALLOW_DISPLAY))
+        return vkd3d_allocate_device_memory(device, heap_properties, heap_flags,
+                memory_requirements, dedicated_allocate_info, vk_memory, vk_memory_type);
+
+    if (FAILED(hr = vkd3d_select_memory_type(device, memory_requirements->memoryTypeBits,
+            heap_properties, heap_flags, &memory_type)))
+    {
+        if (hr != E_INVALIDARG)
+            FIXME("Failed to find suitable memory type (allowed types %#x).\n", memory_requirements->memoryTypeBits);
         *vk_memory = VK_NULL_HANDLE;
-        return hresult_from_vk_result(vr);
+        return hr;
+    }
+
+    if ((hr = vkd3d_memory_allocator_allocate(&device->memory_allocator, device,
+            memory_type, linear, heap_flags, memory_requirements, allocation)) != S_OK)
+    {
+        if (FAILED(hr))
+            WARN("Failed to sub-allocate memory, hr %#x.\n", hr);
+        return vkd3d_allocate_device_memory(device, heap_properties, heap_flags,
+                memory_requirements, NULL, vk_memory, vk_memory_type);
     }
 
+    *vk_memory = allocation->chunk->vk_memory;
+    *offset = allocation->offset;
     if (vk_memory_type)
-        *vk_memory_type = allocate_info.memoryTypeIndex;
+        *vk_memory_type = memory_type;
 
     return S_OK;
 }
 
+static void vkd3d_free_resource_device_memory(struct d3d12_device *device,
+        struct vkd3d_memory_allocation *allocation, VkDeviceMemory vk_memory)
+{
+    if (allocation && allocation->chunk)
+        vkd3d_memory_allocator_free(&device->memory_allocator, device, allocation);
+    else
+        vkd3d_free_device_memory(device, vk_memory);
+}
+
 HRESULT vkd3d_allocate_buffer_memory(struct d3d12_device *device, VkBuffer vk_buffer,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
-        VkDeviceMemory *vk_memory, uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size)
+        struct vkd3d_memory_allocation *allocation, VkDeviceMemory *vk_memory,
+        uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkMemoryDedicatedAllocateInfo *dedicated_allocation = NULL;
@@ -163,6 +624,7 @@ HRESULT vkd3d_allocate_buffer_memory(struct d3d12_device *device, VkBuffer vk_bu
     VkMemoryRequirements2 memory_requirements2;
     VkMemoryRequirements *memory_requirements;
     VkBufferMemoryRequirementsInfo2 info;
+    VkDeviceSize offset;
     VkResult vr;
     HRESULT hr;
 
@@ -197,14 +659,14 @@ HRESULT vkd3d_allocate_buffer_memory(struct d3d12_device *device, VkBuffer vk_bu
         VK_CALL(vkGetBufferMemoryRequirements(device->vk_device, vk_buffer, memory_requirements));
     }
 
-    if (FAILED(hr = vkd3d_allocate_device_memory(device, heap_properties, heap_flags,
-            memory_requirements, dedicated_allocation, vk_memory, vk_memory_type)))
+    if (FAILED(hr = vkd3d_allocate_resource_device_memory(device, heap_properties, heap_flags,
+            memory_requirements, dedicated_allocation, true, allocation, vk_memory, vk_memory_type, &offset)))
         return hr;
 
-    if ((vr = VK_CALL(vkBindBufferMemory(device->vk_device, vk_buffer, *vk_memory, 0))) < 0)
+    if ((vr = VK_CALL(vkBindBufferMemory(device->vk_device, vk_buffer, *vk_memory, offset))) < 0)
     {
         WARN("Failed to bind memory, vr %d.\n", vr);
-        VK_CALL(vkFreeMemory(device->vk_device, *vk_memory, NULL));
+        vkd3d_free_resource_device_memory(device, allocation, *vk_memory);
         *vk_memory = VK_NULL_HANDLE;
     }
 
@@ -216,7 +678,8 @@ HRESULT vkd3d_allocate_buffer_memory(struct d3d12_device *device, VkBuffer vk_bu
 
 static HRESULT vkd3d_allocate_image_memory(struct d3d12_device *device, VkImage vk_image,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
-        VkDeviceMemory *vk_memory, uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size)
+        struct vkd3d_memory_allocation *allocation, VkDeviceMemory *vk_memory,
+        uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
     VkMemoryDedicatedAllocateInfo *dedicated_allocation = NULL;
@@ -225,6 +688,7 @@ static HRESULT vkd3d_allocate_image_memory(struct d3d12_device *device, VkImage
     VkMemoryRequirements2 memory_requirements2;
     VkMemoryRequirements *memory_requirements;
     VkImageMemoryRequirementsInfo2 info;
+    VkDeviceSize offset;
     VkResult vr;
     HRESULT hr;
 
@@ -259,14 +723,14 @@ static HRESULT vkd3d_allocate_image_memory(struct d3d12_device *device, VkImage
         VK_CALL(vkGetImageMemoryRequirements(device->vk_device, vk_image, memory_requirements));
     }
 
-    if (FAILED(hr = vkd3d_allocate_device_memory(device, heap_properties, heap_flags,
-            memory_requirements, dedicated_allocation, vk_memory, vk_memory_type)))
+    if (FAILED(hr = vkd3d_allocate_resource_device_memory(device, heap_properties, heap_flags,
+            memory_requirements, dedicated_allocation, false, allocation, vk_memory, vk_memory_type, &offset)))
         return hr;
 
-    if ((vr = VK_CALL(vkBindImageMemory(device->vk_device, vk_image, *vk_memory, 0))) < 0)
+    if ((vr = VK_CALL(vkBindImageMemory(device->vk_device, vk_image, *vk_memory, offset))) < 0)
     {
         WARN("Failed to bind memory, vr %d.\n", vr);
-        VK_CALL(vkFreeMemory(device->vk_device, *vk_memory, NULL));
+        vkd3d_free_resource_device_memory(device, allocation, *vk_memory);
         *vk_memory = VK_NULL_HANDLE;
         return hresult_from_vk_result(vr);
     }
@@ -320,13 +784,12 @@ static ULONG STDMETHODCALLTYPE d3d12_heap_AddRef(ID3D12Heap *iface)
 static void d3d12_heap_destroy(struct d3d12_heap *heap)
 {
     struct d3d12_device *device = heap->device;
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
     TRACE("Destroying heap %p.\n", heap);
 
     vkd3d_private_store_destroy(&heap->private_store);
 
-    VK_CALL(vkFreeMemory(device->vk_device, heap->vk_memory, NULL));
+    vkd3d_free_resource_device_memory(device, &heap->allocation, heap->vk_memory);
 
     vkd3d_mutex_destroy(&heap->mutex);
 
@@ -395,6 +858,10 @@ static HRESULT STDMETHODCALLTYPE d3d12_heap_SetName(ID3D12Heap *iface, const WCH
 
     TRACE("iface %p, name %s.\n", iface, debugstr_w(name, heap->device->wchar_size));
 
+    /* The memory object of a sub-allocated heap is shared with other heaps. */
+    if (heap->allocation.chunk)
+        return S_OK;
+
     return vkd3d_set_vk_object_name(heap->device, (uint64_t)heap->vk_memory,
             VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, name);
 }
@@ -465,7 +932,13 @@ static HRESULT d3d12_heap_map(struct d3d12_heap *heap, uint64_t offset,
 
             assert(!heap->map_count);
 
-            if ((vr = VK_CALL(vkMapMemory(device->vk_device, heap->vk_memory,
+            if (heap->allocation.chunk)
+            {
+                if ((heap->map_ptr = heap->allocation.chunk->map_ptr))
+                    heap->map_ptr = (BYTE *)heap->map_ptr + heap->allocation.offset;
+                vr = heap->map_ptr ? VK_SUCCESS : VK_ERROR_MEMORY_MAP_FAILED;
+            }
+            else if ((vr = VK_CALL(vkMapMemory(device->vk_device, heap->vk_memory,
                     0, VK_WHOLE_SIZE, 0, &heap->map_ptr))) < 0)
             {
                 WARN("Failed to map device memory, vr %d.\n", vr);
@@ -527,7 +1000,8 @@ static void d3d12_heap_unmap(struct d3d12_heap *heap, struct d3d12_resource *res
 
         TRACE("Unmapping heap %p, ptr %p.\n", heap, heap->map_ptr);
 
-        VK_CALL(vkUnmapMemory(device->vk_device, heap->vk_memory));
+        if (!heap->allocation.chunk)
+            VK_CALL(vkUnmapMemory(device->vk_device, heap->vk_memory));
         heap->map_ptr = NULL;
     }
 
@@ -576,6 +1050,7 @@ static HRESULT d3d12_heap_init(struct d3d12_heap *heap,
 
     heap->map_ptr = NULL;
     heap->map_count = 0;
+    heap->allocation.chunk = NULL;
 
     if (!heap->desc.Properties.CreationNodeMask)
         heap->desc.Properties.CreationNodeMask = 1;
@@ -604,13 +1079,16 @@ static HRESULT d3d12_heap_init(struct d3d12_heap *heap,
         if (d3d12_resource_is_buffer(resource))
         {
             hr = vkd3d_allocate_buffer_memory(device, resource->u.vk_buffer,
-                    &heap->desc.Properties, heap->desc.Flags,
+                    &heap->desc.Properties, heap->desc.Flags, &heap->allocation,
                     &heap->vk_memory, &heap->vk_memory_type, &vk_memory_size);
         }
         else
         {
+            /* Linear images would need bufferImageGranularity padding
+             * against optimally tiled neighbours; give them their own memory. */
             hr = vkd3d_allocate_image_memory(device, resource->u.vk_image,
                     &heap->desc.Properties, heap->desc.Flags,
+                    resource->flags & VKD3D_RESOURCE_LINEAR_TILING ? NULL : &heap->allocation,
                     &heap->vk_memory, &heap->vk_memory_type, &vk_memory_size);
         }
 
@@ -763,6 +1241,8 @@ HRESULT vkd3d_create_buffer(struct d3d12_device *device,
         buffer_info.usage |= VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
     if (!(desc->Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE))
         buffer_info.usage |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+    if (device->use_descriptor_buffers)
+        buffer_info.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
 
     /* Buffers always have properties of D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS. */
     if (desc->Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS)
@@ -2010,7 +2490,7 @@ HRESULT d3d12_reserved_resource_create(struct d3d12_device *device,
 HRESULT vkd3d_create_image_resource(ID3D12Device *device,
         const struct vkd3d_image_resource_create_info *create_info, ID3D12Resource **resource)
 {
-    struct d3d12_device *d3d12_device = unsafe_impl_from_ID3D12Device(device);
+    struct d3d12_device *d3d12_device = unsafe_impl_from_ID3D12Device1((ID3D12Device1 *)device);
     struct d3d12_resource *object;
     HRESULT hr;
 
@@ -2072,6 +2552,20 @@ ULONG vkd3d_resource_decref(ID3D12Resource *resource)
     return d3d12_resource_decref(impl_from_ID3D12Resource(resource));
 }
 
+static VkDeviceAddress vkd3d_get_buffer_device_address(struct d3d12_device *device, VkBuffer vk_buffer)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkBufferDeviceAddressInfoKHR address_info;
+
+    if (!device->use_descriptor_buffers || !vk_buffer)
+        return 0;
+
+    address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR;
+    address_info.pNext = NULL;
+    address_info.buffer = vk_buffer;
+    return VK_CALL(vkGetBufferDeviceAddressKHR(device->vk_device, &address_info));
+}
+
 /* CBVs, SRVs, UAVs */
 static struct vkd3d_view *vkd3d_view_create(enum vkd3d_view_type type)
 {
@@ -2083,6 +2577,8 @@ static struct vkd3d_view *vkd3d_view_create(enum vkd3d_view_type type)
         view->type = type;
         view->serial_id = InterlockedIncrement64(&object_global_serial_id);
         view->vk_counter_view = VK_NULL_HANDLE;
+        view->vk_counter_address = 0;
+        view->is_attachment = false;
     }
     return view;
 }
@@ -2104,6 +2600,8 @@ static void vkd3d_view_destroy(struct vkd3d_view *view, struct d3d12_device *dev
             VK_CALL(vkDestroyBufferView(device->vk_device, view->u.vk_buffer_view, NULL));
             break;
         case VKD3D_VIEW_TYPE_IMAGE:
+            if (view->is_attachment)
+                vkd3d_framebuffer_cache_remove_view(&device->framebuffer_cache, device, view->u.vk_image_view);
             VK_CALL(vkDestroyImageView(device->vk_device, view->u.vk_image_view, NULL));
             break;
         case VKD3D_VIEW_TYPE_SAMPLER:
@@ -2119,36 +2617,133 @@ static void vkd3d_view_destroy(struct vkd3d_view *view, struct d3d12_device *dev
     vkd3d_free(view);
 }
 
-void vkd3d_view_decref(struct vkd3d_view *view, struct d3d12_device *device)
+/* Returns false if the view is already retired. */
+static bool vkd3d_view_incref_if_live(struct vkd3d_view *view)
 {
-    if (!InterlockedDecrement(&view->refcount))
-        vkd3d_view_destroy(view, device);
+    LONG refcount;
+
+    do
+    {
+        if (!(refcount = view->refcount))
+            return false;
+    } while (InterlockedCompareExchange(&view->refcount, refcount + 1, refcount) != refcount);
+
+    return true;
 }
 
-/* TODO: write null descriptors to all applicable sets (invalid behaviour workaround). */
-static void d3d12_descriptor_heap_write_vk_descriptor_range(struct d3d12_descriptor_heap_vk_set *descriptor_set,
-        struct d3d12_desc_copy_location *locations, unsigned int write_count)
+void vkd3d_view_reclaimer_init(struct vkd3d_view_reclaimer *reclaimer)
 {
-    unsigned int i, info_index = 0, write_index = 0;
+    memset(reclaimer, 0, sizeof(*reclaimer));
+    vkd3d_mutex_init(&reclaimer->mutex);
+}
 
-    switch (locations[0].src.s.vk_descriptor_type)
+void vkd3d_view_reclaimer_cleanup(struct vkd3d_view_reclaimer *reclaimer, struct d3d12_device *device)
+{
+    unsigned int i;
+    size_t j;
+
+    for (i = 0; i < ARRAY_SIZE(reclaimer->retired_views); ++i)
     {
-        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            for (; write_index < write_count; ++write_index)
-            {
-                descriptor_set->vk_descriptor_writes[write_index].pBufferInfo = &descriptor_set->vk_buffer_infos[info_index];
-                for (i = 0; i < descriptor_set->vk_descriptor_writes[write_index].descriptorCount; ++i, ++info_index)
-                    descriptor_set->vk_buffer_infos[info_index] = locations[info_index].src.s.u.vk_cbv_info;
-            }
-            break;
-        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-            for (; write_index < write_count; ++write_index)
-            {
-                descriptor_set->vk_descriptor_writes[write_index].pImageInfo = &descriptor_set->vk_image_infos[info_index];
-                for (i = 0; i < descriptor_set->vk_descriptor_writes[write_index].descriptorCount; ++i, ++info_index)
-                    descriptor_set->vk_image_infos[info_index].imageView = locations[info_index].src.s.u.view_info.view->u.vk_image_view;
-            }
+        for (j = 0; j < reclaimer->retired_view_count[i]; ++j)
+            vkd3d_view_destroy(reclaimer->retired_views[i][j], device);
+        vkd3d_free(reclaimer->retired_views[i]);
+    }
+
+    vkd3d_mutex_destroy(&reclaimer->mutex);
+}
+
+static unsigned int vkd3d_view_reclaimer_enter(struct vkd3d_view_reclaimer *reclaimer)
+{
+    unsigned int slot;
+
+    for (;;)
+    {
+        slot = reclaimer->epoch & 1;
+        InterlockedIncrement(&reclaimer->reader_counts[slot]);
+        /* If the epoch advanced before the increment became visible, the
+         * reclaimer may already have checked this slot. */
+        if ((reclaimer->epoch & 1) == slot)
+            return slot;
+        InterlockedDecrement(&reclaimer->reader_counts[slot]);
+    }
+}
+
+static void vkd3d_view_reclaimer_leave(struct vkd3d_view_reclaimer *reclaimer, unsigned int slot)
+{
+    InterlockedDecrement(&reclaimer->reader_counts[slot]);
+}
+
+static void vkd3d_view_reclaimer_retire(struct vkd3d_view_reclaimer *reclaimer,
+        struct vkd3d_view *view, struct d3d12_device *device)
+{
+    struct vkd3d_view **defunct_views = NULL;
+    unsigned int slot, prev_slot;
+    size_t i, defunct_count = 0;
+
+    vkd3d_mutex_lock(&reclaimer->mutex);
+
+    slot = reclaimer->epoch & 1;
+    prev_slot = slot ^ 1;
+
+    if (!vkd3d_array_reserve((void **)&reclaimer->retired_views[slot], &reclaimer->retired_views_size[slot],
+            reclaimer->retired_view_count[slot] + 1, sizeof(*reclaimer->retired_views[slot])))
+    {
+        ERR("Failed to retire view %p.\n", view);
+        vkd3d_mutex_unlock(&reclaimer->mutex);
+        return;
+    }
+    reclaimer->retired_views[slot][reclaimer->retired_view_count[slot]++] = view;
+
+    /* Views retired in the previous epoch are unreachable once all readers
+     * which entered in that epoch have left. New readers then take its slot. */
+    if (!reclaimer->reader_counts[prev_slot])
+    {
+        defunct_views = reclaimer->retired_views[prev_slot];
+        defunct_count = reclaimer->retired_view_count[prev_slot];
+        reclaimer->retired_views[prev_slot] = NULL;
+        reclaimer->retired_views_size[prev_slot] = 0;
+        reclaimer->retired_view_count[prev_slot] = 0;
+        InterlockedIncrement(&reclaimer->epoch);
+    }
+
+    vkd3d_mutex_unlock(&reclaimer->mutex);
+
+    /* Destroy the views after unlocking to reduce wait time. */
+    for (i = 0; i < defunct_count; ++i)
+        vkd3d_view_destroy(defunct_views[i], device);
+    vkd3d_free(defunct_views);
+}
+
+void vkd3d_view_decref(struct vkd3d_view *view, struct d3d12_device *device)
+{
+    if (!InterlockedDecrement(&view->refcount))
+        vkd3d_view_reclaimer_retire(&device->view_reclaimer, view, device);
+}
+
+/* TODO: write null descriptors to all applicable sets (invalid behaviour workaround). */
+static void d3d12_descriptor_heap_write_vk_descriptor_range(struct d3d12_descriptor_heap_vk_set *descriptor_set,
+        struct d3d12_desc_copy_location *locations, unsigned int write_count)
+{
+    unsigned int i, info_index = 0, write_index = 0;
+
+    switch (locations[0].src.s.vk_descriptor_type)
+    {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            for (; write_index < write_count; ++write_index)
+            {
+                descriptor_set->vk_descriptor_writes[write_index].pBufferInfo = &descriptor_set->vk_buffer_infos[info_index];
+                for (i = 0; i < descriptor_set->vk_descriptor_writes[write_index].descriptorCount; ++i, ++info_index)
+                    descriptor_set->vk_buffer_infos[info_index] = locations[info_index].src.s.u.vk_cbv_info;
+            }
+            break;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            for (; write_index < write_count; ++write_index)
+            {
+                descriptor_set->vk_descriptor_writes[write_index].pImageInfo = &descriptor_set->vk_image_infos[info_index];
+                for (i = 0; i < descriptor_set->vk_descriptor_writes[write_index].descriptorCount; ++i, ++info_index)
+                    descriptor_set->vk_image_infos[info_index].imageView = locations[info_index].src.s.u.view_info.view->u.vk_image_view;
+            }
             break;
         case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
         case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
@@ -2277,37 +2872,204 @@ static void d3d12_desc_write_vk_heap(const struct d3d12_desc *dst, const struct
     vkd3d_mutex_unlock(&descriptor_heap->vk_sets_mutex);
 }
 
-static void d3d12_desc_write_atomic_d3d12_only(struct d3d12_desc *dst, const struct d3d12_desc *src, struct d3d12_device *device)
+static void *d3d12_descriptor_heap_get_descriptor_buffer_data(const struct d3d12_descriptor_heap *descriptor_heap,
+        enum vkd3d_vk_descriptor_set_index set, unsigned int index)
 {
-    struct vkd3d_view *defunct_view;
-    struct vkd3d_mutex *mutex;
+    const struct vkd3d_vk_descriptor_heap_layout *layout = &descriptor_heap->device->vk_descriptor_heap_layouts[set];
+
+    return descriptor_heap->descriptor_buffer.data + descriptor_heap->descriptor_buffer.set_offsets[set]
+            + layout->binding_offset + (size_t)index * layout->descriptor_size;
+}
 
-    mutex = d3d12_device_get_descriptor_mutex(device, dst);
-    vkd3d_mutex_lock(mutex);
+#ifdef VK_EXT_descriptor_buffer
+static void d3d12_descriptor_heap_get_vk_descriptor(struct d3d12_descriptor_heap *descriptor_heap,
+        enum vkd3d_vk_descriptor_set_index set, unsigned int index, const VkDescriptorGetInfoEXT *get_info,
+        const struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    VK_CALL(vkGetDescriptorEXT(device->vk_device, get_info, device->vk_descriptor_heap_layouts[set].descriptor_size,
+            d3d12_descriptor_heap_get_descriptor_buffer_data(descriptor_heap, set, index)));
+}
+
+static void d3d12_desc_write_descriptor_buffer_null_descriptor(struct d3d12_descriptor_heap *descriptor_heap,
+        unsigned int index, const struct d3d12_device *device)
+{
+    enum vkd3d_vk_descriptor_set_index i;
+    VkDescriptorImageInfo image_info;
+    VkDescriptorGetInfoEXT get_info;
+
+    image_info.sampler = VK_NULL_HANDLE;
+    image_info.imageView = VK_NULL_HANDLE;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-    if (!(dst->s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW) || InterlockedDecrement(&dst->s.u.view_info.view->refcount))
+    get_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+    get_info.pNext = NULL;
+
+    /* As for Vulkan heap sets, write a null descriptor to all applicable sets. */
+    for (i = VKD3D_SET_INDEX_UNIFORM_BUFFER; i <= VKD3D_SET_INDEX_STORAGE_IMAGE; ++i)
     {
-        d3d12_desc_copy_raw(dst, src);
-        vkd3d_mutex_unlock(mutex);
+        get_info.type = device->vk_descriptor_heap_layouts[i].type;
+        switch (i)
+        {
+            case VKD3D_SET_INDEX_UNIFORM_BUFFER:
+                get_info.data.pUniformBuffer = NULL;
+                break;
+            case VKD3D_SET_INDEX_SAMPLED_IMAGE:
+                get_info.data.pSampledImage = &image_info;
+                break;
+            case VKD3D_SET_INDEX_STORAGE_IMAGE:
+                get_info.data.pStorageImage = &image_info;
+                break;
+            case VKD3D_SET_INDEX_UNIFORM_TEXEL_BUFFER:
+                get_info.data.pUniformTexelBuffer = NULL;
+                break;
+            case VKD3D_SET_INDEX_STORAGE_TEXEL_BUFFER:
+                get_info.data.pStorageTexelBuffer = NULL;
+                break;
+            default:
+                assert(false);
+                break;
+        }
+        d3d12_descriptor_heap_get_vk_descriptor(descriptor_heap, i, index, &get_info, device);
+    }
+}
+
+/* Descriptor buffer equivalent of d3d12_desc_write_vk_heap(). The descriptor
+ * data is written directly into the heap memory, so no lock is needed. */
+static void d3d12_desc_write_descriptor_buffer(const struct d3d12_desc *dst, const struct d3d12_desc *src,
+        struct d3d12_device *device)
+{
+    struct d3d12_descriptor_heap *descriptor_heap = d3d12_desc_get_descriptor_heap(dst);
+    VkDescriptorAddressInfoEXT address_info;
+    VkDescriptorGetInfoEXT get_info;
+    const struct vkd3d_view *view;
+    bool is_null = false;
+
+    get_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+    get_info.pNext = NULL;
+    get_info.type = src->s.vk_descriptor_type;
+
+    address_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT;
+    address_info.pNext = NULL;
+
+    switch (src->s.vk_descriptor_type)
+    {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            is_null = !src->s.u.vk_cbv_info.buffer;
+            address_info.address = vkd3d_get_buffer_device_address(device, src->s.u.vk_cbv_info.buffer)
+                    + src->s.u.vk_cbv_info.offset;
+            /* Only null descriptors use VK_WHOLE_SIZE. */
+            address_info.range = src->s.u.vk_cbv_info.range == VK_WHOLE_SIZE
+                    ? VKD3D_NULL_BUFFER_SIZE : src->s.u.vk_cbv_info.range;
+            address_info.format = VK_FORMAT_UNDEFINED;
+            get_info.data.pUniformBuffer = &address_info;
+            break;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            is_null = !src->s.u.view_info.vk_image_info.imageView;
+            get_info.data.pSampledImage = &src->s.u.view_info.vk_image_info;
+            break;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            is_null = !src->s.u.view_info.vk_image_info.imageView;
+            get_info.data.pStorageImage = &src->s.u.view_info.vk_image_info;
+            break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            view = src->s.u.view_info.view;
+            is_null = !view->u.vk_buffer_view;
+            address_info.address = view->info.buffer.address + view->info.buffer.offset;
+            address_info.range = view->info.buffer.size;
+            address_info.format = view->format->vk_format;
+            if (src->s.vk_descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER)
+                get_info.data.pUniformTexelBuffer = &address_info;
+            else
+                get_info.data.pStorageTexelBuffer = &address_info;
+            break;
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+            get_info.data.pSampler = &src->s.u.view_info.view->u.vk_sampler;
+            break;
+        default:
+            ERR("Unhandled descriptor type %#x.\n", src->s.vk_descriptor_type);
+            return;
+    }
+    if (is_null && device->vk_info.EXT_robustness2)
+    {
+        d3d12_desc_write_descriptor_buffer_null_descriptor(descriptor_heap, dst->index, device);
         return;
     }
 
-    defunct_view = dst->s.u.view_info.view;
-    d3d12_desc_copy_raw(dst, src);
-    vkd3d_mutex_unlock(mutex);
+    d3d12_descriptor_heap_get_vk_descriptor(descriptor_heap,
+            vkd3d_vk_descriptor_set_index_from_vk_descriptor_type(src->s.vk_descriptor_type),
+            dst->index, &get_info, device);
 
-    /* Destroy the view after unlocking to reduce wait time. */
-    vkd3d_view_destroy(defunct_view, device);
+    if (src->s.magic == VKD3D_DESCRIPTOR_MAGIC_UAV && src->s.u.view_info.view->vk_counter_address)
+    {
+        address_info.address = src->s.u.view_info.view->vk_counter_address;
+        address_info.range = sizeof(uint32_t);
+        address_info.format = VK_FORMAT_R32_UINT;
+        get_info.type = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+        get_info.data.pStorageTexelBuffer = &address_info;
+        d3d12_descriptor_heap_get_vk_descriptor(descriptor_heap, VKD3D_SET_INDEX_UAV_COUNTER,
+                dst->index, &get_info, device);
+    }
 }
+#endif
 
-void d3d12_desc_write_atomic(struct d3d12_desc *dst, const struct d3d12_desc *src,
-        struct d3d12_device *device)
+/* Descriptor data is position independent, so copies between heaps are plain
+ * memory copies of each run of descriptors which share a Vulkan set. */
+static void d3d12_descriptor_heap_copy_descriptor_buffer_data(struct d3d12_descriptor_heap *dst_heap,
+        uint32_t dst_base, const struct d3d12_descriptor_heap *src_heap, uint32_t src_base,
+        const enum vkd3d_vk_descriptor_set_index *sets, const bool *uav_counters, unsigned int count)
+{
+    const struct vkd3d_vk_descriptor_heap_layout *layouts = dst_heap->device->vk_descriptor_heap_layouts;
+    unsigned int i, j;
+
+    for (i = 0; i < count; i = j)
+    {
+        for (j = i + 1; j < count && sets[j] == sets[i]; ++j)
+            ;
+        if (sets[i] == VKD3D_SET_INDEX_COUNT)
+            continue;
+        memcpy(d3d12_descriptor_heap_get_descriptor_buffer_data(dst_heap, sets[i], dst_base + i),
+                d3d12_descriptor_heap_get_descriptor_buffer_data(src_heap, sets[i], src_base + i),
+                (j - i) * layouts[sets[i]].descriptor_size);
+    }
+    for (i = 0; i < count; ++i)
+    {
+        if (!uav_counters[i])
+            continue;
+        memcpy(d3d12_descriptor_heap_get_descriptor_buffer_data(dst_heap, VKD3D_SET_INDEX_UAV_COUNTER, dst_base + i),
+                d3d12_descriptor_heap_get_descriptor_buffer_data(src_heap, VKD3D_SET_INDEX_UAV_COUNTER, src_base + i),
+                layouts[VKD3D_SET_INDEX_UAV_COUNTER].descriptor_size);
+    }
+}
+
+/* Writers to the same descriptor only contend if the application races
+ * with itself, so spinning is sufficient. */
+static void d3d12_desc_begin_write(struct d3d12_desc *descriptor)
+{
+    LONG seq;
+
+    for (;;)
+    {
+        seq = descriptor->seq;
+        if (!(seq & 1) && InterlockedCompareExchange(&descriptor->seq, seq + 1, seq) == seq)
+            return;
+    }
+}
+
+static void d3d12_desc_end_write(struct d3d12_desc *descriptor)
+{
+    InterlockedIncrement(&descriptor->seq);
+}
+
+/* Replace the contents of 'dst' with 'src', which owns a reference to its
+ * view. Returns the old view of 'dst' if its last reference was dropped. */
+static struct vkd3d_view *d3d12_desc_replace(struct d3d12_desc *dst, const struct d3d12_desc *src)
 {
     struct vkd3d_view *defunct_view = NULL;
-    struct vkd3d_mutex *mutex;
 
-    mutex = d3d12_device_get_descriptor_mutex(device, dst);
-    vkd3d_mutex_lock(mutex);
+    d3d12_desc_begin_write(dst);
 
     /* Nothing to do for VKD3D_DESCRIPTOR_MAGIC_CBV. */
     if ((dst->s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW)
@@ -2316,13 +3078,37 @@ void d3d12_desc_write_atomic(struct d3d12_desc *dst, const struct d3d12_desc *sr
 
     d3d12_desc_copy_raw(dst, src);
 
-    vkd3d_mutex_unlock(mutex);
+    d3d12_desc_end_write(dst);
+
+    return defunct_view;
+}
+
+static void d3d12_desc_write_atomic_d3d12_only(struct d3d12_desc *dst, const struct d3d12_desc *src, struct d3d12_device *device)
+{
+    struct vkd3d_view *defunct_view;
+
+    if ((defunct_view = d3d12_desc_replace(dst, src)))
+        vkd3d_view_reclaimer_retire(&device->view_reclaimer, defunct_view, device);
+}
+
+void d3d12_desc_write_atomic(struct d3d12_desc *dst, const struct d3d12_desc *src,
+        struct d3d12_device *device)
+{
+    struct vkd3d_view *defunct_view;
 
-    /* Destroy the view after unlocking to reduce wait time. */
-    if (defunct_view)
-        vkd3d_view_destroy(defunct_view, device);
+    if ((defunct_view = d3d12_desc_replace(dst, src)))
+        vkd3d_view_reclaimer_retire(&device->view_reclaimer, defunct_view, device);
 
-    if (device->use_vk_heaps && dst->s.magic)
+    if (!dst->s.magic)
+        return;
+#ifdef VK_EXT_descriptor_buffer
+    if (device->use_descriptor_buffers)
+    {
+        d3d12_desc_write_descriptor_buffer(dst, src, device);
+        return;
+    }
+#endif
+    if (device->use_vk_heaps)
         d3d12_desc_write_vk_heap(dst, src, device);
 }
 
@@ -2385,25 +3171,215 @@ done:
     vkd3d_mutex_unlock(&descriptor_heap->vk_sets_mutex);
 }
 
+/* Snapshot 'src' and take a reference to its view without blocking writers.
+ * The caller must be inside a reclaimer epoch. */
+static void d3d12_desc_read_in_epoch(struct d3d12_desc *dst, const struct d3d12_desc *src)
+{
+    LONG volatile *seq_ptr = (LONG volatile *)&src->seq;
+    LONG seq;
+
+    for (;;)
+    {
+        if ((seq = *seq_ptr) & 1)
+            continue;
+
+        d3d12_desc_copy_raw(dst, src);
+
+        /* The interlocked compare acts as a full barrier, so the copy above
+         * cannot be observed after the sequence is validated. */
+        if (InterlockedCompareExchange(seq_ptr, seq, seq) != seq)
+            continue;
+
+        /* The view may have been released after validation, in which case
+         * the descriptor has been rewritten. */
+        if (!(dst->s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW) || vkd3d_view_incref_if_live(dst->s.u.view_info.view))
+            return;
+    }
+}
+
+void d3d12_desc_read_atomic(struct d3d12_desc *dst, const struct d3d12_desc *src,
+        struct d3d12_device *device)
+{
+    struct vkd3d_view_reclaimer *reclaimer = &device->view_reclaimer;
+    unsigned int slot;
+
+    slot = vkd3d_view_reclaimer_enter(reclaimer);
+    d3d12_desc_read_in_epoch(dst, src);
+    vkd3d_view_reclaimer_leave(reclaimer, slot);
+}
+
+static void vk_copy_descriptor_set_append(VkCopyDescriptorSet *copies, unsigned int *count,
+        VkDescriptorSet src_set, uint32_t src_index, VkDescriptorSet dst_set, uint32_t dst_index)
+{
+    VkCopyDescriptorSet *copy;
+
+    if (*count)
+    {
+        copy = &copies[*count - 1];
+        if (copy->srcSet == src_set && copy->dstSet == dst_set
+                && copy->srcArrayElement + copy->descriptorCount == src_index
+                && copy->dstArrayElement + copy->descriptorCount == dst_index)
+        {
+            ++copy->descriptorCount;
+            return;
+        }
+    }
+
+    copy = &copies[(*count)++];
+    copy->sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
+    copy->pNext = NULL;
+    copy->srcSet = src_set;
+    copy->srcBinding = 0;
+    copy->srcArrayElement = src_index;
+    copy->dstSet = dst_set;
+    copy->dstBinding = 0;
+    copy->dstArrayElement = dst_index;
+    copy->descriptorCount = 1;
+}
+
+/* The source sets are up to date for every populated descriptor, because all
+ * writes to a heap are mirrored into its sets. */
+static void d3d12_descriptor_heap_copy_vk_descriptors(struct d3d12_descriptor_heap *dst_heap, uint32_t dst_base,
+        const struct d3d12_descriptor_heap *src_heap, uint32_t src_base,
+        const enum vkd3d_vk_descriptor_set_index *sets, const bool *uav_counters, unsigned int count,
+        struct d3d12_device *device)
+{
+    VkCopyDescriptorSet vk_copies[2 * VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    unsigned int i, copy_count = 0;
+
+    assert(count <= VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE);
+
+    for (i = 0; i < count; ++i)
+    {
+        if (sets[i] == VKD3D_SET_INDEX_COUNT)
+            continue;
+        vk_copy_descriptor_set_append(vk_copies, &copy_count, src_heap->vk_descriptor_sets[sets[i]].vk_set,
+                src_base + i, dst_heap->vk_descriptor_sets[sets[i]].vk_set, dst_base + i);
+    }
+    for (i = 0; i < count; ++i)
+    {
+        if (!uav_counters[i])
+            continue;
+        vk_copy_descriptor_set_append(vk_copies, &copy_count,
+                src_heap->vk_descriptor_sets[VKD3D_SET_INDEX_UAV_COUNTER].vk_set, src_base + i,
+                dst_heap->vk_descriptor_sets[VKD3D_SET_INDEX_UAV_COUNTER].vk_set, dst_base + i);
+    }
+
+    if (copy_count)
+        VK_CALL(vkUpdateDescriptorSets(device->vk_device, 0, NULL, copy_count, vk_copies));
+}
+
+static bool d3d12_desc_is_same_copy(const struct d3d12_desc *dst, const struct d3d12_desc *src)
+{
+    if (src->s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE)
+        return dst->s.magic == VKD3D_DESCRIPTOR_MAGIC_FREE;
+
+    return dst->s.magic == src->s.magic && (src->s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW)
+            && dst->s.u.view_info.written_serial_id == src->s.u.view_info.view->serial_id;
+}
+
+/* Copy a range of descriptors which is contiguous in both the source and the
+ * destination heap. Source descriptors are read once per chunk inside a single
+ * reclaimer epoch, and Vulkan heap sets, if used, are updated with one
+ * VkCopyDescriptorSet per run of descriptors of the same type. */
+void d3d12_desc_copy_contiguous(struct d3d12_desc *dst, const struct d3d12_desc *src,
+        unsigned int count, struct d3d12_device *device)
+{
+    struct vkd3d_view_reclaimer *reclaimer = &device->view_reclaimer;
+    enum vkd3d_vk_descriptor_set_index sets[VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
+    struct vkd3d_view *defunct_views[VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
+    struct d3d12_desc tmp[VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
+    bool uav_counters[VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
+    unsigned int i, chunk, defunct_count, slot;
+    struct d3d12_descriptor_heap *dst_heap, *src_heap;
+    uint32_t dst_base, src_base;
+    struct vkd3d_view *view;
+
+    dst_heap = d3d12_desc_get_descriptor_heap(dst);
+    src_heap = d3d12_desc_get_descriptor_heap(src);
+    dst_base = dst - (const struct d3d12_desc *)dst_heap->descriptors;
+    src_base = src - (const struct d3d12_desc *)src_heap->descriptors;
+
+    for (; count; dst += chunk, src += chunk, dst_base += chunk, src_base += chunk, count -= chunk)
+    {
+        chunk = min(count, ARRAY_SIZE(sets));
+
+        slot = vkd3d_view_reclaimer_enter(reclaimer);
+        for (i = 0; i < chunk; ++i)
+            d3d12_desc_read_in_epoch(&tmp[i], &src[i]);
+        vkd3d_view_reclaimer_leave(reclaimer, slot);
+
+        /* Same lock order as d3d12_desc_copy_vk_heap_range(). Holding the set
+         * mutex across both updates keeps the sets consistent with the heap. */
+        if (device->use_vk_heaps && !device->use_descriptor_buffers)
+            vkd3d_mutex_lock(&dst_heap->vk_sets_mutex);
+
+        for (i = 0, defunct_count = 0; i < chunk; ++i)
+        {
+            sets[i] = VKD3D_SET_INDEX_COUNT;
+            uav_counters[i] = false;
+            view = (tmp[i].s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW) ? tmp[i].s.u.view_info.view : NULL;
+
+            d3d12_desc_begin_write(&dst[i]);
+
+            if (d3d12_desc_is_same_copy(&dst[i], &tmp[i]))
+            {
+                d3d12_desc_end_write(&dst[i]);
+                if (view)
+                    vkd3d_view_decref(view, device);
+                continue;
+            }
+
+            if (tmp[i].s.magic != VKD3D_DESCRIPTOR_MAGIC_FREE)
+            {
+                sets[i] = vkd3d_vk_descriptor_set_index_from_vk_descriptor_type(tmp[i].s.vk_descriptor_type);
+                uav_counters[i] = tmp[i].s.magic == VKD3D_DESCRIPTOR_MAGIC_UAV && view->vk_counter_view;
+            }
+
+            if ((dst[i].s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW)
+                    && !InterlockedDecrement(&dst[i].s.u.view_info.view->refcount))
+                defunct_views[defunct_count++] = dst[i].s.u.view_info.view;
+
+            d3d12_desc_copy_raw(&dst[i], &tmp[i]);
+
+            d3d12_desc_end_write(&dst[i]);
+        }
+
+        if (device->use_descriptor_buffers)
+        {
+            d3d12_descriptor_heap_copy_descriptor_buffer_data(dst_heap, dst_base, src_heap, src_base,
+                    sets, uav_counters, chunk);
+        }
+        else if (device->use_vk_heaps)
+        {
+            d3d12_descriptor_heap_copy_vk_descriptors(dst_heap, dst_base, src_heap, src_base,
+                    sets, uav_counters, chunk, device);
+            vkd3d_mutex_unlock(&dst_heap->vk_sets_mutex);
+        }
+
+        for (i = 0; i < defunct_count; ++i)
+            vkd3d_view_reclaimer_retire(reclaimer, defunct_views[i], device);
+    }
+}
+
 void d3d12_desc_copy(struct d3d12_desc *dst, const struct d3d12_desc *src,
         struct d3d12_device *device)
 {
     struct d3d12_desc tmp;
-    struct vkd3d_mutex *mutex;
 
     assert(dst != src);
 
+    /* Copy the descriptor data instead of recreating it. */
+    if (device->use_descriptor_buffers)
+    {
+        d3d12_desc_copy_contiguous(dst, src, 1, device);
+        return;
+    }
+
     /* Shadow of the Tomb Raider and possibly other titles sometimes destroy
      * and rewrite a descriptor in another thread while it is being copied. */
-    mutex = d3d12_device_get_descriptor_mutex(device, src);
-    vkd3d_mutex_lock(mutex);
-
-    if (src->s.magic & VKD3D_DESCRIPTOR_MAGIC_HAS_VIEW)
-        vkd3d_view_incref(src->s.u.view_info.view);
-
-    d3d12_desc_copy_raw(&tmp, src);
-
-    vkd3d_mutex_unlock(mutex);
+    d3d12_desc_read_atomic(&tmp, src, device);
 
     d3d12_desc_write_atomic(dst, &tmp, device);
 }
@@ -2484,6 +3460,7 @@ bool vkd3d_create_buffer_view(struct d3d12_device *device, VkBuffer vk_buffer, c
 
     object->u.vk_buffer_view = vk_view;
     object->format = format;
+    object->info.buffer.address = vkd3d_get_buffer_device_address(device, vk_buffer);
     object->info.buffer.offset = offset;
     object->info.buffer.size = size;
     *view = object;
@@ -2801,6 +3778,24 @@ bool vkd3d_create_texture_view(struct d3d12_device *device, VkImage vk_image,
     return true;
 }
 
+static void d3d12_desc_init_vk_image_info(struct d3d12_desc *descriptor, VkImageLayout vk_layout)
+{
+    VkDescriptorImageInfo *image_info = &descriptor->s.u.view_info.vk_image_info;
+    const struct vkd3d_view *view = descriptor->s.u.view_info.view;
+
+    if (descriptor->s.magic == VKD3D_DESCRIPTOR_MAGIC_SAMPLER)
+    {
+        image_info->sampler = view->u.vk_sampler;
+        image_info->imageView = VK_NULL_HANDLE;
+    }
+    else
+    {
+        image_info->sampler = VK_NULL_HANDLE;
+        image_info->imageView = view->u.vk_image_view;
+    }
+    image_info->imageLayout = vk_layout;
+}
+
 void d3d12_desc_create_cbv(struct d3d12_desc *descriptor,
         struct d3d12_device *device, const D3D12_CONSTANT_BUFFER_VIEW_DESC *desc)
 {
@@ -2922,6 +3917,7 @@ static void vkd3d_create_null_srv(struct d3d12_desc *descriptor,
     descriptor->s.vk_descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
     descriptor->s.u.view_info.view = view;
     descriptor->s.u.view_info.written_serial_id = view->serial_id;
+    d3d12_desc_init_vk_image_info(descriptor, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
 static void vkd3d_create_buffer_srv(struct d3d12_desc *descriptor,
@@ -3084,6 +4080,7 @@ void d3d12_desc_create_srv(struct d3d12_desc *descriptor,
     descriptor->s.vk_descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
     descriptor->s.u.view_info.view = view;
     descriptor->s.u.view_info.written_serial_id = view->serial_id;
+    d3d12_desc_init_vk_image_info(descriptor, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
 static unsigned int vkd3d_view_flags_from_d3d12_buffer_uav_flags(D3D12_BUFFER_UAV_FLAGS flags)
@@ -3168,6 +4165,7 @@ static void vkd3d_create_null_uav(struct d3d12_desc *descriptor,
     descriptor->s.vk_descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
     descriptor->s.u.view_info.view = view;
     descriptor->s.u.view_info.written_serial_id = view->serial_id;
+    d3d12_desc_init_vk_image_info(descriptor, VK_IMAGE_LAYOUT_GENERAL);
 }
 
 static void vkd3d_create_buffer_uav(struct d3d12_desc *descriptor, struct d3d12_device *device,
@@ -3214,7 +4212,11 @@ static void vkd3d_create_buffer_uav(struct d3d12_desc *descriptor, struct d3d12_
             WARN("Failed to create counter buffer view.\n");
             view->vk_counter_view = VK_NULL_HANDLE;
             d3d12_desc_destroy(descriptor, device);
+            return;
         }
+        if (device->use_descriptor_buffers)
+            view->vk_counter_address = vkd3d_get_buffer_device_address(device, counter_resource->u.vk_buffer)
+                    + desc->u.Buffer.CounterOffsetInBytes;
     }
 }
 
@@ -3275,6 +4277,7 @@ static void vkd3d_create_texture_uav(struct d3d12_desc *descriptor,
     descriptor->s.vk_descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
     descriptor->s.u.view_info.view = view;
     descriptor->s.u.view_info.written_serial_id = view->serial_id;
+    d3d12_desc_init_vk_image_info(descriptor, VK_IMAGE_LAYOUT_GENERAL);
 }
 
 void d3d12_desc_create_uav(struct d3d12_desc *descriptor, struct d3d12_device *device,
@@ -3438,6 +4441,7 @@ void d3d12_desc_create_sampler(struct d3d12_desc *sampler,
     sampler->s.vk_descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
     sampler->s.u.view_info.view = view;
     sampler->s.u.view_info.written_serial_id = view->serial_id;
+    d3d12_desc_init_vk_image_info(sampler, VK_IMAGE_LAYOUT_UNDEFINED);
 }
 
 HRESULT vkd3d_create_static_sampler(struct d3d12_device *device,
@@ -3541,6 +4545,8 @@ void d3d12_rtv_desc_create_rtv(struct d3d12_rtv_desc *rtv_desc, struct d3d12_dev
     if (!vkd3d_create_texture_view(device, resource->u.vk_image, &vkd3d_desc, &view))
         return;
 
+    view->is_attachment = true;
+
     rtv_desc->magic = VKD3D_DESCRIPTOR_MAGIC_RTV;
     rtv_desc->sample_count = vk_samples_from_dxgi_sample_desc(&resource->desc.SampleDesc);
     rtv_desc->format = vkd3d_desc.format;
@@ -3626,6 +4632,8 @@ void d3d12_dsv_desc_create_dsv(struct d3d12_dsv_desc *dsv_desc, struct d3d12_dev
     if (!vkd3d_create_texture_view(device, resource->u.vk_image, &vkd3d_desc, &view))
         return;
 
+    view->is_attachment = true;
+
     dsv_desc->magic = VKD3D_DESCRIPTOR_MAGIC_DSV;
     dsv_desc->sample_count = vk_samples_from_dxgi_sample_desc(&resource->desc.SampleDesc);
     dsv_desc->format = vkd3d_desc.format;
@@ -3674,6 +4682,22 @@ static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_AddRef(ID3D12DescriptorHeap
     return refcount;
 }
 
+static void d3d12_descriptor_heap_descriptor_buffer_cleanup(struct d3d12_descriptor_heap *descriptor_heap,
+        struct d3d12_device *device)
+{
+    struct d3d12_descriptor_heap_buffer *descriptor_buffer = &descriptor_heap->descriptor_buffer;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+
+    if (!descriptor_buffer->vk_buffer)
+    {
+        vkd3d_free(descriptor_buffer->data);
+        return;
+    }
+
+    VK_CALL(vkDestroyBuffer(device->vk_device, descriptor_buffer->vk_buffer, NULL));
+    vkd3d_free_device_memory(device, descriptor_buffer->vk_memory);
+}
+
 static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_Release(ID3D12DescriptorHeap *iface)
 {
     struct d3d12_descriptor_heap *heap = impl_from_ID3D12DescriptorHeap(iface);
@@ -3734,6 +4758,7 @@ static ULONG STDMETHODCALLTYPE d3d12_descriptor_heap_Release(ID3D12DescriptorHea
 
         VK_CALL(vkDestroyDescriptorPool(device->vk_device, heap->vk_descriptor_pool, NULL));
         vkd3d_mutex_destroy(&heap->vk_sets_mutex);
+        d3d12_descriptor_heap_descriptor_buffer_cleanup(heap, device);
 
         vkd3d_free(heap);
 
@@ -3927,8 +4952,8 @@ static HRESULT d3d12_descriptor_heap_vk_descriptor_sets_init(struct d3d12_descri
     memset(descriptor_heap->vk_descriptor_sets, 0, sizeof(descriptor_heap->vk_descriptor_sets));
     vkd3d_mutex_init(&descriptor_heap->vk_sets_mutex);
 
-    if (!device->use_vk_heaps || (desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
-            && desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER))
+    if (!device->use_vk_heaps || device->use_descriptor_buffers
+            || (desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV && desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER))
         return S_OK;
 
     if (FAILED(hr = d3d12_descriptor_heap_create_descriptor_pool(descriptor_heap, device, desc)))
@@ -3991,6 +5016,95 @@ static HRESULT d3d12_descriptor_heap_vk_descriptor_sets_init(struct d3d12_descri
     return S_OK;
 }
 
+#ifdef VK_EXT_descriptor_buffer
+static HRESULT d3d12_descriptor_heap_descriptor_buffer_init(struct d3d12_descriptor_heap *descriptor_heap,
+        struct d3d12_device *device, const D3D12_DESCRIPTOR_HEAP_DESC *desc)
+{
+    struct d3d12_descriptor_heap_buffer *descriptor_buffer = &descriptor_heap->descriptor_buffer;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    const struct vkd3d_vk_descriptor_heap_layout *layout;
+    enum vkd3d_vk_descriptor_set_index set;
+    D3D12_HEAP_PROPERTIES heap_properties;
+    VkBufferCreateInfo buffer_info;
+    VkDeviceSize size, alignment;
+    void *data;
+    VkResult vr;
+    HRESULT hr;
+
+    memset(descriptor_buffer, 0, sizeof(*descriptor_buffer));
+
+    if (!device->use_descriptor_buffers || (desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
+            && desc->Type != D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER))
+        return S_OK;
+
+    alignment = device->vk_info.descriptor_buffer_properties.descriptorBufferOffsetAlignment;
+    for (set = 0, size = 0; set < ARRAY_SIZE(device->vk_descriptor_heap_layouts); ++set)
+    {
+        layout = &device->vk_descriptor_heap_layouts[set];
+        if (layout->applicable_heap_type != desc->Type)
+            continue;
+        descriptor_buffer->set_offsets[set] = size;
+        size = align(size + layout->binding_offset + (VkDeviceSize)desc->NumDescriptors * layout->descriptor_size,
+                alignment);
+    }
+    size = max(size, alignment);
+
+    /* Descriptors are only copied out of heaps which are not shader visible. */
+    if (!(desc->Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE))
+        return (descriptor_buffer->data = vkd3d_calloc(1, size)) ? S_OK : E_OUTOFMEMORY;
+
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.pNext = NULL;
+    buffer_info.flags = 0;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR
+            | (desc->Type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER ? VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+            : VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT);
+    if (device->queue_family_count > 1)
+    {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = device->queue_family_count;
+        buffer_info.pQueueFamilyIndices = device->queue_family_indices;
+    }
+    else
+    {
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        buffer_info.queueFamilyIndexCount = 0;
+        buffer_info.pQueueFamilyIndices = NULL;
+    }
+
+    if ((vr = VK_CALL(vkCreateBuffer(device->vk_device, &buffer_info, NULL, &descriptor_buffer->vk_buffer))) < 0)
+    {
+        WARN("Failed to create descriptor buffer, vr %d.\n", vr);
+        descriptor_buffer->vk_buffer = VK_NULL_HANDLE;
+        return hresult_from_vk_result(vr);
+    }
+
+    memset(&heap_properties, 0, sizeof(heap_properties));
+    heap_properties.Type = D3D12_HEAP_TYPE_UPLOAD;
+    if (FAILED(hr = vkd3d_allocate_buffer_memory(device, descriptor_buffer->vk_buffer, &heap_properties,
+            D3D12_HEAP_FLAG_NONE, NULL, &descriptor_buffer->vk_memory, NULL, NULL)))
+    {
+        d3d12_descriptor_heap_descriptor_buffer_cleanup(descriptor_heap, device);
+        return hr;
+    }
+
+    if ((vr = VK_CALL(vkMapMemory(device->vk_device, descriptor_buffer->vk_memory, 0, VK_WHOLE_SIZE, 0, &data))) < 0)
+    {
+        WARN("Failed to map descriptor buffer, vr %d.\n", vr);
+        d3d12_descriptor_heap_descriptor_buffer_cleanup(descriptor_heap, device);
+        return hresult_from_vk_result(vr);
+    }
+    descriptor_buffer->data = data;
+    descriptor_buffer->vk_address = vkd3d_get_buffer_device_address(device, descriptor_buffer->vk_buffer);
+
+    TRACE("Created descriptor buffer of size %#"PRIx64" at address %#"PRIx64".\n",
+            size, descriptor_buffer->vk_address);
+
+    return S_OK;
+}
+#endif
+
 static HRESULT d3d12_descriptor_heap_init(struct d3d12_descriptor_heap *descriptor_heap,
         struct d3d12_device *device, const D3D12_DESCRIPTOR_HEAP_DESC *desc)
 {
@@ -4005,6 +5119,16 @@ static HRESULT d3d12_descriptor_heap_init(struct d3d12_descriptor_heap *descript
     if (FAILED(hr = vkd3d_private_store_init(&descriptor_heap->private_store)))
         return hr;
 
+#ifdef VK_EXT_descriptor_buffer
+    if (FAILED(hr = d3d12_descriptor_heap_descriptor_buffer_init(descriptor_heap, device, desc)))
+    {
+        vkd3d_private_store_destroy(&descriptor_heap->private_store);
+        return hr;
+    }
+#else
+    memset(&descriptor_heap->descriptor_buffer, 0, sizeof(descriptor_heap->descriptor_buffer));
+#endif
+
     d3d12_descriptor_heap_vk_descriptor_sets_init(descriptor_heap, device, desc);
 
     d3d12_device_add_ref(descriptor_heap->device = device);
@@ -4058,6 +5182,7 @@ HRESULT d3d12_descriptor_heap_create(struct d3d12_device *device,
         {
             memset(&dst[i].s, 0, sizeof(dst[i].s));
             dst[i].index = i;
+            dst[i].seq = 0;
         }
     }
     else
@@ -4519,7 +5644,7 @@ HRESULT vkd3d_init_null_resources(struct vkd3d_null_resources *null_resources,
             &resource_desc, &null_resources->vk_buffer)))
         goto fail;
     if (FAILED(hr = vkd3d_allocate_buffer_memory(device, null_resources->vk_buffer,
-            &heap_properties, D3D12_HEAP_FLAG_NONE, &null_resources->vk_buffer_memory, NULL, NULL)))
+            &heap_properties, D3D12_HEAP_FLAG_NONE, NULL, &null_resources->vk_buffer_memory, NULL, NULL)))
         goto fail;
 
     /* buffer UAV */
@@ -4529,7 +5654,7 @@ HRESULT vkd3d_init_null_resources(struct vkd3d_null_resources *null_resources,
             &resource_desc, &null_resources->vk_storage_buffer)))
         goto fail;
     if (!use_sparse_resources && FAILED(hr = vkd3d_allocate_buffer_memory(device, null_resources->vk_storage_buffer,
-            &heap_properties, D3D12_HEAP_FLAG_NONE, &null_resources->vk_storage_buffer_memory, NULL, NULL)))
+            &heap_properties, D3D12_HEAP_FLAG_NONE, NULL, &null_resources->vk_storage_buffer_memory, NULL, NULL)))
         goto fail;
 
     /* 2D SRV */
@@ -4549,7 +5674,7 @@ HRESULT vkd3d_init_null_resources(struct vkd3d_null_resources *null_resources,
             &resource_desc, NULL, &null_resources->vk_2d_image)))
         goto fail;
     if (FAILED(hr = vkd3d_allocate_image_memory(device, null_resources->vk_2d_image,
-            &heap_properties, D3D12_HEAP_FLAG_NONE, &null_resources->vk_2d_image_memory, NULL, NULL)))
+            &heap_properties, D3D12_HEAP_FLAG_NONE, NULL, &null_resources->vk_2d_image_memory, NULL, NULL)))
         goto fail;
 
     /* 2D UAV */
@@ -4570,7 +5695,7 @@ HRESULT vkd3d_init_null_resources(struct vkd3d_null_resources *null_resources,
             &resource_desc, NULL, &null_resources->vk_2d_storage_image)))
         goto fail;
     if (!use_sparse_resources && FAILED(hr = vkd3d_allocate_image_memory(device, null_resources->vk_2d_storage_image,
-            &heap_properties, D3D12_HEAP_FLAG_NONE, &null_resources->vk_2d_storage_image_memory, NULL, NULL)))
+            &heap_properties, D3D12_HEAP_FLAG_NONE, NULL, &null_resources->vk_2d_storage_image_memory, NULL, NULL)))
         goto fail;
 
     /* set Vulkan object names */
@@ -4608,16 +5733,16 @@ void vkd3d_destroy_null_resources(struct vkd3d_null_resources *null_resources,
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
     VK_CALL(vkDestroyBuffer(device->vk_device, null_resources->vk_buffer, NULL));
-    VK_CALL(vkFreeMemory(device->vk_device, null_resources->vk_buffer_memory, NULL));
+    vkd3d_free_device_memory(device, null_resources->vk_buffer_memory);
 
     VK_CALL(vkDestroyBuffer(device->vk_device, null_resources->vk_storage_buffer, NULL));
-    VK_CALL(vkFreeMemory(device->vk_device, null_resources->vk_storage_buffer_memory, NULL));
+    vkd3d_free_device_memory(device, null_resources->vk_storage_buffer_memory);
 
     VK_CALL(vkDestroyImage(device->vk_device, null_resources->vk_2d_image, NULL));
-    VK_CALL(vkFreeMemory(device->vk_device, null_resources->vk_2d_image_memory, NULL));
+    vkd3d_free_device_memory(device, null_resources->vk_2d_image_memory);
 
     VK_CALL(vkDestroyImage(device->vk_device, null_resources->vk_2d_storage_image, NULL));
-    VK_CALL(vkFreeMemory(device->vk_device, null_resources->vk_2d_storage_image_memory, NULL));
+    vkd3d_free_device_memory(device, null_resources->vk_2d_storage_image_memory);
 
     memset(null_resources, 0, sizeof(*null_resources));
 }
@@ -21,6 +21,8 @@
 #include "vkd3d_private.h"
 #include "vkd3d_shaders.h"
 
+static HRESULT d3d12_pipeline_state_finish_compile(struct d3d12_pipeline_state *state, bool cancel);
+
 /* ID3D12RootSignature */
 static inline struct d3d12_root_signature *impl_from_ID3D12RootSignature(ID3D12RootSignature *iface)
 {
@@ -83,8 +85,13 @@ static void d3d12_root_signature_cleanup(struct d3d12_root_signature *root_signa
     {
         for (i = 0; i < root_signature->parameter_count; ++i)
         {
-            if (root_signature->parameters[i].parameter_type == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
-                vkd3d_free(root_signature->parameters[i].u.descriptor_table.ranges);
+            struct d3d12_root_descriptor_table *table = &root_signature->parameters[i].u.descriptor_table;
+
+            if (root_signature->parameters[i].parameter_type != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+                continue;
+            if (table->vk_template)
+                VK_CALL(vkDestroyDescriptorUpdateTemplateKHR(device->vk_device, table->vk_template, NULL));
+            vkd3d_free(table->ranges);
         }
         vkd3d_free(root_signature->parameters);
     }
@@ -631,6 +638,16 @@ static HRESULT d3d12_root_signature_append_descriptor_set_layout(struct d3d12_ro
     if (!vkd3d_validate_descriptor_set_count(root_signature->device, index + 1))
         return E_INVALIDARG;
 
+#ifdef VK_EXT_descriptor_buffer
+    if (root_signature->device->use_descriptor_buffers)
+    {
+        flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+        /* Root descriptors are pushed, so the main set holds only static samplers. */
+        if (!(flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR))
+            flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_EMBEDDED_IMMUTABLE_SAMPLERS_BIT_EXT;
+    }
+#endif
+
     if (FAILED(hr = vkd3d_create_descriptor_set_layout(root_signature->device, flags, context->descriptor_binding,
             context->unbounded_offset != UINT_MAX, context->first_binding, &layout->vk_layout)))
         return hr;
@@ -1374,6 +1391,116 @@ static unsigned int d3d12_root_signature_copy_descriptor_set_layouts(const struc
     return i;
 }
 
+static HRESULT d3d12_root_signature_init_descriptor_table_template(struct d3d12_root_signature *root_signature,
+        struct d3d12_root_descriptor_table *table)
+{
+    struct d3d12_device *device = root_signature->device;
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    const struct d3d12_root_descriptor_table_range *range;
+    VkDescriptorUpdateTemplateCreateInfoKHR template_info;
+    VkDescriptorUpdateTemplateEntryKHR *entries, *entry;
+    unsigned int i;
+    VkResult vr;
+
+    if (!table->range_count)
+        return S_OK;
+
+    /* Unbounded ranges are sized from the heap at bind time. */
+    for (i = 0; i < table->range_count; ++i)
+    {
+        range = &table->ranges[i];
+        if (range->descriptor_count == UINT_MAX || !range->descriptor_count || range->set != table->ranges[0].set)
+            return S_OK;
+    }
+
+    if (!(entries = vkd3d_calloc(table->range_count, sizeof(*entries))))
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < table->range_count; ++i)
+    {
+        range = &table->ranges[i];
+        entry = &entries[i];
+
+        entry->dstBinding = range->binding;
+        entry->dstArrayElement = 0;
+        entry->descriptorCount = range->descriptor_count;
+        entry->offset = range->offset * sizeof(struct d3d12_desc)
+                + offsetof(struct d3d12_desc, s.u.view_info.vk_image_info);
+        entry->stride = sizeof(struct d3d12_desc);
+
+        /* SRV and UAV image bindings follow the buffer binding. See
+         * d3d12_root_signature_init_descriptor_array_binding(). */
+        switch (range->type)
+        {
+            case VKD3D_SHADER_DESCRIPTOR_TYPE_CBV:
+                entry->descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                entry->offset = range->offset * sizeof(struct d3d12_desc)
+                        + offsetof(struct d3d12_desc, s.u.vk_cbv_info);
+                break;
+            case VKD3D_SHADER_DESCRIPTOR_TYPE_SRV:
+                entry->descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                ++entry->dstBinding;
+                break;
+            case VKD3D_SHADER_DESCRIPTOR_TYPE_UAV:
+                entry->descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                ++entry->dstBinding;
+                break;
+            case VKD3D_SHADER_DESCRIPTOR_TYPE_SAMPLER:
+                entry->descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+                break;
+            default:
+                FIXME("Unhandled descriptor range type %#x.\n", range->type);
+                vkd3d_free(entries);
+                return S_OK;
+        }
+    }
+
+    template_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+    template_info.pNext = NULL;
+    template_info.flags = 0;
+    template_info.descriptorUpdateEntryCount = table->range_count;
+    template_info.pDescriptorUpdateEntries = entries;
+    template_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+    template_info.descriptorSetLayout
+            = root_signature->descriptor_set_layouts[root_signature->main_set + table->ranges[0].set].vk_layout;
+    template_info.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    template_info.pipelineLayout = VK_NULL_HANDLE;
+    template_info.set = 0;
+    if ((vr = VK_CALL(vkCreateDescriptorUpdateTemplateKHR(device->vk_device,
+            &template_info, NULL, &table->vk_template))) < 0)
+    {
+        WARN("Failed to create descriptor update template, vr %d.\n", vr);
+        table->vk_template = VK_NULL_HANDLE;
+    }
+
+    vkd3d_free(entries);
+
+    return S_OK;
+}
+
+static HRESULT d3d12_root_signature_init_descriptor_table_templates(struct d3d12_root_signature *root_signature)
+{
+    struct d3d12_device *device = root_signature->device;
+    unsigned int i;
+    HRESULT hr;
+
+    /* Templates need one binding per range, which descriptor arrays provide. */
+    if (device->use_vk_heaps || !root_signature->use_descriptor_arrays
+            || !device->vk_info.KHR_descriptor_update_template)
+        return S_OK;
+
+    for (i = 0; i < root_signature->parameter_count; ++i)
+    {
+        if (root_signature->parameters[i].parameter_type != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+            continue;
+        if (FAILED(hr = d3d12_root_signature_init_descriptor_table_template(root_signature,
+                &root_signature->parameters[i].u.descriptor_table)))
+            return hr;
+    }
+
+    return S_OK;
+}
+
 static HRESULT d3d12_root_signature_init(struct d3d12_root_signature *root_signature,
         struct d3d12_device *device, const D3D12_ROOT_SIGNATURE_DESC *desc)
 {
@@ -1491,6 +1618,9 @@ static HRESULT d3d12_root_signature_init(struct d3d12_root_signature *root_signa
             root_signature->push_constant_ranges, &root_signature->vk_pipeline_layout)))
         goto fail;
 
+    if (FAILED(hr = d3d12_root_signature_init_descriptor_table_templates(root_signature)))
+        goto fail;
+
     if (FAILED(hr = vkd3d_private_store_init(&root_signature->private_store)))
         goto fail;
 
@@ -1536,6 +1666,7 @@ HRESULT d3d12_root_signature_create(struct d3d12_device *device,
         vkd3d_free(object);
         return hr;
     }
+    object->hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, bytecode, bytecode_length);
 
     TRACE("Created root signature %p.\n", object);
 
@@ -1547,18 +1678,45 @@ HRESULT d3d12_root_signature_create(struct d3d12_device *device,
 /* vkd3d_render_pass_cache */
 struct vkd3d_render_pass_entry
 {
+    struct vkd3d_render_pass_entry *next;
+    uint32_t hash;
     struct vkd3d_render_pass_key key;
     VkRenderPass vk_render_pass;
 };
 
-STATIC_ASSERT(sizeof(struct vkd3d_render_pass_key) == 48);
+STATIC_ASSERT(sizeof(struct vkd3d_render_pass_key) == 56);
+
+static uint32_t vkd3d_render_pass_key_hash(const struct vkd3d_render_pass_key *key)
+{
+    uint64_t hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, key, sizeof(*key));
+
+    return hash ^ (hash >> 32);
+}
+
+static const struct vkd3d_render_pass_entry *vkd3d_render_pass_cache_lookup(
+        const struct vkd3d_render_pass_cache *cache, uint32_t hash, const struct vkd3d_render_pass_key *key)
+{
+    const struct vkd3d_render_pass_entry *current;
+
+    /* Entries are published with a full barrier, and readers only access
+     * them through the pointer they loaded. */
+    for (current = cache->buckets[hash % ARRAY_SIZE(cache->buckets)]; current; current = current->next)
+    {
+        if (current->hash == hash && !memcmp(&current->key, key, sizeof(*key)))
+            return current;
+    }
+
+    return NULL;
+}
 
 static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pass_cache *cache,
-        struct d3d12_device *device, const struct vkd3d_render_pass_key *key, VkRenderPass *vk_render_pass)
+        struct d3d12_device *device, uint32_t hash, const struct vkd3d_render_pass_key *key,
+        VkRenderPass *vk_render_pass)
 {
     VkAttachmentReference attachment_references[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
     VkAttachmentDescription attachments[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_render_pass_entry * volatile *bucket;
     struct vkd3d_render_pass_entry *entry;
     unsigned int index, attachment_index;
     VkSubpassDescription sub_pass_desc;
@@ -1567,15 +1725,13 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
     unsigned int rt_count;
     VkResult vr;
 
-    if (!vkd3d_array_reserve((void **)&cache->render_passes, &cache->render_passes_size,
-            cache->render_pass_count + 1, sizeof(*cache->render_passes)))
+    if (!(entry = vkd3d_malloc(sizeof(*entry))))
     {
         *vk_render_pass = VK_NULL_HANDLE;
         return E_OUTOFMEMORY;
     }
 
-    entry = &cache->render_passes[cache->render_pass_count];
-
+    entry->hash = hash;
     entry->key = *key;
 
     have_depth_stencil = key->depth_enable || key->stencil_enable;
@@ -1594,7 +1750,12 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
         attachments[attachment_index].flags = 0;
         attachments[attachment_index].format = key->vk_formats[index];
         attachments[attachment_index].samples = key->sample_count;
-        attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        if (key->clear_mask & (1u << index))
+            attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        else if (key->discard_mask & (1u << index))
+            attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        else
+            attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
         attachments[attachment_index].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         attachments[attachment_index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         attachments[attachment_index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -1609,7 +1770,10 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
 
     if (have_depth_stencil)
     {
+        /* Clearing requires a writable layout. Layouts don't affect render
+         * pass compatibility, so pipelines remain usable with this pass. */
         VkImageLayout depth_layout = key->depth_stencil_write
+                || (key->clear_mask & (VKD3D_RENDER_PASS_DEPTH_BIT | VKD3D_RENDER_PASS_STENCIL_BIT))
                 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
                 : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
@@ -1617,9 +1781,15 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
         attachments[attachment_index].format = key->vk_formats[index];
         attachments[attachment_index].samples = key->sample_count;
 
-        if (key->depth_enable)
+        if (key->clear_mask & VKD3D_RENDER_PASS_DEPTH_BIT)
         {
-            attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments[attachment_index].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        }
+        else if (key->depth_enable)
+        {
+            attachments[attachment_index].loadOp = (key->discard_mask & VKD3D_RENDER_PASS_DEPTH_BIT)
+                    ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
             attachments[attachment_index].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         }
         else
@@ -1627,9 +1797,15 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
             attachments[attachment_index].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachments[attachment_index].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         }
-        if (key->stencil_enable)
+        if (key->clear_mask & VKD3D_RENDER_PASS_STENCIL_BIT)
+        {
+            attachments[attachment_index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments[attachment_index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+        }
+        else if (key->stencil_enable)
         {
-            attachments[attachment_index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            attachments[attachment_index].stencilLoadOp = (key->discard_mask & VKD3D_RENDER_PASS_STENCIL_BIT)
+                    ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
             attachments[attachment_index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
         }
         else
@@ -1669,70 +1845,235 @@ static HRESULT vkd3d_render_pass_cache_create_pass_locked(struct vkd3d_render_pa
     pass_info.pSubpasses = &sub_pass_desc;
     pass_info.dependencyCount = 0;
     pass_info.pDependencies = NULL;
-    if ((vr = VK_CALL(vkCreateRenderPass(device->vk_device, &pass_info, NULL, vk_render_pass))) >= 0)
-    {
-        entry->vk_render_pass = *vk_render_pass;
-        ++cache->render_pass_count;
-    }
-    else
+    if ((vr = VK_CALL(vkCreateRenderPass(device->vk_device, &pass_info, NULL, vk_render_pass))) < 0)
     {
         WARN("Failed to create Vulkan render pass, vr %d.\n", vr);
         *vk_render_pass = VK_NULL_HANDLE;
+        vkd3d_free(entry);
+        return hresult_from_vk_result(vr);
     }
 
-    return hresult_from_vk_result(vr);
+    entry->vk_render_pass = *vk_render_pass;
+
+    /* Writers are serialised by the cache mutex. The exchange only serves
+     * as a barrier publishing the initialised entry. */
+    bucket = &cache->buckets[hash % ARRAY_SIZE(cache->buckets)];
+    entry->next = *bucket;
+    InterlockedCompareExchangePointer((void * volatile *)bucket, entry, entry->next);
+    ++cache->render_pass_count;
+
+    return S_OK;
 }
 
 HRESULT vkd3d_render_pass_cache_find(struct vkd3d_render_pass_cache *cache,
         struct d3d12_device *device, const struct vkd3d_render_pass_key *key, VkRenderPass *vk_render_pass)
 {
-    bool found = false;
-    HRESULT hr = S_OK;
-    unsigned int i;
+    const struct vkd3d_render_pass_entry *entry;
+    uint32_t hash;
+    HRESULT hr;
 
-    vkd3d_mutex_lock(&device->mutex);
+    hash = vkd3d_render_pass_key_hash(key);
 
-    for (i = 0; i < cache->render_pass_count; ++i)
+    if ((entry = vkd3d_render_pass_cache_lookup(cache, hash, key)))
     {
-        struct vkd3d_render_pass_entry *current = &cache->render_passes[i];
-
-        if (!memcmp(&current->key, key, sizeof(*key)))
-        {
-            *vk_render_pass = current->vk_render_pass;
-            found = true;
-            break;
-        }
+        *vk_render_pass = entry->vk_render_pass;
+        return S_OK;
     }
 
-    if (!found)
-        hr = vkd3d_render_pass_cache_create_pass_locked(cache, device, key, vk_render_pass);
+    vkd3d_mutex_lock(&cache->mutex);
+
+    if ((entry = vkd3d_render_pass_cache_lookup(cache, hash, key)))
+    {
+        *vk_render_pass = entry->vk_render_pass;
+        hr = S_OK;
+    }
+    else
+    {
+        hr = vkd3d_render_pass_cache_create_pass_locked(cache, device, hash, key, vk_render_pass);
+    }
 
-    vkd3d_mutex_unlock(&device->mutex);
+    vkd3d_mutex_unlock(&cache->mutex);
 
     return hr;
 }
 
 void vkd3d_render_pass_cache_init(struct vkd3d_render_pass_cache *cache)
 {
-    cache->render_passes = NULL;
+    vkd3d_mutex_init(&cache->mutex);
+    memset((void *)cache->buckets, 0, sizeof(cache->buckets));
     cache->render_pass_count = 0;
-    cache->render_passes_size = 0;
 }
 
 void vkd3d_render_pass_cache_cleanup(struct vkd3d_render_pass_cache *cache,
         struct d3d12_device *device)
 {
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct vkd3d_render_pass_entry *current, *next;
     unsigned int i;
 
-    for (i = 0; i < cache->render_pass_count; ++i)
+    TRACE("Destroying %zu render passes.\n", cache->render_pass_count);
+
+    for (i = 0; i < ARRAY_SIZE(cache->buckets); ++i)
+    {
+        for (current = cache->buckets[i]; current; current = next)
+        {
+            next = current->next;
+            VK_CALL(vkDestroyRenderPass(device->vk_device, current->vk_render_pass, NULL));
+            vkd3d_free(current);
+        }
+        cache->buckets[i] = NULL;
+    }
+    cache->render_pass_count = 0;
+
+    vkd3d_mutex_destroy(&cache->mutex);
+}
+
+/* vkd3d_shader_cache */
+#define VKD3D_SHADER_CACHE_DEFAULT_MAX_SIZE_MB 64u
+
+static int vkd3d_shader_source_key_compare(const struct vkd3d_shader_source_key *a,
+        const struct vkd3d_shader_source_key *b)
+{
+    int ret;
+
+    if ((ret = vkd3d_u64_compare(a->hash, b->hash)))
+        return ret;
+    if (a->size != b->size)
+        return a->size < b->size ? -1 : 1;
+    return memcmp(a->data, b->data, a->size);
+}
+
+struct vkd3d_shader_cache_entry *vkd3d_shader_cache_entry_create(VkShaderStageFlagBits stage,
+        const struct vkd3d_shader_source_key *source_key, const struct vkd3d_shader_code *spirv)
+{
+    struct vkd3d_shader_cache_entry *entry;
+    uint8_t *data;
+
+    /* The SPIR-V comes first, so that it stays 4-byte aligned. */
+    if (!(entry = vkd3d_malloc(sizeof(*entry) + spirv->size + source_key->size)))
+        return NULL;
+    data = (uint8_t *)(entry + 1);
+
+    entry->refcount = 1;
+    entry->stage = stage;
+    memcpy(data, spirv->code, spirv->size);
+    entry->spirv.code = data;
+    entry->spirv.size = spirv->size;
+    memcpy(data + spirv->size, source_key->data, source_key->size);
+    entry->source_key.hash = source_key->hash;
+    entry->source_key.size = source_key->size;
+    entry->source_key.data = data + spirv->size;
+    list_init(&entry->lru_entry);
+
+    return entry;
+}
+
+void vkd3d_shader_cache_entry_decref(struct vkd3d_shader_cache_entry *entry)
+{
+    if (!InterlockedDecrement(&entry->refcount))
+        vkd3d_free(entry);
+}
+
+static int vkd3d_shader_cache_compare_key(const void *key, const struct rb_entry *entry)
+{
+    const struct vkd3d_shader_cache_entry *e = RB_ENTRY_VALUE(entry, const struct vkd3d_shader_cache_entry, entry);
+
+    return vkd3d_shader_source_key_compare(key, &e->source_key);
+}
+
+static void vkd3d_shader_cache_evict(struct vkd3d_shader_cache *cache, struct vkd3d_shader_cache_entry *entry)
+{
+    rb_remove(&cache->entries, &entry->entry);
+    list_remove(&entry->lru_entry);
+    cache->size -= entry->spirv.size;
+    vkd3d_shader_cache_entry_decref(entry);
+}
+
+void vkd3d_shader_cache_init(struct vkd3d_shader_cache *cache)
+{
+    vkd3d_mutex_init(&cache->mutex);
+    rb_init(&cache->entries, vkd3d_shader_cache_compare_key);
+    list_init(&cache->lru);
+    cache->size = 0;
+    cache->max_size = (size_t)vkd3d_env_var_as_uint("VKD3D_SHADER_CACHE_MAX_SIZE",
+            VKD3D_SHADER_CACHE_DEFAULT_MAX_SIZE_MB) * 1024 * 1024;
+    cache->hit_count = 0;
+    cache->miss_count = 0;
+}
+
+void vkd3d_shader_cache_cleanup(struct vkd3d_shader_cache *cache)
+{
+    struct vkd3d_shader_cache_entry *entry, *next;
+
+    TRACE("Shader cache hits %"PRIu64", misses %"PRIu64", size %zu.\n",
+            cache->hit_count, cache->miss_count, cache->size);
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &cache->lru, struct vkd3d_shader_cache_entry, lru_entry)
+    {
+        vkd3d_shader_cache_evict(cache, entry);
+    }
+
+    vkd3d_mutex_destroy(&cache->mutex);
+}
+
+struct vkd3d_shader_cache_entry *vkd3d_shader_cache_get(struct vkd3d_shader_cache *cache,
+        const struct vkd3d_shader_source_key *source_key)
+{
+    struct vkd3d_shader_cache_entry *entry = NULL;
+    struct rb_entry *rb_entry;
+
+    if (!cache->max_size)
+        return NULL;
+
+    vkd3d_mutex_lock(&cache->mutex);
+
+    if ((rb_entry = rb_get(&cache->entries, source_key)))
+    {
+        entry = RB_ENTRY_VALUE(rb_entry, struct vkd3d_shader_cache_entry, entry);
+        InterlockedIncrement(&entry->refcount);
+        list_remove(&entry->lru_entry);
+        list_add_head(&cache->lru, &entry->lru_entry);
+        ++cache->hit_count;
+    }
+    else
+    {
+        ++cache->miss_count;
+    }
+
+    vkd3d_mutex_unlock(&cache->mutex);
+
+    return entry;
+}
+
+void vkd3d_shader_cache_put(struct vkd3d_shader_cache *cache, struct vkd3d_shader_cache_entry *entry)
+{
+    struct vkd3d_shader_cache_entry *lru;
+
+    if (entry->spirv.size > cache->max_size)
+        return;
+
+    vkd3d_mutex_lock(&cache->mutex);
+
+    /* Another thread may have translated the same shader in the meantime. */
+    if (rb_put(&cache->entries, &entry->source_key, &entry->entry) < 0)
+    {
+        vkd3d_mutex_unlock(&cache->mutex);
+        return;
+    }
+
+    InterlockedIncrement(&entry->refcount);
+    list_add_head(&cache->lru, &entry->lru_entry);
+    cache->size += entry->spirv.size;
+
+    /* Entries still used by pipeline states stay alive after eviction. */
+    while (cache->size > cache->max_size)
     {
-        struct vkd3d_render_pass_entry *current = &cache->render_passes[i];
-        VK_CALL(vkDestroyRenderPass(device->vk_device, current->vk_render_pass, NULL));
+        lru = LIST_ENTRY(list_tail(&cache->lru), struct vkd3d_shader_cache_entry, lru_entry);
+        TRACE("Evicting shader %#"PRIx64", size %zu.\n", lru->source_key.hash, lru->spirv.size);
+        vkd3d_shader_cache_evict(cache, lru);
     }
 
-    vkd3d_free(cache->render_passes);
-    cache->render_passes = NULL;
+    vkd3d_mutex_unlock(&cache->mutex);
 }
 
 struct vkd3d_pipeline_key
@@ -1744,7 +2085,8 @@ struct vkd3d_pipeline_key
 
 struct vkd3d_compiled_pipeline
 {
-    struct list entry;
+    struct vkd3d_compiled_pipeline *next;
+    uint32_t hash;
     struct vkd3d_pipeline_key key;
     VkPipeline vk_pipeline;
     VkRenderPass vk_render_pass;
@@ -1788,12 +2130,171 @@ static ULONG STDMETHODCALLTYPE d3d12_pipeline_state_AddRef(ID3D12PipelineState *
     return refcount;
 }
 
+#define VKD3D_CACHED_PSO_MAGIC VKD3D_MAKE_TAG('V', 'P', 'S', 'O')
+#define VKD3D_CACHED_PSO_VERSION 2
+
+/* Blobs returned by GetCachedBlob() start with this header. It is followed by
+ * "stage_count" stage records, the description key, and then the source key
+ * and the SPIR-V of each stage, in the same order.
+ *
+ * Blobs don't carry Vulkan pipeline cache data. Pipelines are created with
+ * the device pipeline cache, which is shared by all pipeline states and
+ * persisted on disk, and the data of a single pipeline can't be extracted
+ * from it. Seeding it from a blob would need vkMergePipelineCaches(), which
+ * requires exclusive access to the device cache. */
+struct vkd3d_cached_pso_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t build_hash;
+    uint8_t device_uuid[VK_UUID_SIZE];
+    uint32_t stage_count;
+    uint32_t reserved;
+    uint64_t desc_key_hash;
+    uint64_t desc_key_size;
+};
+
+struct vkd3d_cached_pso_stage
+{
+    uint32_t stage;
+    uint32_t spirv_size;
+    uint64_t source_key_hash;
+    uint64_t source_key_size;
+};
+
+/* A validated D3D12_CACHED_PIPELINE_STATE blob. */
+struct d3d12_cached_pso
+{
+    const struct vkd3d_cached_pso_stage *stages;
+    unsigned int stage_count;
+    const uint8_t *data;
+};
+
+static HRESULT d3d12_cached_pso_init(struct d3d12_cached_pso *cached_pso, const struct d3d12_device *device,
+        const D3D12_CACHED_PIPELINE_STATE *desc, const struct vkd3d_shader_source_key *desc_key)
+{
+    const struct vkd3d_cached_pso_header *header = desc->pCachedBlob;
+    size_t size = desc->CachedBlobSizeInBytes;
+    const struct vkd3d_cached_pso_stage *stages;
+    size_t offset;
+    unsigned int i;
+
+    memset(cached_pso, 0, sizeof(*cached_pso));
+
+    if (!header || !size)
+        return S_OK;
+
+    if (size < sizeof(*header) || header->magic != VKD3D_CACHED_PSO_MAGIC)
+    {
+        WARN("Invalid cached pipeline state blob.\n");
+        return E_INVALIDARG;
+    }
+
+    /* As on Windows, creation fails rather than ignoring the blob. Applications
+     * handle these errors by creating the pipeline state without it. */
+    if (header->version != VKD3D_CACHED_PSO_VERSION || header->build_hash != vkd3d_get_build_hash())
+    {
+        WARN("Cached pipeline state blob was created by a different driver version.\n");
+        return D3D12_ERROR_DRIVER_VERSION_MISMATCH;
+    }
+
+    if (memcmp(header->device_uuid, device->pipeline_cache_uuid, VK_UUID_SIZE))
+    {
+        WARN("Cached pipeline state blob was created for a different device.\n");
+        return D3D12_ERROR_ADAPTER_NOT_FOUND;
+    }
+
+    stages = (const struct vkd3d_cached_pso_stage *)(header + 1);
+    offset = sizeof(*header);
+    if (!header->stage_count || header->stage_count > VKD3D_MAX_SHADER_STAGES
+            || header->stage_count * sizeof(*stages) > size - offset)
+    {
+        WARN("Invalid stage count %u in cached pipeline state blob.\n", header->stage_count);
+        return E_INVALIDARG;
+    }
+    offset += header->stage_count * sizeof(*stages);
+
+    if (header->desc_key_size > size - offset)
+    {
+        WARN("Invalid description key size %#"PRIx64" in cached pipeline state blob.\n", header->desc_key_size);
+        return E_INVALIDARG;
+    }
+    if (header->desc_key_hash != desc_key->hash || header->desc_key_size != desc_key->size
+            || (desc_key->size && memcmp(&stages[header->stage_count], desc_key->data, desc_key->size)))
+    {
+        WARN("Cached pipeline state blob doesn't match the pipeline description.\n");
+        return E_INVALIDARG;
+    }
+    offset += header->desc_key_size;
+
+    /* Compare each size against the remaining size, so that the sum cannot overflow. */
+    for (i = 0; i < header->stage_count; ++i)
+    {
+        if (stages[i].spirv_size % sizeof(uint32_t) || stages[i].source_key_size > size - offset
+                || stages[i].spirv_size > size - offset - stages[i].source_key_size)
+        {
+            WARN("Invalid stage %u in cached pipeline state blob.\n", i);
+            return E_INVALIDARG;
+        }
+        offset += stages[i].source_key_size + stages[i].spirv_size;
+    }
+
+    if (offset != size)
+    {
+        WARN("Invalid cached pipeline state blob size %zu.\n", size);
+        return E_INVALIDARG;
+    }
+
+    cached_pso->stages = stages;
+    cached_pso->stage_count = header->stage_count;
+    cached_pso->data = (const uint8_t *)&stages[header->stage_count] + header->desc_key_size;
+
+    return S_OK;
+}
+
+static bool d3d12_cached_pso_find_stage(const struct d3d12_cached_pso *cached_pso,
+        enum VkShaderStageFlagBits stage, const struct vkd3d_shader_source_key *source_key,
+        struct vkd3d_shader_code *spirv)
+{
+    const struct vkd3d_cached_pso_stage *cached_stage;
+    const uint8_t *data = cached_pso->data;
+    unsigned int i;
+
+    for (i = 0; i < cached_pso->stage_count; ++i)
+    {
+        cached_stage = &cached_pso->stages[i];
+        if (cached_stage->stage == stage && cached_stage->source_key_hash == source_key->hash
+                && cached_stage->source_key_size == source_key->size
+                && !memcmp(data, source_key->data, source_key->size))
+        {
+            spirv->code = data + cached_stage->source_key_size;
+            spirv->size = cached_stage->spirv_size;
+            return true;
+        }
+        data += cached_stage->source_key_size + cached_stage->spirv_size;
+    }
+
+    return false;
+}
+
+static void d3d12_pipeline_state_cleanup_stage_code(struct d3d12_pipeline_state *state)
+{
+    unsigned int i;
+
+    for (i = 0; i < state->stage_code_count; ++i)
+    {
+        if (state->stage_code[i])
+            vkd3d_shader_cache_entry_decref(state->stage_code[i]);
+    }
+    state->stage_code_count = 0;
+}
+
 static void d3d12_pipeline_state_destroy_graphics(struct d3d12_pipeline_state *state,
         struct d3d12_device *device)
 {
     struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
     const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    struct vkd3d_compiled_pipeline *current, *e;
+    struct vkd3d_compiled_pipeline *current, *next;
     unsigned int i;
 
     for (i = 0; i < graphics->stage_count; ++i)
@@ -1801,10 +2302,14 @@ static void d3d12_pipeline_state_destroy_graphics(struct d3d12_pipeline_state *s
         VK_CALL(vkDestroyShaderModule(device->vk_device, graphics->stages[i].module, NULL));
     }
 
-    LIST_FOR_EACH_ENTRY_SAFE(current, e, &graphics->compiled_pipelines, struct vkd3d_compiled_pipeline, entry)
+    for (i = 0; i < ARRAY_SIZE(graphics->compiled_pipelines); ++i)
     {
-        VK_CALL(vkDestroyPipeline(device->vk_device, current->vk_pipeline, NULL));
-        vkd3d_free(current);
+        for (current = graphics->compiled_pipelines[i]; current; current = next)
+        {
+            next = current->next;
+            VK_CALL(vkDestroyPipeline(device->vk_device, current->vk_pipeline, NULL));
+            vkd3d_free(current);
+        }
     }
 }
 
@@ -1833,6 +2338,8 @@ static ULONG STDMETHODCALLTYPE d3d12_pipeline_state_Release(ID3D12PipelineState
         struct d3d12_device *device = state->device;
         const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
 
+        d3d12_pipeline_state_finish_compile(state, true);
+
         vkd3d_private_store_destroy(&state->private_store);
 
         if (d3d12_pipeline_state_is_graphics(state))
@@ -1841,6 +2348,8 @@ static ULONG STDMETHODCALLTYPE d3d12_pipeline_state_Release(ID3D12PipelineState
             VK_CALL(vkDestroyPipeline(device->vk_device, state->u.compute.vk_pipeline, NULL));
 
         d3d12_pipeline_uav_counter_state_cleanup(&state->uav_counters, device);
+        d3d12_pipeline_state_cleanup_stage_code(state);
+        vkd3d_free(state->desc_key.data);
 
         vkd3d_free(state);
 
@@ -1905,29 +2414,108 @@ static HRESULT STDMETHODCALLTYPE d3d12_pipeline_state_GetDevice(ID3D12PipelineSt
     return d3d12_device_query_interface(state->device, iid, device);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d12_pipeline_state_GetCachedBlob(ID3D12PipelineState *iface,
-        ID3DBlob **blob)
+static bool vkd3d_size_add(size_t *size, size_t value)
 {
-    FIXME("iface %p, blob %p stub!\n", iface, blob);
-
-    return E_NOTIMPL;
+    if (value > SIZE_MAX - *size)
+        return false;
+    *size += value;
+    return true;
 }
 
-static const struct ID3D12PipelineStateVtbl d3d12_pipeline_state_vtbl =
+static HRESULT d3d12_pipeline_state_get_cached_data(struct d3d12_pipeline_state *state,
+        void **data, size_t *data_size)
 {
-    /* IUnknown methods */
-    d3d12_pipeline_state_QueryInterface,
-    d3d12_pipeline_state_AddRef,
-    d3d12_pipeline_state_Release,
-    /* ID3D12Object methods */
-    d3d12_pipeline_state_GetPrivateData,
-    d3d12_pipeline_state_SetPrivateData,
-    d3d12_pipeline_state_SetPrivateDataInterface,
-    d3d12_pipeline_state_SetName,
-    /* ID3D12DeviceChild methods */
-    d3d12_pipeline_state_GetDevice,
-    /* ID3D12PipelineState methods */
-    d3d12_pipeline_state_GetCachedBlob,
+    struct vkd3d_cached_pso_header *header;
+    struct vkd3d_cached_pso_stage *stages;
+    unsigned int i;
+    uint8_t *ptr;
+    size_t size;
+    HRESULT hr;
+
+    if (FAILED(hr = d3d12_pipeline_state_wait(state)))
+        return hr;
+
+    size = sizeof(*header) + state->stage_code_count * sizeof(*stages);
+    if (!vkd3d_size_add(&size, state->desc_key.size))
+        return E_OUTOFMEMORY;
+    for (i = 0; i < state->stage_code_count; ++i)
+    {
+        if (!vkd3d_size_add(&size, state->stage_code[i]->source_key.size)
+                || !vkd3d_size_add(&size, state->stage_code[i]->spirv.size))
+            return E_OUTOFMEMORY;
+    }
+
+    if (!(header = vkd3d_malloc(size)))
+        return E_OUTOFMEMORY;
+
+    header->magic = VKD3D_CACHED_PSO_MAGIC;
+    header->version = VKD3D_CACHED_PSO_VERSION;
+    header->build_hash = vkd3d_get_build_hash();
+    memcpy(header->device_uuid, state->device->pipeline_cache_uuid, VK_UUID_SIZE);
+    header->stage_count = state->stage_code_count;
+    header->reserved = 0;
+    header->desc_key_hash = state->desc_key.hash;
+    header->desc_key_size = state->desc_key.size;
+
+    stages = (struct vkd3d_cached_pso_stage *)(header + 1);
+    ptr = (uint8_t *)&stages[state->stage_code_count];
+    if (state->desc_key.size)
+        memcpy(ptr, state->desc_key.data, state->desc_key.size);
+    ptr += state->desc_key.size;
+    for (i = 0; i < state->stage_code_count; ++i)
+    {
+        const struct vkd3d_shader_cache_entry *stage_code = state->stage_code[i];
+
+        stages[i].stage = stage_code->stage;
+        stages[i].spirv_size = stage_code->spirv.size;
+        stages[i].source_key_hash = stage_code->source_key.hash;
+        stages[i].source_key_size = stage_code->source_key.size;
+        memcpy(ptr, stage_code->source_key.data, stage_code->source_key.size);
+        ptr += stage_code->source_key.size;
+        memcpy(ptr, stage_code->spirv.code, stage_code->spirv.size);
+        ptr += stage_code->spirv.size;
+    }
+
+    *data = header;
+    *data_size = size;
+
+    return S_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_state_GetCachedBlob(ID3D12PipelineState *iface,
+        ID3DBlob **blob)
+{
+    struct d3d12_pipeline_state *state = impl_from_ID3D12PipelineState(iface);
+    size_t size;
+    void *data;
+    HRESULT hr;
+
+    TRACE("iface %p, blob %p.\n", iface, blob);
+
+    if (FAILED(hr = d3d12_pipeline_state_get_cached_data(state, &data, &size)))
+        return hr;
+
+    if (FAILED(hr = vkd3d_blob_create(data, size, blob)))
+        vkd3d_free(data);
+
+    return hr;
+}
+
+static const struct ID3D12PipelineStateVtbl d3d12_pipeline_state_vtbl =
+{
+    /* IUnknown methods */
+    d3d12_pipeline_state_QueryInterface,
+    d3d12_pipeline_state_AddRef,
+    d3d12_pipeline_state_Release,
+    /* ID3D12Object methods */
+    d3d12_pipeline_state_GetPrivateData,
+    d3d12_pipeline_state_SetPrivateData,
+    d3d12_pipeline_state_SetPrivateDataInterface,
+    d3d12_pipeline_state_SetName,
+    /* ID3D12DeviceChild methods */
+    d3d12_pipeline_state_GetDevice,
+    /* ID3D12PipelineState methods */
+    d3d12_pipeline_state_GetCachedBlob,
 };
 
 struct d3d12_pipeline_state *unsafe_impl_from_ID3D12PipelineState(ID3D12PipelineState *iface)
@@ -1945,34 +2533,293 @@ static inline unsigned int typed_uav_compile_option(const struct d3d12_device *d
             : VKD3D_SHADER_COMPILE_OPTION_TYPED_UAV_READ_FORMAT_R32;
 }
 
-static HRESULT create_shader_stage(struct d3d12_device *device,
-        struct VkPipelineShaderStageCreateInfo *stage_desc, enum VkShaderStageFlagBits stage,
-        const D3D12_SHADER_BYTECODE *code, const struct vkd3d_shader_interface_info *shader_interface)
+struct vkd3d_shader_source_key_builder
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    struct vkd3d_shader_compile_info compile_info;
-    struct VkShaderModuleCreateInfo shader_desc;
-    struct vkd3d_shader_code spirv = {0};
-    VkResult vr;
-    int ret;
+    uint8_t *data;
+    size_t capacity;
+    size_t size;
+    bool failed;
+};
 
-    const struct vkd3d_shader_compile_option options[] =
+static void vkd3d_key_builder_append(struct vkd3d_shader_source_key_builder *builder,
+        const void *data, size_t size)
+{
+    if (builder->failed || !size)
+        return;
+
+    if (!vkd3d_array_reserve((void **)&builder->data, &builder->capacity, builder->size + size, 1))
     {
-        {VKD3D_SHADER_COMPILE_OPTION_API_VERSION, VKD3D_SHADER_API_VERSION_1_7},
-        {VKD3D_SHADER_COMPILE_OPTION_TYPED_UAV, typed_uav_compile_option(device)},
-        {VKD3D_SHADER_COMPILE_OPTION_WRITE_TESS_GEOM_POINT_SIZE, 0},
-    };
+        builder->failed = true;
+        return;
+    }
 
-    stage_desc->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stage_desc->pNext = NULL;
-    stage_desc->flags = 0;
-    stage_desc->stage = stage;
-    stage_desc->pName = "main";
-    stage_desc->pSpecializationInfo = NULL;
+    memcpy(builder->data + builder->size, data, size);
+    builder->size += size;
+}
 
-    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_desc.pNext = NULL;
-    shader_desc.flags = 0;
+static void vkd3d_key_builder_append_uint(struct vkd3d_shader_source_key_builder *builder, unsigned int value)
+{
+    vkd3d_key_builder_append(builder, &value, sizeof(value));
+}
+
+/* Arrays and strings are prefixed with their length, so that the key is unambiguous. */
+static void vkd3d_key_builder_append_array(struct vkd3d_shader_source_key_builder *builder,
+        const void *elements, unsigned int count, size_t element_size)
+{
+    vkd3d_key_builder_append_uint(builder, count);
+    if (elements)
+        vkd3d_key_builder_append(builder, elements, count * element_size);
+}
+
+static void vkd3d_key_builder_append_string(struct vkd3d_shader_source_key_builder *builder, const char *str)
+{
+    vkd3d_key_builder_append_array(builder, str, str ? strlen(str) : 0, 1);
+}
+
+/* Appends everything in the shader interface chain that may affect the
+ * generated SPIR-V. */
+static void vkd3d_key_builder_append_shader_interface(struct vkd3d_shader_source_key_builder *builder,
+        const struct vkd3d_shader_interface_info *shader_interface)
+{
+    const struct vkd3d_shader_descriptor_offset_info *offset_info;
+    const struct vkd3d_shader_transform_feedback_info *xfb_info;
+    const struct vkd3d_shader_spirv_target_info *target_info;
+    const struct
+    {
+        enum vkd3d_shader_structure_type type;
+        const void *next;
+    } *info;
+    unsigned int i;
+
+    if (!shader_interface)
+        return;
+
+    vkd3d_key_builder_append_array(builder, shader_interface->bindings,
+            shader_interface->binding_count, sizeof(*shader_interface->bindings));
+    vkd3d_key_builder_append_array(builder, shader_interface->push_constant_buffers,
+            shader_interface->push_constant_buffer_count, sizeof(*shader_interface->push_constant_buffers));
+    vkd3d_key_builder_append_array(builder, shader_interface->combined_samplers,
+            shader_interface->combined_sampler_count, sizeof(*shader_interface->combined_samplers));
+    vkd3d_key_builder_append_array(builder, shader_interface->uav_counters,
+            shader_interface->uav_counter_count, sizeof(*shader_interface->uav_counters));
+
+    for (info = shader_interface->next; info; info = info->next)
+    {
+        vkd3d_key_builder_append_uint(builder, info->type);
+
+        switch (info->type)
+        {
+            case VKD3D_SHADER_STRUCTURE_TYPE_SPIRV_TARGET_INFO:
+                target_info = (const struct vkd3d_shader_spirv_target_info *)info;
+                vkd3d_key_builder_append_string(builder, target_info->entry_point);
+                vkd3d_key_builder_append_uint(builder, target_info->environment);
+                vkd3d_key_builder_append_array(builder, target_info->extensions,
+                        target_info->extension_count, sizeof(*target_info->extensions));
+                vkd3d_key_builder_append_array(builder, target_info->parameters,
+                        target_info->parameter_count, sizeof(*target_info->parameters));
+                vkd3d_key_builder_append_uint(builder, target_info->dual_source_blending);
+                vkd3d_key_builder_append_array(builder, target_info->output_swizzles,
+                        target_info->output_swizzle_count, sizeof(*target_info->output_swizzles));
+                break;
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_TRANSFORM_FEEDBACK_INFO:
+                xfb_info = (const struct vkd3d_shader_transform_feedback_info *)info;
+                vkd3d_key_builder_append_uint(builder, xfb_info->element_count);
+                for (i = 0; i < xfb_info->element_count; ++i)
+                {
+                    const struct vkd3d_shader_transform_feedback_element *e = &xfb_info->elements[i];
+
+                    vkd3d_key_builder_append_uint(builder, e->stream_index);
+                    vkd3d_key_builder_append_string(builder, e->semantic_name);
+                    vkd3d_key_builder_append_uint(builder, e->semantic_index);
+                    vkd3d_key_builder_append_uint(builder,
+                            e->component_index | e->component_count << 8 | e->output_slot << 16);
+                }
+                vkd3d_key_builder_append_array(builder, xfb_info->buffer_strides,
+                        xfb_info->buffer_stride_count, sizeof(*xfb_info->buffer_strides));
+                break;
+
+            case VKD3D_SHADER_STRUCTURE_TYPE_DESCRIPTOR_OFFSET_INFO:
+                offset_info = (const struct vkd3d_shader_descriptor_offset_info *)info;
+                vkd3d_key_builder_append_uint(builder, offset_info->descriptor_table_offset);
+                vkd3d_key_builder_append_uint(builder, offset_info->descriptor_table_count);
+                vkd3d_key_builder_append_array(builder, offset_info->binding_offsets,
+                        offset_info->binding_offsets ? shader_interface->binding_count : 0,
+                        sizeof(*offset_info->binding_offsets));
+                vkd3d_key_builder_append_array(builder, offset_info->uav_counter_offsets,
+                        offset_info->uav_counter_offsets ? shader_interface->uav_counter_count : 0,
+                        sizeof(*offset_info->uav_counter_offsets));
+                break;
+
+            default:
+                FIXME("Unhandled structure type %#x.\n", info->type);
+                break;
+        }
+    }
+}
+
+static unsigned int vkd3d_shader_stage_compile_options(const struct d3d12_device *device,
+        struct vkd3d_shader_compile_option *options)
+{
+    options[0].name = VKD3D_SHADER_COMPILE_OPTION_API_VERSION;
+    options[0].value = VKD3D_SHADER_API_VERSION_1_7;
+    options[1].name = VKD3D_SHADER_COMPILE_OPTION_TYPED_UAV;
+    options[1].value = typed_uav_compile_option(device);
+    options[2].name = VKD3D_SHADER_COMPILE_OPTION_WRITE_TESS_GEOM_POINT_SIZE;
+    options[2].value = 0;
+
+    return 3;
+}
+static HRESULT vkd3d_key_builder_finish(struct vkd3d_shader_source_key_builder *builder,
+        struct vkd3d_shader_source_key *key)
+{
+    if (builder->failed)
+    {
+        vkd3d_free(builder->data);
+        memset(key, 0, sizeof(*key));
+        return E_OUTOFMEMORY;
+    }
+
+    key->hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, builder->data, builder->size);
+    key->size = builder->size;
+    key->data = builder->data;
+
+    return S_OK;
+}
+
+/* The key data is owned by the caller, and must be freed with vkd3d_free(). */
+static HRESULT vkd3d_shader_source_key_init(struct vkd3d_shader_source_key *key,
+        const struct d3d12_device *device, enum VkShaderStageFlagBits stage,
+        const D3D12_SHADER_BYTECODE *code, const struct vkd3d_shader_interface_info *shader_interface)
+{
+    struct vkd3d_shader_source_key_builder builder = {0};
+    struct vkd3d_shader_compile_option options[3];
+    unsigned int option_count;
+
+    option_count = vkd3d_shader_stage_compile_options(device, options);
+
+    vkd3d_key_builder_append_uint(&builder, stage);
+    vkd3d_key_builder_append_array(&builder, options, option_count, sizeof(*options));
+    vkd3d_key_builder_append(&builder, &code->BytecodeLength, sizeof(code->BytecodeLength));
+    vkd3d_key_builder_append(&builder, code->pShaderBytecode, code->BytecodeLength);
+    vkd3d_key_builder_append_shader_interface(&builder, shader_interface);
+
+    return vkd3d_key_builder_finish(&builder, key);
+}
+
+static void vkd3d_key_builder_append_stencil_op(struct vkd3d_shader_source_key_builder *builder,
+        const D3D12_DEPTH_STENCILOP_DESC *op_desc)
+{
+    vkd3d_key_builder_append_uint(builder, op_desc->StencilFailOp);
+    vkd3d_key_builder_append_uint(builder, op_desc->StencilDepthFailOp);
+    vkd3d_key_builder_append_uint(builder, op_desc->StencilPassOp);
+    vkd3d_key_builder_append_uint(builder, op_desc->StencilFunc);
+}
+
+/* Builds a key from the fixed-function state of a graphics pipeline. Shaders
+ * and the root signature are covered by the shader source keys. Structures
+ * are appended member by member, because some of them contain padding. */
+static HRESULT d3d12_graphics_pipeline_desc_key_init(struct vkd3d_shader_source_key *key,
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC *desc)
+{
+    struct vkd3d_shader_source_key_builder builder = {0};
+    const D3D12_RENDER_TARGET_BLEND_DESC *rt_desc;
+    const D3D12_SO_DECLARATION_ENTRY *so_entry;
+    const D3D12_INPUT_ELEMENT_DESC *element;
+    const D3D12_STREAM_OUTPUT_DESC *so_desc;
+    const D3D12_DEPTH_STENCIL_DESC *ds_desc;
+    const D3D12_RASTERIZER_DESC *rs_desc;
+    unsigned int i;
+
+    so_desc = &desc->StreamOutput;
+    vkd3d_key_builder_append_uint(&builder, so_desc->pSODeclaration ? so_desc->NumEntries : 0);
+    for (i = 0; so_desc->pSODeclaration && i < so_desc->NumEntries; ++i)
+    {
+        so_entry = &so_desc->pSODeclaration[i];
+        vkd3d_key_builder_append_uint(&builder, so_entry->Stream);
+        vkd3d_key_builder_append_string(&builder, so_entry->SemanticName);
+        vkd3d_key_builder_append_uint(&builder, so_entry->SemanticIndex);
+        vkd3d_key_builder_append_uint(&builder, so_entry->StartComponent);
+        vkd3d_key_builder_append_uint(&builder, so_entry->ComponentCount);
+        vkd3d_key_builder_append_uint(&builder, so_entry->OutputSlot);
+    }
+    vkd3d_key_builder_append_array(&builder, so_desc->pBufferStrides,
+            so_desc->pBufferStrides ? so_desc->NumStrides : 0, sizeof(*so_desc->pBufferStrides));
+    vkd3d_key_builder_append_uint(&builder, so_desc->RasterizedStream);
+
+    vkd3d_key_builder_append_uint(&builder, desc->BlendState.AlphaToCoverageEnable);
+    vkd3d_key_builder_append_uint(&builder, desc->BlendState.IndependentBlendEnable);
+    for (i = 0; i < ARRAY_SIZE(desc->BlendState.RenderTarget); ++i)
+    {
+        rt_desc = &desc->BlendState.RenderTarget[i];
+        vkd3d_key_builder_append_uint(&builder, rt_desc->BlendEnable);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->LogicOpEnable);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->SrcBlend);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->DestBlend);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->BlendOp);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->SrcBlendAlpha);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->DestBlendAlpha);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->BlendOpAlpha);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->LogicOp);
+        vkd3d_key_builder_append_uint(&builder, rt_desc->RenderTargetWriteMask);
+    }
+    vkd3d_key_builder_append_uint(&builder, desc->SampleMask);
+
+    rs_desc = &desc->RasterizerState;
+    vkd3d_key_builder_append_uint(&builder, rs_desc->FillMode);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->CullMode);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->FrontCounterClockwise);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->DepthBias);
+    vkd3d_key_builder_append(&builder, &rs_desc->DepthBiasClamp, sizeof(rs_desc->DepthBiasClamp));
+    vkd3d_key_builder_append(&builder, &rs_desc->SlopeScaledDepthBias, sizeof(rs_desc->SlopeScaledDepthBias));
+    vkd3d_key_builder_append_uint(&builder, rs_desc->DepthClipEnable);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->MultisampleEnable);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->AntialiasedLineEnable);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->ForcedSampleCount);
+    vkd3d_key_builder_append_uint(&builder, rs_desc->ConservativeRaster);
+
+    ds_desc = &desc->DepthStencilState;
+    vkd3d_key_builder_append_uint(&builder, ds_desc->DepthEnable);
+    vkd3d_key_builder_append_uint(&builder, ds_desc->DepthWriteMask);
+    vkd3d_key_builder_append_uint(&builder, ds_desc->DepthFunc);
+    vkd3d_key_builder_append_uint(&builder, ds_desc->StencilEnable);
+    vkd3d_key_builder_append_uint(&builder, ds_desc->StencilReadMask);
+    vkd3d_key_builder_append_uint(&builder, ds_desc->StencilWriteMask);
+    vkd3d_key_builder_append_stencil_op(&builder, &ds_desc->FrontFace);
+    vkd3d_key_builder_append_stencil_op(&builder, &ds_desc->BackFace);
+
+    vkd3d_key_builder_append_uint(&builder,
+            desc->InputLayout.pInputElementDescs ? desc->InputLayout.NumElements : 0);
+    for (i = 0; desc->InputLayout.pInputElementDescs && i < desc->InputLayout.NumElements; ++i)
+    {
+        element = &desc->InputLayout.pInputElementDescs[i];
+        vkd3d_key_builder_append_string(&builder, element->SemanticName);
+        vkd3d_key_builder_append_uint(&builder, element->SemanticIndex);
+        vkd3d_key_builder_append_uint(&builder, element->Format);
+        vkd3d_key_builder_append_uint(&builder, element->InputSlot);
+        vkd3d_key_builder_append_uint(&builder, element->AlignedByteOffset);
+        vkd3d_key_builder_append_uint(&builder, element->InputSlotClass);
+        vkd3d_key_builder_append_uint(&builder, element->InstanceDataStepRate);
+    }
+
+    vkd3d_key_builder_append_uint(&builder, desc->IBStripCutValue);
+    vkd3d_key_builder_append_uint(&builder, desc->PrimitiveTopologyType);
+    vkd3d_key_builder_append_array(&builder, desc->RTVFormats,
+            min(desc->NumRenderTargets, ARRAY_SIZE(desc->RTVFormats)), sizeof(*desc->RTVFormats));
+    vkd3d_key_builder_append_uint(&builder, desc->DSVFormat);
+    vkd3d_key_builder_append_uint(&builder, desc->SampleDesc.Count);
+    vkd3d_key_builder_append_uint(&builder, desc->SampleDesc.Quality);
+    vkd3d_key_builder_append_uint(&builder, desc->Flags);
+
+    return vkd3d_key_builder_finish(&builder, key);
+}
+
+static HRESULT vkd3d_shader_stage_compile(const struct d3d12_device *device, const D3D12_SHADER_BYTECODE *code,
+        const struct vkd3d_shader_interface_info *shader_interface, struct vkd3d_shader_code *spirv)
+{
+    struct vkd3d_shader_compile_option options[3];
+    struct vkd3d_shader_compile_info compile_info;
+    int ret;
 
     compile_info.type = VKD3D_SHADER_STRUCTURE_TYPE_COMPILE_INFO;
     compile_info.next = shader_interface;
@@ -1981,29 +2828,187 @@ static HRESULT create_shader_stage(struct d3d12_device *device,
     compile_info.source_type = VKD3D_SHADER_SOURCE_DXBC_TPF;
     compile_info.target_type = VKD3D_SHADER_TARGET_SPIRV_BINARY;
     compile_info.options = options;
-    compile_info.option_count = ARRAY_SIZE(options);
+    compile_info.option_count = vkd3d_shader_stage_compile_options(device, options);
     compile_info.log_level = VKD3D_SHADER_LOG_NONE;
     compile_info.source_name = NULL;
 
-    if ((ret = vkd3d_shader_compile(&compile_info, &spirv, NULL)) < 0)
+    if ((ret = vkd3d_shader_compile(&compile_info, spirv, NULL)) < 0)
     {
         WARN("Failed to compile shader, vkd3d result %d.\n", ret);
         return hresult_from_vkd3d_result(ret);
     }
-    shader_desc.codeSize = spirv.size;
-    shader_desc.pCode = spirv.code;
 
-    vr = VK_CALL(vkCreateShaderModule(device->vk_device, &shader_desc, NULL, &stage_desc->module));
-    vkd3d_shader_free_shader_code(&spirv);
-    if (vr < 0)
+    return S_OK;
+}
+
+static HRESULT vkd3d_shader_stage_create_module(struct d3d12_device *device,
+        struct VkPipelineShaderStageCreateInfo *stage_desc, const struct vkd3d_shader_code *spirv)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct VkShaderModuleCreateInfo shader_desc;
+    VkResult vr;
+
+    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_desc.pNext = NULL;
+    shader_desc.flags = 0;
+    shader_desc.codeSize = spirv->size;
+    shader_desc.pCode = spirv->code;
+
+    if ((vr = VK_CALL(vkCreateShaderModule(device->vk_device, &shader_desc, NULL, &stage_desc->module))) < 0)
     {
         WARN("Failed to create Vulkan shader module, vr %d.\n", vr);
+        stage_desc->module = VK_NULL_HANDLE;
         return hresult_from_vk_result(vr);
     }
 
     return S_OK;
 }
 
+struct d3d12_pipeline_compile_stage
+{
+    VkPipelineShaderStageCreateInfo *stage_desc;
+    unsigned int code_index;
+    struct vkd3d_shader_source_key source_key;
+    D3D12_SHADER_BYTECODE code;
+
+    bool has_interface;
+    struct vkd3d_shader_interface_info shader_interface;
+    struct vkd3d_shader_descriptor_offset_info offset_info;
+    struct vkd3d_shader_spirv_target_info target_info;
+    struct vkd3d_shader_parameter parameters[1];
+    unsigned int output_swizzles[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+};
+
+/* Shader translation deferred to the device pipeline compiler. The job owns
+ * copies of the bytecode and of the shader interface chain. Arrays in the
+ * chain come from the root signature, which the job keeps a reference to,
+ * from the pipeline state itself, or from the device. */
+struct d3d12_pipeline_compile_job
+{
+    struct list entry;
+    bool started;
+    /* A job which failed on a compiler thread runs once more on the thread
+     * which first waits for it. */
+    bool is_retry;
+
+    struct d3d12_pipeline_state *state;
+    ID3D12RootSignature *root_signature;
+
+    struct d3d12_pipeline_compile_stage stages[VKD3D_MAX_SHADER_STAGES];
+    unsigned int stage_count;
+
+    /* Compute pipelines are created once their shader module exists. */
+    VkComputePipelineCreateInfo compute_info;
+};
+
+static struct d3d12_pipeline_compile_job *d3d12_pipeline_compile_job_create(struct d3d12_pipeline_state *state,
+        struct d3d12_device *device, ID3D12RootSignature *root_signature)
+{
+    struct d3d12_pipeline_compile_job *job;
+
+    if (!device->pipeline_compiler.thread_count)
+        return NULL;
+
+    if (!(job = vkd3d_calloc(1, sizeof(*job))))
+        return NULL;
+
+    job->state = state;
+    ID3D12RootSignature_AddRef(job->root_signature = root_signature);
+
+    return job;
+}
+
+static void d3d12_pipeline_compile_job_destroy(struct d3d12_pipeline_compile_job *job)
+{
+    unsigned int i;
+
+    if (!job)
+        return;
+
+    for (i = 0; i < job->stage_count; ++i)
+    {
+        vkd3d_free((void *)job->stages[i].source_key.data);
+        vkd3d_free((void *)job->stages[i].code.pShaderBytecode);
+    }
+    ID3D12RootSignature_Release(job->root_signature);
+    vkd3d_free(job);
+}
+
+static bool d3d12_pipeline_compile_job_add_stage(struct d3d12_pipeline_compile_job *job,
+        VkPipelineShaderStageCreateInfo *stage_desc, unsigned int code_index,
+        struct vkd3d_shader_source_key *source_key, const D3D12_SHADER_BYTECODE *code,
+        const struct vkd3d_shader_interface_info *shader_interface)
+{
+    const struct vkd3d_shader_spirv_target_info *target_info;
+    struct d3d12_pipeline_compile_stage *stage;
+    const struct
+    {
+        enum vkd3d_shader_structure_type type;
+        const void *next;
+    } *info;
+    void *bytecode;
+
+    assert(job->stage_count < ARRAY_SIZE(job->stages));
+    stage = &job->stages[job->stage_count];
+    memset(stage, 0, sizeof(*stage));
+
+    if ((stage->has_interface = !!shader_interface))
+    {
+        stage->shader_interface = *shader_interface;
+        stage->shader_interface.next = NULL;
+
+        for (info = shader_interface->next; info; info = info->next)
+        {
+            switch (info->type)
+            {
+                case VKD3D_SHADER_STRUCTURE_TYPE_DESCRIPTOR_OFFSET_INFO:
+                    stage->offset_info = *(const struct vkd3d_shader_descriptor_offset_info *)info;
+                    stage->offset_info.next = NULL;
+                    vkd3d_prepend_struct(&stage->shader_interface, &stage->offset_info);
+                    break;
+
+                case VKD3D_SHADER_STRUCTURE_TYPE_SPIRV_TARGET_INFO:
+                    target_info = (const struct vkd3d_shader_spirv_target_info *)info;
+                    if (target_info->parameter_count > ARRAY_SIZE(stage->parameters)
+                            || target_info->output_swizzle_count > ARRAY_SIZE(stage->output_swizzles))
+                        return false;
+                    stage->target_info = *target_info;
+                    stage->target_info.next = NULL;
+                    if (target_info->parameter_count)
+                        memcpy(stage->parameters, target_info->parameters,
+                                target_info->parameter_count * sizeof(*stage->parameters));
+                    if (target_info->output_swizzle_count)
+                        memcpy(stage->output_swizzles, target_info->output_swizzles,
+                                target_info->output_swizzle_count * sizeof(*stage->output_swizzles));
+                    stage->target_info.parameters = stage->parameters;
+                    stage->target_info.output_swizzles = stage->output_swizzles;
+                    vkd3d_prepend_struct(&stage->shader_interface, &stage->target_info);
+                    break;
+
+                default:
+                    /* Stream output declarations are owned by the application,
+                     * translate these shaders immediately. */
+                    return false;
+            }
+        }
+    }
+
+    if (!(bytecode = vkd3d_malloc(code->BytecodeLength)))
+        return false;
+    memcpy(bytecode, code->pShaderBytecode, code->BytecodeLength);
+
+    stage->stage_desc = stage_desc;
+    stage->code_index = code_index;
+    /* The job takes ownership of the key. */
+    stage->source_key = *source_key;
+    source_key->data = NULL;
+    stage->code.pShaderBytecode = bytecode;
+    stage->code.BytecodeLength = code->BytecodeLength;
+    ++job->stage_count;
+
+    return true;
+}
+
 static int vkd3d_scan_dxbc(const struct d3d12_device *device, const D3D12_SHADER_BYTECODE *code,
         struct vkd3d_shader_scan_descriptor_info *descriptor_info)
 {
@@ -2029,64 +3034,469 @@ static int vkd3d_scan_dxbc(const struct d3d12_device *device, const D3D12_SHADER
     return vkd3d_shader_scan(&compile_info, NULL);
 }
 
-static HRESULT vkd3d_create_compute_pipeline(struct d3d12_device *device,
+static HRESULT create_shader_stage(struct d3d12_device *device,
+        struct VkPipelineShaderStageCreateInfo *stage_desc, enum VkShaderStageFlagBits stage,
         const D3D12_SHADER_BYTECODE *code, const struct vkd3d_shader_interface_info *shader_interface,
-        VkPipelineLayout vk_pipeline_layout, VkPipeline *vk_pipeline)
+        struct d3d12_pipeline_state *state, const struct d3d12_cached_pso *cached_pso,
+        struct d3d12_pipeline_compile_job *job)
 {
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    VkComputePipelineCreateInfo pipeline_info;
-    VkResult vr;
+    struct vkd3d_shader_code spirv = {0}, compiled_spirv = {0};
+    struct vkd3d_shader_cache_entry *cache_entry = NULL;
+    struct vkd3d_shader_source_key source_key = {0};
     HRESULT hr;
 
-    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    pipeline_info.pNext = NULL;
-    pipeline_info.flags = 0;
-    if (FAILED(hr = create_shader_stage(device, &pipeline_info.stage,
-            VK_SHADER_STAGE_COMPUTE_BIT, code, shader_interface)))
-        return hr;
-    pipeline_info.layout = vk_pipeline_layout;
-    pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
-    pipeline_info.basePipelineIndex = -1;
+    stage_desc->sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stage_desc->pNext = NULL;
+    stage_desc->flags = 0;
+    stage_desc->stage = stage;
+    stage_desc->module = VK_NULL_HANDLE;
+    stage_desc->pName = "main";
+    stage_desc->pSpecializationInfo = NULL;
 
-    vr = VK_CALL(vkCreateComputePipelines(device->vk_device,
-            VK_NULL_HANDLE, 1, &pipeline_info, NULL, vk_pipeline));
-    VK_CALL(vkDestroyShaderModule(device->vk_device, pipeline_info.stage.module, NULL));
-    if (vr < 0)
+    if (state)
     {
-        WARN("Failed to create Vulkan compute pipeline, hr %#x.\n", hr);
-        return hresult_from_vk_result(vr);
-    }
-
-    return S_OK;
-}
+        if (FAILED(hr = vkd3d_shader_source_key_init(&source_key, device, stage, code, shader_interface)))
+            return hr;
 
-static HRESULT d3d12_pipeline_state_init_uav_counters(struct d3d12_pipeline_state *state,
-        struct d3d12_device *device, const struct d3d12_root_signature *root_signature,
-        const struct vkd3d_shader_scan_descriptor_info *shader_info, VkShaderStageFlags stage_flags)
-{
-    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
-    VkDescriptorSetLayout set_layouts[VKD3D_MAX_DESCRIPTOR_SETS + 1];
-    VkDescriptorSetLayoutBinding *binding_desc;
-    uint32_t set_index, descriptor_binding;
-    unsigned int uav_counter_count = 0;
-    unsigned int i, j;
-    HRESULT hr;
+        /* The description must match the one the blob was created from. */
+        if (cached_pso && cached_pso->stage_count
+                && !d3d12_cached_pso_find_stage(cached_pso, stage, &source_key, &spirv))
+        {
+            WARN("Cached pipeline state blob doesn't match shader stage %#x.\n", stage);
+            vkd3d_free((void *)source_key.data);
+            return E_INVALIDARG;
+        }
 
-    assert(vkd3d_popcount(stage_flags) == 1);
+        cache_entry = vkd3d_shader_cache_get(&device->shader_cache, &source_key);
+    }
 
-    for (i = 0; i < shader_info->descriptor_count; ++i)
+    if (cache_entry)
     {
-        const struct vkd3d_shader_descriptor_info *d = &shader_info->descriptors[i];
-
-        if (d->type == VKD3D_SHADER_DESCRIPTOR_TYPE_UAV
-                && (d->flags & VKD3D_SHADER_DESCRIPTOR_INFO_FLAG_UAV_COUNTER))
-            ++uav_counter_count;
+        TRACE("Using SPIR-V from the shader cache for shader stage %#x.\n", stage);
     }
-
-    if (!uav_counter_count)
-        return S_OK;
-
-    /* It should be possible to support other stages in Vulkan, but in a graphics pipeline
+    else if (spirv.code)
+    {
+        TRACE("Using cached SPIR-V for shader stage %#x.\n", stage);
+    }
+    else
+    {
+        /* Invalid bytecode is the usual reason for translation to fail.
+         * Translate such shaders now, so that creation fails as it would
+         * without a pipeline compiler. */
+        if (job && vkd3d_scan_dxbc(device, code, NULL) >= 0 && d3d12_pipeline_compile_job_add_stage(job,
+                stage_desc, state->stage_code_count, &source_key, code, shader_interface))
+        {
+            TRACE("Deferring translation of shader stage %#x.\n", stage);
+            assert(state->stage_code_count < ARRAY_SIZE(state->stage_code));
+            state->stage_code[state->stage_code_count++] = NULL;
+            return S_OK;
+        }
+
+        if (FAILED(hr = vkd3d_shader_stage_compile(device, code, shader_interface, &compiled_spirv)))
+        {
+            vkd3d_free((void *)source_key.data);
+            return hr;
+        }
+        spirv = compiled_spirv;
+    }
+
+    if (state && !cache_entry)
+    {
+        cache_entry = vkd3d_shader_cache_entry_create(stage, &source_key, &spirv);
+        vkd3d_free((void *)source_key.data);
+        if (!cache_entry)
+        {
+            vkd3d_shader_free_shader_code(&compiled_spirv);
+            return E_OUTOFMEMORY;
+        }
+        vkd3d_shader_cache_put(&device->shader_cache, cache_entry);
+    }
+    else
+    {
+        vkd3d_free((void *)source_key.data);
+    }
+    if (cache_entry)
+        spirv = cache_entry->spirv;
+
+    hr = vkd3d_shader_stage_create_module(device, stage_desc, &spirv);
+    vkd3d_shader_free_shader_code(&compiled_spirv);
+    if (FAILED(hr))
+    {
+        if (cache_entry)
+            vkd3d_shader_cache_entry_decref(cache_entry);
+        return hr;
+    }
+
+    if (state)
+    {
+        assert(state->stage_code_count < ARRAY_SIZE(state->stage_code));
+        state->stage_code[state->stage_code_count++] = cache_entry;
+    }
+
+    return S_OK;
+}
+
+static HRESULT vkd3d_create_compute_pipeline_from_info(struct d3d12_device *device,
+        const struct d3d12_pipeline_state *state, const VkComputePipelineCreateInfo *pipeline_info,
+        VkPipeline *vk_pipeline)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkResult vr;
+
+    vr = VK_CALL(vkCreateComputePipelines(device->vk_device,
+            device->vk_pipeline_cache, 1, pipeline_info, NULL, vk_pipeline));
+    VK_CALL(vkDestroyShaderModule(device->vk_device, pipeline_info->stage.module, NULL));
+    if (vr < 0)
+    {
+        WARN("Failed to create Vulkan compute pipeline, vr %d.\n", vr);
+        *vk_pipeline = VK_NULL_HANDLE;
+        return hresult_from_vk_result(vr);
+    }
+
+    return S_OK;
+}
+
+static HRESULT vkd3d_create_compute_pipeline(struct d3d12_device *device,
+        const D3D12_SHADER_BYTECODE *code, const struct vkd3d_shader_interface_info *shader_interface,
+        VkPipelineLayout vk_pipeline_layout, struct d3d12_pipeline_state *state,
+        const struct d3d12_cached_pso *cached_pso, struct d3d12_pipeline_compile_job *job, VkPipeline *vk_pipeline)
+{
+    VkComputePipelineCreateInfo local_pipeline_info, *pipeline_info;
+    HRESULT hr;
+
+    pipeline_info = job ? &job->compute_info : &local_pipeline_info;
+    pipeline_info->sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info->pNext = NULL;
+    pipeline_info->flags = 0;
+#ifdef VK_EXT_descriptor_buffer
+    /* Internal pipelines without a state object use regular descriptor sets. */
+    if (state && device->use_descriptor_buffers)
+        pipeline_info->flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+#endif
+    if (FAILED(hr = create_shader_stage(device, &pipeline_info->stage,
+            VK_SHADER_STAGE_COMPUTE_BIT, code, shader_interface, state, cached_pso, job)))
+        return hr;
+    pipeline_info->layout = vk_pipeline_layout;
+    pipeline_info->basePipelineHandle = VK_NULL_HANDLE;
+    pipeline_info->basePipelineIndex = -1;
+
+    /* The pipeline is created by the pipeline compiler if translation was deferred. */
+    *vk_pipeline = VK_NULL_HANDLE;
+    if (!pipeline_info->stage.module)
+        return S_OK;
+
+    return vkd3d_create_compute_pipeline_from_info(device, state, pipeline_info, vk_pipeline);
+}
+
+static HRESULT d3d12_pipeline_compile_stage_execute(struct d3d12_pipeline_compile_stage *stage,
+        struct d3d12_pipeline_state *state, struct d3d12_device *device)
+{
+    struct vkd3d_shader_cache_entry *cache_entry;
+    struct vkd3d_shader_code spirv;
+    HRESULT hr;
+
+    /* Another pipeline state may have translated the same shader meanwhile. */
+    if (!(cache_entry = vkd3d_shader_cache_get(&device->shader_cache, &stage->source_key)))
+    {
+        if (FAILED(hr = vkd3d_shader_stage_compile(device, &stage->code,
+                stage->has_interface ? &stage->shader_interface : NULL, &spirv)))
+            return hr;
+
+        cache_entry = vkd3d_shader_cache_entry_create(stage->stage_desc->stage, &stage->source_key, &spirv);
+        vkd3d_shader_free_shader_code(&spirv);
+        if (!cache_entry)
+            return E_OUTOFMEMORY;
+        vkd3d_shader_cache_put(&device->shader_cache, cache_entry);
+    }
+    state->stage_code[stage->code_index] = cache_entry;
+
+    return vkd3d_shader_stage_create_module(device, stage->stage_desc, &cache_entry->spirv);
+}
+
+static HRESULT d3d12_pipeline_compile_job_execute(struct d3d12_pipeline_compile_job *job,
+        struct d3d12_device *device)
+{
+    struct d3d12_pipeline_state *state = job->state;
+    unsigned int i;
+    HRESULT hr;
+
+    for (i = 0; i < job->stage_count; ++i)
+    {
+        if (FAILED(hr = d3d12_pipeline_compile_stage_execute(&job->stages[i], state, device)))
+            return hr;
+    }
+
+    if (d3d12_pipeline_state_is_compute(state))
+    {
+        hr = vkd3d_create_compute_pipeline_from_info(device, state,
+                &job->compute_info, &state->u.compute.vk_pipeline);
+        /* The module is destroyed in any case. */
+        job->compute_info.stage.module = VK_NULL_HANDLE;
+        return hr;
+    }
+
+    return S_OK;
+}
+
+/* Releases the partial results of a failed job, so that it can run again. */
+static void d3d12_pipeline_compile_job_reset(struct d3d12_pipeline_compile_job *job,
+        struct d3d12_device *device)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    struct d3d12_pipeline_state *state = job->state;
+    struct d3d12_pipeline_compile_stage *stage;
+    unsigned int i;
+
+    for (i = 0; i < job->stage_count; ++i)
+    {
+        stage = &job->stages[i];
+        VK_CALL(vkDestroyShaderModule(device->vk_device, stage->stage_desc->module, NULL));
+        stage->stage_desc->module = VK_NULL_HANDLE;
+        if (state->stage_code[stage->code_index])
+        {
+            vkd3d_shader_cache_entry_decref(state->stage_code[stage->code_index]);
+            state->stage_code[stage->code_index] = NULL;
+        }
+    }
+}
+
+static void vkd3d_pipeline_compiler_run_job(struct vkd3d_pipeline_compiler *compiler,
+        struct d3d12_pipeline_compile_job *job)
+{
+    struct d3d12_pipeline_state *state = job->state;
+    HRESULT hr;
+
+    TRACE("Compiling pipeline state %p.\n", state);
+
+    if (FAILED(hr = d3d12_pipeline_compile_job_execute(job, compiler->device)))
+    {
+        d3d12_pipeline_compile_job_reset(job, compiler->device);
+
+        /* Creating the pipeline state synchronously would not have failed
+         * because of e.g. a transient allocation failure on another thread.
+         * Give the job another chance before reporting the error. */
+        if (!job->is_retry)
+        {
+            WARN("Failed to compile pipeline state %p, hr %#x, retrying on first use.\n", state, hr);
+
+            vkd3d_mutex_lock(&compiler->mutex);
+            job->is_retry = true;
+            job->started = false;
+            list_init(&job->entry);
+            vkd3d_cond_broadcast(&compiler->done_cond);
+            vkd3d_mutex_unlock(&compiler->mutex);
+            return;
+        }
+
+        ERR("Failed to compile pipeline state %p, hr %#x.\n", state, hr);
+    }
+
+    vkd3d_mutex_lock(&compiler->mutex);
+    state->compile_hr = hr;
+    state->compile_job = NULL;
+    InterlockedDecrement(&state->compile_pending);
+    vkd3d_cond_broadcast(&compiler->done_cond);
+    vkd3d_mutex_unlock(&compiler->mutex);
+
+    d3d12_pipeline_compile_job_destroy(job);
+}
+
+static void vkd3d_pipeline_compiler_submit(struct vkd3d_pipeline_compiler *compiler,
+        struct d3d12_pipeline_compile_job *job)
+{
+    struct d3d12_pipeline_state *state = job->state;
+
+    vkd3d_mutex_lock(&compiler->mutex);
+    state->compile_job = job;
+    InterlockedIncrement(&state->compile_pending);
+    list_add_tail(&compiler->jobs, &job->entry);
+    vkd3d_cond_signal(&compiler->cond);
+    vkd3d_mutex_unlock(&compiler->mutex);
+}
+
+static void *vkd3d_pipeline_compiler_main(void *arg)
+{
+    struct vkd3d_pipeline_compiler *compiler = arg;
+    struct d3d12_pipeline_compile_job *job;
+
+    vkd3d_set_thread_name("vkd3d_compiler");
+
+    vkd3d_mutex_lock(&compiler->mutex);
+
+    for (;;)
+    {
+        while (list_empty(&compiler->jobs) && !compiler->should_exit)
+            vkd3d_cond_wait(&compiler->cond, &compiler->mutex);
+
+        if (compiler->should_exit)
+            break;
+
+        job = LIST_ENTRY(list_head(&compiler->jobs), struct d3d12_pipeline_compile_job, entry);
+        list_remove(&job->entry);
+        job->started = true;
+
+        vkd3d_mutex_unlock(&compiler->mutex);
+        vkd3d_pipeline_compiler_run_job(compiler, job);
+        vkd3d_mutex_lock(&compiler->mutex);
+    }
+
+    vkd3d_mutex_unlock(&compiler->mutex);
+
+    return NULL;
+}
+
+void vkd3d_pipeline_compiler_init(struct vkd3d_pipeline_compiler *compiler, struct d3d12_device *device)
+{
+    unsigned int i, thread_count;
+    HRESULT hr;
+
+    vkd3d_mutex_init(&compiler->mutex);
+    vkd3d_cond_init(&compiler->cond);
+    vkd3d_cond_init(&compiler->done_cond);
+    list_init(&compiler->jobs);
+    compiler->should_exit = false;
+    compiler->threads = NULL;
+    compiler->thread_count = 0;
+    compiler->device = device;
+
+    if (!(thread_count = vkd3d_env_var_as_uint("VKD3D_PIPELINE_COMPILER_THREADS", 0)))
+        return;
+    thread_count = min(thread_count, VKD3D_MAX_PIPELINE_COMPILER_THREADS);
+
+    if (!(compiler->threads = vkd3d_calloc(thread_count, sizeof(*compiler->threads))))
+        return;
+
+    for (i = 0; i < thread_count; ++i)
+    {
+        if (FAILED(hr = vkd3d_create_thread(device->vkd3d_instance,
+                vkd3d_pipeline_compiler_main, compiler, &compiler->threads[i])))
+        {
+            WARN("Failed to create pipeline compiler thread, hr %#x.\n", hr);
+            break;
+        }
+    }
+    compiler->thread_count = i;
+
+    TRACE("Using %u pipeline compiler threads.\n", compiler->thread_count);
+}
+
+void vkd3d_pipeline_compiler_cleanup(struct vkd3d_pipeline_compiler *compiler, struct d3d12_device *device)
+{
+    unsigned int i;
+    HRESULT hr;
+
+    /* Pipeline states hold a device reference, so the queue is empty. */
+    assert(list_empty(&compiler->jobs));
+
+    vkd3d_mutex_lock(&compiler->mutex);
+    compiler->should_exit = true;
+    vkd3d_cond_broadcast(&compiler->cond);
+    vkd3d_mutex_unlock(&compiler->mutex);
+
+    for (i = 0; i < compiler->thread_count; ++i)
+    {
+        if (FAILED(hr = vkd3d_join_thread(device->vkd3d_instance, &compiler->threads[i])))
+            ERR("Failed to join pipeline compiler thread, hr %#x.\n", hr);
+    }
+    vkd3d_free(compiler->threads);
+
+    vkd3d_cond_destroy(&compiler->done_cond);
+    vkd3d_cond_destroy(&compiler->cond);
+    vkd3d_mutex_destroy(&compiler->mutex);
+}
+
+/* Waits for background compilation of "state" to finish. A job which no
+ * compiler thread picked up yet runs on the calling thread, or is dropped if
+ * "cancel" is set. */
+static HRESULT d3d12_pipeline_state_finish_compile(struct d3d12_pipeline_state *state, bool cancel)
+{
+    struct vkd3d_pipeline_compiler *compiler = &state->device->pipeline_compiler;
+    struct d3d12_pipeline_compile_job *job;
+
+    if (!InterlockedAdd(&state->compile_pending, 0))
+        return state->compile_hr;
+
+    vkd3d_mutex_lock(&compiler->mutex);
+
+    while ((job = state->compile_job))
+    {
+        if (job->started)
+        {
+            vkd3d_cond_wait(&compiler->done_cond, &compiler->mutex);
+            continue;
+        }
+
+        /* Jobs waiting for a retry aren't queued, and their entry is empty. */
+        list_remove(&job->entry);
+        job->started = true;
+        if (cancel)
+        {
+            state->compile_hr = E_ABORT;
+            state->compile_job = NULL;
+            InterlockedDecrement(&state->compile_pending);
+        }
+        vkd3d_mutex_unlock(&compiler->mutex);
+
+        if (cancel)
+        {
+            d3d12_pipeline_compile_job_destroy(job);
+        }
+        else
+        {
+            /* As with synchronous creation, a failure on this thread is final. */
+            job->is_retry = true;
+            vkd3d_pipeline_compiler_run_job(compiler, job);
+        }
+
+        return state->compile_hr;
+    }
+
+    vkd3d_mutex_unlock(&compiler->mutex);
+
+    return state->compile_hr;
+}
+
+HRESULT d3d12_pipeline_state_wait(struct d3d12_pipeline_state *state)
+{
+    return d3d12_pipeline_state_finish_compile(state, false);
+}
+
+static void d3d12_pipeline_state_submit_compile(struct d3d12_pipeline_state *state,
+        struct d3d12_pipeline_compile_job *job)
+{
+    if (job && job->stage_count)
+        vkd3d_pipeline_compiler_submit(&state->device->pipeline_compiler, job);
+    else
+        d3d12_pipeline_compile_job_destroy(job);
+}
+
+static HRESULT d3d12_pipeline_state_init_uav_counters(struct d3d12_pipeline_state *state,
+        struct d3d12_device *device, const struct d3d12_root_signature *root_signature,
+        const struct vkd3d_shader_scan_descriptor_info *shader_info, VkShaderStageFlags stage_flags)
+{
+    const struct vkd3d_vk_device_procs *vk_procs = &device->vk_procs;
+    VkDescriptorSetLayout set_layouts[VKD3D_MAX_DESCRIPTOR_SETS + 1];
+    VkDescriptorSetLayoutBinding *binding_desc;
+    uint32_t set_index, descriptor_binding;
+    unsigned int uav_counter_count = 0;
+    unsigned int i, j;
+    HRESULT hr;
+
+    assert(vkd3d_popcount(stage_flags) == 1);
+
+    for (i = 0; i < shader_info->descriptor_count; ++i)
+    {
+        const struct vkd3d_shader_descriptor_info *d = &shader_info->descriptors[i];
+
+        if (d->type == VKD3D_SHADER_DESCRIPTOR_TYPE_UAV
+                && (d->flags & VKD3D_SHADER_DESCRIPTOR_INFO_FLAG_UAV_COUNTER))
+            ++uav_counter_count;
+    }
+
+    if (!uav_counter_count)
+        return S_OK;
+
+    /* It should be possible to support other stages in Vulkan, but in a graphics pipeline
      * D3D12 currently only supports counters in pixel shaders, and handling multiple stages
      * would be more complex. */
     if (!(stage_flags & (VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT)))
@@ -2197,12 +3607,17 @@ static HRESULT d3d12_pipeline_state_init_compute(struct d3d12_pipeline_state *st
     const struct d3d12_root_signature *root_signature;
     struct vkd3d_shader_spirv_target_info target_info;
     VkPipelineLayout vk_pipeline_layout;
+    struct d3d12_pipeline_compile_job *job;
+    struct d3d12_cached_pso cached_pso;
     HRESULT hr;
 
     state->ID3D12PipelineState_iface.lpVtbl = &d3d12_pipeline_state_vtbl;
     state->refcount = 1;
 
     memset(&state->uav_counters, 0, sizeof(state->uav_counters));
+    state->compile_job = NULL;
+    state->compile_pending = 0;
+    state->compile_hr = S_OK;
 
     if (!(root_signature = unsafe_impl_from_ID3D12RootSignature(desc->pRootSignature)))
     {
@@ -2214,6 +3629,15 @@ static HRESULT d3d12_pipeline_state_init_compute(struct d3d12_pipeline_state *st
             &desc->CS, VK_SHADER_STAGE_COMPUTE_BIT)))
         return hr;
 
+    state->root_signature_hash = root_signature->hash;
+    state->stage_code_count = 0;
+    memset(&state->desc_key, 0, sizeof(state->desc_key));
+    if (FAILED(hr = d3d12_cached_pso_init(&cached_pso, device, &desc->CachedPSO, &state->desc_key)))
+    {
+        d3d12_pipeline_uav_counter_state_cleanup(&state->uav_counters, device);
+        return hr;
+    }
+
     memset(&target_info, 0, sizeof(target_info));
     target_info.type = VKD3D_SHADER_STRUCTURE_TYPE_SPIRV_TARGET_INFO;
     target_info.environment = VKD3D_SHADER_SPIRV_ENVIRONMENT_VULKAN_1_0;
@@ -2252,24 +3676,31 @@ static HRESULT d3d12_pipeline_state_init_compute(struct d3d12_pipeline_state *st
 
     vk_pipeline_layout = state->uav_counters.vk_pipeline_layout
             ? state->uav_counters.vk_pipeline_layout : root_signature->vk_pipeline_layout;
+    job = d3d12_pipeline_compile_job_create(state, device, desc->pRootSignature);
     if (FAILED(hr = vkd3d_create_compute_pipeline(device, &desc->CS, &shader_interface,
-            vk_pipeline_layout, &state->u.compute.vk_pipeline)))
+            vk_pipeline_layout, state, &cached_pso, job, &state->u.compute.vk_pipeline)))
     {
         WARN("Failed to create Vulkan compute pipeline, hr %#x.\n", hr);
+        d3d12_pipeline_compile_job_destroy(job);
         d3d12_pipeline_uav_counter_state_cleanup(&state->uav_counters, device);
+        d3d12_pipeline_state_cleanup_stage_code(state);
         return hr;
     }
 
     if (FAILED(hr = vkd3d_private_store_init(&state->private_store)))
     {
+        d3d12_pipeline_compile_job_destroy(job);
         VK_CALL(vkDestroyPipeline(device->vk_device, state->u.compute.vk_pipeline, NULL));
         d3d12_pipeline_uav_counter_state_cleanup(&state->uav_counters, device);
+        d3d12_pipeline_state_cleanup_stage_code(state);
         return hr;
     }
 
     state->vk_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
     d3d12_device_add_ref(state->device = device);
 
+    d3d12_pipeline_state_submit_compile(state, job);
+
     return S_OK;
 }
 
@@ -2652,7 +4083,7 @@ STATIC_ASSERT(sizeof(struct vkd3d_shader_transform_feedback_element) == sizeof(D
 
 static HRESULT d3d12_graphics_pipeline_state_create_render_pass(
         struct d3d12_graphics_pipeline_state *graphics, struct d3d12_device *device,
-        VkFormat dynamic_dsv_format, VkRenderPass *vk_render_pass)
+        VkFormat dynamic_dsv_format, uint32_t clear_mask, uint32_t discard_mask, VkRenderPass *vk_render_pass)
 {
     struct vkd3d_render_pass_key key;
     VkFormat dsv_format;
@@ -2687,6 +4118,8 @@ static HRESULT d3d12_graphics_pipeline_state_create_render_pass(
 
     key.padding = 0;
     key.sample_count = graphics->ms_desc.rasterizationSamples;
+    key.clear_mask = clear_mask;
+    key.discard_mask = discard_mask;
 
     return vkd3d_render_pass_cache_find(&device->render_pass_cache, device, &key, vk_render_pass);
 }
@@ -2754,6 +4187,8 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
     const struct d3d12_root_signature *root_signature;
     struct vkd3d_shader_signature input_signature;
     bool have_attachment, is_dsv_format_unknown;
+    struct d3d12_pipeline_compile_job *job = NULL;
+    struct d3d12_cached_pso cached_pso;
     VkShaderStageFlagBits xfb_stage = 0;
     VkSampleCountFlagBits sample_count;
     const struct vkd3d_format *format;
@@ -2795,6 +4230,9 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
 
     memset(&state->uav_counters, 0, sizeof(state->uav_counters));
     graphics->stage_count = 0;
+    state->compile_job = NULL;
+    state->compile_pending = 0;
+    state->compile_hr = S_OK;
 
     memset(&input_signature, 0, sizeof(input_signature));
 
@@ -2813,6 +4251,17 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
         return E_INVALIDARG;
     }
 
+    state->root_signature_hash = root_signature->hash;
+    state->stage_code_count = 0;
+    if (FAILED(hr = d3d12_graphics_pipeline_desc_key_init(&state->desc_key, desc)))
+        return hr;
+    if (FAILED(hr = d3d12_cached_pso_init(&cached_pso, device, &desc->CachedPSO, &state->desc_key)))
+    {
+        vkd3d_free(state->desc_key.data);
+        return hr;
+    }
+    job = d3d12_pipeline_compile_job_create(state, device, desc->pRootSignature);
+
     sample_count = vk_samples_from_dxgi_sample_desc(&desc->SampleDesc);
     if (desc->SampleDesc.Count != 1 && desc->SampleDesc.Quality)
         WARN("Ignoring sample quality %u.\n", desc->SampleDesc.Quality);
@@ -2912,7 +4361,7 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
         if (!desc->PS.pShaderBytecode)
         {
             if (FAILED(hr = create_shader_stage(device, &graphics->stages[graphics->stage_count],
-                    VK_SHADER_STAGE_FRAGMENT_BIT, &default_ps, NULL)))
+                    VK_SHADER_STAGE_FRAGMENT_BIT, &default_ps, NULL, state, &cached_pso, job)))
                 goto fail;
 
             ++graphics->stage_count;
@@ -3078,12 +4527,20 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
             vkd3d_prepend_struct(&shader_interface, &offset_info);
 
         if (FAILED(hr = create_shader_stage(device, &graphics->stages[graphics->stage_count],
-                shader_stages[i].stage, b, &shader_interface)))
+                shader_stages[i].stage, b, &shader_interface, state, &cached_pso, job)))
             goto fail;
 
         ++graphics->stage_count;
     }
 
+    if (cached_pso.stage_count && cached_pso.stage_count != state->stage_code_count)
+    {
+        WARN("Cached pipeline state blob has %u stages, expected %u.\n",
+                cached_pso.stage_count, state->stage_code_count);
+        hr = E_INVALIDARG;
+        goto fail;
+    }
+
     graphics->attribute_count = desc->InputLayout.NumElements;
     if (graphics->attribute_count > ARRAY_SIZE(graphics->attributes))
     {
@@ -3237,12 +4694,12 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
     if (is_dsv_format_unknown)
         graphics->render_pass = VK_NULL_HANDLE;
     else if (FAILED(hr = d3d12_graphics_pipeline_state_create_render_pass(graphics,
-            device, 0, &graphics->render_pass)))
+            device, 0, 0, 0, &graphics->render_pass)))
         goto fail;
 
     graphics->root_signature = root_signature;
 
-    list_init(&graphics->compiled_pipelines);
+    memset((void *)graphics->compiled_pipelines, 0, sizeof(graphics->compiled_pipelines));
 
     if (FAILED(hr = vkd3d_private_store_init(&state->private_store)))
         goto fail;
@@ -3250,9 +4707,12 @@ static HRESULT d3d12_pipeline_state_init_graphics(struct d3d12_pipeline_state *s
     state->vk_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
     d3d12_device_add_ref(state->device = device);
 
+    d3d12_pipeline_state_submit_compile(state, job);
+
     return S_OK;
 
 fail:
+    d3d12_pipeline_compile_job_destroy(job);
     for (i = 0; i < graphics->stage_count; ++i)
     {
         VK_CALL(vkDestroyShaderModule(device->vk_device, state->u.graphics.stages[i].module, NULL));
@@ -3260,6 +4720,8 @@ fail:
     vkd3d_shader_free_shader_signature(&input_signature);
 
     d3d12_pipeline_uav_counter_state_cleanup(&state->uav_counters, device);
+    d3d12_pipeline_state_cleanup_stage_code(state);
+    vkd3d_free(state->desc_key.data);
 
     return hr;
 }
@@ -3358,64 +4820,74 @@ static bool vk_topology_can_restart(VkPrimitiveTopology topology)
     }
 }
 
-static VkPipeline d3d12_pipeline_state_find_compiled_pipeline(const struct d3d12_pipeline_state *state,
-        const struct vkd3d_pipeline_key *key, VkRenderPass *vk_render_pass)
+static uint32_t vkd3d_pipeline_key_hash(const struct vkd3d_pipeline_key *key)
 {
-    const struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
-    struct d3d12_device *device = state->device;
-    VkPipeline vk_pipeline = VK_NULL_HANDLE;
-    struct vkd3d_compiled_pipeline *current;
-
-    *vk_render_pass = VK_NULL_HANDLE;
+    uint64_t hash = vkd3d_hash_fnv1a_64(VKD3D_HASH_FNV1A_64_INIT, key, sizeof(*key));
 
-    vkd3d_mutex_lock(&device->mutex);
+    return hash ^ (hash >> 32);
+}
 
-    LIST_FOR_EACH_ENTRY(current, &graphics->compiled_pipelines, struct vkd3d_compiled_pipeline, entry)
+static const struct vkd3d_compiled_pipeline *vkd3d_compiled_pipeline_find(
+        const struct vkd3d_compiled_pipeline *current, const struct vkd3d_compiled_pipeline *last,
+        uint32_t hash, const struct vkd3d_pipeline_key *key)
+{
+    for (; current != last; current = current->next)
     {
-        if (!memcmp(&current->key, key, sizeof(*key)))
-        {
-            vk_pipeline = current->vk_pipeline;
-            *vk_render_pass = current->vk_render_pass;
-            break;
-        }
+        if (current->hash == hash && !memcmp(&current->key, key, sizeof(*key)))
+            return current;
     }
 
-    vkd3d_mutex_unlock(&device->mutex);
+    return NULL;
+}
 
-    return vk_pipeline;
+static VkPipeline d3d12_pipeline_state_find_compiled_pipeline(const struct d3d12_pipeline_state *state,
+        uint32_t hash, const struct vkd3d_pipeline_key *key, VkRenderPass *vk_render_pass)
+{
+    const struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
+    const struct vkd3d_compiled_pipeline *compiled_pipeline;
+
+    /* Entries are published with a full barrier, and readers only access
+     * them through the pointer they loaded, like rcu_dereference(). */
+    if (!(compiled_pipeline = vkd3d_compiled_pipeline_find(
+            graphics->compiled_pipelines[hash % ARRAY_SIZE(graphics->compiled_pipelines)], NULL, hash, key)))
+    {
+        *vk_render_pass = VK_NULL_HANDLE;
+        return VK_NULL_HANDLE;
+    }
+
+    *vk_render_pass = compiled_pipeline->vk_render_pass;
+    return compiled_pipeline->vk_pipeline;
 }
 
 static bool d3d12_pipeline_state_put_pipeline_to_cache(struct d3d12_pipeline_state *state,
-        const struct vkd3d_pipeline_key *key, VkPipeline vk_pipeline, VkRenderPass vk_render_pass)
+        uint32_t hash, const struct vkd3d_pipeline_key *key, VkPipeline vk_pipeline, VkRenderPass vk_render_pass)
 {
     struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
-    struct vkd3d_compiled_pipeline *compiled_pipeline, *current;
-    struct d3d12_device *device = state->device;
+    struct vkd3d_compiled_pipeline *compiled_pipeline, *head, *last = NULL;
+    struct vkd3d_compiled_pipeline * volatile *bucket;
 
     if (!(compiled_pipeline = vkd3d_malloc(sizeof(*compiled_pipeline))))
         return false;
 
+    compiled_pipeline->hash = hash;
     compiled_pipeline->key = *key;
     compiled_pipeline->vk_pipeline = vk_pipeline;
     compiled_pipeline->vk_render_pass = vk_render_pass;
 
-    vkd3d_mutex_lock(&device->mutex);
-
-    LIST_FOR_EACH_ENTRY(current, &graphics->compiled_pipelines, struct vkd3d_compiled_pipeline, entry)
+    bucket = &graphics->compiled_pipelines[hash % ARRAY_SIZE(graphics->compiled_pipelines)];
+    for (head = *bucket;; last = head, head = *bucket)
     {
-        if (!memcmp(&current->key, key, sizeof(*key)))
+        /* Only entries added since the previous attempt need checking. */
+        if (vkd3d_compiled_pipeline_find(head, last, hash, key))
         {
             vkd3d_free(compiled_pipeline);
-            compiled_pipeline = NULL;
-            break;
+            return false;
         }
-    }
-
-    if (compiled_pipeline)
-        list_add_tail(&graphics->compiled_pipelines, &compiled_pipeline->entry);
 
-    vkd3d_mutex_unlock(&device->mutex);
-    return compiled_pipeline;
+        compiled_pipeline->next = head;
+        if (InterlockedCompareExchangePointer((void * volatile *)bucket, compiled_pipeline, head) == head)
+            return true;
+    }
 }
 
 VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_state *state,
@@ -3434,6 +4906,7 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
     VkGraphicsPipelineCreateInfo pipeline_desc;
     struct vkd3d_pipeline_key pipeline_key;
     size_t binding_count = 0;
+    uint32_t pipeline_hash;
     VkPipeline vk_pipeline;
     unsigned int i;
     uint32_t mask;
@@ -3498,8 +4971,10 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
     }
 
     pipeline_key.dsv_format = dsv_format;
+    pipeline_hash = vkd3d_pipeline_key_hash(&pipeline_key);
 
-    if ((vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, &pipeline_key, vk_render_pass)))
+    if ((vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state,
+            pipeline_hash, &pipeline_key, vk_render_pass)))
         return vk_pipeline;
 
     input_desc.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -3553,6 +5028,10 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
     pipeline_desc.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipeline_desc.pNext = NULL;
     pipeline_desc.flags = 0;
+#ifdef VK_EXT_descriptor_buffer
+    if (device->use_descriptor_buffers)
+        pipeline_desc.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+#endif
     pipeline_desc.stageCount = graphics->stage_count;
     pipeline_desc.pStages = graphics->stages;
     pipeline_desc.pVertexInputState = &input_desc;
@@ -3577,30 +5056,662 @@ VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_sta
             TRACE("Compiling %p with DSV format %#x.\n", state, dsv_format);
 
         if (FAILED(hr = d3d12_graphics_pipeline_state_create_render_pass(graphics, device, dsv_format,
-                &pipeline_desc.renderPass)))
+                0, 0, &pipeline_desc.renderPass)))
             return VK_NULL_HANDLE;
     }
 
     *vk_render_pass = pipeline_desc.renderPass;
 
-    if ((vr = VK_CALL(vkCreateGraphicsPipelines(device->vk_device, device->vk_pipeline_cache,
-            1, &pipeline_desc, NULL, &vk_pipeline))) < 0)
+    if ((vr = VK_CALL(vkCreateGraphicsPipelines(device->vk_device,
+            device->vk_pipeline_cache, 1, &pipeline_desc, NULL, &vk_pipeline))) < 0)
     {
         WARN("Failed to create Vulkan graphics pipeline, vr %d.\n", vr);
         return VK_NULL_HANDLE;
     }
 
-    if (d3d12_pipeline_state_put_pipeline_to_cache(state, &pipeline_key, vk_pipeline, pipeline_desc.renderPass))
+    if (d3d12_pipeline_state_put_pipeline_to_cache(state, pipeline_hash,
+            &pipeline_key, vk_pipeline, pipeline_desc.renderPass))
         return vk_pipeline;
 
     /* Other thread compiled the pipeline before us. */
     VK_CALL(vkDestroyPipeline(device->vk_device, vk_pipeline, NULL));
-    vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, &pipeline_key, vk_render_pass);
+    vk_pipeline = d3d12_pipeline_state_find_compiled_pipeline(state, pipeline_hash, &pipeline_key, vk_render_pass);
     if (!vk_pipeline)
         ERR("Could not get the pipeline compiled by other thread from the cache.\n");
     return vk_pipeline;
 }
 
+/* Returns a render pass compatible with the one used for compiling "state",
+ * with LOAD_OP_CLEAR for the attachments in "clear_mask" and LOAD_OP_DONT_CARE
+ * for the attachments in "discard_mask". */
+HRESULT d3d12_pipeline_state_get_render_pass_variant(struct d3d12_pipeline_state *state,
+        VkFormat dsv_format, uint32_t clear_mask, uint32_t discard_mask, VkRenderPass *vk_render_pass)
+{
+    assert(d3d12_pipeline_state_is_graphics(state));
+
+    return d3d12_graphics_pipeline_state_create_render_pass(&state->u.graphics,
+            state->device, dsv_format, clear_mask, discard_mask, vk_render_pass);
+}
+
+static HRESULT d3d12_pipeline_state_get_compiled_keys(struct d3d12_pipeline_state *state,
+        struct vkd3d_pipeline_key **keys, unsigned int *key_count)
+{
+    struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
+    const struct vkd3d_compiled_pipeline *current;
+    unsigned int i, count = 0;
+
+    *keys = NULL;
+    *key_count = 0;
+
+    if (!d3d12_pipeline_state_is_graphics(state))
+        return S_OK;
+
+    for (i = 0; i < ARRAY_SIZE(graphics->compiled_pipelines); ++i)
+    {
+        for (current = graphics->compiled_pipelines[i]; current; current = current->next)
+            ++count;
+    }
+
+    if (count && !(*keys = vkd3d_calloc(count, sizeof(**keys))))
+        return E_OUTOFMEMORY;
+
+    /* Variants compiled concurrently may or may not be included. */
+    for (i = 0; i < ARRAY_SIZE(graphics->compiled_pipelines); ++i)
+    {
+        for (current = graphics->compiled_pipelines[i]; current && *key_count < count; current = current->next)
+            (*keys)[(*key_count)++] = current->key;
+    }
+
+    return S_OK;
+}
+
+static void d3d12_pipeline_state_precompile(struct d3d12_pipeline_state *state,
+        const struct vkd3d_pipeline_key *keys, unsigned int key_count)
+{
+    const struct d3d12_graphics_pipeline_state *graphics = &state->u.graphics;
+    uint32_t strides[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    VkRenderPass vk_render_pass;
+    unsigned int i, j, k;
+    uint32_t binding;
+    uint32_t mask;
+
+    if (FAILED(d3d12_pipeline_state_wait(state)))
+        return;
+
+    for (i = 0; i < key_count; ++i)
+    {
+        /* Pipeline keys only hold the strides of the used bindings, in
+         * attribute order. */
+        memset(strides, 0, sizeof(strides));
+        for (j = 0, k = 0, mask = 0; j < graphics->attribute_count && k < ARRAY_SIZE(keys[i].strides); ++j)
+        {
+            binding = graphics->attributes[j].binding;
+            if (mask & (1u << binding))
+                continue;
+
+            mask |= 1u << binding;
+            strides[binding] = keys[i].strides[k++];
+        }
+
+        if (!d3d12_pipeline_state_get_or_create_pipeline(state, keys[i].topology,
+                strides, keys[i].dsv_format, &vk_render_pass))
+            WARN("Failed to compile pipeline variant %u.\n", i);
+    }
+}
+
+/* ID3D12PipelineLibrary */
+#define VKD3D_PIPELINE_LIBRARY_MAGIC VKD3D_MAKE_TAG('V', 'P', 'L', 'B')
+#define VKD3D_PIPELINE_LIBRARY_VERSION 1
+
+/* Serialized libraries start with this header, followed by "entry_count"
+ * entries. Each entry is an entry header followed by the UTF-8 name, the keys
+ * of the compiled pipeline variants, and a GetCachedBlob() blob, each padded
+ * to 8 bytes. */
+struct vkd3d_pipeline_library_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t build_hash;
+    uint8_t device_uuid[VK_UUID_SIZE];
+    uint32_t entry_count;
+    uint32_t reserved;
+};
+
+struct vkd3d_pipeline_library_entry_header
+{
+    uint32_t bind_point;
+    uint32_t name_size;
+    uint64_t root_signature_hash;
+    uint64_t data_size;
+    uint32_t key_count;
+    uint32_t reserved;
+};
+
+struct d3d12_pipeline_library_entry
+{
+    struct rb_entry entry;
+
+    /* For entries loaded from a serialized library, these point into the
+     * application's blob, which must outlive the library. Stored entries
+     * keep a copy in the same allocation as the entry. */
+    const char *name;
+    const struct vkd3d_pipeline_key *keys;
+    unsigned int key_count;
+    const void *data;
+    size_t data_size;
+
+    VkPipelineBindPoint bind_point;
+    uint64_t root_signature_hash;
+};
+
+static size_t vkd3d_pipeline_library_entry_size(size_t name_size, size_t key_count, size_t data_size)
+{
+    return sizeof(struct vkd3d_pipeline_library_entry_header) + align(name_size, 8)
+            + align(key_count * sizeof(struct vkd3d_pipeline_key), 8) + align(data_size, 8);
+}
+
+static int d3d12_pipeline_library_compare_key(const void *key, const struct rb_entry *entry)
+{
+    const struct d3d12_pipeline_library_entry *e;
+
+    e = RB_ENTRY_VALUE(entry, const struct d3d12_pipeline_library_entry, entry);
+
+    return strcmp(key, e->name);
+}
+
+static void d3d12_pipeline_library_destroy_entry(struct rb_entry *entry, void *context)
+{
+    vkd3d_free(RB_ENTRY_VALUE(entry, struct d3d12_pipeline_library_entry, entry));
+}
+
+static inline struct d3d12_pipeline_library *impl_from_ID3D12PipelineLibrary(ID3D12PipelineLibrary *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d12_pipeline_library, ID3D12PipelineLibrary_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_QueryInterface(ID3D12PipelineLibrary *iface,
+        REFIID riid, void **object)
+{
+    TRACE("iface %p, riid %s, object %p.\n", iface, debugstr_guid(riid), object);
+
+    if (IsEqualGUID(riid, &IID_ID3D12PipelineLibrary)
+            || IsEqualGUID(riid, &IID_ID3D12DeviceChild)
+            || IsEqualGUID(riid, &IID_ID3D12Object)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D12PipelineLibrary_AddRef(iface);
+        *object = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+
+    *object = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d12_pipeline_library_AddRef(ID3D12PipelineLibrary *iface)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    ULONG refcount = InterlockedIncrement(&library->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", library, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d12_pipeline_library_Release(ID3D12PipelineLibrary *iface)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    ULONG refcount = InterlockedDecrement(&library->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", library, refcount);
+
+    if (!refcount)
+    {
+        struct d3d12_device *device = library->device;
+
+        vkd3d_private_store_destroy(&library->private_store);
+
+        rb_destroy(&library->pipelines, d3d12_pipeline_library_destroy_entry, NULL);
+        vkd3d_mutex_destroy(&library->mutex);
+
+        vkd3d_free(library);
+
+        d3d12_device_release(device);
+    }
+
+    return refcount;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_GetPrivateData(ID3D12PipelineLibrary *iface,
+        REFGUID guid, UINT *data_size, void *data)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return vkd3d_get_private_data(&library->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_SetPrivateData(ID3D12PipelineLibrary *iface,
+        REFGUID guid, UINT data_size, const void *data)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return vkd3d_set_private_data(&library->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_SetPrivateDataInterface(ID3D12PipelineLibrary *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return vkd3d_set_private_data_interface(&library->private_store, guid, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_SetName(ID3D12PipelineLibrary *iface, const WCHAR *name)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+
+    TRACE("iface %p, name %s.\n", iface, debugstr_w(name, library->device->wchar_size));
+
+    return name ? S_OK : E_INVALIDARG;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_GetDevice(ID3D12PipelineLibrary *iface,
+        REFIID iid, void **device)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+
+    TRACE("iface %p, iid %s, device %p.\n", iface, debugstr_guid(iid), device);
+
+    return d3d12_device_query_interface(library->device, iid, device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_StorePipeline(ID3D12PipelineLibrary *iface,
+        const WCHAR *name, ID3D12PipelineState *pipeline)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    struct d3d12_pipeline_state *state = unsafe_impl_from_ID3D12PipelineState(pipeline);
+    struct d3d12_pipeline_library_entry *entry;
+    size_t name_size, keys_size, data_size;
+    struct vkd3d_pipeline_key *keys;
+    unsigned int key_count;
+    char *name_utf8;
+    uint8_t *ptr;
+    void *data;
+    HRESULT hr;
+
+    TRACE("iface %p, name %s, pipeline %p.\n", iface, debugstr_w(name, library->device->wchar_size), pipeline);
+
+    if (!name || !state)
+        return E_INVALIDARG;
+
+    if (!(name_utf8 = vkd3d_strdup_w_utf8(name, library->device->wchar_size)))
+        return E_OUTOFMEMORY;
+
+    if (FAILED(hr = d3d12_pipeline_state_get_cached_data(state, &data, &data_size)))
+    {
+        vkd3d_free(name_utf8);
+        return hr;
+    }
+
+    if (FAILED(hr = d3d12_pipeline_state_get_compiled_keys(state, &keys, &key_count)))
+    {
+        vkd3d_free(data);
+        vkd3d_free(name_utf8);
+        return hr;
+    }
+
+    name_size = strlen(name_utf8) + 1;
+    keys_size = key_count * sizeof(*keys);
+    if ((entry = vkd3d_malloc(sizeof(*entry) + align(keys_size, 8) + align(data_size, 8) + name_size)))
+    {
+        ptr = (uint8_t *)(entry + 1);
+        memcpy(ptr, keys, keys_size);
+        entry->keys = (const struct vkd3d_pipeline_key *)ptr;
+        entry->key_count = key_count;
+        ptr += align(keys_size, 8);
+        memcpy(ptr, data, data_size);
+        entry->data = ptr;
+        entry->data_size = data_size;
+        ptr += align(data_size, 8);
+        memcpy(ptr, name_utf8, name_size);
+        entry->name = (const char *)ptr;
+        entry->bind_point = state->vk_bind_point;
+        entry->root_signature_hash = state->root_signature_hash;
+    }
+    vkd3d_free(keys);
+    vkd3d_free(data);
+    vkd3d_free(name_utf8);
+    if (!entry)
+        return E_OUTOFMEMORY;
+
+    vkd3d_mutex_lock(&library->mutex);
+    if (rb_put(&library->pipelines, entry->name, &entry->entry) < 0)
+    {
+        vkd3d_mutex_unlock(&library->mutex);
+        WARN("Pipeline %s already exists.\n", debugstr_a(entry->name));
+        vkd3d_free(entry);
+        return E_INVALIDARG;
+    }
+    library->serialized_size += vkd3d_pipeline_library_entry_size(name_size, key_count, data_size);
+    vkd3d_mutex_unlock(&library->mutex);
+
+    return S_OK;
+}
+
+static HRESULT d3d12_pipeline_library_find_entry(struct d3d12_pipeline_library *library,
+        const WCHAR *name, VkPipelineBindPoint bind_point, ID3D12RootSignature *root_signature_iface,
+        const struct d3d12_pipeline_library_entry **entry)
+{
+    const struct d3d12_root_signature *root_signature;
+    struct rb_entry *rb_entry;
+    char *name_utf8;
+
+    if (!name)
+        return E_INVALIDARG;
+
+    if (!(name_utf8 = vkd3d_strdup_w_utf8(name, library->device->wchar_size)))
+        return E_OUTOFMEMORY;
+
+    vkd3d_mutex_lock(&library->mutex);
+    rb_entry = rb_get(&library->pipelines, name_utf8);
+    vkd3d_mutex_unlock(&library->mutex);
+
+    if (!rb_entry)
+    {
+        TRACE("Pipeline %s not found.\n", debugstr_a(name_utf8));
+        vkd3d_free(name_utf8);
+        return E_INVALIDARG;
+    }
+    vkd3d_free(name_utf8);
+
+    /* Entries are never removed, so we can use them without holding the lock. */
+    *entry = RB_ENTRY_VALUE(rb_entry, const struct d3d12_pipeline_library_entry, entry);
+
+    if ((*entry)->bind_point != bind_point)
+    {
+        WARN("Pipeline type mismatch.\n");
+        return E_INVALIDARG;
+    }
+
+    if (!(root_signature = unsafe_impl_from_ID3D12RootSignature(root_signature_iface))
+            || root_signature->hash != (*entry)->root_signature_hash)
+    {
+        WARN("Root signature mismatch.\n");
+        return E_INVALIDARG;
+    }
+
+    return S_OK;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_LoadGraphicsPipeline(ID3D12PipelineLibrary *iface,
+        const WCHAR *name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC *desc, REFIID riid, void **pipeline_state)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    const struct d3d12_pipeline_library_entry *entry;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_desc;
+    struct d3d12_pipeline_state *object;
+    HRESULT hr;
+
+    TRACE("iface %p, name %s, desc %p, riid %s, pipeline_state %p.\n", iface,
+            debugstr_w(name, library->device->wchar_size), desc, debugstr_guid(riid), pipeline_state);
+
+    if (FAILED(hr = d3d12_pipeline_library_find_entry(library, name,
+            VK_PIPELINE_BIND_POINT_GRAPHICS, desc->pRootSignature, &entry)))
+        return hr;
+
+    pipeline_desc = *desc;
+    pipeline_desc.CachedPSO.pCachedBlob = entry->data;
+    pipeline_desc.CachedPSO.CachedBlobSizeInBytes = entry->data_size;
+    if (FAILED(hr = d3d12_pipeline_state_create_graphics(library->device, &pipeline_desc, &object)))
+        return hr;
+
+    d3d12_pipeline_state_precompile(object, entry->keys, entry->key_count);
+
+    return return_interface(&object->ID3D12PipelineState_iface,
+            &IID_ID3D12PipelineState, riid, pipeline_state);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_LoadComputePipeline(ID3D12PipelineLibrary *iface,
+        const WCHAR *name, const D3D12_COMPUTE_PIPELINE_STATE_DESC *desc, REFIID riid, void **pipeline_state)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    const struct d3d12_pipeline_library_entry *entry;
+    D3D12_COMPUTE_PIPELINE_STATE_DESC pipeline_desc;
+    struct d3d12_pipeline_state *object;
+    HRESULT hr;
+
+    TRACE("iface %p, name %s, desc %p, riid %s, pipeline_state %p.\n", iface,
+            debugstr_w(name, library->device->wchar_size), desc, debugstr_guid(riid), pipeline_state);
+
+    if (FAILED(hr = d3d12_pipeline_library_find_entry(library, name,
+            VK_PIPELINE_BIND_POINT_COMPUTE, desc->pRootSignature, &entry)))
+        return hr;
+
+    pipeline_desc = *desc;
+    pipeline_desc.CachedPSO.pCachedBlob = entry->data;
+    pipeline_desc.CachedPSO.CachedBlobSizeInBytes = entry->data_size;
+    if (FAILED(hr = d3d12_pipeline_state_create_compute(library->device, &pipeline_desc, &object)))
+        return hr;
+
+    return return_interface(&object->ID3D12PipelineState_iface,
+            &IID_ID3D12PipelineState, riid, pipeline_state);
+}
+
+static SIZE_T STDMETHODCALLTYPE d3d12_pipeline_library_GetSerializedSize(ID3D12PipelineLibrary *iface)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    size_t size;
+
+    TRACE("iface %p.\n", iface);
+
+    vkd3d_mutex_lock(&library->mutex);
+    size = library->serialized_size;
+    vkd3d_mutex_unlock(&library->mutex);
+
+    return size;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d12_pipeline_library_Serialize(ID3D12PipelineLibrary *iface,
+        void *data, SIZE_T data_size)
+{
+    struct d3d12_pipeline_library *library = impl_from_ID3D12PipelineLibrary(iface);
+    struct vkd3d_pipeline_library_entry_header *entry_header;
+    struct vkd3d_pipeline_library_header *header = data;
+    struct d3d12_pipeline_library_entry *entry;
+    size_t name_size, keys_size;
+    uint8_t *ptr;
+
+    TRACE("iface %p, data %p, data_size %lu.\n", iface, data, data_size);
+
+    vkd3d_mutex_lock(&library->mutex);
+
+    if (data_size < library->serialized_size)
+    {
+        WARN("Data size %lu is smaller than the serialized size %zu.\n", data_size, library->serialized_size);
+        vkd3d_mutex_unlock(&library->mutex);
+        return E_INVALIDARG;
+    }
+
+    memset(data, 0, library->serialized_size);
+    header->magic = VKD3D_PIPELINE_LIBRARY_MAGIC;
+    header->version = VKD3D_PIPELINE_LIBRARY_VERSION;
+    header->build_hash = vkd3d_get_build_hash();
+    memcpy(header->device_uuid, library->device->pipeline_cache_uuid, VK_UUID_SIZE);
+    header->entry_count = 0;
+
+    ptr = (uint8_t *)(header + 1);
+    RB_FOR_EACH_ENTRY(entry, &library->pipelines, struct d3d12_pipeline_library_entry, entry)
+    {
+        name_size = strlen(entry->name) + 1;
+        keys_size = entry->key_count * sizeof(*entry->keys);
+
+        entry_header = (struct vkd3d_pipeline_library_entry_header *)ptr;
+        entry_header->bind_point = entry->bind_point;
+        entry_header->name_size = name_size;
+        entry_header->root_signature_hash = entry->root_signature_hash;
+        entry_header->data_size = entry->data_size;
+        entry_header->key_count = entry->key_count;
+        ptr = (uint8_t *)(entry_header + 1);
+
+        memcpy(ptr, entry->name, name_size);
+        ptr += align(name_size, 8);
+        memcpy(ptr, entry->keys, keys_size);
+        ptr += align(keys_size, 8);
+        memcpy(ptr, entry->data, entry->data_size);
+        ptr += align(entry->data_size, 8);
+
+        ++header->entry_count;
+    }
+
+    vkd3d_mutex_unlock(&library->mutex);
+
+    return S_OK;
+}
+
+static const struct ID3D12PipelineLibraryVtbl d3d12_pipeline_library_vtbl =
+{
+    /* IUnknown methods */
+    d3d12_pipeline_library_QueryInterface,
+    d3d12_pipeline_library_AddRef,
+    d3d12_pipeline_library_Release,
+    /* ID3D12Object methods */
+    d3d12_pipeline_library_GetPrivateData,
+    d3d12_pipeline_library_SetPrivateData,
+    d3d12_pipeline_library_SetPrivateDataInterface,
+    d3d12_pipeline_library_SetName,
+    /* ID3D12DeviceChild methods */
+    d3d12_pipeline_library_GetDevice,
+    /* ID3D12PipelineLibrary methods */
+    d3d12_pipeline_library_StorePipeline,
+    d3d12_pipeline_library_LoadGraphicsPipeline,
+    d3d12_pipeline_library_LoadComputePipeline,
+    d3d12_pipeline_library_GetSerializedSize,
+    d3d12_pipeline_library_Serialize,
+};
+
+static HRESULT d3d12_pipeline_library_load(struct d3d12_pipeline_library *library,
+        const void *blob, size_t blob_size)
+{
+    const struct vkd3d_pipeline_library_header *header = blob;
+    const struct vkd3d_pipeline_library_entry_header *entry_header;
+    struct d3d12_pipeline_library_entry *entry;
+    const uint8_t *ptr, *end;
+    size_t size, remaining;
+    const char *name;
+    unsigned int i;
+
+    if (blob_size < sizeof(*header) || header->magic != VKD3D_PIPELINE_LIBRARY_MAGIC)
+    {
+        WARN("Invalid pipeline library blob.\n");
+        return E_INVALIDARG;
+    }
+
+    /* As on Windows, applications handle these errors by creating an empty
+     * library instead. */
+    if (header->version != VKD3D_PIPELINE_LIBRARY_VERSION || header->build_hash != vkd3d_get_build_hash())
+    {
+        WARN("Pipeline library was created by a different driver version.\n");
+        return D3D12_ERROR_DRIVER_VERSION_MISMATCH;
+    }
+
+    if (memcmp(header->device_uuid, library->device->pipeline_cache_uuid, VK_UUID_SIZE))
+    {
+        WARN("Pipeline library was created for a different device.\n");
+        return D3D12_ERROR_ADAPTER_NOT_FOUND;
+    }
+
+    ptr = (const uint8_t *)(header + 1);
+    end = (const uint8_t *)blob + blob_size;
+    for (i = 0; i < header->entry_count; ++i)
+    {
+        entry_header = (const struct vkd3d_pipeline_library_entry_header *)ptr;
+        remaining = end - ptr;
+        if (remaining < sizeof(*entry_header) || entry_header->name_size > remaining
+                || entry_header->key_count > remaining / sizeof(struct vkd3d_pipeline_key)
+                || entry_header->data_size > remaining)
+            goto invalid;
+
+        size = vkd3d_pipeline_library_entry_size(entry_header->name_size,
+                entry_header->key_count, entry_header->data_size);
+        name = (const char *)(entry_header + 1);
+        if (size > remaining || !entry_header->name_size || name[entry_header->name_size - 1]
+                || (entry_header->bind_point != VK_PIPELINE_BIND_POINT_GRAPHICS
+                && entry_header->bind_point != VK_PIPELINE_BIND_POINT_COMPUTE))
+            goto invalid;
+
+        if (!(entry = vkd3d_malloc(sizeof(*entry))))
+            return E_OUTOFMEMORY;
+
+        entry->name = name;
+        entry->keys = (const struct vkd3d_pipeline_key *)(name + align(entry_header->name_size, 8));
+        entry->key_count = entry_header->key_count;
+        entry->data = (const uint8_t *)entry->keys + align(entry->key_count * sizeof(*entry->keys), 8);
+        entry->data_size = entry_header->data_size;
+        entry->bind_point = entry_header->bind_point;
+        entry->root_signature_hash = entry_header->root_signature_hash;
+
+        if (rb_put(&library->pipelines, entry->name, &entry->entry) < 0)
+        {
+            vkd3d_free(entry);
+            goto invalid;
+        }
+
+        library->serialized_size += size;
+        ptr += size;
+    }
+
+    TRACE("Loaded %u pipelines.\n", header->entry_count);
+
+    return S_OK;
+
+invalid:
+    WARN("Invalid pipeline library entry %u.\n", i);
+    return E_INVALIDARG;
+}
+
+HRESULT d3d12_pipeline_library_create(struct d3d12_device *device, const void *blob,
+        size_t blob_size, struct d3d12_pipeline_library **library)
+{
+    struct d3d12_pipeline_library *object;
+    HRESULT hr;
+
+    if (!(object = vkd3d_malloc(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D12PipelineLibrary_iface.lpVtbl = &d3d12_pipeline_library_vtbl;
+    object->refcount = 1;
+
+    vkd3d_mutex_init(&object->mutex);
+    rb_init(&object->pipelines, d3d12_pipeline_library_compare_key);
+    object->serialized_size = sizeof(struct vkd3d_pipeline_library_header);
+    object->device = device;
+
+    if ((blob_size && FAILED(hr = d3d12_pipeline_library_load(object, blob, blob_size)))
+            || FAILED(hr = vkd3d_private_store_init(&object->private_store)))
+    {
+        rb_destroy(&object->pipelines, d3d12_pipeline_library_destroy_entry, NULL);
+        vkd3d_mutex_destroy(&object->mutex);
+        vkd3d_free(object);
+        return hr;
+    }
+
+    d3d12_device_add_ref(device);
+
+    TRACE("Created pipeline library %p.\n", object);
+
+    *library = object;
+
+    return S_OK;
+}
+
 static void vkd3d_uav_clear_pipelines_cleanup(struct vkd3d_uav_clear_pipelines *pipelines,
         struct d3d12_device *device)
 {
@@ -3750,7 +5861,7 @@ HRESULT vkd3d_uav_clear_state_init(struct vkd3d_uav_clear_state *state, struct d
             binding.flags = VKD3D_SHADER_BINDING_FLAG_IMAGE;
 
         if (FAILED(hr = vkd3d_create_compute_pipeline(device, &pipelines[i].code, &shader_interface,
-                *pipelines[i].pipeline_layout, pipelines[i].pipeline)))
+                *pipelines[i].pipeline_layout, NULL, NULL, NULL, pipelines[i].pipeline)))
         {
             ERR("Failed to create compute pipeline %u, hr %#x.\n", i, hr);
             goto fail;
@@ -19,6 +19,9 @@
 #include "vkd3d_private.h"
 
 #include <errno.h>
+#ifndef _WIN32
+# include <unistd.h>
+#endif
 
 #define COLOR         (VK_IMAGE_ASPECT_COLOR_BIT)
 #define DEPTH         (VK_IMAGE_ASPECT_DEPTH_BIT)
@@ -887,6 +890,95 @@ bool vkd3d_get_program_name(char program_name[PATH_MAX])
 
 #endif  /* HAVE_DECL_PROGRAM_INVOCATION_NAME */
 
+void *vkd3d_load_file(const char *path, size_t *size)
+{
+    void *data = NULL;
+    long file_size;
+    FILE *f;
+
+    *size = 0;
+
+    if (!(f = fopen(path, "rb")))
+        return NULL;
+
+    if (fseek(f, 0, SEEK_END) || (file_size = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET))
+        goto done;
+
+    if (!(data = vkd3d_malloc(file_size)))
+        goto done;
+
+    if (fread(data, 1, file_size, f) != (size_t)file_size)
+    {
+        WARN("Failed to read %s.\n", debugstr_a(path));
+        vkd3d_free(data);
+        data = NULL;
+        goto done;
+    }
+
+    *size = file_size;
+
+done:
+    fclose(f);
+    return data;
+}
+
+/* Write to a temporary file first and rename it over the destination, so
+ * that concurrent readers never observe a partially written file. */
+bool vkd3d_store_file_atomic(const char *path, const void *data, size_t size)
+{
+    char tmp_path[1024];
+    unsigned int pid;
+    bool ret;
+    FILE *f;
+
+#ifdef _WIN32
+    pid = GetCurrentProcessId();
+#else
+    pid = getpid();
+#endif
+
+    if (snprintf(tmp_path, ARRAY_SIZE(tmp_path), "%s.%u.tmp", path, pid) >= ARRAY_SIZE(tmp_path))
+    {
+        WARN("Path %s is too long.\n", debugstr_a(path));
+        return false;
+    }
+
+    if (!(f = fopen(tmp_path, "wb")))
+    {
+        WARN("Failed to open %s for writing.\n", debugstr_a(tmp_path));
+        return false;
+    }
+
+    ret = fwrite(data, 1, size, f) == size;
+    if (fclose(f))
+        ret = false;
+    if (!ret)
+    {
+        WARN("Failed to write %s.\n", debugstr_a(tmp_path));
+        remove(tmp_path);
+        return false;
+    }
+
+#ifdef _WIN32
+    ret = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ret = !rename(tmp_path, path);
+#endif
+    if (!ret)
+    {
+        WARN("Failed to rename %s to %s.\n", debugstr_a(tmp_path), debugstr_a(path));
+        remove(tmp_path);
+    }
+
+    return ret;
+}
+
+void vkd3d_remove_file(const char *path)
+{
+    if (remove(path) && errno != ENOENT)
+        WARN("Failed to remove %s, errno %d.\n", debugstr_a(path), errno);
+}
+
 static struct vkd3d_private_data *vkd3d_private_store_get_private_data(
         const struct vkd3d_private_store *store, const GUID *tag)
 {
@@ -59,8 +59,14 @@
 #define VKD3D_MAX_SHADER_EXTENSIONS       3u
 #define VKD3D_MAX_SHADER_STAGES           5u
 #define VKD3D_MAX_VK_SYNC_OBJECTS         4u
-#define VKD3D_MAX_DEVICE_BLOCKED_QUEUES  16u
 #define VKD3D_MAX_DESCRIPTOR_SETS        64u
+
+#define VKD3D_MAX_PIPELINE_COMPILER_THREADS   64u
+#define VKD3D_COMPILED_PIPELINE_BUCKET_COUNT  16u
+#define VKD3D_RENDER_PASS_CACHE_BUCKET_COUNT 256u
+#define VKD3D_FRAMEBUFFER_CACHE_BUCKET_COUNT 256u
+#define VKD3D_DESCRIPTOR_POOL_CACHE_SIZE      64u
+
 /* D3D12 binding tier 3 has a limit of 2048 samplers. */
 #define VKD3D_MAX_DESCRIPTOR_SET_SAMPLERS 2048u
 /* The main limitation here is the simple descriptor pool recycling scheme
@@ -114,24 +120,30 @@ struct vkd3d_device_descriptor_limits
 struct vkd3d_vulkan_info
 {
     /* KHR instance extensions */
+    bool KHR_device_group_creation;
     bool KHR_get_physical_device_properties2;
     /* EXT instance extensions */
     bool EXT_debug_report;
 
     /* KHR device extensions */
+    bool KHR_buffer_device_address;
     bool KHR_dedicated_allocation;
+    bool KHR_descriptor_update_template;
+    bool KHR_device_group;
     bool KHR_draw_indirect_count;
     bool KHR_get_memory_requirements2;
     bool KHR_image_format_list;
     bool KHR_maintenance3;
     bool KHR_push_descriptor;
     bool KHR_sampler_mirror_clamp_to_edge;
+    bool KHR_synchronization2;
     bool KHR_timeline_semaphore;
     /* EXT device extensions */
     bool EXT_calibrated_timestamps;
     bool EXT_conditional_rendering;
     bool EXT_debug_marker;
     bool EXT_depth_clip_enable;
+    bool EXT_descriptor_buffer;
     bool EXT_descriptor_indexing;
     bool EXT_robustness2;
     bool EXT_shader_demote_to_helper_invocation;
@@ -153,6 +165,9 @@ struct vkd3d_vulkan_info
     struct vkd3d_device_descriptor_limits descriptor_limits;
 
     VkPhysicalDeviceTexelBufferAlignmentPropertiesEXT texel_buffer_alignment_properties;
+#ifdef VK_EXT_descriptor_buffer
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT descriptor_buffer_properties;
+#endif
 
     unsigned int shader_extension_count;
     enum vkd3d_shader_spirv_extension shader_extensions[VKD3D_MAX_SHADER_EXTENSIONS];
@@ -164,6 +179,9 @@ enum vkd3d_config_flags
 {
     VKD3D_CONFIG_FLAG_VULKAN_DEBUG = 0x00000001,
     VKD3D_CONFIG_FLAG_VIRTUAL_HEAPS = 0x00000002,
+    VKD3D_CONFIG_FLAG_DESCRIPTOR_BUFFER = 0x00000004,
+    VKD3D_CONFIG_FLAG_SUBMIT_THREAD = 0x00000008,
+    VKD3D_CONFIG_FLAG_DEFERRED_RECORDING = 0x00000010,
 };
 
 struct vkd3d_instance
@@ -255,6 +273,7 @@ static inline void vkd3d_cond_destroy(struct vkd3d_cond *cond)
 #else  /* _WIN32 */
 
 #include <pthread.h>
+#include <time.h>
 
 union vkd3d_thread_handle
 {
@@ -356,6 +375,25 @@ static inline void vkd3d_cond_destroy(struct vkd3d_cond *cond)
 
 #endif  /* _WIN32 */
 
+static inline uint64_t vkd3d_get_monotonic_time_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (counter.QuadPart / frequency.QuadPart) * 1000000000
+            + (counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
 HRESULT vkd3d_create_thread(struct vkd3d_instance *instance,
         PFN_vkd3d_thread thread_main, void *data, union vkd3d_thread_handle *thread);
 HRESULT vkd3d_join_thread(struct vkd3d_instance *instance, union vkd3d_thread_handle *thread);
@@ -369,26 +407,49 @@ struct vkd3d_waiting_fence
         VkFence vk_fence;
         VkSemaphore vk_semaphore;
     } u;
+    struct vkd3d_queue *queue;
     uint64_t queue_sequence_number;
 };
 
+/* A single device-wide thread waits for the completion of GPU fences from all
+ * command queues. The thread runs while at least one command queue exists. */
 struct vkd3d_fence_worker
 {
     union vkd3d_thread_handle thread;
     struct vkd3d_mutex mutex;
     struct vkd3d_cond cond;
     bool should_exit;
+    bool is_waiting;
 
+    /* Newly enqueued fences, protected by "mutex". */
     size_t fence_count;
     struct vkd3d_waiting_fence *fences;
     size_t fences_size;
 
-    void (*wait_for_gpu_fence)(struct vkd3d_fence_worker *worker, const struct vkd3d_waiting_fence *enqueued_fence);
+    /* Fences being waited for, in enqueue order. Only accessed by the worker
+     * thread. */
+    size_t pending_count;
+    struct vkd3d_waiting_fence *pending;
+    size_t pending_size;
+
+    void *wait_objects;
+    size_t wait_objects_size;
+    uint64_t *wait_values;
+    size_t wait_values_size;
+
+    /* Signalled to interrupt a wait-any when fences are enqueued. */
+    VkSemaphore vk_wake_semaphore;
+    uint64_t wake_value;
+
+    struct vkd3d_mutex thread_mutex;
+    unsigned int queue_count;
 
-    struct vkd3d_queue *queue;
     struct d3d12_device *device;
 };
 
+HRESULT vkd3d_fence_worker_init(struct vkd3d_fence_worker *worker, struct d3d12_device *device);
+void vkd3d_fence_worker_cleanup(struct vkd3d_fence_worker *worker, struct d3d12_device *device);
+
 struct vkd3d_gpu_va_allocation
 {
     D3D12_GPU_VIRTUAL_ADDRESS base;
@@ -428,16 +489,26 @@ struct vkd3d_render_pass_key
     bool depth_stencil_write;
     bool padding;
     unsigned int sample_count;
+    /* Bit i selects VK_ATTACHMENT_LOAD_OP_CLEAR or VK_ATTACHMENT_LOAD_OP_DONT_CARE
+     * for render target i. Depth and stencil use VKD3D_RENDER_PASS_DEPTH_BIT
+     * and VKD3D_RENDER_PASS_STENCIL_BIT. */
+    uint32_t clear_mask;
+    uint32_t discard_mask;
     VkFormat vk_formats[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
 };
 
+#define VKD3D_RENDER_PASS_DEPTH_BIT   (1u << D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT)
+#define VKD3D_RENDER_PASS_STENCIL_BIT (1u << (D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1))
+
 struct vkd3d_render_pass_entry;
 
+/* Render passes are looked up without locking. Entries are only ever
+ * prepended to a bucket, under the mutex, and are freed with the cache. */
 struct vkd3d_render_pass_cache
 {
-    struct vkd3d_render_pass_entry *render_passes;
+    struct vkd3d_mutex mutex;
+    struct vkd3d_render_pass_entry * volatile buckets[VKD3D_RENDER_PASS_CACHE_BUCKET_COUNT];
     size_t render_pass_count;
-    size_t render_passes_size;
 };
 
 void vkd3d_render_pass_cache_cleanup(struct vkd3d_render_pass_cache *cache, struct d3d12_device *device);
@@ -445,6 +516,117 @@ HRESULT vkd3d_render_pass_cache_find(struct vkd3d_render_pass_cache *cache, stru
         const struct vkd3d_render_pass_key *key, VkRenderPass *vk_render_pass);
 void vkd3d_render_pass_cache_init(struct vkd3d_render_pass_cache *cache);
 
+struct vkd3d_framebuffer_key
+{
+    VkRenderPass vk_render_pass;
+    VkImageView views[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT + 1];
+    unsigned int view_count;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layer_count;
+};
+
+struct vkd3d_framebuffer_entry;
+
+/* Framebuffers for render target sets, shared by all command lists. Entries
+ * referencing an image view are destroyed along with the view. */
+struct vkd3d_framebuffer_cache
+{
+    struct vkd3d_mutex mutex;
+    struct vkd3d_framebuffer_entry *buckets[VKD3D_FRAMEBUFFER_CACHE_BUCKET_COUNT];
+    size_t framebuffer_count;
+};
+
+void vkd3d_framebuffer_cache_cleanup(struct vkd3d_framebuffer_cache *cache, struct d3d12_device *device);
+HRESULT vkd3d_framebuffer_cache_find(struct vkd3d_framebuffer_cache *cache, struct d3d12_device *device,
+        const struct vkd3d_framebuffer_key *key, VkFramebuffer *vk_framebuffer);
+void vkd3d_framebuffer_cache_init(struct vkd3d_framebuffer_cache *cache);
+void vkd3d_framebuffer_cache_remove_view(struct vkd3d_framebuffer_cache *cache,
+        struct d3d12_device *device, VkImageView vk_view);
+
+struct vkd3d_descriptor_pool
+{
+    VkDescriptorPool vk_pool;
+    /* Zero for oversized pools, which are never recycled. */
+    unsigned int max_sets;
+};
+
+/* Reset descriptor pools shared by all command allocators. Slots are claimed
+ * and released with compare-and-swap, so borrowing and returning a pool never
+ * blocks. The size of new pools follows the number of sets allocators use. */
+struct vkd3d_descriptor_pool_cache
+{
+    struct vkd3d_descriptor_pool * volatile pools[VKD3D_DESCRIPTOR_POOL_CACHE_SIZE];
+    LONG volatile max_sets;
+    LONG usage_score;
+};
+
+void vkd3d_descriptor_pool_cache_cleanup(struct vkd3d_descriptor_pool_cache *cache, struct d3d12_device *device);
+void vkd3d_descriptor_pool_cache_init(struct vkd3d_descriptor_pool_cache *cache);
+
+/* Identifies translated SPIR-V. The key data holds the shader stage, the
+ * compile options, the DXBC and everything in the shader interface chain that
+ * may affect the generated code; the hash only speeds up comparisons. */
+struct vkd3d_shader_source_key
+{
+    uint64_t hash;
+    size_t size;
+    const void *data;
+};
+
+/* Translated SPIR-V, shared between pipeline states through the shader cache. */
+struct vkd3d_shader_cache_entry
+{
+    struct rb_entry entry;
+    struct list lru_entry;
+    LONG refcount;
+
+    VkShaderStageFlagBits stage;
+    struct vkd3d_shader_source_key source_key;
+    struct vkd3d_shader_code spirv;
+};
+
+struct vkd3d_shader_cache_entry *vkd3d_shader_cache_entry_create(VkShaderStageFlagBits stage,
+        const struct vkd3d_shader_source_key *source_key, const struct vkd3d_shader_code *spirv);
+void vkd3d_shader_cache_entry_decref(struct vkd3d_shader_cache_entry *entry);
+
+struct vkd3d_shader_cache
+{
+    struct vkd3d_mutex mutex;
+    struct rb_tree entries;
+    /* Most recently used entries first. */
+    struct list lru;
+    size_t size;
+    size_t max_size;
+
+    uint64_t hit_count;
+    uint64_t miss_count;
+};
+
+void vkd3d_shader_cache_cleanup(struct vkd3d_shader_cache *cache);
+struct vkd3d_shader_cache_entry *vkd3d_shader_cache_get(struct vkd3d_shader_cache *cache,
+        const struct vkd3d_shader_source_key *source_key);
+void vkd3d_shader_cache_init(struct vkd3d_shader_cache *cache);
+void vkd3d_shader_cache_put(struct vkd3d_shader_cache *cache, struct vkd3d_shader_cache_entry *entry);
+
+/* Worker threads translating shaders of pipeline states in the background. */
+struct vkd3d_pipeline_compiler
+{
+    struct vkd3d_mutex mutex;
+    struct vkd3d_cond cond;
+    struct vkd3d_cond done_cond;
+    struct list jobs;
+    bool should_exit;
+
+    union vkd3d_thread_handle *threads;
+    unsigned int thread_count;
+
+    struct d3d12_device *device;
+};
+
+void vkd3d_pipeline_compiler_cleanup(struct vkd3d_pipeline_compiler *compiler, struct d3d12_device *device);
+void vkd3d_pipeline_compiler_init(struct vkd3d_pipeline_compiler *compiler, struct d3d12_device *device);
+
 struct vkd3d_private_store
 {
     struct vkd3d_mutex mutex;
@@ -528,13 +710,16 @@ struct d3d12_fence
     struct vkd3d_mutex mutex;
     struct vkd3d_cond null_event_cond;
 
+    /* Sorted by value; live entries are events[event_start, event_start + event_count). */
     struct vkd3d_waiting_event
     {
         uint64_t value;
         HANDLE event;
         bool *latch;
+        struct vkd3d_fence_multi_wait *multi_wait;
     } *events;
     size_t events_size;
+    size_t event_start;
     size_t event_count;
 
     VkSemaphore timeline_semaphore;
@@ -554,10 +739,67 @@ struct d3d12_fence
 
 HRESULT d3d12_fence_create(struct d3d12_device *device, uint64_t initial_value,
         D3D12_FENCE_FLAGS flags, struct d3d12_fence **fence);
+HRESULT vkd3d_set_event_on_multiple_fence_completion(struct d3d12_device *device, ID3D12Fence * const *fences,
+        const uint64_t *values, unsigned int fence_count, D3D12_MULTIPLE_FENCE_WAIT_FLAGS flags, HANDLE event);
 
 VkResult vkd3d_create_timeline_semaphore(const struct d3d12_device *device, uint64_t initial_value,
         VkSemaphore *timeline_semaphore);
 
+struct vkd3d_memory_range
+{
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+/* A VkDeviceMemory object from which committed resources are sub-allocated. */
+struct vkd3d_memory_chunk
+{
+    struct list entry;
+
+    VkDeviceMemory vk_memory;
+    VkDeviceSize size;
+    uint32_t memory_type;
+    bool linear;
+    void *map_ptr;
+
+    /* Sorted by offset; adjacent free ranges are always merged. */
+    struct vkd3d_memory_range *free_ranges;
+    size_t free_ranges_size;
+    size_t free_range_count;
+    VkDeviceSize free_size;
+    unsigned int allocation_count;
+    /* Memory at and above this offset has never been handed out, and still
+     * holds the zeros it was allocated with. */
+    VkDeviceSize clean_offset;
+};
+
+struct vkd3d_memory_allocation
+{
+    struct vkd3d_memory_chunk *chunk;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+struct vkd3d_memory_allocator
+{
+    struct vkd3d_mutex mutex;
+
+    /* Buffers and optimally tiled images are kept in separate chunks, so
+     * bufferImageGranularity never needs to be taken into account. */
+    struct list chunks[VK_MAX_MEMORY_TYPES][2];
+    VkDeviceSize chunk_size[VK_MAX_MEMORY_TYPES];
+
+    LONG device_memory_count;
+    size_t chunk_count;
+    VkDeviceSize chunk_memory_size;
+    VkDeviceSize allocated_size;
+    size_t allocation_count;
+};
+
+void vkd3d_memory_allocator_init(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device);
+void vkd3d_memory_allocator_cleanup(struct vkd3d_memory_allocator *allocator, struct d3d12_device *device);
+void vkd3d_free_device_memory(struct d3d12_device *device, VkDeviceMemory vk_memory);
+
 /* ID3D12Heap */
 struct d3d12_heap
 {
@@ -574,6 +816,8 @@ struct d3d12_heap
     void *map_ptr;
     unsigned int map_count;
     uint32_t vk_memory_type;
+    /* Only used by private heaps sub-allocated from a memory chunk. */
+    struct vkd3d_memory_allocation allocation;
 
     struct d3d12_device *device;
 
@@ -648,7 +892,8 @@ struct d3d12_resource *unsafe_impl_from_ID3D12Resource(ID3D12Resource *iface);
 
 HRESULT vkd3d_allocate_buffer_memory(struct d3d12_device *device, VkBuffer vk_buffer,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
-        VkDeviceMemory *vk_memory, uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size);
+        struct vkd3d_memory_allocation *allocation, VkDeviceMemory *vk_memory,
+        uint32_t *vk_memory_type, VkDeviceSize *vk_memory_size);
 HRESULT vkd3d_create_buffer(struct d3d12_device *device,
         const D3D12_HEAP_PROPERTIES *heap_properties, D3D12_HEAP_FLAGS heap_flags,
         const D3D12_RESOURCE_DESC *desc, VkBuffer *vk_buffer);
@@ -674,11 +919,16 @@ struct vkd3d_view
         VkSampler vk_sampler;
     } u;
     VkBufferView vk_counter_view;
+    VkDeviceAddress vk_counter_address;
+    /* Set for render target and depth stencil views, which may be
+     * referenced by cached framebuffers. */
+    bool is_attachment;
     const struct vkd3d_format *format;
     union
     {
         struct
         {
+            VkDeviceAddress address;
             VkDeviceSize offset;
             VkDeviceSize size;
         } buffer;
@@ -695,6 +945,24 @@ struct vkd3d_view
 void vkd3d_view_decref(struct vkd3d_view *view, struct d3d12_device *device);
 void vkd3d_view_incref(struct vkd3d_view *view);
 
+/* Descriptors are read without locking, so a view whose last reference is
+ * dropped may still be about to be referenced by a concurrent reader. Such
+ * views are retired to the current epoch and destroyed once every reader which
+ * entered in the epoch before it has left. */
+struct vkd3d_view_reclaimer
+{
+    LONG volatile epoch;
+    LONG volatile reader_counts[2];
+
+    struct vkd3d_mutex mutex;
+    struct vkd3d_view **retired_views[2];
+    size_t retired_views_size[2];
+    size_t retired_view_count[2];
+};
+
+void vkd3d_view_reclaimer_cleanup(struct vkd3d_view_reclaimer *reclaimer, struct d3d12_device *device);
+void vkd3d_view_reclaimer_init(struct vkd3d_view_reclaimer *reclaimer);
+
 struct vkd3d_texture_view_desc
 {
     VkImageViewType view_type;
@@ -717,6 +985,9 @@ struct vkd3d_view_info
 {
     uint64_t written_serial_id;
     struct vkd3d_view *view;
+    /* Image and sampler descriptors only. Stored inline so descriptor update
+     * templates can read it straight from the heap. */
+    VkDescriptorImageInfo vk_image_info;
 };
 
 struct d3d12_desc
@@ -732,6 +1003,8 @@ struct d3d12_desc
         } u;
     } s;
     unsigned int index;
+    /* Odd while a write is in progress. Readers retry if it changes. */
+    LONG volatile seq;
 };
 
 static inline struct d3d12_desc *d3d12_desc_from_cpu_handle(D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle)
@@ -759,6 +1032,7 @@ void d3d12_desc_create_uav(struct d3d12_desc *descriptor, struct d3d12_device *d
         struct d3d12_resource *resource, struct d3d12_resource *counter_resource,
         const D3D12_UNORDERED_ACCESS_VIEW_DESC *desc);
 void d3d12_desc_create_sampler(struct d3d12_desc *sampler, struct d3d12_device *device, const D3D12_SAMPLER_DESC *desc);
+void d3d12_desc_read_atomic(struct d3d12_desc *dst, const struct d3d12_desc *src, struct d3d12_device *device);
 void d3d12_desc_write_atomic(struct d3d12_desc *dst, const struct d3d12_desc *src, struct d3d12_device *device);
 
 bool vkd3d_create_raw_buffer_view(struct d3d12_device *device,
@@ -836,6 +1110,9 @@ struct vkd3d_vk_descriptor_heap_layout
     D3D12_DESCRIPTOR_HEAP_TYPE applicable_heap_type;
     unsigned int count;
     VkDescriptorSetLayout vk_set_layout;
+    /* Descriptor buffer layout. */
+    VkDeviceSize binding_offset;
+    size_t descriptor_size;
 };
 
 #define VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE 64
@@ -849,6 +1126,18 @@ struct d3d12_descriptor_heap_vk_set
     VkWriteDescriptorSet vk_descriptor_writes[VKD3D_DESCRIPTOR_WRITE_BUFFER_SIZE];
 };
 
+/* Descriptor data for VK_EXT_descriptor_buffer. Each Vulkan descriptor set
+ * index occupies a region of the buffer, starting at set_offsets[set]. Heaps
+ * which are not shader visible keep their data in host memory. */
+struct d3d12_descriptor_heap_buffer
+{
+    VkBuffer vk_buffer;
+    VkDeviceMemory vk_memory;
+    VkDeviceAddress vk_address;
+    BYTE *data;
+    VkDeviceSize set_offsets[VKD3D_SET_INDEX_COUNT];
+};
+
 /* ID3D12DescriptorHeap */
 struct d3d12_descriptor_heap
 {
@@ -866,6 +1155,8 @@ struct d3d12_descriptor_heap
     struct d3d12_descriptor_heap_vk_set vk_descriptor_sets[VKD3D_SET_INDEX_COUNT];
     struct vkd3d_mutex vk_sets_mutex;
 
+    struct d3d12_descriptor_heap_buffer descriptor_buffer;
+
     BYTE descriptors[];
 };
 
@@ -898,6 +1189,8 @@ struct d3d12_desc_copy_info
 void d3d12_desc_copy_vk_heap_range(struct d3d12_desc_copy_location *locations, const struct d3d12_desc_copy_info *info,
         struct d3d12_descriptor_heap *descriptor_heap, enum vkd3d_vk_descriptor_set_index set,
         struct d3d12_device *device);
+void d3d12_desc_copy_contiguous(struct d3d12_desc *dst, const struct d3d12_desc *src,
+        unsigned int count, struct d3d12_device *device);
 
 /* ID3D12QueryHeap */
 struct d3d12_query_heap
@@ -955,6 +1248,9 @@ struct d3d12_root_descriptor_table
 {
     unsigned int range_count;
     struct d3d12_root_descriptor_table_range *ranges;
+    /* Writes the whole table from the descriptor heap, if it contains only
+     * bounded ranges and all SRVs and UAVs are image views. */
+    VkDescriptorUpdateTemplateKHR vk_template;
 };
 
 struct d3d12_root_constant
@@ -1005,6 +1301,8 @@ struct d3d12_root_signature
     uint32_t push_descriptor_mask;
 
     D3D12_ROOT_SIGNATURE_FLAGS flags;
+    /* Hash of the serialized root signature. */
+    uint64_t hash;
 
     unsigned int binding_count;
     unsigned int uav_mapping_count;
@@ -1070,7 +1368,10 @@ struct d3d12_graphics_pipeline_state
 
     const struct d3d12_root_signature *root_signature;
 
-    struct list compiled_pipelines;
+    /* Hash table of pipeline variants. Entries are only ever prepended to
+     * a bucket and live as long as the pipeline state, so lookups need no
+     * lock. */
+    struct vkd3d_compiled_pipeline * volatile compiled_pipelines[VKD3D_COMPILED_PIPELINE_BUCKET_COUNT];
 
     bool xfb_enabled;
 };
@@ -1110,6 +1411,20 @@ struct d3d12_pipeline_state
 
     struct d3d12_pipeline_uav_counter_state uav_counters;
 
+    /* SPIR-V of every stage, retained for GetCachedBlob(). */
+    struct vkd3d_shader_cache_entry *stage_code[VKD3D_MAX_SHADER_STAGES];
+    unsigned int stage_code_count;
+    uint64_t root_signature_hash;
+    /* Fixed-function state of graphics pipelines, so that cached blobs are
+     * only used with a matching description. */
+    struct vkd3d_shader_source_key desc_key;
+
+    /* Pending background compilation, protected by the device pipeline
+     * compiler mutex. See d3d12_pipeline_state_wait(). */
+    struct d3d12_pipeline_compile_job *compile_job;
+    LONG compile_pending;
+    HRESULT compile_hr;
+
     struct d3d12_device *device;
 
     struct vkd3d_private_store private_store;
@@ -1141,14 +1456,86 @@ HRESULT d3d12_pipeline_state_create_compute(struct d3d12_device *device,
         const D3D12_COMPUTE_PIPELINE_STATE_DESC *desc, struct d3d12_pipeline_state **state);
 HRESULT d3d12_pipeline_state_create_graphics(struct d3d12_device *device,
         const D3D12_GRAPHICS_PIPELINE_STATE_DESC *desc, struct d3d12_pipeline_state **state);
+HRESULT d3d12_pipeline_state_wait(struct d3d12_pipeline_state *state);
 VkPipeline d3d12_pipeline_state_get_or_create_pipeline(struct d3d12_pipeline_state *state,
         D3D12_PRIMITIVE_TOPOLOGY topology, const uint32_t *strides, VkFormat dsv_format, VkRenderPass *vk_render_pass);
+HRESULT d3d12_pipeline_state_get_render_pass_variant(struct d3d12_pipeline_state *state,
+        VkFormat dsv_format, uint32_t clear_mask, uint32_t discard_mask, VkRenderPass *vk_render_pass);
 struct d3d12_pipeline_state *unsafe_impl_from_ID3D12PipelineState(ID3D12PipelineState *iface);
 
+/* ID3D12PipelineLibrary */
+struct d3d12_pipeline_library
+{
+    ID3D12PipelineLibrary ID3D12PipelineLibrary_iface;
+    LONG refcount;
+
+    struct vkd3d_mutex mutex;
+    struct rb_tree pipelines;
+    size_t serialized_size;
+
+    struct d3d12_device *device;
+
+    struct vkd3d_private_store private_store;
+};
+
+HRESULT d3d12_pipeline_library_create(struct d3d12_device *device, const void *blob,
+        size_t blob_size, struct d3d12_pipeline_library **library);
+
 struct vkd3d_buffer
 {
     VkBuffer vk_buffer;
     VkDeviceMemory vk_memory;
+    VkDeviceSize size;
+};
+
+/* Barriers recorded by ResourceBarrier() which are not yet in the command
+ * buffer. They are flushed as a single vkCmdPipelineBarrier() before the next
+ * command which may access resources. */
+struct vkd3d_barrier_batch
+{
+    VkPipelineStageFlags src_stage_mask;
+    VkPipelineStageFlags dst_stage_mask;
+
+    VkMemoryBarrier memory_barrier;
+    bool has_memory_barrier;
+
+    VkBufferMemoryBarrier *buffer_barriers;
+    size_t buffer_barriers_size;
+    size_t buffer_barrier_count;
+
+    VkImageMemoryBarrier *image_barriers;
+    size_t image_barriers_size;
+    size_t image_barrier_count;
+};
+
+/* Vulkan commands recorded by command lists in deferred recording mode. The
+ * stream is an arena owned by the command allocator. It's translated into the
+ * Vulkan command buffer before the next command which isn't deferred, and in
+ * Close(), and rewound afterwards. */
+struct vkd3d_command_stream
+{
+    uint8_t *data;
+    size_t data_size;
+    size_t size;
+
+    /* Translation state, which persists for the whole command buffer. */
+    VkPipeline vk_pipelines[2];
+    VkViewport viewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    unsigned int viewport_count;
+    VkRect2D scissors[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    unsigned int scissor_count;
+    VkRenderPass vk_render_pass;
+    VkFramebuffer vk_framebuffer;
+    VkRect2D render_area;
+    struct vkd3d_barrier_batch barriers;
+
+    /* Statistics, reported in Close(). Timings are only gathered if warnings
+     * are enabled. */
+    unsigned int command_count;
+    unsigned int dropped_command_count;
+    bool collect_timings;
+    uint64_t record_time_ns;
+    uint64_t translation_time_ns;
 };
 
 /* ID3D12CommandAllocator */
@@ -1163,20 +1550,9 @@ struct d3d12_command_allocator
     VkCommandPool vk_command_pool;
 
     VkDescriptorPool vk_descriptor_pool;
+    unsigned int descriptor_set_count;
 
-    VkDescriptorPool *free_descriptor_pools;
-    size_t free_descriptor_pools_size;
-    size_t free_descriptor_pool_count;
-
-    VkRenderPass *passes;
-    size_t passes_size;
-    size_t pass_count;
-
-    VkFramebuffer *framebuffers;
-    size_t framebuffers_size;
-    size_t framebuffer_count;
-
-    VkDescriptorPool *descriptor_pools;
+    struct vkd3d_descriptor_pool **descriptor_pools;
     size_t descriptor_pools_size;
     size_t descriptor_pool_count;
 
@@ -1188,14 +1564,20 @@ struct d3d12_command_allocator
     size_t buffer_views_size;
     size_t buffer_view_count;
 
+    /* Transfer buffers form a linear arena. Ranges are handed out from the
+     * current buffer and the arena is rewound when the allocator is reset. */
     struct vkd3d_buffer *transfer_buffers;
     size_t transfer_buffers_size;
     size_t transfer_buffer_count;
+    size_t transfer_buffer_idx;
+    VkDeviceSize transfer_buffer_offset;
 
     VkCommandBuffer *command_buffers;
     size_t command_buffers_size;
     size_t command_buffer_count;
 
+    struct vkd3d_command_stream command_stream;
+
     struct d3d12_command_list *current_command_list;
     struct d3d12_device *device;
 
@@ -1223,6 +1605,7 @@ struct vkd3d_pipeline_bindings
     const struct d3d12_root_signature *root_signature;
 
     VkPipelineBindPoint vk_bind_point;
+    VkPipeline vk_pipeline;
     /* All descriptor sets at index > 1 are for unbounded d3d12 ranges. Set
      * 0 or 1 may be unbounded too. */
     size_t descriptor_set_count;
@@ -1243,6 +1626,12 @@ struct vkd3d_pipeline_bindings
     struct vkd3d_push_descriptor push_descriptors[D3D12_MAX_ROOT_COST / 2];
     uint32_t push_descriptor_dirty_mask;
     uint32_t push_descriptor_active_mask;
+
+    /* Root constants, indexed by their push constant offset in 32-bit
+     * values. Changed values are pushed before the next draw or dispatch. */
+    uint32_t push_constants[D3D12_MAX_ROOT_COST];
+    uint64_t push_constant_dirty_mask;
+    uint64_t push_constant_valid_mask;
 };
 
 enum vkd3d_pipeline_bind_point
@@ -1253,6 +1642,31 @@ enum vkd3d_pipeline_bind_point
 };
 
 /* ID3D12CommandList */
+/* A ClearRenderTargetView() or ClearDepthStencilView() covering the whole
+ * view. It is folded into the load ops of the next render pass binding the
+ * view, or recorded as a separate clear pass before the next barrier. */
+struct vkd3d_pending_clear
+{
+    struct d3d12_resource *resource;
+    struct vkd3d_view *view;
+    VkSampleCountFlagBits sample_count;
+    unsigned int width;
+    unsigned int height;
+    unsigned int layer_count;
+    VkImageAspectFlags aspect_mask;
+    VkClearValue value;
+};
+
+/* Subresources of a render target or depth stencil resource discarded by
+ * DiscardResource(). The next render pass binding them doesn't load their
+ * contents, and the next transition uses VK_IMAGE_LAYOUT_UNDEFINED as the
+ * old layout. */
+struct vkd3d_pending_discard
+{
+    struct d3d12_resource *resource;
+    VkImageSubresourceRange range;
+};
+
 struct d3d12_command_list
 {
     ID3D12GraphicsCommandList2 ID3D12GraphicsCommandList2_iface;
@@ -1263,6 +1677,7 @@ struct d3d12_command_list
 
     bool is_recording;
     bool is_valid;
+    bool is_deferred;
     VkCommandBuffer vk_command_buffer;
 
     uint32_t strides[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
@@ -1270,8 +1685,22 @@ struct d3d12_command_list
 
     DXGI_FORMAT index_buffer_format;
 
+    /* Vertex and index buffers set by the application. Changed bindings are
+     * recorded before the next draw. */
+    VkBuffer vertex_buffers[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    VkDeviceSize vertex_buffer_offsets[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    uint32_t vertex_buffer_dirty_mask;
+    VkBuffer index_buffer;
+    VkDeviceSize index_buffer_offset;
+    VkIndexType index_type;
+    bool index_buffer_dirty;
+
     VkImageView rtvs[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
     VkImageView dsv;
+    struct d3d12_resource *rtv_resources[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    struct d3d12_resource *dsv_resource;
+    struct vkd3d_view *rtv_views[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    struct vkd3d_view *dsv_view;
     unsigned int fb_width;
     unsigned int fb_height;
     unsigned int fb_layer_count;
@@ -1285,8 +1714,21 @@ struct d3d12_command_list
     VkPipeline current_pipeline;
     VkRenderPass pso_render_pass;
     VkRenderPass current_render_pass;
+    struct vkd3d_barrier_batch barriers;
+    struct vkd3d_pending_clear *pending_clears;
+    size_t pending_clears_size;
+    size_t pending_clear_count;
+    struct vkd3d_pending_discard *pending_discards;
+    size_t pending_discards_size;
+    size_t pending_discard_count;
     struct vkd3d_pipeline_bindings pipeline_bindings[VKD3D_PIPELINE_BIND_POINT_COUNT];
 
+    /* Heaps bound as descriptor buffers, indexed by D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
+     * and D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER. */
+    const struct d3d12_descriptor_heap *descriptor_buffer_heaps[2];
+    uint64_t descriptor_buffer_heap_ids[2];
+    uint32_t descriptor_buffer_indices[2];
+
     struct d3d12_pipeline_state *state;
 
     struct d3d12_command_allocator *allocator;
@@ -1297,6 +1739,11 @@ struct d3d12_command_list
 
     void (*update_descriptors)(struct d3d12_command_list *list, enum vkd3d_pipeline_bind_point bind_point);
 
+    /* Commands recorded into a bundle, replayed by ExecuteBundle(). */
+    uint8_t *bundle_data;
+    size_t bundle_data_size;
+    size_t bundle_size;
+
     struct vkd3d_private_store private_store;
 };
 
@@ -1362,6 +1809,7 @@ struct vkd3d_cs_execute
 
 struct vkd3d_cs_op_data
 {
+    struct vkd3d_cs_op_data *next;
     enum vkd3d_cs_op opcode;
     union
     {
@@ -1371,13 +1819,6 @@ struct vkd3d_cs_op_data
     } u;
 };
 
-struct d3d12_command_queue_op_array
-{
-    struct vkd3d_cs_op_data *ops;
-    size_t count;
-    size_t size;
-};
-
 /* ID3D12CommandQueue */
 struct d3d12_command_queue
 {
@@ -1388,22 +1829,34 @@ struct d3d12_command_queue
 
     struct vkd3d_queue *vkd3d_queue;
 
-    struct vkd3d_fence_worker fence_worker;
     const struct d3d12_fence *last_waited_fence;
     uint64_t last_waited_fence_value;
 
     struct d3d12_device *device;
 
-    struct vkd3d_mutex op_mutex;
-
-    /* These fields are protected by op_mutex. */
-    struct d3d12_command_queue_op_array op_queue;
-    bool is_flushing;
-
-    /* This field is not protected by op_mutex, but can only be used
-     * by the thread that set is_flushing; when is_flushing is not
-     * set, aux_op_queue.count must be zero. */
-    struct d3d12_command_queue_op_array aux_op_queue;
+    /* Lock-free list of submitted ops, newest first. Any thread may push
+     * ops; the flushing thread takes the whole list at once. */
+    struct vkd3d_cs_op_data * volatile op_head;
+    LONG is_flushing;
+    LONG flush_requested;
+
+    /* These fields can only be used by the thread that set is_flushing.
+     * They hold ops taken from op_head which are not executed yet, oldest
+     * first. */
+    struct vkd3d_cs_op_data *pending_head;
+    struct vkd3d_cs_op_data *pending_tail;
+    VkSubmitInfo *submit_infos;
+    size_t submit_infos_size;
+
+    /* Optional thread which flushes ops on behalf of the submitting
+     * threads. submit_idle_cond is signalled after each flush. */
+    bool use_submit_thread;
+    bool submit_thread_exit;
+    LONG submit_pending;
+    struct vkd3d_mutex submit_mutex;
+    struct vkd3d_cond submit_cond;
+    struct vkd3d_cond submit_idle_cond;
+    union vkd3d_thread_handle submit_thread;
 
     struct vkd3d_private_store private_store;
 };
@@ -1491,7 +1944,7 @@ void vkd3d_uav_clear_state_cleanup(struct vkd3d_uav_clear_state *state, struct d
 /* ID3D12Device */
 struct d3d12_device
 {
-    ID3D12Device ID3D12Device_iface;
+    ID3D12Device1 ID3D12Device1_iface;
     LONG refcount;
 
     VkDevice vk_device;
@@ -1503,9 +1956,21 @@ struct d3d12_device
     struct vkd3d_gpu_va_allocator gpu_va_allocator;
 
     struct vkd3d_mutex mutex;
-    struct vkd3d_mutex desc_mutex[8];
+    struct vkd3d_view_reclaimer view_reclaimer;
+    struct vkd3d_fence_worker fence_worker;
+    struct vkd3d_memory_allocator memory_allocator;
     struct vkd3d_render_pass_cache render_pass_cache;
+    struct vkd3d_framebuffer_cache framebuffer_cache;
+    struct vkd3d_descriptor_pool_cache descriptor_pool_cache;
+    struct vkd3d_shader_cache shader_cache;
+    struct vkd3d_pipeline_compiler pipeline_compiler;
     VkPipelineCache vk_pipeline_cache;
+    /* Only set when the pipeline cache is persistent. */
+    char *pipeline_cache_path;
+    size_t pipeline_cache_max_size;
+    VkDeviceSize transfer_buffer_size;
+    /* Used to validate both persistent and per-PSO cached data. */
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
 
     VkPhysicalDeviceMemoryProperties memory_properties;
 
@@ -1525,9 +1990,17 @@ struct d3d12_device
     unsigned int queue_family_count;
     VkTimeDomainEXT vk_host_time_domain;
 
+    /* Command queues blocked on a wait for a fence value which has no
+     * pending signal yet. Each entry holds a reference to the fence. */
     struct vkd3d_mutex blocked_queues_mutex;
-    struct d3d12_command_queue *blocked_queues[VKD3D_MAX_DEVICE_BLOCKED_QUEUES];
-    unsigned int blocked_queue_count;
+    struct vkd3d_blocked_queue
+    {
+        struct d3d12_command_queue *queue;
+        struct d3d12_fence *fence;
+        uint64_t value;
+    } *blocked_queues;
+    size_t blocked_queues_size;
+    size_t blocked_queue_count;
 
     struct vkd3d_instance *vkd3d_instance;
 
@@ -1547,6 +2020,7 @@ struct d3d12_device
     VkDescriptorPoolSize vk_pool_sizes[VKD3D_DESCRIPTOR_POOL_COUNT];
     struct vkd3d_vk_descriptor_heap_layout vk_descriptor_heap_layouts[VKD3D_SET_INDEX_COUNT];
     bool use_vk_heaps;
+    bool use_descriptor_buffers;
 };
 
 HRESULT d3d12_device_create(struct vkd3d_instance *instance,
@@ -1555,40 +2029,28 @@ struct vkd3d_queue *d3d12_device_get_vkd3d_queue(struct d3d12_device *device, D3
 bool d3d12_device_is_uma(struct d3d12_device *device, bool *coherent);
 void d3d12_device_mark_as_removed(struct d3d12_device *device, HRESULT reason,
         const char *message, ...) VKD3D_PRINTF_FUNC(3, 4);
-struct d3d12_device *unsafe_impl_from_ID3D12Device(ID3D12Device *iface);
+struct d3d12_device *unsafe_impl_from_ID3D12Device1(ID3D12Device1 *iface);
+uint64_t vkd3d_get_build_hash(void);
 
 static inline HRESULT d3d12_device_query_interface(struct d3d12_device *device, REFIID iid, void **object)
 {
-    return ID3D12Device_QueryInterface(&device->ID3D12Device_iface, iid, object);
+    return ID3D12Device1_QueryInterface(&device->ID3D12Device1_iface, iid, object);
 }
 
 static inline ULONG d3d12_device_add_ref(struct d3d12_device *device)
 {
-    return ID3D12Device_AddRef(&device->ID3D12Device_iface);
+    return ID3D12Device1_AddRef(&device->ID3D12Device1_iface);
 }
 
 static inline ULONG d3d12_device_release(struct d3d12_device *device)
 {
-    return ID3D12Device_Release(&device->ID3D12Device_iface);
+    return ID3D12Device1_Release(&device->ID3D12Device1_iface);
 }
 
 static inline unsigned int d3d12_device_get_descriptor_handle_increment_size(struct d3d12_device *device,
         D3D12_DESCRIPTOR_HEAP_TYPE descriptor_type)
 {
-    return ID3D12Device_GetDescriptorHandleIncrementSize(&device->ID3D12Device_iface, descriptor_type);
-}
-
-static inline struct vkd3d_mutex *d3d12_device_get_descriptor_mutex(struct d3d12_device *device,
-        const struct d3d12_desc *descriptor)
-{
-    STATIC_ASSERT(!(ARRAY_SIZE(device->desc_mutex) & (ARRAY_SIZE(device->desc_mutex) - 1)));
-    uintptr_t idx = (uintptr_t)descriptor;
-
-    idx ^= idx >> 12;
-    idx ^= idx >> 6;
-    idx ^= idx >> 3;
-
-    return &device->desc_mutex[idx & (ARRAY_SIZE(device->desc_mutex) - 1)];
+    return ID3D12Device1_GetDescriptorHandleIncrementSize(&device->ID3D12Device1_iface, descriptor_type);
 }
 
 /* utils */
@@ -1720,6 +2182,10 @@ extern const char vkd3d_build[];
 
 bool vkd3d_get_program_name(char program_name[PATH_MAX]);
 
+void *vkd3d_load_file(const char *path, size_t *size);
+bool vkd3d_store_file_atomic(const char *path, const void *data, size_t size);
+void vkd3d_remove_file(const char *path);
+
 VkResult vkd3d_set_vk_object_name_utf8(struct d3d12_device *device, uint64_t vk_object,
         VkDebugReportObjectTypeEXT vk_object_type, const char *name);
 HRESULT vkd3d_set_vk_object_name(struct d3d12_device *device, uint64_t vk_object,
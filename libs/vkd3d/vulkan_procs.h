@@ -180,6 +180,14 @@ VK_DEVICE_PFN(vkUnmapMemory)
 VK_DEVICE_PFN(vkUpdateDescriptorSets)
 VK_DEVICE_PFN(vkWaitForFences)
 
+/* VK_KHR_buffer_device_address */
+VK_DEVICE_EXT_PFN(vkGetBufferDeviceAddressKHR)
+
+/* VK_KHR_descriptor_update_template */
+VK_DEVICE_EXT_PFN(vkCreateDescriptorUpdateTemplateKHR)
+VK_DEVICE_EXT_PFN(vkDestroyDescriptorUpdateTemplateKHR)
+VK_DEVICE_EXT_PFN(vkUpdateDescriptorSetWithTemplateKHR)
+
 /* VK_KHR_draw_indirect_count */
 VK_DEVICE_EXT_PFN(vkCmdDrawIndirectCountKHR)
 VK_DEVICE_EXT_PFN(vkCmdDrawIndexedIndirectCountKHR)
@@ -207,6 +215,16 @@ VK_DEVICE_EXT_PFN(vkGetCalibratedTimestampsEXT)
 VK_DEVICE_EXT_PFN(vkCmdBeginConditionalRenderingEXT)
 VK_DEVICE_EXT_PFN(vkCmdEndConditionalRenderingEXT)
 
+#ifdef VK_EXT_descriptor_buffer
+/* VK_EXT_descriptor_buffer */
+VK_DEVICE_EXT_PFN(vkCmdBindDescriptorBufferEmbeddedSamplersEXT)
+VK_DEVICE_EXT_PFN(vkCmdBindDescriptorBuffersEXT)
+VK_DEVICE_EXT_PFN(vkCmdSetDescriptorBufferOffsetsEXT)
+VK_DEVICE_EXT_PFN(vkGetDescriptorEXT)
+VK_DEVICE_EXT_PFN(vkGetDescriptorSetLayoutBindingOffsetEXT)
+VK_DEVICE_EXT_PFN(vkGetDescriptorSetLayoutSizeEXT)
+#endif
+
 /* VK_EXT_debug_marker */
 VK_DEVICE_EXT_PFN(vkDebugMarkerSetObjectNameEXT)
 
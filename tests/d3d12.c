@@ -2974,6 +2974,244 @@ static void test_create_compute_pipeline_state(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+static void test_pipeline_state_cached_blob(void)
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC pipeline_state_desc;
+    ID3D12RootSignature *root_signature, *root_signature2;
+    D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
+    D3D12_ROOT_PARAMETER root_parameter;
+    ID3D12PipelineState *pipeline_state;
+    ID3D12Device *device;
+    uint8_t *blob_data;
+    SIZE_T blob_size;
+    ID3DBlob *blob;
+    ULONG refcount;
+    HRESULT hr;
+
+    static const DWORD dxbc_code[] =
+    {
+#if 0
+        [numthreads(1, 1, 1)]
+        void main() { }
+#endif
+        0x43425844, 0x1acc3ad0, 0x71c7b057, 0xc72c4306, 0xf432cb57, 0x00000001, 0x00000074, 0x00000003,
+        0x0000002c, 0x0000003c, 0x0000004c, 0x4e475349, 0x00000008, 0x00000000, 0x00000008, 0x4e47534f,
+        0x00000008, 0x00000000, 0x00000008, 0x58454853, 0x00000020, 0x00050050, 0x00000008, 0x0100086a,
+        0x0400009b, 0x00000001, 0x00000001, 0x00000001, 0x0100003e,
+    };
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    root_signature_desc.NumParameters = 0;
+    root_signature_desc.pParameters = NULL;
+    root_signature_desc.NumStaticSamplers = 0;
+    root_signature_desc.pStaticSamplers = NULL;
+    root_signature_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+    hr = create_root_signature(device, &root_signature_desc, &root_signature);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+
+    root_parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    root_parameter.Constants.ShaderRegister = 0;
+    root_parameter.Constants.RegisterSpace = 0;
+    root_parameter.Constants.Num32BitValues = 1;
+    root_parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+    root_signature_desc.NumParameters = 1;
+    root_signature_desc.pParameters = &root_parameter;
+    hr = create_root_signature(device, &root_signature_desc, &root_signature2);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+
+    memset(&pipeline_state_desc, 0, sizeof(pipeline_state_desc));
+    pipeline_state_desc.pRootSignature = root_signature;
+    pipeline_state_desc.CS = shader_bytecode(dxbc_code, sizeof(dxbc_code));
+
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to create compute pipeline, hr %#x.\n", hr);
+
+    hr = ID3D12PipelineState_GetCachedBlob(pipeline_state, &blob);
+    ok(hr == S_OK, "Failed to get cached blob, hr %#x.\n", hr);
+    ok(ID3D10Blob_GetBufferSize(blob), "Got unexpected blob size.\n");
+    ID3D12PipelineState_Release(pipeline_state);
+
+    pipeline_state_desc.CachedPSO.pCachedBlob = ID3D10Blob_GetBufferPointer(blob);
+    pipeline_state_desc.CachedPSO.CachedBlobSizeInBytes = ID3D10Blob_GetBufferSize(blob);
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to create compute pipeline from cached blob, hr %#x.\n", hr);
+    refcount = ID3D12PipelineState_Release(pipeline_state);
+    ok(!refcount, "ID3D12PipelineState has %u references left.\n", (unsigned int)refcount);
+
+    /* The blob was created for a different root signature. */
+    pipeline_state_desc.pRootSignature = root_signature2;
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    pipeline_state_desc.pRootSignature = root_signature;
+
+    blob_size = ID3D10Blob_GetBufferSize(blob);
+    blob_data = malloc(blob_size);
+    ok(blob_data, "Failed to allocate memory.\n");
+    pipeline_state_desc.CachedPSO.pCachedBlob = blob_data;
+
+    memcpy(blob_data, ID3D10Blob_GetBufferPointer(blob), blob_size);
+    blob_data[0] ^= 0xff;
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    memcpy(blob_data, ID3D10Blob_GetBufferPointer(blob), blob_size);
+    blob_data[4] ^= 0xff;
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == D3D12_ERROR_DRIVER_VERSION_MISMATCH, "Got unexpected hr %#x.\n", hr);
+
+    memcpy(blob_data, ID3D10Blob_GetBufferPointer(blob), blob_size);
+    pipeline_state_desc.CachedPSO.CachedBlobSizeInBytes = blob_size - 1;
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    free(blob_data);
+    ID3D10Blob_Release(blob);
+
+    refcount = ID3D12RootSignature_Release(root_signature2);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+    refcount = ID3D12RootSignature_Release(root_signature);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
+static void test_pipeline_library(void)
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC pipeline_state_desc;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphics_desc;
+    D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
+    ID3D12PipelineLibrary *library, *library2;
+    ID3D12RootSignature *root_signature;
+    ID3D12PipelineState *pipeline_state;
+    ID3D12Device1 *device1;
+    ID3D12Device *device;
+    SIZE_T size;
+    ULONG refcount;
+    void *data;
+    HRESULT hr;
+
+    static const WCHAR csW[] = {'c', 's', 0};
+    static const WCHAR gfxW[] = {'g', 'f', 'x', 0};
+    static const WCHAR missingW[] = {'m', 'i', 's', 's', 'i', 'n', 'g', 0};
+    static const DWORD dxbc_code[] =
+    {
+#if 0
+        [numthreads(1, 1, 1)]
+        void main() { }
+#endif
+        0x43425844, 0x1acc3ad0, 0x71c7b057, 0xc72c4306, 0xf432cb57, 0x00000001, 0x00000074, 0x00000003,
+        0x0000002c, 0x0000003c, 0x0000004c, 0x4e475349, 0x00000008, 0x00000000, 0x00000008, 0x4e47534f,
+        0x00000008, 0x00000000, 0x00000008, 0x58454853, 0x00000020, 0x00050050, 0x00000008, 0x0100086a,
+        0x0400009b, 0x00000001, 0x00000001, 0x00000001, 0x0100003e,
+    };
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    if (FAILED(hr = ID3D12Device_QueryInterface(device, &IID_ID3D12Device1, (void **)&device1)))
+    {
+        skip("ID3D12Device1 is not supported, hr %#x.\n", hr);
+        ID3D12Device_Release(device);
+        return;
+    }
+
+    root_signature_desc.NumParameters = 0;
+    root_signature_desc.pParameters = NULL;
+    root_signature_desc.NumStaticSamplers = 0;
+    root_signature_desc.pStaticSamplers = NULL;
+    root_signature_desc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+    hr = create_root_signature(device, &root_signature_desc, &root_signature);
+    ok(hr == S_OK, "Failed to create root signature, hr %#x.\n", hr);
+
+    memset(&pipeline_state_desc, 0, sizeof(pipeline_state_desc));
+    pipeline_state_desc.pRootSignature = root_signature;
+    pipeline_state_desc.CS = shader_bytecode(dxbc_code, sizeof(dxbc_code));
+    hr = ID3D12Device_CreateComputePipelineState(device, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to create compute pipeline, hr %#x.\n", hr);
+
+    hr = ID3D12Device1_CreatePipelineLibrary(device1, NULL, 0, &IID_ID3D12PipelineLibrary, (void **)&library);
+    ok(hr == S_OK, "Failed to create pipeline library, hr %#x.\n", hr);
+
+    hr = ID3D12PipelineLibrary_StorePipeline(library, csW, pipeline_state);
+    ok(hr == S_OK, "Failed to store pipeline, hr %#x.\n", hr);
+    hr = ID3D12PipelineLibrary_StorePipeline(library, csW, pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    ID3D12PipelineState_Release(pipeline_state);
+
+    init_pipeline_state_desc(&graphics_desc, root_signature, DXGI_FORMAT_R8G8B8A8_UNORM, NULL, NULL, NULL);
+    hr = ID3D12Device_CreateGraphicsPipelineState(device, &graphics_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to create graphics pipeline, hr %#x.\n", hr);
+    hr = ID3D12PipelineLibrary_StorePipeline(library, gfxW, pipeline_state);
+    ok(hr == S_OK, "Failed to store pipeline, hr %#x.\n", hr);
+    ID3D12PipelineState_Release(pipeline_state);
+
+    size = ID3D12PipelineLibrary_GetSerializedSize(library);
+    ok(size, "Got unexpected serialized size.\n");
+    data = malloc(size);
+    hr = ID3D12PipelineLibrary_Serialize(library, data, size - 1);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D12PipelineLibrary_Serialize(library, data, size);
+    ok(hr == S_OK, "Failed to serialize pipeline library, hr %#x.\n", hr);
+    ID3D12PipelineLibrary_Release(library);
+
+    hr = ID3D12Device1_CreatePipelineLibrary(device1, data, size, &IID_ID3D12PipelineLibrary, (void **)&library2);
+    ok(hr == S_OK, "Failed to create pipeline library, hr %#x.\n", hr);
+    ok(ID3D12PipelineLibrary_GetSerializedSize(library2) == size, "Got unexpected serialized size.\n");
+
+    hr = ID3D12PipelineLibrary_LoadComputePipeline(library2, missingW, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D12PipelineLibrary_LoadComputePipeline(library2, csW, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to load compute pipeline, hr %#x.\n", hr);
+    ID3D12PipelineState_Release(pipeline_state);
+
+    hr = ID3D12PipelineLibrary_LoadComputePipeline(library2, gfxW, &pipeline_state_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    hr = ID3D12PipelineLibrary_LoadGraphicsPipeline(library2, gfxW, &graphics_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == S_OK, "Failed to load graphics pipeline, hr %#x.\n", hr);
+    ID3D12PipelineState_Release(pipeline_state);
+
+    /* The description must match the stored pipeline. */
+    graphics_desc.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT;
+    hr = ID3D12PipelineLibrary_LoadGraphicsPipeline(library2, gfxW, &graphics_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+    graphics_desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    graphics_desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_RED;
+    hr = ID3D12PipelineLibrary_LoadGraphicsPipeline(library2, gfxW, &graphics_desc,
+            &IID_ID3D12PipelineState, (void **)&pipeline_state);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    refcount = ID3D12PipelineLibrary_Release(library2);
+    ok(!refcount, "ID3D12PipelineLibrary has %u references left.\n", (unsigned int)refcount);
+    free(data);
+
+    refcount = ID3D12RootSignature_Release(root_signature);
+    ok(!refcount, "ID3D12RootSignature has %u references left.\n", (unsigned int)refcount);
+    ID3D12Device1_Release(device1);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
 static void test_create_graphics_pipeline_state(void)
 {
     D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
@@ -3991,6 +4229,161 @@ static void test_cpu_signal_fence(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+static void test_fence_many_waiters(void)
+{
+    static const unsigned int waiter_count = 10000;
+    unsigned int i, j, ret, expected;
+    ID3D12Device *device;
+    ID3D12Fence *fence;
+    HANDLE events[4];
+    ULONG refcount;
+    uint64_t value;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE,
+            &IID_ID3D12Fence, (void **)&fence);
+    ok(SUCCEEDED(hr), "Failed to create fence, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(events); ++i)
+    {
+        events[i] = create_event();
+        ok(events[i], "Failed to create event.\n");
+    }
+
+    /* Attach waiters for every value in [1, waiter_count], in scrambled order. */
+    for (i = 0; i < waiter_count; ++i)
+    {
+        value = (i * 7919u) % waiter_count + 1;
+        hr = ID3D12Fence_SetEventOnCompletion(fence, value, events[value % ARRAY_SIZE(events)]);
+        ok(SUCCEEDED(hr), "Failed to set event on completion, hr %#x.\n", hr);
+    }
+
+    for (value = 1; value <= waiter_count / 2; ++value)
+    {
+        hr = ID3D12Fence_Signal(fence, value);
+        ok(SUCCEEDED(hr), "Failed to signal fence, hr %#x.\n", hr);
+        for (j = 0; j < ARRAY_SIZE(events); ++j)
+        {
+            expected = j == value % ARRAY_SIZE(events) ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+            ret = wait_event(events[j], 0);
+            ok(ret == expected, "Got unexpected return value %#x for value %"PRIu64", event %u.\n",
+                    ret, value, j);
+        }
+    }
+
+    /* Complete all remaining waiters at once. */
+    hr = ID3D12Fence_Signal(fence, waiter_count);
+    ok(SUCCEEDED(hr), "Failed to signal fence, hr %#x.\n", hr);
+    for (j = 0; j < ARRAY_SIZE(events); ++j)
+    {
+        ret = wait_event(events[j], 0);
+        ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x for event %u.\n", ret, j);
+        ret = wait_event(events[j], 0);
+        ok(ret == WAIT_TIMEOUT, "Got unexpected return value %#x for event %u.\n", ret, j);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(events); ++i)
+        destroy_event(events[i]);
+
+    ID3D12Fence_Release(fence);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
+static void test_multiple_fence_wait(void)
+{
+    ID3D12Fence *fences[2];
+    ID3D12Device1 *device1;
+    uint64_t values[2];
+    ID3D12Device *device;
+    unsigned int i, ret;
+    ULONG refcount;
+    HANDLE event;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    if (FAILED(hr = ID3D12Device_QueryInterface(device, &IID_ID3D12Device1, (void **)&device1)))
+    {
+        skip("ID3D12Device1 is not supported, hr %#x.\n", hr);
+        ID3D12Device_Release(device);
+        return;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(fences); ++i)
+    {
+        hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE,
+                &IID_ID3D12Fence, (void **)&fences[i]);
+        ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+    }
+    event = create_event();
+    ok(event, "Failed to create event.\n");
+
+    /* Wait for all fences. */
+    values[0] = 1;
+    values[1] = 2;
+    hr = ID3D12Device1_SetEventOnMultipleFenceCompletion(device1, fences, values, ARRAY_SIZE(fences),
+            D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL, event);
+    ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_TIMEOUT, "Got unexpected return value %#x.\n", ret);
+    hr = ID3D12Fence_Signal(fences[0], 1);
+    ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_TIMEOUT, "Got unexpected return value %#x.\n", ret);
+    hr = ID3D12Fence_Signal(fences[1], 2);
+    ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x.\n", ret);
+
+    /* Wait for any fence. The event is only signaled once. */
+    values[0] = 3;
+    values[1] = 3;
+    hr = ID3D12Device1_SetEventOnMultipleFenceCompletion(device1, fences, values, ARRAY_SIZE(fences),
+            D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY, event);
+    ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_TIMEOUT, "Got unexpected return value %#x.\n", ret);
+    hr = ID3D12Fence_Signal(fences[1], 3);
+    ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x.\n", ret);
+    hr = ID3D12Fence_Signal(fences[0], 3);
+    ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_TIMEOUT, "Got unexpected return value %#x.\n", ret);
+
+    /* Already completed values signal the event immediately. */
+    hr = ID3D12Device1_SetEventOnMultipleFenceCompletion(device1, fences, values, ARRAY_SIZE(fences),
+            D3D12_MULTIPLE_FENCE_WAIT_FLAG_ALL, event);
+    ok(hr == S_OK, "Failed to set event on completion, hr %#x.\n", hr);
+    ret = wait_event(event, 0);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected return value %#x.\n", ret);
+
+    /* A NULL event blocks until the wait is satisfied. */
+    values[0] = 4;
+    hr = ID3D12Device1_SetEventOnMultipleFenceCompletion(device1, fences, values, ARRAY_SIZE(fences),
+            D3D12_MULTIPLE_FENCE_WAIT_FLAG_ANY, NULL);
+    ok(hr == S_OK, "Failed to wait for fences, hr %#x.\n", hr);
+
+    destroy_event(event);
+    for (i = 0; i < ARRAY_SIZE(fences); ++i)
+        ID3D12Fence_Release(fences[i]);
+    ID3D12Device1_Release(device1);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
 static void test_gpu_signal_fence(void)
 {
     ID3D12CommandQueue *queue;
@@ -4328,6 +4721,107 @@ static void test_multithread_fence_wait(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+struct multithread_queue_signal_data
+{
+    ID3D12CommandQueue *queue;
+    ID3D12Fence *fence;
+    unsigned int signal_count;
+};
+
+static void queue_signal_main(void *untyped_data)
+{
+    struct multithread_queue_signal_data *data = untyped_data;
+    unsigned int i;
+    HRESULT hr;
+
+    for (i = 1; i <= data->signal_count; ++i)
+    {
+        hr = ID3D12CommandQueue_Signal(data->queue, data->fence, i);
+        ok(hr == S_OK, "Failed to signal fence, hr %#x.\n", hr);
+    }
+}
+
+static void test_multithread_queue_signal(void)
+{
+    struct multithread_queue_signal_data thread_data[8];
+    ID3D12Fence *wait_fences[ARRAY_SIZE(thread_data)];
+    ID3D12CommandQueue *queue, *wait_queues[32];
+    ID3D12Fence *done_fences[32];
+    HANDLE threads[ARRAY_SIZE(thread_data)];
+    ID3D12Device *device;
+    unsigned int i, j;
+    ULONG refcount;
+    uint64_t value;
+    HRESULT hr;
+
+    if (!(device = create_device()))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+
+    queue = create_command_queue(device, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+
+    for (i = 0; i < ARRAY_SIZE(thread_data); ++i)
+    {
+        hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE,
+                &IID_ID3D12Fence, (void **)&wait_fences[i]);
+        ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+
+        thread_data[i].queue = queue;
+        thread_data[i].fence = wait_fences[i];
+        thread_data[i].signal_count = 1000;
+    }
+
+    /* Block more queues on a wait before signal than the number of
+     * signalling threads. */
+    for (i = 0; i < ARRAY_SIZE(wait_queues); ++i)
+    {
+        wait_queues[i] = create_command_queue(device, D3D12_COMMAND_LIST_TYPE_DIRECT,
+                D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+        hr = ID3D12Device_CreateFence(device, 0, D3D12_FENCE_FLAG_NONE,
+                &IID_ID3D12Fence, (void **)&done_fences[i]);
+        ok(hr == S_OK, "Failed to create fence, hr %#x.\n", hr);
+
+        j = i % ARRAY_SIZE(thread_data);
+        hr = ID3D12CommandQueue_Wait(wait_queues[i], wait_fences[j], thread_data[j].signal_count);
+        ok(hr == S_OK, "Failed to wait for fence, hr %#x.\n", hr);
+        queue_signal(wait_queues[i], done_fences[i], 1);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        threads[i] = create_thread(queue_signal_main, &thread_data[i]);
+        ok(threads[i], "Failed to create thread %u.\n", i);
+    }
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+        ok(join_thread(threads[i]), "Failed to join thread %u.\n", i);
+
+    for (i = 0; i < ARRAY_SIZE(wait_queues); ++i)
+    {
+        hr = wait_for_fence(done_fences[i], 1);
+        ok(hr == S_OK, "Failed to wait for fence %u, hr %#x.\n", i, hr);
+    }
+    for (i = 0; i < ARRAY_SIZE(thread_data); ++i)
+    {
+        hr = wait_for_fence(wait_fences[i], thread_data[i].signal_count);
+        ok(hr == S_OK, "Failed to wait for fence %u, hr %#x.\n", i, hr);
+        value = ID3D12Fence_GetCompletedValue(wait_fences[i]);
+        ok(value == thread_data[i].signal_count, "Got unexpected value %"PRIu64".\n", value);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(wait_queues); ++i)
+    {
+        ID3D12Fence_Release(done_fences[i]);
+        ID3D12CommandQueue_Release(wait_queues[i]);
+    }
+    for (i = 0; i < ARRAY_SIZE(thread_data); ++i)
+        ID3D12Fence_Release(wait_fences[i]);
+    ID3D12CommandQueue_Release(queue);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
+}
+
 static void test_fence_values(void)
 {
     uint64_t value, next_value;
@@ -5348,6 +5842,260 @@ static void test_draw_instanced(void)
     destroy_test_context(&context);
 }
 
+static void test_draw_with_new_pipeline_state(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc;
+    ID3D12GraphicsCommandList *command_list;
+    ID3D12PipelineState *pipeline_states[4];
+    struct test_context_desc desc;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    unsigned int i;
+    HRESULT hr;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.no_pipeline = true;
+    if (!init_test_context(&context, &desc))
+        return;
+    command_list = context.list;
+    queue = context.queue;
+
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+
+    /* Use each pipeline state right after creating it, before any shader
+     * translation done in the background can be expected to have finished. */
+    init_pipeline_state_desc(&pso_desc, context.root_signature, context.render_target_desc.Format, NULL, NULL, NULL);
+    for (i = 0; i < ARRAY_SIZE(pipeline_states); ++i)
+    {
+        hr = ID3D12Device_CreateGraphicsPipelineState(context.device, &pso_desc,
+                &IID_ID3D12PipelineState, (void **)&pipeline_states[i]);
+        ok(hr == S_OK, "Failed to create pipeline state %u, hr %#x.\n", i, hr);
+
+        ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+        ID3D12GraphicsCommandList_SetPipelineState(command_list, pipeline_states[i]);
+        ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    }
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff00ff00, 0);
+
+    for (i = 0; i < ARRAY_SIZE(pipeline_states); ++i)
+        ID3D12PipelineState_Release(pipeline_states[i]);
+    destroy_test_context(&context);
+}
+
+static void test_clear_render_target_view_render_pass(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv_array, rtv_layer;
+    D3D12_RENDER_TARGET_VIEW_DESC rtv_desc;
+    ID3D12GraphicsCommandList *command_list;
+    struct d3d12_resource_readback rb;
+    ID3D12DescriptorHeap *rtv_heap;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    ID3D12Resource *texture;
+    ID3D12Device *device;
+    D3D12_BOX box;
+    RECT rect;
+
+    if (!init_test_context(&context, NULL))
+        return;
+    device = context.device;
+    command_list = context.list;
+    queue = context.queue;
+
+    texture = create_default_texture2d(device, 32, 32, 2, 1, DXGI_FORMAT_R8G8B8A8_UNORM,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    rtv_heap = create_cpu_descriptor_heap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2);
+    rtv_array = get_cpu_rtv_handle(&context, rtv_heap, 0);
+    rtv_layer = get_cpu_rtv_handle(&context, rtv_heap, 1);
+    ID3D12Device_CreateRenderTargetView(device, texture, NULL, rtv_array);
+    memset(&rtv_desc, 0, sizeof(rtv_desc));
+    rtv_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    rtv_desc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+    rtv_desc.Texture2DArray.FirstArraySlice = 1;
+    rtv_desc.Texture2DArray.ArraySize = 1;
+    ID3D12Device_CreateRenderTargetView(device, texture, &rtv_desc, rtv_layer);
+
+    /* A clear of the bound view followed by a draw, which only renders to the
+     * first layer. The clear must still apply to both layers. */
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtv_array, white, 0, NULL);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &rtv_array, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    set_rect(&rect, 0, 0, 16, 32);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    get_texture_readback_with_command_list(texture, 0, &rb, queue, command_list);
+    set_box(&box, 0, 0, 0, 16, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    set_box(&box, 16, 0, 0, 32, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xffffffff, 0);
+    release_resource_readback(&rb);
+    reset_command_list(command_list, context.allocator);
+    check_sub_resource_uint(texture, 1, queue, command_list, 0xffffffff, 0);
+
+    /* A clear of a different view of the bound resource. */
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtv_layer, red, 0, NULL);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &rtv_array, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    set_rect(&rect, 16, 0, 32, 32);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    check_sub_resource_uint(texture, 0, queue, command_list, 0xff00ff00, 0);
+    reset_command_list(command_list, context.allocator);
+    check_sub_resource_uint(texture, 1, queue, command_list, 0xff0000ff, 0);
+
+    ID3D12DescriptorHeap_Release(rtv_heap);
+    ID3D12Resource_Release(texture);
+    destroy_test_context(&context);
+}
+
+static void test_discard_resource(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    D3D12_CPU_DESCRIPTOR_HANDLE rtv_array, rtv_layer;
+    D3D12_RENDER_TARGET_VIEW_DESC rtv_desc;
+    ID3D12GraphicsCommandList *command_list;
+    struct d3d12_resource_readback rb;
+    ID3D12DescriptorHeap *rtv_heap;
+    struct test_context context;
+    D3D12_DISCARD_REGION region;
+    ID3D12CommandQueue *queue;
+    ID3D12Resource *texture;
+    ID3D12Device *device;
+    RECT rect;
+    D3D12_BOX box;
+
+    if (!init_test_context(&context, NULL))
+        return;
+    device = context.device;
+    command_list = context.list;
+    queue = context.queue;
+
+    /* A pending clear followed by a discard and a draw covering the target. */
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+    ID3D12GraphicsCommandList_DiscardResource(command_list, context.render_target, NULL);
+
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff00ff00, 0);
+
+    /* A clear after a discard. */
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_DiscardResource(command_list, context.render_target, NULL);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, red, 0, NULL);
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    check_sub_resource_uint(context.render_target, 0, queue, command_list, 0xff0000ff, 0);
+
+    /* Discarding one layer must not affect the other layers. */
+    texture = create_default_texture2d(device, 32, 32, 2, 1, DXGI_FORMAT_R8G8B8A8_UNORM,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    rtv_heap = create_cpu_descriptor_heap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2);
+    rtv_array = get_cpu_rtv_handle(&context, rtv_heap, 0);
+    rtv_layer = get_cpu_rtv_handle(&context, rtv_heap, 1);
+    ID3D12Device_CreateRenderTargetView(device, texture, NULL, rtv_array);
+    memset(&rtv_desc, 0, sizeof(rtv_desc));
+    rtv_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    rtv_desc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+    rtv_desc.Texture2DArray.FirstArraySlice = 1;
+    rtv_desc.Texture2DArray.ArraySize = 1;
+    ID3D12Device_CreateRenderTargetView(device, texture, &rtv_desc, rtv_layer);
+
+    region.NumRects = 0;
+    region.pRects = NULL;
+    region.FirstSubresource = 1;
+    region.NumSubresources = 1;
+
+    /* The clear of the whole array is pending, and the barrier covers both layers. */
+    reset_command_list(command_list, context.allocator);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtv_array, white, 0, NULL);
+    ID3D12GraphicsCommandList_DiscardResource(command_list, texture, &region);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    check_sub_resource_uint(texture, 0, queue, command_list, 0xffffffff, 0);
+
+    /* A render pass with a view of both layers must load them. */
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_DiscardResource(command_list, texture, &region);
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &rtv_array, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+    set_rect(&rect, 0, 0, 16, 32);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    get_texture_readback_with_command_list(texture, 0, &rb, queue, command_list);
+    set_box(&box, 0, 0, 0, 16, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    set_box(&box, 16, 0, 0, 32, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xffffffff, 0);
+    release_resource_readback(&rb);
+
+    /* A partial clear after a discard of the whole resource. The discard
+     * must not apply to the following barrier. */
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    ID3D12GraphicsCommandList_DiscardResource(command_list, texture, NULL);
+    set_rect(&rect, 0, 0, 16, 16);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtv_layer, red, 1, &rect);
+    transition_resource_state(command_list, texture,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    get_texture_readback_with_command_list(texture, 1, &rb, queue, command_list);
+    set_box(&box, 0, 0, 0, 16, 16, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff0000ff, 0);
+    release_resource_readback(&rb);
+
+    ID3D12DescriptorHeap_Release(rtv_heap);
+    ID3D12Resource_Release(texture);
+    destroy_test_context(&context);
+}
+
 static void test_draw_indexed_instanced(void)
 {
     static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
@@ -7251,6 +7999,151 @@ static void test_map_resource(void)
     ok(!refcount, "ID3D12Device has %u references left.\n", (unsigned int)refcount);
 }
 
+static void test_map_committed_resources(void)
+{
+    ID3D12GraphicsCommandList *command_list;
+    struct d3d12_resource_readback rb;
+    ID3D12Resource *readback_buffer;
+    struct test_context_desc desc;
+    struct test_context context;
+    ID3D12Resource *buffers[64];
+    ID3D12CommandQueue *queue;
+    uint32_t data[64], expected, value;
+    unsigned int i, j;
+
+    /* Many small committed resources are likely to share device memory;
+     * check that mappings and GPU accesses don't overlap. */
+    memset(&desc, 0, sizeof(desc));
+    desc.no_render_target = true;
+    desc.no_pipeline = true;
+    if (!init_test_context(&context, &desc))
+        return;
+    command_list = context.list;
+    queue = context.queue;
+
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+            data[j] = (i << 16) | j;
+        buffers[i] = create_upload_buffer(context.device, sizeof(data), data);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(buffers); i += 2)
+    {
+        ID3D12Resource_Release(buffers[i]);
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+            data[j] = 0x80000000 | (i << 16) | j;
+        buffers[i] = create_upload_buffer(context.device, sizeof(data), data);
+    }
+
+    readback_buffer = create_readback_buffer(context.device, ARRAY_SIZE(buffers) * sizeof(data));
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12GraphicsCommandList_CopyBufferRegion(command_list, readback_buffer, i * sizeof(data),
+                buffers[i], 0, sizeof(data));
+
+    get_buffer_readback_with_command_list(readback_buffer, DXGI_FORMAT_R32_UINT, &rb, queue, command_list);
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+        {
+            expected = (i % 2 ? 0 : 0x80000000) | (i << 16) | j;
+            value = get_readback_uint(&rb.rb, i * ARRAY_SIZE(data) + j, 0, 0);
+            ok(value == expected, "Got unexpected value %#x at (%u, %u), expected %#x.\n", value, i, j, expected);
+            if (value != expected)
+                break;
+        }
+    }
+    release_resource_readback(&rb);
+
+    ID3D12Resource_Release(readback_buffer);
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12Resource_Release(buffers[i]);
+    destroy_test_context(&context);
+}
+
+static void test_committed_resource_zeroed(void)
+{
+    ID3D12GraphicsCommandList *command_list;
+    struct d3d12_resource_readback rb;
+    ID3D12Resource *buffers[16];
+    struct test_context_desc desc;
+    struct test_context context;
+    ID3D12Resource *upload_buffer;
+    ID3D12CommandQueue *queue;
+    uint32_t data[1024], *ptr, value;
+    unsigned int i, j;
+    HRESULT hr;
+
+    /* Freed committed resources are likely to leave their memory behind for
+     * the next resource of the same size; check that new resources still
+     * read back as zero. */
+    memset(&desc, 0, sizeof(desc));
+    desc.no_render_target = true;
+    desc.no_pipeline = true;
+    if (!init_test_context(&context, &desc))
+        return;
+    command_list = context.list;
+    queue = context.queue;
+
+    for (i = 0; i < ARRAY_SIZE(data); ++i)
+        data[i] = 0xdeadbeef;
+
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        buffers[i] = create_upload_buffer(context.device, sizeof(data), data);
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12Resource_Release(buffers[i]);
+
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        buffers[i] = create_upload_buffer(context.device, sizeof(data), NULL);
+        hr = ID3D12Resource_Map(buffers[i], 0, NULL, (void **)&ptr);
+        ok(hr == S_OK, "Failed to map buffer %u, hr %#x.\n", i, hr);
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+        {
+            ok(!ptr[j], "Got unexpected value %#x at (%u, %u).\n", ptr[j], i, j);
+            if (ptr[j])
+                break;
+        }
+        ID3D12Resource_Unmap(buffers[i], 0, NULL);
+    }
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12Resource_Release(buffers[i]);
+
+    upload_buffer = create_upload_buffer(context.device, sizeof(data), data);
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        buffers[i] = create_default_buffer(context.device, sizeof(data), 0, D3D12_RESOURCE_STATE_COPY_DEST);
+        ID3D12GraphicsCommandList_CopyBufferRegion(command_list, buffers[i], 0, upload_buffer, 0, sizeof(data));
+    }
+    hr = ID3D12GraphicsCommandList_Close(command_list);
+    ok(hr == S_OK, "Failed to close command list, hr %#x.\n", hr);
+    exec_command_list(queue, command_list);
+    wait_queue_idle(context.device, queue);
+    reset_command_list(command_list, context.allocator);
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12Resource_Release(buffers[i]);
+
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        buffers[i] = create_default_buffer(context.device, sizeof(data), 0, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        get_buffer_readback_with_command_list(buffers[i], DXGI_FORMAT_R32_UINT, &rb, queue, command_list);
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+        {
+            value = get_readback_uint(&rb.rb, j, 0, 0);
+            ok(!value, "Got unexpected value %#x at (%u, %u).\n", value, i, j);
+            if (value)
+                break;
+        }
+        release_resource_readback(&rb);
+        reset_command_list(command_list, context.allocator);
+    }
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+        ID3D12Resource_Release(buffers[i]);
+
+    ID3D12Resource_Release(upload_buffer);
+    destroy_test_context(&context);
+}
+
 static void test_map_placed_resources(void)
 {
     D3D12_ROOT_SIGNATURE_DESC root_signature_desc;
@@ -7449,13 +8342,6 @@ static void test_bundle_state_inheritance(void)
     unsigned int x, y;
     HRESULT hr;
 
-    if (!vkd3d_test_platform_is_windows())
-    {
-        /* FIXME: Avoid 2048 test todos. */
-        skip("Bundles are not implemented yet.\n");
-        return;
-    }
-
     if (test_options.use_warp_device)
     {
         skip("Bundle state inheritance test crashes on WARP.\n");
@@ -7598,6 +8484,51 @@ static void test_bundle_state_inheritance(void)
     destroy_test_context(&context);
 }
 
+static void test_invalid_bundle_commands(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    ID3D12CommandAllocator *bundle_allocator;
+    ID3D12GraphicsCommandList *bundle;
+    struct test_context context;
+    ID3D12Device *device;
+    HRESULT hr;
+
+    if (!init_test_context(&context, NULL))
+        return;
+    device = context.device;
+
+    hr = ID3D12Device_CreateCommandAllocator(device, D3D12_COMMAND_LIST_TYPE_BUNDLE,
+            &IID_ID3D12CommandAllocator, (void **)&bundle_allocator);
+    ok(SUCCEEDED(hr), "Failed to create command allocator, hr %#x.\n", hr);
+    hr = ID3D12Device_CreateCommandList(device, 0, D3D12_COMMAND_LIST_TYPE_BUNDLE,
+            bundle_allocator, NULL, &IID_ID3D12GraphicsCommandList, (void **)&bundle);
+    ok(SUCCEEDED(hr), "Failed to create command list, hr %#x.\n", hr);
+
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(bundle, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+
+    /* Clears are not allowed in bundles. */
+    reset_command_list(bundle, bundle_allocator);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(bundle, context.rtv, white, 0, NULL);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    reset_command_list(bundle, bundle_allocator);
+    ID3D12GraphicsCommandList_IASetVertexBuffers(bundle, D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, 1, NULL);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    /* Reset() clears the error. */
+    reset_command_list(bundle, bundle_allocator);
+    hr = ID3D12GraphicsCommandList_Close(bundle);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+
+    ID3D12GraphicsCommandList_Release(bundle);
+    ID3D12CommandAllocator_Release(bundle_allocator);
+    destroy_test_context(&context);
+}
+
 static void test_shader_instructions(void)
 {
     struct named_shader
@@ -18333,6 +19264,148 @@ static void test_copy_descriptors_range_sizes(void)
     destroy_test_context(&context);
 }
 
+static void test_copy_descriptors_bulk(void)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE dst_handle, src_handle;
+    ID3D12Resource *green_texture, *blue_texture;
+    ID3D12GraphicsCommandList *command_list;
+    struct d3d12_resource_readback rb;
+    ID3D12DescriptorHeap *cpu_heap;
+    struct test_context_desc desc;
+    D3D12_SUBRESOURCE_DATA data;
+    struct test_context context;
+    ID3D12DescriptorHeap *heap;
+    ID3D12CommandQueue *queue;
+    ID3D12Device *device;
+    clock_t start, end;
+    double seconds;
+    unsigned int i;
+    D3D12_BOX box;
+
+    static const DWORD ps_code[] =
+    {
+#if 0
+        Texture2D t;
+        SamplerState s;
+
+        float4 main(float4 position : SV_POSITION) : SV_Target
+        {
+            float2 p;
+
+            p.x = position.x / 32.0f;
+            p.y = position.y / 32.0f;
+            return t.Sample(s, p);
+        }
+#endif
+        0x43425844, 0x7a0c3929, 0x75ff3ca4, 0xccb318b2, 0xe6965b4c, 0x00000001, 0x00000140, 0x00000003,
+        0x0000002c, 0x00000060, 0x00000094, 0x4e475349, 0x0000002c, 0x00000001, 0x00000008, 0x00000020,
+        0x00000000, 0x00000001, 0x00000003, 0x00000000, 0x0000030f, 0x505f5653, 0x5449534f, 0x004e4f49,
+        0x4e47534f, 0x0000002c, 0x00000001, 0x00000008, 0x00000020, 0x00000000, 0x00000000, 0x00000003,
+        0x00000000, 0x0000000f, 0x545f5653, 0x65677261, 0xabab0074, 0x58454853, 0x000000a4, 0x00000050,
+        0x00000029, 0x0100086a, 0x0300005a, 0x00106000, 0x00000000, 0x04001858, 0x00107000, 0x00000000,
+        0x00005555, 0x04002064, 0x00101032, 0x00000000, 0x00000001, 0x03000065, 0x001020f2, 0x00000000,
+        0x02000068, 0x00000001, 0x0a000038, 0x00100032, 0x00000000, 0x00101046, 0x00000000, 0x00004002,
+        0x3d000000, 0x3d000000, 0x00000000, 0x00000000, 0x8b000045, 0x800000c2, 0x00155543, 0x001020f2,
+        0x00000000, 0x00100046, 0x00000000, 0x00107e46, 0x00000000, 0x00106000, 0x00000000, 0x0100003e,
+    };
+    static const D3D12_SHADER_BYTECODE ps = {ps_code, sizeof(ps_code)};
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const struct vec4 blue = {0.0f, 0.0f, 1.0f, 1.0f};
+    static const unsigned int descriptor_count = 1024;
+    static const unsigned int iteration_count = 256;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.rt_width = desc.rt_height = 6;
+    desc.no_root_signature = true;
+    if (!init_test_context(&context, &desc))
+        return;
+    device = context.device;
+    command_list = context.list;
+    queue = context.queue;
+
+    cpu_heap = create_cpu_descriptor_heap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, descriptor_count + 1);
+    heap = create_gpu_descriptor_heap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, descriptor_count);
+
+    green_texture = create_default_texture(context.device,
+            1, 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_RESOURCE_STATE_COPY_DEST);
+    data.pData = &green;
+    data.RowPitch = sizeof(green);
+    data.SlicePitch = data.RowPitch;
+    upload_texture_data(green_texture, &data, 1, queue, command_list);
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, green_texture,
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    blue_texture = create_default_texture(context.device,
+            1, 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D12_RESOURCE_STATE_COPY_DEST);
+    data.pData = &blue;
+    data.RowPitch = sizeof(blue);
+    data.SlicePitch = data.RowPitch;
+    upload_texture_data(blue_texture, &data, 1, queue, command_list);
+    reset_command_list(command_list, context.allocator);
+    transition_resource_state(command_list, blue_texture,
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    for (i = 0; i < descriptor_count + 1; ++i)
+        ID3D12Device_CreateShaderResourceView(device, i % 2 ? blue_texture : green_texture, NULL,
+                get_cpu_descriptor_handle(&context, cpu_heap, i));
+
+    context.root_signature = create_texture_root_signature(context.device,
+            D3D12_SHADER_VISIBILITY_PIXEL, 0, 0);
+    context.pipeline_state = create_pipeline_state(context.device,
+            context.root_signature, context.render_target_desc.Format, NULL, &ps, NULL);
+
+    /* Alternate the source offset, so that every copy replaces all destination descriptors. */
+    dst_handle = get_cpu_descriptor_handle(&context, heap, 0);
+    start = clock();
+    for (i = 0; i < iteration_count; ++i)
+    {
+        src_handle = get_cpu_descriptor_handle(&context, cpu_heap, i % 2);
+        ID3D12Device_CopyDescriptorsSimple(device, descriptor_count, dst_handle, src_handle,
+                D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+    end = clock();
+    if ((seconds = (double)(end - start) / CLOCKS_PER_SEC) > 0.0)
+        trace("Copied %.1f descriptors per second.\n", descriptor_count * iteration_count / seconds);
+
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, context.rtv, white, 0, NULL);
+
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &context.rtv, false, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_SetDescriptorHeaps(command_list, 1, &heap);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &context.scissor_rect);
+
+    for (i = 0; i < desc.rt_width; ++i)
+    {
+        ID3D12GraphicsCommandList_SetGraphicsRootDescriptorTable(command_list, 0,
+                get_gpu_descriptor_handle(&context, heap, i * 199));
+        set_viewport(&context.viewport, i, 0.0f, 1.0f, desc.rt_height, 0.0f, 1.0f);
+        ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+        ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    }
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    /* The last copy started at source offset 1. */
+    get_texture_readback_with_command_list(context.render_target, 0, &rb, queue, command_list);
+    for (i = 0; i < desc.rt_width; ++i)
+    {
+        set_box(&box, i, 0, 0, i + 1, desc.rt_height, 1);
+        check_readback_data_uint(&rb.rb, &box, i % 2 ? 0xff00ff00 : 0xffff0000, 0);
+    }
+    release_resource_readback(&rb);
+
+    ID3D12DescriptorHeap_Release(cpu_heap);
+    ID3D12DescriptorHeap_Release(heap);
+    ID3D12Resource_Release(blue_texture);
+    ID3D12Resource_Release(green_texture);
+    destroy_test_context(&context);
+}
+
 static void test_descriptors_visibility(void)
 {
     ID3D12Resource *vs_raw_buffer, *ps_raw_buffer;
@@ -25689,6 +26762,73 @@ static void test_copy_texture(void)
     destroy_test_context(&context);
 }
 
+static void test_copy_texture_incompatible_formats(void)
+{
+    D3D12_TEXTURE_COPY_LOCATION src_location, dst_location;
+    ID3D12GraphicsCommandList *command_list;
+    struct depth_stencil_resource ds[8];
+    ID3D12Resource *dst_textures[8];
+    struct test_context_desc desc;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    ID3D12Device *device;
+    unsigned int i, j;
+
+    /* Depth to colour copies go through transfer memory owned by the command
+     * allocator. Record several in one list, and reuse the allocator, to
+     * check that the copies don't overlap. */
+    memset(&desc, 0, sizeof(desc));
+    desc.no_render_target = true;
+    desc.no_pipeline = true;
+    if (!init_test_context(&context, &desc))
+        return;
+    device = context.device;
+    command_list = context.list;
+    queue = context.queue;
+
+    for (i = 0; i < 2; ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(ds); ++j)
+        {
+            init_depth_stencil(&ds[j], device, 32, 32, 1, 1, DXGI_FORMAT_D32_FLOAT,
+                    DXGI_FORMAT_D32_FLOAT, NULL);
+            ID3D12GraphicsCommandList_ClearDepthStencilView(command_list, ds[j].dsv_handle,
+                    D3D12_CLEAR_FLAG_DEPTH, (i * ARRAY_SIZE(ds) + j) / 16.0f, 0, 0, NULL);
+            transition_sub_resource_state(command_list, ds[j].texture, 0,
+                    D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+            dst_textures[j] = create_default_texture(device, 32, 32, DXGI_FORMAT_R32_FLOAT,
+                    0, D3D12_RESOURCE_STATE_COPY_DEST);
+
+            src_location.pResource = ds[j].texture;
+            src_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            src_location.SubresourceIndex = 0;
+            dst_location.pResource = dst_textures[j];
+            dst_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            dst_location.SubresourceIndex = 0;
+            ID3D12GraphicsCommandList_CopyTextureRegion(command_list, &dst_location, 0, 0, 0,
+                    &src_location, NULL);
+            transition_sub_resource_state(command_list, dst_textures[j], 0,
+                    D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        }
+
+        for (j = 0; j < ARRAY_SIZE(ds); ++j)
+        {
+            check_sub_resource_float(dst_textures[j], 0, queue, command_list,
+                    (i * ARRAY_SIZE(ds) + j) / 16.0f, 0);
+            reset_command_list(command_list, context.allocator);
+        }
+
+        for (j = 0; j < ARRAY_SIZE(ds); ++j)
+        {
+            destroy_depth_stencil(&ds[j]);
+            ID3D12Resource_Release(dst_textures[j]);
+        }
+    }
+
+    destroy_test_context(&context);
+}
+
 static void test_copy_texture_buffer(void)
 {
     D3D12_TEXTURE_COPY_LOCATION src_location, dst_location;
@@ -36224,14 +37364,19 @@ START_TEST(d3d12)
     run_test(test_create_root_signature);
     run_test(test_root_signature_limits);
     run_test(test_create_compute_pipeline_state);
+    run_test(test_pipeline_state_cached_blob);
+    run_test(test_pipeline_library);
     run_test(test_create_graphics_pipeline_state);
     run_test(test_create_fence);
     run_test(test_object_interface);
     run_test(test_multithread_private_data);
     run_test(test_reset_command_allocator);
     run_test(test_cpu_signal_fence);
+    run_test(test_fence_many_waiters);
+    run_test(test_multiple_fence_wait);
     run_test(test_gpu_signal_fence);
     run_test(test_multithread_fence_wait);
+    run_test(test_multithread_queue_signal);
     run_test(test_fence_values);
     run_test(test_clear_depth_stencil_view);
     run_test(test_clear_render_target_view);
@@ -36239,6 +37384,9 @@ START_TEST(d3d12)
     run_test(test_clear_unordered_access_view_image);
     run_test(test_set_render_targets);
     run_test(test_draw_instanced);
+    run_test(test_draw_with_new_pipeline_state);
+    run_test(test_clear_render_target_view_render_pass);
+    run_test(test_discard_resource);
     run_test(test_draw_indexed_instanced);
     run_test(test_draw_no_descriptor_bindings);
     run_test(test_multiple_render_targets);
@@ -36255,8 +37403,11 @@ START_TEST(d3d12)
     run_test(test_texture_resource_barriers);
     run_test(test_device_removed_reason);
     run_test(test_map_resource);
+    run_test(test_map_committed_resources);
+    run_test(test_committed_resource_zeroed);
     run_test(test_map_placed_resources);
     run_test(test_bundle_state_inheritance);
+    run_test(test_invalid_bundle_commands);
     run_test(test_shader_instructions);
     run_test(test_compute_shader_instructions);
     run_test(test_discard_instruction);
@@ -36284,6 +37435,7 @@ START_TEST(d3d12)
     run_test(test_update_descriptor_tables_after_root_signature_change);
     run_test(test_copy_descriptors);
     run_test(test_copy_descriptors_range_sizes);
+    run_test(test_copy_descriptors_bulk);
     run_test(test_descriptors_visibility);
     run_test(test_create_null_descriptors);
     run_test(test_null_cbv);
@@ -36321,6 +37473,7 @@ START_TEST(d3d12)
     run_test(test_instance_id);
     run_test(test_vertex_id);
     run_test(test_copy_texture);
+    run_test(test_copy_texture_incompatible_formats);
     run_test(test_copy_texture_buffer);
     run_test(test_copy_buffer_texture);
     run_test(test_copy_block_compressed_texture);
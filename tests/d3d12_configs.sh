@@ -0,0 +1,19 @@
+#!/bin/sh
+# Runs the d3d12 tests again with optional code paths enabled. Used by
+# "make check-configs".
+status=0
+
+run_config()
+{
+    echo "Running tests/d3d12 with $*."
+    if ! env "$@" tests/d3d12; then
+        echo "tests/d3d12 failed with $*."
+        status=1
+    fi
+}
+
+run_config VKD3D_PIPELINE_COMPILER_THREADS=2
+run_config VKD3D_CONFIG=descriptor_buffer
+run_config VKD3D_CONFIG=deferred_recording
+
+exit $status
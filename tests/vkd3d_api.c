@@ -745,6 +745,187 @@ static void test_vkd3d_queue(void)
     ok(!refcount, "Device has %u references left.\n", refcount);
 }
 
+/* The configuration is read when the instance is created. */
+static char *set_vkd3d_config(const char *config)
+{
+    const char *old_config;
+
+    old_config = getenv("VKD3D_CONFIG");
+    setenv("VKD3D_CONFIG", config, 1);
+    return old_config ? strdup(old_config) : NULL;
+}
+
+static void restore_vkd3d_config(char *old_config)
+{
+    if (old_config)
+        setenv("VKD3D_CONFIG", old_config, 1);
+    else
+        unsetenv("VKD3D_CONFIG");
+    free(old_config);
+}
+
+static void test_vkd3d_queue_submit_thread(void)
+{
+    ID3D12GraphicsCommandList *command_list;
+    ID3D12CommandAllocator *allocator;
+    ID3D12Resource *src, *dst;
+    ID3D12CommandQueue *queue;
+    uint32_t data[4096], *ptr;
+    ID3D12Device *device;
+    char *old_config;
+    unsigned int i, j;
+    VkQueue vk_queue;
+    D3D12_RANGE range;
+    ULONG refcount;
+    HRESULT hr;
+
+    old_config = set_vkd3d_config("submit_thread");
+    device = create_device();
+    restore_vkd3d_config(old_config);
+    ok(device, "Failed to create device.\n");
+
+    queue = create_command_queue(device, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_QUEUE_PRIORITY_NORMAL);
+    hr = ID3D12Device_CreateCommandAllocator(device, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            &IID_ID3D12CommandAllocator, (void **)&allocator);
+    ok(hr == S_OK, "Failed to create command allocator, hr %#x.\n", hr);
+    hr = ID3D12Device_CreateCommandList(device, 0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+            allocator, NULL, &IID_ID3D12GraphicsCommandList, (void **)&command_list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+
+    src = create_upload_buffer(device, sizeof(data), NULL);
+    dst = create_readback_buffer(device, sizeof(data));
+
+    /* Acquiring the Vulkan queue waits for the submit thread, so work
+     * executed before can be waited for with Vulkan alone. */
+    for (i = 0; i < 8; ++i)
+    {
+        for (j = 0; j < ARRAY_SIZE(data); ++j)
+            data[j] = i * ARRAY_SIZE(data) + j;
+        update_buffer_data(src, 0, sizeof(data), data);
+
+        if (i)
+            reset_command_list(command_list, allocator);
+        ID3D12GraphicsCommandList_CopyBufferRegion(command_list, dst, 0, src, 0, sizeof(data));
+        hr = ID3D12GraphicsCommandList_Close(command_list);
+        ok(hr == S_OK, "Failed to close command list, hr %#x.\n", hr);
+        exec_command_list(queue, command_list);
+
+        vk_queue = vkd3d_acquire_vk_queue(queue);
+        ok(vk_queue != VK_NULL_HANDLE, "Failed to acquire Vulkan queue.\n");
+        vkQueueWaitIdle(vk_queue);
+        vkd3d_release_vk_queue(queue);
+
+        range.Begin = 0;
+        range.End = sizeof(data);
+        hr = ID3D12Resource_Map(dst, 0, &range, (void **)&ptr);
+        ok(hr == S_OK, "Failed to map buffer, hr %#x.\n", hr);
+        ok(!memcmp(ptr, data, sizeof(data)), "Got unexpected data %#x in round %u.\n", ptr[0], i);
+        range.End = 0;
+        ID3D12Resource_Unmap(dst, 0, &range);
+    }
+
+    ID3D12Resource_Release(dst);
+    ID3D12Resource_Release(src);
+    ID3D12GraphicsCommandList_Release(command_list);
+    ID3D12CommandAllocator_Release(allocator);
+    ID3D12CommandQueue_Release(queue);
+    refcount = ID3D12Device_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+}
+
+static void test_deferred_recording(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+
+    ID3D12GraphicsCommandList *command_list;
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvs[2];
+    struct d3d12_resource_readback rb;
+    struct test_context_desc desc;
+    struct test_context context;
+    ID3D12CommandQueue *queue;
+    ID3D12Resource *rt;
+    char *old_config;
+    D3D12_BOX box;
+    RECT rect;
+    bool ret;
+
+    old_config = set_vkd3d_config("deferred_recording");
+    memset(&desc, 0, sizeof(desc));
+    desc.rt_descriptor_count = 2;
+    ret = init_test_context(&context, &desc);
+    restore_vkd3d_config(old_config);
+    if (!ret)
+        return;
+    command_list = context.list;
+    queue = context.queue;
+
+    rt = create_default_texture2d(context.device, 32, 32, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    rtvs[0] = context.rtv;
+    rtvs[1] = get_cpu_rtv_handle(&context, context.rtv_heap, 1);
+    ID3D12Device_CreateRenderTargetView(context.device, rt, NULL, rtvs[1]);
+
+    /* Clears folded into render passes, several draws in the same render
+     * pass, and adjacent independent and dependent barriers. */
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtvs[0], white, 0, NULL);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtvs[1], red, 0, NULL);
+    ID3D12GraphicsCommandList_SetGraphicsRootSignature(command_list, context.root_signature);
+    ID3D12GraphicsCommandList_SetPipelineState(command_list, context.pipeline_state);
+    ID3D12GraphicsCommandList_IASetPrimitiveTopology(command_list, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    ID3D12GraphicsCommandList_RSSetViewports(command_list, 1, &context.viewport);
+
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &rtvs[0], false, NULL);
+    set_rect(&rect, 0, 0, 16, 32);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    set_rect(&rect, 16, 0, 32, 16);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+
+    ID3D12GraphicsCommandList_OMSetRenderTargets(command_list, 1, &rtvs[1], false, NULL);
+    set_rect(&rect, 0, 16, 32, 32);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+
+    transition_resource_state(command_list, context.render_target,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    transition_resource_state(command_list, rt,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    transition_resource_state(command_list, rt,
+            D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    set_rect(&rect, 16, 0, 32, 16);
+    ID3D12GraphicsCommandList_ClearRenderTargetView(command_list, rtvs[1], white, 1, &rect);
+    set_rect(&rect, 0, 0, 16, 16);
+    ID3D12GraphicsCommandList_RSSetScissorRects(command_list, 1, &rect);
+    ID3D12GraphicsCommandList_DrawInstanced(command_list, 3, 1, 0, 0);
+    transition_resource_state(command_list, rt,
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    get_texture_readback_with_command_list(context.render_target, 0, &rb, queue, command_list);
+    set_box(&box, 0, 0, 0, 16, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    set_box(&box, 16, 0, 0, 32, 16, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    set_box(&box, 16, 16, 0, 32, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xffffffff, 0);
+    release_resource_readback(&rb);
+    reset_command_list(command_list, context.allocator);
+
+    get_texture_readback_with_command_list(rt, 0, &rb, queue, command_list);
+    set_box(&box, 0, 0, 0, 16, 16, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    set_box(&box, 16, 0, 0, 32, 16, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xffffffff, 0);
+    set_box(&box, 0, 16, 0, 32, 32, 1);
+    check_readback_data_uint(&rb.rb, &box, 0xff00ff00, 0);
+    release_resource_readback(&rb);
+
+    ID3D12Resource_Release(rt);
+    destroy_test_context(&context);
+}
+
 static void test_resource_internal_refcount(void)
 {
     ID3D12Resource *resource;
@@ -1236,6 +1417,8 @@ LOAD_VK_PFN(vkGetInstanceProcAddr)
     run_test(test_adapter_luid);
     run_test(test_device_parent);
     run_test(test_vkd3d_queue);
+    run_test(test_vkd3d_queue_submit_thread);
+    run_test(test_deferred_recording);
     run_test(test_resource_internal_refcount);
     run_test(test_external_resource_map);
     run_test(test_external_resource_present_state);